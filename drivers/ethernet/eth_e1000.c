@@ -52,6 +52,7 @@ static const char *e1000_reg_to_string(enum e1000_reg_t r)
 	_(TDLEN);
 	_(TDH);
 	_(TDT);
+	_(RXCSUM);
 	_(RAL);
 	_(RAH);
 	}
@@ -86,26 +87,213 @@ static enum ethernet_hw_caps e1000_caps(const struct device *dev)
 		ETHERNET_HW_VLAN |
 #endif
 		ETHERNET_LINK_10BASE_T | ETHERNET_LINK_100BASE_T |
-		ETHERNET_LINK_1000BASE_T;
+		ETHERNET_LINK_1000BASE_T |
+		/* RX checksums are reported per packet, see e1000_rx() */
+		ETHERNET_HW_TX_CHKSUM_OFFLOAD;
 }
 
-static int e1000_tx(struct e1000_dev *dev, void *buf, size_t len)
+static uint32_t e1000_csum_add(uint32_t sum, const uint8_t *data, size_t len)
+{
+	for (; len > 1; len -= 2, data += 2) {
+		sum += (data[0] << 8) | data[1];
+	}
+
+	if (len) {
+		sum += data[0] << 8;
+	}
+
+	return sum;
+}
+
+static uint16_t e1000_csum_fold(uint32_t sum)
+{
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return sum;
+}
+
+static volatile union e1000_tx_desc *e1000_tx_next(struct e1000_dev *dev)
+{
+	volatile union e1000_tx_desc *desc = &dev->tx[dev->tx_tail];
+
+	dev->tx_tail = (dev->tx_tail + 1) % E1000_TX_DESC_NUM;
+
+	return desc;
+}
+
+/* The stack leaves the IPv4 header and TCP/UDP checksums to us. Queue a
+ * context descriptor describing where they are and seed the TCP/UDP
+ * checksum field with the pseudo header sum as the hardware expects.
+ * Returns the POPTS flags for the data descriptor, or 0 if the frame
+ * does not need any checksum to be inserted.
+ */
+static uint8_t e1000_tx_csum_setup(struct e1000_dev *dev, uint8_t *buf,
+				   size_t len)
 {
+	volatile union e1000_tx_desc *desc;
+	size_t l3 = sizeof(struct net_eth_hdr);
+	uint8_t tucmd = 0U, popts = 0U;
+	size_t l4, l4_len, addr_len;
+	uint16_t type;
+	uint32_t sum;
+	uint8_t proto;
+	size_t cso;
+
+	type = sys_get_be16(&buf[l3 - sizeof(uint16_t)]);
+	if (type == NET_ETH_PTYPE_VLAN) {
+		l3 += NET_ETH_VLAN_HDR_SIZE;
+		type = sys_get_be16(&buf[l3 - sizeof(uint16_t)]);
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && type == NET_ETH_PTYPE_IP &&
+	    len >= l3 + NET_IPV4H_LEN) {
+		struct net_ipv4_hdr *hdr = (struct net_ipv4_hdr *)&buf[l3];
+
+		l4 = l3 + (hdr->vhl & 0x0f) * 4U;
+		l4_len = ntohs(hdr->len) - (l4 - l3);
+		proto = hdr->proto;
+		addr_len = 2 * sizeof(struct in_addr);
+		tucmd = TDESC_TUCMD_IP;
+		popts = TDESC_POPTS_IXSM;
+	} else if (IS_ENABLED(CONFIG_NET_IPV6) &&
+		   type == NET_ETH_PTYPE_IPV6 &&
+		   len >= l3 + NET_IPV6H_LEN) {
+		struct net_ipv6_hdr *hdr = (struct net_ipv6_hdr *)&buf[l3];
+
+		l4 = l3 + NET_IPV6H_LEN;
+		l4_len = ntohs(hdr->len);
+		proto = hdr->nexthdr;
+
+		/* Skip the extension headers we know the length of. Fragments
+		 * are left alone: the checksum covers the whole datagram, so
+		 * the stack computes it before fragmenting.
+		 */
+		while ((proto == NET_IPV6_NEXTHDR_HBHO ||
+			proto == NET_IPV6_NEXTHDR_DESTO) && len > l4 + 1) {
+			size_t ext_len = (buf[l4 + 1] + 1) * 8U;
+
+			proto = buf[l4];
+			l4 += ext_len;
+			l4_len -= ext_len;
+		}
+
+		addr_len = 2 * sizeof(struct in6_addr);
+	} else {
+		return 0U;
+	}
+
+	if (proto == IPPROTO_TCP && len >= l4 + NET_TCPH_LEN) {
+		cso = l4 + offsetof(struct net_tcp_hdr, chksum);
+	} else if (proto == IPPROTO_UDP && len >= l4 + NET_UDPH_LEN) {
+		cso = l4 + offsetof(struct net_udp_hdr, chksum);
+	} else {
+		cso = 0U;
+	}
+
+	if (cso) {
+		/* Source and destination addresses end the IP header */
+		sum = e1000_csum_add(proto + l4_len,
+				     &buf[l3 + (tucmd ? NET_IPV4H_LEN :
+						NET_IPV6H_LEN) - addr_len],
+				     addr_len);
+		sys_put_be16(e1000_csum_fold(sum), &buf[cso]);
+
+		if (cso <= UINT8_MAX) {
+			popts |= TDESC_POPTS_TXSM;
+		} else {
+			/* Out of reach of the context descriptor */
+			sum = e1000_csum_add(0, &buf[l4], len - l4);
+			sum = (uint16_t)~e1000_csum_fold(sum);
+			if (sum == 0U && proto == IPPROTO_UDP) {
+				sum = 0xffff;
+			}
+
+			sys_put_be16(sum, &buf[cso]);
+			cso = 0U;
+		}
+	}
+
+	if (!popts) {
+		return 0U;
+	}
+
+	desc = e1000_tx_next(dev);
+
+	desc->ctx.ipcss = l3;
+	desc->ctx.ipcso = l3 + offsetof(struct net_ipv4_hdr, chksum);
+	desc->ctx.ipcse = l4 - 1;
+	desc->ctx.tucss = l4;
+	desc->ctx.tucso = cso;
+	desc->ctx.tucse = 0U; /* Up to the end of the frame */
+	desc->ctx.cmd_len = TDESC_DTYP_CTX | (TDESC_DEXT << 24) |
+			    (tucmd << 24);
+	desc->ctx.sta = 0U;
+	desc->ctx.hdrlen = 0U;
+	desc->ctx.mss = 0U;
+
+	return popts;
+}
+
+BUILD_ASSERT(2 * E1000_TX_BURST < E1000_TX_DESC_NUM,
+	     "Tx ring too small for a burst");
+
+/* Put the frame on the Tx ring, the caller tells the hardware about it.
+ * Returns the descriptor to wait on.
+ */
+static volatile union e1000_tx_desc *e1000_tx_queue(struct e1000_dev *dev,
+						    void *buf, size_t len)
+{
+	volatile union e1000_tx_desc *desc;
+	uint8_t popts;
+
+	popts = e1000_tx_csum_setup(dev, buf, len);
+
 	hexdump(buf, len, "%zu byte(s)", len);
 
-	dev->tx.addr = POINTER_TO_INT(buf);
-	dev->tx.len = len;
-	dev->tx.cmd = TDESC_EOP | TDESC_RS;
+	desc = e1000_tx_next(dev);
+
+	if (popts) {
+		desc->data.addr = POINTER_TO_INT(buf);
+		desc->data.cmd_len = len | TDESC_DTYP_DATA |
+			((TDESC_EOP | TDESC_RS | TDESC_DEXT) << 24);
+		desc->data.sta = 0U;
+		desc->data.popts = popts;
+		desc->data.special = 0U;
+	} else {
+		desc->legacy.addr = POINTER_TO_INT(buf);
+		desc->legacy.len = len;
+		desc->legacy.cso = 0U;
+		desc->legacy.cmd = TDESC_EOP | TDESC_RS;
+		desc->legacy.sta = 0U;
+		desc->legacy.css = 0U;
+		desc->legacy.special = 0U;
+	}
 
-	iow32(dev, TDT, 1);
+	return desc;
+}
 
-	while (!(dev->tx.sta)) {
+static int e1000_tx_wait(volatile union e1000_tx_desc *desc)
+{
+	while (!(desc->legacy.sta)) {
 		k_yield();
 	}
 
-	LOG_DBG("tx.sta: 0x%02hx", dev->tx.sta);
+	LOG_DBG("tx.sta: 0x%02hx", desc->legacy.sta);
+
+	return (desc->legacy.sta & TDESC_STA_DD) ? 0 : -EIO;
+}
+
+static int e1000_tx(struct e1000_dev *dev, void *buf, size_t len)
+{
+	volatile union e1000_tx_desc *desc;
+
+	desc = e1000_tx_queue(dev, buf, len);
+
+	iow32(dev, TDT, dev->tx_tail);
 
-	return (dev->tx.sta & TDESC_STA_DD) ? 0 : -EIO;
+	return e1000_tx_wait(desc);
 }
 
 static int e1000_send(const struct device *device, struct net_pkt *pkt)
@@ -113,11 +301,49 @@ static int e1000_send(const struct device *device, struct net_pkt *pkt)
 	struct e1000_dev *dev = device->data;
 	size_t len = net_pkt_get_len(pkt);
 
-	if (net_pkt_read(pkt, dev->txb, len)) {
+	if (net_pkt_read(pkt, dev->txb[0], len)) {
 		return -EIO;
 	}
 
-	return e1000_tx(dev, dev->txb, len);
+	return e1000_tx(dev, dev->txb[0], len);
+}
+
+/* Queue the whole burst and write the tail register once */
+static int e1000_send_burst(const struct device *device,
+			    struct net_pkt **pkts, int count)
+{
+	volatile union e1000_tx_desc *desc[E1000_TX_BURST];
+	struct e1000_dev *dev = device->data;
+	int queued, sent;
+	int i;
+
+	count = MIN(count, E1000_TX_BURST);
+
+	for (queued = 0; queued < count; queued++) {
+		size_t len = net_pkt_get_len(pkts[queued]);
+
+		if (len > sizeof(dev->txb[queued]) ||
+		    net_pkt_read(pkts[queued], dev->txb[queued], len)) {
+			break;
+		}
+
+		desc[queued] = e1000_tx_queue(dev, dev->txb[queued], len);
+	}
+
+	if (!queued) {
+		return -EIO;
+	}
+
+	iow32(dev, TDT, dev->tx_tail);
+
+	/* The buffers are reused by the next call, wait for all of them */
+	for (i = 0, sent = queued; i < queued; i++) {
+		if (e1000_tx_wait(desc[i]) < 0 && sent == queued) {
+			sent = i;
+		}
+	}
+
+	return sent ? sent : -EIO;
 }
 
 static struct net_pkt *e1000_rx(struct e1000_dev *dev)
@@ -143,6 +369,12 @@ static struct net_pkt *e1000_rx(struct e1000_dev *dev)
 
 	hexdump(buf, len, "%zd byte(s)", len);
 
+	if (!(dev->rx.sta & RDESC_STA_IXSM) &&
+	    (dev->rx.err & (RDESC_ERR_IPE | RDESC_ERR_TCPE))) {
+		LOG_DBG("Checksum error, rx.err: 0x%02hx", dev->rx.err);
+		goto out;
+	}
+
 	pkt = net_pkt_rx_alloc_with_buffer(dev->iface, len, AF_UNSPEC, 0,
 					   K_NO_WAIT);
 	if (!pkt) {
@@ -154,6 +386,16 @@ static struct net_pkt *e1000_rx(struct e1000_dev *dev)
 		LOG_ERR("Out of memory for received frame");
 		net_pkt_unref(pkt);
 		pkt = NULL;
+		goto out;
+	}
+
+	/* The hardware only validates IPv4 TCP/UDP packets, the stack
+	 * verifies the rest itself.
+	 */
+	if (!(dev->rx.sta & RDESC_STA_IXSM) &&
+	    (dev->rx.sta & (RDESC_STA_IPCS | RDESC_STA_TCPCS)) ==
+	    (RDESC_STA_IPCS | RDESC_STA_TCPCS)) {
+		net_pkt_set_chksum_done(pkt, true);
 	}
 
 out:
@@ -237,7 +479,7 @@ int e1000_probe(const struct device *device)
 
 	iow32(dev, TDBAL, (uint32_t) &dev->tx);
 	iow32(dev, TDBAH, 0);
-	iow32(dev, TDLEN, 1*16);
+	iow32(dev, TDLEN, sizeof(dev->tx));
 
 	iow32(dev, TDH, 0);
 	iow32(dev, TDT, 0);
@@ -256,6 +498,8 @@ int e1000_probe(const struct device *device)
 	iow32(dev, RDH, 0);
 	iow32(dev, RDT, 1);
 
+	iow32(dev, RXCSUM, RXCSUM_IPOFL | RXCSUM_TUOFL);
+
 	iow32(dev, IMS, IMS_RXO);
 
 	ral = ior32(dev, RAL);
@@ -303,6 +547,7 @@ static const struct ethernet_api e1000_api = {
 	.iface_api.init		= e1000_iface_init,
 	.get_capabilities	= e1000_caps,
 	.send			= e1000_send,
+	.send_burst		= e1000_send_burst,
 };
 
 ETH_NET_DEVICE_INIT(eth_e1000,
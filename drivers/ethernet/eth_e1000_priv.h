@@ -24,12 +24,36 @@ extern "C" {
 
 #define RCTL_MPE	(1 << 4) /* Multicast Promiscuous Enabled */
 
+#define RXCSUM_IPOFL	(1 << 8) /* IP Checksum Off-load Enable */
+#define RXCSUM_TUOFL	(1 << 9) /* TCP/UDP Checksum Off-load Enable */
+
 #define TDESC_EOP	     (1) /* End Of Packet */
 #define TDESC_RS	(1 << 3) /* Report Status */
+#define TDESC_DEXT	(1 << 5) /* Descriptor Extension */
+
+#define TDESC_DTYP_CTX	(0 << 20) /* TCP/IP Context Descriptor */
+#define TDESC_DTYP_DATA	(1 << 20) /* TCP/IP Data Descriptor */
+
+#define TDESC_TUCMD_IP	(1 << 1) /* IPv4 Packet Type */
+
+#define TDESC_POPTS_IXSM     (1) /* Insert IP Checksum */
+#define TDESC_POPTS_TXSM (1 << 1) /* Insert TCP/UDP Checksum */
 
 #define RDESC_STA_DD	     (1) /* Descriptor Done */
+#define RDESC_STA_IXSM	(1 << 2) /* Ignore Checksum Indication */
+#define RDESC_STA_TCPCS	(1 << 5) /* TCP/UDP Checksum Calculated */
+#define RDESC_STA_IPCS	(1 << 6) /* IP Checksum Calculated */
+#define RDESC_ERR_TCPE	(1 << 5) /* TCP/UDP Checksum Error */
+#define RDESC_ERR_IPE	(1 << 6) /* IP Checksum Error */
 #define TDESC_STA_DD	     (1) /* Descriptor Done */
 
+#define E1000_TX_DESC_NUM	16
+
+/* Frames per send_burst() call, each may take a context and a data
+ * descriptor and the ring must never be completely full.
+ */
+#define E1000_TX_BURST		4
+
 #define ETH_ALEN 6	/* TODO: Add a global reusable definition in OS */
 
 enum e1000_reg_t {
@@ -49,6 +73,7 @@ enum e1000_reg_t {
 	TDLEN	= 0x3808,	/* Tx Descriptor Length */
 	TDH	= 0x3810,	/* Tx Descriptor Head */
 	TDT	= 0x3818,	/* Tx Descriptor Tail */
+	RXCSUM	= 0x5000,	/* Receive Checksum Control */
 	RAL	= 0x5400,	/* Receive Address Low */
 	RAH	= 0x5404,	/* Receive Address High */
 };
@@ -64,6 +89,35 @@ struct e1000_tx {
 	uint16_t special;
 };
 
+/* TCP/IP Context Descriptor */
+struct e1000_tx_ctx {
+	uint8_t  ipcss;
+	uint8_t  ipcso;
+	uint16_t ipcse;
+	uint8_t  tucss;
+	uint8_t  tucso;
+	uint16_t tucse;
+	uint32_t cmd_len;
+	uint8_t  sta;
+	uint8_t  hdrlen;
+	uint16_t mss;
+};
+
+/* TCP/IP Data Descriptor */
+struct e1000_tx_data {
+	uint64_t addr;
+	uint32_t cmd_len;
+	uint8_t  sta;
+	uint8_t  popts;
+	uint16_t special;
+};
+
+union e1000_tx_desc {
+	struct e1000_tx legacy;
+	struct e1000_tx_ctx ctx;
+	struct e1000_tx_data data;
+};
+
 /* Legacy RX Descriptor */
 struct e1000_rx {
 	uint64_t addr;
@@ -75,16 +129,17 @@ struct e1000_rx {
 };
 
 struct e1000_dev {
-	volatile struct e1000_tx tx __aligned(16);
+	volatile union e1000_tx_desc tx[E1000_TX_DESC_NUM] __aligned(16);
 	volatile struct e1000_rx rx __aligned(16);
 	mm_reg_t address;
+	uint16_t tx_tail;
 	/* If VLAN is enabled, there can be multiple VLAN interfaces related to
 	 * this physical device. In that case, this iface pointer value is not
 	 * really used for anything.
 	 */
 	struct net_if *iface;
 	uint8_t mac[ETH_ALEN];
-	uint8_t txb[NET_ETH_MTU];
+	uint8_t txb[E1000_TX_BURST][NET_ETH_MTU];
 	uint8_t rxb[NET_ETH_MTU];
 };
 
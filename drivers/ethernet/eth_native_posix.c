@@ -201,6 +201,25 @@ static int eth_send(const struct device *dev, struct net_pkt *pkt)
 	return ret < 0 ? ret : 0;
 }
 
+static int eth_send_burst(const struct device *dev, struct net_pkt **pkts,
+			  int count)
+{
+	int ret;
+	int i;
+
+	/* The TAP device takes one frame per write, the gain is in the
+	 * stack calling us once per burst.
+	 */
+	for (i = 0; i < count; i++) {
+		ret = eth_send(dev, pkts[i]);
+		if (ret < 0) {
+			return i ? i : ret;
+		}
+	}
+
+	return count;
+}
+
 static int eth_init(const struct device *dev)
 {
 	ARG_UNUSED(dev);
@@ -319,17 +338,17 @@ static struct net_pkt *prepare_non_vlan_pkt(struct eth_context *ctx,
 	return pkt;
 }
 
-static int read_data(struct eth_context *ctx, int fd)
+static struct net_pkt *read_data(struct eth_context *ctx, int fd,
+				 struct net_if **iface)
 {
 	uint16_t vlan_tag = NET_VLAN_TAG_UNSPEC;
-	struct net_if *iface;
 	struct net_pkt *pkt = NULL;
 	int status;
 	int count;
 
 	count = eth_read_data(fd, ctx->recv, sizeof(ctx->recv));
 	if (count <= 0) {
-		return 0;
+		return NULL;
 	}
 
 #if defined(CONFIG_NET_VLAN)
@@ -339,12 +358,12 @@ static int read_data(struct eth_context *ctx, int fd)
 		if (ntohs(hdr->type) == NET_ETH_PTYPE_VLAN) {
 			pkt = prepare_vlan_pkt(ctx, count, &vlan_tag, &status);
 			if (!pkt) {
-				return status;
+				return NULL;
 			}
 		} else {
 			pkt = prepare_non_vlan_pkt(ctx, count, &status);
 			if (!pkt) {
-				return status;
+				return NULL;
 			}
 
 			net_pkt_set_vlan_tci(pkt, 0);
@@ -354,30 +373,78 @@ static int read_data(struct eth_context *ctx, int fd)
 	{
 		pkt = prepare_non_vlan_pkt(ctx, count, &status);
 		if (!pkt) {
-			return status;
+			return NULL;
 		}
 	}
 #endif
 
-	iface = get_iface(ctx, vlan_tag);
+	*iface = get_iface(ctx, vlan_tag);
 
-	update_gptp(iface, pkt, false);
+	update_gptp(*iface, pkt, false);
 
-	if (net_recv_data(iface, pkt) < 0) {
-		net_pkt_unref(pkt);
-	}
+	return pkt;
+}
 
-	return 0;
+static void recv_burst(struct net_if *iface, struct net_pkt **pkts,
+		       int count)
+{
+	int ret;
+
+	ret = net_recv_data_burst(iface, pkts, count);
+
+	for (ret = MAX(ret, 0); ret < count; ret++) {
+		net_pkt_unref(pkts[ret]);
+	}
 }
 
 static void eth_rx(struct eth_context *ctx)
 {
+	struct net_pkt *pkts[CONFIG_ETH_NATIVE_POSIX_RX_BURST];
+	struct net_if *burst_iface = NULL;
+	struct net_if *iface;
+	struct net_pkt *pkt;
+	int count = 0;
+
 	LOG_DBG("Starting ZETH RX thread");
 
 	while (1) {
 		if (net_if_is_up(ctx->iface)) {
+			/* Collect the frames that are already there and
+			 * pass them to the stack in one go.
+			 */
 			while (!eth_wait_data(ctx->dev_fd)) {
-				read_data(ctx, ctx->dev_fd);
+				pkt = read_data(ctx, ctx->dev_fd, &iface);
+				if (!pkt) {
+					/* Might be out of packets, release
+					 * the ones we hold.
+					 */
+					if (count) {
+						recv_burst(burst_iface, pkts,
+							   count);
+						count = 0;
+					}
+
+					continue;
+				}
+
+				if (count && iface != burst_iface) {
+					recv_burst(burst_iface, pkts, count);
+					count = 0;
+				}
+
+				burst_iface = iface;
+				pkts[count++] = pkt;
+
+				if (count == ARRAY_SIZE(pkts)) {
+					recv_burst(burst_iface, pkts, count);
+					count = 0;
+					k_yield();
+				}
+			}
+
+			if (count) {
+				recv_burst(burst_iface, pkts, count);
+				count = 0;
 				k_yield();
 			}
 		}
@@ -609,6 +676,7 @@ static const struct ethernet_api eth_if_api = {
 	.start = eth_start_device,
 	.stop = eth_stop_device,
 	.send = eth_send,
+	.send_burst = eth_send_burst,
 
 #if defined(CONFIG_NET_VLAN)
 	.vlan_setup = vlan_setup,
@@ -8,6 +8,7 @@
 #define ZEPHYR_INCLUDE_DATA_JSON_H_
 
 #include <sys/util.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <zephyr/types.h>
 #include <sys/types.h>
@@ -43,6 +44,8 @@ enum json_tokens {
 	JSON_TOK_COLON = ':',
 	JSON_TOK_COMMA = ',',
 	JSON_TOK_NUMBER = '0',
+	JSON_TOK_FLOAT = '1',
+	JSON_TOK_INT64 = '2',
 	JSON_TOK_TRUE = 't',
 	JSON_TOK_FALSE = 'f',
 	JSON_TOK_NULL = 'n',
@@ -64,10 +67,10 @@ struct json_obj_descr {
 	uint32_t field_name_len : 7;
 
 	/* Valid values here (enum json_tokens): JSON_TOK_STRING,
-	 * JSON_TOK_NUMBER, JSON_TOK_TRUE, JSON_TOK_FALSE,
-	 * JSON_TOK_OBJECT_START, JSON_TOK_LIST_START.  (All others
-	 * ignored.) Maximum value is '}' (125), so this has to be 7 bits
-	 * long.
+	 * JSON_TOK_NUMBER, JSON_TOK_INT64, JSON_TOK_FLOAT, JSON_TOK_TRUE,
+	 * JSON_TOK_FALSE, JSON_TOK_OBJECT_START, JSON_TOK_LIST_START.
+	 * (All others ignored.) Maximum value is '}' (125), so this has
+	 * to be 7 bits long.
 	 */
 	uint32_t type : 7;
 
@@ -86,6 +89,21 @@ struct json_obj_descr {
 	};
 };
 
+/**
+ * @brief Number decoded for, or encoded from, a JSON_TOK_FLOAT field
+ *
+ * The number is given as it is written in the JSON payload, checked against
+ * the JSON grammar: no floating point conversion is made by the library.
+ */
+struct json_obj_token {
+	/** First character of the number, not NUL terminated by
+	 *  json_obj_parse()
+	 */
+	char *start;
+	/** Number of characters */
+	size_t length;
+};
+
 /**
  * @brief Function pointer type to append bytes to a buffer while
  * encoding JSON data.
@@ -115,7 +133,9 @@ typedef int (*json_append_bytes_t)(const char *bytes, size_t len,
  *
  * @param type_ Token type for JSON value corresponding to a primitive
  * type. Must be one of: JSON_TOK_STRING for strings, JSON_TOK_NUMBER
- * for numbers, JSON_TOK_TRUE (or JSON_TOK_FALSE) for booleans.
+ * for 32-bit integers, JSON_TOK_INT64 for 64-bit integers, JSON_TOK_FLOAT
+ * for any number, given as a struct json_obj_token, JSON_TOK_TRUE (or
+ * JSON_TOK_FALSE) for booleans.
  *
  * Here's an example of use:
  *
@@ -571,7 +591,13 @@ typedef int (*json_append_bytes_t)(const char *bytes, size_t len,
  * (1) strings are not unescaped (but only valid escape sequences are
  * accepted);
  * (2) no UTF-8 validation is performed; and
- * (3) only integer numbers are supported (no strtod() in the minimal libc).
+ * (3) numbers other than integers are not converted (no strtod() in the
+ * minimal libc), see JSON_TOK_FLOAT.
+ *
+ * Values of fields missing from the descriptor are skipped. Fields are
+ * looked up starting with the one following the field decoded last, so
+ * objects sent with their fields in the order of the descriptor are
+ * decoded the fastest.
  *
  * @param json Pointer to JSON-encoded value to be parsed
  *
@@ -592,6 +618,100 @@ int json_obj_parse(char *json, size_t len,
 	const struct json_obj_descr *descr, size_t descr_len,
 	void *val);
 
+/** Maximum nesting of the objects and arrays decoded by json_obj_stream */
+#define JSON_OBJ_STREAM_MAX_DEPTH 8
+
+/** @cond INTERNAL_HIDDEN */
+struct json_obj_stream_frame {
+	const struct json_obj_descr *descr;
+	void *val;
+	char *field;
+	ptrdiff_t elem_size;
+	size_t len;
+	uint32_t count;
+	int8_t cur;
+	uint8_t hint;
+	bool array;
+};
+/** @endcond */
+
+/**
+ * @brief State of an object parsed from successive chunks of its JSON
+ * payload, with json_obj_stream_feed(). Its fields are internal.
+ */
+struct json_obj_stream {
+	/** @cond INTERNAL_HIDDEN */
+	struct json_obj_stream_frame stack[JSON_OBJ_STREAM_MAX_DEPTH];
+	const struct json_obj_descr *descr;
+	size_t descr_len;
+	void *val;
+	char *buf;
+	size_t buf_size;
+	size_t buf_used;
+	size_t tok_len;
+	const char *literal;
+	size_t skip;
+	int result;
+	uint8_t depth;
+	uint8_t state;
+	uint8_t sub;
+	/** @endcond */
+};
+
+/**
+ * @brief Starts parsing a JSON-encoded object received in chunks, which
+ * do not have to be kept once given to json_obj_stream_feed().
+ *
+ * Values are decoded as json_obj_parse() does, but strings and the
+ * numbers of JSON_TOK_FLOAT fields are copied, NUL terminated, to @a buf.
+ * The key or the number being read is kept there as well until decoded.
+ * The payload must follow the JSON grammar more strictly, with commas
+ * between all the values.
+ *
+ * @param stream Parser state
+ *
+ * @param descr Pointer to the descriptor array
+ *
+ * @param descr_len Number of elements in the descriptor array, less than 31
+ *
+ * @param val Pointer to the struct to hold the decoded values
+ *
+ * @param buf Buffer for the strings decoded, used until @a val is
+ *
+ * @param buf_size Size of @a buf
+ */
+void json_obj_stream_init(struct json_obj_stream *stream,
+			  const struct json_obj_descr *descr,
+			  size_t descr_len, void *val,
+			  char *buf, size_t buf_size);
+
+/**
+ * @brief Parses the next chunk of a JSON-encoded object
+ *
+ * @param stream Parser state, set up with json_obj_stream_init()
+ *
+ * @param data Chunk of the JSON-encoded object
+ *
+ * @param len Length of the chunk
+ *
+ * @return 0 if the chunk has been parsed, or a negative error code, as
+ * for all the following chunks: -EINVAL if the payload is invalid, -ENOSPC
+ * if an array has too many elements, -ENOMEM if @a buf is too small or
+ * objects are nested deeper than JSON_OBJ_STREAM_MAX_DEPTH.
+ */
+int json_obj_stream_feed(struct json_obj_stream *stream, const char *data,
+			 size_t len);
+
+/**
+ * @brief Ends parsing a JSON-encoded object
+ *
+ * @param stream Parser state
+ *
+ * @return < 0 if error, including -EINVAL if the object is incomplete,
+ * bitmap of decoded fields on success, as json_obj_parse().
+ */
+int json_obj_stream_end(struct json_obj_stream *stream);
+
 /**
  * @brief Escapes the string so it can be used to encode JSON objects
  *
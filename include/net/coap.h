@@ -72,6 +72,9 @@ enum coap_method {
 	COAP_METHOD_POST = 2,
 	COAP_METHOD_PUT = 3,
 	COAP_METHOD_DELETE = 4,
+	COAP_METHOD_FETCH = 5,
+	COAP_METHOD_PATCH = 6,
+	COAP_METHOD_IPATCH = 7,
 };
 
 #define COAP_REQUEST_MASK 0x07
@@ -189,6 +192,9 @@ struct coap_resource {
 	void *user_data;
 	sys_slist_t observers;
 	int age;
+	/* Set by coap_resource_index_init() */
+	struct coap_resource *index_next;
+	uint32_t path_hash;
 };
 
 /**
@@ -468,6 +474,55 @@ int coap_handle_request(struct coap_packet *cpkt,
 			uint8_t opt_num,
 			struct sockaddr *addr, socklen_t addr_len);
 
+/**
+ * @brief Hash table of resources, used to find the resource matching
+ * a request without comparing its path with the path of each resource.
+ */
+struct coap_resource_index {
+	struct coap_resource *resources;
+	struct coap_resource **buckets;
+	/* Resources with a wildcard in their path, in array order */
+	struct coap_resource *wildcards;
+	size_t bucket_count;
+};
+
+/**
+ * @brief Builds an index of the resources of @a resources.
+ *
+ * The resources array must not be modified while the index is used.
+ *
+ * @param index Index to be initialized
+ * @param resources Array of known resources, terminated by a resource
+ * with a NULL path
+ * @param buckets Array of @a bucket_count resource pointers
+ * @param bucket_count Number of buckets, a power of two
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_resource_index_init(struct coap_resource_index *index,
+			     struct coap_resource *resources,
+			     struct coap_resource **buckets,
+			     size_t bucket_count);
+
+/**
+ * @brief Same as coap_handle_request(), with the resource looked up in
+ * @a index.
+ *
+ * @param cpkt Packet received
+ * @param index Index of the known resources
+ * @param options Parsed options from coap_packet_parse()
+ * @param opt_num Number of options
+ * @param addr Peer address
+ * @param addr_len Peer address length
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_handle_request_index(struct coap_packet *cpkt,
+			      const struct coap_resource_index *index,
+			      struct coap_option *options,
+			      uint8_t opt_num,
+			      struct sockaddr *addr, socklen_t addr_len);
+
 /**
  * Represents the size of each block that will be transferred using
  * block-wise transfers [RFC7959]:
@@ -593,6 +648,78 @@ int coap_get_option_int(const struct coap_packet *cpkt, uint16_t code);
 int coap_update_from_block(const struct coap_packet *cpkt,
 			   struct coap_block_context *ctx);
 
+/**
+ * @brief Represents a body sent or received with block-wise transfers.
+ */
+struct coap_block_transfer {
+	struct coap_block_context ctx;
+	uint8_t *body;
+	/* Size of the body buffer */
+	size_t size;
+	/* Length of the body, or of its part received so far */
+	size_t len;
+};
+
+/**
+ * @brief Initializes a block-wise transfer of a body.
+ *
+ * @param xfer Transfer to be initialized
+ * @param block_size Largest block size to be used
+ * @param body Buffer holding the body
+ * @param size Size of the body buffer
+ * @param len Length of the body to be sent, 0 to receive a body
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_block_transfer_setup(struct coap_block_transfer *xfer,
+			      enum coap_block_size block_size,
+			      uint8_t *body, size_t size, size_t len);
+
+/**
+ * @brief Adds the payload of @a cpkt to the body being received.
+ *
+ * The block is taken from the BLOCK1 option of a request, or from the
+ * BLOCK2 option of a response. A packet without that option holds the
+ * whole body. A block with number 0 starts the body again.
+ *
+ * After a request, xfer->ctx describes the received block, so that the
+ * response can hold it with coap_append_block1_option(). After a
+ * response, xfer->ctx.current is the offset of the next block, to be
+ * requested with coap_append_block2_option().
+ *
+ * @param xfer Transfer receiving the body
+ * @param cpkt Packet received
+ *
+ * @return 1 if the body is complete, 0 if more blocks are expected,
+ * -EINVAL if the block is not the next one and -ENOMEM if the body
+ * buffer is too small.
+ */
+int coap_block_transfer_recv(struct coap_block_transfer *xfer,
+			     const struct coap_packet *cpkt);
+
+/**
+ * @brief Appends the next block of the body being sent to @a cpkt.
+ *
+ * A response holds the block asked for in the BLOCK2 option of the
+ * request @a peer, the first block if it has none. A request holds
+ * the block following the one acknowledged by the response @a peer,
+ * the first block if @a peer is NULL. The block size is reduced when
+ * @a peer uses a smaller one.
+ *
+ * The BLOCK option, the SIZE option for the first block and the payload
+ * are appended, so other options with a higher number cannot be added.
+ *
+ * @param xfer Transfer sending the body
+ * @param cpkt Packet being built
+ * @param peer Packet received from the peer, or NULL
+ *
+ * @return 1 if this is the last block, 0 if more blocks are to be sent
+ * or negative in case of error.
+ */
+int coap_block_transfer_send(struct coap_block_transfer *xfer,
+			     struct coap_packet *cpkt,
+			     const struct coap_packet *peer);
+
 /**
  * @brief Updates @a ctx so after this is called the current entry
  * indicates the correct offset in the body of data being
@@ -655,6 +782,22 @@ struct coap_observer *coap_find_observer_by_addr(
 	struct coap_observer *observers, size_t len,
 	const struct sockaddr *addr);
 
+/**
+ * @brief Returns the observer of @a resource that matches address
+ * @a addr and token @a token.
+ *
+ * @param resource Resource being observed
+ * @param addr Address of the endpoint observing the resource
+ * @param token Token of the observe request
+ * @param tkl Length of the token
+ *
+ * @return A pointer to a observer if a match is found, NULL
+ * otherwise.
+ */
+struct coap_observer *coap_find_observer(
+	struct coap_resource *resource, const struct sockaddr *addr,
+	const uint8_t *token, uint8_t tkl);
+
 /**
  * @brief Returns the next available observer representation.
  *
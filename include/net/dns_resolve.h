@@ -157,6 +157,29 @@ typedef void (*dns_resolve_cb_t)(enum dns_resolve_status status,
 				 struct dns_addrinfo *info,
 				 void *user_data);
 
+/** @cond INTERNAL_HIDDEN */
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/* Answers of a pending query, given to the cache when the query is done */
+struct dns_cache_answer {
+	/* Addresses, only the first ones if there are more than
+	 * CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS.
+	 */
+	union {
+		struct in_addr in;
+		struct in6_addr in6;
+	} addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS];
+
+	/* Lowest TTL of the records seen */
+	uint32_t ttl;
+
+	/* Number of valid addresses */
+	uint8_t count;
+};
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
+/** @endcond */
+
 /**
  * DNS resolve context structure.
  */
@@ -216,6 +239,16 @@ struct dns_resolve_context {
 		 * cannot be used to find correct pending query.
 		 */
 		uint16_t query_hash;
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+		/** Index of the pending query whose answer this query waits
+		 * for, or -1 if this query was sent to the servers itself.
+		 */
+		int8_t leader;
+
+		/** Answers received for this query, cached when it is done */
+		struct dns_cache_answer answer;
+#endif
 	} queries[CONFIG_DNS_NUM_CONCUR_QUERIES];
 
 	/** Is this context in use */
@@ -399,6 +432,42 @@ static inline int dns_cancel_addr_info(uint16_t dns_id)
 	return dns_resolve_cancel(dns_resolve_get_default(), dns_id);
 }
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/**
+ * DNS answer cache statistics.
+ */
+struct dns_resolve_cache_stats {
+	/** Queries answered from the cache */
+	uint32_t hits;
+
+	/** Queries not found in the cache */
+	uint32_t misses;
+
+	/** Queries which waited for the answer of an identical pending one
+	 * instead of being sent to the servers.
+	 */
+	uint32_t coalesced;
+
+	/** Unexpired answers dropped to make room for other names */
+	uint32_t evictions;
+};
+
+/**
+ * @brief Drop all the answers kept in the DNS cache.
+ *
+ * @details The cache is shared by all the DNS contexts. It needs to be
+ * flushed e.g., when the DNS servers are changed.
+ */
+void dns_resolve_cache_flush(void);
+
+/**
+ * @brief Get the DNS cache statistics.
+ *
+ * @param stats Statistics are copied here.
+ */
+void dns_resolve_cache_get_stats(struct dns_resolve_cache_stats *stats);
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
 /**
  * @}
  */
@@ -130,6 +130,12 @@ enum ethernet_hw_caps {
 
 	/** VLAN Tag stripping */
 	ETHERNET_HW_VLAN_TAG_STRIP	= BIT(14),
+
+	/** TCP segmentation offload (TSO) supported. Oversized TCP segments
+	 * are passed to the driver as is and net_pkt_gso_size() tells the
+	 * segment size to use.
+	 */
+	ETHERNET_HW_TX_TSO		= BIT(15),
 };
 
 /** @cond INTERNAL_HIDDEN */
@@ -267,6 +273,15 @@ struct ethernet_api {
 
 	/** Send a network packet */
 	int (*send)(const struct device *dev, struct net_pkt *pkt);
+
+	/** Send a burst of network packets. Optional, used instead of
+	 * send() by CONFIG_NET_ETHERNET_TX_BURST so that the device is
+	 * kicked once for several packets. Returns the number of packets
+	 * sent, starting from the first one, or <0 if none could be sent.
+	 * The packets are not used by the driver after it returns.
+	 */
+	int (*send_burst)(const struct device *dev, struct net_pkt **pkts,
+			  int count);
 };
 
 /* Make sure that the network interface API is properly setup inside
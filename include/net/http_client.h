@@ -93,6 +93,40 @@ typedef void (*http_response_cb_t)(struct http_response *rsp,
 				   enum http_final_call final_data,
 				   void *user_data);
 
+/**
+ * @typedef http_payload_producer_t
+ * @brief Callback used to get the payload of a request piece by piece.
+ * Each piece is sent as a chunk of the chunked transfer encoding, without
+ * being copied.
+ *
+ * @param req HTTP request information
+ * @param data Set to point to the next piece of the payload. The data must
+ *        stay valid until the callback is called again.
+ * @param user_data User specified data specified in http_client_req()
+ *
+ * @return >0 length of the next piece,
+ *          0  if all the payload has been given,
+ *         <0  if http_client_req() should return the error code to the
+ *             caller.
+ */
+typedef ssize_t (*http_payload_producer_t)(struct http_request *req,
+					   const void **data,
+					   void *user_data);
+
+/**
+ * @typedef http_body_cb_t
+ * @brief Callback used when a part of the response body is received.
+ *
+ * @param rsp HTTP response information
+ * @param data Part of the body. This points into the receive buffer and
+ *        is only valid during the callback.
+ * @param len Length of the part
+ * @param user_data User specified data specified in http_client_req()
+ */
+typedef void (*http_body_cb_t)(struct http_response *rsp,
+			       const uint8_t *data, size_t len,
+			       void *user_data);
+
 /**
  * HTTP response from the server.
  */
@@ -149,6 +183,11 @@ struct http_response {
 	uint8_t cl_present : 1;
 	uint8_t body_found : 1;
 	uint8_t message_complete : 1;
+
+	/** Set when the message is complete if the connection can be used
+	 * for further requests.
+	 */
+	uint8_t keep_alive : 1;
 };
 
 /** HTTP client internal data that the application should not touch
@@ -171,6 +210,14 @@ struct http_client_internal_data {
 	/** User data */
 	void *user_data;
 
+	/** Data received after the end of the response, which belongs to
+	 * the response to the next pipelined request.
+	 */
+	const char *rest;
+
+	/** Length of the data received after the end of the response */
+	size_t rest_len;
+
 	/** HTTP socket */
 	int sock;
 
@@ -265,6 +312,20 @@ struct http_request {
 	 * headers will be placed into this field.
 	 */
 	const char **optional_headers;
+
+	/** User supplied callback function to call to get the payload when
+	 * its length is not known in advance. The payload is then sent with
+	 * the chunked transfer encoding. If set, the payload, payload_cb and
+	 * payload_len fields are ignored.
+	 */
+	http_payload_producer_t payload_producer;
+
+	/** User supplied callback function to call when a part of the
+	 * response body is received. Unlike the response callback, this is
+	 * given the part itself, which is not copied. May be NULL, in which
+	 * case the response callback must be set.
+	 */
+	http_body_cb_t body_cb;
 };
 
 /**
@@ -285,6 +346,30 @@ struct http_request {
 int http_client_req(int sock, struct http_request *req,
 		    int32_t timeout, void *user_data);
 
+/**
+ * @brief Do several HTTP requests on the same connection without waiting
+ * for the responses in between (HTTP pipelining). All the requests are
+ * sent first, then the responses are received in order and given to the
+ * callbacks of their requests.
+ *
+ * As with http_client_req(), the connection can be used for further
+ * requests if the keep_alive flag of the last response is set.
+ *
+ * @param sock Socket id of the connection.
+ * @param reqs HTTP requests to send, in order
+ * @param count Number of requests
+ * @param timeout Max timeout to wait for all the responses, in
+ *        milliseconds.
+ * @param user_data User specified data that is passed to the callbacks.
+ *
+ * @return <0 if error, for example if the server closed the connection
+ *         before all the responses were received, >=0 amount of data sent
+ *         to the server.
+ */
+int http_client_req_pipelined(int sock, struct http_request **reqs,
+			      size_t count, int32_t timeout,
+			      void *user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,281 @@
+/** @file
+ * @brief HTTP server API
+ *
+ * An API for applications to serve HTTP/1.1 resources
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_HTTP_SERVER_H_
+#define ZEPHYR_INCLUDE_NET_HTTP_SERVER_H_
+
+/**
+ * @brief HTTP server API
+ * @defgroup http_server HTTP server API
+ * @ingroup networking
+ * @{
+ */
+
+#include <kernel.h>
+#include <net/net_ip.h>
+#include <net/http_parser.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(HTTP_CRLF)
+#define HTTP_CRLF "\r\n"
+#endif
+
+struct http_server_req;
+
+/**
+ * @typedef http_resource_cb_t
+ * @brief Callback used when a request for a dynamic resource is received.
+ *
+ * The callback is run by the server thread and must answer the request
+ * with http_server_send_response() or with the chunked response
+ * functions before returning. Other connections are not served while
+ * the callback runs.
+ *
+ * @param req Request information
+ * @param user_data User data given in HTTP_RESOURCE_DYNAMIC_DEFINE()
+ *
+ * @return 0 if ok, <0 if the connection should be closed. If the
+ *         callback returns 0 without sending a response, the server
+ *         answers with 500 Internal Server Error.
+ */
+typedef int (*http_resource_cb_t)(struct http_server_req *req,
+				  void *user_data);
+
+/** Type of a HTTP server resource */
+enum http_resource_type {
+	/** Content kept in memory, typically a generated include file */
+	HTTP_RESOURCE_STATIC,
+
+	/** Content created by a callback */
+	HTTP_RESOURCE_DYNAMIC,
+
+	/** Content read from a file, sent with sendfile() */
+	HTTP_RESOURCE_FILE,
+};
+
+/**
+ * HTTP server resource. Resources are defined at build time with the
+ * HTTP_RESOURCE_*_DEFINE() macros, the application does not need to
+ * register them.
+ */
+struct http_resource {
+	/** Path of the resource, for example "/index.html" */
+	const char *path;
+
+	/** Value of the Content-Type header field, may be NULL */
+	const char *content_type;
+
+	/** Value of the Content-Encoding header field, for example "gzip"
+	 * for precompressed content. May be NULL.
+	 */
+	const char *content_encoding;
+
+	union {
+		/** Static content */
+		struct {
+			const uint8_t *data;
+			size_t len;
+		} content;
+
+		/** Dynamic content */
+		struct {
+			http_resource_cb_t cb;
+			void *user_data;
+		} dynamic;
+
+		/** Name of the file in the file system */
+		const char *file;
+	};
+
+	/** Length of the path */
+	uint16_t path_len;
+
+	/** enum http_resource_type */
+	uint8_t type;
+};
+
+/** @cond INTERNAL_HIDDEN */
+#define Z_HTTP_RESOURCE_DEFINE(_name, _path, _type, ...)		\
+	const Z_STRUCT_SECTION_ITERABLE(http_resource, _name) = {	\
+		.path = _path,						\
+		.path_len = sizeof(_path) - 1,				\
+		.type = _type,						\
+		__VA_ARGS__						\
+	}
+/** @endcond */
+
+/**
+ * @brief Define a resource served from memory.
+ *
+ * The content is typically generated at build time with
+ * generate_inc_file_for_target(), which compresses it when given the
+ * --gzip option. The encoding is then "gzip".
+ *
+ * @param _name Name of the resource variable
+ * @param _path Path of the resource, must be a string literal
+ * @param _content_type Value of the Content-Type header field
+ * @param _encoding Value of the Content-Encoding header field or NULL
+ * @param _data Content of the resource
+ * @param _len Length of the content
+ */
+#define HTTP_RESOURCE_STATIC_DEFINE(_name, _path, _content_type,	\
+				    _encoding, _data, _len)		\
+	Z_HTTP_RESOURCE_DEFINE(_name, _path, HTTP_RESOURCE_STATIC,	\
+			       .content_type = _content_type,		\
+			       .content_encoding = _encoding,		\
+			       .content = { .data = _data, .len = _len })
+
+/**
+ * @brief Define a resource whose content is created by a callback.
+ *
+ * @param _name Name of the resource variable
+ * @param _path Path of the resource, must be a string literal
+ * @param _cb Callback of type http_resource_cb_t
+ * @param _user_data User data given to the callback
+ */
+#define HTTP_RESOURCE_DYNAMIC_DEFINE(_name, _path, _cb, _user_data)	\
+	Z_HTTP_RESOURCE_DEFINE(_name, _path, HTTP_RESOURCE_DYNAMIC,	\
+			       .dynamic = { .cb = _cb,			\
+					    .user_data = _user_data })
+
+/**
+ * @brief Define a resource served from a file.
+ *
+ * Requires CONFIG_HTTP_SERVER_FILE.
+ *
+ * @param _name Name of the resource variable
+ * @param _path Path of the resource, must be a string literal
+ * @param _content_type Value of the Content-Type header field
+ * @param _encoding Value of the Content-Encoding header field or NULL
+ * @param _file Name of the file, for example "/RAM:/index.html"
+ */
+#define HTTP_RESOURCE_FILE_DEFINE(_name, _path, _content_type,		\
+				  _encoding, _file)			\
+	Z_HTTP_RESOURCE_DEFINE(_name, _path, HTTP_RESOURCE_FILE,	\
+			       .content_type = _content_type,		\
+			       .content_encoding = _encoding,		\
+			       .file = _file)
+
+/**
+ * HTTP request given to a dynamic resource callback. The data is only
+ * valid while the callback runs.
+ */
+struct http_server_req {
+	/** The HTTP method: GET, HEAD, POST, ... */
+	enum http_method method;
+
+	/** Requested URL, including the query string. NUL terminated. */
+	const char *url;
+
+	/** Length of the URL */
+	size_t url_len;
+
+	/** Request body, NULL if there is none */
+	const uint8_t *body;
+
+	/** Length of the request body */
+	size_t body_len;
+
+	/** Resource the request is for */
+	const struct http_resource *resource;
+
+	/* Server internal data, the application should not touch these */
+
+	/** Socket of the connection */
+	int sock;
+
+	/** Whether a response has been (or is being) sent */
+	uint8_t responded : 1;
+
+	/** Whether a chunked response is being sent */
+	uint8_t chunked : 1;
+
+	/** Whether the connection is kept open after the response */
+	uint8_t keep_alive : 1;
+};
+
+/**
+ * @brief Send a complete response to a request.
+ *
+ * @param req Request to answer
+ * @param status HTTP status code, for example 200
+ * @param content_type Value of the Content-Type header field or NULL
+ * @param body Response body, may be NULL if len is 0
+ * @param len Length of the body
+ *
+ * @return 0 if ok, -ENOBUFS if the part of the response the socket does
+ * not take right away does not fit in the send buffer, <0 if other error
+ */
+int http_server_send_response(struct http_server_req *req, uint16_t status,
+			      const char *content_type,
+			      const void *body, size_t len);
+
+/**
+ * @brief Start a response whose body is sent with chunked transfer
+ * encoding. Use this when the length of the body is not known in advance.
+ *
+ * @param req Request to answer
+ * @param status HTTP status code, for example 200
+ * @param content_type Value of the Content-Type header field or NULL
+ *
+ * @return 0 if ok, <0 if error
+ */
+int http_server_send_chunked_start(struct http_server_req *req,
+				   uint16_t status, const char *content_type);
+
+/**
+ * @brief Send a chunk of a response started with
+ * http_server_send_chunked_start().
+ *
+ * @param req Request being answered
+ * @param data Data of the chunk
+ * @param len Length of the chunk, empty chunks are not sent
+ *
+ * @return 0 if ok, <0 if error
+ */
+int http_server_send_chunk(struct http_server_req *req,
+			   const void *data, size_t len);
+
+/**
+ * @brief Finish a response started with http_server_send_chunked_start().
+ *
+ * @param req Request being answered
+ *
+ * @return 0 if ok, <0 if error
+ */
+int http_server_send_chunked_end(struct http_server_req *req);
+
+/**
+ * @brief Start the HTTP server.
+ *
+ * The server thread listens on the given port on all the enabled address
+ * families and serves the resources defined with the
+ * HTTP_RESOURCE_*_DEFINE() macros.
+ *
+ * @param port Port number to listen on
+ *
+ * @return 0 if ok, <0 if error
+ */
+int http_server_start(uint16_t port);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_HTTP_SERVER_H_ */
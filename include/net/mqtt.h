@@ -84,7 +84,10 @@ enum mqtt_evt_type {
 /** @brief MQTT version protocol level. */
 enum mqtt_version {
 	MQTT_VERSION_3_1_0 = 3, /**< Protocol level for 3.1.0. */
-	MQTT_VERSION_3_1_1 = 4  /**< Protocol level for 3.1.1. */
+	MQTT_VERSION_3_1_1 = 4, /**< Protocol level for 3.1.1. */
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	MQTT_VERSION_5_0 = 5    /**< Protocol level for 5.0. */
+#endif
 };
 
 /** @brief MQTT Quality of Service types. */
@@ -172,6 +175,125 @@ struct mqtt_binstr {
 	uint32_t len;              /**< Length of binary stream. */
 };
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/** @brief MQTT 5.0 reason codes, carried by acknowledgments and
+ *         by CONNACK in place of @ref mqtt_conn_return_code.
+ */
+enum mqtt_reason_code {
+	MQTT_RC_SUCCESS                     = 0x00,
+	MQTT_RC_NO_MATCHING_SUBSCRIBERS     = 0x10,
+	MQTT_RC_NO_SUBSCRIPTION_EXISTED     = 0x11,
+	MQTT_RC_UNSPECIFIED_ERROR           = 0x80,
+	MQTT_RC_MALFORMED_PACKET            = 0x81,
+	MQTT_RC_PROTOCOL_ERROR              = 0x82,
+	MQTT_RC_IMPLEMENTATION_SPECIFIC     = 0x83,
+	MQTT_RC_UNSUPPORTED_PROTOCOL        = 0x84,
+	MQTT_RC_CLIENT_ID_NOT_VALID         = 0x85,
+	MQTT_RC_BAD_USER_NAME_OR_PASSWORD   = 0x86,
+	MQTT_RC_NOT_AUTHORIZED              = 0x87,
+	MQTT_RC_SERVER_UNAVAILABLE          = 0x88,
+	MQTT_RC_SERVER_BUSY                 = 0x89,
+	MQTT_RC_BANNED                      = 0x8A,
+	MQTT_RC_SERVER_SHUTTING_DOWN        = 0x8B,
+	MQTT_RC_KEEP_ALIVE_TIMEOUT          = 0x8D,
+	MQTT_RC_SESSION_TAKEN_OVER          = 0x8E,
+	MQTT_RC_TOPIC_FILTER_INVALID        = 0x8F,
+	MQTT_RC_TOPIC_NAME_INVALID          = 0x90,
+	MQTT_RC_PACKET_ID_IN_USE            = 0x91,
+	MQTT_RC_PACKET_ID_NOT_FOUND         = 0x92,
+	MQTT_RC_RECEIVE_MAXIMUM_EXCEEDED    = 0x93,
+	MQTT_RC_TOPIC_ALIAS_INVALID         = 0x94,
+	MQTT_RC_PACKET_TOO_LARGE            = 0x95,
+	MQTT_RC_QUOTA_EXCEEDED              = 0x97,
+	MQTT_RC_PAYLOAD_FORMAT_INVALID      = 0x99,
+	MQTT_RC_RETAIN_NOT_SUPPORTED        = 0x9A,
+	MQTT_RC_QOS_NOT_SUPPORTED           = 0x9B,
+	MQTT_RC_USE_ANOTHER_SERVER          = 0x9C,
+	MQTT_RC_SERVER_MOVED                = 0x9D,
+	MQTT_RC_CONNECTION_RATE_EXCEEDED    = 0x9F,
+};
+
+/** @brief Abstracts UTF-8 encoded string pairs, used by user properties. */
+struct mqtt_utf8_pair {
+	struct mqtt_utf8 name;     /**< Name of the pair. */
+	struct mqtt_utf8 value;    /**< Value of the pair. */
+};
+
+/** @brief MQTT 5.0 properties.
+ *
+ * @details The same structure is used by all packets carrying properties.
+ *          Only the properties the specification allows in a packet are
+ *          encoded, and a zero value or an empty string stands for an
+ *          absent property. Received strings point into the receive buffer
+ *          and are only valid during the event callback.
+ */
+struct mqtt_prop {
+	/** Session Expiry Interval, in seconds. CONNECT, CONNACK and
+	 *  DISCONNECT.
+	 */
+	uint32_t session_expiry_interval;
+
+	/** Message Expiry Interval, in seconds. PUBLISH. */
+	uint32_t message_expiry_interval;
+
+	/** Maximum Packet Size accepted. CONNECT and CONNACK. */
+	uint32_t maximum_packet_size;
+
+	/** Subscription Identifier. SUBSCRIBE, and received PUBLISH. */
+	uint32_t subscription_identifier;
+
+	/** Receive Maximum, the number of QoS 1 and 2 PUBLISH that can be
+	 *  unacknowledged. CONNECT and CONNACK.
+	 */
+	uint16_t receive_maximum;
+
+	/** Topic Alias Maximum. Received in CONNACK, the library sets it in
+	 *  CONNECT from :option:`CONFIG_MQTT_TOPIC_ALIAS_MAX`.
+	 */
+	uint16_t topic_alias_maximum;
+
+	/** Topic Alias of a received PUBLISH. Aliases of sent PUBLISH are
+	 *  managed by the library.
+	 */
+	uint16_t topic_alias;
+
+	/** Server Keep Alive, in seconds. CONNACK. */
+	uint16_t server_keep_alive;
+
+	/** Payload Format Indicator, 1 for UTF-8 payloads. PUBLISH. */
+	uint8_t payload_format_indicator;
+
+	/** Maximum QoS supported by the server, 2 if absent. CONNACK. */
+	uint8_t maximum_qos;
+
+	/** Retain Available, 1 if absent. CONNACK. */
+	uint8_t retain_available;
+
+	/** Content Type. PUBLISH. */
+	struct mqtt_utf8 content_type;
+
+	/** Response Topic. PUBLISH. */
+	struct mqtt_utf8 response_topic;
+
+	/** Correlation Data. PUBLISH. */
+	struct mqtt_binstr correlation_data;
+
+	/** Assigned Client Identifier. CONNACK. */
+	struct mqtt_utf8 assigned_client_id;
+
+	/** Reason String. CONNACK, acknowledgments and DISCONNECT. */
+	struct mqtt_utf8 reason_string;
+
+	/** User Properties. All packets. Received properties beyond
+	 *  :option:`CONFIG_MQTT_USER_PROP_MAX` are dropped.
+	 */
+	struct mqtt_utf8_pair user_prop[CONFIG_MQTT_USER_PROP_MAX];
+
+	/** Number of User Properties. */
+	uint8_t user_prop_count;
+};
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
 /** @brief Abstracts MQTT UTF-8 encoded topic that can be subscribed
  *         to or published.
  */
@@ -201,39 +323,90 @@ struct mqtt_connack_param {
 
 	/** The appropriate non-zero Connect return code indicates if the Server
 	 *  is unable to process a connection request for some reason.
+	 *  With MQTT 5.0, holds a @ref mqtt_reason_code instead.
 	 */
 	enum mqtt_conn_return_code return_code;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief Parameters for MQTT publish acknowledgment (PUBACK). */
 struct mqtt_puback_param {
 	uint16_t message_id;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	uint8_t reason_code;
+
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief Parameters for MQTT publish receive (PUBREC). */
 struct mqtt_pubrec_param {
 	uint16_t message_id;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	uint8_t reason_code;
+
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief Parameters for MQTT publish release (PUBREL). */
 struct mqtt_pubrel_param {
 	uint16_t message_id;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	uint8_t reason_code;
+
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief Parameters for MQTT publish complete (PUBCOMP). */
 struct mqtt_pubcomp_param {
 	uint16_t message_id;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 reason code, see @ref mqtt_reason_code. */
+	uint8_t reason_code;
+
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief Parameters for MQTT subscription acknowledgment (SUBACK). */
 struct mqtt_suback_param {
 	uint16_t message_id;
 	struct mqtt_binstr return_codes;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief Parameters for MQTT unsubscribe acknowledgment (UNSUBACK). */
 struct mqtt_unsuback_param {
 	uint16_t message_id;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 reason codes, one per topic filter. */
+	struct mqtt_binstr reason_codes;
+
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief Parameters for a publish message. */
@@ -255,6 +428,11 @@ struct mqtt_publish_param {
 	 *  by the broker.
 	 */
 	uint8_t retain_flag : 1;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /** @brief List of topics in a subscription request. */
@@ -267,6 +445,11 @@ struct mqtt_subscription_list {
 
 	/** Message id used to identify subscription request. */
 	uint16_t message_id;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 properties. */
+	struct mqtt_prop prop;
+#endif
 };
 
 /**
@@ -432,6 +615,17 @@ struct mqtt_transport {
 #endif
 };
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/** @brief Topic bound to an MQTT 5.0 topic alias. */
+struct mqtt_topic_alias {
+	/** Length of the topic, 0 if the alias is not bound. */
+	uint16_t size;
+
+	/** Copy of the topic. */
+	uint8_t topic[CONFIG_MQTT_TOPIC_ALIAS_SIZE];
+};
+#endif
+
 /** @brief MQTT internal state. */
 struct mqtt_internal {
 	/** Internal. Mutex to protect access to the client instance. */
@@ -450,6 +644,38 @@ struct mqtt_internal {
 
 	/** Internal. Remaining payload length to read. */
 	uint32_t remaining_payload;
+
+#if defined(CONFIG_MQTT_TX_QUEUE)
+	/** Internal. Length of the queued messages in the queue buffer. */
+	uint32_t queue_len;
+#endif
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** Internal. Maximum packet size accepted by the server, 0 if not
+	 *  limited.
+	 */
+	uint32_t max_packet_size;
+
+	/** Internal. Receive Maximum of the server. */
+	uint16_t receive_max;
+
+	/** Internal. Number of QoS 1 and 2 PUBLISH that can still be sent
+	 *  before acknowledgments are received.
+	 */
+	uint16_t send_quota;
+
+	/** Internal. Number of topic aliases the server accepts. */
+	uint16_t tx_alias_max;
+
+	/** Internal. Index of the next sent topic alias to be replaced. */
+	uint16_t tx_alias_next;
+
+	/** Internal. Topic aliases used for sent PUBLISH. */
+	struct mqtt_topic_alias tx_alias[CONFIG_MQTT_TOPIC_ALIAS_MAX];
+
+	/** Internal. Topic aliases set by the server in received PUBLISH. */
+	struct mqtt_topic_alias rx_alias[CONFIG_MQTT_TOPIC_ALIAS_MAX];
+#endif
 };
 
 /**
@@ -490,6 +716,13 @@ struct mqtt_client {
 	 */
 	struct mqtt_utf8 *will_message;
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/** MQTT 5.0 properties sent in CONNECT, used when protocol_version
+	 *  is MQTT_VERSION_5_0.
+	 */
+	struct mqtt_prop prop;
+#endif
+
 	/** Application callback registered with the module to get MQTT events.
 	 */
 	mqtt_evt_cb_t evt_cb;
@@ -506,6 +739,16 @@ struct mqtt_client {
 	/** Size of transmit buffer. */
 	uint32_t tx_buf_size;
 
+#if defined(CONFIG_MQTT_TX_QUEUE)
+	/** Buffer holding the messages queued with
+	 *  @ref mqtt_publish_queued, payload included.
+	 */
+	uint8_t *queue_buf;
+
+	/** Size of queue buffer. */
+	uint32_t queue_buf_size;
+#endif
+
 	/** Keepalive interval for this client in seconds.
 	 *  Default is CONFIG_MQTT_KEEPALIVE.
 	 */
@@ -591,6 +834,61 @@ int mqtt_connect(struct mqtt_client *client);
 int mqtt_publish(struct mqtt_client *client,
 		 const struct mqtt_publish_param *param);
 
+#if defined(CONFIG_MQTT_TX_QUEUE)
+/**
+ * @brief API to queue messages to be published on topics.
+ *
+ * @details The message, payload included, is copied to the queue buffer of
+ *          the client, so the parameters can be reused as soon as the
+ *          function returns. Queued messages are sent in order, as many in
+ *          a single write as possible, when the client is connected.
+ *          Up to :option:`CONFIG_MQTT_TX_QUEUE_INFLIGHT` QoS 1 and 2
+ *          messages can wait for their acknowledgment, which is handled by
+ *          the library: @ref MQTT_EVT_PUBREC is answered with a PUBREL.
+ *          Unacknowledged messages are sent again, with the DUP flag set,
+ *          once the client is connected again.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[in] param Parameters to be used for the publish message.
+ *                  Shall not be NULL.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ *         -ENOMEM is returned when the queue buffer is full.
+ */
+int mqtt_publish_queued(struct mqtt_client *client,
+			const struct mqtt_publish_param *param);
+
+/**
+ * @brief API to send the queued messages that can be sent now.
+ *
+ * @details Queued messages are also sent when acknowledgments are received,
+ *          on @ref mqtt_live and on connection, so this only needs to be
+ *          called to send the messages queued since then without delay.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_flush(struct mqtt_client *client);
+
+/**
+ * @brief API to restore the unacknowledged messages stored before a reboot.
+ *
+ * @details Should be called after the client is initialized and its queue
+ *          buffer set, before connecting. The restored messages are sent
+ *          again on connection. Requires
+ *          :option:`CONFIG_MQTT_TX_QUEUE_PERSIST`.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_queue_restore(struct mqtt_client *client);
+#endif /* CONFIG_MQTT_TX_QUEUE */
+
 /**
  * @brief API used by client to send acknowledgment on receiving QoS1 publish
  *        message. Should be called on reception of @ref MQTT_EVT_PUBLISH with
@@ -111,6 +111,24 @@ typedef void (*net_context_send_cb_t)(struct net_context *context,
 				      int status,
 				      void *user_data);
 
+/**
+ * @typedef net_context_zerocopy_cb_t
+ * @brief Zero-copy data release callback.
+ *
+ * @details The callback is called once the network stack does not
+ * reference the data given to net_context_sendto_zerocopy() anymore, so
+ * the caller can reuse the buffer. For TCP this happens when the peer has
+ * acknowledged the data. The callback is called from the thread that
+ * releases the data, typically a TX or RX thread, and must not block.
+ *
+ * @param context The context the data was sent with.
+ * @param buf The data buffer given to net_context_sendto_zerocopy().
+ * @param user_data The user data given to net_context_sendto_zerocopy().
+ */
+typedef void (*net_context_zerocopy_cb_t)(struct net_context *context,
+					  const void *buf,
+					  void *user_data);
+
 /**
  * @typedef net_tcp_accept_cb_t
  * @brief Accept callback
@@ -275,6 +293,15 @@ __net_socket struct net_context {
 		struct k_fifo accept_q;
 	};
 
+#if defined(CONFIG_NET_SOCKETS_ZEROCOPY)
+	/** Number of zero-copy sends whose data has been released */
+	atomic_t zerocopy_done;
+#endif
+
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+	/** Readiness notifiers of the socket, see struct zfd_notifier */
+	sys_dlist_t poll_notifiers;
+#endif
 #endif /* CONFIG_NET_SOCKETS */
 
 #if defined(CONFIG_NET_OFFLOAD)
@@ -907,7 +934,8 @@ int net_context_accept(struct net_context *context,
  * @param buf The data buffer to send
  * @param len Length of the buffer
  * @param cb Caller-supplied callback function.
- * @param timeout Currently this value is not used.
+ * @param timeout For TCP, time to wait for the send window of the peer to
+ * have room for the data, -EAGAIN is returned when it expires.
  * @param user_data Caller-supplied user data.
  *
  * @return 0 if ok, < 0 if error
@@ -935,7 +963,8 @@ int net_context_send(struct net_context *context,
  * @param dst_addr Destination address.
  * @param addrlen Length of the address.
  * @param cb Caller-supplied callback function.
- * @param timeout Currently this value is not used.
+ * @param timeout For TCP, time to wait for the send window of the peer to
+ * have room for the data, -EAGAIN is returned when it expires.
  * @param user_data Caller-supplied user data.
  *
  * @return numbers of bytes sent on success, a negative errno otherwise
@@ -949,6 +978,39 @@ int net_context_sendto(struct net_context *context,
 		       k_timeout_t timeout,
 		       void *user_data);
 
+/**
+ * @brief Send data without copying it.
+ *
+ * @details Same as net_context_sendto() for UDP and TCP contexts, but the
+ * data buffer is attached to the network packet instead of being copied
+ * into it. The buffer must not be modified until the release callback has
+ * been called, which can happen after the context has been released with
+ * net_context_put(). The callback is not called if this function fails,
+ * unless the data was already queued to a TCP connection that then got
+ * aborted.
+ *
+ * @param context The network context to use.
+ * @param buf The data buffer to send
+ * @param len Length of the buffer
+ * @param dst_addr Destination address, or NULL to send to the address the
+ * context is connected to.
+ * @param addrlen Length of the address.
+ * @param cb Called when the data is not used by the stack anymore.
+ * @param timeout Timeout for getting a network packet, and for TCP for
+ * the send window of the peer to have room for the data.
+ * @param user_data Caller-supplied user data given to the callback.
+ *
+ * @return numbers of bytes sent on success, a negative errno otherwise
+ */
+int net_context_sendto_zerocopy(struct net_context *context,
+				const void *buf,
+				size_t len,
+				const struct sockaddr *dst_addr,
+				socklen_t addrlen,
+				net_context_zerocopy_cb_t cb,
+				k_timeout_t timeout,
+				void *user_data);
+
 /**
  * @brief Send data in iovec to a peer specified in msghdr struct.
  *
@@ -962,7 +1024,8 @@ int net_context_sendto(struct net_context *context,
  * @param msghdr The data to send
  * @param flags Flags for the sending.
  * @param cb Caller-supplied callback function.
- * @param timeout Currently this value is not used.
+ * @param timeout For TCP, time to wait for the send window of the peer to
+ * have room for the data, -EAGAIN is returned when it expires.
  * @param user_data Caller-supplied user data.
  *
  * @return numbers of bytes sent on success, a negative errno otherwise
@@ -112,6 +112,41 @@ enum net_verdict {
  */
 int net_recv_data(struct net_if *iface, struct net_pkt *pkt);
 
+/**
+ * @brief Called by network device drivers that have multiple hardware
+ * Rx queues, instead of net_recv_data(). Packets received from the same
+ * hardware queue are processed in the same Rx queue of the stack, so the
+ * order of a flow is kept as long as the hardware steers each flow to one
+ * queue (RSS). If CONFIG_NET_RX_FLOW_STEERING is not enabled, this is the
+ * same as net_recv_data().
+ *
+ * @param iface Network interface where the packet was received.
+ * @param pkt Network packet data.
+ * @param queue Hardware Rx queue (or RSS hash) of the packet, it is mapped
+ * to the CONFIG_NET_RX_FLOW_QUEUES Rx queues modulo their count.
+ *
+ * @return 0 if ok, <0 if error.
+ */
+int net_recv_data_queue(struct net_if *iface, struct net_pkt *pkt,
+			uint32_t queue);
+
+/**
+ * @brief Called by network device drivers to pass a burst of received
+ * network packets to the network stack at once, instead of calling
+ * net_recv_data() for each of them. The packets are queued to the Rx
+ * queues with one queue operation per queue.
+ *
+ * @param iface Network interface where the packets were received.
+ * @param pkts Network packets, in the order they were received.
+ * @param count Number of packets in @a pkts.
+ *
+ * @return Number of packets taken by the stack, starting from the first
+ * one. The caller still owns the rest of them. <0 if error and no packet
+ * was taken.
+ */
+int net_recv_data_burst(struct net_if *iface, struct net_pkt **pkts,
+			int count);
+
 /**
  * @brief Send data to network.
  *
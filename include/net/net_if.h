@@ -187,6 +187,12 @@ enum net_if_flag {
 	 */
 	NET_IF_FORWARD_MULTICASTS,
 
+	/** IPv4 packets forwarded to this interface get its address as
+	 * source address (masquerade). Used only if CONFIG_NET_IPV4_NAT
+	 * is enabled.
+	 */
+	NET_IF_IPV4_MASQUERADE,
+
 /** @cond INTERNAL_HIDDEN */
 	/* Total number of flags - must be at the end of the enum */
 	NET_IF_NUM_FLAGS
@@ -444,6 +450,26 @@ struct net_if_dev {
 #endif /* CONFIG_NET_SOCKETS_OFFLOAD */
 };
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+/**
+ * @brief Network packets and buffers of the global pools which are held
+ * by an interface. Used only if CONFIG_NET_PKT_QUOTA is enabled.
+ */
+struct net_if_pkt_usage {
+	/** Packets allocated from the RX slab */
+	atomic_t rx_pkts;
+
+	/** Packets allocated from the TX slab */
+	atomic_t tx_pkts;
+
+	/** Buffers allocated from the RX data pool */
+	atomic_t rx_bufs;
+
+	/** Buffers allocated from the TX data pool */
+	atomic_t tx_bufs;
+};
+#endif /* CONFIG_NET_PKT_QUOTA */
+
 /**
  * @brief Network Interface structure
  *
@@ -463,6 +489,11 @@ struct net_if {
 	/** Network interface instance configuration */
 	struct net_if_config config;
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+	/** Packets and buffers allocated on this network interface */
+	struct net_if_pkt_usage pkt_usage;
+#endif /* CONFIG_NET_PKT_QUOTA */
+
 #if defined(CONFIG_NET_POWER_MANAGEMENT)
 	/** Keep track of packets pending in traffic queues. This is
 	 * needed to avoid putting network device driver to sleep if
@@ -1933,6 +1964,19 @@ bool net_if_need_calc_rx_checksum(struct net_if *iface);
  */
 bool net_if_need_calc_tx_checksum(struct net_if *iface);
 
+/**
+ * @brief Check if TCP needs to split outgoing data into MSS sized segments
+ * itself. If the interface supports TCP segmentation offload, or the L2
+ * can segment the data in software right before the driver (GSO), TCP can
+ * pass larger segments down the stack and save the per segment processing
+ * cost.
+ *
+ * @param iface Network interface
+ *
+ * @return True if TCP must segment the data, false otherwise.
+ */
+bool net_if_need_tcp_segmentation(struct net_if *iface);
+
 /**
  * @brief Get interface according to index
  *
@@ -234,6 +234,25 @@ struct msghdr {
 	int           msg_flags;      /* flags on received message */
 };
 
+/** Message header of sendmmsg() and recvmmsg() */
+struct mmsghdr {
+	struct msghdr msg_hdr;        /* message header */
+	unsigned int  msg_len;        /* number of bytes transmitted */
+};
+
+/** Control message data of IP_PKTINFO */
+struct in_pktinfo {
+	unsigned int   ipi_ifindex;   /* interface index */
+	struct in_addr ipi_spec_dst;  /* local address */
+	struct in_addr ipi_addr;      /* header destination address */
+};
+
+/** Control message data of IPV6_PKTINFO */
+struct in6_pktinfo {
+	struct in6_addr ipi6_addr;    /* header destination address */
+	unsigned int    ipi6_ifindex; /* interface index */
+};
+
 struct cmsghdr {
 	socklen_t cmsg_len;    /* Number of bytes, including header */
 	int       cmsg_level;  /* Originating protocol */
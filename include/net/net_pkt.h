@@ -97,6 +97,12 @@ struct net_pkt {
 	struct net_if *orig_iface; /* Original network interface */
 #endif
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+	/* Interface the packet and its buffers are accounted to */
+	struct net_if *quota_iface;
+	uint16_t quota_bufs; /* Buffers accounted to quota_iface */
+#endif
+
 #if defined(CONFIG_NET_PKT_TIMESTAMP) || \
 				defined(CONFIG_NET_PKT_RXTIME_STATS) ||	\
 				defined(CONFIG_NET_PKT_TXTIME_STATS)
@@ -163,7 +169,8 @@ struct net_pkt {
 	};
 
 	uint8_t forwarding : 1;	/* Are we forwarding this pkt
-				 * Used only if defined(CONFIG_NET_ROUTE)
+				 * Used only if defined(CONFIG_NET_ROUTE) or
+				 * defined(CONFIG_NET_IPV4_FORWARDING)
 				 */
 	uint8_t family     : 3;	/* IPv4 vs IPv6 */
 
@@ -190,6 +197,11 @@ struct net_pkt {
 					*/
 #endif
 
+	uint8_t chksum_done       : 1; /* Driver has already verified the
+					* IP and transport layer checksums of
+					* this received pkt.
+					*/
+
 	union {
 		/* IPv6 hop limit or IPv4 ttl for this network packet.
 		 * The value is shared between IPv6 and IPv4.
@@ -212,6 +224,21 @@ struct net_pkt {
 	 */
 	uint8_t priority;
 
+#if defined(CONFIG_NET_TCP_GSO)
+	/* Segment size to use when splitting an oversized TCP segment into
+	 * frames, either by the hardware (TSO) or by the L2 (GSO).
+	 * Zero if the packet does not need to be segmented.
+	 */
+	uint16_t gso_size;
+#endif /* CONFIG_NET_TCP_GSO */
+
+#if defined(CONFIG_NET_RX_FLOW_STEERING)
+	/* Rx queue of the traffic class this packet is processed in,
+	 * selected from the flow hash or by the driver.
+	 */
+	uint8_t rx_queue;
+#endif /* CONFIG_NET_RX_FLOW_STEERING */
+
 #if defined(CONFIG_NET_VLAN)
 	/* VLAN TCI (Tag Control Information). This contains the Priority
 	 * Code Point (PCP), Drop Eligible Indicator (DEI) and VLAN
@@ -394,7 +421,7 @@ static inline void net_pkt_set_eof(struct net_pkt *pkt, bool eof)
 }
 #endif
 
-#if defined(CONFIG_NET_ROUTE)
+#if defined(CONFIG_NET_ROUTE) || defined(CONFIG_NET_IPV4_FORWARDING)
 static inline bool net_pkt_forwarding(struct net_pkt *pkt)
 {
 	return pkt->forwarding;
@@ -1038,6 +1065,71 @@ static inline void net_pkt_set_ppp(struct net_pkt *pkt,
 }
 #endif /* CONFIG_NET_PPP */
 
+static inline bool net_pkt_is_chksum_done(struct net_pkt *pkt)
+{
+	return !!(pkt->chksum_done);
+}
+
+static inline void net_pkt_set_chksum_done(struct net_pkt *pkt,
+					   bool is_chksum_done)
+{
+	pkt->chksum_done = is_chksum_done;
+}
+
+#if defined(CONFIG_NET_TCP_GSO)
+static inline uint16_t net_pkt_gso_size(struct net_pkt *pkt)
+{
+	return pkt->gso_size;
+}
+
+static inline void net_pkt_set_gso_size(struct net_pkt *pkt,
+					uint16_t gso_size)
+{
+	pkt->gso_size = gso_size;
+}
+#else /* CONFIG_NET_TCP_GSO */
+static inline uint16_t net_pkt_gso_size(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return 0;
+}
+
+static inline void net_pkt_set_gso_size(struct net_pkt *pkt,
+					uint16_t gso_size)
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(gso_size);
+}
+#endif /* CONFIG_NET_TCP_GSO */
+
+#if defined(CONFIG_NET_RX_FLOW_STEERING)
+static inline uint8_t net_pkt_rx_queue(struct net_pkt *pkt)
+{
+	return pkt->rx_queue;
+}
+
+static inline void net_pkt_set_rx_queue(struct net_pkt *pkt,
+					uint8_t rx_queue)
+{
+	pkt->rx_queue = rx_queue;
+}
+#else /* CONFIG_NET_RX_FLOW_STEERING */
+static inline uint8_t net_pkt_rx_queue(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return 0;
+}
+
+static inline void net_pkt_set_rx_queue(struct net_pkt *pkt,
+					uint8_t rx_queue)
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(rx_queue);
+}
+#endif /* CONFIG_NET_RX_FLOW_STEERING */
+
 #define NET_IPV6_HDR(pkt) ((struct net_ipv6_hdr *)net_pkt_ip_data(pkt))
 #define NET_IPV4_HDR(pkt) ((struct net_ipv4_hdr *)net_pkt_ip_data(pkt))
 
@@ -1341,6 +1433,17 @@ void net_pkt_get_info(struct k_mem_slab **rx,
 		      struct net_buf_pool **rx_data,
 		      struct net_buf_pool **tx_data);
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+/**
+ * @brief Number of packets or buffers of a pool which one network
+ * interface can hold.
+ *
+ * @param count Number of packets or buffers of the pool.
+ */
+#define NET_PKT_QUOTA(count) \
+	MAX(1, (count) * CONFIG_NET_PKT_QUOTA_IFACE_PERCENT / 100)
+#endif
+
 /** @cond INTERNAL_HIDDEN */
 
 #if defined(CONFIG_NET_DEBUG_NET_PKT_ALLOC)
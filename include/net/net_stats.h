@@ -246,6 +246,36 @@ struct net_stats_tc {
 };
 
 
+/**
+ * @brief Usage of a packet slab and of its buffer pool by an interface
+ */
+struct net_stats_pkt_pool {
+	/** Highest number of packets held by the interface */
+	net_stats_t pkts_max;
+
+	/** Highest number of buffers held by the interface */
+	net_stats_t bufs_max;
+
+	/** Number of allocations refused because of the quota */
+	net_stats_t quota_drop;
+};
+
+/**
+ * @brief Network packet and buffer pool statistics
+ */
+struct net_stats_mem {
+	/** RX packet slab and buffer pool */
+	struct net_stats_pkt_pool rx;
+
+	/** TX packet slab and buffer pool */
+	struct net_stats_pkt_pool tx;
+
+	/** Number of received packets dropped to keep the packets
+	 * reserved to the highest traffic class
+	 */
+	net_stats_t reserve_drop;
+};
+
 /**
  * @brief Power management statistics
  */
@@ -341,6 +371,13 @@ struct net_stats {
 #if defined(CONFIG_NET_STATISTICS_POWER_MANAGEMENT)
 	struct net_stats_pm pm;
 #endif
+
+#if defined(CONFIG_NET_PKT_QUOTA)
+	/** Packet and buffer pool statistics. When not per interface,
+	 * the watermarks are the highest of all the interfaces.
+	 */
+	struct net_stats_mem mem;
+#endif
 };
 
 /**
@@ -465,7 +502,8 @@ enum net_request_stats_cmd {
 	NET_REQUEST_STATS_CMD_GET_TCP,
 	NET_REQUEST_STATS_CMD_GET_ETHERNET,
 	NET_REQUEST_STATS_CMD_GET_PPP,
-	NET_REQUEST_STATS_CMD_GET_PM
+	NET_REQUEST_STATS_CMD_GET_PM,
+	NET_REQUEST_STATS_CMD_GET_MEM,
 };
 
 #define NET_REQUEST_STATS_GET_ALL				\
@@ -544,6 +582,13 @@ NET_MGMT_DEFINE_REQUEST_HANDLER(NET_REQUEST_STATS_GET_ETHERNET);
 NET_MGMT_DEFINE_REQUEST_HANDLER(NET_REQUEST_STATS_GET_PPP);
 #endif /* CONFIG_NET_STATISTICS_PPP */
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+#define NET_REQUEST_STATS_GET_MEM				\
+	(_NET_STATS_BASE | NET_REQUEST_STATS_CMD_GET_MEM)
+
+NET_MGMT_DEFINE_REQUEST_HANDLER(NET_REQUEST_STATS_GET_MEM);
+#endif /* CONFIG_NET_PKT_QUOTA */
+
 #endif /* CONFIG_NET_STATISTICS_USER_API */
 
 #if defined(CONFIG_NET_STATISTICS_POWER_MANAGEMENT)
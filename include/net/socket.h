@@ -52,10 +52,52 @@ struct zsock_pollfd {
 /** zsock_poll: Invalid socket (output value only) */
 #define ZSOCK_POLLNVAL 0x20
 
+/** User data of a file descriptor registered with zsock_epoll_ctl() */
+typedef union zsock_epoll_data {
+	void *ptr;
+	int fd;
+	uint32_t u32;
+	uint64_t u64;
+} zsock_epoll_data_t;
+
+struct zsock_epoll_event {
+	uint32_t events;
+	zsock_epoll_data_t data;
+};
+
+/* ZSOCK_EPOLL* values are compatible with Linux */
+/** zsock_epoll_wait: Wait for readability */
+#define ZSOCK_EPOLLIN ZSOCK_POLLIN
+/** zsock_epoll_wait: Wait for writability */
+#define ZSOCK_EPOLLOUT ZSOCK_POLLOUT
+/** zsock_epoll_wait: Error condition (output value only) */
+#define ZSOCK_EPOLLERR ZSOCK_POLLERR
+/** zsock_epoll_wait: Closed connection (output value only) */
+#define ZSOCK_EPOLLHUP ZSOCK_POLLHUP
+/** zsock_epoll_ctl: Disable the file descriptor after one event */
+#define ZSOCK_EPOLLONESHOT BIT(30)
+/** zsock_epoll_ctl: Report only the transitions to the ready state */
+#define ZSOCK_EPOLLET BIT(31)
+
+/** zsock_epoll_ctl: Register a file descriptor */
+#define ZSOCK_EPOLL_CTL_ADD 1
+/** zsock_epoll_ctl: Unregister a file descriptor */
+#define ZSOCK_EPOLL_CTL_DEL 2
+/** zsock_epoll_ctl: Change the events of a registered file descriptor */
+#define ZSOCK_EPOLL_CTL_MOD 3
+
 /** zsock_recv: Read data without removing it from socket input queue */
 #define ZSOCK_MSG_PEEK 0x02
 /** zsock_recv/zsock_send: Override operation to non-blocking */
 #define ZSOCK_MSG_DONTWAIT 0x40
+/** zsock_send/zsock_sendto: Send the data without copying it */
+#define ZSOCK_MSG_ZEROCOPY 0x4000000
+/** zsock_recvmsg: Control data was truncated (output value only) */
+#define ZSOCK_MSG_CTRUNC 0x08
+/** zsock_recvmsg: Datagram was truncated (output value only) */
+#define ZSOCK_MSG_TRUNC 0x20
+/** zsock_recvmmsg: Do not wait after the first message was received */
+#define ZSOCK_MSG_WAITFORONE 0x10000
 
 /* Well-known values, e.g. from Linux man 2 shutdown:
  * "The constants SHUT_RD, SHUT_WR, SHUT_RDWR have the value 0, 1, 2,
@@ -119,9 +161,69 @@ struct zsock_pollfd {
  *    - 1 - server
  */
 #define TLS_DTLS_ROLE 6
+/** Socket option to enable TLS session resumption. It accepts and returns
+ *  an integer:
+ *    - 0 - disabled
+ *    - 1 - enabled
+ *
+ *  When enabled on a client socket, the session established with a peer
+ *  is stored after the handshake, and offered to the same peer address and
+ *  hostname on the next connection, which saves a full handshake if the
+ *  server accepts it. When enabled on a listening socket, the accepted
+ *  connections issue session tickets to the clients, if supported by the
+ *  mbedTLS configuration (MBEDTLS_SSL_SESSION_TICKETS and
+ *  MBEDTLS_SSL_TICKET_C). Disabled by default.
+ */
+#define TLS_SESSION_CACHE 7
+/** Write-only socket option to remove all the stored client sessions.
+ *  The option value is ignored.
+ */
+#define TLS_SESSION_CACHE_PURGE 8
+/** Socket option to set the maximum fragment length for TLS/DTLS records.
+ *  It accepts and returns an integer with the length in bytes: 512, 1024,
+ *  2048 or 4096, or 0 for no limit (default). Clients request the limit
+ *  from the server during the handshake, so that smaller record buffers
+ *  can be used on both sides. Requires the maximum fragment length
+ *  extension in the mbedTLS configuration (MBEDTLS_SSL_MAX_FRAGMENT_LENGTH).
+ */
+#define TLS_MAX_FRAG_LEN 9
+/** Read-only socket option to read the memory used by a TLS/DTLS
+ *  connection. It returns a struct tls_memory_usage.
+ */
+#define TLS_MEMORY_USAGE 10
 
 /** @} */
 
+/** Memory used by a TLS/DTLS connection, read with the TLS_MEMORY_USAGE
+ *  socket option. All the sizes are in bytes and approximate the memory
+ *  allocated by mbedTLS, whose internal structures are not accounted for.
+ */
+struct tls_memory_usage {
+	/** TLS context, allocated statically. */
+	uint32_t context;
+
+	/** Content length of the input record buffer, allocated on the
+	 *  mbedTLS heap.
+	 */
+	uint32_t in_buf;
+
+	/** Content length of the output record buffer, allocated on the
+	 *  mbedTLS heap.
+	 */
+	uint32_t out_buf;
+
+	/** Session and peer certificate, allocated on the mbedTLS heap. */
+	uint32_t session;
+
+	/** mbedTLS configuration and certificates, shared with the other
+	 *  connections using the same credentials and options.
+	 */
+	uint32_t config;
+
+	/** Number of connections sharing the configuration. */
+	uint32_t config_users;
+};
+
 /* Valid values for TLS_PEER_VERIFY option */
 #define TLS_PEER_VERIFY_NONE 0     /**< Peer verification disabled. */
 #define TLS_PEER_VERIFY_OPTIONAL 1 /**< Peer verification optional. */
@@ -131,6 +233,10 @@ struct zsock_pollfd {
 #define TLS_DTLS_ROLE_CLIENT 0 /**< Client role in a DTLS session. */
 #define TLS_DTLS_ROLE_SERVER 1 /**< Server role in a DTLS session. */
 
+/* Valid values for TLS_SESSION_CACHE option */
+#define TLS_SESSION_CACHE_DISABLED 0 /**< Disable TLS session caching. */
+#define TLS_SESSION_CACHE_ENABLED 1 /**< Enable TLS session caching. */
+
 struct zsock_addrinfo {
 	struct zsock_addrinfo *ai_next;
 	int ai_flags;
@@ -367,6 +473,56 @@ __syscall ssize_t zsock_recvfrom(int sock, void *buf, size_t max_len,
 				 int flags, struct sockaddr *src_addr,
 				 socklen_t *addrlen);
 
+/**
+ * @brief Receive a message from an arbitrary network address
+ *
+ * @details
+ * @rst
+ * See `POSIX.1-2017 article
+ * <http://pubs.opengroup.org/onlinepubs/9699919799/functions/recvmsg.html>`__
+ * for normative description.
+ * This function is also exposed as ``recvmsg()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ *
+ * The control messages enabled with the IP_PKTINFO, IPV6_RECVPKTINFO and
+ * SO_TIMESTAMPING socket options are returned in msg_control.
+ */
+__syscall ssize_t zsock_recvmsg(int sock, struct msghdr *msg, int flags);
+
+/**
+ * @brief Send several messages with one call
+ *
+ * @details
+ * Same as calling zsock_sendmsg() for each of the @p vlen messages in
+ * @p msgvec, the number of bytes sent for each message is stored in its
+ * msg_len. This function is also exposed as ``sendmmsg()`` if
+ * :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ *
+ * @return Number of messages sent, or -1 with errno set if the first
+ * message could not be sent.
+ */
+__syscall int zsock_sendmmsg(int sock, struct mmsghdr *msgvec,
+			     unsigned int vlen, int flags);
+
+/**
+ * @brief Receive several messages with one call
+ *
+ * @details
+ * Same as calling zsock_recvmsg() for each of the @p vlen messages in
+ * @p msgvec, the number of bytes received for each message is stored in
+ * its msg_len. With ZSOCK_MSG_WAITFORONE, only the first message is waited
+ * for. Unlike Linux recvmmsg(), there is no timeout argument, use
+ * ZSOCK_MSG_DONTWAIT or ZSOCK_MSG_WAITFORONE instead. This function is also
+ * exposed as ``recvmmsg()`` if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is
+ * defined.
+ *
+ * @return Number of messages received, or -1 with errno set if no message
+ * could be received.
+ */
+__syscall int zsock_recvmmsg(int sock, struct mmsghdr *msgvec,
+			     unsigned int vlen, int flags);
+
 /**
  * @brief Receive data from a connected peer
  *
@@ -385,6 +541,61 @@ static inline ssize_t zsock_recv(int sock, void *buf, size_t max_len,
 	return zsock_recvfrom(sock, buf, max_len, flags, NULL, NULL);
 }
 
+/**
+ * @brief Receive data without copying it
+ *
+ * @details
+ * Same as zsock_recvfrom() but, instead of copying the data to an
+ * application buffer, gives the network buffers holding it to the
+ * application. For a datagram socket the whole datagram is returned, for a
+ * stream socket the data of one received segment. The application reads
+ * the data from the buffer fragments and releases them with
+ * net_buf_unref() when it is done, which should be soon as the buffers
+ * come from the network receive pool. ZSOCK_MSG_PEEK is not supported.
+ * Only available with :option:`CONFIG_NET_SOCKETS_ZEROCOPY`, for sockets
+ * of the native IP stack, and not available to user mode threads.
+ *
+ * @param sock Socket to receive from.
+ * @param frags Set to the first buffer fragment of the data on success.
+ * @param flags Socket flags, ZSOCK_MSG_DONTWAIT is supported.
+ * @param src_addr Set to the source address if not NULL.
+ * @param addrlen Length of src_addr, set to the actual length.
+ *
+ * @return Number of bytes received, 0 at end of stream, or -1 with errno
+ *         set on error.
+ */
+ssize_t zsock_recv_zerocopy(int sock, struct net_buf **frags, int flags,
+			    struct sockaddr *src_addr, socklen_t *addrlen);
+
+/**
+ * @brief Send data read from a file descriptor
+ *
+ * @details
+ * @rst
+ * See `Linux man page
+ * <https://man7.org/linux/man-pages/man2/sendfile.2.html>`__
+ * for normative description. ``in_fd`` is any file descriptor which can be
+ * read, typically a file opened with the POSIX file system API. If
+ * ``offset`` is not NULL, the data is read from ``*offset``, which is then
+ * advanced, and the file position of ``in_fd`` is not changed. For TCP
+ * sockets of the native IP stack the data is read into buffers which are
+ * sent without copying, other sockets get the data copied.
+ * This function is also exposed as ``sendfile()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * Only available with :option:`CONFIG_NET_SOCKETS_SENDFILE`, and not
+ * available to user mode threads.
+ * @endrst
+ *
+ * @param sock Socket to send to.
+ * @param in_fd File descriptor to read from.
+ * @param offset Offset to read from, or NULL to read from the file position.
+ * @param count Number of bytes to send.
+ *
+ * @return Number of bytes sent, which is less than count at end of file,
+ *         or -1 with errno set on error.
+ */
+ssize_t zsock_sendfile(int sock, int in_fd, off_t *offset, size_t count);
+
 /**
  * @brief Control blocking/non-blocking mode of a socket
  *
@@ -415,6 +626,58 @@ __syscall int zsock_fcntl(int sock, int cmd, int flags);
  */
 __syscall int zsock_poll(struct zsock_pollfd *fds, int nfds, int timeout);
 
+/**
+ * @brief Create an epoll instance
+ *
+ * @details
+ * @rst
+ * See `Linux man page
+ * <https://man7.org/linux/man-pages/man2/epoll_create.2.html>`__
+ * for normative description. Zephyr has no flags and ``flags`` must
+ * be 0.
+ * Readiness of the registered file descriptors is tracked as it changes,
+ * so the cost of a wait depends on the number of ready file descriptors
+ * only. Sockets, socketpairs and eventfds may be registered, TLS sockets
+ * may not.
+ * This function is also exposed as ``epoll_create1()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * Requires :option:`CONFIG_NET_SOCKETS_EPOLL`.
+ * @endrst
+ */
+__syscall int zsock_epoll_create(int flags);
+
+/**
+ * @brief Register, modify or unregister a file descriptor of an epoll instance
+ *
+ * @details
+ * @rst
+ * See `Linux man page
+ * <https://man7.org/linux/man-pages/man2/epoll_ctl.2.html>`__
+ * for normative description. Both level-triggered and edge-triggered
+ * (``ZSOCK_EPOLLET``) modes as well as ``ZSOCK_EPOLLONESHOT`` are
+ * supported.
+ * This function is also exposed as ``epoll_ctl()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ */
+__syscall int zsock_epoll_ctl(int epfd, int op, int fd,
+			      struct zsock_epoll_event *event);
+
+/**
+ * @brief Wait for events of an epoll instance
+ *
+ * @details
+ * @rst
+ * See `Linux man page
+ * <https://man7.org/linux/man-pages/man2/epoll_wait.2.html>`__
+ * for normative description.
+ * This function is also exposed as ``epoll_wait()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ */
+__syscall int zsock_epoll_wait(int epfd, struct zsock_epoll_event *events,
+			       int maxevents, int timeout);
+
 /**
  * @brief Get various socket options
  *
@@ -691,11 +954,62 @@ static inline ssize_t recvfrom(int sock, void *buf, size_t max_len, int flags,
 	return zsock_recvfrom(sock, buf, max_len, flags, src_addr, addrlen);
 }
 
+static inline ssize_t recvmsg(int sock, struct msghdr *msg, int flags)
+{
+	return zsock_recvmsg(sock, msg, flags);
+}
+
+static inline int sendmmsg(int sock, struct mmsghdr *msgvec,
+			   unsigned int vlen, int flags)
+{
+	return zsock_sendmmsg(sock, msgvec, vlen, flags);
+}
+
+static inline int recvmmsg(int sock, struct mmsghdr *msgvec,
+			   unsigned int vlen, int flags)
+{
+	return zsock_recvmmsg(sock, msgvec, vlen, flags);
+}
+
 static inline int poll(struct zsock_pollfd *fds, int nfds, int timeout)
 {
 	return zsock_poll(fds, nfds, timeout);
 }
 
+static inline ssize_t sendfile(int out_fd, int in_fd, off_t *offset,
+			       size_t count)
+{
+	return zsock_sendfile(out_fd, in_fd, offset, count);
+}
+
+#define epoll_event zsock_epoll_event
+#define epoll_data_t zsock_epoll_data_t
+
+/* The size is only a hint, as the instances grow as needed */
+static inline int epoll_create(int size)
+{
+	ARG_UNUSED(size);
+
+	return zsock_epoll_create(0);
+}
+
+static inline int epoll_create1(int flags)
+{
+	return zsock_epoll_create(flags);
+}
+
+static inline int epoll_ctl(int epfd, int op, int fd,
+			    struct zsock_epoll_event *event)
+{
+	return zsock_epoll_ctl(epfd, op, fd, event);
+}
+
+static inline int epoll_wait(int epfd, struct zsock_epoll_event *events,
+			     int maxevents, int timeout)
+{
+	return zsock_epoll_wait(epfd, events, maxevents, timeout);
+}
+
 static inline int getsockopt(int sock, int level, int optname,
 			     void *optval, socklen_t *optlen)
 {
@@ -763,8 +1077,23 @@ static inline char *inet_ntop(sa_family_t family, const void *src, char *dst,
 #define POLLHUP ZSOCK_POLLHUP
 #define POLLNVAL ZSOCK_POLLNVAL
 
+#define EPOLLIN ZSOCK_EPOLLIN
+#define EPOLLOUT ZSOCK_EPOLLOUT
+#define EPOLLERR ZSOCK_EPOLLERR
+#define EPOLLHUP ZSOCK_EPOLLHUP
+#define EPOLLONESHOT ZSOCK_EPOLLONESHOT
+#define EPOLLET ZSOCK_EPOLLET
+
+#define EPOLL_CTL_ADD ZSOCK_EPOLL_CTL_ADD
+#define EPOLL_CTL_DEL ZSOCK_EPOLL_CTL_DEL
+#define EPOLL_CTL_MOD ZSOCK_EPOLL_CTL_MOD
+
 #define MSG_PEEK ZSOCK_MSG_PEEK
 #define MSG_DONTWAIT ZSOCK_MSG_DONTWAIT
+#define MSG_ZEROCOPY ZSOCK_MSG_ZEROCOPY
+#define MSG_CTRUNC ZSOCK_MSG_CTRUNC
+#define MSG_TRUNC ZSOCK_MSG_TRUNC
+#define MSG_WAITFORONE ZSOCK_MSG_WAITFORONE
 
 #define SHUT_RD ZSOCK_SHUT_RD
 #define SHUT_WR ZSOCK_SHUT_WR
@@ -789,8 +1118,25 @@ static inline char *inet_ntop(sa_family_t family, const void *src, char *dst,
 /** sockopt: Async error (ignored, for compatibility) */
 #define SO_ERROR 4
 
-/** sockopt: Timestamp TX packets */
+/** sockopt: Timestamp TX packets, and RX packets with a control message
+ * (takes a bool for TX timestamps or an int of SOF_TIMESTAMPING_* flags)
+ */
 #define SO_TIMESTAMPING 37
+#define SCM_TIMESTAMPING SO_TIMESTAMPING
+
+/* SO_TIMESTAMPING flags, the packet timestamps come from the driver */
+/** SO_TIMESTAMPING: Timestamp TX packets */
+#define SOF_TIMESTAMPING_TX_HARDWARE BIT(0)
+/** SO_TIMESTAMPING: Return the timestamp of RX packets from recvmsg(), as
+ * a struct net_ptp_time in a SCM_TIMESTAMPING control message
+ */
+#define SOF_TIMESTAMPING_RX_HARDWARE BIT(2)
+
+/* Socket options for IPPROTO_IP level */
+/** sockopt: Return the destination address and interface of received
+ * IPv4 packets from recvmsg()
+ */
+#define IP_PKTINFO 8
 
 /* Socket options for IPPROTO_TCP level */
 /** sockopt: Disable TCP buffering (ignored, for compatibility) */
@@ -800,6 +1146,13 @@ static inline char *inet_ntop(sa_family_t family, const void *src, char *dst,
 /** sockopt: Don't support IPv4 access (ignored, for compatibility) */
 #define IPV6_V6ONLY 26
 
+/** sockopt: Return the destination address and interface of received
+ * IPv6 packets from recvmsg()
+ */
+#define IPV6_RECVPKTINFO 49
+/** Control message type of the IPV6_RECVPKTINFO data */
+#define IPV6_PKTINFO 50
+
 /** sockopt: Socket priority */
 #define SO_PRIORITY 12
 
@@ -807,6 +1160,11 @@ static inline char *inet_ntop(sa_family_t family, const void *src, char *dst,
 #define SO_TXTIME 61
 #define SCM_TXTIME SO_TXTIME
 
+/** sockopt: Number of MSG_ZEROCOPY sends whose buffer can be reused
+ * (Zephyr specific, read only)
+ */
+#define SO_ZEROCOPY_DONE 1000
+
 /* Socket options for SOCKS5 proxy */
 /** sockopt: Enable SOCKS5 for Socket */
 #define SO_SOCKS5 60
@@ -151,11 +151,38 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		       enum websocket_opcode opcode, bool mask, bool final,
 		       int32_t timeout);
 
+/**
+ * @brief Send websocket msg whose payload is gathered from several buffers.
+ *
+ * @details The buffers are sent as the payload of one websocket frame,
+ * after a websocket header added automatically. Unmasked buffers are
+ * given to the socket as they are, without being copied. Masked buffers
+ * are masked while being copied to a small buffer in the stack, whose
+ * size is set with CONFIG_WEBSOCKET_MASK_BUF_SIZE, so the buffers are
+ * not modified.
+ *
+ * @param ws_sock Websocket id returned by websocket_connect().
+ * @param iov Buffers holding the websocket data to send.
+ * @param iovlen Number of buffers.
+ * @param opcode Operation code (text, binary, ping, pong, close)
+ * @param mask Mask the data, see RFC 6455 for details
+ * @param final Is this final message for this message send, see
+ *        websocket_send_msg() for details.
+ * @param timeout How long to try to send the message. The value is in
+ *        milliseconds. Value SYS_FOREVER_MS means to wait forever.
+ *
+ * @return <0 if error, >=0 amount of bytes sent
+ */
+int websocket_send_msg_iov(int ws_sock, const struct iovec *iov,
+			   size_t iovlen, enum websocket_opcode opcode,
+			   bool mask, bool final, int32_t timeout);
+
 /**
  * @brief Receive websocket msg from peer.
  *
  * @details The function will automatically remove websocket header from the
- * message.
+ * message. When no data of the message is already buffered, the data is
+ * received directly to the given buffer and unmasked there.
  *
  * @param ws_sock Websocket id returned by websocket_connect().
  * @param buf Buffer where websocket data is read.
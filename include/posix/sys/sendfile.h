@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef ZEPHYR_INCLUDE_POSIX_SYS_SENDFILE_H_
+#define ZEPHYR_INCLUDE_POSIX_SYS_SENDFILE_H_
+
+#include <net/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline ssize_t sendfile(int out_fd, int in_fd, off_t *offset,
+			       size_t count)
+{
+	return zsock_sendfile(out_fd, in_fd, offset, count);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* ZEPHYR_INCLUDE_POSIX_SYS_SENDFILE_H_ */
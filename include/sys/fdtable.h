@@ -8,6 +8,7 @@
 
 #include <stdarg.h>
 #include <sys/types.h>
+#include <sys/dlist.h>
 /* FIXME: For native_posix ssize_t, off_t. */
 #include <fs/fs.h>
 
@@ -126,6 +127,78 @@ static inline int z_fdtable_call_ioctl(const struct fd_op_vtable *vtable, void *
 	return res;
 }
 
+/**
+ * @brief Readiness notifier of an I/O object.
+ *
+ * A notifier is attached to an object with the ZFD_IOCTL_POLL_NOTIFY
+ * request. The object then calls it with z_fd_notify() whenever some of
+ * the ZSOCK_POLL* events may have become ready, which lets epoll track
+ * readiness without polling every object it watches. The callback is
+ * called with a spinlock held and must not block.
+ */
+struct zfd_notifier {
+	sys_dnode_t node;
+	void (*cb)(struct zfd_notifier *notifier, uint32_t events);
+};
+
+/** Event passed to the notifiers of an object being closed */
+#define ZFD_NOTIFY_CLOSE BIT(31)
+
+/**
+ * @brief Attach a readiness notifier to the notifier list of an object.
+ *
+ * @param notifiers Notifier list of the object
+ * @param notifier Notifier to attach
+ */
+void z_fd_notifier_attach(sys_dlist_t *notifiers,
+			  struct zfd_notifier *notifier);
+
+/**
+ * @brief Detach a readiness notifier from its object.
+ *
+ * Once this function returns, the notifier callback is not running and
+ * will not be called anymore. Detaching a detached notifier does nothing.
+ *
+ * @param notifier Notifier to detach
+ */
+void z_fd_notifier_detach(struct zfd_notifier *notifier);
+
+/**
+ * @brief Call the readiness notifiers of an object.
+ *
+ * @param notifiers Notifier list of the object
+ * @param events ZSOCK_POLL* events which may have become ready
+ */
+void z_fd_notify(sys_dlist_t *notifiers, uint32_t events);
+
+/**
+ * @brief Read the readiness of the object a notifier is attached to.
+ *
+ * Calls the ZFD_IOCTL_POLL_READY request of the object, unless the
+ * notifier was detached because the object is being closed. The object
+ * cannot be closed until the request returns.
+ *
+ * @param notifier Notifier attached to the object
+ * @param vtable Vtable of the object
+ * @param obj Object
+ *
+ * @return ZSOCK_POLL* events which are ready, or -1 with errno set
+ */
+int z_fd_notifier_poll_ready(struct zfd_notifier *notifier,
+			     const struct fd_op_vtable *vtable, void *obj);
+
+/**
+ * @brief Detach all the readiness notifiers of an object being closed.
+ *
+ * Every notifier is called with ZFD_NOTIFY_CLOSE once it is detached.
+ * This waits for the z_fd_notifier_poll_ready() calls in progress, so it
+ * must not be called with a lock held which the ZFD_IOCTL_POLL_READY
+ * request of the object takes.
+ *
+ * @param notifiers Notifier list of the object
+ */
+void z_fd_notify_close(sys_dlist_t *notifiers);
+
 /**
  * Request codes for fd_op_vtable.ioctl().
  *
@@ -141,6 +214,10 @@ enum {
 	ZFD_IOCTL_POLL_PREPARE,
 	ZFD_IOCTL_POLL_UPDATE,
 	ZFD_IOCTL_POLL_OFFLOAD,
+	/* Return the ZSOCK_POLL* events which are ready. */
+	ZFD_IOCTL_POLL_READY,
+	/* Attach the struct zfd_notifier argument to the object. */
+	ZFD_IOCTL_POLL_NOTIFY,
 };
 
 #ifdef __cplusplus
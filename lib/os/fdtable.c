@@ -56,6 +56,14 @@ static struct fd_entry fdtable[CONFIG_POSIX_MAX_FDS] = {
 
 static K_MUTEX_DEFINE(fdtable_lock);
 
+/* Protects the notifier lists of all the objects */
+static struct k_spinlock notifier_lock;
+
+/* Held while the readiness of a watched object is read, so that the
+ * object is not closed meanwhile.
+ */
+static K_MUTEX_DEFINE(notifier_ready_lock);
+
 static int z_fd_ref(int fd)
 {
 	return atomic_inc(&fdtable[fd].refcount) + 1;
@@ -192,6 +200,94 @@ int z_alloc_fd(void *obj, const struct fd_op_vtable *vtable)
 	return fd;
 }
 
+void z_fd_notifier_attach(sys_dlist_t *notifiers,
+			  struct zfd_notifier *notifier)
+{
+	k_spinlock_key_t key = k_spin_lock(&notifier_lock);
+
+	sys_dlist_append(notifiers, &notifier->node);
+
+	k_spin_unlock(&notifier_lock, key);
+}
+
+void z_fd_notifier_detach(struct zfd_notifier *notifier)
+{
+	k_spinlock_key_t key = k_spin_lock(&notifier_lock);
+
+	if (sys_dnode_is_linked(&notifier->node)) {
+		sys_dlist_remove(&notifier->node);
+	}
+
+	k_spin_unlock(&notifier_lock, key);
+}
+
+void z_fd_notify(sys_dlist_t *notifiers, uint32_t events)
+{
+	struct zfd_notifier *notifier;
+	k_spinlock_key_t key;
+
+	/* Most objects are not watched, a notifier attached concurrently
+	 * checks the readiness of the object itself after attaching.
+	 */
+	if (sys_dlist_is_empty(notifiers)) {
+		return;
+	}
+
+	key = k_spin_lock(&notifier_lock);
+
+	SYS_DLIST_FOR_EACH_CONTAINER(notifiers, notifier, node) {
+		notifier->cb(notifier, events);
+	}
+
+	k_spin_unlock(&notifier_lock, key);
+}
+
+int z_fd_notifier_poll_ready(struct zfd_notifier *notifier,
+			     const struct fd_op_vtable *vtable, void *obj)
+{
+	k_spinlock_key_t key;
+	bool attached;
+	int ret;
+
+	(void)k_mutex_lock(&notifier_ready_lock, K_FOREVER);
+
+	key = k_spin_lock(&notifier_lock);
+	attached = sys_dnode_is_linked(&notifier->node);
+	k_spin_unlock(&notifier_lock, key);
+
+	if (attached) {
+		ret = z_fdtable_call_ioctl(vtable, obj, ZFD_IOCTL_POLL_READY);
+	} else {
+		errno = EBADF;
+		ret = -1;
+	}
+
+	k_mutex_unlock(&notifier_ready_lock);
+
+	return ret;
+}
+
+void z_fd_notify_close(sys_dlist_t *notifiers)
+{
+	struct zfd_notifier *notifier;
+	k_spinlock_key_t key;
+	sys_dnode_t *node;
+
+	/* Wait for the readiness reads in progress */
+	(void)k_mutex_lock(&notifier_ready_lock, K_FOREVER);
+
+	key = k_spin_lock(&notifier_lock);
+
+	while ((node = sys_dlist_get(notifiers)) != NULL) {
+		notifier = CONTAINER_OF(node, struct zfd_notifier, node);
+		notifier->cb(notifier, ZFD_NOTIFY_CLOSE);
+	}
+
+	k_spin_unlock(&notifier_lock, key);
+
+	k_mutex_unlock(&notifier_ready_lock);
+}
+
 #ifdef CONFIG_POSIX_API
 
 ssize_t read(int fd, void *buf, size_t sz)
@@ -8,7 +8,6 @@
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
-#include <sys/printk.h>
 #include <sys/util.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -24,11 +23,8 @@ struct token {
 };
 
 struct lexer {
-	void *(*state)(struct lexer *lexer);
-	char *start;
 	char *pos;
 	char *end;
-	struct token token;
 };
 
 struct json_obj {
@@ -41,248 +37,185 @@ struct json_obj_key_value {
 	struct token value;
 };
 
-static bool lexer_consume(struct lexer *lexer, struct token *token,
-			  enum json_tokens empty_token)
+static inline bool is_space(char chr)
 {
-	if (lexer->token.type == empty_token) {
-		return false;
-	}
-
-	*token = lexer->token;
-	lexer->token.type = empty_token;
-
-	return true;
+	return chr == ' ' || chr == '\t' || chr == '\n' || chr == '\r' ||
+	       chr == '\v' || chr == '\f';
 }
 
-static bool lexer_next(struct lexer *lexer, struct token *token)
+static inline bool is_digit(char chr)
 {
-	while (lexer->state) {
-		if (lexer_consume(lexer, token, JSON_TOK_NONE)) {
-			return true;
-		}
-
-		lexer->state = lexer->state(lexer);
-	}
-
-	return lexer_consume(lexer, token, JSON_TOK_EOF);
+	return (unsigned char)(chr - '0') < 10;
 }
 
-static void *lexer_json(struct lexer *lexer);
-
-static void emit(struct lexer *lexer, enum json_tokens token)
+/* Characters a number token is made of, checked when decoded */
+static inline bool is_number(char chr)
 {
-	lexer->token.type = token;
-	lexer->token.start = lexer->start;
-	lexer->token.end = lexer->pos;
-	lexer->start = lexer->pos;
+	return is_digit(chr) || chr == '.' || chr == '-' || chr == '+' ||
+	       chr == 'e' || chr == 'E';
 }
 
-static int next(struct lexer *lexer)
+/* Valid characters after a backslash, but for \uXXXX */
+static inline bool is_escape(char chr)
 {
-	if (lexer->pos >= lexer->end) {
-		lexer->pos = lexer->end + 1;
-
-		return '\0';
+	switch (chr) {
+	case '"':
+	case '\\':
+	case '/':
+	case 'b':
+	case 'f':
+	case 'n':
+	case 'r':
+	case 't':
+		return true;
+	default:
+		return false;
 	}
-
-	return *lexer->pos++;
-}
-
-static void ignore(struct lexer *lexer)
-{
-	lexer->start = lexer->pos;
-}
-
-static void backup(struct lexer *lexer)
-{
-	lexer->pos--;
-}
-
-static int peek(struct lexer *lexer)
-{
-	int chr = next(lexer);
-
-	backup(lexer);
-
-	return chr;
 }
 
-static void *lexer_string(struct lexer *lexer)
+/* Position of the closing quote of the string starting at pos */
+static char *lexer_string(char *pos, char *end)
 {
-	ignore(lexer);
-
-	while (true) {
-		int chr = next(lexer);
+	int i;
 
-		if (chr == '\0') {
-			emit(lexer, JSON_TOK_ERROR);
+	while (pos < end) {
+		switch (*pos) {
+		case '"':
+			return pos;
+		case '\0':
 			return NULL;
-		}
-
-		if (chr == '\\') {
-			switch (next(lexer)) {
-			case '"':
-			case '\\':
-			case '/':
-			case 'b':
-			case 'f':
-			case 'n':
-			case 'r':
-			case 't':
-				continue;
-			case 'u':
-				if (!isxdigit(next(lexer))) {
-					goto error;
-				}
-
-				if (!isxdigit(next(lexer))) {
-					goto error;
-				}
-
-				if (!isxdigit(next(lexer))) {
-					goto error;
-				}
+		case '\\':
+			if (++pos >= end) {
+				return NULL;
+			}
 
-				if (!isxdigit(next(lexer))) {
-					goto error;
+			if (*pos != 'u') {
+				if (!is_escape(*pos)) {
+					return NULL;
 				}
 
 				break;
-			default:
-				goto error;
 			}
-		}
 
-		if (chr == '"') {
-			backup(lexer);
-			emit(lexer, JSON_TOK_STRING);
+			if (end - pos <= 4) {
+				return NULL;
+			}
 
-			next(lexer);
-			ignore(lexer);
+			for (i = 1; i <= 4; i++) {
+				if (!isxdigit((unsigned char)pos[i])) {
+					return NULL;
+				}
+			}
 
-			return lexer_json;
+			pos += 4;
+			break;
 		}
+
+		pos++;
 	}
 
-error:
-	emit(lexer, JSON_TOK_ERROR);
 	return NULL;
 }
 
-static int accept_run(struct lexer *lexer, const char *run)
+static char *lexer_literal(char *pos, char *end, const char *literal,
+			   size_t len)
 {
-	for (; *run; run++) {
-		if (next(lexer) != *run) {
-			return -EINVAL;
-		}
+	if ((size_t)(end - pos) < len || memcmp(pos, literal, len)) {
+		return NULL;
 	}
 
-	return 0;
+	return pos + len;
 }
 
-static void *lexer_boolean(struct lexer *lexer)
+static void lexer_next(struct lexer *lexer, struct token *token)
 {
-	backup(lexer);
+	char *pos = lexer->pos;
+	char *end = lexer->end;
 
-	switch (next(lexer)) {
-	case 't':
-		if (!accept_run(lexer, "rue")) {
-			emit(lexer, JSON_TOK_TRUE);
-			return lexer_json;
-		}
-		break;
-	case 'f':
-		if (!accept_run(lexer, "alse")) {
-			emit(lexer, JSON_TOK_FALSE);
-			return lexer_json;
-		}
-		break;
+	while (pos < end && is_space(*pos)) {
+		pos++;
 	}
 
-	emit(lexer, JSON_TOK_ERROR);
-	return NULL;
-}
+	token->start = pos;
 
-static void *lexer_null(struct lexer *lexer)
-{
-	if (accept_run(lexer, "ull") < 0) {
-		emit(lexer, JSON_TOK_ERROR);
-		return NULL;
+	if (pos >= end) {
+		token->type = JSON_TOK_EOF;
+		token->end = pos;
+		lexer->pos = pos;
+		return;
 	}
 
-	emit(lexer, JSON_TOK_NULL);
-	return lexer_json;
-}
+	switch (*pos) {
+	case '\0':
+		token->type = JSON_TOK_EOF;
+		break;
+	case '}':
+	case '{':
+	case '[':
+	case ']':
+	case ',':
+	case ':':
+		token->type = (enum json_tokens)*pos++;
+		break;
+	case '"':
+		token->start = ++pos;
+		pos = lexer_string(pos, end);
+		if (!pos) {
+			goto error;
+		}
 
-static void *lexer_number(struct lexer *lexer)
-{
-	while (true) {
-		int chr = next(lexer);
+		token->type = JSON_TOK_STRING;
+		token->end = pos++;
+		lexer->pos = pos;
+		return;
+	case 't':
+		pos = lexer_literal(pos, end, "true", 4);
+		token->type = JSON_TOK_TRUE;
+		break;
+	case 'f':
+		pos = lexer_literal(pos, end, "false", 5);
+		token->type = JSON_TOK_FALSE;
+		break;
+	case 'n':
+		pos = lexer_literal(pos, end, "null", 4);
+		token->type = JSON_TOK_NULL;
+		break;
+	case '-':
+		if (++pos >= end) {
+			goto error;
+		}
 
-		if (isdigit(chr) || chr == '.') {
-			continue;
+		__fallthrough;
+	default:
+		if (!is_digit(*pos)) {
+			goto error;
 		}
 
-		backup(lexer);
-		emit(lexer, JSON_TOK_NUMBER);
+		for (pos++; pos < end && is_number(*pos); pos++) {
+		}
 
-		return lexer_json;
+		token->type = JSON_TOK_NUMBER;
+		break;
 	}
-}
-
-static void *lexer_json(struct lexer *lexer)
-{
-	while (true) {
-		int chr = next(lexer);
-
-		switch (chr) {
-		case '\0':
-			emit(lexer, JSON_TOK_EOF);
-			return NULL;
-		case '}':
-		case '{':
-		case '[':
-		case ']':
-		case ',':
-		case ':':
-			emit(lexer, (enum json_tokens)chr);
-			return lexer_json;
-		case '"':
-			return lexer_string;
-		case 'n':
-			return lexer_null;
-		case 't':
-		case 'f':
-			return lexer_boolean;
-		case '-':
-			if (isdigit(peek(lexer))) {
-				return lexer_number;
-			}
 
-			__fallthrough;
-		default:
-			if (isspace(chr)) {
-				ignore(lexer);
-				continue;
-			}
+	if (!pos) {
+		goto error;
+	}
 
-			if (isdigit(chr)) {
-				return lexer_number;
-			}
+	token->end = pos;
+	lexer->pos = pos;
+	return;
 
-			emit(lexer, JSON_TOK_ERROR);
-			return NULL;
-		}
-	}
+error:
+	token->type = JSON_TOK_ERROR;
+	token->end = token->start;
+	lexer->pos = end;
 }
 
 static void lexer_init(struct lexer *lexer, char *data, size_t len)
 {
-	lexer->state = lexer_json;
-	lexer->start = data;
 	lexer->pos = data;
 	lexer->end = data + len;
-	lexer->token.type = JSON_TOK_NONE;
 }
 
 static int obj_init(struct json_obj *json, char *data, size_t len)
@@ -290,10 +223,7 @@ static int obj_init(struct json_obj *json, char *data, size_t len)
 	struct token token;
 
 	lexer_init(&json->lexer, data, len);
-
-	if (!lexer_next(&json->lexer, &token)) {
-		return -EINVAL;
-	}
+	lexer_next(&json->lexer, &token);
 
 	if (token.type != JSON_TOK_OBJECT_START) {
 		return -EINVAL;
@@ -311,6 +241,7 @@ static int element_token(enum json_tokens token)
 	case JSON_TOK_NUMBER:
 	case JSON_TOK_TRUE:
 	case JSON_TOK_FALSE:
+	case JSON_TOK_NULL:
 		return 0;
 	default:
 		return -EINVAL;
@@ -322,9 +253,7 @@ static int obj_next(struct json_obj *json,
 {
 	struct token token;
 
-	if (!lexer_next(&json->lexer, &token)) {
-		return -EINVAL;
-	}
+	lexer_next(&json->lexer, &token);
 
 	/* Match end of object or next key */
 	switch (token.type) {
@@ -335,10 +264,7 @@ static int obj_next(struct json_obj *json,
 
 		return 0;
 	case JSON_TOK_COMMA:
-		if (!lexer_next(&json->lexer, &token)) {
-			return -EINVAL;
-		}
-
+		lexer_next(&json->lexer, &token);
 		if (token.type != JSON_TOK_STRING) {
 			return -EINVAL;
 		}
@@ -353,66 +279,194 @@ static int obj_next(struct json_obj *json,
 	}
 
 	/* Match : after key */
-	if (!lexer_next(&json->lexer, &token)) {
-		return -EINVAL;
-	}
-
+	lexer_next(&json->lexer, &token);
 	if (token.type != JSON_TOK_COLON) {
 		return -EINVAL;
 	}
 
 	/* Match value */
-	if (!lexer_next(&json->lexer, &kv->value)) {
-		return -EINVAL;
-	}
+	lexer_next(&json->lexer, &kv->value);
 
 	return element_token(kv->value.type);
 }
 
 static int arr_next(struct json_obj *json, struct token *value)
 {
-	if (!lexer_next(&json->lexer, value)) {
-		return -EINVAL;
-	}
+	lexer_next(&json->lexer, value);
 
 	if (value->type == JSON_TOK_LIST_END) {
 		return 0;
 	}
 
 	if (value->type == JSON_TOK_COMMA) {
-		if (!lexer_next(&json->lexer, value)) {
+		lexer_next(&json->lexer, value);
+	}
+
+	return element_token(value->type);
+}
+
+/* Skip the value starting with token, with all the values it holds */
+static int skip_value(struct json_obj *json, const struct token *value)
+{
+	struct token token;
+	size_t depth;
+
+	if (value->type != JSON_TOK_OBJECT_START &&
+	    value->type != JSON_TOK_LIST_START) {
+		return 0;
+	}
+
+	for (depth = 1; depth > 0; ) {
+		lexer_next(&json->lexer, &token);
+
+		switch (token.type) {
+		case JSON_TOK_OBJECT_START:
+		case JSON_TOK_LIST_START:
+			depth++;
+			break;
+		case JSON_TOK_OBJECT_END:
+		case JSON_TOK_LIST_END:
+			depth--;
+			break;
+		case JSON_TOK_ERROR:
+		case JSON_TOK_EOF:
+			return -EINVAL;
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static int decode_int64(const char *start, const char *end, int64_t *num)
+{
+	bool negative = start < end && *start == '-';
+	uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : INT64_MAX;
+	uint64_t value = 0U;
+	const char *pos;
+
+	pos = start + negative;
+	if (pos == end) {
+		return -EINVAL;
+	}
+
+	for (; pos < end; pos++) {
+		unsigned int digit = (unsigned char)*pos - '0';
+
+		if (digit > 9) {
 			return -EINVAL;
 		}
+
+		if (value > (limit - digit) / 10U) {
+			return -ERANGE;
+		}
+
+		value = value * 10U + digit;
 	}
 
-	return element_token(value->type);
+	*num = negative ? -(int64_t)(value - 1U) - 1 : (int64_t)value;
+
+	return 0;
 }
 
-static int decode_num(const struct token *token, int32_t *num)
+static int decode_int32(const char *start, const char *end, int32_t *num)
 {
-	/* FIXME: strtod() is not available in newlib/minimal libc,
-	 * so using strtol() here.
-	 */
-	char *endptr;
-	char prev_end;
+	int64_t value;
+	int ret;
+
+	ret = decode_int64(start, end, &value);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (value < INT32_MIN || value > INT32_MAX) {
+		return -ERANGE;
+	}
+
+	*num = (int32_t)value;
+
+	return 0;
+}
 
-	prev_end = *token->end;
-	*token->end = '\0';
+static const char *skip_digits(const char *pos, const char *end)
+{
+	while (pos < end && is_digit(*pos)) {
+		pos++;
+	}
 
-	errno = 0;
-	*num = strtol(token->start, &endptr, 10);
+	return pos;
+}
 
-	*token->end = prev_end;
+/* Check a number against the JSON grammar, without converting it */
+static int check_float(const char *start, const char *end)
+{
+	const char *pos = start;
 
-	if (errno != 0) {
-		return -errno;
+	if (pos < end && *pos == '-') {
+		pos++;
 	}
 
-	if (endptr != token->end) {
+	start = pos;
+	pos = skip_digits(pos, end);
+	if (pos == start) {
 		return -EINVAL;
 	}
 
-	return 0;
+	if (pos < end && *pos == '.') {
+		start = ++pos;
+		pos = skip_digits(pos, end);
+		if (pos == start) {
+			return -EINVAL;
+		}
+	}
+
+	if (pos < end && (*pos == 'e' || *pos == 'E')) {
+		pos++;
+		if (pos < end && (*pos == '+' || *pos == '-')) {
+			pos++;
+		}
+
+		start = pos;
+		pos = skip_digits(pos, end);
+		if (pos == start) {
+			return -EINVAL;
+		}
+	}
+
+	return pos == end ? 0 : -EINVAL;
+}
+
+/* Decode a number token for a JSON_TOK_NUMBER, JSON_TOK_INT64 or
+ * JSON_TOK_FLOAT descriptor.
+ */
+static int decode_num(const struct json_obj_descr *descr, char *start,
+		      char *end, void *field)
+{
+	/* Floats are given to the application as their checked text, see
+	 * struct json_obj_token, as strtod() is not available in all the
+	 * C libraries.
+	 */
+	switch (descr->type) {
+	case JSON_TOK_NUMBER:
+		return decode_int32(start, end, field);
+	case JSON_TOK_INT64:
+		return decode_int64(start, end, field);
+	case JSON_TOK_FLOAT: {
+		struct json_obj_token *num = field;
+
+		if (check_float(start, end) < 0) {
+			return -EINVAL;
+		}
+
+		num->start = start;
+		num->length = (size_t)(end - start);
+
+		return 0;
+	}
+	default:
+		return -EINVAL;
+	}
 }
 
 static bool equivalent_types(enum json_tokens type1, enum json_tokens type2)
@@ -421,9 +475,36 @@ static bool equivalent_types(enum json_tokens type1, enum json_tokens type2)
 		return type2 == JSON_TOK_TRUE || type2 == JSON_TOK_FALSE;
 	}
 
+	if (type1 == JSON_TOK_NUMBER) {
+		return type2 == JSON_TOK_NUMBER || type2 == JSON_TOK_INT64 ||
+		       type2 == JSON_TOK_FLOAT;
+	}
+
 	return type1 == type2;
 }
 
+/* Index of the field named key, starting with the one at hint: fields
+ * are usually sent in the order of their descriptors.
+ */
+static int field_index(const struct json_obj_descr *descr, size_t descr_len,
+		       size_t hint, const char *key, size_t key_len)
+{
+	size_t i, n;
+
+	for (i = hint, n = 0; n < descr_len; n++, i++) {
+		if (i >= descr_len) {
+			i = 0;
+		}
+
+		if (descr[i].field_name_len == key_len &&
+		    !memcmp(descr[i].field_name, key, key_len)) {
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
 static int obj_parse(struct json_obj *obj,
 		     const struct json_obj_descr *descr, size_t descr_len,
 		     void *val);
@@ -456,11 +537,10 @@ static int decode_value(struct json_obj *obj,
 
 		return 0;
 	}
-	case JSON_TOK_NUMBER: {
-		int32_t *num = field;
-
-		return decode_num(value, num);
-	}
+	case JSON_TOK_NUMBER:
+	case JSON_TOK_INT64:
+	case JSON_TOK_FLOAT:
+		return decode_num(descr, value->start, value->end, field);
 	case JSON_TOK_STRING: {
 		char **str = field;
 
@@ -479,6 +559,10 @@ static ptrdiff_t get_elem_size(const struct json_obj_descr *descr)
 	switch (descr->type) {
 	case JSON_TOK_NUMBER:
 		return sizeof(int32_t);
+	case JSON_TOK_INT64:
+		return sizeof(int64_t);
+	case JSON_TOK_FLOAT:
+		return sizeof(struct json_obj_token);
 	case JSON_TOK_STRING:
 		return sizeof(char *);
 	case JSON_TOK_TRUE:
@@ -541,7 +625,8 @@ static int obj_parse(struct json_obj *obj, const struct json_obj_descr *descr,
 {
 	struct json_obj_key_value kv;
 	int32_t decoded_fields = 0;
-	size_t i;
+	size_t hint = 0;
+	int i;
 	int ret;
 
 	while (!obj_next(obj, &kv)) {
@@ -549,34 +634,27 @@ static int obj_parse(struct json_obj *obj, const struct json_obj_descr *descr,
 			return decoded_fields;
 		}
 
-		for (i = 0; i < descr_len; i++) {
-			void *decode_field = (char *)val + descr[i].offset;
+		i = field_index(descr, descr_len, hint, kv.key, kv.key_len);
 
-			/* Field has been decoded already, skip */
-			if (decoded_fields & (1 << i)) {
-				continue;
-			}
-
-			/* Check if it's the i-th field */
-			if (kv.key_len != descr[i].field_name_len) {
-				continue;
-			}
-
-			if (memcmp(kv.key, descr[i].field_name,
-				   descr[i].field_name_len)) {
-				continue;
-			}
-
-			/* Store the decoded value */
-			ret = decode_value(obj, &descr[i], &kv.value,
-					   decode_field, val);
+		/* Unknown field, or decoded already: skip */
+		if (i < 0 || (decoded_fields & (1 << i))) {
+			ret = skip_value(obj, &kv.value);
 			if (ret < 0) {
 				return ret;
 			}
 
-			decoded_fields |= 1<<i;
-			break;
+			continue;
 		}
+
+		/* Store the decoded value */
+		ret = decode_value(obj, &descr[i], &kv.value,
+				   (char *)val + descr[i].offset, val);
+		if (ret < 0) {
+			return ret;
+		}
+
+		decoded_fields |= 1 << i;
+		hint = i + 1;
 	}
 
 	return -EINVAL;
@@ -599,6 +677,587 @@ int json_obj_parse(char *payload, size_t len,
 	return obj_parse(&obj, descr, descr_len, val);
 }
 
+enum stream_state {
+	STREAM_START,		/* before the '{' of the object */
+	STREAM_VALUE,		/* before a value */
+	STREAM_OBJ_FIRST,	/* after '{', before a key or '}' */
+	STREAM_OBJ_KEY,		/* after ',', before a key */
+	STREAM_KEY,		/* in a key */
+	STREAM_COLON,		/* after a key */
+	STREAM_OBJ_NEXT,	/* after a field, before ',' or '}' */
+	STREAM_ARR_FIRST,	/* after '[', before a value or ']' */
+	STREAM_ARR_NEXT,	/* after an element, before ',' or ']' */
+	STREAM_STRING,		/* in a string value */
+	STREAM_NUMBER,		/* in a number */
+	STREAM_LITERAL,		/* in true, false or null */
+	STREAM_SKIP,		/* in an object or array that is not decoded */
+	STREAM_DONE,		/* after the '}' of the object */
+};
+
+/* stream->sub in strings: hex digits left in \uXXXX, or after '\' */
+#define STREAM_SUB_ESCAPE	5
+/* stream->sub while skipping: in a string, or after '\' in a string */
+#define STREAM_SUB_SKIP_STRING	1
+#define STREAM_SUB_SKIP_ESCAPE	2
+
+static struct json_obj_stream_frame *stream_top(struct json_obj_stream *stream)
+{
+	return &stream->stack[stream->depth - 1];
+}
+
+/* Whether the value being read is decoded, or skipped */
+static bool stream_decoded(struct json_obj_stream *stream)
+{
+	struct json_obj_stream_frame *frame = stream_top(stream);
+
+	return frame->array || frame->cur >= 0;
+}
+
+/* Descriptor of the value starting now, NULL if it is skipped */
+static const struct json_obj_descr *stream_target(
+	struct json_obj_stream *stream, void **field, void **val)
+{
+	struct json_obj_stream_frame *frame = stream_top(stream);
+	const struct json_obj_descr *descr;
+
+	if (frame->array) {
+		*field = frame->field;
+		*val = frame->val;
+		return frame->descr;
+	}
+
+	if (frame->cur < 0) {
+		return NULL;
+	}
+
+	descr = &frame->descr[frame->cur];
+	*field = (char *)frame->val + descr->offset;
+	*val = frame->val;
+
+	return descr;
+}
+
+static int stream_push(struct json_obj_stream *stream, bool array,
+		       const struct json_obj_descr *descr, size_t len,
+		       void *field, void *val)
+{
+	struct json_obj_stream_frame *frame;
+
+	if (stream->depth == JSON_OBJ_STREAM_MAX_DEPTH) {
+		return -ENOMEM;
+	}
+
+	frame = &stream->stack[stream->depth++];
+	frame->descr = descr;
+	frame->len = len;
+	frame->count = 0U;
+	frame->array = array;
+	frame->cur = -1;
+	frame->hint = 0U;
+
+	if (array) {
+		frame->elem_size = get_elem_size(descr);
+		frame->field = field;
+		frame->val = val;
+		*(size_t *)((char *)val + descr->offset) = 0;
+		stream->state = STREAM_ARR_FIRST;
+	} else {
+		frame->val = field;
+		stream->state = STREAM_OBJ_FIRST;
+	}
+
+	return 0;
+}
+
+static void stream_value_end(struct json_obj_stream *stream)
+{
+	struct json_obj_stream_frame *frame = stream_top(stream);
+
+	if (frame->array) {
+		frame->count++;
+		frame->field += frame->elem_size;
+		*(size_t *)((char *)frame->val + frame->descr->offset) =
+			frame->count;
+		stream->state = STREAM_ARR_NEXT;
+		return;
+	}
+
+	if (frame->cur >= 0) {
+		frame->count |= 1U << frame->cur;
+		frame->hint = frame->cur + 1;
+	}
+
+	stream->state = STREAM_OBJ_NEXT;
+}
+
+static void stream_pop(struct json_obj_stream *stream)
+{
+	struct json_obj_stream_frame *frame = &stream->stack[--stream->depth];
+
+	if (!stream->depth) {
+		stream->result = (int)frame->count;
+		stream->state = STREAM_DONE;
+		return;
+	}
+
+	stream_value_end(stream);
+}
+
+/* Bytes of the token being read are kept after the used part of the buffer */
+static int stream_token_append(struct json_obj_stream *stream,
+			       const char *data, size_t len)
+{
+	/* with room for the terminating NUL */
+	if (stream->buf_size - stream->buf_used - stream->tok_len <= len) {
+		return -ENOMEM;
+	}
+
+	memcpy(stream->buf + stream->buf_used + stream->tok_len, data, len);
+	stream->tok_len += len;
+
+	return 0;
+}
+
+/* Token read, kept in the buffer with a terminating NUL if keep is set */
+static char *stream_token_end(struct json_obj_stream *stream, bool keep)
+{
+	char *token = stream->buf + stream->buf_used;
+
+	if (keep) {
+		if (stream->buf_size - stream->buf_used <= stream->tok_len) {
+			return NULL;
+		}
+
+		token[stream->tok_len] = '\0';
+		stream->buf_used += stream->tok_len + 1;
+	}
+
+	stream->tok_len = 0;
+
+	return token;
+}
+
+static int stream_value_start(struct json_obj_stream *stream, char chr)
+{
+	struct json_obj_stream_frame *frame = stream_top(stream);
+	const struct json_obj_descr *descr;
+	void *field, *val;
+
+	if (frame->array && frame->count == frame->len) {
+		return -ENOSPC;
+	}
+
+	descr = stream_target(stream, &field, &val);
+
+	switch (chr) {
+	case '{':
+		if (!descr) {
+			break;
+		}
+
+		if (descr->type != JSON_TOK_OBJECT_START) {
+			return -EINVAL;
+		}
+
+		return stream_push(stream, false, descr->object.sub_descr,
+				   descr->object.sub_descr_len, field, val);
+	case '[':
+		if (!descr) {
+			break;
+		}
+
+		if (descr->type != JSON_TOK_LIST_START) {
+			return -EINVAL;
+		}
+
+		return stream_push(stream, true, descr->array.element_descr,
+				   descr->array.n_elements, field, val);
+	case '"':
+		if (descr && descr->type != JSON_TOK_STRING) {
+			return -EINVAL;
+		}
+
+		stream->sub = 0U;
+		stream->state = STREAM_STRING;
+		return 0;
+	case 't':
+	case 'f':
+	case 'n':
+		if (descr && (chr == 'n' ||
+			      !equivalent_types(JSON_TOK_TRUE, descr->type))) {
+			return -EINVAL;
+		}
+
+		stream->literal = chr == 't' ? "true" :
+				  chr == 'f' ? "false" : "null";
+		stream->sub = 1U;
+		stream->state = STREAM_LITERAL;
+		return 0;
+	default:
+		if (!is_digit(chr) && chr != '-') {
+			return -EINVAL;
+		}
+
+		if (descr && !equivalent_types(JSON_TOK_NUMBER, descr->type)) {
+			return -EINVAL;
+		}
+
+		stream->state = STREAM_NUMBER;
+		return descr ? stream_token_append(stream, &chr, 1) : 0;
+	}
+
+	/* object or array skipped with all it holds */
+	stream->skip = 1U;
+	stream->sub = 0U;
+	stream->state = STREAM_SKIP;
+
+	return 0;
+}
+
+/* Read the string from data to its closing quote, or to end */
+static int stream_string(struct json_obj_stream *stream, const char *data,
+			 const char *end, bool keep)
+{
+	const char *pos;
+	int ret;
+
+	for (pos = data; pos < end; pos++) {
+		if (stream->sub == 0U) {
+			if (*pos == '"') {
+				break;
+			}
+
+			if (*pos == '\\') {
+				stream->sub = STREAM_SUB_ESCAPE;
+			} else if (*pos == '\0') {
+				return -EINVAL;
+			}
+		} else if (stream->sub == STREAM_SUB_ESCAPE) {
+			if (*pos == 'u') {
+				stream->sub = 4U;
+			} else if (is_escape(*pos)) {
+				stream->sub = 0U;
+			} else {
+				return -EINVAL;
+			}
+		} else if (isxdigit((unsigned char)*pos)) {
+			stream->sub--;
+		} else {
+			return -EINVAL;
+		}
+	}
+
+	if (keep && pos > data) {
+		ret = stream_token_append(stream, data, pos - data);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return pos - data;
+}
+
+static void stream_key_end(struct json_obj_stream *stream)
+{
+	struct json_obj_stream_frame *frame = stream_top(stream);
+	size_t len = stream->tok_len;
+	char *key = stream_token_end(stream, false);
+	int i;
+
+	i = field_index(frame->descr, frame->len, frame->hint, key, len);
+
+	/* Unknown field, or decoded already: skip */
+	if (i >= 0 && (frame->count & (1U << i))) {
+		i = -1;
+	}
+
+	frame->cur = i;
+	stream->state = STREAM_COLON;
+}
+
+static int stream_string_end(struct json_obj_stream *stream)
+{
+	const struct json_obj_descr *descr;
+	void *field, *val;
+	char *str;
+
+	descr = stream_target(stream, &field, &val);
+	if (descr) {
+		str = stream_token_end(stream, true);
+		if (!str) {
+			return -ENOMEM;
+		}
+
+		*(char **)field = str;
+	}
+
+	stream_value_end(stream);
+
+	return 0;
+}
+
+static int stream_number_end(struct json_obj_stream *stream)
+{
+	const struct json_obj_descr *descr;
+	void *field, *val;
+	size_t len = stream->tok_len;
+	char *start;
+	int ret;
+
+	descr = stream_target(stream, &field, &val);
+	if (descr) {
+		start = stream_token_end(stream,
+					 descr->type == JSON_TOK_FLOAT);
+		if (!start) {
+			return -ENOMEM;
+		}
+
+		ret = decode_num(descr, start, start + len, field);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	stream_value_end(stream);
+
+	return 0;
+}
+
+static int stream_literal(struct json_obj_stream *stream, char chr)
+{
+	const struct json_obj_descr *descr;
+	void *field, *val;
+
+	if (chr != stream->literal[stream->sub]) {
+		return -EINVAL;
+	}
+
+	if (stream->literal[++stream->sub] != '\0') {
+		return 0;
+	}
+
+	descr = stream_target(stream, &field, &val);
+	if (descr) {
+		*(bool *)field = stream->literal[0] == 't';
+	}
+
+	stream_value_end(stream);
+
+	return 0;
+}
+
+static void stream_skip(struct json_obj_stream *stream, char chr)
+{
+	switch (stream->sub) {
+	case STREAM_SUB_SKIP_STRING:
+		if (chr == '\\') {
+			stream->sub = STREAM_SUB_SKIP_ESCAPE;
+		} else if (chr == '"') {
+			stream->sub = 0U;
+		}
+
+		return;
+	case STREAM_SUB_SKIP_ESCAPE:
+		stream->sub = STREAM_SUB_SKIP_STRING;
+		return;
+	}
+
+	switch (chr) {
+	case '"':
+		stream->sub = STREAM_SUB_SKIP_STRING;
+		break;
+	case '{':
+	case '[':
+		stream->skip++;
+		break;
+	case '}':
+	case ']':
+		if (!--stream->skip) {
+			stream_value_end(stream);
+		}
+
+		break;
+	}
+}
+
+/* Bytes of data consumed, 0 if the first one has to be read again in the
+ * new state, or error.
+ */
+static int stream_step(struct json_obj_stream *stream, const char *data,
+		       const char *end)
+{
+	char chr = *data;
+	int ret;
+
+	switch (stream->state) {
+	case STREAM_STRING:
+	case STREAM_KEY:
+		ret = stream_string(stream, data, end,
+				    stream->state == STREAM_KEY ||
+				    stream_decoded(stream));
+		if (ret < 0 || &data[ret] == end) {
+			return ret;
+		}
+
+		/* closing quote */
+		if (stream->state == STREAM_KEY) {
+			stream_key_end(stream);
+			return ret + 1;
+		}
+
+		if (stream_string_end(stream) < 0) {
+			return -ENOMEM;
+		}
+
+		return ret + 1;
+	case STREAM_NUMBER:
+		if (is_number(chr)) {
+			if (!stream_decoded(stream)) {
+				return 1;
+			}
+
+			ret = stream_token_append(stream, &chr, 1);
+			return ret < 0 ? ret : 1;
+		}
+
+		ret = stream_number_end(stream);
+		return ret < 0 ? ret : 0;
+	case STREAM_LITERAL:
+		ret = stream_literal(stream, chr);
+		return ret < 0 ? ret : 1;
+	case STREAM_SKIP:
+		stream_skip(stream, chr);
+		return 1;
+	default:
+		break;
+	}
+
+	if (is_space(chr)) {
+		return 1;
+	}
+
+	switch (stream->state) {
+	case STREAM_START:
+		if (chr != '{') {
+			return -EINVAL;
+		}
+
+		ret = stream_push(stream, false, stream->descr,
+				  stream->descr_len, stream->val, NULL);
+		break;
+	case STREAM_VALUE:
+		ret = stream_value_start(stream, chr);
+		break;
+	case STREAM_OBJ_FIRST:
+		if (chr == '}') {
+			stream_pop(stream);
+			return 1;
+		}
+
+		__fallthrough;
+	case STREAM_OBJ_KEY:
+		if (chr != '"') {
+			return -EINVAL;
+		}
+
+		stream->sub = 0U;
+		stream->state = STREAM_KEY;
+		return 1;
+	case STREAM_COLON:
+		if (chr != ':') {
+			return -EINVAL;
+		}
+
+		stream->state = STREAM_VALUE;
+		return 1;
+	case STREAM_OBJ_NEXT:
+		if (chr == ',') {
+			stream->state = STREAM_OBJ_KEY;
+			return 1;
+		}
+
+		if (chr != '}') {
+			return -EINVAL;
+		}
+
+		stream_pop(stream);
+		return 1;
+	case STREAM_ARR_FIRST:
+		if (chr != ']') {
+			ret = stream_value_start(stream, chr);
+			break;
+		}
+
+		stream_pop(stream);
+		return 1;
+	case STREAM_ARR_NEXT:
+		if (chr == ',') {
+			stream->state = STREAM_VALUE;
+			return 1;
+		}
+
+		if (chr != ']') {
+			return -EINVAL;
+		}
+
+		stream_pop(stream);
+		return 1;
+	default:
+		/* only white space after the object */
+		return -EINVAL;
+	}
+
+	return ret < 0 ? ret : 1;
+}
+
+void json_obj_stream_init(struct json_obj_stream *stream,
+			  const struct json_obj_descr *descr,
+			  size_t descr_len, void *val,
+			  char *buf, size_t buf_size)
+{
+	assert(descr_len < (sizeof(stream->result) * CHAR_BIT - 1));
+
+	(void)memset(stream, 0, sizeof(*stream));
+	stream->descr = descr;
+	stream->descr_len = descr_len;
+	stream->val = val;
+	stream->buf = buf;
+	stream->buf_size = buf_size;
+	stream->state = STREAM_START;
+}
+
+int json_obj_stream_feed(struct json_obj_stream *stream, const char *data,
+			 size_t len)
+{
+	const char *end = data + len;
+	int ret;
+
+	if (stream->result < 0) {
+		return stream->result;
+	}
+
+	while (data < end) {
+		ret = stream_step(stream, data, end);
+		if (ret < 0) {
+			stream->result = ret;
+			return ret;
+		}
+
+		data += ret;
+	}
+
+	return 0;
+}
+
+int json_obj_stream_end(struct json_obj_stream *stream)
+{
+	if (stream->result >= 0 && stream->state != STREAM_DONE) {
+		return -EINVAL;
+	}
+
+	return stream->result;
+}
+
 static char escape_as(char chr)
 {
 	switch (chr) {
@@ -628,16 +1287,24 @@ static int json_escape_internal(const char *str,
 	const char *cur;
 	int ret = 0;
 
-	for (cur = str; ret == 0 && *cur; cur++) {
+	for (cur = str; ret == 0 && *cur; ) {
 		char escaped = escape_as(*cur);
+		size_t len;
 
 		if (escaped) {
 			char bytes[2] = { '\\', escaped };
 
 			ret = append_bytes(bytes, 2, data);
-		} else {
-			ret = append_bytes(cur, 1, data);
+			cur++;
+			continue;
+		}
+
+		/* append the characters up to the next one to escape at once */
+		for (len = 1; cur[len] && !escape_as(cur[len]); len++) {
 		}
+
+		ret = append_bytes(cur, len, data);
+		cur += len;
 	}
 
 	return ret;
@@ -773,21 +1440,54 @@ static int str_encode(const char **str, json_append_bytes_t append_bytes,
 	return ret;
 }
 
-static int num_encode(const int32_t *num, json_append_bytes_t append_bytes,
+static int int_encode(int64_t num, json_append_bytes_t append_bytes,
 		      void *data)
 {
-	char buf[3 * sizeof(int32_t)];
-	int ret;
+	char buf[sizeof("-9223372036854775808")];
+	char *pos = buf + sizeof(buf);
+	uint64_t value64 = num < 0 ? 0U - (uint64_t)num : (uint64_t)num;
+	uint32_t value;
+
+	/* 32-bit divisions only for the digits fitting 32 bits */
+	while (value64 > UINT32_MAX) {
+		*--pos = '0' + value64 % 10U;
+		value64 /= 10U;
+	}
 
-	ret = snprintk(buf, sizeof(buf), "%d", *num);
-	if (ret < 0) {
-		return ret;
+	value = (uint32_t)value64;
+
+	do {
+		*--pos = '0' + value % 10U;
+		value /= 10U;
+	} while (value);
+
+	if (num < 0) {
+		*--pos = '-';
 	}
-	if (ret >= (int)sizeof(buf)) {
-		return -ENOMEM;
+
+	return append_bytes(pos, buf + sizeof(buf) - pos, data);
+}
+
+static int num_encode(const int32_t *num, json_append_bytes_t append_bytes,
+		      void *data)
+{
+	return int_encode(*num, append_bytes, data);
+}
+
+static int int64_encode(const int64_t *num, json_append_bytes_t append_bytes,
+			void *data)
+{
+	return int_encode(*num, append_bytes, data);
+}
+
+static int float_encode(const struct json_obj_token *num,
+			json_append_bytes_t append_bytes, void *data)
+{
+	if (check_float(num->start, num->start + num->length) < 0) {
+		return -EINVAL;
 	}
 
-	return append_bytes(buf, (size_t)ret, data);
+	return append_bytes(num->start, num->length, data);
 }
 
 static int bool_encode(const bool *value, json_append_bytes_t append_bytes,
@@ -820,6 +1520,10 @@ static int encode(const struct json_obj_descr *descr, const void *val,
 				       ptr, append_bytes, data);
 	case JSON_TOK_NUMBER:
 		return num_encode(ptr, append_bytes, data);
+	case JSON_TOK_INT64:
+		return int64_encode(ptr, append_bytes, data);
+	case JSON_TOK_FLOAT:
+		return float_encode(ptr, append_bytes, data);
 	default:
 		return -EINVAL;
 	}
@@ -15,6 +15,9 @@ struct eventfd {
 	struct k_sem write_sem;
 	eventfd_t cnt;
 	int flags;
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	sys_dlist_t notifiers;
+#endif
 };
 
 K_MUTEX_DEFINE(eventfd_mtx);
@@ -63,6 +66,34 @@ static int eventfd_poll_update(struct eventfd *efd,
 	return 0;
 }
 
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+static inline void eventfd_notify(struct eventfd *efd, uint32_t events)
+{
+	z_fd_notify(&efd->notifiers, events);
+}
+
+static int eventfd_poll_ready(struct eventfd *efd)
+{
+	int events = 0;
+
+	if (efd->cnt > 0) {
+		events |= ZSOCK_POLLIN;
+	}
+
+	if (efd->cnt < UINT64_MAX - 1) {
+		events |= ZSOCK_POLLOUT;
+	}
+
+	return events;
+}
+#else
+static inline void eventfd_notify(struct eventfd *efd, uint32_t events)
+{
+	ARG_UNUSED(efd);
+	ARG_UNUSED(events);
+}
+#endif /* CONFIG_NET_SOCKETS_EPOLL */
+
 static ssize_t eventfd_read_op(void *obj, void *buf, size_t sz)
 {
 	struct eventfd *efd = obj;
@@ -86,6 +117,7 @@ static ssize_t eventfd_read_op(void *obj, void *buf, size_t sz)
 	efd->cnt -= count;
 	*(eventfd_t *)buf = count;
 	k_sem_give(&efd->write_sem);
+	eventfd_notify(efd, ZSOCK_POLLOUT);
 
 	return sizeof(eventfd_t);
 }
@@ -125,6 +157,7 @@ static ssize_t eventfd_write_op(void *obj, const void *buf, size_t sz)
 	efd->cnt += count;
 	if (count) {
 		k_sem_give(&efd->read_sem);
+		eventfd_notify(efd, ZSOCK_POLLIN);
 	}
 
 	return sizeof(eventfd_t);
@@ -136,6 +169,10 @@ static int eventfd_close_op(void *obj)
 
 	efd->flags = 0;
 
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	z_fd_notify_close(&efd->notifiers);
+#endif
+
 	return 0;
 }
 
@@ -184,6 +221,16 @@ static int eventfd_ioctl_op(void *obj, unsigned int request, va_list args)
 		return eventfd_poll_update(obj, pfd, pev);
 	}
 
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	case ZFD_IOCTL_POLL_READY:
+		return eventfd_poll_ready(efd);
+
+	case ZFD_IOCTL_POLL_NOTIFY:
+		z_fd_notifier_attach(&efd->notifiers,
+				     va_arg(args, struct zfd_notifier *));
+		return 0;
+#endif
+
 	default:
 		errno = EOPNOTSUPP;
 		return -1;
@@ -233,6 +280,9 @@ int eventfd(unsigned int initval, int flags)
 	efd->cnt = 0;
 	k_sem_init(&efd->read_sem, 0, 1);
 	k_sem_init(&efd->write_sem, 0, UINT32_MAX);
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	sys_dlist_init(&efd->notifiers);
+#endif
 
 	z_finalize_fd(fd, efd, &eventfd_fd_vtable);
 
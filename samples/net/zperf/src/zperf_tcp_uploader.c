@@ -66,7 +66,11 @@ void zperf_tcp_upload(const struct shell *shell,
 		ret = net_context_send(ctx, sample_packet,
 				       packet_size, NULL,
 				       K_NO_WAIT, NULL);
-		if (ret < 0) {
+		if (ret == -EAGAIN) {
+			/* The send window of the peer is full, send the
+			 * packet again once it has room.
+			 */
+		} else if (ret < 0) {
 			if (nb_errors == 0 && ret != -ENOMEM) {
 				shell_fprintf(shell, SHELL_WARNING,
 				      "Failed to send the packet (%d)\n",
@@ -0,0 +1,484 @@
+/** @file
+ * @brief TCP receive coalescing (GRO)
+ *
+ * Consecutive segments of the same TCP connection that arrive in one RX
+ * burst are merged into a single packet, so that the IP and TCP input
+ * code is run once per burst instead of once per frame.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_gro, CONFIG_NET_GRO_LOG_LEVEL);
+
+#include <kernel.h>
+#include <string.h>
+#include <zephyr/types.h>
+
+#include <net/net_pkt.h>
+#include <net/net_core.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#include "net_private.h"
+#include "tcp_internal.h"
+#include "gro.h"
+
+#define NET_TCP_HDR_LEN_MAX 60
+#define NET_TCP_OPT_MAX_LEN (NET_TCP_HDR_LEN_MAX - NET_TCPH_LEN)
+
+struct gro_flow {
+	/** Held packet, NULL if the entry is free */
+	struct net_pkt *pkt;
+
+	/** Interface the segments were received on */
+	struct net_if *iface;
+
+	/** Source and destination address, only the first 4 bytes are used
+	 * for IPv4.
+	 */
+	struct in6_addr src;
+	struct in6_addr dst;
+
+	/** Sequence number expected in the next segment */
+	uint32_t next_seq;
+
+	/** Acknowledgment number of the held segments */
+	uint32_t ack;
+
+	/** Uptime in ms when the first segment was held */
+	uint32_t start;
+
+	/** Total TCP payload held */
+	uint16_t len;
+
+	/** Payload length of the first segment */
+	uint16_t mss;
+
+	uint16_t src_port;
+	uint16_t dst_port;
+
+	/** TCP options of the first segment */
+	uint8_t opts[NET_TCP_OPT_MAX_LEN];
+	uint8_t opts_len;
+
+	uint8_t segs;
+	sa_family_t family;
+};
+
+struct gro_table {
+	struct gro_flow flows[CONFIG_NET_GRO_MAX_FLOWS];
+	uint8_t held;
+};
+
+/* Parsed headers of a received segment */
+struct gro_seg {
+	struct net_tcp_hdr *tcp_hdr;
+	uint8_t *src;
+	uint8_t *dst;
+	uint16_t ip_hdr_len;
+	uint16_t hdr_len;
+	uint16_t len;
+	uint8_t addr_len;
+	sa_family_t family;
+};
+
+/* Each RX queue is served by its own thread, so the tables do not need
+ * locking.
+ */
+static struct gro_table gro_tables[NET_RX_QUEUE_COUNT];
+
+static bool gro_parse_ipv4(struct net_pkt *pkt, struct gro_seg *seg)
+{
+	struct net_ipv4_hdr *hdr = (struct net_ipv4_hdr *)pkt->buffer->data;
+
+	if (!IS_ENABLED(CONFIG_NET_IPV4) ||
+	    pkt->buffer->len < NET_IPV4TCPH_LEN) {
+		return false;
+	}
+
+	/* No IPv4 options and no fragments, DF bit is allowed. */
+	if (hdr->vhl != 0x45 || hdr->proto != IPPROTO_TCP ||
+	    (hdr->offset[0] & 0x3f) || hdr->offset[1]) {
+		return false;
+	}
+
+	if (ntohs(hdr->len) != net_pkt_get_len(pkt)) {
+		return false;
+	}
+
+	if ((IS_ENABLED(CONFIG_NET_ROUTING) ||
+	     IS_ENABLED(CONFIG_NET_IPV4_FORWARDING)) &&
+	    !net_ipv4_is_my_addr(&hdr->dst)) {
+		return false;
+	}
+
+	/* Replies of masqueraded connections are forwarded too */
+	if (IS_ENABLED(CONFIG_NET_IPV4_NAT) &&
+	    net_if_flag_is_set(net_pkt_iface(pkt), NET_IF_IPV4_MASQUERADE)) {
+		return false;
+	}
+
+	seg->src = (uint8_t *)&hdr->src;
+	seg->dst = (uint8_t *)&hdr->dst;
+	seg->addr_len = sizeof(struct in_addr);
+	seg->ip_hdr_len = NET_IPV4H_LEN;
+	seg->family = AF_INET;
+
+	return true;
+}
+
+static bool gro_parse_ipv6(struct net_pkt *pkt, struct gro_seg *seg)
+{
+	struct net_ipv6_hdr *hdr = (struct net_ipv6_hdr *)pkt->buffer->data;
+
+	if (!IS_ENABLED(CONFIG_NET_IPV6) ||
+	    pkt->buffer->len < NET_IPV6TCPH_LEN) {
+		return false;
+	}
+
+	/* Extension headers are not coalesced. */
+	if (hdr->nexthdr != IPPROTO_TCP) {
+		return false;
+	}
+
+	if (ntohs(hdr->len) + NET_IPV6H_LEN != net_pkt_get_len(pkt)) {
+		return false;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_ROUTING) &&
+	    !net_ipv6_is_my_addr(&hdr->dst)) {
+		return false;
+	}
+
+	seg->src = (uint8_t *)&hdr->src;
+	seg->dst = (uint8_t *)&hdr->dst;
+	seg->addr_len = sizeof(struct in6_addr);
+	seg->ip_hdr_len = NET_IPV6H_LEN;
+	seg->family = AF_INET6;
+
+	return true;
+}
+
+static bool gro_parse(struct net_pkt *pkt, struct gro_seg *seg)
+{
+	struct net_buf *buf = pkt->buffer;
+	uint8_t th_len;
+
+	/* Only headers that are contiguous in the first fragment are
+	 * looked at, which is always the case with sane buffer sizes.
+	 */
+	switch (buf->data[0] & 0xf0) {
+	case 0x40:
+		if (!gro_parse_ipv4(pkt, seg)) {
+			return false;
+		}
+
+		break;
+	case 0x60:
+		if (!gro_parse_ipv6(pkt, seg)) {
+			return false;
+		}
+
+		break;
+	default:
+		return false;
+	}
+
+	seg->tcp_hdr = (struct net_tcp_hdr *)(buf->data + seg->ip_hdr_len);
+
+	th_len = NET_TCP_HDR_LEN(seg->tcp_hdr);
+	if (th_len < NET_TCPH_LEN || seg->ip_hdr_len + th_len > buf->len) {
+		return false;
+	}
+
+	seg->hdr_len = seg->ip_hdr_len + th_len;
+	seg->len = net_pkt_get_len(pkt) - seg->hdr_len;
+
+	/* Needed by the checksum helpers, on this packet and on the held
+	 * packet it may become.
+	 */
+	net_pkt_set_family(pkt, seg->family);
+	net_pkt_set_ip_hdr_len(pkt, seg->ip_hdr_len);
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && seg->family == AF_INET) {
+		net_pkt_set_ipv4_opts_len(pkt, 0);
+	} else {
+		net_pkt_set_ipv6_ext_len(pkt, 0);
+	}
+
+	return true;
+}
+
+static bool gro_chksum_ok(struct net_pkt *pkt, struct gro_seg *seg)
+{
+	struct net_if *iface = net_pkt_iface(pkt);
+
+	if (net_pkt_is_chksum_done(pkt) ||
+	    !net_if_need_calc_rx_checksum(iface)) {
+		return true;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && seg->family == AF_INET &&
+	    net_calc_chksum_ipv4(pkt) != 0U) {
+		return false;
+	}
+
+	if (net_calc_chksum_tcp(pkt) != 0U) {
+		return false;
+	}
+
+	/* The IP and TCP input do not need to verify it again. */
+	net_pkt_set_chksum_done(pkt, true);
+
+	return true;
+}
+
+static struct gro_flow *gro_lookup(struct gro_table *table,
+				   struct net_pkt *pkt,
+				   struct gro_seg *seg)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_GRO_MAX_FLOWS; i++) {
+		struct gro_flow *flow = &table->flows[i];
+
+		if (flow->pkt && flow->family == seg->family &&
+		    flow->iface == net_pkt_iface(pkt) &&
+		    flow->src_port == seg->tcp_hdr->src_port &&
+		    flow->dst_port == seg->tcp_hdr->dst_port &&
+		    !memcmp(&flow->src, seg->src, seg->addr_len) &&
+		    !memcmp(&flow->dst, seg->dst, seg->addr_len)) {
+			return flow;
+		}
+	}
+
+	return NULL;
+}
+
+static void gro_deliver(struct net_pkt *pkt)
+{
+	enum net_verdict verdict = NET_DROP;
+
+	net_pkt_cursor_init(pkt);
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && net_pkt_family(pkt) == AF_INET6) {
+		verdict = net_ipv6_input(pkt, false);
+	} else if (IS_ENABLED(CONFIG_NET_IPV4)) {
+		verdict = net_ipv4_input(pkt);
+	}
+
+	if (verdict != NET_OK) {
+		NET_DBG("Dropping pkt %p", pkt);
+		net_pkt_unref(pkt);
+	}
+}
+
+static void gro_flush_flow(struct gro_table *table, struct gro_flow *flow)
+{
+	struct net_pkt *pkt = flow->pkt;
+
+	NET_DBG("Flushing pkt %p (%u segments, %u bytes)", pkt, flow->segs,
+		flow->len);
+
+	flow->pkt = NULL;
+	table->held--;
+
+	gro_deliver(pkt);
+}
+
+static void gro_flush_expired(struct gro_table *table)
+{
+	uint32_t now = k_uptime_get_32();
+	int i;
+
+	for (i = 0; i < CONFIG_NET_GRO_MAX_FLOWS && table->held; i++) {
+		struct gro_flow *flow = &table->flows[i];
+
+		if (flow->pkt &&
+		    (now - flow->start) >= CONFIG_NET_GRO_TIMEOUT) {
+			gro_flush_flow(table, flow);
+		}
+	}
+}
+
+static struct gro_flow *gro_flow_alloc(struct gro_table *table)
+{
+	struct gro_flow *oldest = NULL;
+	int i;
+
+	for (i = 0; i < CONFIG_NET_GRO_MAX_FLOWS; i++) {
+		struct gro_flow *flow = &table->flows[i];
+
+		if (!flow->pkt) {
+			return flow;
+		}
+
+		if (!oldest || (int32_t)(flow->start - oldest->start) < 0) {
+			oldest = flow;
+		}
+	}
+
+	gro_flush_flow(table, oldest);
+
+	return oldest;
+}
+
+static void gro_hold(struct gro_table *table, struct gro_flow *flow,
+		     struct net_pkt *pkt, struct gro_seg *seg)
+{
+	struct net_tcp_hdr *tcp_hdr = seg->tcp_hdr;
+
+	flow->pkt = pkt;
+	flow->iface = net_pkt_iface(pkt);
+	flow->family = seg->family;
+	memcpy(&flow->src, seg->src, seg->addr_len);
+	memcpy(&flow->dst, seg->dst, seg->addr_len);
+	flow->src_port = tcp_hdr->src_port;
+	flow->dst_port = tcp_hdr->dst_port;
+	flow->next_seq = sys_get_be32(tcp_hdr->seq) + seg->len;
+	flow->ack = sys_get_be32(tcp_hdr->ack);
+	flow->opts_len = seg->hdr_len - seg->ip_hdr_len - NET_TCPH_LEN;
+	memcpy(flow->opts, tcp_hdr->optdata, flow->opts_len);
+	flow->start = k_uptime_get_32();
+	flow->len = seg->len;
+	flow->mss = seg->len;
+	flow->segs = 1U;
+
+	table->held++;
+}
+
+static bool gro_can_merge(struct gro_flow *flow, struct gro_seg *seg)
+{
+	struct net_tcp_hdr *tcp_hdr = seg->tcp_hdr;
+
+	return sys_get_be32(tcp_hdr->seq) == flow->next_seq &&
+		sys_get_be32(tcp_hdr->ack) == flow->ack &&
+		seg->len <= flow->mss &&
+		flow->len + seg->len <= CONFIG_NET_GRO_MAX_SIZE &&
+		seg->hdr_len - seg->ip_hdr_len - NET_TCPH_LEN ==
+							flow->opts_len &&
+		!memcmp(tcp_hdr->optdata, flow->opts, flow->opts_len);
+}
+
+static void gro_merge(struct gro_flow *flow, struct net_pkt *pkt,
+		      struct gro_seg *seg)
+{
+	struct net_pkt *held = flow->pkt;
+	uint8_t *hdr = held->buffer->data;
+	struct net_tcp_hdr *tcp_hdr;
+	struct net_buf *buf;
+
+	/* Take the PSH flag and the window of the segment before its
+	 * headers are released.
+	 */
+	tcp_hdr = (struct net_tcp_hdr *)(hdr + seg->ip_hdr_len);
+	tcp_hdr->flags |= seg->tcp_hdr->flags & NET_TCP_PSH;
+	memcpy(tcp_hdr->wnd, seg->tcp_hdr->wnd, sizeof(tcp_hdr->wnd));
+
+	/* Strip the headers and chain the payload fragments to the held
+	 * packet, no data is copied.
+	 */
+	buf = pkt->buffer;
+	net_buf_pull(buf, seg->hdr_len);
+	if (!buf->len) {
+		buf = net_buf_frag_del(NULL, buf);
+	}
+
+	pkt->buffer = NULL;
+	if (buf) {
+		net_pkt_append_buffer(held, buf);
+	}
+
+	seg->tcp_hdr = NULL;
+
+	net_pkt_unref(pkt);
+
+	flow->len += seg->len;
+	flow->next_seq += seg->len;
+	flow->segs++;
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && flow->family == AF_INET) {
+		struct net_ipv4_hdr *ipv4_hdr = (struct net_ipv4_hdr *)hdr;
+
+		ipv4_hdr->len = htons(ntohs(ipv4_hdr->len) + seg->len);
+		ipv4_hdr->chksum = 0U;
+		ipv4_hdr->chksum = net_calc_chksum_ipv4(held);
+	} else {
+		struct net_ipv6_hdr *ipv6_hdr = (struct net_ipv6_hdr *)hdr;
+
+		ipv6_hdr->len = htons(ntohs(ipv6_hdr->len) + seg->len);
+	}
+}
+
+enum net_verdict net_gro_receive(struct net_pkt *pkt)
+{
+	uint8_t tc = net_rx_priority2tc(net_pkt_priority(pkt));
+	struct gro_table *table = &gro_tables[net_rx_queue_id(tc, pkt)];
+	struct gro_flow *flow;
+	struct gro_seg seg;
+	uint8_t flags;
+
+	if (table->held) {
+		gro_flush_expired(table);
+	}
+
+	if (!pkt->buffer || !gro_parse(pkt, &seg)) {
+		return NET_CONTINUE;
+	}
+
+	flow = table->held ? gro_lookup(table, pkt, &seg) : NULL;
+	flags = NET_TCP_FLAGS(seg.tcp_hdr);
+
+	/* Control segments, pure ACKs and corrupted segments are processed
+	 * normally, after the data held for the same connection.
+	 */
+	if ((flags & ~NET_TCP_PSH) != NET_TCP_ACK || !seg.len ||
+	    !gro_chksum_ok(pkt, &seg)) {
+		if (flow) {
+			gro_flush_flow(table, flow);
+		}
+
+		return NET_CONTINUE;
+	}
+
+	if (flow) {
+		if (gro_can_merge(flow, &seg)) {
+			gro_merge(flow, pkt, &seg);
+
+			if ((flags & NET_TCP_PSH) || seg.len < flow->mss ||
+			    flow->segs >= CONFIG_NET_GRO_MAX_SEGS ||
+			    flow->len + flow->mss > CONFIG_NET_GRO_MAX_SIZE) {
+				gro_flush_flow(table, flow);
+			}
+
+			return NET_OK;
+		}
+
+		gro_flush_flow(table, flow);
+	}
+
+	if (flags & NET_TCP_PSH) {
+		return NET_CONTINUE;
+	}
+
+	gro_hold(table, gro_flow_alloc(table), pkt, &seg);
+
+	return NET_OK;
+}
+
+void net_gro_flush(uint8_t queue)
+{
+	struct gro_table *table = &gro_tables[queue];
+	int i;
+
+	for (i = 0; i < CONFIG_NET_GRO_MAX_FLOWS && table->held; i++) {
+		if (table->flows[i].pkt) {
+			gro_flush_flow(table, &table->flows[i]);
+		}
+	}
+}
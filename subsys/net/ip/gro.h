@@ -0,0 +1,65 @@
+/** @file
+ * @brief TCP receive coalescing (GRO)
+ *
+ * This is not to be included by the application.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __GRO_H
+#define __GRO_H
+
+#include <zephyr/types.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_NET_GRO)
+/**
+ * @brief Try to coalesce a received packet with the segments already held
+ * for the same TCP connection.
+ *
+ * The packet must start with the IP header. Packets that are held or merged
+ * are passed to the IP layer later, either when the flow is flushed or by
+ * net_gro_flush().
+ *
+ * @param pkt Received network packet
+ *
+ * @return NET_OK if the packet was consumed, NET_CONTINUE if the caller
+ * should process it normally.
+ */
+enum net_verdict net_gro_receive(struct net_pkt *pkt);
+
+/**
+ * @brief Pass all the held packets of a RX queue to the IP layer.
+ *
+ * @param queue RX queue, see net_rx_queue_id()
+ */
+void net_gro_flush(uint8_t queue);
+#else
+static inline enum net_verdict net_gro_receive(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return NET_CONTINUE;
+}
+
+static inline void net_gro_flush(uint8_t queue)
+{
+	ARG_UNUSED(queue);
+}
+#endif /* CONFIG_NET_GRO */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GRO_H */
@@ -258,11 +258,26 @@ enum net_verdict net_ipv4_input(struct net_pkt *pkt)
 	}
 
 	if (net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
+	    !net_pkt_is_chksum_done(pkt) &&
 	    net_calc_chksum_ipv4(pkt) != 0U) {
 		NET_DBG("DROP: invalid chksum");
 		goto drop;
 	}
 
+	if (IS_ENABLED(CONFIG_NET_IPV4_FORWARDING)) {
+		net_pkt_set_family(pkt, PF_INET);
+
+		switch (net_ipv4_forward(pkt, hdr)) {
+		case NET_OK:
+			return NET_OK;
+		case NET_DROP:
+			goto drop;
+		default:
+			net_pkt_cursor_init(pkt);
+			break;
+		}
+	}
+
 	if ((!net_ipv4_is_my_addr(&hdr->dst) &&
 	     !net_ipv4_is_addr_mcast(&hdr->dst) &&
 	     !(hdr->proto == IPPROTO_UDP &&
@@ -132,4 +132,28 @@ static inline int net_ipv4_parse_hdr_options(struct net_pkt *pkt,
 }
 #endif
 
+/**
+ * @brief Forward a received IPv4 packet which is not addressed to this
+ * host, and the replies of the connections translated by the NAT.
+ *
+ * @param pkt Network packet, with the cursor at the IPv4 header
+ * @param hdr IPv4 header of the packet
+ *
+ * @return NET_OK if the packet was forwarded, NET_DROP if it must be
+ * dropped, NET_CONTINUE if it must be handled by this host.
+ */
+#if defined(CONFIG_NET_IPV4_FORWARDING)
+enum net_verdict net_ipv4_forward(struct net_pkt *pkt,
+				  struct net_ipv4_hdr *hdr);
+#else
+static inline enum net_verdict net_ipv4_forward(struct net_pkt *pkt,
+						struct net_ipv4_hdr *hdr)
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(hdr);
+
+	return NET_CONTINUE;
+}
+#endif
+
 #endif /* __IPV4_H */
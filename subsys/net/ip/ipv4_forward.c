@@ -0,0 +1,614 @@
+/** @file
+ * @brief IPv4 forwarding and NAT
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_ipv4, CONFIG_NET_IPV4_LOG_LEVEL);
+
+#include <errno.h>
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_if.h>
+#include "net_private.h"
+#include "icmpv4.h"
+#include "ipv4.h"
+
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_RST 0x04
+
+/* Update a checksum after a 32-bit field of the data changed from old to
+ * new (RFC 1624). The values are taken as they are in the packet, the
+ * one's complement sum does not depend on the byte order.
+ */
+static uint16_t chksum_update(uint16_t chksum, uint32_t old, uint32_t new)
+{
+	uint32_t sum = (uint16_t)~chksum;
+
+	sum += (uint16_t)~(old >> 16) + (uint16_t)~old;
+	sum += (new >> 16) + (new & 0xffff);
+
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+
+	return ~sum;
+}
+
+static enum net_verdict ipv4_forward_send(struct net_pkt *pkt,
+					  struct net_ipv4_hdr *hdr,
+					  struct net_if *iface)
+{
+	uint16_t old = UNALIGNED_GET((uint16_t *)&hdr->ttl);
+
+	hdr->ttl--;
+	hdr->chksum = chksum_update(hdr->chksum, old,
+				    UNALIGNED_GET((uint16_t *)&hdr->ttl));
+
+	NET_DBG("Forward pkt %p from %p to %p", pkt, net_pkt_iface(pkt),
+		iface);
+
+	net_pkt_set_orig_iface(pkt, net_pkt_iface(pkt));
+	net_pkt_set_iface(pkt, iface);
+	net_pkt_set_forwarding(pkt, true);
+
+	net_pkt_lladdr_src(pkt)->addr = net_pkt_lladdr_if(pkt)->addr;
+	net_pkt_lladdr_src(pkt)->type = net_pkt_lladdr_if(pkt)->type;
+	net_pkt_lladdr_src(pkt)->len = net_pkt_lladdr_if(pkt)->len;
+
+	/* Found by ARP, if the interface needs it */
+	net_pkt_lladdr_dst(pkt)->addr = NULL;
+	net_pkt_lladdr_dst(pkt)->len = 0U;
+
+	if (net_send_data(pkt) < 0) {
+		NET_DBG("Cannot forward pkt %p", pkt);
+		return NET_DROP;
+	}
+
+	return NET_OK;
+}
+
+#if defined(CONFIG_NET_IPV4_NAT)
+
+#define CONNTRACK_COUNT CONFIG_NET_IPV4_NAT_MAX_CONNECTIONS
+#define CONNTRACK_HASH_SIZE CONFIG_NET_IPV4_NAT_MAX_CONNECTIONS
+#define CONNTRACK_HASH_END 0xffff
+
+#define NAT_PORT_COUNT (CONFIG_NET_IPV4_NAT_PORT_MAX - \
+			CONFIG_NET_IPV4_NAT_PORT_MIN + 1)
+
+#define NAT_TCP_CLOSING_TIMEOUT MIN(CONFIG_NET_IPV4_NAT_TCP_TIMEOUT, 60)
+
+/* Addresses and ports of the packets of a connection in one direction.
+ * ICMP echo requests have their identifier as source port and the replies
+ * as destination port, the other port being 0.
+ */
+struct conntrack_tuple {
+	struct in_addr src;
+	struct in_addr dst;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint8_t proto;
+};
+
+struct conntrack_entry {
+	/* Packets from the host behind the NAT, before translation */
+	struct conntrack_tuple orig;
+
+	/* Packets from the peer, before translation */
+	struct conntrack_tuple reply;
+
+	/* Interface of the host behind the NAT */
+	struct net_if *iface;
+
+	/* Uptime at which the entry expires, in milliseconds */
+	uint32_t expires;
+
+	bool closing;
+	bool used;
+};
+
+enum {
+	CONNTRACK_ORIG,
+	CONNTRACK_REPLY,
+};
+
+/* Transport header of a translated packet */
+union nat_hdr {
+	struct net_udp_hdr udp;
+	struct net_tcp_hdr tcp;
+	struct {
+		struct net_icmp_hdr hdr;
+		struct net_icmpv4_echo_req echo;
+	} __packed icmp;
+};
+
+static struct conntrack_entry conntrack[CONNTRACK_COUNT];
+
+/* Every entry is indexed in both directions by a hash of the tuple. Each
+ * bucket holds the index of the first entry of its chain, conntrack_next[]
+ * holds the index of the next one.
+ */
+static uint16_t conntrack_head[2][CONNTRACK_HASH_SIZE] = {
+	[0 ... 1] = {
+		[0 ... (CONNTRACK_HASH_SIZE - 1)] = CONNTRACK_HASH_END,
+	},
+};
+static uint16_t conntrack_next[2][CONNTRACK_COUNT];
+
+static uint16_t nat_next_port = CONFIG_NET_IPV4_NAT_PORT_MIN;
+
+static K_MUTEX_DEFINE(conntrack_lock);
+
+static inline struct conntrack_tuple *conntrack_tuple(
+	struct conntrack_entry *entry, int dir)
+{
+	return dir == CONNTRACK_ORIG ? &entry->orig : &entry->reply;
+}
+
+static uint16_t *conntrack_bucket(int dir, const struct conntrack_tuple *t)
+{
+	uint32_t hash = t->proto;
+
+	hash = (hash ^ t->src.s_addr) * 0x9e3779b1U;
+	hash = (hash ^ t->dst.s_addr) * 0x9e3779b1U;
+	hash = (hash ^ ((uint32_t)t->src_port << 16 | t->dst_port)) *
+	       0x9e3779b1U;
+
+	return &conntrack_head[dir][(hash ^ (hash >> 16)) %
+				    CONNTRACK_HASH_SIZE];
+}
+
+static bool conntrack_tuple_cmp(const struct conntrack_tuple *a,
+				const struct conntrack_tuple *b)
+{
+	return a->proto == b->proto &&
+	       a->src_port == b->src_port && a->dst_port == b->dst_port &&
+	       net_ipv4_addr_cmp(&a->src, &b->src) &&
+	       net_ipv4_addr_cmp(&a->dst, &b->dst);
+}
+
+static void conntrack_hash_add(uint16_t idx)
+{
+	uint16_t *bucket;
+	int dir;
+
+	for (dir = CONNTRACK_ORIG; dir <= CONNTRACK_REPLY; dir++) {
+		bucket = conntrack_bucket(dir,
+					  conntrack_tuple(&conntrack[idx], dir));
+
+		conntrack_next[dir][idx] = *bucket;
+		*bucket = idx;
+	}
+}
+
+static void conntrack_hash_remove(uint16_t idx)
+{
+	uint16_t *i;
+	int dir;
+
+	for (dir = CONNTRACK_ORIG; dir <= CONNTRACK_REPLY; dir++) {
+		i = conntrack_bucket(dir, conntrack_tuple(&conntrack[idx], dir));
+
+		for (; *i != CONNTRACK_HASH_END; i = &conntrack_next[dir][*i]) {
+			if (*i == idx) {
+				*i = conntrack_next[dir][idx];
+				break;
+			}
+		}
+	}
+}
+
+static inline bool conntrack_expired(struct conntrack_entry *entry,
+				     uint32_t now)
+{
+	return (int32_t)(entry->expires - now) <= 0;
+}
+
+static void conntrack_free(struct conntrack_entry *entry)
+{
+	conntrack_hash_remove(entry - conntrack);
+	entry->used = false;
+}
+
+/* Must be called with conntrack_lock held. */
+static struct conntrack_entry *conntrack_find(int dir,
+					      const struct conntrack_tuple *t)
+{
+	uint16_t i = *conntrack_bucket(dir, t);
+
+	for (; i != CONNTRACK_HASH_END; i = conntrack_next[dir][i]) {
+		if (!conntrack_tuple_cmp(conntrack_tuple(&conntrack[i], dir),
+					 t)) {
+			continue;
+		}
+
+		if (conntrack_expired(&conntrack[i], k_uptime_get_32())) {
+			conntrack_free(&conntrack[i]);
+			return NULL;
+		}
+
+		return &conntrack[i];
+	}
+
+	return NULL;
+}
+
+/* Must be called with conntrack_lock held. */
+static struct conntrack_entry *conntrack_alloc(void)
+{
+	uint32_t now = k_uptime_get_32();
+	int i;
+
+	for (i = 0; i < CONNTRACK_COUNT; i++) {
+		if (!conntrack[i].used) {
+			return &conntrack[i];
+		}
+
+		if (conntrack_expired(&conntrack[i], now)) {
+			conntrack_free(&conntrack[i]);
+			return &conntrack[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void conntrack_refresh(struct conntrack_entry *entry,
+			      union nat_hdr *l4)
+{
+	uint32_t timeout;
+
+	switch (entry->orig.proto) {
+	case IPPROTO_TCP:
+		if (l4->tcp.flags & (TCP_FLAG_FIN | TCP_FLAG_RST)) {
+			entry->closing = true;
+		}
+
+		timeout = entry->closing ? NAT_TCP_CLOSING_TIMEOUT :
+			CONFIG_NET_IPV4_NAT_TCP_TIMEOUT;
+		break;
+	case IPPROTO_UDP:
+		timeout = CONFIG_NET_IPV4_NAT_UDP_TIMEOUT;
+		break;
+	default:
+		timeout = CONFIG_NET_IPV4_NAT_ICMP_TIMEOUT;
+		break;
+	}
+
+	entry->expires = k_uptime_get_32() + timeout * MSEC_PER_SEC;
+}
+
+/* Create the entry of a new connection from orig, translated to the address
+ * of the NAT interface and a free port. Must be called with conntrack_lock
+ * held.
+ */
+static struct conntrack_entry *conntrack_create(
+	const struct conntrack_tuple *orig, struct net_if *iface,
+	struct net_if *nat_iface)
+{
+	struct conntrack_tuple reply;
+	struct conntrack_entry *entry;
+	const struct in_addr *addr;
+	int i;
+
+	addr = net_if_ipv4_select_src_addr(nat_iface, &orig->dst);
+	if (net_ipv4_is_addr_unspecified(addr)) {
+		NET_DBG("No address on iface %p", nat_iface);
+		return NULL;
+	}
+
+	entry = conntrack_alloc();
+	if (!entry) {
+		NET_DBG("Connection tracking table full");
+		return NULL;
+	}
+
+	reply.proto = orig->proto;
+	net_ipaddr_copy(&reply.src, &orig->dst);
+	net_ipaddr_copy(&reply.dst, addr);
+	reply.src_port = orig->dst_port;
+
+	for (i = 0; i < NAT_PORT_COUNT; i++) {
+		reply.dst_port = htons(nat_next_port);
+
+		if (nat_next_port++ == CONFIG_NET_IPV4_NAT_PORT_MAX) {
+			nat_next_port = CONFIG_NET_IPV4_NAT_PORT_MIN;
+		}
+
+		if (!conntrack_find(CONNTRACK_REPLY, &reply)) {
+			break;
+		}
+	}
+
+	if (i == NAT_PORT_COUNT) {
+		NET_DBG("No free port to %s",
+			log_strdup(net_sprint_ipv4_addr(&orig->dst)));
+		return NULL;
+	}
+
+	entry->orig = *orig;
+	entry->reply = reply;
+	entry->iface = iface;
+	entry->closing = false;
+	entry->used = true;
+
+	conntrack_hash_add(entry - conntrack);
+
+	NET_DBG("New connection %s:%u -> %s:%u proto %u via port %u",
+		log_strdup(net_sprint_ipv4_addr(&orig->src)),
+		ntohs(orig->src_port),
+		log_strdup(net_sprint_ipv4_addr(&orig->dst)),
+		ntohs(orig->dst_port), orig->proto, ntohs(reply.dst_port));
+
+	return entry;
+}
+
+/* Read the transport header of a packet and the tuple of its connection.
+ * The cursor is left at the transport header.
+ */
+static int nat_read_hdr(struct net_pkt *pkt, struct net_ipv4_hdr *hdr,
+			union nat_hdr *l4, size_t *l4_len,
+			struct conntrack_tuple *t)
+{
+	/* Only the first fragment has the ports */
+	if ((hdr->offset[0] & 0x3f) || hdr->offset[1]) {
+		return -ENOTSUP;
+	}
+
+	switch (hdr->proto) {
+	case IPPROTO_TCP:
+		*l4_len = sizeof(l4->tcp);
+		break;
+	case IPPROTO_UDP:
+		*l4_len = sizeof(l4->udp);
+		break;
+	case IPPROTO_ICMP:
+		*l4_len = sizeof(l4->icmp);
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	net_pkt_cursor_init(pkt);
+
+	if (net_pkt_skip(pkt, net_pkt_ip_hdr_len(pkt) +
+			 net_pkt_ipv4_opts_len(pkt))) {
+		return -EINVAL;
+	}
+
+	if (net_pkt_read(pkt, l4, *l4_len)) {
+		return -EINVAL;
+	}
+
+	t->proto = hdr->proto;
+	net_ipaddr_copy(&t->src, &hdr->src);
+	net_ipaddr_copy(&t->dst, &hdr->dst);
+
+	if (hdr->proto == IPPROTO_ICMP) {
+		if (l4->icmp.hdr.type == NET_ICMPV4_ECHO_REQUEST) {
+			t->src_port = l4->icmp.echo.identifier;
+			t->dst_port = 0U;
+		} else if (l4->icmp.hdr.type == NET_ICMPV4_ECHO_REPLY) {
+			t->src_port = 0U;
+			t->dst_port = l4->icmp.echo.identifier;
+		} else {
+			return -ENOTSUP;
+		}
+	} else {
+		/* Same offsets in UDP and TCP headers */
+		t->src_port = l4->udp.src_port;
+		t->dst_port = l4->udp.dst_port;
+	}
+
+	return 0;
+}
+
+/* Replace the source or destination address and port of a packet, and
+ * update the checksums incrementally, then write the transport header
+ * back at the cursor.
+ */
+static int nat_rewrite(struct net_pkt *pkt, struct net_ipv4_hdr *hdr,
+		       union nat_hdr *l4, size_t l4_len, bool src,
+		       const struct in_addr *addr, uint16_t port)
+{
+	struct in_addr *ip_addr = src ? &hdr->src : &hdr->dst;
+	uint32_t old_addr = UNALIGNED_GET(&ip_addr->s_addr);
+	uint32_t new_addr = UNALIGNED_GET(&addr->s_addr);
+	uint16_t old_port;
+
+	if (hdr->proto == IPPROTO_ICMP) {
+		/* No pseudo header in the ICMP checksum */
+		old_port = l4->icmp.echo.identifier;
+		l4->icmp.echo.identifier = port;
+		l4->icmp.hdr.chksum = chksum_update(l4->icmp.hdr.chksum,
+						    old_port, port);
+	} else if (hdr->proto == IPPROTO_TCP) {
+		old_port = src ? l4->tcp.src_port : l4->tcp.dst_port;
+
+		if (src) {
+			l4->tcp.src_port = port;
+		} else {
+			l4->tcp.dst_port = port;
+		}
+
+		l4->tcp.chksum = chksum_update(l4->tcp.chksum, old_addr,
+					       new_addr);
+		l4->tcp.chksum = chksum_update(l4->tcp.chksum, old_port, port);
+	} else {
+		old_port = src ? l4->udp.src_port : l4->udp.dst_port;
+
+		if (src) {
+			l4->udp.src_port = port;
+		} else {
+			l4->udp.dst_port = port;
+		}
+
+		/* A zero checksum means that there is none */
+		if (l4->udp.chksum) {
+			l4->udp.chksum = chksum_update(l4->udp.chksum,
+						       old_addr, new_addr);
+			l4->udp.chksum = chksum_update(l4->udp.chksum,
+						       old_port, port);
+			if (!l4->udp.chksum) {
+				l4->udp.chksum = 0xffff;
+			}
+		}
+	}
+
+	hdr->chksum = chksum_update(hdr->chksum, old_addr, new_addr);
+	UNALIGNED_PUT(new_addr, &ip_addr->s_addr);
+
+	return net_pkt_write(pkt, l4, l4_len);
+}
+
+/* Translate the source of a packet forwarded to a masquerading interface. */
+static int nat_masquerade(struct net_pkt *pkt, struct net_ipv4_hdr *hdr,
+			  struct net_if *iface)
+{
+	struct conntrack_entry *entry;
+	struct conntrack_tuple t;
+	union nat_hdr l4;
+	struct in_addr addr;
+	size_t l4_len;
+	uint16_t port;
+	int ret;
+
+	ret = nat_read_hdr(pkt, hdr, &l4, &l4_len, &t);
+	if (ret < 0 || (hdr->proto == IPPROTO_ICMP && t.dst_port)) {
+		NET_DBG("Cannot translate pkt %p proto %u", pkt, hdr->proto);
+		return -ENOTSUP;
+	}
+
+	k_mutex_lock(&conntrack_lock, K_FOREVER);
+
+	entry = conntrack_find(CONNTRACK_ORIG, &t);
+	if (!entry) {
+		entry = conntrack_create(&t, net_pkt_iface(pkt), iface);
+	}
+
+	if (entry) {
+		conntrack_refresh(entry, &l4);
+		net_ipaddr_copy(&addr, &entry->reply.dst);
+		port = entry->reply.dst_port;
+	}
+
+	k_mutex_unlock(&conntrack_lock);
+
+	if (!entry) {
+		return -ENOMEM;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_skip(pkt, net_pkt_ip_hdr_len(pkt) +
+		     net_pkt_ipv4_opts_len(pkt));
+
+	return nat_rewrite(pkt, hdr, &l4, l4_len, true, &addr, port);
+}
+
+/* Translate back and forward the replies of the masqueraded connections,
+ * which are addressed to this host.
+ */
+static enum net_verdict nat_reply(struct net_pkt *pkt,
+				  struct net_ipv4_hdr *hdr)
+{
+	struct conntrack_entry *entry;
+	struct conntrack_tuple t;
+	union nat_hdr l4;
+	struct net_if *iface;
+	struct in_addr addr;
+	size_t l4_len;
+	uint16_t port;
+
+	if (!net_if_flag_is_set(net_pkt_iface(pkt), NET_IF_IPV4_MASQUERADE) ||
+	    nat_read_hdr(pkt, hdr, &l4, &l4_len, &t) < 0) {
+		return NET_CONTINUE;
+	}
+
+	k_mutex_lock(&conntrack_lock, K_FOREVER);
+
+	entry = conntrack_find(CONNTRACK_REPLY, &t);
+	if (entry) {
+		conntrack_refresh(entry, &l4);
+		net_ipaddr_copy(&addr, &entry->orig.src);
+		port = entry->orig.src_port;
+		iface = entry->iface;
+	}
+
+	k_mutex_unlock(&conntrack_lock);
+
+	if (!entry) {
+		return NET_CONTINUE;
+	}
+
+	if (hdr->ttl <= 1U) {
+		NET_DBG("DROP: TTL expired");
+		return NET_DROP;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_skip(pkt, net_pkt_ip_hdr_len(pkt) +
+		     net_pkt_ipv4_opts_len(pkt));
+
+	if (nat_rewrite(pkt, hdr, &l4, l4_len, false, &addr, port) < 0) {
+		return NET_DROP;
+	}
+
+	return ipv4_forward_send(pkt, hdr, iface);
+}
+#else
+#define nat_masquerade(...) -ENOTSUP
+#define nat_reply(...) NET_CONTINUE
+#endif /* CONFIG_NET_IPV4_NAT */
+
+static bool ipv4_can_forward(struct net_if *iface, struct net_ipv4_hdr *hdr)
+{
+	return !net_ipv4_is_addr_mcast(&hdr->dst) &&
+	       !net_ipv4_is_addr_bcast(iface, &hdr->dst) &&
+	       !net_ipv4_is_addr_unspecified(&hdr->dst) &&
+	       !net_ipv4_is_addr_loopback(&hdr->dst) &&
+	       !net_ipv4_is_addr_loopback(&hdr->src) &&
+	       /* RFC 3927 ch 2.7 */
+	       !net_ipv4_is_ll_addr(&hdr->dst) &&
+	       !net_ipv4_is_ll_addr(&hdr->src);
+}
+
+enum net_verdict net_ipv4_forward(struct net_pkt *pkt,
+				  struct net_ipv4_hdr *hdr)
+{
+	struct net_if *iface;
+
+	if (net_ipv4_is_my_addr(&hdr->dst)) {
+		return nat_reply(pkt, hdr);
+	}
+
+	if (!ipv4_can_forward(net_pkt_iface(pkt), hdr)) {
+		return NET_CONTINUE;
+	}
+
+	iface = net_if_ipv4_select_src_iface(&hdr->dst);
+	if (!iface || iface == net_pkt_iface(pkt) ||
+	    !net_if_is_up(iface)) {
+		NET_DBG("DROP: No route to %s",
+			log_strdup(net_sprint_ipv4_addr(&hdr->dst)));
+		return NET_DROP;
+	}
+
+	if (hdr->ttl <= 1U) {
+		NET_DBG("DROP: TTL expired");
+		net_icmpv4_send_error(pkt, NET_ICMPV4_TIME_EXCEEDED, 0);
+		return NET_DROP;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV4_NAT) &&
+	    net_if_flag_is_set(iface, NET_IF_IPV4_MASQUERADE) &&
+	    nat_masquerade(pkt, hdr, iface) < 0) {
+		return NET_DROP;
+	}
+
+	return ipv4_forward_send(pkt, hdr, iface);
+}
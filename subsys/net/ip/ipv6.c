@@ -652,4 +652,6 @@ void net_ipv6_init(void)
 #if defined(CONFIG_NET_IPV6_MLD)
 	net_ipv6_mld_init();
 #endif
+
+	net_ipv6_frag_init();
 }
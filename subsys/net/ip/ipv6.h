@@ -387,8 +387,28 @@ static inline void net_ipv6_nbr_set_reachable_timer(struct net_if *iface,
  * The first one being 1280 bytes and the second one 220 bytes.
  */
 #if !defined(NET_IPV6_FRAGMENTS_MAX_PKT)
+#if defined(CONFIG_NET_IPV6_FRAGMENT_MAX_PKT)
+#define NET_IPV6_FRAGMENTS_MAX_PKT CONFIG_NET_IPV6_FRAGMENT_MAX_PKT
+#else
 #define NET_IPV6_FRAGMENTS_MAX_PKT 2
 #endif
+#endif
+
+/** Pending IPv6 fragment. */
+struct net_ipv6_frag {
+	/**
+	 * Data of the fragment, without the IPv6 and fragment headers.
+	 * NULL for the first fragment, which is kept with its headers
+	 * in the pkt of the reassembly.
+	 */
+	struct net_buf *buf;
+
+	/** Offset of the data in the fragmented part of the packet */
+	uint16_t offset;
+
+	/** Length of the data */
+	uint16_t len;
+};
 
 /** Store pending IPv6 fragment information that is needed for reassembly. */
 struct net_ipv6_reassembly {
@@ -398,17 +418,35 @@ struct net_ipv6_reassembly {
 	/** IPv6 destination address of the fragment */
 	struct in6_addr dst;
 
+	/** Timeout for cancelling the reassembly. */
+	struct k_delayed_work timer;
+
+	/** Node in the list of pending or free reassemblies */
+	sys_dnode_t node;
+
+	/** First fragment, holding the unfragmentable headers */
+	struct net_pkt *pkt;
+
+	/** Pending fragments, sorted by offset */
+	struct net_ipv6_frag frag[NET_IPV6_FRAGMENTS_MAX_PKT];
+
 	/**
-	 * Timeout for cancelling the reassembly. The timer is used
-	 * also to detect if this reassembly slot is used or not.
+	 * Length of the fragmented part of the packet, known once the
+	 * last fragment is received, 0 until then.
 	 */
-	struct k_delayed_work timer;
+	uint32_t total_len;
 
-	/** Pointers to pending fragments */
-	struct net_pkt *pkt[NET_IPV6_FRAGMENTS_MAX_PKT];
+	/** Length of the data received so far */
+	uint32_t received_len;
+
+	/** Size of the network buffers held by the fragments */
+	uint32_t mem;
 
 	/** IPv6 fragment identification */
 	uint32_t id;
+
+	/** Number of pending fragments */
+	uint8_t frag_count;
 };
 
 /**
@@ -478,6 +516,11 @@ void net_ipv6_mld_init(void);
 #else
 #define net_ipv6_mld_init(...)
 #endif
+#if defined(CONFIG_NET_IPV6_FRAGMENT)
+void net_ipv6_frag_init(void);
+#else
+#define net_ipv6_frag_init(...)
+#endif
 #else
 #define net_ipv6_init(...)
 #define net_ipv6_nbr_init(...)
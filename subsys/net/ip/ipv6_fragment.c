@@ -41,11 +41,34 @@ LOG_MODULE_DECLARE(net_ipv6, CONFIG_NET_IPV6_LOG_LEVEL);
 #define FRAG_BUF_WAIT K_MSEC(10) /* how long to max wait for a buffer */
 
 static void reassembly_timeout(struct k_work *work);
-static bool reassembly_init_done;
 
 static struct net_ipv6_reassembly
 reassembly[CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT];
 
+/* The pending reassemblies are indexed by a hash of their identification
+ * and addresses. Each bucket holds the index of the first reassembly of
+ * its chain, reass_hash_next[] holds the index of the next one.
+ */
+#define REASS_HASH_SIZE CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT
+#define REASS_HASH_END 0xff
+
+static uint8_t reass_hash_head[REASS_HASH_SIZE] = {
+	[0 ... (REASS_HASH_SIZE - 1)] = REASS_HASH_END,
+};
+static uint8_t reass_hash_next[CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT];
+
+/* Pending reassemblies, least recently updated first, and free ones. */
+static sys_dlist_t reass_lru = SYS_DLIST_STATIC_INIT(&reass_lru);
+static sys_dlist_t reass_free = SYS_DLIST_STATIC_INIT(&reass_free);
+
+/* Size of the network buffers held by all the pending fragments. */
+static size_t reass_mem;
+
+/* Protects the reassemblies, which are updated by the RX threads and
+ * by the timeouts.
+ */
+static K_MUTEX_DEFINE(reass_lock);
+
 int net_ipv6_find_last_ext_hdr(struct net_pkt *pkt, uint16_t *next_hdr_off,
 			       uint16_t *last_hdr_off)
 {
@@ -120,168 +143,343 @@ fail:
 	return -EINVAL;
 }
 
-static struct net_ipv6_reassembly *reassembly_get(uint32_t id,
-						  struct in6_addr *src,
-						  struct in6_addr *dst)
+static uint8_t *reass_hash_bucket(uint32_t id, const struct in6_addr *src,
+				  const struct in6_addr *dst)
 {
-	int i, avail = -1;
+	uint32_t hash = id;
+	int i;
 
-	for (i = 0; i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
+	for (i = 0; i < 4; i++) {
+		hash = (hash ^ UNALIGNED_GET(&src->s6_addr32[i])) * 0x9e3779b1U;
+		hash = (hash ^ UNALIGNED_GET(&dst->s6_addr32[i])) * 0x9e3779b1U;
+	}
+
+	return &reass_hash_head[(hash ^ (hash >> 16)) % REASS_HASH_SIZE];
+}
+
+static void reass_hash_add(struct net_ipv6_reassembly *reass)
+{
+	uint8_t *bucket = reass_hash_bucket(reass->id, &reass->src,
+					    &reass->dst);
+	uint8_t idx = reass - reassembly;
+
+	reass_hash_next[idx] = *bucket;
+	*bucket = idx;
+}
+
+static void reass_hash_remove(struct net_ipv6_reassembly *reass)
+{
+	uint8_t *i = reass_hash_bucket(reass->id, &reass->src, &reass->dst);
+	uint8_t idx = reass - reassembly;
+
+	for (; *i != REASS_HASH_END; i = &reass_hash_next[*i]) {
+		if (*i == idx) {
+			*i = reass_hash_next[idx];
+			return;
+		}
+	}
+}
 
-		if (k_delayed_work_remaining_get(&reassembly[i].timer) &&
-		    reassembly[i].id == id &&
+static struct net_ipv6_reassembly *reassembly_find(uint32_t id,
+						   struct in6_addr *src,
+						   struct in6_addr *dst)
+{
+	uint8_t i = *reass_hash_bucket(id, src, dst);
+
+	for (; i != REASS_HASH_END; i = reass_hash_next[i]) {
+		if (reassembly[i].id == id &&
 		    net_ipv6_addr_cmp(src, &reassembly[i].src) &&
 		    net_ipv6_addr_cmp(dst, &reassembly[i].dst)) {
 			return &reassembly[i];
 		}
+	}
 
-		if (k_delayed_work_remaining_get(&reassembly[i].timer)) {
-			continue;
-		}
+	return NULL;
+}
 
-		if (avail < 0) {
-			avail = i;
+static void reassembly_info(char *str, struct net_ipv6_reassembly *reass)
+{
+	NET_DBG("%s id 0x%x src %s dst %s remain %d ms", str, reass->id,
+		log_strdup(net_sprint_ipv6_addr(&reass->src)),
+		log_strdup(net_sprint_ipv6_addr(&reass->dst)),
+		k_delayed_work_remaining_get(&reass->timer));
+}
+
+/* Free the fragments of a reassembly and put it back to the free list.
+ * Must be called with reass_lock held.
+ */
+static void reassembly_release(struct net_ipv6_reassembly *reass)
+{
+	int i;
+
+	NET_DBG("Release 0x%x", reass->id);
+
+	k_delayed_work_cancel(&reass->timer);
+
+	reass_hash_remove(reass);
+
+	sys_dlist_remove(&reass->node);
+	sys_dlist_append(&reass_free, &reass->node);
+
+	for (i = 0; i < reass->frag_count; i++) {
+		if (reass->frag[i].buf) {
+			net_buf_unref(reass->frag[i].buf);
+			reass->frag[i].buf = NULL;
 		}
 	}
 
-	if (avail < 0) {
-		return NULL;
+	if (reass->pkt) {
+		net_pkt_unref(reass->pkt);
+		reass->pkt = NULL;
 	}
 
-	k_delayed_work_submit(&reassembly[avail].timer,
-			      IPV6_REASSEMBLY_TIMEOUT);
+	reass_mem -= reass->mem;
 
-	net_ipaddr_copy(&reassembly[avail].src, src);
-	net_ipaddr_copy(&reassembly[avail].dst, dst);
-
-	reassembly[avail].id = id;
-
-	return &reassembly[avail];
+	reass->mem = 0U;
+	reass->frag_count = 0U;
+	reass->total_len = 0U;
+	reass->received_len = 0U;
+	reass->id = 0U;
 }
 
-static bool reassembly_cancel(uint32_t id,
-			      struct in6_addr *src,
-			      struct in6_addr *dst)
+/* Must be called with reass_lock held. */
+static struct net_ipv6_reassembly *reassembly_alloc(uint32_t id,
+						    struct in6_addr *src,
+						    struct in6_addr *dst)
 {
-	int i, j;
+	struct net_ipv6_reassembly *reass;
+	sys_dnode_t *node;
 
-	NET_DBG("Cancel 0x%x", id);
+	node = sys_dlist_peek_head(&reass_free);
+	if (!node) {
+		/* Make room by discarding the least recently updated
+		 * reassembly, which is the least likely to complete.
+		 */
+		reass = CONTAINER_OF(sys_dlist_peek_head(&reass_lru),
+				     struct net_ipv6_reassembly, node);
 
-	for (i = 0; i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
-		int32_t remaining;
+		reassembly_info("Reassembly evicted", reass);
+		reassembly_release(reass);
 
-		if (reassembly[i].id != id ||
-		    !net_ipv6_addr_cmp(src, &reassembly[i].src) ||
-		    !net_ipv6_addr_cmp(dst, &reassembly[i].dst)) {
-			continue;
-		}
+		node = sys_dlist_peek_head(&reass_free);
+	}
 
-		remaining = k_delayed_work_remaining_get(&reassembly[i].timer);
-		if (remaining) {
-			k_delayed_work_cancel(&reassembly[i].timer);
-		}
+	reass = CONTAINER_OF(node, struct net_ipv6_reassembly, node);
 
-		NET_DBG("IPv6 reassembly id 0x%x remaining %d ms",
-			reassembly[i].id, remaining);
+	sys_dlist_remove(&reass->node);
+	sys_dlist_append(&reass_lru, &reass->node);
 
-		reassembly[i].id = 0U;
+	net_ipaddr_copy(&reass->src, src);
+	net_ipaddr_copy(&reass->dst, dst);
+	reass->id = id;
 
-		for (j = 0; j < NET_IPV6_FRAGMENTS_MAX_PKT; j++) {
-			if (!reassembly[i].pkt[j]) {
-				continue;
-			}
+	reass_hash_add(reass);
 
-			NET_DBG("[%d] IPv6 reassembly pkt %p %zd bytes data",
-				j, reassembly[i].pkt[j],
-				net_pkt_get_len(reassembly[i].pkt[j]));
+	k_delayed_work_submit(&reass->timer, IPV6_REASSEMBLY_TIMEOUT);
 
-			net_pkt_unref(reassembly[i].pkt[j]);
-			reassembly[i].pkt[j] = NULL;
-		}
+	return reass;
+}
+
+static void reassembly_timeout(struct k_work *work)
+{
+	struct net_ipv6_reassembly *reass =
+		CONTAINER_OF(work, struct net_ipv6_reassembly, timer);
+
+	k_mutex_lock(&reass_lock, K_FOREVER);
 
-		return true;
+	/* The reassembly might have been completed, discarded or reused
+	 * while we were waiting for the lock.
+	 */
+	if (reass->frag_count &&
+	    !k_delayed_work_remaining_get(&reass->timer)) {
+		reassembly_info("Reassembly cancelled", reass);
+		reassembly_release(reass);
 	}
 
-	return false;
+	k_mutex_unlock(&reass_lock);
 }
 
-static void reassembly_info(char *str, struct net_ipv6_reassembly *reass)
+static size_t buf_mem(struct net_buf *buf)
 {
-	NET_DBG("%s id 0x%x src %s dst %s remain %d ms", str, reass->id,
-		log_strdup(net_sprint_ipv6_addr(&reass->src)),
-		log_strdup(net_sprint_ipv6_addr(&reass->dst)),
-		k_delayed_work_remaining_get(&reass->timer));
+	size_t mem = 0;
+
+	for (; buf; buf = buf->frags) {
+		mem += buf->size;
+	}
+
+	return mem;
 }
 
-static void reassembly_timeout(struct k_work *work)
+/* Remove len bytes of headers from the start of a buffer chain. The data
+ * is not moved, the buffers which only hold headers are freed.
+ */
+static struct net_buf *buf_pull_headers(struct net_buf *buf, size_t len)
 {
-	struct net_ipv6_reassembly *reass =
-		CONTAINER_OF(work, struct net_ipv6_reassembly, timer);
+	while (buf && len >= buf->len) {
+		len -= buf->len;
+		buf = net_buf_frag_del(NULL, buf);
+	}
 
-	reassembly_info("Reassembly cancelled", reass);
+	if (buf) {
+		net_buf_pull(buf, len);
+	}
 
-	reassembly_cancel(reass->id, &reass->src, &reass->dst);
+	return buf;
 }
 
-static void reassemble_packet(struct net_ipv6_reassembly *reass)
+/* Store a fragment in the reassembly, sorted by offset. Returns 0 if the
+ * fragment was stored, in which case the reassembly owns the pkt,
+ * -EALREADY if it duplicates a stored fragment, -ENOMEM if there is no
+ * room left for it and -EINVAL if it overlaps another fragment or does
+ * not match the length of the packet. Overlapping fragments make the
+ * whole packet invalid (RFC 5722).
+ */
+static int fragment_insert(struct net_ipv6_reassembly *reass,
+			   struct net_pkt *pkt, uint16_t offset, uint16_t len,
+			   bool more)
 {
-	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv6_access, struct net_ipv6_hdr);
-	NET_PKT_DATA_ACCESS_DEFINE(frag_access, struct net_ipv6_frag_hdr);
-	union {
-		struct net_ipv6_hdr *hdr;
-		struct net_ipv6_frag_hdr *frag_hdr;
-	} ipv6;
+	uint32_t end = offset + len;
+	struct net_ipv6_frag *frag;
+	struct net_buf *buf = NULL;
+	size_t mem;
+	int i;
 
-	struct net_pkt *pkt;
-	struct net_buf *last;
-	uint8_t next_hdr;
-	int i, len;
+	for (i = 0; i < reass->frag_count; i++) {
+		if (reass->frag[i].offset >= offset) {
+			break;
+		}
+	}
 
-	k_delayed_work_cancel(&reass->timer);
+	if (i < reass->frag_count && reass->frag[i].offset == offset &&
+	    reass->frag[i].len == len) {
+		return -EALREADY;
+	}
 
-	NET_ASSERT(reass->pkt[0]);
+	if ((i > 0 &&
+	     reass->frag[i - 1].offset + reass->frag[i - 1].len > offset) ||
+	    (i < reass->frag_count && end > reass->frag[i].offset)) {
+		return -EINVAL;
+	}
 
-	last = net_buf_frag_last(reass->pkt[0]->buffer);
+	if ((reass->total_len && end > reass->total_len) ||
+	    (!more && (i < reass->frag_count ||
+		       (reass->total_len && end != reass->total_len)))) {
+		return -EINVAL;
+	}
 
-	/* We start from 2nd packet which is then appended to
-	 * the first one.
-	 */
-	for (i = 1; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		int removed_len;
+	if (reass->frag_count == NET_IPV6_FRAGMENTS_MAX_PKT) {
+		return -ENOMEM;
+	}
 
-		pkt = reass->pkt[i];
+	if (offset) {
+		/* Keep only the data of the fragment, the headers are
+		 * taken from the first one.
+		 */
+		buf = buf_pull_headers(pkt->buffer,
+				       net_pkt_ipv6_fragment_start(pkt) +
+				       sizeof(struct net_ipv6_frag_hdr));
+		pkt->buffer = NULL;
 
-		net_pkt_cursor_init(pkt);
+		if (!buf) {
+			/* Cannot happen as the length was checked. */
+			return -EINVAL;
+		}
 
-		/* Get rid of IPv6 and fragment header which are at
-		 * the beginning of the fragment.
-		 */
-		removed_len = net_pkt_ipv6_fragment_start(pkt) +
-			      sizeof(struct net_ipv6_frag_hdr);
+		net_pkt_unref(pkt);
 
-		NET_DBG("Removing %d bytes from start of pkt %p",
-			removed_len, pkt->buffer);
+		mem = buf_mem(buf);
+	} else {
+		reass->pkt = pkt;
+		mem = buf_mem(pkt->buffer);
+	}
 
-		if (net_pkt_pull(pkt, removed_len)) {
-			NET_ERR("Failed to pull headers");
-			reassembly_cancel(reass->id, &reass->src, &reass->dst);
-			return;
+	memmove(&reass->frag[i + 1], &reass->frag[i],
+		(reass->frag_count - i) * sizeof(reass->frag[0]));
+
+	frag = &reass->frag[i];
+	frag->buf = buf;
+	frag->offset = offset;
+	frag->len = len;
+
+	reass->frag_count++;
+	reass->received_len += len;
+	reass->mem += mem;
+	reass_mem += mem;
+
+	if (!more) {
+		reass->total_len = end;
+	}
+
+	NET_DBG("Storing fragment %d/%d offset %u len %u of 0x%x", i,
+		reass->frag_count, offset, len, reass->id);
+
+	return 0;
+}
+
+/* Discard reassemblies, least recently updated first, until the pending
+ * fragments fit in the memory budget. Returns false if the current
+ * reassembly had to be discarded too.
+ */
+static bool reassembly_fit_memory(struct net_ipv6_reassembly *reass)
+{
+	struct net_ipv6_reassembly *lru;
+
+	while (CONFIG_NET_IPV6_FRAGMENT_MEMORY > 0 &&
+	       reass_mem > CONFIG_NET_IPV6_FRAGMENT_MEMORY) {
+		lru = CONTAINER_OF(sys_dlist_peek_head(&reass_lru),
+				   struct net_ipv6_reassembly, node);
+
+		reassembly_info("Reassembly over memory limit", lru);
+		reassembly_release(lru);
+
+		if (lru == reass) {
+			return false;
 		}
+	}
 
-		/* Attach the data to previous pkt */
-		last->frags = pkt->buffer;
-		last = net_buf_frag_last(pkt->buffer);
+	return true;
+}
 
-		pkt->buffer = NULL;
-		reass->pkt[i] = NULL;
+/* Chain the data of all the fragments to the first one, which is returned.
+ * Must be called with reass_lock held.
+ */
+static struct net_pkt *reassembly_detach(struct net_ipv6_reassembly *reass)
+{
+	struct net_pkt *pkt = reass->pkt;
+	struct net_buf *last;
+	int i;
 
-		net_pkt_unref(pkt);
+	NET_ASSERT(pkt && reass->frag[0].offset == 0U);
+
+	last = net_buf_frag_last(pkt->buffer);
+
+	for (i = 1; i < reass->frag_count; i++) {
+		last->frags = reass->frag[i].buf;
+		last = net_buf_frag_last(reass->frag[i].buf);
+
+		reass->frag[i].buf = NULL;
 	}
 
-	pkt = reass->pkt[0];
-	reass->pkt[0] = NULL;
+	reass->pkt = NULL;
+
+	reassembly_release(reass);
 
-	/* Next we need to strip away the fragment header from the first packet
+	return pkt;
+}
+
+static void reassemble_packet(struct net_pkt *pkt)
+{
+	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv6_access, struct net_ipv6_hdr);
+	NET_PKT_DATA_ACCESS_DEFINE(frag_access, struct net_ipv6_frag_hdr);
+	union {
+		struct net_ipv6_hdr *hdr;
+		struct net_ipv6_frag_hdr *frag_hdr;
+	} ipv6;
+
+	uint8_t next_hdr;
+	int len;
+
+	/* We need to strip away the fragment header from the first packet
 	 * and set the various pointers and values in packet.
 	 */
 	net_pkt_cursor_init(pkt);
@@ -350,102 +548,28 @@ error:
 
 void net_ipv6_frag_foreach(net_ipv6_frag_cb_t cb, void *user_data)
 {
-	int i;
+	struct net_ipv6_reassembly *reass;
 
-	for (i = 0; reassembly_init_done &&
-		     i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
-		if (!k_delayed_work_remaining_get(&reassembly[i].timer)) {
-			continue;
-		}
+	k_mutex_lock(&reass_lock, K_FOREVER);
 
-		cb(&reassembly[i], user_data);
+	SYS_DLIST_FOR_EACH_CONTAINER(&reass_lru, reass, node) {
+		cb(reass, user_data);
 	}
-}
 
-/* Verify that we have all the fragments received and in correct order.
- */
-static bool fragment_verify(struct net_ipv6_reassembly *reass)
-{
-	uint16_t offset;
-	int i, prev_len;
-
-	prev_len = net_pkt_get_len(reass->pkt[0]);
-	offset = net_pkt_ipv6_fragment_offset(reass->pkt[0]);
-
-	NET_DBG("pkt %p offset %u", reass->pkt[0], offset);
-
-	if (offset != 0U) {
-		return false;
-	}
-
-	for (i = 1; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		offset = net_pkt_ipv6_fragment_offset(reass->pkt[i]);
-
-		NET_DBG("pkt %p offset %u prev_len %d", reass->pkt[i],
-			offset, prev_len);
-
-		if (prev_len < offset) {
-			/* Something wrong with the offset value */
-			return false;
-		}
-
-		prev_len = net_pkt_get_len(reass->pkt[i]);
-	}
-
-	return true;
-}
-
-static int shift_packets(struct net_ipv6_reassembly *reass, int pos)
-{
-	int i;
-
-	for (i = pos + 1; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		if (!reass->pkt[i]) {
-			NET_DBG("Moving [%d] %p (offset 0x%x) to [%d]",
-				pos, reass->pkt[pos],
-				net_pkt_ipv6_fragment_offset(reass->pkt[pos]),
-				i);
-
-			/* Do we have enough space in packet array to make
-			 * the move?
-			 */
-			if (((i - pos) + 1) >
-			    (NET_IPV6_FRAGMENTS_MAX_PKT - i)) {
-				return -ENOMEM;
-			}
-
-			memmove(&reass->pkt[i], &reass->pkt[pos],
-				sizeof(void *) * (i - pos));
-
-			return 0;
-		}
-	}
-
-	return -EINVAL;
+	k_mutex_unlock(&reass_lock);
 }
 
 enum net_verdict net_ipv6_handle_fragment_hdr(struct net_pkt *pkt,
 					      struct net_ipv6_hdr *hdr,
 					      uint8_t nexthdr)
 {
-	struct net_ipv6_reassembly *reass = NULL;
-	uint16_t flag;
-	bool found;
-	uint8_t more;
+	struct net_ipv6_reassembly *reass;
+	struct net_pkt *reassembled = NULL;
+	uint16_t flag, offset;
+	size_t len;
 	uint32_t id;
-	int i;
-
-	if (!reassembly_init_done) {
-		/* Static initializing does not work here because of the array
-		 * so we must do it at runtime.
-		 */
-		for (i = 0; i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
-			k_delayed_work_init(&reassembly[i].timer,
-					    reassembly_timeout);
-		}
-
-		reassembly_init_done = true;
-	}
+	bool more;
+	int ret;
 
 	/* Each fragment has a fragment header, however since we already
 	 * read the nexthdr part of it, we are not going to use
@@ -455,109 +579,85 @@ enum net_verdict net_ipv6_handle_fragment_hdr(struct net_pkt *pkt,
 	if (net_pkt_skip(pkt, 1) || /* reserved */
 	    net_pkt_read_be16(pkt, &flag) ||
 	    net_pkt_read_be32(pkt, &id)) {
-		goto drop;
+		return NET_DROP;
 	}
 
-	reass = reassembly_get(id, &hdr->src, &hdr->dst);
-	if (!reass) {
-		NET_DBG("Cannot get reassembly slot, dropping pkt %p", pkt);
-		goto drop;
+	more = flag & 0x01;
+	offset = flag & 0xfff8;
+	len = net_pkt_get_len(pkt) - net_pkt_ipv6_fragment_start(pkt) -
+	      sizeof(struct net_ipv6_frag_hdr);
+
+	if (more && len % 8) {
+		/* Fragment length is not multiple of 8, discard
+		 * the packet and send parameter problem error.
+		 */
+		net_icmpv6_send_error(pkt, NET_ICMPV6_PARAM_PROBLEM,
+				      NET_ICMPV6_PARAM_PROB_OPTION, 0);
+		return NET_DROP;
 	}
 
-	more = flag & 0x01;
-	net_pkt_set_ipv6_fragment_offset(pkt, flag & 0xfff8);
+	if (!len || offset + len > UINT16_MAX) {
+		NET_DBG("Invalid fragment offset %u len %zu, dropping pkt %p",
+			offset, len, pkt);
+		return NET_DROP;
+	}
 
-	if (!reass->pkt[0]) {
-		NET_DBG("Storing pkt %p to slot %d offset %d",
-			pkt, 0, net_pkt_ipv6_fragment_offset(pkt));
-		reass->pkt[0] = pkt;
+	net_pkt_set_ipv6_fragment_offset(pkt, offset);
 
-		reassembly_info("Reassembly 1st pkt", reass);
+	k_mutex_lock(&reass_lock, K_FOREVER);
 
-		/* Wait for more fragments to receive. */
-		goto accept;
+	reass = reassembly_find(id, &hdr->src, &hdr->dst);
+	if (reass) {
+		sys_dlist_remove(&reass->node);
+		sys_dlist_append(&reass_lru, &reass->node);
+	} else {
+		reass = reassembly_alloc(id, &hdr->src, &hdr->dst);
 	}
 
-	/* The fragments might come in wrong order so place them
-	 * in reassembly chain in correct order.
-	 */
-	for (i = 0, found = false; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		if (reass->pkt[i]) {
-			if (net_pkt_ipv6_fragment_offset(reass->pkt[i]) <
-			    net_pkt_ipv6_fragment_offset(pkt)) {
-				continue;
-			}
+	ret = fragment_insert(reass, pkt, offset, len, more);
+	if (ret < 0) {
+		NET_DBG("Cannot store fragment offset %u of 0x%x (%d)",
+			offset, id, ret);
 
-			/* Make room for this fragment. If there is no room,
-			 * then it will discard the whole reassembly.
-			 */
-			if (shift_packets(reass, i)) {
-				break;
-			}
+		if (ret != -EALREADY) {
+			/* We must discard the whole packet at this point. */
+			reassembly_release(reass);
 		}
 
-		NET_DBG("Storing pkt %p to slot %d offset %d",
-			pkt, i, net_pkt_ipv6_fragment_offset(pkt));
-		reass->pkt[i] = pkt;
-		found = true;
-
-		break;
+		k_mutex_unlock(&reass_lock);
+		return NET_DROP;
 	}
 
-	if (!found) {
-		/* We could not add this fragment into our saved fragment
-		 * list. We must discard the whole packet at this point.
-		 */
-		NET_DBG("No slots available for 0x%x", reass->id);
-		net_pkt_unref(pkt);
-		goto drop;
+	if (!reassembly_fit_memory(reass)) {
+		goto out;
 	}
 
-	if (more) {
-		if (net_pkt_get_len(pkt) % 8) {
-			/* Fragment length is not multiple of 8, discard
-			 * the packet and send parameter problem error.
-			 */
-			net_icmpv6_send_error(pkt, NET_ICMPV6_PARAM_PROBLEM,
-					      NET_ICMPV6_PARAM_PROB_OPTION, 0);
-			goto drop;
-		}
-
+	if (reass->total_len && reass->received_len == reass->total_len) {
+		/* All the fragments received, as they do not overlap */
+		reassembly_info("Reassembly last pkt", reass);
+		reassembled = reassembly_detach(reass);
+	} else {
 		reassembly_info("Reassembly nth pkt", reass);
-
-		NET_DBG("More fragments to be received");
-		goto accept;
 	}
 
-	reassembly_info("Reassembly last pkt", reass);
-
-	if (!fragment_verify(reass)) {
-		NET_DBG("Reassembled IPv6 verify failed, dropping id %u",
-			reass->id);
-
-		/* Let the caller release the already inserted pkt */
-		if (i < NET_IPV6_FRAGMENTS_MAX_PKT) {
-			reass->pkt[i] = NULL;
-		}
+out:
+	k_mutex_unlock(&reass_lock);
 
-		net_pkt_unref(pkt);
-		goto drop;
+	if (reassembled) {
+		reassemble_packet(reassembled);
 	}
 
-	/* The last fragment received, reassemble the packet */
-	reassemble_packet(reass);
-
-accept:
 	return NET_OK;
+}
 
-drop:
-	if (reass) {
-		if (reassembly_cancel(reass->id, &reass->src, &reass->dst)) {
-			return NET_OK;
-		}
-	}
+void net_ipv6_frag_init(void)
+{
+	int i;
 
-	return NET_DROP;
+	for (i = 0; i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
+		k_delayed_work_init(&reassembly[i].timer, reassembly_timeout);
+		sys_dlist_append(&reass_free, &reassembly[i].node);
+	}
 }
 
 #define BUF_ALLOC_TIMEOUT K_MSEC(100)
@@ -654,6 +754,54 @@ fail:
 	return ret;
 }
 
+/* The upper layer checksum covers the whole datagram, so a device that
+ * offloads it cannot insert it into the fragments. Compute it here before
+ * the datagram is split.
+ */
+static int set_upper_layer_chksum(struct net_pkt *pkt, uint8_t proto)
+{
+	size_t offset = net_pkt_ip_hdr_len(pkt) + net_pkt_ipv6_ext_len(pkt);
+	uint16_t chksum = 0U;
+	int ret = 0;
+	bool ow;
+
+	if (proto == IPPROTO_UDP) {
+		offset += offsetof(struct net_udp_hdr, chksum);
+	} else if (proto == IPPROTO_TCP) {
+		offset += offsetof(struct net_tcp_hdr, chksum);
+	} else {
+		return 0;
+	}
+
+	ow = net_pkt_is_being_overwritten(pkt);
+	net_pkt_set_overwrite(pkt, true);
+
+	/* The checksum field must be zero while the sum is computed */
+	net_pkt_cursor_init(pkt);
+	if (net_pkt_skip(pkt, offset) ||
+	    net_pkt_write(pkt, &chksum, sizeof(chksum))) {
+		ret = -ENOBUFS;
+		goto out;
+	}
+
+	if (proto == IPPROTO_UDP) {
+		chksum = net_calc_chksum_udp(pkt);
+	} else {
+		chksum = net_calc_chksum_tcp(pkt);
+	}
+
+	net_pkt_cursor_init(pkt);
+	if (net_pkt_skip(pkt, offset) ||
+	    net_pkt_write(pkt, &chksum, sizeof(chksum))) {
+		ret = -ENOBUFS;
+	}
+
+out:
+	net_pkt_set_overwrite(pkt, ow);
+
+	return ret;
+}
+
 int net_ipv6_send_fragmented_pkt(struct net_if *iface, struct net_pkt *pkt,
 				 uint16_t pkt_len)
 {
@@ -682,6 +830,13 @@ int net_ipv6_send_fragmented_pkt(struct net_if *iface, struct net_pkt *pkt,
 		return -ENOBUFS;
 	}
 
+	if (!net_if_need_calc_tx_checksum(iface)) {
+		ret = set_upper_layer_chksum(pkt, next_hdr);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
 	/* The Maximum payload can fit into each packet after IPv6 header,
 	 * Extenstion headers and Fragmentation header.
 	 */
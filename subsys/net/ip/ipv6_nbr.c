@@ -80,6 +80,9 @@ static void ipv6_nd_restart_reachable_timer(struct net_nbr *nbr, int64_t time);
 #define DELAY_FIRST_PROBE_TIME (5 * MSEC_PER_SEC)
 #define RETRANS_TIMER 1000 /* ms */
 
+/* Neighbor timers expiring within this time are handled together */
+#define REACHABLE_TIMER_SLACK 50 /* ms */
+
 extern void net_neighbor_data_remove(struct net_nbr *nbr);
 extern void net_neighbor_table_clear(struct net_nbr_table *table);
 
@@ -122,6 +125,63 @@ static inline struct net_nbr *get_nbr(int idx)
 	return &net_neighbor_pool[idx].nbr;
 }
 
+/* The neighbors are also indexed by a hash of their IPv6 address, as one
+ * of them is looked up for every sent packet. A bucket holds the index of
+ * its first neighbor and every neighbor holds the index of the next one,
+ * NBR_HASH_END ending the chain.
+ */
+#define NBR_HASH_SIZE CONFIG_NET_IPV6_MAX_NEIGHBORS
+#define NBR_HASH_END 0xff
+
+static uint8_t nbr_hash_head[NBR_HASH_SIZE] = {
+	[0 ... (NBR_HASH_SIZE - 1)] = NBR_HASH_END,
+};
+static uint8_t nbr_hash_next[CONFIG_NET_IPV6_MAX_NEIGHBORS];
+
+static inline uint8_t get_nbr_index(struct net_nbr *nbr)
+{
+	return ((uint8_t *)nbr - (uint8_t *)net_neighbor_pool) /
+		sizeof(net_neighbor_pool[0]);
+}
+
+static uint8_t *nbr_hash_bucket(const struct in6_addr *addr)
+{
+	uint32_t hash = 0U;
+	int i;
+
+	/* The address is often in a packet header, so it might not be
+	 * aligned.
+	 */
+	for (i = 0; i < ARRAY_SIZE(addr->s6_addr32); i++) {
+		hash = (hash ^ UNALIGNED_GET(&addr->s6_addr32[i])) *
+		       0x9e3779b1U;
+	}
+
+	return &nbr_hash_head[(hash ^ (hash >> 16)) % NBR_HASH_SIZE];
+}
+
+static void nbr_hash_add(struct net_nbr *nbr)
+{
+	uint8_t *bucket = nbr_hash_bucket(&net_ipv6_nbr_data(nbr)->addr);
+	uint8_t idx = get_nbr_index(nbr);
+
+	nbr_hash_next[idx] = *bucket;
+	*bucket = idx;
+}
+
+static void nbr_hash_remove(struct net_nbr *nbr)
+{
+	uint8_t *i = nbr_hash_bucket(&net_ipv6_nbr_data(nbr)->addr);
+	uint8_t idx = get_nbr_index(nbr);
+
+	for (; *i != NBR_HASH_END; i = &nbr_hash_next[*i]) {
+		if (*i == idx) {
+			*i = nbr_hash_next[idx];
+			break;
+		}
+	}
+}
+
 static inline struct net_nbr *get_nbr_from_data(struct net_ipv6_nbr_data *data)
 {
 	int i;
@@ -259,9 +319,9 @@ static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
 				  struct net_if *iface,
 				  const struct in6_addr *addr)
 {
-	int i;
+	uint8_t i = *nbr_hash_bucket(addr);
 
-	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
+	for (; i != NBR_HASH_END; i = nbr_hash_next[i]) {
 		struct net_nbr *nbr = get_nbr(i);
 
 		if (!nbr->ref) {
@@ -338,6 +398,7 @@ bool net_ipv6_nbr_rm(struct net_if *iface, struct in6_addr *addr)
 static void ipv6_ns_reply_timeout(struct k_work *work)
 {
 	int64_t current = k_uptime_get();
+	int64_t next = INT64_MAX;
 	struct net_nbr *nbr = NULL;
 	struct net_ipv6_nbr_data *data;
 	int i;
@@ -363,13 +424,8 @@ static void ipv6_ns_reply_timeout(struct k_work *work)
 
 		remaining = data->send_ns + NS_REPLY_TIMEOUT - current;
 
-		if (remaining > 0) {
-			if (!k_delayed_work_remaining_get(
-						&ipv6_ns_reply_timer)) {
-				k_delayed_work_submit(&ipv6_ns_reply_timer,
-						      K_MSEC(remaining));
-			}
-
+		if (remaining > REACHABLE_TIMER_SLACK) {
+			next = MIN(next, remaining);
 			continue;
 		}
 
@@ -398,6 +454,16 @@ static void ipv6_ns_reply_timeout(struct k_work *work)
 
 		net_nbr_unref(nbr);
 	}
+
+	if (next != INT64_MAX) {
+		int32_t pending;
+
+		pending = k_delayed_work_remaining_get(&ipv6_ns_reply_timer);
+		if (!pending || pending > next) {
+			k_delayed_work_submit(&ipv6_ns_reply_timer,
+					      K_MSEC(next));
+		}
+	}
 }
 
 static void nbr_init(struct net_nbr *nbr, struct net_if *iface,
@@ -417,6 +483,8 @@ static void nbr_init(struct net_nbr *nbr, struct net_if *iface,
 	net_ipv6_nbr_data(nbr)->reachable = 0;
 	net_ipv6_nbr_data(nbr)->reachable_timeout = 0;
 #endif
+
+	nbr_hash_add(nbr);
 }
 
 static struct net_nbr *nbr_new(struct net_if *iface,
@@ -610,8 +678,8 @@ struct net_nbr *net_ipv6_nbr_add(struct net_if *iface,
 		if (memcmp(cached_lladdr->addr, lladdr->addr, lladdr->len)) {
 			dbg_update_neighbor_lladdr(lladdr, cached_lladdr, addr);
 
-			net_linkaddr_set(cached_lladdr, lladdr->addr,
-					 lladdr->len);
+			net_nbr_set_lladdr(nbr->idx, lladdr->addr,
+					   lladdr->len);
 
 			ipv6_nbr_set_state(nbr, NET_IPV6_NBR_STATE_STALE);
 		} else if (net_ipv6_nbr_data(nbr)->state ==
@@ -653,7 +721,7 @@ void net_neighbor_data_remove(struct net_nbr *nbr)
 {
 	NET_DBG("Neighbor %p removed", nbr);
 
-	return;
+	nbr_hash_remove(nbr);
 }
 
 void net_neighbor_table_clear(struct net_nbr_table *table)
@@ -787,9 +855,10 @@ enum net_verdict net_ipv6_prepare_for_send(struct net_pkt *pkt)
 
 #if defined(CONFIG_NET_IPV6_FRAGMENT)
 	/* If we have already fragmented the packet, the fragment id will
-	 * contain a proper value and we can skip other checks.
+	 * contain a proper value and we can skip other checks. Oversized
+	 * TCP segments are split by the L2 or by the device instead.
 	 */
-	if (net_pkt_ipv6_fragment_id(pkt) == 0U) {
+	if (net_pkt_ipv6_fragment_id(pkt) == 0U && !net_pkt_gso_size(pkt)) {
 		uint16_t mtu = net_if_get_mtu(net_pkt_iface(pkt));
 		size_t pkt_len = net_pkt_get_len(pkt);
 
@@ -1411,6 +1480,7 @@ static void ipv6_nd_restart_reachable_timer(struct net_nbr *nbr, int64_t time)
 static void ipv6_nd_reachable_timeout(struct k_work *work)
 {
 	int64_t current = k_uptime_get();
+	int64_t next = INT64_MAX;
 	struct net_nbr *nbr = NULL;
 	struct net_ipv6_nbr_data *data = NULL;
 	int ret;
@@ -1433,9 +1503,13 @@ static void ipv6_nd_reachable_timeout(struct k_work *work)
 			continue;
 		}
 
+		/* The timers that expire soon are handled now, so that
+		 * the table is scanned once for a batch of neighbors and
+		 * not once per neighbor.
+		 */
 		remaining = data->reachable + data->reachable_timeout - current;
-		if (remaining > 0) {
-			ipv6_nd_restart_reachable_timer(NULL, remaining);
+		if (remaining > REACHABLE_TIMER_SLACK) {
+			next = MIN(next, remaining);
 			continue;
 		}
 
@@ -1514,6 +1588,10 @@ static void ipv6_nd_reachable_timeout(struct k_work *work)
 			break;
 		}
 	}
+
+	if (next != INT64_MAX) {
+		ipv6_nd_restart_reachable_timer(NULL, next);
+	}
 }
 
 void net_ipv6_nbr_set_reachable_timer(struct net_if *iface,
@@ -1613,8 +1691,8 @@ static inline bool handle_na_neighbor(struct net_pkt *pkt,
 						       cached_lladdr,
 						       &na_hdr->tgt);
 
-			net_linkaddr_set(cached_lladdr, lladdr.addr,
-					 cached_lladdr->len);
+			net_nbr_set_lladdr(nbr->idx, lladdr.addr,
+					   cached_lladdr->len);
 		}
 
 		if (na_hdr->flags & NET_ICMPV6_NA_FLAG_SOLICITED) {
@@ -1657,8 +1735,8 @@ static inline bool handle_na_neighbor(struct net_pkt *pkt,
 			dbg_update_neighbor_lladdr_raw(
 				lladdr.addr, cached_lladdr, &na_hdr->tgt);
 
-			net_linkaddr_set(cached_lladdr, lladdr.addr,
-					 cached_lladdr->len);
+			net_nbr_set_lladdr(nbr->idx, lladdr.addr,
+					   cached_lladdr->len);
 		}
 
 		if (na_hdr->flags & NET_ICMPV6_NA_FLAG_SOLICITED) {
@@ -19,6 +19,72 @@ LOG_MODULE_REGISTER(net_nbr, CONFIG_NET_IPV6_NBR_CACHE_LOG_LEVEL);
 
 NET_NBR_LLADDR_INIT(net_neighbor_lladdr, CONFIG_NET_IPV6_MAX_NEIGHBORS);
 
+/* The link layer addresses are also indexed by a hash, so that linking a
+ * neighbor does not compare against every known address. A bucket holds
+ * the lladdr index of its first entry and every entry holds the index of
+ * the next one, NET_NBR_LLADDR_UNKNOWN ending the chain.
+ */
+#define LLADDR_HASH_SIZE CONFIG_NET_IPV6_MAX_NEIGHBORS
+
+static uint8_t lladdr_hash_head[LLADDR_HASH_SIZE] = {
+	[0 ... (LLADDR_HASH_SIZE - 1)] = NET_NBR_LLADDR_UNKNOWN,
+};
+static uint8_t lladdr_hash_next[CONFIG_NET_IPV6_MAX_NEIGHBORS];
+
+static uint8_t lladdr_hash(const uint8_t *addr, uint8_t len)
+{
+	uint32_t hash = len;
+
+	while (len--) {
+		hash = (hash ^ *addr++) * 0x9e3779b1U;
+	}
+
+	return (hash ^ (hash >> 16)) % LLADDR_HASH_SIZE;
+}
+
+static int lladdr_find(const struct net_linkaddr *lladdr)
+{
+	uint8_t i = lladdr_hash_head[lladdr_hash(lladdr->addr, lladdr->len)];
+
+	for (; i != NET_NBR_LLADDR_UNKNOWN; i = lladdr_hash_next[i]) {
+		if (net_neighbor_lladdr[i].ref &&
+		    net_neighbor_lladdr[i].lladdr.len == lladdr->len &&
+		    !memcmp(net_neighbor_lladdr[i].lladdr.addr, lladdr->addr,
+			    lladdr->len)) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static inline uint8_t *lladdr_hash_bucket(uint8_t idx)
+{
+	struct net_linkaddr_storage *lladdr = &net_neighbor_lladdr[idx].lladdr;
+
+	return &lladdr_hash_head[lladdr_hash(lladdr->addr, lladdr->len)];
+}
+
+static void lladdr_hash_add(uint8_t idx)
+{
+	uint8_t *bucket = lladdr_hash_bucket(idx);
+
+	lladdr_hash_next[idx] = *bucket;
+	*bucket = idx;
+}
+
+static void lladdr_hash_remove(uint8_t idx)
+{
+	uint8_t *i = lladdr_hash_bucket(idx);
+
+	for (; *i != NET_NBR_LLADDR_UNKNOWN; i = &lladdr_hash_next[*i]) {
+		if (*i == idx) {
+			*i = lladdr_hash_next[idx];
+			break;
+		}
+	}
+}
+
 #if defined(CONFIG_NET_IPV6_NBR_CACHE_LOG_LEVEL_DBG)
 void net_nbr_unref_debug(struct net_nbr *nbr, const char *caller, int line)
 #define net_nbr_unref(nbr) net_nbr_unref_debug(nbr, __func__, __LINE__)
@@ -92,24 +158,23 @@ int net_nbr_link(struct net_nbr *nbr, struct net_if *iface,
 		return -EALREADY;
 	}
 
-	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
-		if (avail < 0 && !net_neighbor_lladdr[i].ref) {
-			avail = i;
-		}
+	i = lladdr_find(lladdr);
+	if (i >= 0) {
+		/* We found same lladdr in nbr cache so just
+		 * increase the ref count.
+		 */
+		net_neighbor_lladdr[i].ref++;
 
-		if (net_neighbor_lladdr[i].ref &&
-		    !memcmp(lladdr->addr,
-			    net_neighbor_lladdr[i].lladdr.addr,
-			    lladdr->len)) {
-			/* We found same lladdr in nbr cache so just
-			 * increase the ref count.
-			 */
-			net_neighbor_lladdr[i].ref++;
+		nbr->idx = i;
+		nbr->iface = iface;
 
-			nbr->idx = i;
-			nbr->iface = iface;
+		return 0;
+	}
 
-			return 0;
+	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
+		if (!net_neighbor_lladdr[i].ref) {
+			avail = i;
+			break;
 		}
 	}
 
@@ -128,6 +193,8 @@ int net_nbr_link(struct net_nbr *nbr, struct net_if *iface,
 	net_neighbor_lladdr[avail].lladdr.len = lladdr->len;
 	net_neighbor_lladdr[avail].lladdr.type = lladdr->type;
 
+	lladdr_hash_add(avail);
+
 	nbr->iface = iface;
 
 	return 0;
@@ -147,6 +214,8 @@ int net_nbr_unlink(struct net_nbr *nbr, struct net_linkaddr *lladdr)
 	net_neighbor_lladdr[nbr->idx].ref--;
 
 	if (!net_neighbor_lladdr[nbr->idx].ref) {
+		lladdr_hash_remove(nbr->idx);
+
 		(void)memset(net_neighbor_lladdr[nbr->idx].lladdr.addr, 0,
 			     sizeof(net_neighbor_lladdr[nbr->idx].lladdr.addr));
 	}
@@ -161,15 +230,17 @@ struct net_nbr *net_nbr_lookup(struct net_nbr_table *table,
 			       struct net_if *iface,
 			       struct net_linkaddr *lladdr)
 {
-	int i;
+	int i, idx;
+
+	idx = lladdr_find(lladdr);
+	if (idx < 0) {
+		return NULL;
+	}
 
 	for (i = 0; i < table->nbr_count; i++) {
 		struct net_nbr *nbr = get_nbr(table->nbr, i);
 
-		if (nbr->ref && nbr->iface == iface &&
-		    net_neighbor_lladdr[nbr->idx].ref &&
-		    !memcmp(net_neighbor_lladdr[nbr->idx].lladdr.addr,
-			    lladdr->addr, lladdr->len)) {
+		if (nbr->ref && nbr->iface == iface && nbr->idx == idx) {
 			return nbr;
 		}
 	}
@@ -177,6 +248,23 @@ struct net_nbr *net_nbr_lookup(struct net_nbr_table *table,
 	return NULL;
 }
 
+int net_nbr_set_lladdr(uint8_t idx, uint8_t *addr, uint8_t len)
+{
+	int ret;
+
+	NET_ASSERT(idx < CONFIG_NET_IPV6_MAX_NEIGHBORS,
+		   "idx %d >= max %d", idx,
+		   CONFIG_NET_IPV6_MAX_NEIGHBORS);
+
+	lladdr_hash_remove(idx);
+
+	ret = net_linkaddr_set(&net_neighbor_lladdr[idx].lladdr, addr, len);
+
+	lladdr_hash_add(idx);
+
+	return ret;
+}
+
 struct net_linkaddr_storage *net_nbr_get_lladdr(uint8_t idx)
 {
 	NET_ASSERT(idx < CONFIG_NET_IPV6_MAX_NEIGHBORS,
@@ -204,6 +204,17 @@ static inline struct net_linkaddr_storage *net_nbr_get_lladdr(uint8_t idx)
 }
 #endif
 
+/**
+ * @brief Change the link address of a specific lladdr table index. The
+ * address must not be changed directly through net_nbr_get_lladdr() as
+ * the lladdr table is indexed by address.
+ * @param idx Link layer address index in ll table.
+ * @param addr New link layer address
+ * @param len Length of the new link layer address
+ * @return 0 if ok, <0 if the address is too long
+ */
+int net_nbr_set_lladdr(uint8_t idx, uint8_t *addr, uint8_t len);
+
 /**
  * @brief Clear table from all neighbors. After this the linking between
  * lladdr and neighbor is removed.
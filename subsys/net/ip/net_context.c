@@ -240,6 +240,12 @@ int net_context_get(sa_family_t family,
 		}
 
 		memset(&contexts[i], 0, sizeof(contexts[i]));
+
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+		/* TCP notifies the socket of the context from the start */
+		sys_dlist_init(&contexts[i].poll_notifiers);
+#endif
+
 	/* FIXME - Figure out a way to get the correct network interface
 	 * as it is not known at this point yet.
 	 */
@@ -1217,6 +1223,126 @@ static int context_write_data(struct net_pkt *pkt, const void *buf,
 	return ret;
 }
 
+#if defined(CONFIG_NET_CONTEXT_ZEROCOPY)
+struct zerocopy_data {
+	net_context_zerocopy_cb_t cb;
+	struct net_context *context;
+	const void *buf;
+	void *user_data;
+};
+
+static void zerocopy_buf_destroy(struct net_buf *buf);
+
+/* The buffers only point to the caller's data, the release callback of
+ * each buffer is kept in zerocopy_data[] at the buffer index.
+ */
+NET_BUF_POOL_DEFINE(zerocopy_pool, CONFIG_NET_CONTEXT_ZEROCOPY_BUF_COUNT,
+		    0, 0, zerocopy_buf_destroy);
+
+static struct zerocopy_data zerocopy_data[CONFIG_NET_CONTEXT_ZEROCOPY_BUF_COUNT];
+
+static void zerocopy_buf_destroy(struct net_buf *buf)
+{
+	struct zerocopy_data data = zerocopy_data[net_buf_id(buf)];
+
+	net_buf_destroy(buf);
+
+	if (data.cb) {
+		data.cb(data.context, data.buf, data.user_data);
+	}
+}
+
+static int context_zerocopy_len(struct net_context *context,
+				struct net_pkt *pkt, size_t *len)
+{
+	size_t max_len;
+	uint16_t mtu = 0U;
+
+	if (IS_ENABLED(CONFIG_NET_OFFLOAD) &&
+	    net_if_is_ip_offloaded(net_context_get_iface(context))) {
+		return -EOPNOTSUPP;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_TCP) &&
+	    net_context_get_ip_proto(context) == IPPROTO_TCP) {
+		/* The data is attached as a single buffer, TCP takes care
+		 * of the segmentation.
+		 */
+		*len = MIN(*len, UINT16_MAX);
+		return 0;
+	}
+
+	if (!IS_ENABLED(CONFIG_NET_UDP) ||
+	    net_context_get_ip_proto(context) != IPPROTO_UDP) {
+		return -EOPNOTSUPP;
+	}
+
+	if (net_pkt_iface(pkt)) {
+		mtu = net_if_get_mtu(net_pkt_iface(pkt));
+	}
+
+	/* Same limits as for the datagrams that are copied to the packet */
+	if (IS_ENABLED(CONFIG_NET_IPV6) &&
+	    net_context_get_family(context) == AF_INET6) {
+		if (IS_ENABLED(CONFIG_NET_IPV6_FRAGMENT)) {
+			max_len = UINT16_MAX - NET_UDPH_LEN;
+		} else {
+			max_len = MAX(mtu, NET_IPV6_MTU) - NET_IPV6UDPH_LEN;
+		}
+	} else {
+		max_len = MAX(mtu, NET_IPV4_MTU) - NET_IPV4UDPH_LEN;
+	}
+
+	if (*len > max_len) {
+		return -EMSGSIZE;
+	}
+
+	return 0;
+}
+
+static int context_attach_data(struct net_context *context,
+			       struct net_pkt *pkt,
+			       const void *buf, size_t len,
+			       net_context_zerocopy_cb_t cb,
+			       void *user_data)
+{
+	struct zerocopy_data *data;
+	struct net_buf *frag;
+
+	frag = net_buf_alloc_with_data(&zerocopy_pool, (void *)buf, len,
+				       PKT_WAIT_TIME);
+	if (!frag) {
+		return -ENOBUFS;
+	}
+
+	data = &zerocopy_data[net_buf_id(frag)];
+	data->cb = cb;
+	data->context = context;
+	data->buf = buf;
+	data->user_data = user_data;
+
+	net_pkt_append_buffer(pkt, frag);
+
+	return 0;
+}
+
+/* The data is not released with a callback if sending fails */
+static void context_detach_data(struct net_pkt *pkt)
+{
+	struct net_buf *frag;
+
+	for (frag = pkt->buffer; frag; frag = frag->frags) {
+		if (net_buf_pool_get(frag->pool_id) == &zerocopy_pool) {
+			zerocopy_data[net_buf_id(frag)].cb = NULL;
+		}
+	}
+}
+#else
+#define context_zerocopy_len(...) (-EOPNOTSUPP)
+#define context_attach_data(...) (-EOPNOTSUPP)
+#define context_detach_data(...)
+#endif /* CONFIG_NET_CONTEXT_ZEROCOPY */
+
 static int context_setup_udp_packet(struct net_context *context,
 				    struct net_pkt *pkt,
 				    const void *buf,
@@ -1343,6 +1469,54 @@ static void set_pkt_txtime(struct net_pkt *pkt, const struct msghdr *msghdr)
 	}
 }
 
+#if defined(CONFIG_NET_TCP)
+/* Queue the data to TCP. While the send window of the peer is full, wait
+ * for it to open, without holding the context lock so that the incoming
+ * ACKs can be processed.
+ */
+static int context_queue_tcp_data(struct net_context *context,
+				  struct net_pkt *pkt, k_timeout_t timeout)
+{
+	uint64_t end = z_timeout_end_calc(timeout);
+	struct k_poll_event event;
+	struct k_sem *tx_sem;
+	int ret;
+
+	while (true) {
+		ret = net_tcp_queue_data(context, pkt);
+		if (ret != -EAGAIN || K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+			return ret;
+		}
+
+		tx_sem = net_tcp_tx_sem_get(context);
+		if (!tx_sem) {
+			return ret;
+		}
+
+		k_poll_event_init(&event, K_POLL_TYPE_SEM_AVAILABLE,
+				  K_POLL_MODE_NOTIFY_ONLY, tx_sem);
+
+		k_mutex_unlock(&context->lock);
+		ret = k_poll(&event, 1, timeout);
+		k_mutex_lock(&context->lock, K_FOREVER);
+
+		if (ret < 0) {
+			return -EAGAIN;
+		}
+
+		if (!K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+			int64_t remaining = end - z_tick_get();
+
+			if (remaining <= 0) {
+				timeout = K_NO_WAIT;
+			} else {
+				timeout = Z_TIMEOUT_TICKS(remaining);
+			}
+		}
+	}
+}
+#endif /* CONFIG_NET_TCP */
+
 static int context_sendto(struct net_context *context,
 			  const void *buf,
 			  size_t len,
@@ -1351,7 +1525,8 @@ static int context_sendto(struct net_context *context,
 			  net_context_send_cb_t cb,
 			  k_timeout_t timeout,
 			  void *user_data,
-			  bool sendto)
+			  bool sendto,
+			  net_context_zerocopy_cb_t zc_cb)
 {
 	const struct msghdr *msghdr = NULL;
 	struct net_pkt *pkt;
@@ -1515,15 +1690,30 @@ static int context_sendto(struct net_context *context,
 		}
 	}
 
-	pkt = context_alloc_pkt(context, len, PKT_WAIT_TIME);
-	if (!pkt) {
-		return -ENOMEM;
-	}
+	if (zc_cb) {
+		/* Only the headers are written to the packet buffer, the
+		 * data is attached after them.
+		 */
+		pkt = context_alloc_pkt(context, 0, PKT_WAIT_TIME);
+		if (!pkt) {
+			return -ENOMEM;
+		}
+
+		ret = context_zerocopy_len(context, pkt, &len);
+		if (ret < 0) {
+			goto fail;
+		}
+	} else {
+		pkt = context_alloc_pkt(context, len, PKT_WAIT_TIME);
+		if (!pkt) {
+			return -ENOMEM;
+		}
 
-	tmp_len = net_pkt_available_payload_buffer(
-				pkt, net_context_get_ip_proto(context));
-	if (tmp_len < len) {
-		len = tmp_len;
+		tmp_len = net_pkt_available_payload_buffer(
+					pkt, net_context_get_ip_proto(context));
+		if (tmp_len < len) {
+			len = tmp_len;
+		}
 	}
 
 	context->send_cb = cb;
@@ -1599,8 +1789,20 @@ static int context_sendto(struct net_context *context,
 		}
 	} else if (IS_ENABLED(CONFIG_NET_UDP) &&
 	    net_context_get_ip_proto(context) == IPPROTO_UDP) {
-		ret = context_setup_udp_packet(context, pkt, buf, len, msghdr,
-					       dst_addr, addrlen);
+		if (zc_cb) {
+			ret = context_setup_udp_packet(context, pkt, NULL, 0,
+						       NULL, dst_addr, addrlen);
+			if (ret == 0) {
+				ret = context_attach_data(context, pkt, buf,
+							  len, zc_cb,
+							  user_data);
+			}
+		} else {
+			ret = context_setup_udp_packet(context, pkt, buf, len,
+						       msghdr, dst_addr,
+						       addrlen);
+		}
+
 		if (ret < 0) {
 			goto fail;
 		}
@@ -1611,13 +1813,23 @@ static int context_sendto(struct net_context *context,
 	} else if (IS_ENABLED(CONFIG_NET_TCP) &&
 		   net_context_get_ip_proto(context) == IPPROTO_TCP) {
 
-		ret = context_write_data(pkt, buf, len, msghdr);
+		if (zc_cb) {
+			/* TCP adds the headers when it sends the segments */
+			net_buf_unref(pkt->buffer);
+			pkt->buffer = NULL;
+
+			ret = context_attach_data(context, pkt, buf, len,
+						  zc_cb, user_data);
+		} else {
+			ret = context_write_data(pkt, buf, len, msghdr);
+		}
+
 		if (ret < 0) {
 			goto fail;
 		}
 
 		net_pkt_cursor_init(pkt);
-		ret = net_tcp_queue_data(context, pkt);
+		ret = context_queue_tcp_data(context, pkt, timeout);
 		if (ret < 0) {
 			goto fail;
 		}
@@ -1656,6 +1868,10 @@ static int context_sendto(struct net_context *context,
 
 	return len;
 fail:
+	if (zc_cb) {
+		context_detach_data(pkt);
+	}
+
 	net_pkt_unref(pkt);
 
 	return ret;
@@ -1697,7 +1913,7 @@ int net_context_send(struct net_context *context,
 	}
 
 	ret = context_sendto(context, buf, len, &context->remote,
-			     addrlen, cb, timeout, user_data, false);
+			     addrlen, cb, timeout, user_data, false, NULL);
 unlock:
 	k_mutex_unlock(&context->lock);
 
@@ -1716,7 +1932,7 @@ int net_context_sendmsg(struct net_context *context,
 	k_mutex_lock(&context->lock, K_FOREVER);
 
 	ret = context_sendto(context, msghdr, 0, NULL, 0,
-			     cb, timeout, user_data, true);
+			     cb, timeout, user_data, true, NULL);
 
 	k_mutex_unlock(&context->lock);
 
@@ -1737,8 +1953,50 @@ int net_context_sendto(struct net_context *context,
 	k_mutex_lock(&context->lock, K_FOREVER);
 
 	ret = context_sendto(context, buf, len, dst_addr, addrlen,
-			     cb, timeout, user_data, true);
+			     cb, timeout, user_data, true, NULL);
+
+	k_mutex_unlock(&context->lock);
+
+	return ret;
+}
 
+int net_context_sendto_zerocopy(struct net_context *context,
+				const void *buf,
+				size_t len,
+				const struct sockaddr *dst_addr,
+				socklen_t addrlen,
+				net_context_zerocopy_cb_t cb,
+				k_timeout_t timeout,
+				void *user_data)
+{
+	int ret;
+
+	if (!cb) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&context->lock, K_FOREVER);
+
+	if (!dst_addr) {
+		if (!(context->flags & NET_CONTEXT_REMOTE_ADDR_SET) ||
+		    !net_sin(&context->remote)->sin_port) {
+			ret = -EDESTADDRREQ;
+			goto unlock;
+		}
+
+		dst_addr = &context->remote;
+
+		if (IS_ENABLED(CONFIG_NET_IPV6) &&
+		    net_context_get_family(context) == AF_INET6) {
+			addrlen = sizeof(struct sockaddr_in6);
+		} else {
+			addrlen = sizeof(struct sockaddr_in);
+		}
+	}
+
+	ret = context_sendto(context, buf, len, dst_addr, addrlen,
+			     NULL, timeout, user_data, true, cb);
+unlock:
 	k_mutex_unlock(&context->lock);
 
 	return ret;
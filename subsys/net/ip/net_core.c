@@ -44,6 +44,7 @@ LOG_MODULE_REGISTER(net_core, CONFIG_NET_CORE_LOG_LEVEL);
 #include "dhcpv4.h"
 
 #include "route.h"
+#include "gro.h"
 
 #include "packet_socket.h"
 #include "canbus_socket.h"
@@ -107,6 +108,13 @@ static inline enum net_verdict process_data(struct net_pkt *pkt,
 	 */
 	net_pkt_cursor_init(pkt);
 
+	if (IS_ENABLED(CONFIG_NET_GRO) && !is_loopback && !locally_routed) {
+		ret = net_gro_receive(pkt);
+		if (ret != NET_CONTINUE) {
+			return ret;
+		}
+	}
+
 	/* IP version and header length. */
 	switch (NET_IPV6_HDR(pkt)->vtc & 0xf0) {
 #if defined(CONFIG_NET_IPV6)
@@ -347,15 +355,24 @@ static void net_rx(struct net_if *iface, struct net_pkt *pkt)
 static void process_rx_packet(struct k_work *work)
 {
 	struct net_pkt *pkt;
+	uint8_t queue;
 
 	pkt = CONTAINER_OF(work, struct net_pkt, work);
+	queue = net_rx_queue_id(net_rx_priority2tc(net_pkt_priority(pkt)),
+				pkt);
 
 	net_pkt_set_rx_stats_tick(pkt, k_cycle_get_32());
 
 	net_rx(net_pkt_iface(pkt), pkt);
+
+	/* Pass the coalesced TCP segments up once the burst is over. */
+	if (IS_ENABLED(CONFIG_NET_GRO) && net_tc_rx_queue_is_empty(queue)) {
+		net_gro_flush(queue);
+	}
 }
 
-static void net_queue_rx(struct net_if *iface, struct net_pkt *pkt)
+static uint8_t net_queue_rx_prepare(struct net_if *iface,
+				   struct net_pkt *pkt)
 {
 	uint8_t prio = net_pkt_priority(pkt);
 	uint8_t tc = net_rx_priority2tc(prio);
@@ -372,11 +389,37 @@ static void net_queue_rx(struct net_if *iface, struct net_pkt *pkt)
 	NET_DBG("TC %d with prio %d pkt %p", tc, prio, pkt);
 #endif
 
-	net_tc_submit_to_rx_queue(tc, pkt);
+	return tc;
 }
 
-/* Called by driver when an IP packet has been received */
-int net_recv_data(struct net_if *iface, struct net_pkt *pkt)
+static void net_queue_rx(struct net_if *iface, struct net_pkt *pkt)
+{
+	net_tc_submit_to_rx_queue(net_queue_rx_prepare(iface, pkt), pkt);
+}
+
+#if defined(CONFIG_NET_PKT_QUOTA_RX_RESERVE) && CONFIG_NET_PKT_QUOTA_RX_RESERVE > 0
+/* Keep the last free RX packets for the highest traffic class so that
+ * bulk traffic cannot starve control traffic of packets to receive into.
+ */
+static bool rx_reserve_exhausted(struct net_pkt *pkt)
+{
+	struct k_mem_slab *rx;
+
+	if (net_rx_priority2tc(net_pkt_priority(pkt)) >= NET_TC_RX_COUNT - 1) {
+		return false;
+	}
+
+	net_pkt_get_info(&rx, NULL, NULL, NULL);
+
+	return k_mem_slab_num_free_get(rx) < CONFIG_NET_PKT_QUOTA_RX_RESERVE;
+}
+#else
+#define rx_reserve_exhausted(pkt) false
+#endif
+
+/* A negative queue selects the Rx queue from the flow hash. */
+static int recv_data_prepare(struct net_if *iface, struct net_pkt *pkt,
+			     int queue)
 {
 	if (!pkt || !iface) {
 		return -EINVAL;
@@ -390,6 +433,13 @@ int net_recv_data(struct net_if *iface, struct net_pkt *pkt)
 		return -ENETDOWN;
 	}
 
+	if (rx_reserve_exhausted(pkt)) {
+		NET_DBG("RX reserve reached, dropping pkt %p prio %d", pkt,
+			net_pkt_priority(pkt));
+		net_stats_update_mem_reserve_drop(iface);
+		return -ENOBUFS;
+	}
+
 	net_pkt_set_overwrite(pkt, true);
 	net_pkt_cursor_init(pkt);
 
@@ -402,11 +452,69 @@ int net_recv_data(struct net_if *iface, struct net_pkt *pkt)
 
 	net_pkt_set_iface(pkt, iface);
 
+	if (IS_ENABLED(CONFIG_NET_RX_FLOW_STEERING)) {
+		if (queue < 0) {
+			queue = net_tc_rx_flow_hash(iface, pkt) %
+				NET_RX_FLOW_QUEUES;
+		}
+
+		net_pkt_set_rx_queue(pkt, queue);
+	}
+
+	return 0;
+}
+
+static int recv_data(struct net_if *iface, struct net_pkt *pkt,
+		     int queue)
+{
+	int ret;
+
+	ret = recv_data_prepare(iface, pkt, queue);
+	if (ret < 0) {
+		return ret;
+	}
+
 	net_queue_rx(iface, pkt);
 
 	return 0;
 }
 
+/* Called by driver when an IP packet has been received */
+int net_recv_data(struct net_if *iface, struct net_pkt *pkt)
+{
+	return recv_data(iface, pkt, -1);
+}
+
+int net_recv_data_queue(struct net_if *iface, struct net_pkt *pkt,
+			uint32_t queue)
+{
+	return recv_data(iface, pkt, queue % NET_RX_FLOW_QUEUES);
+}
+
+int net_recv_data_burst(struct net_if *iface, struct net_pkt **pkts,
+			int count)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		ret = recv_data_prepare(iface, pkts[i], -1);
+		if (ret < 0) {
+			break;
+		}
+
+		net_queue_rx_prepare(iface, pkts[i]);
+	}
+
+	if (i == 0) {
+		return ret;
+	}
+
+	net_tc_submit_burst_to_rx_queue(pkts, i);
+
+	return i;
+}
+
 static inline void l3_init(void)
 {
 	net_icmpv4_init();
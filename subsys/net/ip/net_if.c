@@ -3529,6 +3529,23 @@ bool net_if_need_calc_rx_checksum(struct net_if *iface)
 	return need_calc_checksum(iface, ETHERNET_HW_RX_CHKSUM_OFFLOAD);
 }
 
+bool net_if_need_tcp_segmentation(struct net_if *iface)
+{
+#if defined(CONFIG_NET_TCP_GSO) && defined(CONFIG_NET_L2_ETHERNET)
+	if (net_if_l2(iface) != &NET_L2_GET_NAME(ETHERNET)) {
+		return true;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_ETHERNET_GSO)) {
+		return false;
+	}
+
+	return !(net_eth_get_hw_capabilities(iface) & ETHERNET_HW_TX_TSO);
+#else
+	return true;
+#endif
+}
+
 int net_if_get_by_iface(struct net_if *iface)
 {
 	if (!(iface >= _net_if_list_start && iface < _net_if_list_end)) {
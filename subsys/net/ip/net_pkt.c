@@ -39,6 +39,7 @@ LOG_MODULE_REGISTER(net_pkt, CONFIG_NET_PKT_LOG_LEVEL);
 #include <net/udp.h>
 
 #include "net_private.h"
+#include "net_stats.h"
 #include "tcp_internal.h"
 
 /* Find max header size of IP protocol (IPv4 or IPv6) */
@@ -128,6 +129,126 @@ NET_BUF_POOL_VAR_DEFINE(tx_bufs, CONFIG_NET_BUF_TX_COUNT,
 
 #endif /* CONFIG_NET_BUF_FIXED_DATA_SIZE */
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+/* Account count items to usage, unless that would exceed the quota of
+ * the pool. Return the new usage, or a negative value.
+ */
+static int pkt_quota_charge(atomic_t *usage, int count, int pool_size)
+{
+	atomic_val_t used = atomic_add(usage, count) + count;
+
+	if (used > NET_PKT_QUOTA(pool_size)) {
+		atomic_sub(usage, count);
+		return -ENOBUFS;
+	}
+
+	return used;
+}
+
+static bool pkt_quota_charge_pkt(struct k_mem_slab *slab,
+				 struct net_if *iface)
+{
+	int used;
+
+	if (!iface) {
+		return true;
+	}
+
+	if (slab == &rx_pkts) {
+		used = pkt_quota_charge(&iface->pkt_usage.rx_pkts, 1,
+					CONFIG_NET_PKT_RX_COUNT);
+		if (used < 0) {
+			NET_DBG("iface %p over its %s packet quota", iface,
+				"RX");
+			net_stats_update_mem_rx_quota_drop(iface);
+			return false;
+		}
+
+		net_stats_update_mem_rx_pkts(iface, used);
+	} else if (slab == &tx_pkts) {
+		used = pkt_quota_charge(&iface->pkt_usage.tx_pkts, 1,
+					CONFIG_NET_PKT_TX_COUNT);
+		if (used < 0) {
+			NET_DBG("iface %p over its %s packet quota", iface,
+				"TX");
+			net_stats_update_mem_tx_quota_drop(iface);
+			return false;
+		}
+
+		net_stats_update_mem_tx_pkts(iface, used);
+	}
+
+	return true;
+}
+
+/* Return the number of buffers accounted for len bytes from pool, or a
+ * negative value if the packet interface is over its quota.
+ */
+static int pkt_quota_charge_bufs(struct net_pkt *pkt,
+				 struct net_buf_pool *pool, size_t len)
+{
+	struct net_if *iface = pkt->quota_iface;
+	int count;
+	int used;
+
+	if (!iface || !len || (pool != &rx_bufs && pool != &tx_bufs)) {
+		return 0;
+	}
+
+#if defined(CONFIG_NET_BUF_FIXED_DATA_SIZE)
+	count = ceiling_fraction(len, CONFIG_NET_BUF_DATA_SIZE);
+#else
+	count = 1;
+#endif
+
+	if (pool == &rx_bufs) {
+		used = pkt_quota_charge(&iface->pkt_usage.rx_bufs, count,
+					CONFIG_NET_BUF_RX_COUNT);
+		if (used < 0) {
+			NET_DBG("iface %p over its %s buffer quota", iface,
+				"RX");
+			net_stats_update_mem_rx_quota_drop(iface);
+			return used;
+		}
+
+		net_stats_update_mem_rx_bufs(iface, used);
+	} else {
+		used = pkt_quota_charge(&iface->pkt_usage.tx_bufs, count,
+					CONFIG_NET_BUF_TX_COUNT);
+		if (used < 0) {
+			NET_DBG("iface %p over its %s buffer quota", iface,
+				"TX");
+			net_stats_update_mem_tx_quota_drop(iface);
+			return used;
+		}
+
+		net_stats_update_mem_tx_bufs(iface, used);
+	}
+
+	return count;
+}
+
+static void pkt_quota_release(struct k_mem_slab *slab, struct net_if *iface,
+			      int pkts, int bufs)
+{
+	if (!iface) {
+		return;
+	}
+
+	if (slab == &rx_pkts) {
+		atomic_sub(&iface->pkt_usage.rx_pkts, pkts);
+		atomic_sub(&iface->pkt_usage.rx_bufs, bufs);
+	} else if (slab == &tx_pkts) {
+		atomic_sub(&iface->pkt_usage.tx_pkts, pkts);
+		atomic_sub(&iface->pkt_usage.tx_bufs, bufs);
+	}
+}
+#else
+#define pkt_quota_charge_pkt(slab, iface) true
+#define pkt_quota_charge_bufs(pkt, pool, len) 0
+#define pkt_quota_release(slab, iface, pkts, bufs)
+#endif /* CONFIG_NET_PKT_QUOTA */
+
 /* Allocation tracking is only available if separately enabled */
 #if defined(CONFIG_NET_DEBUG_NET_PKT_ALLOC)
 struct net_pkt_alloc {
@@ -401,7 +522,8 @@ struct net_buf *net_pkt_get_reserve_data(struct net_buf_pool *pool,
 }
 
 /* Get a fragment, try to figure out the pool from where to get
- * the data.
+ * the data. The fragment is meant to be added to pkt, so it is charged
+ * to the quota of the packet interface and released with the packet.
  */
 #if NET_LOG_LEVEL >= LOG_LEVEL_DBG
 struct net_buf *net_pkt_get_frag_debug(struct net_pkt *pkt,
@@ -412,34 +534,45 @@ struct net_buf *net_pkt_get_frag(struct net_pkt *pkt,
 				 k_timeout_t timeout)
 #endif
 {
+	struct net_buf_pool *pool;
+	struct net_buf *frag;
+	int count;
+
+	if (pkt->slab == &rx_pkts) {
+		pool = &rx_bufs;
+	} else {
+		pool = &tx_bufs;
+	}
+
 #if defined(CONFIG_NET_CONTEXT_NET_PKT_POOL)
 	struct net_context *context;
 
 	context = net_pkt_context(pkt);
 	if (context && context->data_pool) {
-#if NET_LOG_LEVEL >= LOG_LEVEL_DBG
-		return net_pkt_get_reserve_data_debug(context->data_pool(),
-						      timeout, caller, line);
-#else
-		return net_pkt_get_reserve_data(context->data_pool(), timeout);
-#endif /* NET_LOG_LEVEL >= LOG_LEVEL_DBG */
+		pool = context->data_pool();
 	}
 #endif /* CONFIG_NET_CONTEXT_NET_PKT_POOL */
 
-	if (pkt->slab == &rx_pkts) {
 #if NET_LOG_LEVEL >= LOG_LEVEL_DBG
-		return net_pkt_get_reserve_rx_data_debug(timeout,
-							 caller, line);
+	frag = net_pkt_get_reserve_data_debug(pool, timeout, caller, line);
 #else
-		return net_pkt_get_reserve_rx_data(timeout);
+	frag = net_pkt_get_reserve_data(pool, timeout);
 #endif
+	if (!frag) {
+		return NULL;
 	}
 
-#if NET_LOG_LEVEL >= LOG_LEVEL_DBG
-	return net_pkt_get_reserve_tx_data_debug(timeout, caller, line);
-#else
-	return net_pkt_get_reserve_tx_data(timeout);
+	count = pkt_quota_charge_bufs(pkt, pool, frag->size);
+	if (count < 0) {
+		net_buf_unref(frag);
+		return NULL;
+	}
+
+#if defined(CONFIG_NET_PKT_QUOTA)
+	pkt->quota_bufs += count;
 #endif
+
+	return frag;
 }
 
 #if NET_LOG_LEVEL >= LOG_LEVEL_DBG
@@ -591,6 +724,10 @@ done:
 		net_pkt_cursor_init(pkt);
 	}
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+	pkt_quota_release(pkt->slab, pkt->quota_iface, 1, pkt->quota_bufs);
+#endif
+
 	k_mem_slab_free(pkt->slab, (void **)&pkt);
 }
 
@@ -1108,6 +1245,7 @@ int net_pkt_alloc_buffer(struct net_pkt *pkt,
 	size_t alloc_len = 0;
 	size_t hdr_len = 0;
 	struct net_buf *buf;
+	int bufs;
 
 	if (!size && proto == 0 && net_pkt_family(pkt) == AF_UNSPEC) {
 		return 0;
@@ -1142,6 +1280,11 @@ int net_pkt_alloc_buffer(struct net_pkt *pkt,
 		pool = pkt->slab == &tx_pkts ? &tx_bufs : &rx_bufs;
 	}
 
+	bufs = pkt_quota_charge_bufs(pkt, pool, alloc_len);
+	if (bufs < 0) {
+		return -ENOMEM;
+	}
+
 	if (!K_TIMEOUT_EQ(timeout, K_NO_WAIT) &&
 	    !K_TIMEOUT_EQ(timeout, K_FOREVER)) {
 		int64_t remaining = end - z_tick_get();
@@ -1165,10 +1308,17 @@ int net_pkt_alloc_buffer(struct net_pkt *pkt,
 			alloc_len, caller, line);
 #else
 		NET_ERR("Data buffer (%zd) allocation failed.", alloc_len);
+#endif
+#if defined(CONFIG_NET_PKT_QUOTA)
+		pkt_quota_release(pkt->slab, pkt->quota_iface, 0, bufs);
 #endif
 		return -ENOMEM;
 	}
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+	pkt->quota_bufs += bufs;
+#endif
+
 	net_pkt_append_buffer(pkt, buf);
 
 	return 0;
@@ -1308,16 +1458,29 @@ static struct net_pkt *pkt_alloc_on_iface(struct k_mem_slab *slab,
 {
 	struct net_pkt *pkt;
 
+	if (!pkt_quota_charge_pkt(slab, iface)) {
+		return NULL;
+	}
+
 #if NET_LOG_LEVEL >= LOG_LEVEL_DBG
 	pkt = pkt_alloc(slab, timeout, caller, line);
 #else
 	pkt = pkt_alloc(slab, timeout);
 #endif
 
-	if (pkt) {
-		net_pkt_set_iface(pkt, iface);
+	if (!pkt) {
+		pkt_quota_release(slab, iface, 1, 0);
+		return NULL;
 	}
 
+	net_pkt_set_iface(pkt, iface);
+
+#if defined(CONFIG_NET_PKT_QUOTA)
+	if (slab == &rx_pkts || slab == &tx_pkts) {
+		pkt->quota_iface = iface;
+	}
+#endif
+
 	return pkt;
 }
 
@@ -1759,16 +1922,41 @@ static void clone_pkt_attributes(struct net_pkt *pkt, struct net_pkt *clone_pkt)
 struct net_pkt *net_pkt_clone(struct net_pkt *pkt, k_timeout_t timeout)
 {
 	size_t cursor_offset = net_pkt_get_current_offset(pkt);
+	uint64_t end = z_timeout_end_calc(timeout);
 	struct net_pkt *clone_pkt;
 	struct net_pkt_cursor backup;
+	int ret;
 
-	clone_pkt = net_pkt_alloc_with_buffer(net_pkt_iface(pkt),
-					      net_pkt_get_len(pkt),
-					      AF_UNSPEC, 0, timeout);
+	clone_pkt = net_pkt_alloc_on_iface(net_pkt_iface(pkt), timeout);
 	if (!clone_pkt) {
 		return NULL;
 	}
 
+	if (!K_TIMEOUT_EQ(timeout, K_NO_WAIT) &&
+	    !K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+		int64_t remaining = end - z_tick_get();
+
+		if (remaining <= 0) {
+			timeout = K_NO_WAIT;
+		} else {
+			timeout = Z_TIMEOUT_TICKS(remaining);
+		}
+	}
+
+	/* The buffer is not capped to the MTU of the interface: the packet
+	 * can be larger if it was coalesced or if it is an oversized TCP
+	 * segment. It is still accounted to the interface.
+	 */
+	net_pkt_set_iface(clone_pkt, NULL);
+	ret = net_pkt_alloc_buffer(clone_pkt, net_pkt_get_len(pkt), 0,
+				   timeout);
+	net_pkt_set_iface(clone_pkt, net_pkt_iface(pkt));
+
+	if (ret < 0) {
+		net_pkt_unref(clone_pkt);
+		return NULL;
+	}
+
 	net_pkt_cursor_backup(pkt, &backup);
 	net_pkt_cursor_init(pkt);
 
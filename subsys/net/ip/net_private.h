@@ -76,8 +76,44 @@ static inline enum net_verdict net_ipv6_input(struct net_pkt *pkt,
 	return NET_CONTINUE;
 }
 #endif
+#if defined(CONFIG_NET_RX_FLOW_STEERING)
+#define NET_RX_FLOW_QUEUES CONFIG_NET_RX_FLOW_QUEUES
+#else
+#define NET_RX_FLOW_QUEUES 1
+#endif
+
+/* Total number of Rx work queues, each traffic class has
+ * NET_RX_FLOW_QUEUES of them.
+ */
+#define NET_RX_QUEUE_COUNT (NET_TC_RX_COUNT * NET_RX_FLOW_QUEUES)
+
+/* Index of the Rx work queue that processes the packet */
+static inline uint8_t net_rx_queue_id(uint8_t tc, struct net_pkt *pkt)
+{
+	return tc * NET_RX_FLOW_QUEUES + net_pkt_rx_queue(pkt);
+}
+
+#if defined(CONFIG_NET_RX_FLOW_STEERING)
+extern uint32_t net_tc_rx_flow_hash(struct net_if *iface,
+				    struct net_pkt *pkt);
+#else
+static inline uint32_t net_tc_rx_flow_hash(struct net_if *iface,
+					   struct net_pkt *pkt)
+{
+	ARG_UNUSED(iface);
+	ARG_UNUSED(pkt);
+
+	return 0;
+}
+#endif
+
 extern bool net_tc_submit_to_tx_queue(uint8_t tc, struct net_pkt *pkt);
 extern void net_tc_submit_to_rx_queue(uint8_t tc, struct net_pkt *pkt);
+extern void net_tc_submit_burst_to_rx_queue(struct net_pkt **pkts,
+					    int count);
+extern void net_tc_submit_work_to_tx_queue(uint8_t tc, struct k_work *work);
+extern bool net_tc_tx_queue_is_empty(uint8_t tc);
+extern bool net_tc_rx_queue_is_empty(uint8_t queue);
 extern enum net_verdict net_promisc_mode_input(struct net_pkt *pkt);
 
 char *net_sprint_addr(sa_family_t af, const void *addr);
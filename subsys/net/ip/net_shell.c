@@ -236,6 +236,7 @@ struct ethernet_capabilities {
 static struct ethernet_capabilities eth_hw_caps[] = {
 	EC(ETHERNET_HW_TX_CHKSUM_OFFLOAD, "TX checksum offload"),
 	EC(ETHERNET_HW_RX_CHKSUM_OFFLOAD, "RX checksum offload"),
+	EC(ETHERNET_HW_TX_TSO,            "TCP segmentation offload"),
 	EC(ETHERNET_HW_VLAN,              "Virtual LAN"),
 	EC(ETHERNET_HW_VLAN_TAG_STRIP,    "VLAN Tag stripping"),
 	EC(ETHERNET_AUTO_NEGOTIATION_SET, "Auto negotiation"),
@@ -1412,23 +1413,26 @@ static void ipv6_frag_cb(struct net_ipv6_reassembly *reass,
 	   k_delayed_work_remaining_get(&reass->timer),
 	   src, net_sprint_ipv6_addr(&reass->dst));
 
-	for (i = 0; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		if (reass->pkt[i]) {
-			struct net_buf *frag = reass->pkt[i]->frags;
+	for (i = 0; i < reass->frag_count; i++) {
+		struct net_buf *frag = reass->frag[i].buf;
 
-			PR("[%d] pkt %p->", i, reass->pkt[i]);
+		if (!frag) {
+			frag = reass->pkt->frags;
+		}
 
-			while (frag) {
-				PR("%p", frag);
+		PR("[%d] offset %u len %u ", i, reass->frag[i].offset,
+		   reass->frag[i].len);
 
-				frag = frag->frags;
-				if (frag) {
-					PR("->");
-				}
-			}
+		while (frag) {
+			PR("%p", frag);
 
-			PR("\n");
+			frag = frag->frags;
+			if (frag) {
+				PR("->");
+			}
 		}
+
+		PR("\n");
 	}
 
 	(*count)++;
@@ -2835,6 +2839,34 @@ static void context_info(struct net_context *context, void *user_data)
 }
 #endif /* CONFIG_NET_OFFLOAD || CONFIG_NET_NATIVE */
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+static void iface_pkt_usage_cb(struct net_if *iface, void *user_data)
+{
+	struct net_shell_user_data *data = user_data;
+	const struct shell *shell = data->shell;
+	struct net_if_pkt_usage *usage = &iface->pkt_usage;
+
+	PR("%d\t%d/%d\t%d/%d\t%d/%d\t%d/%d\n",
+	   net_if_get_by_iface(iface),
+	   atomic_get(&usage->rx_pkts),
+	   NET_PKT_QUOTA(CONFIG_NET_PKT_RX_COUNT),
+	   atomic_get(&usage->tx_pkts),
+	   NET_PKT_QUOTA(CONFIG_NET_PKT_TX_COUNT),
+	   atomic_get(&usage->rx_bufs),
+	   NET_PKT_QUOTA(CONFIG_NET_BUF_RX_COUNT),
+	   atomic_get(&usage->tx_bufs),
+	   NET_PKT_QUOTA(CONFIG_NET_BUF_TX_COUNT));
+
+#if defined(CONFIG_NET_STATISTICS_PER_INTERFACE)
+	PR("\tmax\t%u\t%u\t%u\t%u\tdrop %u/%u reserve %u\n",
+	   iface->stats.mem.rx.pkts_max, iface->stats.mem.tx.pkts_max,
+	   iface->stats.mem.rx.bufs_max, iface->stats.mem.tx.bufs_max,
+	   iface->stats.mem.rx.quota_drop, iface->stats.mem.tx.quota_drop,
+	   iface->stats.mem.reserve_drop);
+#endif
+}
+#endif /* CONFIG_NET_PKT_QUOTA */
+
 static int cmd_net_mem(const struct shell *shell, size_t argc, char *argv[])
 {
 	ARG_UNUSED(argc);
@@ -2877,6 +2909,17 @@ static int cmd_net_mem(const struct shell *shell, size_t argc, char *argv[])
 		"CONFIG_NET_BUF_POOL_USAGE", "net_buf allocation");
 #endif /* CONFIG_NET_BUF_POOL_USAGE */
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+	struct net_shell_user_data quota_data = {
+		.shell = shell,
+	};
+
+	PR("\nInterface quotas (used/quota):\n");
+	PR("Iface\tRX\tTX\tRX DATA\tTX DATA\n");
+
+	net_if_foreach(iface_pkt_usage_cb, &quota_data);
+#endif /* CONFIG_NET_PKT_QUOTA */
+
 	if (IS_ENABLED(CONFIG_NET_CONTEXT_NET_PKT_POOL)) {
 		struct net_shell_user_data user_data;
 		struct ctx_info info;
@@ -302,6 +302,12 @@ static int net_stats_get(uint32_t mgmt_request, struct net_if *iface,
 		len_chk = sizeof(struct net_stats_pm);
 		src = GET_STAT_ADDR(iface, pm);
 		break;
+#endif
+#if defined(CONFIG_NET_PKT_QUOTA)
+	case NET_REQUEST_STATS_CMD_GET_MEM:
+		len_chk = sizeof(struct net_stats_mem);
+		src = GET_STAT_ADDR(iface, mem);
+		break;
 #endif
 	}
 
@@ -361,6 +367,11 @@ NET_MGMT_REGISTER_REQUEST_HANDLER(NET_REQUEST_STATS_GET_PM,
 				  net_stats_get);
 #endif
 
+#if defined(CONFIG_NET_PKT_QUOTA)
+NET_MGMT_REGISTER_REQUEST_HANDLER(NET_REQUEST_STATS_GET_MEM,
+				  net_stats_get);
+#endif
+
 #endif /* CONFIG_NET_STATISTICS_USER_API */
 
 void net_stats_reset(struct net_if *iface)
@@ -595,6 +595,63 @@ static inline void net_stats_add_suspend_end_time(struct net_if *iface,
 #define net_stats_add_suspend_end_time(iface, time)
 #endif
 
+#if defined(CONFIG_NET_PKT_QUOTA) && defined(CONFIG_NET_STATISTICS) && \
+	defined(CONFIG_NET_NATIVE)
+/* Packet and buffer pool stats */
+
+#define UPDATE_STAT_MAX(_iface, _s, _val)				\
+	{ NET_ASSERT(_iface);						\
+	  net_stats._s = MAX(net_stats._s, (_val));			\
+	  SET_STAT(_iface->stats._s = MAX(_iface->stats._s, (_val))); }
+
+static inline void net_stats_update_mem_rx_pkts(struct net_if *iface,
+						uint32_t used)
+{
+	UPDATE_STAT_MAX(iface, mem.rx.pkts_max, used);
+}
+
+static inline void net_stats_update_mem_tx_pkts(struct net_if *iface,
+						uint32_t used)
+{
+	UPDATE_STAT_MAX(iface, mem.tx.pkts_max, used);
+}
+
+static inline void net_stats_update_mem_rx_bufs(struct net_if *iface,
+						uint32_t used)
+{
+	UPDATE_STAT_MAX(iface, mem.rx.bufs_max, used);
+}
+
+static inline void net_stats_update_mem_tx_bufs(struct net_if *iface,
+						uint32_t used)
+{
+	UPDATE_STAT_MAX(iface, mem.tx.bufs_max, used);
+}
+
+static inline void net_stats_update_mem_rx_quota_drop(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.mem.rx.quota_drop++);
+}
+
+static inline void net_stats_update_mem_tx_quota_drop(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.mem.tx.quota_drop++);
+}
+
+static inline void net_stats_update_mem_reserve_drop(struct net_if *iface)
+{
+	UPDATE_STAT(iface, stats.mem.reserve_drop++);
+}
+#else
+#define net_stats_update_mem_rx_pkts(iface, used)
+#define net_stats_update_mem_tx_pkts(iface, used)
+#define net_stats_update_mem_rx_bufs(iface, used)
+#define net_stats_update_mem_tx_bufs(iface, used)
+#define net_stats_update_mem_rx_quota_drop(iface)
+#define net_stats_update_mem_tx_quota_drop(iface)
+#define net_stats_update_mem_reserve_drop(iface)
+#endif /* CONFIG_NET_PKT_QUOTA && CONFIG_NET_STATISTICS */
+
 #if defined(CONFIG_NET_STATISTICS_PERIODIC_OUTPUT) \
 	&& defined(CONFIG_NET_NATIVE)
 /* A simple periodic statistic printer, used only in net core */
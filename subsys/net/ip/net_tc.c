@@ -13,6 +13,7 @@ LOG_MODULE_REGISTER(net_tc, CONFIG_NET_TC_LOG_LEVEL);
 #include <net/net_core.h>
 #include <net/net_pkt.h>
 #include <net/net_stats.h>
+#include <net/ethernet.h>
 
 #include "net_private.h"
 #include "net_stats.h"
@@ -23,11 +24,11 @@ K_KERNEL_STACK_ARRAY_DEFINE(tx_stack, NET_TC_TX_COUNT,
 			    CONFIG_NET_TX_STACK_SIZE);
 
 /* Stacks for RX work queue */
-K_KERNEL_STACK_ARRAY_DEFINE(rx_stack, NET_TC_RX_COUNT,
+K_KERNEL_STACK_ARRAY_DEFINE(rx_stack, NET_RX_QUEUE_COUNT,
 			    CONFIG_NET_RX_STACK_SIZE);
 
 static struct net_traffic_class tx_classes[NET_TC_TX_COUNT];
-static struct net_traffic_class rx_classes[NET_TC_RX_COUNT];
+static struct net_traffic_class rx_classes[NET_RX_QUEUE_COUNT];
 
 bool net_tc_submit_to_tx_queue(uint8_t tc, struct net_pkt *pkt)
 {
@@ -46,9 +47,128 @@ void net_tc_submit_to_rx_queue(uint8_t tc, struct net_pkt *pkt)
 {
 	net_pkt_set_rx_stats_tick(pkt, k_cycle_get_32());
 
-	k_work_submit_to_queue(&rx_classes[tc].work_q, net_pkt_work(pkt));
+	k_work_submit_to_queue(&rx_classes[net_rx_queue_id(tc, pkt)].work_q,
+			       net_pkt_work(pkt));
 }
 
+/* Queue a burst of received packets. The scheduler is locked while the
+ * packets are queued, so the Rx threads wake up once for the whole burst
+ * instead of preempting us after every packet. The packets keep their
+ * order within each queue.
+ */
+void net_tc_submit_burst_to_rx_queue(struct net_pkt **pkts, int count)
+{
+	int i;
+
+	k_sched_lock();
+
+	for (i = 0; i < count; i++) {
+		net_tc_submit_to_rx_queue(
+			net_rx_priority2tc(net_pkt_priority(pkts[i])),
+			pkts[i]);
+	}
+
+	k_sched_unlock();
+}
+
+void net_tc_submit_work_to_tx_queue(uint8_t tc, struct k_work *work)
+{
+	k_work_submit_to_queue(&tx_classes[tc].work_q, work);
+}
+
+bool net_tc_tx_queue_is_empty(uint8_t tc)
+{
+	return k_queue_is_empty(&tx_classes[tc].work_q.queue);
+}
+
+bool net_tc_rx_queue_is_empty(uint8_t queue)
+{
+	return k_queue_is_empty(&rx_classes[queue].work_q.queue);
+}
+
+#if defined(CONFIG_NET_RX_FLOW_STEERING)
+static inline uint32_t rx_flow_hash_add(uint32_t hash, const uint8_t *data)
+{
+	return (hash ^ sys_get_be32(data)) * 0x9e3779b1U;
+}
+
+uint32_t net_tc_rx_flow_hash(struct net_if *iface, struct net_pkt *pkt)
+{
+	struct net_buf *buf = pkt->buffer;
+	const uint8_t *data = buf->data;
+	size_t len = buf->len;
+	uint32_t hash = 0U;
+	size_t l4_offset;
+	uint8_t proto;
+	int i;
+
+	/* Only the first fragment is looked at, packets that do not have
+	 * their headers there all end up in the first queue.
+	 */
+#if defined(CONFIG_NET_L2_ETHERNET)
+	if (net_if_l2(iface) == &NET_L2_GET_NAME(ETHERNET)) {
+		struct net_eth_hdr *hdr = (struct net_eth_hdr *)data;
+		size_t hdr_len = sizeof(struct net_eth_hdr);
+		uint16_t type;
+
+		if (len < sizeof(struct net_eth_vlan_hdr)) {
+			return 0;
+		}
+
+		type = ntohs(hdr->type);
+		if (type == NET_ETH_PTYPE_VLAN) {
+			type = ntohs(((struct net_eth_vlan_hdr *)data)->type);
+			hdr_len = sizeof(struct net_eth_vlan_hdr);
+		}
+
+		if (type != NET_ETH_PTYPE_IP && type != NET_ETH_PTYPE_IPV6) {
+			return 0;
+		}
+
+		data += hdr_len;
+		len -= hdr_len;
+	}
+#endif
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && len >= NET_IPV4H_LEN &&
+	    (data[0] & 0xf0) == 0x40) {
+		struct net_ipv4_hdr *hdr = (struct net_ipv4_hdr *)data;
+
+		hash = rx_flow_hash_add(hash, (uint8_t *)&hdr->src);
+		hash = rx_flow_hash_add(hash, (uint8_t *)&hdr->dst);
+
+		/* Fragments do not all carry the ports, keep them together
+		 * by using the addresses only.
+		 */
+		proto = ((hdr->offset[0] & 0x3f) || hdr->offset[1]) ?
+			0 : hdr->proto;
+		l4_offset = (hdr->vhl & 0x0f) * 4U;
+	} else if (IS_ENABLED(CONFIG_NET_IPV6) && len >= NET_IPV6H_LEN &&
+		   (data[0] & 0xf0) == 0x60) {
+		struct net_ipv6_hdr *hdr = (struct net_ipv6_hdr *)data;
+
+		for (i = 0; i < sizeof(struct in6_addr); i += 4) {
+			hash = rx_flow_hash_add(hash, hdr->src.s6_addr + i);
+			hash = rx_flow_hash_add(hash, hdr->dst.s6_addr + i);
+		}
+
+		/* Extension headers are not parsed. */
+		proto = hdr->nexthdr;
+		l4_offset = NET_IPV6H_LEN;
+	} else {
+		return 0;
+	}
+
+	if ((proto == IPPROTO_TCP || proto == IPPROTO_UDP) &&
+	    len >= l4_offset + 2 * sizeof(uint16_t)) {
+		/* Source and destination port */
+		hash = rx_flow_hash_add(hash, data + l4_offset);
+	}
+
+	return hash ^ (hash >> 16);
+}
+#endif /* CONFIG_NET_RX_FLOW_STEERING */
+
 int net_tx_priority2tc(enum net_priority prio)
 {
 	if (prio > NET_PRIORITY_NC) {
@@ -250,6 +370,25 @@ void net_tc_tx_init(void)
 	}
 }
 
+#if defined(CONFIG_NET_RX_FLOW_STEERING) && defined(CONFIG_SCHED_CPU_MASK)
+/* Pin each queue of a traffic class to its own CPU. The CPU mask can only
+ * be changed while the thread cannot run.
+ */
+static void rx_queue_pin(struct k_thread *thread, int cpu)
+{
+	k_thread_suspend(thread);
+
+	if (k_thread_cpu_mask_clear(thread) < 0 ||
+	    k_thread_cpu_mask_enable(thread, cpu) < 0) {
+		NET_ERR("Cannot pin RX queue thread %p to CPU %d",
+			thread, cpu);
+		(void)k_thread_cpu_mask_enable_all(thread);
+	}
+
+	k_thread_resume(thread);
+}
+#endif
+
 void net_tc_rx_init(void)
 {
 	int i;
@@ -260,10 +399,10 @@ void net_tc_rx_init(void)
 	net_if_foreach(net_tc_rx_stats_priority_setup, NULL);
 #endif
 
-	for (i = 0; i < NET_TC_RX_COUNT; i++) {
+	for (i = 0; i < NET_RX_QUEUE_COUNT; i++) {
 		uint8_t thread_priority;
 
-		thread_priority = rx_tc2thread(i);
+		thread_priority = rx_tc2thread(i / NET_RX_FLOW_QUEUES);
 		rx_classes[i].tc = thread_priority;
 
 		NET_DBG("[%d] Starting RX queue %p stack size %zd "
@@ -277,5 +416,10 @@ void net_tc_rx_init(void)
 			       K_KERNEL_STACK_SIZEOF(rx_stack[i]),
 			       K_PRIO_COOP(thread_priority));
 		k_thread_name_set(&rx_classes[i].work_q.thread, "rx_workq");
+
+#if defined(CONFIG_NET_RX_FLOW_STEERING) && defined(CONFIG_SCHED_CPU_MASK)
+		rx_queue_pin(&rx_classes[i].work_q.thread,
+			     (i % NET_RX_FLOW_QUEUES) % CONFIG_MP_NUM_CPUS);
+#endif
 	}
 }
@@ -33,10 +33,38 @@ LOG_MODULE_REGISTER(net_route, CONFIG_NET_ROUTE_LOG_LEVEL);
 #define NET_ROUTE_EXTRA_DATA_SIZE 0
 #endif
 
-/* We keep track of the routes in a separate list so that we can remove
- * the oldest routes (at tail) if needed.
+/* The route prefixes are kept in a path compressed binary trie so that
+ * the longest prefix match does not depend on the number of routes. A node
+ * either has routes, or it joins two subtries whose prefixes differ at the
+ * bit after its own prefix. So there are at most 2 * CONFIG_NET_MAX_ROUTES
+ * nodes in addition to the root node, which is the ::/0 prefix.
  */
-static sys_slist_t routes;
+struct route_trie_node {
+	struct route_trie_node *parent;
+	struct route_trie_node *child[2];
+
+	/** Routes with this prefix, one per network interface */
+	sys_slist_t routes;
+
+	/** Prefix, with the bits after prefix_len cleared */
+	struct in6_addr prefix;
+	uint8_t prefix_len;
+	bool used;
+};
+
+static struct route_trie_node trie_root = {
+	.used = true,
+};
+
+static struct route_trie_node trie_nodes[2 * CONFIG_NET_MAX_ROUTES];
+
+/* Sequence number of the route accesses, used to find the least recently
+ * used route.
+ */
+static uint32_t route_access;
+
+/* Changed every time a route is added or removed, see route_cache_get() */
+static atomic_t route_gen = ATOMIC_INIT(1);
 
 static void net_route_nexthop_remove(struct net_nbr *nbr)
 {
@@ -86,6 +114,21 @@ static struct net_nbr *get_nexthop_route(void)
 	return NULL;
 }
 
+static void put_nexthop_route(struct net_route_nexthop *nexthop_route)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_MAX_NEXTHOPS; i++) {
+		struct net_nbr *nbr = get_nexthop_nbr(
+			(struct net_nbr *)net_route_nexthop_pool, i);
+
+		if (nbr->ref && nbr->data == (uint8_t *)nexthop_route) {
+			net_nbr_unref(nbr);
+			return;
+		}
+	}
+}
+
 static void net_route_entry_remove(struct net_nbr *nbr)
 {
 	NET_DBG("Route %p removed", nbr);
@@ -250,51 +293,342 @@ static int nbr_nexthop_put(struct net_nbr *nbr)
 			route->iface);					\
 	} } while (0)
 
-/* Route was accessed, so place it in front of the routes list */
-static inline void update_route_access(struct net_route_entry *route)
+static inline int prefix_bit(const struct in6_addr *addr, uint8_t bit)
 {
-	sys_slist_find_and_remove(&routes, &route->node);
-	sys_slist_prepend(&routes, &route->node);
+	return (addr->s6_addr[bit / 8] >> (7 - bit % 8)) & 1;
 }
 
-struct net_route_entry *net_route_lookup(struct net_if *iface,
-					 struct in6_addr *dst)
+/* Number of leading bits, up to len, that are the same in both addresses */
+static uint8_t prefix_common_len(const struct in6_addr *addr1,
+				 const struct in6_addr *addr2, uint8_t len)
 {
-	struct net_route_entry *route, *found = NULL;
-	uint8_t longest_match = 0U;
+	uint8_t bits = 0U;
 	int i;
 
-	for (i = 0; i < CONFIG_NET_MAX_ROUTES && longest_match < 128; i++) {
-		struct net_nbr *nbr = get_nbr(i);
+	for (i = 0; i < sizeof(struct in6_addr) && bits < len; i++) {
+		uint8_t diff = addr1->s6_addr[i] ^ addr2->s6_addr[i];
 
-		if (!nbr->ref) {
+		if (diff) {
+			bits += 8 - find_msb_set(diff);
+			break;
+		}
+
+		bits += 8U;
+	}
+
+	return MIN(bits, len);
+}
+
+static struct route_trie_node *trie_node_alloc(const struct in6_addr *prefix,
+					       uint8_t prefix_len)
+{
+	struct route_trie_node *node;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(trie_nodes); i++) {
+		node = &trie_nodes[i];
+
+		if (node->used) {
 			continue;
 		}
 
-		if (iface && nbr->iface != iface) {
+		(void)memset(node, 0, sizeof(*node));
+
+		node->used = true;
+		node->prefix_len = prefix_len;
+
+		memcpy(node->prefix.s6_addr, prefix->s6_addr,
+		       prefix_len / 8);
+
+		if (prefix_len % 8) {
+			node->prefix.s6_addr[prefix_len / 8] =
+				prefix->s6_addr[prefix_len / 8] &
+				(0xff << (8 - prefix_len % 8));
+		}
+
+		return node;
+	}
+
+	return NULL;
+}
+
+static inline void trie_link(struct route_trie_node *parent,
+			     struct route_trie_node *node)
+{
+	parent->child[prefix_bit(&node->prefix, parent->prefix_len)] = node;
+	node->parent = parent;
+}
+
+/* Return the node of the prefix, adding it to the trie if needed */
+static struct route_trie_node *trie_insert(const struct in6_addr *prefix,
+					   uint8_t prefix_len)
+{
+	struct route_trie_node *node = &trie_root;
+	struct route_trie_node *child, *new, *join;
+	uint8_t common;
+
+	while (node->prefix_len < prefix_len) {
+		child = node->child[prefix_bit(prefix, node->prefix_len)];
+		if (!child) {
+			new = trie_node_alloc(prefix, prefix_len);
+			if (new) {
+				trie_link(node, new);
+			}
+
+			return new;
+		}
+
+		common = prefix_common_len(prefix, &child->prefix,
+					   MIN(prefix_len, child->prefix_len));
+		if (common == child->prefix_len) {
+			node = child;
 			continue;
 		}
 
-		route = net_route_data(nbr);
+		new = trie_node_alloc(prefix, prefix_len);
+		if (!new) {
+			return NULL;
+		}
+
+		if (common == prefix_len) {
+			/* The new prefix covers the child one */
+			trie_link(node, new);
+			trie_link(new, child);
+
+			return new;
+		}
+
+		join = trie_node_alloc(prefix, common);
+		if (!join) {
+			new->used = false;
+			return NULL;
+		}
+
+		trie_link(node, join);
+		trie_link(join, child);
+		trie_link(join, new);
+
+		return new;
+	}
+
+	return node;
+}
+
+static struct route_trie_node *trie_find(const struct in6_addr *prefix,
+					 uint8_t prefix_len)
+{
+	struct route_trie_node *node = &trie_root;
+
+	while (node && node->prefix_len < prefix_len) {
+		node = node->child[prefix_bit(prefix, node->prefix_len)];
+	}
+
+	if (node && node->prefix_len == prefix_len &&
+	    net_ipv6_is_prefix(prefix->s6_addr, node->prefix.s6_addr,
+			       prefix_len)) {
+		return node;
+	}
+
+	return NULL;
+}
+
+/* Remove the nodes that are neither a route prefix nor join two subtries */
+static void trie_compact(struct route_trie_node *node)
+{
+	struct route_trie_node *parent, *child;
+
+	while (node != &trie_root && sys_slist_is_empty(&node->routes) &&
+	       !(node->child[0] && node->child[1])) {
+		parent = node->parent;
+		child = node->child[0] ? node->child[0] : node->child[1];
+
+		parent->child[parent->child[1] == node] = child;
+		if (child) {
+			child->parent = parent;
+		}
+
+		node->used = false;
+		node = parent;
+	}
+}
+
+static struct net_route_entry *trie_route(struct route_trie_node *node,
+					  struct net_if *iface)
+{
+	struct net_route_entry *route;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&node->routes, route, node) {
+		if (!iface || route->iface == iface) {
+			return route;
+		}
+	}
 
-		if (route->prefix_len >= longest_match &&
-		    net_ipv6_is_prefix(dst->s6_addr,
-				       route->addr.s6_addr,
-				       route->prefix_len)) {
+	return NULL;
+}
+
+static struct net_route_entry *trie_lookup(struct net_if *iface,
+					   const struct in6_addr *dst)
+{
+	struct route_trie_node *node = &trie_root;
+	struct net_route_entry *route, *found = NULL;
+
+	while (node && net_ipv6_is_prefix(dst->s6_addr, node->prefix.s6_addr,
+					  node->prefix_len)) {
+		route = trie_route(node, iface);
+		if (route) {
 			found = route;
-			longest_match = route->prefix_len;
 		}
+
+		if (node->prefix_len == 128) {
+			break;
+		}
+
+		node = node->child[prefix_bit(dst, node->prefix_len)];
+	}
+
+	return found;
+}
+
+#if CONFIG_NET_ROUTE_CACHE_SIZE > 0
+/* Cache of the route lookup results, including the negative ones. An
+ * entry is valid only if it was filled with the current route generation.
+ */
+struct route_cache_entry {
+	struct in6_addr dst;
+	struct net_if *iface;
+	struct net_route_entry *route;
+	atomic_val_t gen;
+};
+
+static struct route_cache_entry route_cache[CONFIG_NET_ROUTE_CACHE_SIZE];
+static struct k_spinlock route_cache_lock;
+
+static struct route_cache_entry *route_cache_entry(struct net_if *iface,
+						   const struct in6_addr *dst)
+{
+	/* The destination is often in a packet header, so it might not
+	 * be aligned.
+	 */
+	uint32_t hash = UNALIGNED_GET(&dst->s6_addr32[0]) ^
+			UNALIGNED_GET(&dst->s6_addr32[1]) ^
+			UNALIGNED_GET(&dst->s6_addr32[2]) ^
+			UNALIGNED_GET(&dst->s6_addr32[3]) ^
+			(uint32_t)POINTER_TO_UINT(iface);
+
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
+
+	return &route_cache[hash % CONFIG_NET_ROUTE_CACHE_SIZE];
+}
+
+static bool route_cache_get(struct net_if *iface, const struct in6_addr *dst,
+			    struct net_route_entry **route)
+{
+	struct route_cache_entry *entry = route_cache_entry(iface, dst);
+	k_spinlock_key_t key = k_spin_lock(&route_cache_lock);
+	bool hit;
+
+	hit = entry->gen == atomic_get(&route_gen) && entry->iface == iface &&
+	      net_ipv6_addr_cmp(&entry->dst, dst);
+	if (hit) {
+		*route = entry->route;
+	}
+
+	k_spin_unlock(&route_cache_lock, key);
+
+	return hit;
+}
+
+static void route_cache_put(struct net_if *iface, const struct in6_addr *dst,
+			    struct net_route_entry *route, atomic_val_t gen)
+{
+	struct route_cache_entry *entry = route_cache_entry(iface, dst);
+	k_spinlock_key_t key = k_spin_lock(&route_cache_lock);
+
+	net_ipaddr_copy(&entry->dst, dst);
+	entry->iface = iface;
+	entry->route = route;
+	entry->gen = gen;
+
+	k_spin_unlock(&route_cache_lock, key);
+}
+#else
+static inline bool route_cache_get(struct net_if *iface,
+				   const struct in6_addr *dst,
+				   struct net_route_entry **route)
+{
+	return false;
+}
+
+static inline void route_cache_put(struct net_if *iface,
+				   const struct in6_addr *dst,
+				   struct net_route_entry *route,
+				   atomic_val_t gen)
+{
+}
+#endif /* CONFIG_NET_ROUTE_CACHE_SIZE > 0 */
+
+/* Must be called after the routing table has been changed, so that
+ * a lookup running concurrently does not cache a stale result.
+ */
+static inline void route_cache_invalidate(void)
+{
+	atomic_inc(&route_gen);
+}
+
+struct net_route_entry *net_route_lookup(struct net_if *iface,
+					 struct in6_addr *dst)
+{
+	struct net_route_entry *found;
+	atomic_val_t gen;
+
+	if (!route_cache_get(iface, dst, &found)) {
+		gen = atomic_get(&route_gen);
+		found = trie_lookup(iface, dst);
+		route_cache_put(iface, dst, found, gen);
 	}
 
 	if (found) {
 		net_route_info("Found", found, dst);
 
-		update_route_access(found);
+		found->last_use = ++route_access;
 	}
 
 	return found;
 }
 
+static struct net_route_entry *route_find(struct net_if *iface,
+					  struct in6_addr *addr,
+					  uint8_t prefix_len)
+{
+	struct route_trie_node *node = trie_find(addr, prefix_len);
+
+	return node ? trie_route(node, iface) : NULL;
+}
+
+static struct net_route_entry *route_least_recently_used(void)
+{
+	struct net_route_entry *route, *oldest = NULL;
+	int i;
+
+	for (i = 0; i < CONFIG_NET_MAX_ROUTES; i++) {
+		struct net_nbr *nbr = get_nbr(i);
+
+		if (!nbr->ref) {
+			continue;
+		}
+
+		route = net_route_data(nbr);
+
+		if (!oldest ||
+		    (int32_t)(route->last_use - oldest->last_use) < 0) {
+			oldest = route;
+		}
+	}
+
+	return oldest;
+}
+
 struct net_route_entry *net_route_add(struct net_if *iface,
 				      struct in6_addr *addr,
 				      uint8_t prefix_len,
@@ -303,6 +637,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	struct net_linkaddr_storage *nexthop_lladdr;
 	struct net_nbr *nbr, *nbr_nexthop, *tmp;
 	struct net_route_nexthop *nexthop_route;
+	struct route_trie_node *node;
 	struct net_route_entry *route;
 #if defined(CONFIG_NET_MGMT_EVENT_INFO)
        struct net_event_ipv6_route info;
@@ -333,7 +668,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 		log_strdup(net_sprint_ll_addr(nexthop_lladdr->addr,
 					      nexthop_lladdr->len)));
 
-	route = net_route_lookup(iface, addr);
+	route = route_find(iface, addr, prefix_len);
 	if (route) {
 		/* Update nexthop if not the same */
 		struct in6_addr *nexthop_addr;
@@ -353,13 +688,11 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	nbr = nbr_new(iface, addr, prefix_len);
 	if (!nbr) {
 		/* Remove the oldest route and try again */
-		sys_snode_t *last = sys_slist_peek_tail(&routes);
-
-		sys_slist_find_and_remove(&routes, last);
-
-		route = CONTAINER_OF(last,
-				     struct net_route_entry,
-				     node);
+		route = route_least_recently_used();
+		if (!route) {
+			NET_ERR("Neighbor route alloc failed!");
+			return NULL;
+		}
 
 		if (CONFIG_NET_ROUTE_LOG_LEVEL >= LOG_LEVEL_DBG) {
 			struct in6_addr *tmp;
@@ -393,15 +726,26 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	tmp = get_nexthop_route();
 	if (!tmp) {
 		NET_ERR("No nexthop route available!");
+		nbr_free(nbr);
+		return NULL;
+	}
+
+	route = net_route_data(nbr);
+
+	node = trie_insert(addr, prefix_len);
+	if (!node) {
+		NET_ERR("No route prefix node available!");
+		net_nbr_unref(tmp);
+		nbr_free(nbr);
 		return NULL;
 	}
 
 	nexthop_route = net_nexthop_data(tmp);
 
-	route = net_route_data(nbr);
 	route->iface = iface;
+	route->last_use = ++route_access;
 
-	sys_slist_prepend(&routes, &route->node);
+	sys_slist_prepend(&node->routes, &route->node);
 
 	tmp = nbr_nexthop_get(iface, nexthop);
 
@@ -412,6 +756,8 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	sys_slist_init(&route->nexthop);
 	sys_slist_prepend(&route->nexthop, &nexthop_route->node);
 
+	route_cache_invalidate();
+
 	net_route_info("Added", route, addr);
 
 #if defined(CONFIG_NET_MGMT_EVENT_INFO)
@@ -433,6 +779,7 @@ int net_route_del(struct net_route_entry *route)
 {
 	struct net_nbr *nbr;
 	struct net_route_nexthop *nexthop_route;
+	struct route_trie_node *node;
 #if defined(CONFIG_NET_MGMT_EVENT_INFO)
        struct net_event_ipv6_route info;
 #endif
@@ -454,21 +801,26 @@ int net_route_del(struct net_route_entry *route)
 	net_mgmt_event_notify(NET_EVENT_IPV6_ROUTE_DEL, route->iface);
 #endif
 
-	sys_slist_find_and_remove(&routes, &route->node);
-
 	nbr = net_route_get_nbr(route);
 	if (!nbr) {
 		return -ENOENT;
 	}
 
+	node = trie_find(&route->addr, route->prefix_len);
+	if (node && sys_slist_find_and_remove(&node->routes, &route->node)) {
+		trie_compact(node);
+	}
+
+	route_cache_invalidate();
+
 	net_route_info("Deleted", route, &route->addr);
 
 	SYS_SLIST_FOR_EACH_CONTAINER(&route->nexthop, nexthop_route, node) {
-		if (!nexthop_route->nbr) {
-			continue;
+		if (nexthop_route->nbr) {
+			nbr_nexthop_put(nexthop_route->nbr);
 		}
 
-		nbr_nexthop_put(nexthop_route->nbr);
+		put_nexthop_route(nexthop_route);
 	}
 
 	nbr_free(nbr);
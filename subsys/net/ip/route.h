@@ -41,10 +41,9 @@ struct net_route_nexthop {
  * @brief Route entry to a specific neighbor.
  */
 struct net_route_entry {
-	/** Node information. The routes are also in separate list in
-	 * order to keep track which one of them is the oldest so that
-	 * we can remove it if we run out of available routes.
-	 * The oldest one is the last entry in the list.
+	/** Node information. The routes with the same prefix, on different
+	 * network interfaces, are linked together in the prefix trie that
+	 * is used for the longest prefix match.
 	 */
 	sys_snode_t node;
 
@@ -57,6 +56,12 @@ struct net_route_entry {
 	/** IPv6 address/prefix of the route. */
 	struct in6_addr addr;
 
+	/** Last time the route was looked up or added, as a sequence number.
+	 * The least recently used route is removed if we run out of
+	 * available routes.
+	 */
+	uint32_t last_use;
+
 	/** IPv6 address/prefix length. */
 	uint8_t prefix_len;
 };
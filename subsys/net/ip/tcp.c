@@ -1586,6 +1586,14 @@ int net_tcp_update_recv_wnd(struct net_context *context, int32_t delta)
 	return 0;
 }
 
+struct k_sem *net_tcp_tx_sem_get(struct net_context *context)
+{
+	ARG_UNUSED(context);
+
+	/* The send window is not tracked, data is always queued */
+	return NULL;
+}
+
 static int send_reset(struct net_context *context, struct sockaddr *local,
 		      struct sockaddr *remote);
 
@@ -2758,6 +2766,7 @@ struct net_tcp_hdr *net_tcp_input(struct net_pkt *pkt,
 
 	if (IS_ENABLED(CONFIG_NET_TCP_CHECKSUM) &&
 	    net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
+	    !net_pkt_is_chksum_done(pkt) &&
 	    net_calc_chksum_tcp(pkt) != 0U) {
 		NET_DBG("DROP: checksum mismatch");
 		goto drop;
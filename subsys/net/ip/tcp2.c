@@ -15,6 +15,8 @@ LOG_MODULE_REGISTER(net_tcp, CONFIG_NET_TCP_LOG_LEVEL);
 #include <net/net_pkt.h>
 #include <net/net_context.h>
 #include <net/udp.h>
+#include <net/socket.h>
+#include <sys/fdtable.h>
 #include "ipv4.h"
 #include "ipv6.h"
 #include "connection.h"
@@ -313,6 +315,9 @@ static int tcp_conn_unref(struct tcp *conn)
 					-ECONNRESET, conn->recv_user_data);
 	}
 
+	/* Wake up a sender waiting for the send window */
+	k_sem_give(&conn->tx_sem);
+
 	conn->context->tcp = NULL;
 
 	net_context_unref(conn->context);
@@ -646,6 +651,11 @@ static void tcp_out_ext(struct tcp *conn, uint8_t flags, struct net_pkt *data,
 	}
 
 	if (data) {
+		if (net_pkt_get_len(data) > conn_mss(conn)) {
+			/* Let the L2 or the device do the segmentation */
+			net_pkt_set_gso_size(pkt, conn_mss(conn));
+		}
+
 		/* Append the data buffer to the pkt */
 		net_pkt_append_buffer(pkt, data->buffer);
 		data->buffer = NULL;
@@ -689,9 +699,14 @@ static void tcp_out(struct tcp *conn, uint8_t flags)
 	tcp_out_ext(conn, flags, NULL /* no data */, conn->seq);
 }
 
+/* Acknowledged data is dropped by advancing the buffers instead of moving
+ * the remaining data, which can be the application's own memory when it
+ * was sent without copying.
+ */
 static int tcp_pkt_pull(struct net_pkt *pkt, size_t len)
 {
 	int total = net_pkt_get_len(pkt);
+	struct net_buf *buf;
 	int ret = 0;
 
 	if (len > total) {
@@ -699,10 +714,22 @@ static int tcp_pkt_pull(struct net_pkt *pkt, size_t len)
 		goto out;
 	}
 
-	net_pkt_cursor_init(pkt);
-	net_pkt_set_overwrite(pkt, true);
-	net_pkt_pull(pkt, len);
+	while (len) {
+		buf = pkt->buffer;
+
+		if (buf->len > len) {
+			net_buf_pull(buf, len);
+			break;
+		}
+
+		len -= buf->len;
+		pkt->buffer = buf->frags;
+		buf->frags = NULL;
+		net_buf_unref(buf);
+	}
+
 	net_pkt_trim_buffer(pkt);
+	net_pkt_cursor_init(pkt);
  out:
 	return ret;
 }
@@ -730,6 +757,30 @@ static bool tcp_window_full(struct tcp *conn)
 	return window_full;
 }
 
+/* No more data is queued than the receiver's window can take */
+static bool tcp_send_queue_full(struct tcp *conn)
+{
+	return conn->send_data_total >= conn->send_win;
+}
+
+/* Keep the tx_sem available while more data can be queued. Called with
+ * conn->lock held whenever the queued data or the send window change.
+ */
+static void tcp_tx_window_update(struct tcp *conn)
+{
+	if (tcp_send_queue_full(conn)) {
+		(void)k_sem_take(&conn->tx_sem, K_NO_WAIT);
+		return;
+	}
+
+	if (k_sem_count_get(&conn->tx_sem) == 0) {
+		k_sem_give(&conn->tx_sem);
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+		z_fd_notify(&conn->context->poll_notifiers, ZSOCK_POLLOUT);
+#endif
+	}
+}
+
 static int tcp_unsent_len(struct tcp *conn)
 {
 	int unsent_len;
@@ -748,6 +799,16 @@ static int tcp_unsent_len(struct tcp *conn)
 	return unsent_len;
 }
 
+static int tcp_seg_max(struct tcp *conn)
+{
+#if defined(CONFIG_NET_TCP_GSO)
+	if (!net_if_need_tcp_segmentation(conn->iface)) {
+		return MAX(CONFIG_NET_TCP_GSO_MAX_SIZE, conn_mss(conn));
+	}
+#endif
+	return conn_mss(conn);
+}
+
 static int tcp_send_data(struct tcp *conn)
 {
 	int ret = 0;
@@ -757,9 +818,30 @@ static int tcp_send_data(struct tcp *conn)
 	pos = conn->unacked_len;
 	len = MIN3(conn->send_data_total - conn->unacked_len,
 		   conn->send_win - conn->unacked_len,
-		   conn_mss(conn));
+		   tcp_seg_max(conn));
+
+	if (len > conn_mss(conn)) {
+		/* Oversized segment, do not bind the buffer allocation to
+		 * the interface as that would cap it to the MTU.
+		 */
+		pkt = tcp_pkt_alloc(conn, 0);
+		if (pkt && net_pkt_alloc_buffer(pkt, len, 0,
+						TCP_PKT_ALLOC_TIMEOUT) < 0) {
+			tcp_pkt_unref(pkt);
+			pkt = NULL;
+		}
+	} else {
+		pkt = tcp_pkt_alloc(conn, len);
+
+		/* The buffer is capped to the interface MTU, which can be
+		 * smaller than the MSS when the peer did not announce one.
+		 */
+		if (pkt) {
+			len = MIN(len, net_pkt_available_payload_buffer(
+					  pkt, IPPROTO_TCP));
+		}
+	}
 
-	pkt = tcp_pkt_alloc(conn, len);
 	if (!pkt) {
 		NET_ERR("conn: %p packet allocation failed, len=%d", conn, len);
 		ret = -ENOBUFS;
@@ -889,6 +971,7 @@ static struct tcp *tcp_conn_alloc(void)
 	k_delayed_work_init(&conn->send_data_timer, tcp_resend_data);
 
 	k_sem_init(&conn->connect_sem, 0, UINT_MAX);
+	k_sem_init(&conn->tx_sem, 1, 1);
 	conn->in_connect = false;
 
 	tcp_conn_ref(conn);
@@ -1108,6 +1191,7 @@ static void tcp_in(struct tcp *conn, struct net_pkt *pkt)
 
 	if (th) {
 		conn->send_win = ntohs(th->th_win);
+		tcp_tx_window_update(conn);
 	}
 
 	if (FL(&fl, &, RST)) {
@@ -1228,6 +1312,8 @@ next_state:
 				conn_state(conn, TCP_CLOSED);
 				break;
 			}
+
+			tcp_tx_window_update(conn);
 		}
 
 		if (th && len) {
@@ -1358,6 +1444,13 @@ int net_tcp_queue_data(struct net_context *context, struct net_pkt *pkt)
 
 	k_mutex_lock(&conn->lock, K_FOREVER);
 
+	if (tcp_send_queue_full(conn)) {
+		/* The caller keeps the packet and waits for the tx_sem */
+		k_mutex_unlock(&conn->lock);
+		ret = -EAGAIN;
+		goto out;
+	}
+
 	len = net_pkt_get_len(pkt);
 
 	net_pkt_append_buffer(conn->send_data, pkt->buffer);
@@ -1374,11 +1467,20 @@ int net_tcp_queue_data(struct net_context *context, struct net_pkt *pkt)
 		goto out;
 	}
 
+	tcp_tx_window_update(conn);
+
 	k_mutex_unlock(&conn->lock);
  out:
 	return ret;
 }
 
+struct k_sem *net_tcp_tx_sem_get(struct net_context *context)
+{
+	struct tcp *conn = context->tcp;
+
+	return conn ? &conn->tx_sem : NULL;
+}
+
 /* net context is about to send out queued data - inform caller only */
 int net_tcp_send_data(struct net_context *context, net_context_send_cb_t cb,
 		      void *user_data)
@@ -1621,6 +1723,7 @@ struct net_tcp_hdr *net_tcp_input(struct net_pkt *pkt,
 
 	if (IS_ENABLED(CONFIG_NET_TCP_CHECKSUM) &&
 			net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
+			!net_pkt_is_chksum_done(pkt) &&
 			net_calc_chksum_tcp(pkt) != 0U) {
 		NET_DBG("DROP: checksum mismatch");
 		goto drop;
@@ -202,6 +202,7 @@ struct tcp { /* TCP connection */
 	struct k_delayed_work timewait_timer;
 	struct net_if *iface;
 	struct k_sem connect_sem; /* semaphore for blocking connect */
+	struct k_sem tx_sem; /* available while the send window has room */
 	bool in_connect;
 	net_tcp_accept_cb_t accept_cb;
 	atomic_t ref_count;
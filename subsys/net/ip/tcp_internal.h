@@ -420,7 +420,8 @@ static inline int net_tcp_send_data(struct net_context *context,
  * @param context TCP context
  * @param pkt Packet
  *
- * @return 0 if ok, < 0 if error
+ * @return 0 if ok, -EAGAIN if the send window of the peer is full and
+ * the packet was not queued, other < 0 if error
  */
 #if defined(CONFIG_NET_NATIVE_TCP)
 int net_tcp_queue_data(struct net_context *context, struct net_pkt *pkt);
@@ -661,6 +662,28 @@ static inline int net_tcp_update_recv_wnd(struct net_context *context,
 }
 #endif
 
+/**
+ * @brief Get the TCP transmit semaphore
+ *
+ * The semaphore is available while data can be queued for transmission,
+ * i.e. while the send window of the peer is not full.
+ *
+ * @param context Network context
+ *
+ * @return Semaphore, or NULL if the context has no TCP connection or the
+ *         send window is not tracked
+ */
+#if defined(CONFIG_NET_NATIVE_TCP)
+struct k_sem *net_tcp_tx_sem_get(struct net_context *context);
+#else
+static inline struct k_sem *net_tcp_tx_sem_get(struct net_context *context)
+{
+	ARG_UNUSED(context);
+
+	return NULL;
+}
+#endif
+
 /**
  * @brief Initialize TCP parts of a context
  *
@@ -28,6 +28,7 @@ LOG_MODULE_REGISTER(net_ethernet, CONFIG_NET_L2_ETHERNET_LOG_LEVEL);
 #include "arp.h"
 #include "eth_stats.h"
 #include "net_private.h"
+#include "ipv4.h"
 #include "ipv6.h"
 #include "ipv4_autoconf_internal.h"
 
@@ -555,18 +556,311 @@ static void ethernet_remove_l2_header(struct net_pkt *pkt)
 	net_pkt_frag_unref(buf);
 }
 
+#if defined(CONFIG_NET_ETHERNET_TX_BURST)
+/* Packets waiting to be passed to the driver, one burst per Tx queue.
+ * A burst is only accessed from the thread of its Tx queue.
+ */
+static struct ethernet_tx_burst {
+	struct k_work flush;
+	struct net_if *iface;
+	struct net_pkt *pkts[CONFIG_NET_ETHERNET_TX_BURST_SIZE];
+	int count;
+} tx_bursts[NET_TC_TX_COUNT];
+
+static void ethernet_tx_burst_flush(struct ethernet_tx_burst *burst)
+{
+	const struct device *dev;
+	const struct ethernet_api *api;
+	int i = 0;
+	int ret;
+
+	if (!burst->count) {
+		return;
+	}
+
+	dev = net_if_get_device(burst->iface);
+	api = dev->api;
+
+	while (i < burst->count) {
+		ret = api->send_burst(dev, &burst->pkts[i], burst->count - i);
+		if (ret <= 0) {
+			/* Drop the packet the driver failed on and go on
+			 * with the rest.
+			 */
+			eth_stats_update_errors_tx(burst->iface);
+			i++;
+			continue;
+		}
+
+		for (ret = MIN(ret, burst->count - i); ret > 0; ret--, i++) {
+			ethernet_update_tx_stats(burst->iface, burst->pkts[i]);
+		}
+	}
+
+	for (i = 0; i < burst->count; i++) {
+		ethernet_remove_l2_header(burst->pkts[i]);
+		net_pkt_unref(burst->pkts[i]);
+	}
+
+	burst->count = 0;
+}
+
+static void ethernet_tx_burst_work(struct k_work *work)
+{
+	ethernet_tx_burst_flush(CONTAINER_OF(work, struct ethernet_tx_burst,
+					     flush));
+}
+
+/* Add the packet to the burst of its Tx queue. The burst is passed to the
+ * driver when it is full or when the Tx queue has no more packets, which
+ * is checked again by a flush work item queued behind them. Returns false
+ * if the packet must be sent on its own.
+ */
+static bool ethernet_tx_burst_add(struct net_if *iface, int tc,
+				  struct net_pkt *pkt)
+{
+	const struct ethernet_api *api = net_if_get_device(iface)->api;
+	struct ethernet_tx_burst *burst = &tx_bursts[tc];
+
+	if (burst->count && burst->iface != iface) {
+		ethernet_tx_burst_flush(burst);
+	}
+
+	/* Packets somebody else holds a reference to, like TCP segments
+	 * waiting for an ack, must get their L2 header removed before we
+	 * return. gPTP needs its timestamp right away.
+	 */
+	if (!api->send_burst || atomic_get(&pkt->atomic_ref) != 1 ||
+	    net_pkt_is_gptp(pkt)) {
+		/* Keep the order of the packets */
+		ethernet_tx_burst_flush(burst);
+		return false;
+	}
+
+	if (!burst->flush.handler) {
+		k_work_init(&burst->flush, ethernet_tx_burst_work);
+	}
+
+	burst->iface = iface;
+	burst->pkts[burst->count++] = pkt;
+
+	if (burst->count == ARRAY_SIZE(burst->pkts) ||
+	    net_tc_tx_queue_is_empty(tc)) {
+		ethernet_tx_burst_flush(burst);
+	} else {
+		net_tc_submit_work_to_tx_queue(tc, &burst->flush);
+	}
+
+	return true;
+}
+#else
+static inline bool ethernet_tx_burst_add(struct net_if *iface, int tc,
+					 struct net_pkt *pkt)
+{
+	return false;
+}
+#endif /* CONFIG_NET_ETHERNET_TX_BURST */
+
+static int ethernet_send(struct net_if *iface, struct net_pkt *pkt);
+
+#if defined(CONFIG_NET_ETHERNET_GSO)
+#define GSO_TCP_FLAGS_LAST	(0x01 | 0x08) /* FIN and PSH */
+
+static struct net_pkt *ethernet_gso_alloc(struct net_if *iface,
+					  struct net_pkt *pkt, size_t len)
+{
+	struct net_pkt *seg;
+
+	seg = net_pkt_alloc_with_buffer(iface, len, AF_UNSPEC, 0,
+					NET_BUF_TIMEOUT);
+	if (!seg) {
+		return NULL;
+	}
+
+	net_pkt_set_family(seg, net_pkt_family(pkt));
+	net_pkt_set_ip_hdr_len(seg, net_pkt_ip_hdr_len(pkt));
+	net_pkt_set_priority(seg, net_pkt_priority(pkt));
+	net_pkt_set_vlan_tci(seg, net_pkt_vlan_tci(pkt));
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(pkt) == AF_INET) {
+		net_pkt_set_ipv4_ttl(seg, net_pkt_ipv4_ttl(pkt));
+		net_pkt_set_ipv4_opts_len(seg, net_pkt_ipv4_opts_len(pkt));
+	} else if (IS_ENABLED(CONFIG_NET_IPV6) &&
+		   net_pkt_family(pkt) == AF_INET6) {
+		net_pkt_set_ipv6_hop_limit(seg, net_pkt_ipv6_hop_limit(pkt));
+		net_pkt_set_ipv6_ext_len(seg, net_pkt_ipv6_ext_len(pkt));
+		net_pkt_set_ipv6_hdr_prev(seg, net_pkt_ipv6_hdr_prev(pkt));
+		net_pkt_set_ipv6_next_hdr(seg, net_pkt_ipv6_next_hdr(pkt));
+	}
+
+	memcpy(net_pkt_lladdr_src(seg), net_pkt_lladdr_src(pkt),
+	       sizeof(struct net_linkaddr));
+	memcpy(net_pkt_lladdr_dst(seg), net_pkt_lladdr_dst(pkt),
+	       sizeof(struct net_linkaddr));
+
+	return seg;
+}
+
+/* Build one MSS sized frame out of the oversized segment: copy the IP and
+ * TCP headers, then the payload slice, and fix up the sequence number,
+ * the flags, the lengths and the checksums.
+ */
+static struct net_pkt *ethernet_gso_segment(struct net_if *iface,
+					    struct net_pkt *pkt,
+					    size_t hdr_len, size_t offset,
+					    size_t len, bool last)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(tcp_access, struct net_tcp_hdr);
+	size_t ip_len = net_pkt_ip_hdr_len(pkt) + net_pkt_ip_opts_len(pkt);
+	struct net_tcp_hdr *tcp_hdr;
+	struct net_pkt *seg;
+	int ret;
+
+	seg = ethernet_gso_alloc(iface, pkt, hdr_len + len);
+	if (!seg) {
+		return NULL;
+	}
+
+	net_pkt_cursor_init(pkt);
+
+	if (net_pkt_copy(seg, pkt, hdr_len) ||
+	    net_pkt_skip(pkt, offset) ||
+	    net_pkt_copy(seg, pkt, len)) {
+		goto drop;
+	}
+
+	net_pkt_cursor_init(seg);
+	net_pkt_set_overwrite(seg, true);
+
+	if (net_pkt_skip(seg, ip_len)) {
+		goto drop;
+	}
+
+	tcp_hdr = (struct net_tcp_hdr *)net_pkt_get_data(seg, &tcp_access);
+	if (!tcp_hdr) {
+		goto drop;
+	}
+
+	sys_put_be32(sys_get_be32(tcp_hdr->seq) + offset, tcp_hdr->seq);
+
+	if (!last) {
+		tcp_hdr->flags &= ~GSO_TCP_FLAGS_LAST;
+	}
+
+	if (net_pkt_set_data(seg, &tcp_access)) {
+		goto drop;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(seg) == AF_INET) {
+		NET_IPV4_HDR(seg)->chksum = 0U;
+	}
+
+	net_pkt_cursor_init(seg);
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(seg) == AF_INET) {
+		ret = net_ipv4_finalize(seg, IPPROTO_TCP);
+	} else {
+		ret = net_ipv6_finalize(seg, IPPROTO_TCP);
+	}
+
+	if (ret < 0) {
+		goto drop;
+	}
+
+	return seg;
+drop:
+	net_pkt_unref(seg);
+	return NULL;
+}
+
+/* Software fallback for devices without TCP segmentation offload: the
+ * oversized segment is split here, as late as possible, so that the rest
+ * of the stack only processed it once.
+ */
+static int ethernet_gso_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(tcp_access, struct net_tcp_hdr);
+	size_t ip_len = net_pkt_ip_hdr_len(pkt) + net_pkt_ip_opts_len(pkt);
+	size_t mss = net_pkt_gso_size(pkt);
+	size_t hdr_len, payload_len, offset;
+	struct net_tcp_hdr *tcp_hdr;
+	int sent = 0;
+	int ret;
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+
+	if (net_pkt_skip(pkt, ip_len)) {
+		return -ENOBUFS;
+	}
+
+	tcp_hdr = (struct net_tcp_hdr *)net_pkt_get_data(pkt, &tcp_access);
+	if (!tcp_hdr) {
+		return -ENOBUFS;
+	}
+
+	hdr_len = ip_len + 4 * (tcp_hdr->offset >> 4);
+	payload_len = net_pkt_get_len(pkt) - hdr_len;
+
+	NET_DBG("Segmenting %zu bytes into %zu byte frames", payload_len, mss);
+
+	for (offset = 0; offset < payload_len; offset += mss) {
+		size_t len = MIN(mss, payload_len - offset);
+		struct net_pkt *seg;
+
+		seg = ethernet_gso_segment(iface, pkt, hdr_len, offset, len,
+					   offset + len == payload_len);
+		if (!seg) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		ret = ethernet_send(iface, seg);
+		if (ret < 0) {
+			net_pkt_unref(seg);
+			goto out;
+		}
+
+		sent += ret;
+	}
+
+	ret = sent;
+out:
+	if (sent == 0) {
+		/* Nothing went out, the caller frees the original pkt */
+		return ret;
+	}
+
+	/* Missing frames are recovered by TCP retransmission */
+	net_pkt_unref(pkt);
+
+	return sent;
+}
+#endif /* CONFIG_NET_ETHERNET_GSO */
+
 static int ethernet_send(struct net_if *iface, struct net_pkt *pkt)
 {
 	const struct ethernet_api *api = net_if_get_device(iface)->api;
 	struct ethernet_context *ctx = net_if_l2_data(iface);
+	/* Tx queue we are running in, pkt might be replaced by an ARP
+	 * request below.
+	 */
+	int tc = net_tx_priority2tc(net_pkt_priority(pkt));
 	uint16_t ptype;
-	int ret;
+	int ret, len;
 
 	if (!api) {
 		ret = -ENOENT;
 		goto error;
 	}
 
+#if defined(CONFIG_NET_ETHERNET_GSO)
+	if (net_pkt_gso_size(pkt) &&
+	    !(net_eth_get_hw_capabilities(iface) & ETHERNET_HW_TX_TSO)) {
+		return ethernet_gso_send(iface, pkt);
+	}
+#endif
+
 	if (IS_ENABLED(CONFIG_NET_IPV4) &&
 	    net_pkt_family(pkt) == AF_INET) {
 		struct net_pkt *tmp;
@@ -659,6 +953,16 @@ static int ethernet_send(struct net_if *iface, struct net_pkt *pkt)
 	net_pkt_cursor_init(pkt);
 
 send:
+	/* The burst may be flushed, and pkt freed, before the call
+	 * returns.
+	 */
+	len = net_pkt_get_len(pkt);
+
+	if (ethernet_tx_burst_add(iface, tc, pkt)) {
+		/* Errors are only visible in the statistics from now on */
+		return len;
+	}
+
 	ret = api->send(net_if_get_device(iface), pkt);
 	if (ret != 0) {
 		eth_stats_update_errors_tx(iface);
@@ -668,7 +972,7 @@ send:
 
 	ethernet_update_tx_stats(iface, pkt);
 
-	ret = net_pkt_get_len(pkt);
+	ret = len;
 	ethernet_remove_l2_header(pkt);
 
 	net_pkt_unref(pkt);
@@ -689,6 +689,9 @@ uint8_t coap_header_get_code(const struct coap_packet *cpkt)
 	case COAP_METHOD_POST:
 	case COAP_METHOD_PUT:
 	case COAP_METHOD_DELETE:
+	case COAP_METHOD_FETCH:
+	case COAP_METHOD_PATCH:
+	case COAP_METHOD_IPATCH:
 
 	/* All the defined response codes */
 	case COAP_RESPONSE_CODE_OK:
@@ -822,6 +825,22 @@ static bool is_request(const struct coap_packet *cpkt)
 	return !(code & ~COAP_REQUEST_MASK);
 }
 
+static int call_method(struct coap_resource *resource,
+		       struct coap_packet *cpkt,
+		       struct sockaddr *addr, socklen_t addr_len)
+{
+	coap_method_t method;
+	uint8_t code;
+
+	code = coap_header_get_code(cpkt);
+	method = method_from_code(resource, code);
+	if (!method) {
+		return -EPERM;
+	}
+
+	return method(resource, cpkt, addr, addr_len);
+}
+
 int coap_handle_request(struct coap_packet *cpkt,
 			struct coap_resource *resources,
 			struct coap_option *options,
@@ -836,26 +855,163 @@ int coap_handle_request(struct coap_packet *cpkt,
 
 	/* FIXME: deal with hierarchical resources */
 	for (resource = resources; resource && resource->path; resource++) {
-		coap_method_t method;
-		uint8_t code;
-
 		if (!uri_path_eq(cpkt, resource->path, options, opt_num)) {
 			continue;
 		}
 
-		code = coap_header_get_code(cpkt);
-		method = method_from_code(resource, code);
-		if (!method) {
-			return -EPERM;
-		}
-
-		return method(resource, cpkt, addr, addr_len);
+		return call_method(resource, cpkt, addr, addr_len);
 	}
 
 	NET_DBG("%d", __LINE__);
 	return -ENOENT;
 }
 
+/* FNV-1a over the length and the bytes of each path segment */
+#define PATH_HASH_INIT 2166136261U
+#define PATH_HASH_PRIME 16777619U
+
+static uint32_t path_hash_add(uint32_t hash, const uint8_t *segment,
+			      uint16_t len)
+{
+	uint16_t i;
+
+	hash = (hash ^ (len & 0xff)) * PATH_HASH_PRIME;
+	hash = (hash ^ (len >> 8)) * PATH_HASH_PRIME;
+
+	for (i = 0U; i < len; i++) {
+		hash = (hash ^ segment[i]) * PATH_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+static bool path_has_wildcard(const char * const *path)
+{
+	if (!IS_ENABLED(CONFIG_COAP_URI_WILDCARD)) {
+		return false;
+	}
+
+	for (; *path; path++) {
+		if (!strcmp(*path, "+") || !strcmp(*path, "#")) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int coap_resource_index_init(struct coap_resource_index *index,
+			     struct coap_resource *resources,
+			     struct coap_resource **buckets,
+			     size_t bucket_count)
+{
+	struct coap_resource **wildcard_tail = &index->wildcards;
+	struct coap_resource *resource;
+	const char * const *path;
+	size_t count = 0;
+	size_t i;
+
+	if (bucket_count == 0 || (bucket_count & (bucket_count - 1))) {
+		return -EINVAL;
+	}
+
+	index->resources = resources;
+	index->buckets = buckets;
+	index->bucket_count = bucket_count;
+	index->wildcards = NULL;
+
+	for (i = 0; i < bucket_count; i++) {
+		buckets[i] = NULL;
+	}
+
+	for (resource = resources; resource && resource->path; resource++) {
+		resource->index_next = NULL;
+		count++;
+
+		if (path_has_wildcard(resource->path)) {
+			*wildcard_tail = resource;
+			wildcard_tail = &resource->index_next;
+			continue;
+		}
+
+		resource->path_hash = PATH_HASH_INIT;
+
+		for (path = resource->path; *path; path++) {
+			resource->path_hash =
+				path_hash_add(resource->path_hash,
+					      (const uint8_t *)*path,
+					      strlen(*path));
+		}
+	}
+
+	/* Chain the resources in reverse order, so that each bucket keeps
+	 * the array order and the first matching resource wins, as with
+	 * coap_handle_request().
+	 */
+	for (i = count; i > 0; i--) {
+		resource = &resources[i - 1];
+
+		if (path_has_wildcard(resource->path)) {
+			continue;
+		}
+
+		resource->index_next =
+			buckets[resource->path_hash & (bucket_count - 1)];
+		buckets[resource->path_hash & (bucket_count - 1)] = resource;
+	}
+
+	return 0;
+}
+
+int coap_handle_request_index(struct coap_packet *cpkt,
+			      const struct coap_resource_index *index,
+			      struct coap_option *options,
+			      uint8_t opt_num,
+			      struct sockaddr *addr, socklen_t addr_len)
+{
+	struct coap_resource *resource;
+	struct coap_resource *found = NULL;
+	uint32_t hash = PATH_HASH_INIT;
+	uint8_t i;
+
+	if (!is_request(cpkt)) {
+		return 0;
+	}
+
+	for (i = 0U; i < opt_num; i++) {
+		if (options[i].delta == COAP_OPTION_URI_PATH) {
+			hash = path_hash_add(hash, options[i].value,
+					     options[i].len);
+		}
+	}
+
+	for (resource = index->buckets[hash & (index->bucket_count - 1)];
+	     resource; resource = resource->index_next) {
+		if (resource->path_hash == hash &&
+		    uri_path_eq(cpkt, resource->path, options, opt_num)) {
+			found = resource;
+			break;
+		}
+	}
+
+	/* A wildcard resource placed before the exact match wins */
+	for (resource = index->wildcards;
+	     resource && (!found || resource < found);
+	     resource = resource->index_next) {
+		if (uri_path_eq(cpkt, resource->path, options, opt_num)) {
+			found = resource;
+			break;
+		}
+	}
+
+	if (!found) {
+		NET_DBG("%d", __LINE__);
+		return -ENOENT;
+	}
+
+	return call_method(found, cpkt, addr, addr_len);
+}
+
 int coap_block_transfer_init(struct coap_block_context *ctx,
 			      enum coap_block_size block_size,
 			      size_t total_size)
@@ -1070,6 +1226,159 @@ size_t coap_next_block(const struct coap_packet *cpkt,
 	return ctx->current;
 }
 
+int coap_block_transfer_setup(struct coap_block_transfer *xfer,
+			      enum coap_block_size block_size,
+			      uint8_t *body, size_t size, size_t len)
+{
+	if (len > size) {
+		return -EINVAL;
+	}
+
+	xfer->body = body;
+	xfer->size = size;
+	xfer->len = len;
+
+	return coap_block_transfer_init(&xfer->ctx, block_size, len);
+}
+
+int coap_block_transfer_recv(struct coap_block_transfer *xfer,
+			     const struct coap_packet *cpkt)
+{
+	enum coap_block_size block_size = xfer->ctx.block_size;
+	const uint8_t *payload;
+	uint16_t payload_len;
+	size_t offset = 0;
+	bool more = false;
+	int block, size;
+
+	if (is_request(cpkt)) {
+		block = coap_get_option_int(cpkt, COAP_OPTION_BLOCK1);
+		size = coap_get_option_int(cpkt, COAP_OPTION_SIZE1);
+	} else {
+		block = coap_get_option_int(cpkt, COAP_OPTION_BLOCK2);
+		size = coap_get_option_int(cpkt, COAP_OPTION_SIZE2);
+	}
+
+	payload = coap_packet_get_payload(cpkt, &payload_len);
+
+	if (block >= 0) {
+		/* Size exponent 7 is reserved */
+		if (GET_BLOCK_SIZE(block) > COAP_BLOCK_1024) {
+			return -EINVAL;
+		}
+
+		block_size = GET_BLOCK_SIZE(block);
+		offset = GET_NUM(block) << (block_size + 4);
+		more = GET_MORE(block);
+
+		/* All blocks but the last one are full */
+		if (more ? payload_len != coap_block_size_to_bytes(block_size) :
+		    payload_len > coap_block_size_to_bytes(block_size)) {
+			return -EINVAL;
+		}
+	}
+
+	if (offset == 0) {
+		xfer->len = 0;
+		xfer->ctx.total_size = 0;
+	}
+
+	if (offset != xfer->len) {
+		return -EINVAL;
+	}
+
+	if (payload_len > xfer->size - xfer->len) {
+		return -ENOMEM;
+	}
+
+	memcpy(xfer->body + xfer->len, payload, payload_len);
+	xfer->len += payload_len;
+
+	if (size > 0) {
+		xfer->ctx.total_size = size;
+	}
+
+	/* Blocks of the peer larger than ours are accepted, and our block
+	 * size is then given back to it.
+	 */
+	xfer->ctx.block_size = MIN(block_size, xfer->ctx.block_size);
+	xfer->ctx.current = is_request(cpkt) ? offset : xfer->len;
+
+	return more ? 0 : 1;
+}
+
+int coap_block_transfer_send(struct coap_block_transfer *xfer,
+			     struct coap_packet *cpkt,
+			     const struct coap_packet *peer)
+{
+	enum coap_block_size block_size = xfer->ctx.block_size;
+	size_t offset = 0;
+	uint16_t len;
+	int block;
+	int r;
+
+	if (is_request(cpkt)) {
+		/* Block1, continue after the block sent before */
+		if (peer) {
+			block = coap_get_option_int(peer, COAP_OPTION_BLOCK1);
+			if (block < 0) {
+				return -EINVAL;
+			}
+
+			offset = xfer->ctx.current +
+				 coap_block_size_to_bytes(block_size);
+			block_size = MIN(GET_BLOCK_SIZE(block), block_size);
+		}
+	} else if (peer) {
+		/* Block2, send the block asked for */
+		block = coap_get_option_int(peer, COAP_OPTION_BLOCK2);
+		if (block >= 0) {
+			offset = GET_NUM(block) << (GET_BLOCK_SIZE(block) + 4);
+			block_size = MIN(GET_BLOCK_SIZE(block), block_size);
+		}
+	}
+
+	if (offset > xfer->len || (offset == xfer->len && offset > 0)) {
+		return -EINVAL;
+	}
+
+	len = MIN(coap_block_size_to_bytes(block_size), xfer->len - offset);
+
+	xfer->ctx.block_size = block_size;
+	xfer->ctx.current = offset;
+	xfer->ctx.total_size = xfer->len;
+
+	if (is_request(cpkt)) {
+		r = coap_append_block1_option(cpkt, &xfer->ctx);
+		if (r >= 0 && offset == 0) {
+			r = coap_append_size1_option(cpkt, &xfer->ctx);
+		}
+	} else {
+		r = coap_append_block2_option(cpkt, &xfer->ctx);
+		if (r >= 0 && offset == 0) {
+			r = coap_append_size2_option(cpkt, &xfer->ctx);
+		}
+	}
+
+	if (r < 0) {
+		return r;
+	}
+
+	if (len > 0) {
+		r = coap_packet_append_payload_marker(cpkt);
+		if (r < 0) {
+			return r;
+		}
+
+		r = coap_packet_append_payload(cpkt, xfer->body + offset, len);
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	return offset + len == xfer->len ? 1 : 0;
+}
+
 int coap_pending_init(struct coap_pending *pending,
 		      const struct coap_packet *request,
 		      const struct sockaddr *addr)
@@ -1436,6 +1745,22 @@ struct coap_observer *coap_find_observer_by_addr(
 	return NULL;
 }
 
+struct coap_observer *coap_find_observer(
+	struct coap_resource *resource, const struct sockaddr *addr,
+	const uint8_t *token, uint8_t tkl)
+{
+	struct coap_observer *o;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&resource->observers, o, list) {
+		if (o->tkl == tkl && !memcmp(o->token, token, tkl) &&
+		    sockaddr_equal(&o->addr, addr)) {
+			return o;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * @brief Internal initialization function for CoAP library.
  *
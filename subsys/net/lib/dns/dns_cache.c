@@ -0,0 +1,302 @@
+/** @file
+ * @brief DNS answer cache
+ *
+ * Keeps the addresses received for a name until their TTL expires so that
+ * the resolver does not need to query the servers again.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_dns_resolve, CONFIG_DNS_RESOLVER_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/crc.h>
+#include <net/net_ip.h>
+#include <net/dns_resolve.h>
+#include "dns_internal.h"
+
+#if defined(CONFIG_NET_IPV6)
+#define DNS_CACHE_ADDR_LEN sizeof(struct in6_addr)
+#else
+#define DNS_CACHE_ADDR_LEN sizeof(struct in_addr)
+#endif
+
+enum dns_cache_state {
+	DNS_CACHE_FREE = 0,
+	DNS_CACHE_VALID,
+};
+
+struct dns_cache_entry {
+	/** Addresses of the name, only the first ones if there are more
+	 * than CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS.
+	 */
+	uint8_t addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS][DNS_CACHE_ADDR_LEN];
+
+	/** Name the answers are for */
+	char name[CONFIG_DNS_RESOLVER_CACHE_NAME_LEN + 1];
+
+	/** Uptime when the entry expires, in ms */
+	int64_t expires;
+
+	/** Hash of the name, compared before the name itself */
+	uint16_t hash;
+
+	/** Query type (A or AAAA) */
+	uint8_t type;
+
+	/** Number of valid addresses, 0 for a negative entry */
+	uint8_t count;
+
+	/** enum dns_cache_state */
+	uint8_t state;
+};
+
+static struct dns_cache_entry cache[CONFIG_DNS_RESOLVER_CACHE_MAX_ENTRIES];
+static struct dns_resolve_cache_stats cache_stats;
+
+static K_MUTEX_DEFINE(cache_lock);
+
+static uint16_t cache_hash(const char *name, size_t len)
+{
+	return crc16_ansi((const uint8_t *)name, len);
+}
+
+static struct dns_cache_entry *cache_get(const char *name, size_t len,
+					 uint16_t hash,
+					 enum dns_query_type type)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].state != DNS_CACHE_FREE &&
+		    cache[i].hash == hash && cache[i].type == type &&
+		    !memcmp(cache[i].name, name, len + 1)) {
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Take a free entry, or else the entry which expires first */
+static struct dns_cache_entry *cache_alloc(void)
+{
+	struct dns_cache_entry *oldest = NULL;
+	int64_t now = k_uptime_get();
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].state == DNS_CACHE_FREE) {
+			return &cache[i];
+		}
+
+		if (!oldest || cache[i].expires < oldest->expires) {
+			oldest = &cache[i];
+		}
+	}
+
+	if (oldest && oldest->expires > now) {
+		cache_stats.evictions++;
+	}
+
+	return oldest;
+}
+
+static void cache_fill_info(struct dns_addrinfo *info,
+			    enum dns_query_type type, const uint8_t *addr)
+{
+	(void)memset(info, 0, sizeof(*info));
+
+	if (type == DNS_QUERY_TYPE_A) {
+		memcpy(&net_sin(&info->ai_addr)->sin_addr, addr,
+		       sizeof(struct in_addr));
+		info->ai_family = AF_INET;
+		info->ai_addr.sa_family = AF_INET;
+		info->ai_addrlen = sizeof(struct sockaddr_in);
+	}
+#if defined(CONFIG_NET_IPV6)
+	else {
+		memcpy(&net_sin6(&info->ai_addr)->sin6_addr, addr,
+		       sizeof(struct in6_addr));
+		info->ai_family = AF_INET6;
+		info->ai_addr.sa_family = AF_INET6;
+		info->ai_addrlen = sizeof(struct sockaddr_in6);
+	}
+#endif
+}
+
+int dns_cache_find(const char *name, enum dns_query_type type,
+		   dns_resolve_cb_t cb, void *user_data)
+{
+	uint8_t addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS][DNS_CACHE_ADDR_LEN];
+	struct dns_cache_entry *entry;
+	struct dns_addrinfo info;
+	size_t len = strlen(name);
+	int count;
+	int i;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	entry = NULL;
+	if (len <= CONFIG_DNS_RESOLVER_CACHE_NAME_LEN) {
+		entry = cache_get(name, len, cache_hash(name, len), type);
+	}
+
+	if (entry && entry->expires <= k_uptime_get()) {
+		NET_DBG("Cached answer for %s type %d expired",
+			log_strdup(name), type);
+		entry->state = DNS_CACHE_FREE;
+		entry = NULL;
+	}
+
+	if (!entry) {
+		cache_stats.misses++;
+		k_mutex_unlock(&cache_lock);
+		return -ENOENT;
+	}
+
+	cache_stats.hits++;
+
+	/* Copy the answer so that the callback runs without the lock */
+	count = entry->count;
+	memcpy(addr, entry->addr, count * DNS_CACHE_ADDR_LEN);
+
+	k_mutex_unlock(&cache_lock);
+
+	NET_DBG("Answering %s type %d from cache (%d addresses)",
+		log_strdup(name), type, count);
+
+	for (i = 0; i < count; i++) {
+		cache_fill_info(&info, type, addr[i]);
+		cb(DNS_EAI_INPROGRESS, &info, user_data);
+	}
+
+	cb(count ? DNS_EAI_ALLDONE : DNS_EAI_NODATA, NULL, user_data);
+
+	return 0;
+}
+
+void dns_cache_add(struct dns_cache_answer *answer,
+		   const struct dns_addrinfo *info, uint32_t ttl)
+{
+	answer->ttl = MIN(answer->ttl, ttl);
+
+	if (answer->count == CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS) {
+		return;
+	}
+
+	if (info->ai_family == AF_INET) {
+		net_ipaddr_copy(&answer->addr[answer->count].in,
+				&net_sin(&info->ai_addr)->sin_addr);
+	}
+#if defined(CONFIG_NET_IPV6)
+	else {
+		net_ipaddr_copy(&answer->addr[answer->count].in6,
+				&net_sin6(&info->ai_addr)->sin6_addr);
+	}
+#endif
+
+	answer->count++;
+}
+
+void dns_cache_done(const char *name, enum dns_query_type type,
+		    const struct dns_cache_answer *answer, int status)
+{
+	struct dns_cache_entry *entry;
+	size_t len = strlen(name);
+	uint16_t hash;
+	uint32_t ttl;
+	int count;
+	int i;
+
+	if (len > CONFIG_DNS_RESOLVER_CACHE_NAME_LEN) {
+		return;
+	}
+
+	if (status == DNS_EAI_ALLDONE) {
+		count = answer->count;
+		ttl = answer->ttl;
+	} else if (status == DNS_EAI_NODATA) {
+		count = 0;
+		ttl = CONFIG_DNS_RESOLVER_CACHE_NEGATIVE_TTL;
+	} else {
+		return;
+	}
+
+	hash = cache_hash(name, len);
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	/* The entry is written at once, so concurrent queries of the same
+	 * name only replace each other's complete answers.
+	 */
+	entry = cache_get(name, len, hash, type);
+
+	if (ttl == 0U) {
+		if (entry) {
+			entry->state = DNS_CACHE_FREE;
+		}
+
+		goto out;
+	}
+
+	if (!entry) {
+		entry = cache_alloc();
+		if (!entry) {
+			goto out;
+		}
+
+		memcpy(entry->name, name, len + 1);
+		entry->hash = hash;
+		entry->type = type;
+	}
+
+	NET_DBG("Caching %d addresses for %s type %d for %u s", count,
+		log_strdup(name), type, ttl);
+
+	for (i = 0; i < count; i++) {
+		memcpy(entry->addr[i], &answer->addr[i], DNS_CACHE_ADDR_LEN);
+	}
+
+	entry->count = count;
+	entry->expires = k_uptime_get() + (int64_t)ttl * MSEC_PER_SEC;
+	entry->state = DNS_CACHE_VALID;
+
+out:
+	k_mutex_unlock(&cache_lock);
+}
+
+void dns_cache_coalesced(void)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+	cache_stats.coalesced++;
+	k_mutex_unlock(&cache_lock);
+}
+
+void dns_resolve_cache_flush(void)
+{
+	int i;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(cache); i++) {
+		cache[i].state = DNS_CACHE_FREE;
+	}
+
+	k_mutex_unlock(&cache_lock);
+}
+
+void dns_resolve_cache_get_stats(struct dns_resolve_cache_stats *stats)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+	memcpy(stats, &cache_stats, sizeof(*stats));
+	k_mutex_unlock(&cache_lock);
+}
@@ -16,3 +16,29 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 		     int *query_idx,
 		     struct net_buf *dns_cname,
 		     uint16_t *query_hash);
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/* Answer the query from the cache. Return 0 if the callback was called,
+ * <0 if the name must be resolved.
+ */
+int dns_cache_find(const char *name, enum dns_query_type type,
+		   dns_resolve_cb_t cb, void *user_data);
+
+/* Add an answer of the pending query to its answer buffer */
+void dns_cache_add(struct dns_cache_answer *answer,
+		   const struct dns_addrinfo *info, uint32_t ttl);
+
+/* The pending query finished with status, cache its answers if it was
+ * successful.
+ */
+void dns_cache_done(const char *name, enum dns_query_type type,
+		    const struct dns_cache_answer *answer, int status);
+
+/* A query waits for the answer of an identical pending one */
+void dns_cache_coalesced(void);
+#else
+#define dns_cache_find(name, type, cb, user_data) -ENOENT
+#define dns_cache_add(answer, info, ttl)
+#define dns_cache_done(name, type, answer, status)
+#define dns_cache_coalesced()
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
@@ -82,6 +82,7 @@ static int dns_write(struct dns_resolve_context *ctx,
 		     struct net_buf *dns_data,
 		     struct net_buf *dns_qname,
 		     int hop_limit);
+static int dns_query_send(struct dns_resolve_context *ctx, int query_idx);
 
 static bool server_is_mdns(sa_family_t family, struct sockaddr *addr)
 {
@@ -361,6 +362,132 @@ static inline int get_slot_by_id(struct dns_resolve_context *ctx,
 	return -ENOENT;
 }
 
+static void dns_query_done(struct dns_resolve_context *ctx, int query_idx,
+			   int status);
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/* Find a query of the same name and type which was sent to the servers */
+static inline int get_slot_by_query(struct dns_resolve_context *ctx,
+				    int query_idx)
+{
+	struct dns_pending_query *query = &ctx->queries[query_idx];
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (i != query_idx && ctx->queries[i].cb &&
+		    ctx->queries[i].leader < 0 &&
+		    ctx->queries[i].query_type == query->query_type &&
+		    !strcmp(ctx->queries[i].query, query->query)) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/* Finish the queries waiting for the answer of the query at query_idx */
+static void dns_release_waiting(struct dns_resolve_context *ctx,
+				int query_idx, int status)
+{
+	int promoted = -1;
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (!ctx->queries[i].cb ||
+		    ctx->queries[i].leader != query_idx) {
+			continue;
+		}
+
+		/* If the query was canceled, its answer will never come so
+		 * the first waiting query is sent instead.
+		 */
+		if (status == DNS_EAI_CANCELED) {
+			if (promoted < 0) {
+				promoted = i;
+				ctx->queries[i].leader = -1;
+			} else {
+				ctx->queries[i].leader = promoted;
+			}
+
+			continue;
+		}
+
+		dns_query_done(ctx, i, status);
+	}
+
+	if (promoted < 0) {
+		return;
+	}
+
+	/* The promoted query keeps the time it has left. If it has already
+	 * expired, its own timeout handler finishes it.
+	 */
+	if (!K_TIMEOUT_EQ(ctx->queries[promoted].timeout, K_FOREVER)) {
+		k_ticks_t left = k_delayed_work_remaining_ticks(
+					&ctx->queries[promoted].timer);
+
+		if (left == 0) {
+			return;
+		}
+
+		ctx->queries[promoted].timeout = K_TICKS(left);
+	}
+
+	if (dns_query_send(ctx, promoted) < 0) {
+		dns_query_done(ctx, promoted, DNS_EAI_SYSTEM);
+	}
+}
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
+/* Pass an answer of the query to the cache and to the queries waiting
+ * for it.
+ */
+static void dns_query_answer(struct dns_resolve_context *ctx, int query_idx,
+			     struct dns_addrinfo *info, uint32_t ttl)
+{
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	int i;
+
+	dns_cache_add(&ctx->queries[query_idx].answer, info, ttl);
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (ctx->queries[i].cb && ctx->queries[i].leader == query_idx) {
+			ctx->queries[i].cb(DNS_EAI_INPROGRESS, info,
+					   ctx->queries[i].user_data);
+		}
+	}
+#else
+	ARG_UNUSED(ctx);
+	ARG_UNUSED(query_idx);
+	ARG_UNUSED(info);
+	ARG_UNUSED(ttl);
+#endif
+}
+
+/* Stop the query and give its final status to the caller */
+static void dns_query_done(struct dns_resolve_context *ctx, int query_idx,
+			   int status)
+{
+	struct dns_pending_query *query = &ctx->queries[query_idx];
+	dns_resolve_cb_t cb = query->cb;
+
+	if (k_delayed_work_remaining_get(&query->timer) > 0) {
+		k_delayed_work_cancel(&query->timer);
+	}
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	if (query->leader < 0) {
+		dns_cache_done(query->query, query->query_type,
+			       &query->answer, status);
+		dns_release_waiting(ctx, query_idx, status);
+	}
+#endif
+
+	/* Marks the end of the results */
+	query->cb = NULL;
+	cb(status, NULL, query->user_data);
+}
+
 int dns_validate_msg(struct dns_resolve_context *ctx,
 		     struct dns_msg_t *dns_msg,
 		     uint16_t *dns_id,
@@ -369,7 +496,8 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 		     uint16_t *query_hash)
 {
 	struct dns_addrinfo info = { 0 };
-	uint32_t ttl; /* RR ttl, so far it is not passed to caller */
+	uint32_t ttl; /* RR ttl, only used by the cache */
+	uint32_t chain_ttl = UINT32_MAX;
 	uint8_t *src, *addr;
 	const char *query_name;
 	int address_size;
@@ -452,20 +580,23 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 
 		switch (dns_msg->response_type) {
 		case DNS_RESPONSE_IP:
-			if (*query_idx >= 0) {
-				goto query_known;
-			}
-
-			query_name = dns_msg->msg + dns_msg->query_offset;
+			if (*query_idx < 0) {
+				query_name = dns_msg->msg +
+					dns_msg->query_offset;
 
-			/* Add \0 and query type (A or AAAA) to the hash */
-			*query_hash = crc16_ansi(query_name,
-						 strlen(query_name) + 1 + 2);
+				/* Add \0 and query type (A or AAAA) to the
+				 * hash
+				 */
+				*query_hash = crc16_ansi(query_name,
+							 strlen(query_name) +
+							 1 + 2);
 
-			*query_idx = get_slot_by_id(ctx, *dns_id, *query_hash);
-			if (*query_idx < 0) {
-				ret = DNS_EAI_SYSTEM;
-				goto quit;
+				*query_idx = get_slot_by_id(ctx, *dns_id,
+							    *query_hash);
+				if (*query_idx < 0) {
+					ret = DNS_EAI_SYSTEM;
+					goto quit;
+				}
 			}
 
 			if (ctx->queries[*query_idx].query_type ==
@@ -528,9 +659,10 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 			src = dns_msg->msg + dns_msg->response_position;
 			memcpy(addr, src, address_size);
 
-		query_known:
 			ctx->queries[*query_idx].cb(DNS_EAI_INPROGRESS, &info,
 					ctx->queries[*query_idx].user_data);
+			dns_query_answer(ctx, *query_idx, &info,
+					 MIN(ttl, chain_ttl));
 			items++;
 			break;
 
@@ -539,6 +671,11 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 			 * we will use this CNAME
 			 */
 			answer_ptr = dns_msg->response_position;
+
+			/* The addresses are valid for the lowest TTL of the
+			 * CNAME chain leading to them.
+			 */
+			chain_ttl = MIN(chain_ttl, ttl);
 			break;
 
 		default:
@@ -631,6 +768,7 @@ static int dns_read(struct dns_resolve_context *ctx,
 
 	dns_msg.msg = dns_data->data;
 	dns_msg.msg_size = data_len;
+	dns_msg.response_type = DNS_RESPONSE_INVALID;
 
 	ret = dns_validate_msg(ctx, &dns_msg, dns_id, &query_idx,
 			       dns_cname, query_hash);
@@ -642,14 +780,7 @@ static int dns_read(struct dns_resolve_context *ctx,
 		goto quit;
 	}
 
-	if (k_delayed_work_remaining_get(&ctx->queries[query_idx].timer) > 0) {
-		k_delayed_work_cancel(&ctx->queries[query_idx].timer);
-	}
-
-	/* Marks the end of the results */
-	ctx->queries[query_idx].cb(ret, NULL,
-				   ctx->queries[query_idx].user_data);
-	ctx->queries[query_idx].cb = NULL;
+	dns_query_done(ctx, query_idx, ret);
 
 	net_pkt_unref(pkt);
 
@@ -745,13 +876,7 @@ quit:
 		goto free_buf;
 	}
 
-	if (k_delayed_work_remaining_get(&ctx->queries[i].timer) > 0) {
-		k_delayed_work_cancel(&ctx->queries[i].timer);
-	}
-
-	/* Marks the end of the results */
-	ctx->queries[i].cb(ret, NULL, ctx->queries[i].user_data);
-	ctx->queries[i].cb = NULL;
+	dns_query_done(ctx, i, ret);
 
 free_buf:
 	if (dns_data) {
@@ -855,12 +980,7 @@ static int dns_resolve_cancel_with_hash(struct dns_resolve_context *ctx,
 		log_strdup(query_name), ctx->queries[i].query_type,
 		query_hash);
 
-	if (k_delayed_work_remaining_get(&ctx->queries[i].timer) > 0) {
-		k_delayed_work_cancel(&ctx->queries[i].timer);
-	}
-
-	ctx->queries[i].cb(DNS_EAI_CANCELED, NULL, ctx->queries[i].user_data);
-	ctx->queries[i].cb = NULL;
+	dns_query_done(ctx, i, DNS_EAI_CANCELED);
 
 	return 0;
 }
@@ -932,6 +1052,113 @@ static void query_timeout(struct k_work *work)
 					   pending_query->query);
 }
 
+static bool is_mdns_query(const char *query)
+{
+	const char *ptr;
+
+	if (!IS_ENABLED(CONFIG_MDNS_RESOLVER)) {
+		return false;
+	}
+
+	ptr = strrchr(query, '.');
+
+	/* Note that we memcmp() the \0 here too */
+	return ptr && !memcmp(ptr, (const void *){ ".local" }, 7);
+}
+
+static int dns_query_send(struct dns_resolve_context *ctx, int query_idx)
+{
+	struct net_buf *dns_data = NULL;
+	struct net_buf *dns_qname = NULL;
+	bool mdns_query;
+	int failure = 0;
+	uint8_t hop_limit;
+	int ret, j;
+
+	mdns_query = is_mdns_query(ctx->queries[query_idx].query);
+
+	dns_data = net_buf_alloc(&dns_msg_pool, ctx->buf_timeout);
+	if (!dns_data) {
+		ret = -ENOMEM;
+		goto quit;
+	}
+
+	dns_qname = net_buf_alloc(&dns_qname_pool, ctx->buf_timeout);
+	if (!dns_qname) {
+		ret = -ENOMEM;
+		goto quit;
+	}
+
+	ret = dns_msg_pack_qname(&dns_qname->len, dns_qname->data,
+				 DNS_MAX_NAME_LEN,
+				 ctx->queries[query_idx].query);
+	if (ret < 0) {
+		goto quit;
+	}
+
+	for (j = 0; j < SERVER_COUNT; j++) {
+		hop_limit = 0U;
+
+		if (!ctx->servers[j].net_ctx) {
+			continue;
+		}
+
+		/* If mDNS is enabled, then send .local queries only to
+		 * a well known multicast mDNS server address.
+		 */
+		if (IS_ENABLED(CONFIG_MDNS_RESOLVER) && mdns_query &&
+		    !ctx->servers[j].is_mdns) {
+			continue;
+		}
+
+		/* If llmnr is enabled, then all the queries are sent to
+		 * LLMNR multicast address unless it is a mDNS query.
+		 */
+		if (!mdns_query && IS_ENABLED(CONFIG_LLMNR_RESOLVER)) {
+			if (!ctx->servers[j].is_llmnr) {
+				continue;
+			}
+
+			hop_limit = 1U;
+		}
+
+		ret = dns_write(ctx, j, query_idx, dns_data, dns_qname,
+				hop_limit);
+		if (ret < 0) {
+			failure++;
+			continue;
+		}
+
+		/* Do one concurrent query only for each name resolve.
+		 * TODO: Change the i (query index) to do multiple concurrent
+		 *       to each server.
+		 */
+		break;
+	}
+
+	if (failure) {
+		NET_DBG("DNS query failed %d times", failure);
+
+		if (failure == j) {
+			ret = -ENOENT;
+			goto quit;
+		}
+	}
+
+	ret = 0;
+
+quit:
+	if (dns_data) {
+		net_buf_unref(dns_data);
+	}
+
+	if (dns_qname) {
+		net_buf_unref(dns_qname);
+	}
+
+	return ret;
+}
+
 int dns_resolve_name(struct dns_resolve_context *ctx,
 		     const char *query,
 		     enum dns_query_type type,
@@ -941,13 +1168,8 @@ int dns_resolve_name(struct dns_resolve_context *ctx,
 		     int32_t timeout)
 {
 	k_timeout_t tout;
-	struct net_buf *dns_data = NULL;
-	struct net_buf *dns_qname = NULL;
 	struct sockaddr addr;
-	int ret, i = -1, j = 0;
-	int failure = 0;
-	bool mdns_query = false;
-	uint8_t hop_limit;
+	int ret, i = -1;
 
 	if (!ctx || !ctx->is_used || !query || !cb) {
 		return -EINVAL;
@@ -1012,6 +1234,14 @@ int dns_resolve_name(struct dns_resolve_context *ctx,
 	}
 
 try_resolve:
+	if (!dns_cache_find(query, type, cb, user_data)) {
+		if (dns_id) {
+			*dns_id = 0U;
+		}
+
+		return 0;
+	}
+
 	i = get_cb_slot(ctx);
 	if (i < 0) {
 		return -EAGAIN;
@@ -1027,39 +1257,14 @@ try_resolve:
 
 	k_delayed_work_init(&ctx->queries[i].timer, query_timeout);
 
-	dns_data = net_buf_alloc(&dns_msg_pool, ctx->buf_timeout);
-	if (!dns_data) {
-		ret = -ENOMEM;
-		goto quit;
-	}
-
-	dns_qname = net_buf_alloc(&dns_qname_pool, ctx->buf_timeout);
-	if (!dns_qname) {
-		ret = -ENOMEM;
-		goto quit;
-	}
-
-	ret = dns_msg_pack_qname(&dns_qname->len, dns_qname->data,
-				DNS_MAX_NAME_LEN, ctx->queries[i].query);
-	if (ret < 0) {
-		goto quit;
-	}
-
 	ctx->queries[i].id = sys_rand32_get();
 
 	/* If mDNS is enabled, then send .local queries only to multicast
 	 * address. For mDNS the id should be set to 0, see RFC 6762 ch. 18.1
 	 * for details.
 	 */
-	if (IS_ENABLED(CONFIG_MDNS_RESOLVER)) {
-		const char *ptr = strrchr(query, '.');
-
-		/* Note that we memcmp() the \0 here too */
-		if (ptr && !memcmp(ptr, (const void *){ ".local" }, 7)) {
-			mdns_query = true;
-
-			ctx->queries[i].id = 0;
-		}
+	if (is_mdns_query(query)) {
+		ctx->queries[i].id = 0;
 	}
 
 	/* Do this immediately after calculating the Id so that the unit
@@ -1071,55 +1276,26 @@ try_resolve:
 		NET_DBG("DNS id will be %u", *dns_id);
 	}
 
-	for (j = 0; j < SERVER_COUNT; j++) {
-		hop_limit = 0U;
-
-		if (!ctx->servers[j].net_ctx) {
-			continue;
-		}
-
-		/* If mDNS is enabled, then send .local queries only to
-		 * a well known multicast mDNS server address.
-		 */
-		if (IS_ENABLED(CONFIG_MDNS_RESOLVER) && mdns_query &&
-		    !ctx->servers[j].is_mdns) {
-			continue;
-		}
-
-		/* If llmnr is enabled, then all the queries are sent to
-		 * LLMNR multicast address unless it is a mDNS query.
-		 */
-		if (!mdns_query && IS_ENABLED(CONFIG_LLMNR_RESOLVER)) {
-			if (!ctx->servers[j].is_llmnr) {
-				continue;
-			}
-
-			hop_limit = 1U;
-		}
-
-		ret = dns_write(ctx, j, i, dns_data, dns_qname, hop_limit);
-		if (ret < 0) {
-			failure++;
-			continue;
-		}
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	/* If the name is already being resolved, wait for that answer
+	 * instead of sending the same query again.
+	 */
+	ctx->queries[i].answer.count = 0U;
+	ctx->queries[i].answer.ttl = CONFIG_DNS_RESOLVER_CACHE_MAX_TTL;
 
-		/* Do one concurrent query only for each name resolve.
-		 * TODO: Change the i (query index) to do multiple concurrent
-		 *       to each server.
-		 */
-		break;
-	}
+	ctx->queries[i].leader = get_slot_by_query(ctx, i);
+	if (ctx->queries[i].leader >= 0) {
+		NET_DBG("[%u] waiting for the answer of [%d]", i,
+			ctx->queries[i].leader);
 
-	if (failure) {
-		NET_DBG("DNS query failed %d times", failure);
+		dns_cache_coalesced();
 
-		if (failure == j) {
-			ret = -ENOENT;
-			goto quit;
-		}
+		ret = k_delayed_work_submit(&ctx->queries[i].timer, tout);
+		goto quit;
 	}
+#endif
 
-	ret = 0;
+	ret = dns_query_send(ctx, i);
 
 quit:
 	if (ret < 0) {
@@ -1137,14 +1313,6 @@ quit:
 		}
 	}
 
-	if (dns_data) {
-		net_buf_unref(dns_data);
-	}
-
-	if (dns_qname) {
-		net_buf_unref(dns_qname);
-	}
-
 	return ret;
 }
 
@@ -45,6 +45,36 @@ static ssize_t sendall(int sock, const void *buf, size_t len)
 	return 0;
 }
 
+/* Send the whole message, even if the socket takes only a part of it */
+static int sendmsg_all(int sock, struct msghdr *msg)
+{
+	int total = 0;
+	ssize_t ret;
+
+	while (msg->msg_iovlen) {
+		ret = sendmsg(sock, msg, 0);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		total += ret;
+
+		while (msg->msg_iovlen && (size_t)ret >= msg->msg_iov->iov_len) {
+			ret -= msg->msg_iov->iov_len;
+			msg->msg_iov++;
+			msg->msg_iovlen--;
+		}
+
+		if (ret) {
+			msg->msg_iov->iov_base =
+				(uint8_t *)msg->msg_iov->iov_base + ret;
+			msg->msg_iov->iov_len -= ret;
+		}
+	}
+
+	return total;
+}
+
 static int http_send_data(int sock, char *send_buf,
 			  size_t send_buf_max_len, size_t *send_buf_pos,
 			  ...)
@@ -257,6 +287,11 @@ static int on_body(struct http_parser *parser, const char *at, size_t length)
 	NET_DBG("Processed %zd length %zd", req->internal.response.processed,
 		length);
 
+	if (req->body_cb) {
+		req->body_cb(&req->internal.response, (const uint8_t *)at,
+			     length, req->internal.user_data);
+	}
+
 	if (req->internal.response.http_cb &&
 	    req->internal.response.http_cb->on_body) {
 		req->internal.response.http_cb->on_body(parser, at, length);
@@ -357,6 +392,12 @@ static int on_message_complete(struct http_parser *parser)
 		http_method_str(req->method));
 
 	req->internal.response.message_complete = 1;
+	req->internal.response.keep_alive = http_should_keep_alive(parser);
+
+	/* Stop at the end of the response, the data after it belongs to the
+	 * response to the next pipelined request.
+	 */
+	http_parser_pause(parser, 1);
 
 	if (req->internal.response.cb) {
 		req->internal.response.cb(&req->internal.response,
@@ -412,12 +453,42 @@ static void http_client_init_parser(struct http_parser *parser,
 	settings->on_url = on_url;
 }
 
-static int http_wait_data(int sock, struct http_request *req)
+/* Returns true once the response is complete */
+static bool http_parse_data(struct http_request *req, const char *data,
+			    size_t len)
+{
+	size_t parsed;
+
+	req->internal.response.data_len += len;
+
+	parsed = http_parser_execute(&req->internal.parser,
+				     &req->internal.parser_settings,
+				     data, len);
+
+	if (!req->internal.response.message_complete) {
+		return false;
+	}
+
+	req->internal.rest = data + parsed;
+	req->internal.rest_len = len - parsed;
+
+	return true;
+}
+
+static int http_wait_data(int sock, struct http_request *req,
+			  const char *rest, size_t rest_len)
 {
 	int total_received = 0;
 	size_t offset = 0;
 	int received, ret;
 
+	/* The data received with the previous response is parsed where
+	 * it is.
+	 */
+	if (rest_len && http_parse_data(req, rest, rest_len)) {
+		return 0;
+	}
+
 	do {
 		received = recv(sock, req->internal.response.recv_buf + offset,
 				req->internal.response.recv_buf_len - offset,
@@ -432,28 +503,22 @@ static int http_wait_data(int sock, struct http_request *req)
 			LOG_DBG("Connection error (%d)", errno);
 			ret = -errno;
 			break;
-		} else {
-			req->internal.response.data_len += received;
-
-			(void)http_parser_execute(
-				&req->internal.parser,
-				&req->internal.parser_settings,
-				req->internal.response.recv_buf + offset,
-				received);
 		}
 
 		total_received += received;
-		offset += received;
-
-		if (offset >= req->internal.response.recv_buf_len) {
-			offset = 0;
-		}
 
-		if (req->internal.response.message_complete) {
+		if (http_parse_data(req, (const char *)
+				    req->internal.response.recv_buf + offset,
+				    received)) {
 			ret = total_received;
 			break;
 		}
 
+		offset += received;
+
+		if (offset >= req->internal.response.recv_buf_len) {
+			offset = 0;
+		}
 	} while (true);
 
 	return ret;
@@ -467,31 +532,71 @@ static void http_timeout(struct k_work *work)
 	(void)close(data->sock);
 }
 
-int http_client_req(int sock, struct http_request *req,
-		    int32_t timeout, void *user_data)
+static int http_send_chunks(int sock, struct http_request *req,
+			    const char *header, size_t header_len,
+			    void *user_data)
+{
+	static const char last_chunk[] = "0" HTTP_CRLF HTTP_CRLF;
+	char chunk_size[sizeof("ffffffff" HTTP_CRLF)];
+	struct iovec iov[4];
+	struct msghdr msg;
+	const void *data;
+	int total_sent = 0;
+	ssize_t len;
+	int ret;
+
+	do {
+		len = req->payload_producer(req, &data, user_data);
+		if (len < 0) {
+			return len;
+		}
+
+		(void)memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+
+		if (header_len) {
+			iov[msg.msg_iovlen].iov_base = (void *)header;
+			iov[msg.msg_iovlen++].iov_len = header_len;
+			header_len = 0;
+		}
+
+		if (len > 0) {
+			ret = snprintk(chunk_size, sizeof(chunk_size),
+				       "%x" HTTP_CRLF, (unsigned int)len);
+
+			iov[msg.msg_iovlen].iov_base = chunk_size;
+			iov[msg.msg_iovlen++].iov_len = ret;
+			iov[msg.msg_iovlen].iov_base = (void *)data;
+			iov[msg.msg_iovlen++].iov_len = len;
+			iov[msg.msg_iovlen].iov_base = HTTP_CRLF;
+			iov[msg.msg_iovlen++].iov_len = sizeof(HTTP_CRLF) - 1;
+		} else {
+			iov[msg.msg_iovlen].iov_base = (void *)last_chunk;
+			iov[msg.msg_iovlen++].iov_len = sizeof(last_chunk) - 1;
+		}
+
+		ret = sendmsg_all(sock, &msg);
+		if (ret < 0) {
+			NET_DBG("Cannot send chunk (%d)", ret);
+			return ret;
+		}
+
+		total_sent += ret;
+	} while (len > 0);
+
+	return total_sent;
+}
+
+static int http_send_req(int sock, struct http_request *req,
+			 void *user_data)
 {
 	/* Utilize the network usage by sending data in bigger blocks */
 	char send_buf[MAX_SEND_BUF_LEN];
 	const size_t send_buf_max_len = sizeof(send_buf);
 	size_t send_buf_pos = 0;
 	int total_sent = 0;
-	int ret, total_recv, i;
 	const char *method;
-
-	if (sock < 0 || req == NULL || req->response == NULL ||
-	    req->recv_buf == NULL || req->recv_buf_len == 0) {
-		return -EINVAL;
-	}
-
-	memset(&req->internal.response, 0, sizeof(req->internal.response));
-
-	req->internal.response.http_cb = req->http_cb;
-	req->internal.response.cb = req->response;
-	req->internal.response.recv_buf = req->recv_buf;
-	req->internal.response.recv_buf_len = req->recv_buf_len;
-	req->internal.user_data = user_data;
-	req->internal.sock = sock;
-	req->internal.timeout = SYS_TIMEOUT_MS(timeout);
+	int ret, i;
 
 	method = http_method_str(req->method);
 
@@ -577,7 +682,26 @@ int http_client_req(int sock, struct http_request *req,
 		total_sent += ret;
 	}
 
-	if (req->payload || req->payload_cb) {
+	if (req->payload_producer) {
+		ret = http_send_data(sock, send_buf, send_buf_max_len,
+				     &send_buf_pos, "Transfer-Encoding: chunked",
+				     HTTP_CRLF, HTTP_CRLF, NULL);
+		if (ret < 0) {
+			goto out;
+		}
+
+		total_sent += ret;
+
+		/* The header is sent together with the first chunk */
+		ret = http_send_chunks(sock, req, send_buf, send_buf_pos,
+				       user_data);
+		if (ret < 0) {
+			goto out;
+		}
+
+		send_buf_pos = 0;
+		total_sent += ret;
+	} else if (req->payload || req->payload_cb) {
 		if (req->payload_len) {
 			char content_len_str[HTTP_CONTENT_LEN_SIZE];
 
@@ -653,31 +777,140 @@ int http_client_req(int sock, struct http_request *req,
 
 	NET_DBG("Sent %d bytes", total_sent);
 
+	return total_sent;
+
+out:
+	return ret;
+}
+
+static bool http_req_is_valid(struct http_request *req)
+{
+	return req != NULL && (req->response != NULL || req->body_cb != NULL) &&
+	       req->recv_buf != NULL && req->recv_buf_len != 0;
+}
+
+static void http_req_init(int sock, struct http_request *req,
+			  int32_t timeout, void *user_data)
+{
+	memset(&req->internal.response, 0, sizeof(req->internal.response));
+
+	req->internal.response.http_cb = req->http_cb;
+	req->internal.response.cb = req->response;
+	req->internal.response.recv_buf = req->recv_buf;
+	req->internal.response.recv_buf_len = req->recv_buf_len;
+	req->internal.user_data = user_data;
+	req->internal.sock = sock;
+	req->internal.timeout = SYS_TIMEOUT_MS(timeout);
+	req->internal.rest = NULL;
+	req->internal.rest_len = 0;
+
 	http_client_init_parser(&req->internal.parser,
 				&req->internal.parser_settings);
+}
+
+static bool http_timeout_needed(struct http_request *req)
+{
+	return !K_TIMEOUT_EQ(req->internal.timeout, K_FOREVER) &&
+	       !K_TIMEOUT_EQ(req->internal.timeout, K_NO_WAIT);
+}
+
+int http_client_req(int sock, struct http_request *req,
+		    int32_t timeout, void *user_data)
+{
+	int total_sent, total_recv;
 
-	if (!K_TIMEOUT_EQ(req->internal.timeout, K_FOREVER) &&
-	    !K_TIMEOUT_EQ(req->internal.timeout, K_NO_WAIT)) {
+	if (sock < 0 || !http_req_is_valid(req)) {
+		return -EINVAL;
+	}
+
+	http_req_init(sock, req, timeout, user_data);
+
+	total_sent = http_send_req(sock, req, user_data);
+	if (total_sent < 0) {
+		return total_sent;
+	}
+
+	if (http_timeout_needed(req)) {
 		k_delayed_work_init(&req->internal.work, http_timeout);
 		(void)k_delayed_work_submit(&req->internal.work,
 					    req->internal.timeout);
 	}
 
 	/* Request is sent, now wait data to be received */
-	total_recv = http_wait_data(sock, req);
+	total_recv = http_wait_data(sock, req, NULL, 0);
 	if (total_recv < 0) {
 		NET_DBG("Wait data failure (%d)", total_recv);
 	} else {
 		NET_DBG("Received %d bytes", total_recv);
 	}
 
-	if (!K_TIMEOUT_EQ(req->internal.timeout, K_FOREVER) &&
-	    !K_TIMEOUT_EQ(req->internal.timeout, K_NO_WAIT)) {
+	if (http_timeout_needed(req)) {
 		(void)k_delayed_work_cancel(&req->internal.work);
 	}
 
 	return total_sent;
+}
 
-out:
-	return ret;
+int http_client_req_pipelined(int sock, struct http_request **reqs,
+			      size_t count, int32_t timeout,
+			      void *user_data)
+{
+	const char *rest = NULL;
+	size_t rest_len = 0;
+	int total_sent = 0;
+	int ret = 0;
+	size_t i;
+
+	if (sock < 0 || reqs == NULL || count == 0) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!http_req_is_valid(reqs[i])) {
+			return -EINVAL;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		http_req_init(sock, reqs[i], timeout, user_data);
+
+		ret = http_send_req(sock, reqs[i], user_data);
+		if (ret < 0) {
+			return ret;
+		}
+
+		total_sent += ret;
+	}
+
+	/* The first request tracks the timeout of all the responses */
+	if (http_timeout_needed(reqs[0])) {
+		k_delayed_work_init(&reqs[0]->internal.work, http_timeout);
+		(void)k_delayed_work_submit(&reqs[0]->internal.work,
+					    reqs[0]->internal.timeout);
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = http_wait_data(sock, reqs[i], rest, rest_len);
+		if (ret < 0) {
+			NET_DBG("Wait data failure (%d)", ret);
+			break;
+		}
+
+		if (!reqs[i]->internal.response.message_complete ||
+		    (i < count - 1 &&
+		     !reqs[i]->internal.response.keep_alive)) {
+			NET_DBG("Connection closed at response %zd", i);
+			ret = -ECONNRESET;
+			break;
+		}
+
+		rest = reqs[i]->internal.rest;
+		rest_len = reqs[i]->internal.rest_len;
+	}
+
+	if (http_timeout_needed(reqs[0])) {
+		(void)k_delayed_work_cancel(&reqs[0]->internal.work);
+	}
+
+	return ret < 0 ? ret : total_sent;
 }
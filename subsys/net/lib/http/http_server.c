@@ -0,0 +1,1141 @@
+/** @file
+ * @brief HTTP server API
+ *
+ * An API for applications to serve HTTP/1.1 resources
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_http_server, CONFIG_NET_HTTP_SERVER_LOG_LEVEL);
+
+#include <kernel.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+
+#include <net/net_ip.h>
+#include <net/socket.h>
+#include <net/http_server.h>
+
+#if defined(CONFIG_HTTP_SERVER_FILE)
+#include <sys/stat.h>
+#include <posix/unistd.h>
+#include <fs/fs.h>
+#endif
+
+#include "net_private.h"
+
+#define NUM_LISTENERS (IS_ENABLED(CONFIG_NET_IPV6) + \
+		       IS_ENABLED(CONFIG_NET_IPV4))
+#define MAX_POLL_FDS (NUM_LISTENERS + CONFIG_HTTP_SERVER_MAX_CLIENTS)
+
+BUILD_ASSERT(MAX_POLL_FDS <= CONFIG_NET_SOCKETS_POLL_MAX,
+	     "CONFIG_NET_SOCKETS_POLL_MAX too small for the HTTP server");
+
+/* Room for the status line and the header fields of a response */
+BUILD_ASSERT(CONFIG_HTTP_SERVER_SEND_BUF_SIZE >= 192,
+	     "HTTP server send buffer too small");
+
+enum header_state {
+	HEADER_NONE,
+	HEADER_FIELD,
+	HEADER_VALUE,
+};
+
+struct http_conn {
+	/** HTTP parser context */
+	struct http_parser parser;
+
+	/** Request being served */
+	struct http_server_req req;
+
+	/** Uptime of the last data received or sent, for the idle timeout */
+	int64_t last_active;
+
+	/** Socket of the connection, -1 if the entry is free */
+	int sock;
+
+	/** Amount of received data in buf */
+	size_t recv_len;
+
+	/** Amount of data in buf given to the parser */
+	size_t parsed;
+
+	/* Offsets of the request data in buf. The parser may return the
+	 * data in pieces, which are contiguous apart from the body of a
+	 * chunked request. Its pieces are moved next to each other.
+	 */
+	size_t url_off;
+	size_t url_len;
+	size_t body_off;
+	size_t body_len;
+	size_t field_off;
+	size_t field_len;
+	size_t value_off;
+	size_t value_len;
+
+	/** enum header_state */
+	uint8_t header_state;
+
+	uint8_t headers_done : 1;
+	uint8_t too_large : 1;
+	uint8_t accept_gzip : 1;
+
+	/** Close the connection once the pending output has been sent */
+	uint8_t closing : 1;
+
+	/** Received data. Requests are removed from the start of the buffer
+	 * once answered, so pipelined requests follow each other here.
+	 */
+	char buf[CONFIG_HTTP_SERVER_RECV_BUF_SIZE];
+
+	/* The sockets are non-blocking. Output the socket does not take
+	 * right away is kept here and sent once the socket is writable
+	 * again, while the next requests wait.
+	 */
+
+	/** Amount of data in out_buf, and amount of it already sent */
+	size_t out_len;
+	size_t out_sent;
+
+	/** Static content sent from where it is, after out_buf */
+	const uint8_t *out_data;
+	size_t out_data_len;
+
+#if defined(CONFIG_HTTP_SERVER_FILE)
+	/** File sent after out_buf, -1 if none */
+	int file_fd;
+	off_t file_off;
+	off_t file_size;
+#endif
+
+	/** Responses are gathered here, so that the header and a small
+	 * body, or the answers to pipelined requests, share segments.
+	 */
+	char out_buf[CONFIG_HTTP_SERVER_SEND_BUF_SIZE];
+};
+
+static struct http_conn conns[CONFIG_HTTP_SERVER_MAX_CLIENTS];
+static int listeners[NUM_LISTENERS];
+
+K_THREAD_STACK_DEFINE(http_server_stack, CONFIG_HTTP_SERVER_STACK_SIZE);
+static struct k_thread http_server_thread_data;
+static bool started;
+
+#if defined(CONFIG_HTTP_SERVER_FILE)
+static bool file_pending(struct http_conn *conn)
+{
+	return conn->file_fd >= 0;
+}
+
+static void file_close(struct http_conn *conn)
+{
+	if (conn->file_fd >= 0) {
+		(void)close(conn->file_fd);
+		conn->file_fd = -1;
+	}
+}
+
+static int file_send(struct http_conn *conn)
+{
+	ssize_t len;
+
+	while (conn->file_fd >= 0) {
+		len = zsock_sendfile(conn->sock, conn->file_fd, &conn->file_off,
+				     conn->file_size - conn->file_off);
+		if (len <= 0) {
+			/* The header has been sent, the connection cannot
+			 * be used anymore.
+			 */
+			return len < 0 ? -errno : -EIO;
+		}
+
+		conn->last_active = k_uptime_get();
+
+		if (conn->file_off >= conn->file_size) {
+			file_close(conn);
+		}
+	}
+
+	return 0;
+}
+#else
+static bool file_pending(struct http_conn *conn)
+{
+	return false;
+}
+
+static void file_close(struct http_conn *conn)
+{
+}
+
+static int file_send(struct http_conn *conn)
+{
+	return 0;
+}
+#endif /* CONFIG_HTTP_SERVER_FILE */
+
+/* Whether a response is being sent from outside out_buf. The next
+ * requests are answered once it is complete.
+ */
+static bool out_streaming(struct http_conn *conn)
+{
+	return conn->out_data_len || file_pending(conn);
+}
+
+static bool out_pending(struct http_conn *conn)
+{
+	return conn->out_sent < conn->out_len || out_streaming(conn);
+}
+
+/* Send as much of the pending output as the socket takes. Returns 0 once
+ * everything has been sent, -EAGAIN if the rest has to wait until the
+ * socket is writable, or another negative error.
+ */
+static int out_send(struct http_conn *conn)
+{
+	ssize_t len;
+
+	while (conn->out_sent < conn->out_len) {
+		len = zsock_send(conn->sock, conn->out_buf + conn->out_sent,
+				 conn->out_len - conn->out_sent, 0);
+		if (len < 0) {
+			return -errno;
+		}
+
+		conn->out_sent += len;
+		conn->last_active = k_uptime_get();
+	}
+
+	conn->out_len = 0;
+	conn->out_sent = 0;
+
+	while (conn->out_data_len) {
+		len = zsock_send(conn->sock, conn->out_data,
+				 conn->out_data_len, 0);
+		if (len < 0) {
+			return -errno;
+		}
+
+		conn->out_data += len;
+		conn->out_data_len -= len;
+		conn->last_active = k_uptime_get();
+	}
+
+	return file_send(conn);
+}
+
+/* Make room for len more bytes in out_buf */
+static int out_reserve(struct http_conn *conn, size_t len)
+{
+	int ret;
+
+	if (len <= sizeof(conn->out_buf) - conn->out_len) {
+		return 0;
+	}
+
+	ret = out_send(conn);
+	if (ret < 0 && ret != -EAGAIN) {
+		return ret;
+	}
+
+	/* Move what the socket did not take to the start of the buffer */
+	conn->out_len -= conn->out_sent;
+	memmove(conn->out_buf, conn->out_buf + conn->out_sent, conn->out_len);
+	conn->out_sent = 0;
+
+	if (len > sizeof(conn->out_buf) - conn->out_len) {
+		return -ENOBUFS;
+	}
+
+	return 0;
+}
+
+static int out_write(struct http_conn *conn, const void *data, size_t len)
+{
+	ssize_t sent;
+	int ret;
+
+	ret = out_reserve(conn, len);
+	if (ret == -ENOBUFS && conn->out_len == 0) {
+		/* Give the socket what it takes of data larger than the
+		 * buffer, and keep the rest.
+		 */
+		sent = zsock_send(conn->sock, data, len, 0);
+		if (sent < 0 && errno != EAGAIN) {
+			return -errno;
+		}
+
+		if (sent > 0) {
+			data = (const char *)data + sent;
+			len -= sent;
+		}
+
+		ret = out_reserve(conn, len);
+	}
+
+	if (ret < 0) {
+		NET_DBG("[%d] Cannot queue %zu bytes (%d)", conn->sock, len,
+			ret);
+		return ret;
+	}
+
+	memcpy(conn->out_buf + conn->out_len, data, len);
+	conn->out_len += len;
+
+	return 0;
+}
+
+static const char *status_str(uint16_t status)
+{
+	switch (status) {
+	case 200:
+		return "OK";
+	case 204:
+		return "No Content";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	case 406:
+		return "Not Acceptable";
+	case 413:
+		return "Payload Too Large";
+	case 431:
+		return "Request Header Fields Too Large";
+	case 500:
+		return "Internal Server Error";
+	case 501:
+		return "Not Implemented";
+	case 503:
+		return "Service Unavailable";
+	}
+
+	return "";
+}
+
+/* Write the status line and header fields. A negative content_len means
+ * that the body is sent with the chunked transfer encoding.
+ */
+static int send_header(struct http_conn *conn, uint16_t status,
+		       const char *content_type, const char *encoding,
+		       ssize_t content_len, const char *extra)
+{
+	const char *connection = "";
+	size_t space;
+	int len;
+
+	if (!conn->req.keep_alive) {
+		connection = "Connection: close" HTTP_CRLF;
+	} else if (conn->parser.http_minor == 0U) {
+		connection = "Connection: keep-alive" HTTP_CRLF;
+	}
+
+	len = out_reserve(conn, 192);
+	if (len < 0) {
+		return len;
+	}
+
+	space = sizeof(conn->out_buf) - conn->out_len;
+
+	len = snprintk(conn->out_buf + conn->out_len, space,
+		       "HTTP/1.1 %u %s" HTTP_CRLF "%s%s%s%s%s%s",
+		       status, status_str(status),
+		       content_type ? "Content-Type: " : "",
+		       content_type ? content_type : "",
+		       content_type ? HTTP_CRLF : "",
+		       encoding ? "Content-Encoding: " : "",
+		       encoding ? encoding : "",
+		       encoding ? HTTP_CRLF : "");
+	if (len < 0 || len >= space) {
+		return -EMSGSIZE;
+	}
+
+	conn->out_len += len;
+	space -= len;
+
+	if (content_len < 0) {
+		len = snprintk(conn->out_buf + conn->out_len, space,
+			       "Transfer-Encoding: chunked" HTTP_CRLF
+			       "%s%s" HTTP_CRLF,
+			       connection, extra ? extra : "");
+	} else {
+		len = snprintk(conn->out_buf + conn->out_len, space,
+			       "Content-Length: %zu" HTTP_CRLF "%s%s" HTTP_CRLF,
+			       (size_t)content_len, connection,
+			       extra ? extra : "");
+	}
+
+	if (len < 0 || len >= space) {
+		return -EMSGSIZE;
+	}
+
+	conn->out_len += len;
+
+	return 0;
+}
+
+static int send_reply(struct http_conn *conn, uint16_t status,
+		      const char *content_type, const char *encoding,
+		      const void *body, size_t len, const char *extra)
+{
+	int ret;
+
+	conn->req.responded = 1U;
+
+	ret = send_header(conn, status, content_type, encoding, len, extra);
+	if (ret < 0 || conn->req.method == HTTP_HEAD || len == 0) {
+		return ret;
+	}
+
+	return out_write(conn, body, len);
+}
+
+static int send_error(struct http_conn *conn, uint16_t status)
+{
+	return send_reply(conn, status, NULL, NULL, NULL, 0, NULL);
+}
+
+int http_server_send_response(struct http_server_req *req, uint16_t status,
+			      const char *content_type,
+			      const void *body, size_t len)
+{
+	struct http_conn *conn = CONTAINER_OF(req, struct http_conn, req);
+
+	if (req->responded) {
+		return -EALREADY;
+	}
+
+	return send_reply(conn, status, content_type, NULL, body, len, NULL);
+}
+
+int http_server_send_chunked_start(struct http_server_req *req,
+				   uint16_t status, const char *content_type)
+{
+	struct http_conn *conn = CONTAINER_OF(req, struct http_conn, req);
+
+	if (req->responded) {
+		return -EALREADY;
+	}
+
+	req->responded = 1U;
+	req->chunked = 1U;
+
+	return send_header(conn, status, content_type, NULL, -1, NULL);
+}
+
+int http_server_send_chunk(struct http_server_req *req,
+			   const void *data, size_t len)
+{
+	struct http_conn *conn = CONTAINER_OF(req, struct http_conn, req);
+	char chunk_size[sizeof("ffffffff" HTTP_CRLF)];
+	int ret;
+
+	if (!req->chunked) {
+		return -EINVAL;
+	}
+
+	/* An empty chunk would end the body */
+	if (len == 0 || req->method == HTTP_HEAD) {
+		return 0;
+	}
+
+	ret = snprintk(chunk_size, sizeof(chunk_size), "%x" HTTP_CRLF,
+		       (unsigned int)len);
+
+	ret = out_write(conn, chunk_size, ret);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = out_write(conn, data, len);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return out_write(conn, HTTP_CRLF, sizeof(HTTP_CRLF) - 1);
+}
+
+int http_server_send_chunked_end(struct http_server_req *req)
+{
+	static const char last_chunk[] = "0" HTTP_CRLF HTTP_CRLF;
+	struct http_conn *conn = CONTAINER_OF(req, struct http_conn, req);
+
+	if (!req->chunked) {
+		return -EINVAL;
+	}
+
+	req->chunked = 0U;
+
+	if (req->method == HTTP_HEAD) {
+		return 0;
+	}
+
+	return out_write(conn, last_chunk, sizeof(last_chunk) - 1);
+}
+
+#if defined(CONFIG_HTTP_SERVER_FILE)
+static int send_file(struct http_conn *conn,
+		     const struct http_resource *res)
+{
+	struct fs_dirent entry;
+	int ret, fd;
+
+	ret = fs_stat(res->file, &entry);
+	if (ret < 0 || entry.type != FS_DIR_ENTRY_FILE) {
+		NET_DBG("Cannot stat %s (%d)", log_strdup(res->file), ret);
+		return send_error(conn, 404);
+	}
+
+	fd = open(res->file, O_RDONLY);
+	if (fd < 0) {
+		NET_DBG("Cannot open %s (%d)", log_strdup(res->file), errno);
+		return send_error(conn, 500);
+	}
+
+	conn->req.responded = 1U;
+
+	ret = send_header(conn, 200, res->content_type, res->content_encoding,
+			  entry.size, NULL);
+	if (ret < 0 || conn->req.method == HTTP_HEAD || entry.size == 0) {
+		(void)close(fd);
+		return ret;
+	}
+
+	/* The file follows the header once the buffer has been sent */
+	conn->file_fd = fd;
+	conn->file_off = 0;
+	conn->file_size = entry.size;
+
+	return 0;
+}
+#else
+static int send_file(struct http_conn *conn,
+		     const struct http_resource *res)
+{
+	ARG_UNUSED(res);
+
+	return send_error(conn, 501);
+}
+#endif /* CONFIG_HTTP_SERVER_FILE */
+
+/* Static content outlives the connection, so the part of it which does
+ * not fit in the buffer is sent from where it is.
+ */
+static int send_static(struct http_conn *conn,
+		       const struct http_resource *res)
+{
+	size_t len = res->content.len;
+	int ret;
+
+	conn->req.responded = 1U;
+
+	ret = send_header(conn, 200, res->content_type, res->content_encoding,
+			  len, NULL);
+	if (ret < 0 || conn->req.method == HTTP_HEAD || len == 0) {
+		return ret;
+	}
+
+	if (len <= sizeof(conn->out_buf) - conn->out_len) {
+		return out_write(conn, res->content.data, len);
+	}
+
+	conn->out_data = res->content.data;
+	conn->out_data_len = len;
+
+	return 0;
+}
+
+static const struct http_resource *find_resource(const char *path,
+						 size_t len)
+{
+	Z_STRUCT_SECTION_FOREACH(http_resource, res) {
+		if (res->path_len == len && !memcmp(res->path, path, len)) {
+			return res;
+		}
+	}
+
+	return NULL;
+}
+
+static int handle_request(struct http_conn *conn)
+{
+	struct http_server_req *req = &conn->req;
+	const struct http_resource *res;
+	size_t path_len;
+	int ret;
+
+	req->method = conn->parser.method;
+	req->responded = 0U;
+	req->chunked = 0U;
+	req->keep_alive = http_should_keep_alive(&conn->parser) ? 1U : 0U;
+
+	/* The byte following the URL has been parsed already */
+	conn->buf[conn->url_off + conn->url_len] = '\0';
+	req->url = conn->buf + conn->url_off;
+	req->url_len = conn->url_len;
+
+	req->body = conn->body_len ?
+		(const uint8_t *)conn->buf + conn->body_off : NULL;
+	req->body_len = conn->body_len;
+
+	path_len = strcspn(req->url, "?#");
+
+	NET_DBG("[%d] %s %s", conn->sock, http_method_str(req->method),
+		log_strdup(req->url));
+
+	res = find_resource(req->url, path_len);
+	if (!res) {
+		return send_error(conn, 404);
+	}
+
+	req->resource = res;
+
+	if (res->type == HTTP_RESOURCE_DYNAMIC) {
+		ret = res->dynamic.cb(req, res->dynamic.user_data);
+		if (ret < 0) {
+			return ret;
+		}
+
+		if (!req->responded) {
+			return send_error(conn, 500);
+		}
+
+		if (req->chunked) {
+			return http_server_send_chunked_end(req);
+		}
+
+		return 0;
+	}
+
+	if (req->method != HTTP_GET && req->method != HTTP_HEAD) {
+		return send_reply(conn, 405, NULL, NULL, NULL, 0,
+				  "Allow: GET, HEAD" HTTP_CRLF);
+	}
+
+	if (res->content_encoding && !strcmp(res->content_encoding, "gzip") &&
+	    !conn->accept_gzip) {
+		return send_error(conn, 406);
+	}
+
+	if (res->type == HTTP_RESOURCE_FILE) {
+		return send_file(conn, res);
+	}
+
+	return send_static(conn, res);
+}
+
+static void header_field_done(struct http_conn *conn)
+{
+	static const char accept_encoding[] = "Accept-Encoding";
+	const char *value = conn->buf + conn->value_off;
+	size_t i;
+
+	if (conn->field_len != sizeof(accept_encoding) - 1 ||
+	    strncasecmp(conn->buf + conn->field_off,
+			accept_encoding, conn->field_len)) {
+		return;
+	}
+
+	for (i = 0; i + 4 <= conn->value_len; i++) {
+		if (!strncasecmp(value + i, "gzip", 4)) {
+			conn->accept_gzip = 1U;
+			break;
+		}
+	}
+}
+
+static int on_message_begin(struct http_parser *parser)
+{
+	struct http_conn *conn = parser->data;
+
+	conn->url_len = 0;
+	conn->body_len = 0;
+	conn->header_state = HEADER_NONE;
+	conn->headers_done = 0U;
+	conn->accept_gzip = 0U;
+
+	return 0;
+}
+
+static int on_url(struct http_parser *parser, const char *at, size_t length)
+{
+	struct http_conn *conn = parser->data;
+
+	if (conn->url_len == 0) {
+		conn->url_off = at - conn->buf;
+	}
+
+	conn->url_len += length;
+
+	return 0;
+}
+
+static int on_header_field(struct http_parser *parser, const char *at,
+			   size_t length)
+{
+	struct http_conn *conn = parser->data;
+
+	if (conn->header_state == HEADER_VALUE) {
+		header_field_done(conn);
+	}
+
+	if (conn->header_state != HEADER_FIELD) {
+		conn->field_off = at - conn->buf;
+		conn->field_len = 0;
+		conn->header_state = HEADER_FIELD;
+	}
+
+	conn->field_len += length;
+
+	return 0;
+}
+
+static int on_header_value(struct http_parser *parser, const char *at,
+			   size_t length)
+{
+	struct http_conn *conn = parser->data;
+
+	if (conn->header_state != HEADER_VALUE) {
+		conn->value_off = at - conn->buf;
+		conn->value_len = 0;
+		conn->header_state = HEADER_VALUE;
+	}
+
+	conn->value_len += length;
+
+	return 0;
+}
+
+static int on_headers_complete(struct http_parser *parser)
+{
+	struct http_conn *conn = parser->data;
+
+	if (conn->header_state == HEADER_VALUE) {
+		header_field_done(conn);
+	}
+
+	conn->headers_done = 1U;
+
+	if (parser->content_length != ULLONG_MAX &&
+	    parser->content_length > sizeof(conn->buf)) {
+		conn->too_large = 1U;
+		return -1;
+	}
+
+	return 0;
+}
+
+static int on_body(struct http_parser *parser, const char *at, size_t length)
+{
+	struct http_conn *conn = parser->data;
+
+	if (conn->body_len == 0) {
+		conn->body_off = at - conn->buf;
+	}
+
+	/* Join the chunks of a chunked body, the data in between has been
+	 * parsed already.
+	 */
+	memmove(conn->buf + conn->body_off + conn->body_len, at, length);
+	conn->body_len += length;
+
+	return 0;
+}
+
+static int on_message_complete(struct http_parser *parser)
+{
+	/* Stop here so that the request can be answered before the parser
+	 * moves to a pipelined request.
+	 */
+	http_parser_pause(parser, 1);
+
+	return 0;
+}
+
+static const struct http_parser_settings parser_settings = {
+	.on_message_begin = on_message_begin,
+	.on_url = on_url,
+	.on_header_field = on_header_field,
+	.on_header_value = on_header_value,
+	.on_headers_complete = on_headers_complete,
+	.on_body = on_body,
+	.on_message_complete = on_message_complete,
+};
+
+/* Answer the complete requests in the receive buffer, until a response
+ * is sent from outside the send buffer. Returns <0 if the connection is
+ * to be closed right away.
+ */
+static int conn_handle(struct http_conn *conn)
+{
+	enum http_errno err;
+	size_t parsed;
+	int ret;
+
+	while (conn->parsed < conn->recv_len && !out_streaming(conn)) {
+		parsed = http_parser_execute(&conn->parser, &parser_settings,
+					     conn->buf + conn->parsed,
+					     conn->recv_len - conn->parsed);
+		conn->parsed += parsed;
+
+		err = HTTP_PARSER_ERRNO(&conn->parser);
+		if (err == HPE_OK) {
+			break;
+		}
+
+		if (err != HPE_PAUSED) {
+			NET_DBG("[%d] Invalid request (%s)", conn->sock,
+				http_errno_name(err));
+			conn->req.keep_alive = 0U;
+			conn->closing = 1U;
+			return send_error(conn, conn->too_large ? 413 : 400);
+		}
+
+		ret = handle_request(conn);
+		if (ret < 0) {
+			return ret;
+		}
+
+		if (!conn->req.keep_alive) {
+			conn->closing = 1U;
+			return 0;
+		}
+
+		/* Drop the answered request */
+		conn->recv_len -= conn->parsed;
+		memmove(conn->buf, conn->buf + conn->parsed, conn->recv_len);
+		conn->parsed = 0;
+
+		http_parser_pause(&conn->parser, 0);
+	}
+
+	if (!out_streaming(conn) && conn->recv_len == sizeof(conn->buf)) {
+		NET_DBG("[%d] Request does not fit in %zu bytes", conn->sock,
+			sizeof(conn->buf));
+		conn->req.keep_alive = 0U;
+		conn->closing = 1U;
+		return send_error(conn, conn->headers_done ? 413 : 431);
+	}
+
+	return 0;
+}
+
+/* Answer the received requests and send the responses, as far as the
+ * socket takes them. Called again once the socket is writable if output
+ * is left. Returns <0 if the connection is to be closed.
+ */
+static int conn_process(struct http_conn *conn)
+{
+	int ret;
+
+	do {
+		ret = conn_handle(conn);
+		if (ret < 0) {
+			return ret;
+		}
+
+		ret = out_send(conn);
+		if (ret == -EAGAIN) {
+			return 0;
+		}
+
+		if (ret < 0) {
+			return ret;
+		}
+
+		/* Requests may be left behind a response sent from outside
+		 * the buffer.
+		 */
+	} while (!conn->closing && conn->parsed < conn->recv_len);
+
+	return conn->closing ? -ECONNRESET : 0;
+}
+
+static void conn_close(struct http_conn *conn)
+{
+	NET_DBG("[%d] Closing connection", conn->sock);
+
+	file_close(conn);
+	(void)zsock_close(conn->sock);
+	conn->sock = -1;
+}
+
+static int conn_recv(struct http_conn *conn)
+{
+	ssize_t len;
+
+	len = zsock_recv(conn->sock, conn->buf + conn->recv_len,
+			 sizeof(conn->buf) - conn->recv_len, 0);
+	if (len < 0 && errno == EAGAIN) {
+		return 0;
+	}
+
+	if (len <= 0) {
+		return len < 0 ? -errno : -ECONNRESET;
+	}
+
+	conn->recv_len += len;
+	conn->last_active = k_uptime_get();
+
+	return conn_process(conn);
+}
+
+static void conn_accept(int listener)
+{
+	struct http_conn *conn = NULL;
+	int sock;
+	int i;
+
+	sock = zsock_accept(listener, NULL, NULL);
+	if (sock < 0) {
+		NET_DBG("Cannot accept (%d)", errno);
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(conns); i++) {
+		if (conns[i].sock < 0) {
+			conn = &conns[i];
+			break;
+		}
+	}
+
+	if (!conn) {
+		/* The listeners are not polled while all the entries are
+		 * taken, so this should not happen.
+		 */
+		(void)zsock_close(sock);
+		return;
+	}
+
+	/* A slow client must not hold up the other connections */
+	if (zsock_fcntl(sock, F_SETFL, O_NONBLOCK) < 0) {
+		NET_DBG("[%d] Cannot make non-blocking (%d)", sock, errno);
+		(void)zsock_close(sock);
+		return;
+	}
+
+	NET_DBG("[%d] New connection", sock);
+
+	conn->sock = sock;
+	conn->recv_len = 0;
+	conn->parsed = 0;
+	conn->too_large = 0U;
+	conn->closing = 0U;
+	conn->out_len = 0;
+	conn->out_sent = 0;
+	conn->out_data_len = 0;
+#if defined(CONFIG_HTTP_SERVER_FILE)
+	conn->file_fd = -1;
+#endif
+	conn->last_active = k_uptime_get();
+	conn->req.sock = sock;
+
+	http_parser_init(&conn->parser, HTTP_REQUEST);
+	conn->parser.data = conn;
+}
+
+static int conn_event(struct http_conn *conn, int revents)
+{
+	if (revents & ZSOCK_POLLOUT) {
+		return conn_process(conn);
+	}
+
+	if (revents & ZSOCK_POLLIN) {
+		return conn_recv(conn);
+	}
+
+	return -ECONNRESET;
+}
+
+/* Close the idle connections and return the time until the next one
+ * expires, or -1 if there are no connections.
+ */
+static int conn_expire(void)
+{
+	int64_t now = k_uptime_get();
+	int timeout = -1;
+	int64_t left;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(conns); i++) {
+		if (conns[i].sock < 0) {
+			continue;
+		}
+
+		left = conns[i].last_active +
+			CONFIG_HTTP_SERVER_IDLE_TIMEOUT - now;
+		if (left <= 0) {
+			conn_close(&conns[i]);
+			continue;
+		}
+
+		if (timeout < 0 || left < timeout) {
+			timeout = (int)left;
+		}
+	}
+
+	return timeout;
+}
+
+static void http_server_thread(void *p1, void *p2, void *p3)
+{
+	struct http_conn *polled[MAX_POLL_FDS];
+	struct zsock_pollfd fds[MAX_POLL_FDS];
+	int nfds, active;
+	int timeout;
+	int ret;
+	int i;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		timeout = conn_expire();
+		nfds = 0;
+		active = 0;
+
+		for (i = 0; i < ARRAY_SIZE(conns); i++) {
+			if (conns[i].sock < 0) {
+				continue;
+			}
+
+			/* Nothing more is read until the responses have
+			 * been sent.
+			 */
+			fds[nfds].fd = conns[i].sock;
+			fds[nfds].events = out_pending(&conns[i]) ?
+				ZSOCK_POLLOUT : ZSOCK_POLLIN;
+			polled[nfds++] = &conns[i];
+			active++;
+		}
+
+		/* Leave new connections in the listen backlog while all the
+		 * connection entries are in use.
+		 */
+		if (active < ARRAY_SIZE(conns)) {
+			for (i = 0; i < ARRAY_SIZE(listeners); i++) {
+				fds[nfds].fd = listeners[i];
+				fds[nfds].events = ZSOCK_POLLIN;
+				polled[nfds++] = NULL;
+			}
+		}
+
+		ret = zsock_poll(fds, nfds, timeout);
+		if (ret < 0) {
+			NET_ERR("Cannot poll (%d)", errno);
+			k_sleep(K_MSEC(100));
+			continue;
+		}
+
+		for (i = 0; i < nfds && ret > 0; i++) {
+			if (!fds[i].revents) {
+				continue;
+			}
+
+			ret--;
+
+			if (!polled[i]) {
+				conn_accept(fds[i].fd);
+				continue;
+			}
+
+			if (conn_event(polled[i], fds[i].revents) < 0) {
+				conn_close(polled[i]);
+			}
+		}
+	}
+}
+
+static int listener_create(int family, uint16_t port)
+{
+	struct sockaddr addr;
+	socklen_t addrlen;
+	int sock;
+
+	(void)memset(&addr, 0, sizeof(addr));
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && family == AF_INET6) {
+		net_sin6(&addr)->sin6_family = AF_INET6;
+		net_sin6(&addr)->sin6_port = htons(port);
+		addrlen = sizeof(struct sockaddr_in6);
+	} else {
+		net_sin(&addr)->sin_family = AF_INET;
+		net_sin(&addr)->sin_port = htons(port);
+		addrlen = sizeof(struct sockaddr_in);
+	}
+
+	sock = zsock_socket(family, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0) {
+		return -errno;
+	}
+
+	if (zsock_bind(sock, &addr, addrlen) < 0 ||
+	    zsock_listen(sock, CONFIG_HTTP_SERVER_MAX_CLIENTS) < 0) {
+		int ret = -errno;
+
+		NET_ERR("Cannot listen on port %u (%d)", port, ret);
+		(void)zsock_close(sock);
+		return ret;
+	}
+
+	return sock;
+}
+
+int http_server_start(uint16_t port)
+{
+	int families[] = {
+#if defined(CONFIG_NET_IPV6)
+		AF_INET6,
+#endif
+#if defined(CONFIG_NET_IPV4)
+		AF_INET,
+#endif
+	};
+	k_tid_t tid;
+	int i;
+
+	if (started) {
+		return -EALREADY;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(families); i++) {
+		listeners[i] = listener_create(families[i], port);
+		if (listeners[i] < 0) {
+			int ret = listeners[i];
+
+			while (i--) {
+				(void)zsock_close(listeners[i]);
+			}
+
+			return ret;
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(conns); i++) {
+		conns[i].sock = -1;
+	}
+
+	started = true;
+
+	tid = k_thread_create(&http_server_thread_data, http_server_stack,
+			      K_THREAD_STACK_SIZEOF(http_server_stack),
+			      http_server_thread, NULL, NULL, NULL,
+			      K_PRIO_PREEMPT(CONFIG_HTTP_SERVER_THREAD_PRIO),
+			      0, K_NO_WAIT);
+	k_thread_name_set(tid, "http_server");
+
+	NET_DBG("Listening on port %u", port);
+
+	return 0;
+}
@@ -45,6 +45,12 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #ifdef CONFIG_LWM2M_RW_JSON_SUPPORT
 #include "lwm2m_rw_json.h"
 #endif
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+#include "lwm2m_rw_senml_json.h"
+#endif
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+#include "lwm2m_rw_senml_cbor.h"
+#endif
 #ifdef CONFIG_LWM2M_RD_CLIENT_SUPPORT
 #include "lwm2m_rd_client.h"
 #endif
@@ -83,6 +89,8 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 
 struct observe_node {
 	sys_snode_t node;
+	sys_snode_t index_node;
+	sys_snode_t event_node;
 	struct lwm2m_ctx *ctx;
 	struct lwm2m_obj_path path;
 	uint8_t  token[MAX_TOKEN_LEN];
@@ -93,6 +101,9 @@ struct observe_node {
 	uint32_t counter;
 	uint16_t format;
 	uint8_t  tkl;
+	bool event_pending;
+	/* one of the paths of a composite observation, sharing its token */
+	bool composite;
 };
 
 struct notification_attrs {
@@ -123,6 +134,25 @@ static sys_slist_t engine_obj_inst_list;
 static sys_slist_t engine_observer_list;
 static sys_slist_t engine_service_list;
 
+#define PATH_INDEX_SIZE		CONFIG_LWM2M_ENGINE_PATH_INDEX_SIZE
+
+BUILD_ASSERT((PATH_INDEX_SIZE & (PATH_INDEX_SIZE - 1)) == 0,
+	     "CONFIG_LWM2M_ENGINE_PATH_INDEX_SIZE must be a power of two");
+
+/* object instances and observers by object and instance ID */
+static sys_slist_t engine_obj_inst_index[PATH_INDEX_SIZE];
+static sys_slist_t engine_observer_index[PATH_INDEX_SIZE];
+
+/* observers with a notify event, waiting for their pmin */
+static sys_slist_t engine_observer_event_list;
+/* observers with a notify event, past their pmin, being notified */
+static sys_slist_t engine_observer_notify_list;
+/* protects both lists and event_pending */
+static struct k_spinlock engine_observer_event_lock;
+
+/* no observer reaches its pmax before this time */
+static int64_t engine_observer_pmax_timestamp;
+
 static K_KERNEL_STACK_DEFINE(engine_thread_stack,
 			      CONFIG_LWM2M_ENGINE_STACK_SIZE);
 static struct k_thread engine_thread_data;
@@ -317,6 +347,12 @@ static void free_block_ctx(struct block_context *ctx)
 	ctx->tkl = 0U;
 }
 
+static inline sys_slist_t *path_index(sys_slist_t *index, uint16_t obj_id,
+				       uint16_t obj_inst_id)
+{
+	return &index[(obj_id * 31U + obj_inst_id) & (PATH_INDEX_SIZE - 1)];
+}
+
 /* observer functions */
 
 static int update_attrs(void *ref, struct notification_attrs *out)
@@ -372,16 +408,29 @@ static void clear_attrs(void *ref)
 int lwm2m_notify_observer(uint16_t obj_id, uint16_t obj_inst_id, uint16_t res_id)
 {
 	struct observe_node *obs;
+	int64_t timestamp = k_uptime_get();
+	k_spinlock_key_t key;
 	int ret = 0;
 
 	/* look for observers which match our resource */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+	SYS_SLIST_FOR_EACH_CONTAINER(
+			path_index(engine_observer_index, obj_id, obj_inst_id),
+			obs, index_node) {
 		if (obs->path.obj_id == obj_id &&
 		    obs->path.obj_inst_id == obj_inst_id &&
 		    (obs->path.level < 3 ||
 		     obs->path.res_id == res_id)) {
 			/* update the event time for this observer */
-			obs->event_timestamp = k_uptime_get();
+			obs->event_timestamp = timestamp;
+
+			/* events until the next notification share it */
+			key = k_spin_lock(&engine_observer_event_lock);
+			if (!obs->event_pending) {
+				obs->event_pending = true;
+				sys_slist_append(&engine_observer_event_list,
+						 &obs->event_node);
+			}
+			k_spin_unlock(&engine_observer_event_lock, key);
 
 			LOG_DBG("NOTIFY EVENT %u/%u/%u",
 				obj_id, obj_inst_id, res_id);
@@ -401,7 +450,7 @@ int lwm2m_notify_observer_path(struct lwm2m_obj_path *path)
 
 static int engine_add_observer(struct lwm2m_message *msg,
 			       const uint8_t *token, uint8_t tkl,
-			       uint16_t format)
+			       uint16_t format, bool composite)
 {
 	struct lwm2m_engine_obj *obj = NULL;
 	struct lwm2m_engine_obj_field *obj_field = NULL;
@@ -430,9 +479,12 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	/* TODO: observe dup checking */
 
 	/* make sure this observer doesn't exist already */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+	SYS_SLIST_FOR_EACH_CONTAINER(
+			path_index(engine_observer_index, msg->path.obj_id,
+				   msg->path.obj_inst_id),
+			obs, index_node) {
 		/* TODO: distinguish server object */
-		if (obs->ctx == msg->ctx &&
+		if (!composite && !obs->composite && obs->ctx == msg->ctx &&
 		    memcmp(&obs->path, &msg->path, sizeof(msg->path)) == 0) {
 			/* quietly update the token information */
 			memcpy(obs->token, token, tkl);
@@ -536,8 +588,17 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	observe_node_data[i].max_period_sec = MAX(attrs.pmax, attrs.pmin);
 	observe_node_data[i].format = format;
 	observe_node_data[i].counter = 1U;
+	observe_node_data[i].composite = composite;
 	sys_slist_append(&engine_observer_list,
 			 &observe_node_data[i].node);
+	sys_slist_append(path_index(engine_observer_index, msg->path.obj_id,
+				    msg->path.obj_inst_id),
+			 &observe_node_data[i].index_node);
+
+	engine_observer_pmax_timestamp = MIN(
+			engine_observer_pmax_timestamp,
+			observe_node_data[i].last_timestamp +
+			MSEC_PER_SEC * observe_node_data[i].max_period_sec);
 
 	LOG_DBG("OBSERVER ADDED %u/%u/%u(%u) token:'%s' addr:%s",
 		msg->path.obj_id, msg->path.obj_inst_id,
@@ -548,10 +609,122 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	return 0;
 }
 
+static int engine_remove_observer(const uint8_t *token, uint8_t tkl);
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+/*
+ * A composite observation is made of one observer per path, all with the
+ * token of the request. Observing again with the same token replaces the
+ * paths.
+ */
+static int engine_add_composite_observer(struct lwm2m_message *msg,
+					 const uint8_t *token, uint8_t tkl,
+					 uint16_t format,
+					 struct lwm2m_obj_path *paths,
+					 uint8_t path_count)
+{
+	struct lwm2m_obj_path temp_path;
+	int ret = 0;
+	int i;
+
+	(void)engine_remove_observer(token, tkl);
+
+	memcpy(&temp_path, &msg->path, sizeof(temp_path));
+
+	for (i = 0; i < path_count; i++) {
+		if (paths[i].level == 0U) {
+			ret = -EINVAL;
+			break;
+		}
+
+		memcpy(&msg->path, &paths[i], sizeof(msg->path));
+		ret = engine_add_observer(msg, token, tkl, format, true);
+		if (ret < 0) {
+			break;
+		}
+	}
+
+	memcpy(&msg->path, &temp_path, sizeof(temp_path));
+
+	if (ret < 0) {
+		(void)engine_remove_observer(token, tkl);
+	}
+
+	return ret;
+}
+
+static bool composite_sibling(struct observe_node *obs,
+			      struct observe_node *other)
+{
+	return other->composite && other->ctx == obs->ctx &&
+	       other->tkl == obs->tkl &&
+	       memcmp(other->token, obs->token, obs->tkl) == 0;
+}
+
+/* Paths of the observers of a composite observation */
+static uint8_t composite_observer_paths(struct observe_node *obs,
+					struct lwm2m_obj_path *paths)
+{
+	struct observe_node *other;
+	uint8_t count = 0U;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, other, node) {
+		if (count < CONFIG_LWM2M_COMPOSITE_PATH_MAX &&
+		    composite_sibling(obs, other)) {
+			memcpy(&paths[count++], &other->path,
+			       sizeof(other->path));
+		}
+	}
+
+	return count;
+}
+
+/*
+ * A notification is sent for all the paths of a composite observation,
+ * which restarts the pmin and pmax periods of each of them.
+ */
+static void composite_observer_notified(struct observe_node *obs,
+					int64_t timestamp)
+{
+	struct observe_node *other;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, other, node) {
+		if (composite_sibling(obs, other)) {
+			other->counter = obs->counter;
+			other->last_timestamp = timestamp;
+		}
+	}
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
+
+static void remove_observer_node(struct observe_node *obs,
+				 sys_snode_t *prev_node)
+{
+	k_spinlock_key_t key;
+
+	sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
+	sys_slist_find_and_remove(path_index(engine_observer_index,
+					     obs->path.obj_id,
+					     obs->path.obj_inst_id),
+				  &obs->index_node);
+
+	key = k_spin_lock(&engine_observer_event_lock);
+	if (obs->event_pending &&
+	    !sys_slist_find_and_remove(&engine_observer_event_list,
+				       &obs->event_node)) {
+		sys_slist_find_and_remove(&engine_observer_notify_list,
+					  &obs->event_node);
+	}
+	k_spin_unlock(&engine_observer_event_lock, key);
+
+	(void)memset(obs, 0, sizeof(*obs));
+}
+
 static int engine_remove_observer(const uint8_t *token, uint8_t tkl)
 {
-	struct observe_node *obs, *found_obj = NULL;
+	struct observe_node *obs, *tmp;
 	sys_snode_t *prev_node = NULL;
+	bool found = false;
 
 	if (!token || (tkl == 0U || tkl > MAX_TOKEN_LEN)) {
 		LOG_ERR("token(%p) and token length(%u) must be valid.",
@@ -559,23 +732,23 @@ static int engine_remove_observer(const uint8_t *token, uint8_t tkl)
 		return -EINVAL;
 	}
 
-	/* find the node index */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+	/* remove the observers of the token, all the paths of a composite
+	 * observation included
+	 */
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&engine_observer_list,
+					  obs, tmp, node) {
 		if (memcmp(obs->token, token, tkl) == 0) {
-			found_obj = obs;
-			break;
+			remove_observer_node(obs, prev_node);
+			found = true;
+		} else {
+			prev_node = &obs->node;
 		}
-
-		prev_node = &obs->node;
 	}
 
-	if (!found_obj) {
+	if (!found) {
 		return -ENOENT;
 	}
 
-	sys_slist_remove(&engine_observer_list, prev_node, &found_obj->node);
-	(void)memset(found_obj, 0, sizeof(*found_obj));
-
 	LOG_DBG("observer '%s' removed", log_strdup(sprint_token(token, tkl)));
 
 	return 0;
@@ -595,8 +768,7 @@ static void engine_remove_observer_by_id(uint16_t obj_id, int32_t obj_inst_id)
 			continue;
 		}
 
-		sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
-		(void)memset(obs, 0, sizeof(*obs));
+		remove_observer_node(obs, prev_node);
 	}
 }
 
@@ -647,6 +819,10 @@ lwm2m_get_engine_obj_field(struct lwm2m_engine_obj *obj, int res_id)
 static void engine_register_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
 {
 	sys_slist_append(&engine_obj_inst_list, &obj_inst->node);
+	sys_slist_prepend(path_index(engine_obj_inst_index,
+				     obj_inst->obj->obj_id,
+				     obj_inst->obj_inst_id),
+			  &obj_inst->index_node);
 }
 
 static void engine_unregister_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
@@ -654,6 +830,10 @@ static void engine_unregister_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
 	engine_remove_observer_by_id(
 			obj_inst->obj->obj_id, obj_inst->obj_inst_id);
 	sys_slist_find_and_remove(&engine_obj_inst_list, &obj_inst->node);
+	sys_slist_find_and_remove(path_index(engine_obj_inst_index,
+					     obj_inst->obj->obj_id,
+					     obj_inst->obj_inst_id),
+				  &obj_inst->index_node);
 }
 
 static struct lwm2m_engine_obj_inst *get_engine_obj_inst(int obj_id,
@@ -661,8 +841,9 @@ static struct lwm2m_engine_obj_inst *get_engine_obj_inst(int obj_id,
 {
 	struct lwm2m_engine_obj_inst *obj_inst;
 
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_inst_list, obj_inst,
-				     node) {
+	SYS_SLIST_FOR_EACH_CONTAINER(
+			path_index(engine_obj_inst_index, obj_id, obj_inst_id),
+			obj_inst, index_node) {
 		if (obj_inst->obj->obj_id == obj_id &&
 		    obj_inst->obj_inst_id == obj_inst_id) {
 			return obj_inst;
@@ -1140,6 +1321,18 @@ static int select_writer(struct lwm2m_output_context *out, uint16_t accept)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		out->writer = &senml_json_writer;
+		break;
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		out->writer = &senml_cbor_writer;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", accept);
 		return -ENOMSG;
@@ -1171,6 +1364,18 @@ static int select_reader(struct lwm2m_input_context *in, uint16_t format)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		in->reader = &senml_json_reader;
+		break;
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		in->reader = &senml_cbor_reader;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", format);
 		return -ENOMSG;
@@ -1181,8 +1386,8 @@ static int select_reader(struct lwm2m_input_context *in, uint16_t format)
 
 /* user data setter functions */
 
-static int string_to_path(char *pathstr, struct lwm2m_obj_path *path,
-			  char delim)
+int lwm2m_string_to_path(char *pathstr, struct lwm2m_obj_path *path,
+			 char delim)
 {
 	uint16_t value, len;
 	int i, tokstart = -1, toklen;
@@ -1329,7 +1534,7 @@ int lwm2m_engine_create_obj_inst(char *pathstr)
 	LOG_DBG("path:%s", log_strdup(pathstr));
 
 	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -1350,7 +1555,7 @@ int lwm2m_engine_set_res_data(char *pathstr, void *data_ptr, uint16_t data_len,
 	int ret = 0;
 
 	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -1394,7 +1599,7 @@ static int lwm2m_engine_set(char *pathstr, void *value, uint16_t len)
 	LOG_DBG("path:%s, value:%p, len:%d", log_strdup(pathstr), value, len);
 
 	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -1620,7 +1825,7 @@ int lwm2m_engine_get_res_data(char *pathstr, void **data_ptr, uint16_t *data_len
 	int ret = 0;
 
 	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -1662,7 +1867,7 @@ static int lwm2m_engine_get(char *pathstr, void *buf, uint16_t buflen)
 	LOG_DBG("path:%s, buf:%p, buflen:%d", log_strdup(pathstr), buf, buflen);
 
 	/* translate path -> path_obj */
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -1861,7 +2066,7 @@ int lwm2m_engine_get_resource(char *pathstr, struct lwm2m_engine_res **res)
 	int ret;
 	struct lwm2m_obj_path path;
 
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -1891,7 +2096,7 @@ int lwm2m_engine_create_res_inst(char *pathstr)
 	struct lwm2m_engine_res_inst *res_inst = NULL;
 	struct lwm2m_obj_path path;
 
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -1943,7 +2148,7 @@ int lwm2m_engine_delete_res_inst(char *pathstr)
 	struct lwm2m_engine_res_inst *res_inst = NULL;
 	struct lwm2m_obj_path path;
 
-	ret = string_to_path(pathstr, &path, '/');
+	ret = lwm2m_string_to_path(pathstr, &path, '/');
 	if (ret < 0) {
 		return ret;
 	}
@@ -2748,6 +2953,9 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 		return 0;
 	}
 
+	/* pmax may be shorter, look for the next notification again */
+	engine_observer_pmax_timestamp = 0;
+
 	/* update observe_node accordingly */
 	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
 		/* updated path is deeper than obs node, skip */
@@ -2885,6 +3093,16 @@ static int do_read_op(struct lwm2m_message *msg, uint16_t content_format)
 		return do_read_op_json(msg, content_format);
 #endif
 
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_read_op_senml_json(msg, content_format);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_read_op_senml_cbor(msg, content_format);
+#endif
+
 	default:
 		LOG_ERR("Unsupported content-format: %u", content_format);
 		return -ENOMSG;
@@ -2892,27 +3110,72 @@ static int do_read_op(struct lwm2m_message *msg, uint16_t content_format)
 	}
 }
 
-int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+static int do_composite_read_op(struct lwm2m_message *msg,
+				uint16_t content_format,
+				struct lwm2m_obj_path *paths,
+				uint8_t path_count)
 {
-	struct lwm2m_engine_obj_inst *obj_inst = NULL;
-	struct lwm2m_engine_res *res = NULL;
-	struct lwm2m_engine_obj_field *obj_field;
-	struct lwm2m_obj_path temp_path;
-	int ret = 0, index;
-	uint8_t num_read = 0U;
+	switch (content_format) {
+
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_composite_read_op_senml_json(msg, paths, path_count);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_composite_read_op_senml_cbor(msg, paths, path_count);
+#endif
+
+	default:
+		LOG_ERR("Unsupported content-format: %u", content_format);
+		return -ENOMSG;
 
-	if (msg->path.level >= 2U) {
-		obj_inst = get_engine_obj_inst(msg->path.obj_id,
-					       msg->path.obj_inst_id);
-	} else if (msg->path.level == 1U) {
-		/* find first obj_inst with path's obj_id */
-		obj_inst = next_engine_obj_inst(msg->path.obj_id, -1);
 	}
+}
 
-	if (!obj_inst) {
-		return -ENOENT;
+static int parse_composite_paths(struct lwm2m_message *msg, uint16_t format,
+				 struct lwm2m_obj_path *paths,
+				 uint8_t max_paths)
+{
+	switch (format) {
+
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return parse_composite_paths_senml_json(msg, paths, max_paths);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return parse_composite_paths_senml_cbor(msg, paths, max_paths);
+#endif
+
+	default:
+		LOG_ERR("Unsupported format: %u", format);
+		return -ENOMSG;
+
+	}
+}
+#endif /* CONFIG_LWM2M_COMPOSITE_SUPPORT */
+
+static struct lwm2m_engine_obj_inst *
+read_op_obj_inst(struct lwm2m_obj_path *path)
+{
+	if (path->level >= 2U) {
+		return get_engine_obj_inst(path->obj_id, path->obj_inst_id);
+	} else if (path->level == 1U) {
+		/* find first obj_inst with path's obj_id */
+		return next_engine_obj_inst(path->obj_id, -1);
 	}
 
+	return NULL;
+}
+
+static int read_op_header(struct lwm2m_message *msg, uint16_t content_format)
+{
+	int ret;
+
 	/* set output content-format */
 	ret = coap_append_option_int(msg->out.out_cpkt,
 				     COAP_OPTION_CONTENT_FORMAT,
@@ -2928,9 +3191,17 @@ int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
 		return ret;
 	}
 
-	/* store original path values so we can change them during processing */
-	memcpy(&temp_path, &msg->path, sizeof(temp_path));
-	engine_put_begin(&msg->out, &msg->path);
+	return 0;
+}
+
+/* Read msg->path from obj_inst on, counting the resources read */
+static int read_op_obj_insts(struct lwm2m_message *msg,
+			     struct lwm2m_engine_obj_inst *obj_inst,
+			     uint8_t *num_read)
+{
+	struct lwm2m_engine_res *res = NULL;
+	struct lwm2m_engine_obj_field *obj_field;
+	int ret = 0, index;
 
 	while (obj_inst) {
 		if (!obj_inst->resources || obj_inst->resource_count == 0U) {
@@ -2981,7 +3252,7 @@ int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
 						LOG_ERR("READ OP: %d", ret);
 					}
 				} else {
-					num_read += 1U;
+					(*num_read)++;
 				}
 
 				/* end resource formatting */
@@ -3012,6 +3283,32 @@ move_forward:
 		}
 	}
 
+	return ret;
+}
+
+int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_obj_path temp_path;
+	uint8_t num_read = 0U;
+	int ret;
+
+	obj_inst = read_op_obj_inst(&msg->path);
+	if (!obj_inst) {
+		return -ENOENT;
+	}
+
+	ret = read_op_header(msg, content_format);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* store original path values so we can change them during processing */
+	memcpy(&temp_path, &msg->path, sizeof(temp_path));
+	engine_put_begin(&msg->out, &msg->path);
+
+	ret = read_op_obj_insts(msg, obj_inst, &num_read);
+
 	engine_put_end(&msg->out, &msg->path);
 
 	/* restore original path values */
@@ -3025,6 +3322,47 @@ move_forward:
 	return ret;
 }
 
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+/*
+ * Read a list of paths into one payload. Paths of objects or resources
+ * which do not exist are left out, as the resources which cannot be read.
+ */
+int lwm2m_perform_composite_read_op(struct lwm2m_message *msg,
+				    uint16_t content_format,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_obj_path temp_path;
+	uint8_t num_read = 0U;
+	int ret, i;
+
+	ret = read_op_header(msg, content_format);
+	if (ret < 0) {
+		return ret;
+	}
+
+	memcpy(&temp_path, &msg->path, sizeof(temp_path));
+	engine_put_begin(&msg->out, &msg->path);
+
+	for (i = 0; i < path_count; i++) {
+		memcpy(&msg->path, &paths[i], sizeof(msg->path));
+
+		obj_inst = read_op_obj_inst(&msg->path);
+		if (obj_inst) {
+			(void)read_op_obj_insts(msg, obj_inst, &num_read);
+		}
+	}
+
+	engine_put_end(&msg->out, &msg->path);
+
+	/* restore original path values */
+	memcpy(&msg->path, &temp_path, sizeof(temp_path));
+
+	return num_read ? 0 : -ENOENT;
+}
+#endif
+
 static int print_attr(struct lwm2m_output_context *out,
 		      uint8_t *buf, uint16_t buflen, void *ref)
 {
@@ -3288,6 +3626,16 @@ static int do_write_op(struct lwm2m_message *msg,
 		return do_write_op_json(msg);
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_write_op_senml_json(msg);
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_write_op_senml_cbor(msg);
+#endif
+
 	default:
 		LOG_ERR("Unsupported format: %u", format);
 		return -ENOMSG;
@@ -3318,6 +3666,51 @@ static int bootstrap_delete(void)
 }
 #endif
 
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+/* Read-Composite and Observe-Composite: FETCH of the paths of the payload */
+static int handle_composite_read(struct lwm2m_message *msg, uint16_t format,
+				 uint16_t accept, int observe,
+				 const uint8_t *token, uint8_t tkl)
+{
+	struct lwm2m_obj_path paths[CONFIG_LWM2M_COMPOSITE_PATH_MAX];
+	int count, r;
+
+	count = parse_composite_paths(msg, format, paths, ARRAY_SIZE(paths));
+	if (count < 0) {
+		LOG_ERR("Error parsing composite paths: %d", count);
+		return count;
+	}
+
+	if (observe == 0) {
+		if (!msg->token) {
+			LOG_ERR("OBSERVE request missing token");
+			return -EINVAL;
+		}
+
+		r = coap_append_option_int(msg->out.out_cpkt,
+					   COAP_OPTION_OBSERVE, 1);
+		if (r < 0) {
+			LOG_ERR("OBSERVE option error: %d", r);
+			return r;
+		}
+
+		r = engine_add_composite_observer(msg, token, tkl, accept,
+						  paths, count);
+		if (r < 0) {
+			LOG_ERR("add OBSERVE error: %d", r);
+			return r;
+		}
+	} else if (observe == 1) {
+		r = engine_remove_observer(token, tkl);
+		if (r < 0) {
+			LOG_ERR("remove observe error: %d", r);
+		}
+	}
+
+	return do_composite_read_op(msg, accept, paths, count);
+}
+#endif
+
 static int handle_request(struct coap_packet *request,
 			  struct lwm2m_message *msg)
 {
@@ -3336,6 +3729,7 @@ static int handle_request(struct coap_packet *request,
 	uint16_t payload_len = 0U;
 	bool last_block = false;
 	bool ignore = false;
+	bool composite = false;
 
 	/* set CoAP request / message */
 	msg->in.in_cpkt = request;
@@ -3347,6 +3741,12 @@ static int handle_request(struct coap_packet *request,
 
 	code = coap_header_get_code(msg->in.in_cpkt);
 
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+	/* FETCH and iPATCH of the root path carry their paths in the payload */
+	composite = (code & COAP_REQUEST_MASK) == COAP_METHOD_FETCH ||
+		    (code & COAP_REQUEST_MASK) == COAP_METHOD_IPATCH;
+#endif
+
 	/* setup response token */
 	tkl = coap_header_get_token(msg->in.in_cpkt, token);
 	if (tkl) {
@@ -3357,7 +3757,7 @@ static int handle_request(struct coap_packet *request,
 	/* parse the URL path into components */
 	r = coap_find_options(msg->in.in_cpkt, COAP_OPTION_URI_PATH, options,
 			      ARRAY_SIZE(options));
-	if (r <= 0) {
+	if (r <= 0 && !composite) {
 		switch (code & COAP_REQUEST_MASK) {
 #if defined(CONFIG_LWM2M_RD_CLIENT_SUPPORT_BOOTSTRAP)
 		case COAP_METHOD_DELETE:
@@ -3385,8 +3785,14 @@ static int handle_request(struct coap_packet *request,
 		}
 	}
 
+	if (composite) {
+		if (r != 0) {
+			r = -EPERM;
+			goto error;
+		}
+
 	/* check for .well-known/core URI query (DISCOVER) */
-	if (r == 2 &&
+	} else if (r == 2 &&
 	    (options[0].len == 11U &&
 	     strncmp(options[0].value, ".well-known", 11) == 0) &&
 	    (options[1].len == 4U &&
@@ -3429,10 +3835,19 @@ static int handle_request(struct coap_packet *request,
 		}
 	}
 
+	/* paths and values of all the objects are only given with SenML */
+	if (composite && format != LWM2M_FORMAT_APP_SENML_JSON &&
+	    format != LWM2M_FORMAT_APP_SENML_CBOR) {
+		r = -ENOMSG;
+		goto error;
+	}
+
 	/* read Accept / setup out.writer */
 	r = coap_find_options(msg->in.in_cpkt, COAP_OPTION_ACCEPT, options, 1);
 	if (r > 0) {
 		accept = coap_option_value_to_int(&options[0]);
+	} else if (composite) {
+		accept = format;
 	} else {
 		LOG_DBG("No accept option given. Assume OMA TLV.");
 		accept = LWM2M_FORMAT_OMA_TLV;
@@ -3443,7 +3858,7 @@ static int handle_request(struct coap_packet *request,
 		goto error;
 	}
 
-	if (!well_known) {
+	if (!well_known && !composite) {
 		/* find registered obj */
 		obj = get_engine_obj(msg->path.obj_id);
 		if (!obj) {
@@ -3506,6 +3921,22 @@ static int handle_request(struct coap_packet *request,
 		msg->code = COAP_RESPONSE_CODE_DELETED;
 		break;
 
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+	case COAP_METHOD_FETCH:
+		msg->operation = LWM2M_OP_READ;
+
+		/* check for observe */
+		observe = coap_get_option_int(msg->in.in_cpkt,
+					      COAP_OPTION_OBSERVE);
+		msg->code = COAP_RESPONSE_CODE_CONTENT;
+		break;
+
+	case COAP_METHOD_IPATCH:
+		msg->operation = LWM2M_OP_WRITE;
+		msg->code = COAP_RESPONSE_CODE_CHANGED;
+		break;
+#endif
+
 	default:
 		break;
 	}
@@ -3588,6 +4019,14 @@ static int handle_request(struct coap_packet *request,
 		switch (msg->operation) {
 
 		case LWM2M_OP_READ:
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+			if (composite) {
+				r = handle_composite_read(msg, format, accept,
+							  observe, token, tkl);
+				break;
+			}
+#endif
+
 			if (observe == 0) {
 				/* add new observer */
 				if (msg->token) {
@@ -3601,7 +4040,7 @@ static int handle_request(struct coap_packet *request,
 					}
 
 					r = engine_add_observer(msg, token, tkl,
-								accept);
+								accept, false);
 					if (r < 0) {
 						LOG_ERR("add OBSERVE error: %d", r);
 						goto error;
@@ -3934,6 +4373,10 @@ static int generate_notify_message(struct observe_node *obs,
 {
 	struct lwm2m_message *msg;
 	struct lwm2m_engine_obj_inst *obj_inst;
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+	struct lwm2m_obj_path paths[CONFIG_LWM2M_COMPOSITE_PATH_MAX];
+	uint8_t path_count = 0U;
+#endif
 	int ret = 0;
 
 	if (!obs->ctx) {
@@ -3961,14 +4404,24 @@ static int generate_notify_message(struct observe_node *obs,
 		log_strdup(lwm2m_sprint_ip_addr(&obs->ctx->remote_addr)),
 		k_uptime_get());
 
-	obj_inst = get_engine_obj_inst(obs->path.obj_id,
-				       obs->path.obj_inst_id);
-	if (!obj_inst) {
-		LOG_ERR("unable to get engine obj for %u/%u",
-			obs->path.obj_id,
-			obs->path.obj_inst_id);
-		ret = -EINVAL;
-		goto cleanup;
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+	if (obs->composite) {
+		/* the paths which do not exist are left out of the payload */
+		path_count = composite_observer_paths(obs, paths);
+		(void)memset(&msg->path, 0, sizeof(msg->path));
+	}
+#endif
+
+	if (!obs->composite) {
+		obj_inst = get_engine_obj_inst(obs->path.obj_id,
+					       obs->path.obj_inst_id);
+		if (!obj_inst) {
+			LOG_ERR("unable to get engine obj for %u/%u",
+				obs->path.obj_id,
+				obs->path.obj_inst_id);
+			ret = -EINVAL;
+			goto cleanup;
+		}
 	}
 
 	msg->type = COAP_TYPE_CON;
@@ -3997,7 +4450,16 @@ static int generate_notify_message(struct observe_node *obs,
 	/* set the output writer */
 	select_writer(&msg->out, obs->format);
 
-	ret = do_read_op(msg, obs->format);
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+	if (obs->composite) {
+		ret = do_composite_read_op(msg, obs->format, paths, path_count);
+	}
+#endif
+
+	if (!obs->composite) {
+		ret = do_read_op(msg, obs->format);
+	}
+
 	if (ret < 0) {
 		LOG_ERR("error in multi-format read (err:%d)", ret);
 		goto cleanup;
@@ -4009,6 +4471,12 @@ static int generate_notify_message(struct observe_node *obs,
 		goto cleanup;
 	}
 
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+	if (obs->composite) {
+		composite_observer_notified(obs, k_uptime_get());
+	}
+#endif
+
 	LOG_DBG("NOTIFY MSG: SENT");
 	return 0;
 
@@ -4066,42 +4534,123 @@ int lwm2m_engine_add_service(k_work_handler_t service, uint32_t period_ms)
 	return 0;
 }
 
-static int lwm2m_engine_service(void)
+static void engine_notify_events(int64_t timestamp)
 {
-	struct observe_node *obs;
-	struct service_node *srv;
-	int64_t timestamp, service_due_timestamp;
+	struct observe_node *obs, *tmp;
+	sys_snode_t *prev_node = NULL;
+	sys_snode_t *node;
+	int64_t last_timestamp;
+	k_spinlock_key_t key;
+	int ret;
 
 	/*
-	 * 1. scan the observer list
-	 * 2. For each notify event found, scan the observer list
-	 * 3. For each observer match, generate a NOTIFY message,
-	 *    attaching the notify response handler
+	 * manual notify requirements:
+	 * - event_timestamp > last_timestamp
+	 * - current timestamp > last_timestamp + min_period_sec
+	 *
+	 * Only the observers with an event are in the event list, and all
+	 * the events of an observer within its pmin are notified at once.
+	 * Updates from other threads add events meanwhile, so the lists
+	 * are only walked with the lock held, and the observers past their
+	 * pmin are moved to the notify list to be sent without it.
 	 */
-	timestamp = k_uptime_get();
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
-		/*
-		 * manual notify requirements:
-		 * - event_timestamp > last_timestamp
-		 * - current timestamp > last_timestamp + min_period_sec
-		 */
+	key = k_spin_lock(&engine_observer_event_lock);
+
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&engine_observer_event_list,
+					  obs, tmp, event_node) {
 		if (obs->event_timestamp > obs->last_timestamp &&
-		    timestamp > obs->last_timestamp +
-				MSEC_PER_SEC * obs->min_period_sec) {
-			obs->last_timestamp = k_uptime_get();
-			generate_notify_message(obs, true);
+		    timestamp <= obs->last_timestamp +
+				 MSEC_PER_SEC * obs->min_period_sec) {
+			prev_node = &obs->event_node;
+			continue;
+		}
 
-		/*
-		 * automatic time-based notify requirements:
-		 * - current timestamp > last_timestamp + max_period_sec
-		 */
-		} else if (timestamp > obs->last_timestamp +
+		sys_slist_remove(&engine_observer_event_list, prev_node,
+				 &obs->event_node);
+
+		if (obs->event_timestamp > obs->last_timestamp) {
+			sys_slist_append(&engine_observer_notify_list,
+					 &obs->event_node);
+		} else {
+			/* already sent by a pmax notification */
+			obs->event_pending = false;
+		}
+	}
+
+	while ((node = sys_slist_get(&engine_observer_notify_list)) != NULL) {
+		obs = CONTAINER_OF(node, struct observe_node, event_node);
+
+		/* later events need a new notification */
+		last_timestamp = obs->last_timestamp;
+		obs->last_timestamp = k_uptime_get();
+		obs->event_pending = false;
+		k_spin_unlock(&engine_observer_event_lock, key);
+
+		ret = generate_notify_message(obs, true);
+
+		key = k_spin_lock(&engine_observer_event_lock);
+
+		/* out of messages, keep the events for the next pass */
+		if (ret == -ENOMEM) {
+			obs->last_timestamp = last_timestamp;
+			if (!obs->event_pending) {
+				obs->event_pending = true;
+				sys_slist_prepend(&engine_observer_event_list,
+						  &obs->event_node);
+			}
+
+			sys_slist_merge_slist(&engine_observer_event_list,
+					      &engine_observer_notify_list);
+			break;
+		}
+	}
+
+	k_spin_unlock(&engine_observer_event_lock, key);
+}
+
+static void engine_notify_pmax(int64_t timestamp)
+{
+	struct observe_node *obs;
+	int64_t pmax_timestamp;
+
+	if (timestamp <= engine_observer_pmax_timestamp) {
+		return;
+	}
+
+	/*
+	 * automatic time-based notify requirements:
+	 * - current timestamp > last_timestamp + max_period_sec
+	 */
+	engine_observer_pmax_timestamp = INT64_MAX;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+		if (timestamp > obs->last_timestamp +
 				MSEC_PER_SEC * obs->max_period_sec) {
 			obs->last_timestamp = k_uptime_get();
 			generate_notify_message(obs, false);
 		}
 
+		pmax_timestamp = obs->last_timestamp +
+				 MSEC_PER_SEC * obs->max_period_sec;
+		engine_observer_pmax_timestamp =
+			MIN(engine_observer_pmax_timestamp, pmax_timestamp);
 	}
+}
+
+static int lwm2m_engine_service(void)
+{
+	struct service_node *srv;
+	int64_t timestamp, service_due_timestamp;
+
+	/*
+	 * 1. walk the observers with a notify event, and the observers
+	 *    reaching their pmax when one of them may do so
+	 * 2. For each of them, generate a NOTIFY message, attaching the
+	 *    notify response handler
+	 */
+	timestamp = k_uptime_get();
+	engine_notify_events(timestamp);
+	engine_notify_pmax(timestamp);
 
 	timestamp = k_uptime_get();
 	SYS_SLIST_FOR_EACH_CONTAINER(&engine_service_list, srv, node) {
@@ -4133,9 +4682,7 @@ int lwm2m_engine_context_close(struct lwm2m_ctx *client_ctx)
 	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&engine_observer_list,
 					  obs, tmp, node) {
 		if (obs->ctx == client_ctx) {
-			sys_slist_remove(&engine_observer_list, prev_node,
-					 &obs->node);
-			(void)memset(obs, 0, sizeof(*obs));
+			remove_observer_node(obs, prev_node);
 		} else {
 			prev_node = &obs->node;
 		}
@@ -18,6 +18,8 @@
 #define LWM2M_FORMAT_APP_OCTET_STREAM	42
 #define LWM2M_FORMAT_APP_EXI		47
 #define LWM2M_FORMAT_APP_JSON		50
+#define LWM2M_FORMAT_APP_SENML_JSON	110
+#define LWM2M_FORMAT_APP_SENML_CBOR	112
 #define LWM2M_FORMAT_OMA_PLAIN_TEXT	1541
 #define LWM2M_FORMAT_OMA_OLD_TLV	1542
 #define LWM2M_FORMAT_OMA_OLD_JSON	1543
@@ -81,7 +83,16 @@ int lwm2m_send_message(struct lwm2m_message *msg);
 
 uint16_t lwm2m_get_rd_data(uint8_t *client_data, uint16_t size);
 
+int lwm2m_string_to_path(char *pathstr, struct lwm2m_obj_path *path,
+			 char delim);
+
 int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format);
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+int lwm2m_perform_composite_read_op(struct lwm2m_message *msg,
+				    uint16_t content_format,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count);
+#endif
 
 int lwm2m_write_handler(struct lwm2m_engine_obj_inst *obj_inst,
 			struct lwm2m_engine_res *res,
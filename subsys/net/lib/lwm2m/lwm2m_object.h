@@ -342,6 +342,8 @@ struct lwm2m_engine_res {
 struct lwm2m_engine_obj_inst {
 	/* instance list */
 	sys_snode_t node;
+	/* instance index bucket list */
+	sys_snode_t index_node;
 
 	struct lwm2m_engine_obj *obj;
 	struct lwm2m_engine_res *resources;
@@ -0,0 +1,1099 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML CBOR content format (RFC 8428 section 6), as used by LwM2M 1.1.
+ * The records are maps with the integer labels of the RFC, and the
+ * "vlo" text label of LwM2M for object links. The array and the maps
+ * written have a definite length; the reader also accepts indefinite
+ * lengths.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_cbor
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/byteorder.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "lwm2m_rw_plain_text.h"
+#include "lwm2m_engine.h"
+#include "lwm2m_util.h"
+
+/* CBOR major types */
+#define CBOR_UINT		0
+#define CBOR_NINT		1
+#define CBOR_BYTES		2
+#define CBOR_TEXT		3
+#define CBOR_ARRAY		4
+#define CBOR_MAP		5
+#define CBOR_TAG		6
+#define CBOR_SIMPLE		7
+
+/* additional info values */
+#define CBOR_AI_HALF		25
+#define CBOR_AI_SINGLE		26
+#define CBOR_AI_DOUBLE		27
+#define CBOR_AI_INDEFINITE	31
+
+#define CBOR_FALSE		0xf4
+#define CBOR_TRUE		0xf5
+#define CBOR_BREAK		0xff
+
+/* SenML labels */
+#define SENML_BASE_NAME		-2
+#define SENML_NAME		0
+#define SENML_VALUE		2
+#define SENML_STRING_VALUE	3
+#define SENML_BOOL_VALUE	4
+#define SENML_DATA_VALUE	8
+#define SENML_OBJLNK_VALUE	"vlo"
+
+/* nesting of the items skipped in a record */
+#define SKIP_DEPTH		4
+
+/* "/65535/65535/" base name followed by a "65535/65535" name */
+#define NAME_BUF_LEN		sizeof("/65535/65535/65535/65535")
+
+struct senml_cbor_out_formatter_data {
+	/* position of the array head, and number of records */
+	uint16_t array_offset;
+	uint16_t record_count;
+
+	/* object instance of the last base name written */
+	uint16_t bn_obj_id;
+	uint16_t bn_obj_inst_id;
+	bool bn_written;
+
+	/* flags */
+	uint8_t writer_flags;
+};
+
+struct senml_cbor_in_formatter_data {
+	/* base name text, kept across records */
+	uint16_t bn_offset;
+	uint16_t bn_len;
+
+	/* name text */
+	uint16_t name_offset;
+	uint16_t name_len;
+
+	/* value item */
+	uint16_t value_offset;
+	bool has_value;
+
+	/* position of the next record, and records left in the pack */
+	uint16_t offset;
+	uint64_t record_count;
+	bool indefinite;
+	bool in_pack;
+};
+
+static size_t put_head(struct lwm2m_output_context *out, uint8_t major,
+		       uint64_t arg)
+{
+	uint8_t buf[9];
+	int len, i;
+
+	if (arg < 24) {
+		buf[0] = (major << 5) | arg;
+		len = 1;
+	} else {
+		if (arg <= UINT8_MAX) {
+			len = 1;
+		} else if (arg <= UINT16_MAX) {
+			len = 2;
+		} else if (arg <= UINT32_MAX) {
+			len = 4;
+		} else {
+			len = 8;
+		}
+
+		/* 24 + log2(len) */
+		buf[0] = (major << 5) | (24 + find_lsb_set(len) - 1);
+
+		for (i = len; i > 0; i--) {
+			buf[i] = arg & 0xff;
+			arg >>= 8;
+		}
+
+		len++;
+	}
+
+	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), buf, len) < 0) {
+		return 0;
+	}
+
+	return len;
+}
+
+static size_t put_int(struct lwm2m_output_context *out, int64_t value)
+{
+	if (value < 0) {
+		return put_head(out, CBOR_NINT, (uint64_t)(-(value + 1)));
+	}
+
+	return put_head(out, CBOR_UINT, value);
+}
+
+static size_t put_bytes(struct lwm2m_output_context *out, uint8_t major,
+			const void *buf, size_t buflen)
+{
+	size_t len;
+
+	len = put_head(out, major, buflen);
+	if (len == 0 || buf_append(CPKT_BUF_WRITE(out->out_cpkt),
+				   (uint8_t *)buf, buflen) < 0) {
+		return 0;
+	}
+
+	return len + buflen;
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	/* written again with the number of records at the end */
+	fd->array_offset = out->out_cpkt->offset;
+	fd->record_count = 0U;
+
+	return put_head(out, CBOR_ARRAY, 0);
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	uint8_t count[2];
+	uint16_t len;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	if (fd->record_count < 24) {
+		out->out_cpkt->data[fd->array_offset] =
+			(CBOR_ARRAY << 5) | fd->record_count;
+		return 0;
+	}
+
+	if (fd->record_count <= UINT8_MAX) {
+		out->out_cpkt->data[fd->array_offset] = (CBOR_ARRAY << 5) | 24;
+		count[0] = fd->record_count;
+		len = 1U;
+	} else {
+		out->out_cpkt->data[fd->array_offset] = (CBOR_ARRAY << 5) | 25;
+		sys_put_be16(fd->record_count, count);
+		len = 2U;
+	}
+
+	if (buf_insert(CPKT_BUF_WRITE(out->out_cpkt), fd->array_offset + 1,
+		       count, len) < 0) {
+		return 0;
+	}
+
+	return len;
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+/* Start a record up to its value label */
+static size_t put_record_prefix(struct lwm2m_output_context *out,
+				struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	char name[sizeof("/65535/65535/")];
+	bool bn;
+	size_t len;
+	int ret;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	bn = !fd->bn_written || fd->bn_obj_id != path->obj_id ||
+	     fd->bn_obj_inst_id != path->obj_inst_id;
+
+	fd->record_count++;
+	len = put_head(out, CBOR_MAP, bn ? 3 : 2);
+
+	if (bn) {
+		ret = snprintk(name, sizeof(name), "/%u/%u/", path->obj_id,
+			       path->obj_inst_id);
+		len += put_int(out, SENML_BASE_NAME);
+		len += put_bytes(out, CBOR_TEXT, name, ret);
+
+		fd->bn_obj_id = path->obj_id;
+		fd->bn_obj_inst_id = path->obj_inst_id;
+		fd->bn_written = true;
+	}
+
+	if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+		ret = snprintk(name, sizeof(name), "%u/%u", path->res_id,
+			       path->res_inst_id);
+	} else {
+		ret = snprintk(name, sizeof(name), "%u", path->res_id);
+	}
+
+	len += put_int(out, SENML_NAME);
+	len += put_bytes(out, CBOR_TEXT, name, ret);
+
+	return len;
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int64_t value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path);
+	len += put_int(out, SENML_VALUE);
+	len += put_int(out, value);
+
+	return len;
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int32_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int16_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, int8_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path);
+	len += put_int(out, SENML_STRING_VALUE);
+	len += put_bytes(out, CBOR_TEXT, buf, buflen);
+
+	return len;
+}
+
+/* Whole numbers are written as integers, the others as IEEE floats */
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	uint8_t b32[5];
+	size_t len;
+
+	len = put_record_prefix(out, path);
+	len += put_int(out, SENML_VALUE);
+
+	if (value->val2 == 0) {
+		return len + put_int(out, value->val1);
+	}
+
+	b32[0] = (CBOR_SIMPLE << 5) | CBOR_AI_SINGLE;
+	if (lwm2m_f32_to_b32(value, b32 + 1, 4) < 0 ||
+	    buf_append(CPKT_BUF_WRITE(out->out_cpkt), b32, sizeof(b32)) < 0) {
+		return 0;
+	}
+
+	return len + sizeof(b32);
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	uint8_t b64[9];
+	size_t len;
+
+	len = put_record_prefix(out, path);
+	len += put_int(out, SENML_VALUE);
+
+	if (value->val2 == 0) {
+		return len + put_int(out, value->val1);
+	}
+
+	b64[0] = (CBOR_SIMPLE << 5) | CBOR_AI_DOUBLE;
+	if (lwm2m_f64_to_b64(value, b64 + 1, 8) < 0 ||
+	    buf_append(CPKT_BUF_WRITE(out->out_cpkt), b64, sizeof(b64)) < 0) {
+		return 0;
+	}
+
+	return len + sizeof(b64);
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path,
+		       bool value)
+{
+	uint8_t b = value ? CBOR_TRUE : CBOR_FALSE;
+	size_t len;
+
+	len = put_record_prefix(out, path);
+	len += put_int(out, SENML_BOOL_VALUE);
+
+	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), &b, sizeof(b)) < 0) {
+		return 0;
+	}
+
+	return len + sizeof(b);
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path);
+	len += put_int(out, SENML_DATA_VALUE);
+	len += put_bytes(out, CBOR_BYTES, buf, buflen);
+
+	return len;
+}
+
+static size_t put_objlnk(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 struct lwm2m_objlnk *value)
+{
+	char objlnk[sizeof("65535:65535")];
+	size_t len;
+	int ret;
+
+	ret = snprintk(objlnk, sizeof(objlnk), "%u:%u", value->obj_id,
+		       value->obj_inst);
+
+	len = put_record_prefix(out, path);
+	len += put_bytes(out, CBOR_TEXT, SENML_OBJLNK_VALUE,
+			 strlen(SENML_OBJLNK_VALUE));
+	len += put_bytes(out, CBOR_TEXT, objlnk, ret);
+
+	return len;
+}
+
+/* parser */
+
+/* Read the head of the item at *offset, return its additional info */
+static int get_head(struct lwm2m_input_context *in, uint16_t *offset,
+		    uint8_t *major, uint64_t *arg)
+{
+	uint8_t ib, b;
+	int ai, i;
+
+	if (buf_read_u8(&ib, CPKT_BUF_READ(in->in_cpkt), offset) < 0) {
+		return -EINVAL;
+	}
+
+	*major = ib >> 5;
+	ai = ib & 0x1f;
+	*arg = 0U;
+
+	if (ai < 24) {
+		*arg = ai;
+		return ai;
+	}
+
+	if (ai == CBOR_AI_INDEFINITE) {
+		return ai;
+	}
+
+	if (ai > CBOR_AI_DOUBLE) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < BIT(ai - 24); i++) {
+		if (buf_read_u8(&b, CPKT_BUF_READ(in->in_cpkt), offset) < 0) {
+			return -EINVAL;
+		}
+
+		*arg = (*arg << 8) | b;
+	}
+
+	return ai;
+}
+
+static bool is_break(struct lwm2m_input_context *in, uint16_t *offset)
+{
+	if (*offset < in->in_cpkt->max_len &&
+	    in->in_cpkt->data[*offset] == CBOR_BREAK) {
+		(*offset)++;
+		return true;
+	}
+
+	return false;
+}
+
+static int skip_item(struct lwm2m_input_context *in, uint16_t *offset,
+		     int depth)
+{
+	uint64_t arg, count;
+	uint8_t major;
+	int ai, ret;
+
+	ai = get_head(in, offset, &major, &arg);
+	if (ai < 0) {
+		return ai;
+	}
+
+	switch (major) {
+	case CBOR_UINT:
+	case CBOR_NINT:
+		return ai == CBOR_AI_INDEFINITE ? -EINVAL : 0;
+
+	case CBOR_SIMPLE:
+		/* a break is not an item */
+		return ai == CBOR_AI_INDEFINITE ? -EINVAL : 0;
+
+	case CBOR_BYTES:
+	case CBOR_TEXT:
+		if (ai != CBOR_AI_INDEFINITE) {
+			if (arg > in->in_cpkt->max_len - *offset) {
+				return -EINVAL;
+			}
+
+			*offset += arg;
+			return 0;
+		}
+
+		/* chunks of a definite length */
+		while (!is_break(in, offset)) {
+			if (depth == 0) {
+				return -EINVAL;
+			}
+
+			ret = skip_item(in, offset, 0);
+			if (ret < 0) {
+				return ret;
+			}
+		}
+
+		return 0;
+
+	case CBOR_TAG:
+		return depth ? skip_item(in, offset, depth - 1) : -EINVAL;
+
+	default:
+		break;
+	}
+
+	/* arrays and maps */
+	if (depth == 0) {
+		return -EINVAL;
+	}
+
+	if (ai == CBOR_AI_INDEFINITE) {
+		while (!is_break(in, offset)) {
+			ret = skip_item(in, offset, depth - 1);
+			if (ret < 0) {
+				return ret;
+			}
+		}
+
+		return 0;
+	}
+
+	count = major == CBOR_MAP ? arg * 2 : arg;
+	while (count--) {
+		ret = skip_item(in, offset, depth - 1);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* Read a definite text string, return its offset and length */
+static int get_text(struct lwm2m_input_context *in, uint16_t *offset,
+		    uint16_t *text_offset, uint16_t *text_len)
+{
+	uint64_t arg;
+	uint8_t major;
+	int ai;
+
+	ai = get_head(in, offset, &major, &arg);
+	if (ai < 0 || major != CBOR_TEXT || ai == CBOR_AI_INDEFINITE ||
+	    arg > in->in_cpkt->max_len - *offset) {
+		return -EINVAL;
+	}
+
+	*text_offset = *offset;
+	*text_len = arg;
+	*offset += arg;
+
+	return 0;
+}
+
+static int get_record_key(struct lwm2m_input_context *in, uint16_t *offset,
+			  int64_t *key)
+{
+	uint16_t text_offset, text_len;
+	uint64_t arg;
+	uint8_t major;
+	uint16_t start = *offset;
+	int ai;
+
+	ai = get_head(in, offset, &major, &arg);
+	if (ai < 0 || ai == CBOR_AI_INDEFINITE) {
+		return -EINVAL;
+	}
+
+	if (major == CBOR_UINT || major == CBOR_NINT) {
+		*key = major == CBOR_UINT ? (int64_t)arg : -1 - (int64_t)arg;
+		return 0;
+	}
+
+	/* the only text label is the one of object links */
+	*offset = start;
+	if (get_text(in, offset, &text_offset, &text_len) < 0) {
+		return -EINVAL;
+	}
+
+	if (text_len == strlen(SENML_OBJLNK_VALUE) &&
+	    !memcmp(in->in_cpkt->data + text_offset, SENML_OBJLNK_VALUE,
+		    text_len)) {
+		*key = SENML_VALUE;
+	} else {
+		/* unknown label, skipped with its value */
+		*key = INT64_MIN;
+	}
+
+	return 0;
+}
+
+/*
+ * Read the next record of the pack, return 1 when one is found, 0 at
+ * the end of the pack.
+ */
+static int next_record(struct lwm2m_input_context *in,
+		       struct senml_cbor_in_formatter_data *fd)
+{
+	uint64_t arg, count;
+	uint8_t major;
+	int64_t key;
+	bool indefinite;
+	int ai, ret;
+
+	if (!fd->in_pack) {
+		ai = get_head(in, &fd->offset, &major, &arg);
+		if (ai < 0 || major != CBOR_ARRAY) {
+			return -EINVAL;
+		}
+
+		fd->indefinite = (ai == CBOR_AI_INDEFINITE);
+		fd->record_count = arg;
+		fd->in_pack = true;
+	}
+
+	if (fd->indefinite) {
+		if (is_break(in, &fd->offset)) {
+			return 0;
+		}
+	} else if (fd->record_count-- == 0U) {
+		return 0;
+	}
+
+	ai = get_head(in, &fd->offset, &major, &count);
+	if (ai < 0 || major != CBOR_MAP) {
+		return -EINVAL;
+	}
+
+	indefinite = (ai == CBOR_AI_INDEFINITE);
+	fd->name_len = 0U;
+	fd->has_value = false;
+
+	while (indefinite ? !is_break(in, &fd->offset) : count-- > 0U) {
+		if (get_record_key(in, &fd->offset, &key) < 0) {
+			return -EINVAL;
+		}
+
+		switch (key) {
+		case SENML_BASE_NAME:
+			ret = get_text(in, &fd->offset, &fd->bn_offset,
+				       &fd->bn_len);
+			break;
+
+		case SENML_NAME:
+			ret = get_text(in, &fd->offset, &fd->name_offset,
+				       &fd->name_len);
+			break;
+
+		case SENML_VALUE:
+		case SENML_STRING_VALUE:
+		case SENML_BOOL_VALUE:
+		case SENML_DATA_VALUE:
+			fd->value_offset = fd->offset;
+			fd->has_value = true;
+			/* fall through */
+		default:
+			ret = skip_item(in, &fd->offset, SKIP_DEPTH);
+			break;
+		}
+
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return 1;
+}
+
+/* Path of the record, made of the base name followed by the name */
+static int record_path(struct lwm2m_input_context *in,
+		       struct senml_cbor_in_formatter_data *fd,
+		       struct lwm2m_obj_path *path)
+{
+	char name[NAME_BUF_LEN];
+
+	if (fd->bn_len + fd->name_len >= sizeof(name)) {
+		return -EINVAL;
+	}
+
+	memcpy(name, in->in_cpkt->data + fd->bn_offset, fd->bn_len);
+	memcpy(name + fd->bn_len, in->in_cpkt->data + fd->name_offset,
+	       fd->name_len);
+	name[fd->bn_len + fd->name_len] = '\0';
+
+	return lwm2m_string_to_path(name, path, '/');
+}
+
+/* Head of the value of the current record */
+static int get_value_head(struct lwm2m_input_context *in, uint16_t *offset,
+			  uint8_t *major, uint64_t *arg)
+{
+	struct senml_cbor_in_formatter_data *fd;
+
+	fd = engine_get_in_user_data(in);
+	if (!fd || !fd->has_value) {
+		return -EINVAL;
+	}
+
+	*offset = fd->value_offset;
+	return get_head(in, offset, major, arg);
+}
+
+/* Single from a half precision float, both in host order */
+static uint32_t half_to_single(uint16_t half)
+{
+	uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+	int32_t exp = (half >> 10) & 0x1f;
+	uint32_t mant = half & 0x3ff;
+
+	if (exp == 0x1f) {
+		return sign | 0x7f800000 | (mant << 13);
+	}
+
+	if (exp == 0) {
+		if (mant == 0U) {
+			return sign;
+		}
+
+		/* subnormal, normalized as a single */
+		exp = 1;
+		while (!(mant & 0x400)) {
+			mant <<= 1;
+			exp--;
+		}
+
+		mant &= 0x3ff;
+	}
+
+	return sign | ((exp - 15 + 127) << 23) | (mant << 13);
+}
+
+/*
+ * Read a number value as val1 + val2 / LWM2M_FLOAT64_DEC_MAX, return the
+ * length of the item.
+ */
+static size_t read_number(struct lwm2m_input_context *in,
+			  float64_value_t *value)
+{
+	struct senml_cbor_in_formatter_data *fd;
+	float32_value_t f32;
+	uint16_t offset;
+	uint8_t major;
+	uint64_t arg;
+	uint8_t b[8];
+	int ai;
+
+	ai = get_value_head(in, &offset, &major, &arg);
+	if (ai < 0) {
+		return 0;
+	}
+
+	value->val2 = 0;
+
+	switch (major) {
+	case CBOR_UINT:
+		value->val1 = arg;
+		break;
+
+	case CBOR_NINT:
+		value->val1 = -1 - (int64_t)arg;
+		break;
+
+	case CBOR_SIMPLE:
+		if (ai == CBOR_AI_DOUBLE) {
+			sys_put_be64(arg, b);
+			if (lwm2m_b64_to_f64(b, 8, value) < 0) {
+				return 0;
+			}
+
+			break;
+		}
+
+		if (ai == CBOR_AI_HALF) {
+			arg = half_to_single(arg);
+		} else if (ai != CBOR_AI_SINGLE) {
+			return 0;
+		}
+
+		sys_put_be32(arg, b);
+		if (lwm2m_b32_to_f32(b, 4, &f32) < 0) {
+			return 0;
+		}
+
+		value->val1 = f32.val1;
+		value->val2 = (int64_t)f32.val2 *
+			      (LWM2M_FLOAT64_DEC_MAX / LWM2M_FLOAT32_DEC_MAX);
+		break;
+
+	default:
+		return 0;
+	}
+
+	fd = engine_get_in_user_data(in);
+	return offset - fd->value_offset;
+}
+
+static size_t get_s64(struct lwm2m_input_context *in, int64_t *value)
+{
+	float64_value_t f64;
+	size_t len;
+
+	len = read_number(in, &f64);
+	if (len > 0) {
+		*value = f64.val1;
+	}
+
+	return len;
+}
+
+static size_t get_s32(struct lwm2m_input_context *in, int32_t *value)
+{
+	int64_t tmp;
+	size_t len;
+
+	len = get_s64(in, &tmp);
+	if (len > 0) {
+		*value = (int32_t)tmp;
+	}
+
+	return len;
+}
+
+static size_t get_float32fix(struct lwm2m_input_context *in,
+			     float32_value_t *value)
+{
+	float64_value_t f64;
+	size_t len;
+
+	len = read_number(in, &f64);
+	if (len > 0) {
+		value->val1 = (int32_t)f64.val1;
+		value->val2 = (int32_t)(f64.val2 /
+			(LWM2M_FLOAT64_DEC_MAX / LWM2M_FLOAT32_DEC_MAX));
+	}
+
+	return len;
+}
+
+static size_t get_float64fix(struct lwm2m_input_context *in,
+			     float64_value_t *value)
+{
+	return read_number(in, value);
+}
+
+static size_t get_string(struct lwm2m_input_context *in,
+			 uint8_t *buf, size_t buflen)
+{
+	struct senml_cbor_in_formatter_data *fd;
+	uint16_t offset, text_offset, text_len;
+	size_t len;
+
+	fd = engine_get_in_user_data(in);
+	if (!fd || !fd->has_value || buflen == 0) {
+		return 0;
+	}
+
+	offset = fd->value_offset;
+	if (get_text(in, &offset, &text_offset, &text_len) < 0) {
+		return 0;
+	}
+
+	len = MIN(text_len, buflen - 1);
+	memcpy(buf, in->in_cpkt->data + text_offset, len);
+	buf[len] = '\0';
+
+	return offset - fd->value_offset;
+}
+
+static size_t get_bool(struct lwm2m_input_context *in, bool *value)
+{
+	uint16_t offset;
+	uint8_t major;
+	uint64_t arg;
+	int ai;
+
+	ai = get_value_head(in, &offset, &major, &arg);
+	if (ai < 0 || major != CBOR_SIMPLE ||
+	    (arg != (CBOR_FALSE & 0x1f) && arg != (CBOR_TRUE & 0x1f))) {
+		return 0;
+	}
+
+	*value = (arg == (CBOR_TRUE & 0x1f));
+	return 1;
+}
+
+static size_t get_opaque(struct lwm2m_input_context *in,
+			 uint8_t *value, size_t buflen, bool *last_block)
+{
+	uint16_t offset;
+	uint8_t major;
+	uint64_t arg;
+	int ai;
+
+	ai = get_value_head(in, &offset, &major, &arg);
+	if (ai < 0 || major != CBOR_BYTES || ai == CBOR_AI_INDEFINITE ||
+	    arg > in->in_cpkt->max_len - offset) {
+		*last_block = true;
+		return 0;
+	}
+
+	in->offset = offset;
+	in->opaque_len = arg;
+	return lwm2m_engine_get_opaque_more(in, value, buflen, last_block);
+}
+
+static size_t get_objlnk(struct lwm2m_input_context *in,
+			 struct lwm2m_objlnk *value)
+{
+	char buf[sizeof("65535:65535")];
+	char *end;
+	size_t len;
+
+	len = get_string(in, (uint8_t *)buf, sizeof(buf));
+	if (len == 0) {
+		return 0;
+	}
+
+	value->obj_id = strtoul(buf, &end, 10);
+	if (*end != ':') {
+		return 0;
+	}
+
+	value->obj_inst = strtoul(end + 1, NULL, 10);
+
+	return len;
+}
+
+const struct lwm2m_writer senml_cbor_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+	.put_objlnk = put_objlnk,
+};
+
+const struct lwm2m_reader senml_cbor_reader = {
+	.get_s32 = get_s32,
+	.get_s64 = get_s64,
+	.get_string = get_string,
+	.get_float32fix = get_float32fix,
+	.get_float64fix = get_float64fix,
+	.get_bool = get_bool,
+	.get_opaque = get_opaque,
+	.get_objlnk = get_objlnk,
+};
+
+int do_read_op_senml_cbor(struct lwm2m_message *msg, int content_format)
+{
+	struct senml_cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_read_op(msg, content_format);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+static int write_record(struct lwm2m_message *msg,
+			struct senml_cbor_in_formatter_data *fd)
+{
+	int ret;
+
+	/* records of resources, with a value */
+	if (msg->path.level < 3U || !fd->has_value) {
+		return -EINVAL;
+	}
+
+	/* a record is written like the single resource of a text payload */
+	ret = do_write_op_plain_text(msg);
+	if (ret == -EACCES || ret == -ENOENT) {
+		/* if read-only or non-existent data buffer move on */
+		ret = 0;
+	}
+
+	return ret;
+}
+
+int do_write_op_senml_cbor(struct lwm2m_message *msg)
+{
+	struct senml_cbor_in_formatter_data fd;
+	struct lwm2m_obj_path orig_path;
+	int ret, i;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.offset = msg->in.offset;
+	engine_set_in_user_data(&msg->in, &fd);
+
+	/* store a copy of the original path */
+	memcpy(&orig_path, &msg->path, sizeof(msg->path));
+
+	while ((ret = next_record(&msg->in, &fd)) > 0) {
+		ret = record_path(&msg->in, &fd, &msg->path);
+		if (ret < 0) {
+			break;
+		}
+
+		/* records must be within the path of the request */
+		for (i = 0; i < orig_path.level; i++) {
+			if ((&orig_path.obj_id)[i] != (&msg->path.obj_id)[i]) {
+				ret = -EINVAL;
+				break;
+			}
+		}
+
+		ret = ret < 0 ? ret : write_record(msg, &fd);
+		if (ret < 0) {
+			break;
+		}
+	}
+
+	memcpy(&msg->path, &orig_path, sizeof(msg->path));
+	engine_clear_in_user_data(&msg->in);
+
+	return ret;
+}
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+int do_composite_read_op_senml_cbor(struct lwm2m_message *msg,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count)
+{
+	struct senml_cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_composite_read_op(msg,
+					      LWM2M_FORMAT_APP_SENML_CBOR,
+					      paths, path_count);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+int parse_composite_paths_senml_cbor(struct lwm2m_message *msg,
+				     struct lwm2m_obj_path *paths,
+				     uint8_t max_paths)
+{
+	struct senml_cbor_in_formatter_data fd;
+	int count = 0;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.offset = msg->in.offset;
+
+	while ((ret = next_record(&msg->in, &fd)) > 0) {
+		if (count == max_paths) {
+			return -ENOMEM;
+		}
+
+		ret = record_path(&msg->in, &fd, &paths[count]);
+		if (ret < 0) {
+			return ret;
+		}
+
+		count++;
+	}
+
+	return ret < 0 ? ret : count;
+}
+#endif
@@ -0,0 +1,980 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML JSON content format (RFC 8428), as used by LwM2M 1.1:
+ *
+ *   [{"bn":"/3303/0/","n":"5700","v":21.5},{"n":"5701","vs":"Cel"}]
+ *
+ * A base name is written with the first record, and again with each
+ * record of another object instance, which happens in the payloads of
+ * composite reads.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_json
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <ctype.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_json.h"
+#include "lwm2m_rw_plain_text.h"
+#include "lwm2m_engine.h"
+
+#define TOKEN_BUF_LEN	64
+
+/* "/65535/65535/" base name followed by a "65535/65535" name */
+#define NAME_BUF_LEN	sizeof("/65535/65535/65535/65535")
+
+struct senml_json_out_formatter_data {
+	/* object instance of the last base name written */
+	uint16_t bn_obj_id;
+	uint16_t bn_obj_inst_id;
+	bool bn_written;
+
+	/* flags */
+	uint8_t writer_flags;
+};
+
+struct senml_json_in_formatter_data {
+	/* base name info, kept across records */
+	uint16_t bn_offset;
+	uint16_t bn_len;
+
+	/* name info */
+	uint16_t name_offset;
+	uint16_t name_len;
+
+	/* value info, without the quotes of strings */
+	uint16_t value_offset;
+	uint16_t value_len;
+	bool has_value;
+
+	/* position of the next record */
+	uint16_t offset;
+	bool in_pack;
+};
+
+/* some temporary buffer space for format conversions */
+static char json_buffer[TOKEN_BUF_LEN];
+
+static const char base64url[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static size_t put_buf(struct lwm2m_output_context *out,
+		      const char *buf, int len)
+{
+	if (len < 0 || buf_append(CPKT_BUF_WRITE(out->out_cpkt),
+				  (uint8_t *)buf, len) < 0) {
+		/* TODO: Generate error? */
+		return 0;
+	}
+
+	return len;
+}
+
+static size_t put_char(struct lwm2m_output_context *out, char c)
+{
+	return put_buf(out, &c, sizeof(c));
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	return put_char(out, '[');
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	return put_char(out, ']');
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+/* Start a record up to its value, labelled as given */
+static size_t put_record_prefix(struct lwm2m_output_context *out,
+				struct lwm2m_obj_path *path,
+				const char *label)
+{
+	struct senml_json_out_formatter_data *fd;
+	size_t len;
+	int ret;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	if (fd->writer_flags & WRITER_OUTPUT_VALUE) {
+		len = put_char(out, ',');
+	} else {
+		len = 0;
+	}
+
+	if (!fd->bn_written || fd->bn_obj_id != path->obj_id ||
+	    fd->bn_obj_inst_id != path->obj_inst_id) {
+		ret = snprintk(json_buffer, sizeof(json_buffer),
+			       "{\"bn\":\"/%u/%u/\",",
+			       path->obj_id, path->obj_inst_id);
+
+		fd->bn_obj_id = path->obj_id;
+		fd->bn_obj_inst_id = path->obj_inst_id;
+		fd->bn_written = true;
+	} else {
+		ret = snprintk(json_buffer, sizeof(json_buffer), "{");
+	}
+
+	len += put_buf(out, json_buffer, ret);
+
+	if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+		ret = snprintk(json_buffer, sizeof(json_buffer),
+			       "\"n\":\"%u/%u\",\"%s\":",
+			       path->res_id, path->res_inst_id, label);
+	} else {
+		ret = snprintk(json_buffer, sizeof(json_buffer),
+			       "\"n\":\"%u\",\"%s\":", path->res_id, label);
+	}
+
+	return len + put_buf(out, json_buffer, ret);
+}
+
+static size_t put_record_postfix(struct lwm2m_output_context *out)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_OUTPUT_VALUE;
+	return put_char(out, '}');
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int32_t value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, "v");
+	len += plain_text_put_format(out, "%d", value);
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int16_t value)
+{
+	return put_s32(out, path, (int32_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, int8_t value)
+{
+	return put_s32(out, path, (int32_t)value);
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int64_t value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, "v");
+	len += plain_text_put_format(out, "%lld", value);
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	size_t len;
+	size_t i;
+
+	len = put_record_prefix(out, path, "vs");
+	len += put_char(out, '"');
+
+	for (i = 0; i < buflen; i++) {
+		if ((uint8_t)buf[i] < 0x20) {
+			len += put_buf(out, json_buffer,
+				       snprintk(json_buffer,
+						sizeof(json_buffer),
+						"\\u%04x", buf[i]));
+			continue;
+		}
+
+		if (buf[i] == '"' || buf[i] == '\\') {
+			len += put_char(out, '\\');
+		}
+
+		len += put_char(out, buf[i]);
+	}
+
+	len += put_char(out, '"');
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, "v");
+	len += plain_text_put_float32fix(out, path, value);
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, "v");
+	len += plain_text_put_float64fix(out, path, value);
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path,
+		       bool value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, "vb");
+	len += plain_text_put_format(out, "%s", value ? "true" : "false");
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+/* Data values are base64url encoded, without padding */
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	const uint8_t *src = (const uint8_t *)buf;
+	size_t len, pos = 0;
+	size_t i, n;
+	uint32_t v;
+
+	len = put_record_prefix(out, path, "vd");
+	len += put_char(out, '"');
+
+	for (i = 0; i < buflen; i += 3) {
+		n = MIN(buflen - i, 3);
+
+		v = src[i] << 16;
+		if (n > 1) {
+			v |= src[i + 1] << 8;
+		}
+
+		if (n > 2) {
+			v |= src[i + 2];
+		}
+
+		json_buffer[pos++] = base64url[(v >> 18) & 0x3f];
+		json_buffer[pos++] = base64url[(v >> 12) & 0x3f];
+		if (n > 1) {
+			json_buffer[pos++] = base64url[(v >> 6) & 0x3f];
+		}
+
+		if (n > 2) {
+			json_buffer[pos++] = base64url[v & 0x3f];
+		}
+
+		if (pos + 4 > sizeof(json_buffer)) {
+			len += put_buf(out, json_buffer, pos);
+			pos = 0;
+		}
+	}
+
+	len += put_buf(out, json_buffer, pos);
+	len += put_char(out, '"');
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+static size_t put_objlnk(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 struct lwm2m_objlnk *value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, "vlo");
+	len += plain_text_put_format(out, "\"%u:%u\"", value->obj_id,
+				     value->obj_inst);
+	len += put_record_postfix(out);
+
+	return len;
+}
+
+/* parser */
+
+static int next_char(struct lwm2m_input_context *in,
+		     struct senml_json_in_formatter_data *fd)
+{
+	uint8_t c;
+
+	do {
+		if (fd->offset >= in->in_cpkt->max_len) {
+			return -EINVAL;
+		}
+
+		c = in->in_cpkt->data[fd->offset++];
+	} while (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+
+	return c;
+}
+
+/* Find the end of a string or of a literal value */
+static int read_token(struct lwm2m_input_context *in,
+		      struct senml_json_in_formatter_data *fd,
+		      bool string, uint16_t *offset, uint16_t *len)
+{
+	const uint8_t *buf = in->in_cpkt->data;
+	uint16_t max_len = in->in_cpkt->max_len;
+
+	*offset = fd->offset;
+
+	while (fd->offset < max_len) {
+		if (string) {
+			if (buf[fd->offset] == '"') {
+				*len = fd->offset++ - *offset;
+				return 0;
+			}
+
+			if (buf[fd->offset] == '\\') {
+				fd->offset++;
+			}
+		} else if (buf[fd->offset] == ',' || buf[fd->offset] == '}' ||
+			   buf[fd->offset] == ' ' || buf[fd->offset] == '\t' ||
+			   buf[fd->offset] == '\r' || buf[fd->offset] == '\n') {
+			*len = fd->offset - *offset;
+			return 0;
+		}
+
+		fd->offset++;
+	}
+
+	return -EINVAL;
+}
+
+static bool token_is(struct lwm2m_input_context *in, uint16_t offset,
+		     uint16_t len, const char *str)
+{
+	return len == strlen(str) &&
+	       !memcmp(in->in_cpkt->data + offset, str, len);
+}
+
+/*
+ * Read the next record of the pack, return 1 when one is found, 0 at
+ * the end of the pack. The first call starts at the beginning of the
+ * pack.
+ */
+static int next_record(struct lwm2m_input_context *in,
+		       struct senml_json_in_formatter_data *fd)
+{
+	uint16_t key_offset, key_len;
+	uint16_t offset, len;
+	bool string;
+	int c;
+
+	c = next_char(in, fd);
+	if (!fd->in_pack) {
+		if (c != '[') {
+			return -EINVAL;
+		}
+
+		fd->in_pack = true;
+		c = next_char(in, fd);
+	} else if (c == ',') {
+		c = next_char(in, fd);
+	}
+
+	if (c == ']') {
+		return 0;
+	}
+
+	if (c != '{') {
+		return -EINVAL;
+	}
+
+	fd->name_len = 0U;
+	fd->has_value = false;
+
+	c = next_char(in, fd);
+	while (c != '}') {
+		if (c != '"' ||
+		    read_token(in, fd, true, &key_offset, &key_len) < 0 ||
+		    next_char(in, fd) != ':') {
+			return -EINVAL;
+		}
+
+		c = next_char(in, fd);
+		string = (c == '"');
+		if (!string) {
+			fd->offset--;
+		}
+
+		if (read_token(in, fd, string, &offset, &len) < 0) {
+			return -EINVAL;
+		}
+
+		if (token_is(in, key_offset, key_len, "bn")) {
+			fd->bn_offset = offset;
+			fd->bn_len = len;
+		} else if (token_is(in, key_offset, key_len, "n")) {
+			fd->name_offset = offset;
+			fd->name_len = len;
+		} else if (token_is(in, key_offset, key_len, "v") ||
+			   token_is(in, key_offset, key_len, "vs") ||
+			   token_is(in, key_offset, key_len, "vb") ||
+			   token_is(in, key_offset, key_len, "vd") ||
+			   token_is(in, key_offset, key_len, "vlo")) {
+			fd->value_offset = offset;
+			fd->value_len = len;
+			fd->has_value = true;
+		}
+
+		c = next_char(in, fd);
+		if (c == ',') {
+			c = next_char(in, fd);
+		} else if (c != '}') {
+			return -EINVAL;
+		}
+	}
+
+	return 1;
+}
+
+/* Path of the record, made of the base name followed by the name */
+static int record_path(struct lwm2m_input_context *in,
+		       struct senml_json_in_formatter_data *fd,
+		       struct lwm2m_obj_path *path)
+{
+	char name[NAME_BUF_LEN];
+
+	if (fd->bn_len + fd->name_len >= sizeof(name)) {
+		return -EINVAL;
+	}
+
+	memcpy(name, in->in_cpkt->data + fd->bn_offset, fd->bn_len);
+	memcpy(name + fd->bn_len, in->in_cpkt->data + fd->name_offset,
+	       fd->name_len);
+	name[fd->bn_len + fd->name_len] = '\0';
+
+	return lwm2m_string_to_path(name, path, '/');
+}
+
+/*
+ * Read the number of the value as val1 + val2 / dec_max, both with the
+ * sign of the number.
+ */
+static size_t read_number(struct lwm2m_input_context *in,
+			  int64_t *val1, int64_t *val2, int64_t dec_max)
+{
+	struct senml_json_in_formatter_data *fd;
+	const uint8_t *buf;
+	int64_t mantissa = 0;
+	int64_t scale = 1;
+	int digits = 0;
+	int frac_digits = 0;
+	int exp = 0;
+	bool neg = false;
+	bool neg_exp = false;
+	bool dot = false;
+	uint16_t i = 0U;
+
+	*val1 = 0;
+	*val2 = 0;
+
+	fd = engine_get_in_user_data(in);
+	if (!fd || !fd->value_len) {
+		return 0;
+	}
+
+	buf = in->in_cpkt->data + fd->value_offset;
+
+	if (buf[i] == '-') {
+		neg = true;
+		i++;
+	}
+
+	for (; i < fd->value_len; i++) {
+		if (buf[i] == '.' && !dot) {
+			dot = true;
+		} else if (isdigit(buf[i])) {
+			/* ignore the digits past the precision of int64_t */
+			if (digits < 18) {
+				mantissa = mantissa * 10 + (buf[i] - '0');
+				frac_digits += dot;
+				digits += (mantissa != 0);
+			} else if (!dot) {
+				return 0;
+			}
+		} else {
+			break;
+		}
+	}
+
+	if (i < fd->value_len && (buf[i] == 'e' || buf[i] == 'E')) {
+		i++;
+		if (i < fd->value_len && (buf[i] == '-' || buf[i] == '+')) {
+			neg_exp = (buf[i] == '-');
+			i++;
+		}
+
+		for (; i < fd->value_len && isdigit(buf[i]) && exp < 100; i++) {
+			exp = exp * 10 + (buf[i] - '0');
+		}
+
+		if (neg_exp) {
+			exp = -exp;
+		}
+	}
+
+	/* number of decimals of the mantissa */
+	frac_digits -= exp;
+
+	if (frac_digits <= 0) {
+		for (; frac_digits < 0; frac_digits++) {
+			if (mantissa > INT64_MAX / 10) {
+				return 0;
+			}
+
+			mantissa *= 10;
+		}
+
+		*val1 = mantissa;
+	} else if (frac_digits <= 18) {
+		for (; frac_digits > 0; frac_digits--) {
+			scale *= 10;
+		}
+
+		*val1 = mantissa / scale;
+		mantissa %= scale;
+
+		if (scale <= dec_max) {
+			*val2 = mantissa * (dec_max / scale);
+		} else {
+			*val2 = mantissa / (scale / dec_max);
+		}
+	}
+
+	if (neg) {
+		*val1 = -*val1;
+		*val2 = -*val2;
+	}
+
+	return i;
+}
+
+static size_t get_s64(struct lwm2m_input_context *in, int64_t *value)
+{
+	int64_t frac;
+
+	return read_number(in, value, &frac, 1);
+}
+
+static size_t get_s32(struct lwm2m_input_context *in, int32_t *value)
+{
+	int64_t tmp;
+	size_t len;
+
+	len = get_s64(in, &tmp);
+	if (len > 0) {
+		*value = (int32_t)tmp;
+	}
+
+	return len;
+}
+
+static size_t get_string(struct lwm2m_input_context *in,
+			 uint8_t *buf, size_t buflen)
+{
+	struct senml_json_in_formatter_data *fd;
+	const uint8_t *value;
+	char hex[3] = { 0 };
+	size_t len = 0;
+	uint16_t i;
+	uint8_t c;
+
+	fd = engine_get_in_user_data(in);
+	if (!fd || buflen == 0) {
+		return 0;
+	}
+
+	value = in->in_cpkt->data + fd->value_offset;
+
+	for (i = 0U; i < fd->value_len && len < buflen - 1; i++) {
+		c = value[i];
+		if (c == '\\' && i + 1 < fd->value_len) {
+			c = value[++i];
+			switch (c) {
+			case 'b':
+				c = '\b';
+				break;
+			case 'f':
+				c = '\f';
+				break;
+			case 'n':
+				c = '\n';
+				break;
+			case 'r':
+				c = '\r';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			case 'u':
+				/* only characters of the first 256 code points */
+				if (i + 4 >= fd->value_len) {
+					return 0;
+				}
+
+				hex[0] = value[i + 3];
+				hex[1] = value[i + 4];
+				c = strtoul(hex, NULL, 16);
+				i += 4;
+				break;
+			default:
+				break;
+			}
+		}
+
+		buf[len++] = c;
+	}
+
+	buf[len] = '\0';
+	return fd->value_len;
+}
+
+static size_t get_float32fix(struct lwm2m_input_context *in,
+			     float32_value_t *value)
+{
+	int64_t tmp1, tmp2;
+	size_t len;
+
+	len = read_number(in, &tmp1, &tmp2, LWM2M_FLOAT32_DEC_MAX);
+	if (len > 0) {
+		value->val1 = (int32_t)tmp1;
+		value->val2 = (int32_t)tmp2;
+	}
+
+	return len;
+}
+
+static size_t get_float64fix(struct lwm2m_input_context *in,
+			     float64_value_t *value)
+{
+	int64_t tmp1, tmp2;
+	size_t len;
+
+	len = read_number(in, &tmp1, &tmp2, LWM2M_FLOAT64_DEC_MAX);
+	if (len > 0) {
+		value->val1 = tmp1;
+		value->val2 = tmp2;
+	}
+
+	return len;
+}
+
+static size_t get_bool(struct lwm2m_input_context *in, bool *value)
+{
+	struct senml_json_in_formatter_data *fd;
+
+	fd = engine_get_in_user_data(in);
+	if (!fd) {
+		return 0;
+	}
+
+	if (token_is(in, fd->value_offset, fd->value_len, "true")) {
+		*value = true;
+	} else if (token_is(in, fd->value_offset, fd->value_len, "false")) {
+		*value = false;
+	} else {
+		return 0;
+	}
+
+	return fd->value_len;
+}
+
+static int base64url_value(uint8_t c)
+{
+	const char *p;
+
+	p = c ? strchr(base64url, c) : NULL;
+	if (p) {
+		return p - base64url;
+	}
+
+	/* also accept the base64 alphabet */
+	if (c == '+') {
+		return 62;
+	} else if (c == '/') {
+		return 63;
+	}
+
+	return -EINVAL;
+}
+
+static size_t get_opaque(struct lwm2m_input_context *in,
+			 uint8_t *value, size_t buflen, bool *last_block)
+{
+	struct senml_json_in_formatter_data *fd;
+	const uint8_t *src;
+	uint32_t v = 0U;
+	size_t len = 0;
+	uint16_t i;
+	int bits = 0;
+	int d;
+
+	*last_block = true;
+
+	fd = engine_get_in_user_data(in);
+	if (!fd) {
+		return 0;
+	}
+
+	src = in->in_cpkt->data + fd->value_offset;
+
+	for (i = 0U; i < fd->value_len && src[i] != '='; i++) {
+		d = base64url_value(src[i]);
+		if (d < 0) {
+			return 0;
+		}
+
+		v = (v << 6) | d;
+		bits += 6;
+
+		if (bits >= 8) {
+			bits -= 8;
+			if (len == buflen) {
+				LOG_WRN("Opaque value truncated");
+				break;
+			}
+
+			value[len++] = v >> bits;
+		}
+	}
+
+	return len;
+}
+
+static size_t get_objlnk(struct lwm2m_input_context *in,
+			 struct lwm2m_objlnk *value)
+{
+	struct senml_json_in_formatter_data *fd;
+	char buf[sizeof("65535:65535")];
+	char *end;
+
+	fd = engine_get_in_user_data(in);
+	if (!fd || get_string(in, (uint8_t *)buf, sizeof(buf)) == 0) {
+		return 0;
+	}
+
+	value->obj_id = strtoul(buf, &end, 10);
+	if (*end != ':') {
+		return 0;
+	}
+
+	value->obj_inst = strtoul(end + 1, NULL, 10);
+
+	return fd->value_len;
+}
+
+const struct lwm2m_writer senml_json_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+	.put_objlnk = put_objlnk,
+};
+
+const struct lwm2m_reader senml_json_reader = {
+	.get_s32 = get_s32,
+	.get_s64 = get_s64,
+	.get_string = get_string,
+	.get_float32fix = get_float32fix,
+	.get_float64fix = get_float64fix,
+	.get_bool = get_bool,
+	.get_opaque = get_opaque,
+	.get_objlnk = get_objlnk,
+};
+
+int do_read_op_senml_json(struct lwm2m_message *msg, int content_format)
+{
+	struct senml_json_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_read_op(msg, content_format);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+static int write_record(struct lwm2m_message *msg,
+			struct senml_json_in_formatter_data *fd)
+{
+	int ret;
+
+	/* records of resources, with a value */
+	if (msg->path.level < 3U || !fd->has_value) {
+		return -EINVAL;
+	}
+
+	/* a record is written like the single resource of a text payload */
+	ret = do_write_op_plain_text(msg);
+	if (ret == -EACCES || ret == -ENOENT) {
+		/* if read-only or non-existent data buffer move on */
+		ret = 0;
+	}
+
+	return ret;
+}
+
+int do_write_op_senml_json(struct lwm2m_message *msg)
+{
+	struct senml_json_in_formatter_data fd;
+	struct lwm2m_obj_path orig_path;
+	int ret, i;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.offset = msg->in.offset;
+	engine_set_in_user_data(&msg->in, &fd);
+
+	/* store a copy of the original path */
+	memcpy(&orig_path, &msg->path, sizeof(msg->path));
+
+	while ((ret = next_record(&msg->in, &fd)) > 0) {
+		ret = record_path(&msg->in, &fd, &msg->path);
+		if (ret < 0) {
+			break;
+		}
+
+		/* records must be within the path of the request */
+		for (i = 0; i < orig_path.level; i++) {
+			if ((&orig_path.obj_id)[i] != (&msg->path.obj_id)[i]) {
+				ret = -EINVAL;
+				break;
+			}
+		}
+
+		ret = ret < 0 ? ret : write_record(msg, &fd);
+		if (ret < 0) {
+			break;
+		}
+	}
+
+	memcpy(&msg->path, &orig_path, sizeof(msg->path));
+	engine_clear_in_user_data(&msg->in);
+
+	return ret;
+}
+
+#if defined(CONFIG_LWM2M_COMPOSITE_SUPPORT)
+int do_composite_read_op_senml_json(struct lwm2m_message *msg,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count)
+{
+	struct senml_json_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_composite_read_op(msg,
+					      LWM2M_FORMAT_APP_SENML_JSON,
+					      paths, path_count);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+int parse_composite_paths_senml_json(struct lwm2m_message *msg,
+				     struct lwm2m_obj_path *paths,
+				     uint8_t max_paths)
+{
+	struct senml_json_in_formatter_data fd;
+	int count = 0;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	fd.offset = msg->in.offset;
+
+	while ((ret = next_record(&msg->in, &fd)) > 0) {
+		if (count == max_paths) {
+			return -ENOMEM;
+		}
+
+		ret = record_path(&msg->in, &fd, &paths[count]);
+		if (ret < 0) {
+			return ret;
+		}
+
+		count++;
+	}
+
+	return ret < 0 ? ret : count;
+}
+#endif
@@ -197,7 +197,7 @@ int lwm2m_b32_to_f32(uint8_t *b32, size_t len, float32_value_t *f32)
 	e -= 127;
 
 	/* enable "hidden" fraction bit 23 which is always 1 */
-	f  = ((int32_t)1 << 22);
+	f  = ((int32_t)1 << 23);
 	/* calc fraction: bits 22-0 */
 	f += ((int32_t)(b32[1] & 0x7F) << 16);
 	f += ((int32_t)b32[2] << 8);
@@ -230,6 +230,10 @@ int lwm2m_b32_to_f32(uint8_t *b32, size_t len, float32_value_t *f32)
 		}
 	}
 
+	if (sign) {
+		f32->val2 = -f32->val2;
+	}
+
 	return 0;
 }
 
@@ -294,5 +298,9 @@ int lwm2m_b64_to_f64(uint8_t *b64, size_t len, float64_value_t *f64)
 		}
 	}
 
+	if (sign) {
+		f64->val2 = -f64->val2;
+	}
+
 	return 0;
 }
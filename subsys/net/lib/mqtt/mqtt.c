@@ -243,6 +243,10 @@ int mqtt_publish(struct mqtt_client *client,
 	struct buf_ctx packet;
 	struct iovec io_vector[2];
 	struct msghdr msg;
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	struct mqtt_publish_param aliased;
+	bool quota_taken = false;
+#endif
 
 	NULL_PARAM_CHECK(client);
 	NULL_PARAM_CHECK(param);
@@ -261,11 +265,38 @@ int mqtt_publish(struct mqtt_client *client,
 		goto error;
 	}
 
-	err_code = publish_encode(param, &packet);
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		if (param->message.topic.qos > MQTT_QOS_0_AT_MOST_ONCE) {
+			/* Receive Maximum of the server reached. */
+			if (!mqtt_send_quota_take(client)) {
+				err_code = -EBUSY;
+				goto error;
+			}
+
+			quota_taken = true;
+		}
+
+		aliased = *param;
+		mqtt_topic_alias_tx(client, &aliased);
+		param = &aliased;
+	}
+#endif
+
+	err_code = publish_encode(client, param, &packet);
 	if (err_code < 0) {
 		goto error;
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (client->internal.max_packet_size != 0U &&
+	    packet.end - packet.cur + param->message.payload.len >
+					client->internal.max_packet_size) {
+		err_code = -EMSGSIZE;
+		goto error;
+	}
+#endif
+
 	io_vector[0].iov_base = packet.cur;
 	io_vector[0].iov_len = packet.end - packet.cur;
 	io_vector[1].iov_base = param->message.payload.data;
@@ -279,6 +310,21 @@ int mqtt_publish(struct mqtt_client *client,
 	err_code = client_write_msg(client, &msg);
 
 error:
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (err_code < 0 && param == &aliased) {
+		if (quota_taken) {
+			mqtt_send_quota_give(client);
+		}
+
+		/* A topic alias being bound was not received by the server. */
+		if (aliased.prop.topic_alias != 0U &&
+		    aliased.message.topic.topic.size != 0U) {
+			client->internal.tx_alias[
+				aliased.prop.topic_alias - 1].size = 0U;
+		}
+	}
+#endif
+
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 			 client, client->internal.state, err_code);
 
@@ -287,6 +333,66 @@ error:
 	return err_code;
 }
 
+#if defined(CONFIG_MQTT_TX_QUEUE)
+static int client_flush(struct mqtt_client *client)
+{
+	int err_code;
+
+	err_code = mqtt_queue_flush(client);
+	if (err_code < 0) {
+		MQTT_TRC("Queue flush failed, err_code = %d, "
+			 "closing connection", err_code);
+		client_disconnect(client, err_code, true);
+	}
+
+	return err_code;
+}
+
+int mqtt_publish_queued(struct mqtt_client *client,
+			const struct mqtt_publish_param *param)
+{
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(param);
+
+	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Topic size 0x%08x, "
+		 "Data size 0x%08x", client, client->internal.state,
+		 param->message.topic.topic.size,
+		 param->message.payload.len);
+
+	mqtt_mutex_lock(client);
+
+	/* Messages can be queued while disconnected. */
+	err_code = mqtt_queue_publish(client, param);
+
+	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
+			 client, client->internal.state, err_code);
+
+	mqtt_mutex_unlock(client);
+
+	return err_code;
+}
+
+int mqtt_flush(struct mqtt_client *client)
+{
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+
+	mqtt_mutex_lock(client);
+
+	err_code = verify_tx_state(client);
+	if (err_code == 0) {
+		err_code = client_flush(client);
+	}
+
+	mqtt_mutex_unlock(client);
+
+	return err_code;
+}
+#endif /* CONFIG_MQTT_TX_QUEUE */
+
 int mqtt_publish_qos1_ack(struct mqtt_client *client,
 			  const struct mqtt_puback_param *param)
 {
@@ -494,7 +600,7 @@ int mqtt_subscribe(struct mqtt_client *client,
 		goto error;
 	}
 
-	err_code = subscribe_encode(param, &packet);
+	err_code = subscribe_encode(client, param, &packet);
 	if (err_code < 0) {
 		goto error;
 	}
@@ -528,7 +634,7 @@ int mqtt_unsubscribe(struct mqtt_client *client,
 		goto error;
 	}
 
-	err_code = unsubscribe_encode(param, &packet);
+	err_code = unsubscribe_encode(client, param, &packet);
 	if (err_code < 0) {
 		goto error;
 	}
@@ -601,6 +707,14 @@ int mqtt_live(struct mqtt_client *client)
 
 	mqtt_mutex_lock(client);
 
+#if defined(CONFIG_MQTT_TX_QUEUE)
+	err_code = client_flush(client);
+	if (err_code < 0) {
+		mqtt_mutex_unlock(client);
+		return err_code;
+	}
+#endif
+
 	elapsed_time = mqtt_elapsed_time_in_ms_get(
 				client->internal.last_activity);
 	if ((client->keepalive > 0) &&
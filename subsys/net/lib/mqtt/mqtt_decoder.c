@@ -69,6 +69,37 @@ static int unpack_uint16(struct buf_ctx *buf, uint16_t *val)
 	return 0;
 }
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/**
+ * @brief Unpacks unsigned 32 bit value from the buffer from the offset
+ *        requested.
+ *
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ * @param[out] val Memory where the value is to be unpacked.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if the buffer would be exceeded during the read
+ */
+static int unpack_uint32(struct buf_ctx *buf, uint32_t *val)
+{
+	MQTT_TRC(">> cur:%p, end:%p", buf->cur, buf->end);
+
+	if ((buf->end - buf->cur) < sizeof(uint32_t)) {
+		return -EINVAL;
+	}
+
+	*val = *(buf->cur++) << 24;
+	*val |= *(buf->cur++) << 16;
+	*val |= *(buf->cur++) << 8;
+	*val |= *(buf->cur++);
+
+	MQTT_TRC("<< val:%08x", *val);
+
+	return 0;
+}
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
 /**
  * @brief Unpacks utf8 string from the buffer from the offset requested.
  *
@@ -188,6 +219,237 @@ static int packet_length_decode(struct buf_ctx *buf, uint32_t *length)
 	return 0;
 }
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/**
+ * @brief Unpacks a variable byte integer, encoded like the remaining length.
+ *
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ * @param[out] val Memory where the value is to be unpacked.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if the value is malformed or the buffer would be exceeded
+ *                 during the read.
+ */
+static int unpack_variable_int(struct buf_ctx *buf, uint32_t *val)
+{
+	int err_code;
+
+	err_code = packet_length_decode(buf, val);
+
+	return (err_code == -EAGAIN) ? -EINVAL : err_code;
+}
+
+static int user_property_decode(struct buf_ctx *buf, struct mqtt_prop *prop)
+{
+	struct mqtt_utf8_pair pair;
+	int err_code;
+
+	err_code = unpack_utf8_str(buf, &pair.name);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = unpack_utf8_str(buf, &pair.value);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if (prop->user_prop_count < CONFIG_MQTT_USER_PROP_MAX) {
+		prop->user_prop[prop->user_prop_count++] = pair;
+	} else {
+		MQTT_TRC("User property dropped");
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Decodes MQTT 5.0 properties, preceded by their length.
+ *
+ * @note The properties are not cleared first, so that the caller can set
+ *       the default values of absent properties. Properties not kept in
+ *       @ref mqtt_prop are skipped.
+ *
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ * @param[out] prop Decoded properties.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if the properties are malformed.
+ */
+static int properties_decode(struct buf_ctx *buf, struct mqtt_prop *prop)
+{
+	struct buf_ctx prop_buf;
+	struct mqtt_binstr bin;
+	struct mqtt_utf8 str;
+	uint32_t length;
+	uint32_t val32;
+	uint16_t val16;
+	uint8_t val8;
+	uint8_t id;
+	int err_code;
+
+	err_code = unpack_variable_int(buf, &length);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	if ((buf->end - buf->cur) < length) {
+		return -EINVAL;
+	}
+
+	prop_buf.cur = buf->cur;
+	prop_buf.end = buf->cur + length;
+	buf->cur += length;
+
+	while (prop_buf.cur < prop_buf.end) {
+		(void)unpack_uint8(&prop_buf, &id);
+
+		switch (id) {
+		case MQTT_PROP_PAYLOAD_FORMAT_INDICATOR:
+			err_code = unpack_uint8(&prop_buf,
+						&prop->payload_format_indicator);
+			break;
+		case MQTT_PROP_MAXIMUM_QOS:
+			err_code = unpack_uint8(&prop_buf, &prop->maximum_qos);
+			break;
+		case MQTT_PROP_RETAIN_AVAILABLE:
+			err_code = unpack_uint8(&prop_buf,
+						&prop->retain_available);
+			break;
+		case MQTT_PROP_REQUEST_PROBLEM_INFORMATION:
+		case MQTT_PROP_REQUEST_RESPONSE_INFORMATION:
+		case MQTT_PROP_WILDCARD_SUBSCRIPTION_AVAILABLE:
+		case MQTT_PROP_SUBSCRIPTION_IDENTIFIER_AVAILABLE:
+		case MQTT_PROP_SHARED_SUBSCRIPTION_AVAILABLE:
+			err_code = unpack_uint8(&prop_buf, &val8);
+			break;
+		case MQTT_PROP_SERVER_KEEP_ALIVE:
+			err_code = unpack_uint16(&prop_buf,
+						 &prop->server_keep_alive);
+			break;
+		case MQTT_PROP_RECEIVE_MAXIMUM:
+			err_code = unpack_uint16(&prop_buf,
+						 &prop->receive_maximum);
+			break;
+		case MQTT_PROP_TOPIC_ALIAS_MAXIMUM:
+			err_code = unpack_uint16(&prop_buf,
+						 &prop->topic_alias_maximum);
+			break;
+		case MQTT_PROP_TOPIC_ALIAS:
+			err_code = unpack_uint16(&prop_buf, &prop->topic_alias);
+			break;
+		case MQTT_PROP_MESSAGE_EXPIRY_INTERVAL:
+			err_code = unpack_uint32(&prop_buf,
+						 &prop->message_expiry_interval);
+			break;
+		case MQTT_PROP_SESSION_EXPIRY_INTERVAL:
+			err_code = unpack_uint32(&prop_buf,
+						 &prop->session_expiry_interval);
+			break;
+		case MQTT_PROP_MAXIMUM_PACKET_SIZE:
+			err_code = unpack_uint32(&prop_buf,
+						 &prop->maximum_packet_size);
+			break;
+		case MQTT_PROP_WILL_DELAY_INTERVAL:
+			err_code = unpack_uint32(&prop_buf, &val32);
+			break;
+		case MQTT_PROP_SUBSCRIPTION_IDENTIFIER:
+			err_code = unpack_variable_int(
+					&prop_buf, &prop->subscription_identifier);
+			break;
+		case MQTT_PROP_CONTENT_TYPE:
+			err_code = unpack_utf8_str(&prop_buf,
+						   &prop->content_type);
+			break;
+		case MQTT_PROP_RESPONSE_TOPIC:
+			err_code = unpack_utf8_str(&prop_buf,
+						   &prop->response_topic);
+			break;
+		case MQTT_PROP_ASSIGNED_CLIENT_IDENTIFIER:
+			err_code = unpack_utf8_str(&prop_buf,
+						   &prop->assigned_client_id);
+			break;
+		case MQTT_PROP_REASON_STRING:
+			err_code = unpack_utf8_str(&prop_buf,
+						   &prop->reason_string);
+			break;
+		case MQTT_PROP_AUTHENTICATION_METHOD:
+		case MQTT_PROP_RESPONSE_INFORMATION:
+		case MQTT_PROP_SERVER_REFERENCE:
+			err_code = unpack_utf8_str(&prop_buf, &str);
+			break;
+		case MQTT_PROP_CORRELATION_DATA:
+			err_code = unpack_uint16(&prop_buf, &val16);
+			if (err_code == 0) {
+				err_code = unpack_data(val16, &prop_buf,
+						       &prop->correlation_data);
+			}
+			break;
+		case MQTT_PROP_AUTHENTICATION_DATA:
+			err_code = unpack_uint16(&prop_buf, &val16);
+			if (err_code == 0) {
+				err_code = unpack_data(val16, &prop_buf, &bin);
+			}
+			break;
+		case MQTT_PROP_USER_PROPERTY:
+			err_code = user_property_decode(&prop_buf, prop);
+			break;
+		default:
+			MQTT_ERR("Unknown property 0x%02x", id);
+			err_code = -EINVAL;
+			break;
+		}
+
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Decodes the optional reason code and properties following the
+ *        message id of MQTT 5.0 acknowledgments. Both are absent from the
+ *        short form, which is also the MQTT 3.1.1 one.
+ *
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ * @param[out] reason_code Decoded reason code.
+ * @param[out] prop Decoded properties.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -EINVAL if the packet is malformed.
+ */
+static int ack_reason_decode(struct buf_ctx *buf, uint8_t *reason_code,
+			     struct mqtt_prop *prop)
+{
+	int err_code;
+
+	*reason_code = MQTT_RC_SUCCESS;
+	(void)memset(prop, 0, sizeof(*prop));
+
+	if (buf->cur == buf->end) {
+		return 0;
+	}
+
+	err_code = unpack_uint8(buf, reason_code);
+	if (err_code != 0 || buf->cur == buf->end) {
+		return err_code;
+	}
+
+	return properties_decode(buf, prop);
+}
+
+int disconnect_decode(struct buf_ctx *buf, uint8_t *reason_code,
+		      struct mqtt_prop *prop)
+{
+	return ack_reason_decode(buf, reason_code, prop);
+}
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
 int fixed_header_decode(struct buf_ctx *buf, uint8_t *type_and_flags,
 			uint32_t *length)
 {
@@ -217,7 +479,7 @@ int connect_ack_decode(const struct mqtt_client *client, struct buf_ctx *buf,
 		return err_code;
 	}
 
-	if (client->protocol_version == MQTT_VERSION_3_1_1) {
+	if (client->protocol_version >= MQTT_VERSION_3_1_1) {
 		param->session_present_flag =
 			flags & MQTT_CONNACK_FLAG_SESSION_PRESENT;
 
@@ -227,10 +489,23 @@ int connect_ack_decode(const struct mqtt_client *client, struct buf_ctx *buf,
 
 	param->return_code = (enum mqtt_conn_return_code)ret_code;
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		(void)memset(&param->prop, 0, sizeof(param->prop));
+
+		/* Defaults of the properties that have one. */
+		param->prop.maximum_qos = MQTT_QOS_2_EXACTLY_ONCE;
+		param->prop.retain_available = 1U;
+
+		return properties_decode(buf, &param->prop);
+	}
+#endif
+
 	return 0;
 }
 
-int publish_decode(uint8_t flags, uint32_t var_length, struct buf_ctx *buf,
+int publish_decode(const struct mqtt_client *client, uint8_t flags,
+		   uint32_t var_length, struct buf_ctx *buf,
 		   struct mqtt_publish_param *param)
 {
 	int err_code;
@@ -256,6 +531,21 @@ int publish_decode(uint8_t flags, uint32_t var_length, struct buf_ctx *buf,
 		var_header_length += sizeof(uint16_t);
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		uint8_t *prop_start = buf->cur;
+
+		(void)memset(&param->prop, 0, sizeof(param->prop));
+
+		err_code = properties_decode(buf, &param->prop);
+		if (err_code != 0) {
+			return err_code;
+		}
+
+		var_header_length += buf->cur - prop_start;
+	}
+#endif
+
 	if (var_length < var_header_length) {
 		MQTT_ERR("Corrupted PUBLISH message, header length (%u) larger "
 			 "than total length (%u)", var_header_length,
@@ -271,26 +561,71 @@ int publish_decode(uint8_t flags, uint32_t var_length, struct buf_ctx *buf,
 
 int publish_ack_decode(struct buf_ctx *buf, struct mqtt_puback_param *param)
 {
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	int err_code;
+
+	err_code = unpack_uint16(buf, &param->message_id);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return ack_reason_decode(buf, &param->reason_code, &param->prop);
+#else
 	return unpack_uint16(buf, &param->message_id);
+#endif
 }
 
 int publish_receive_decode(struct buf_ctx *buf, struct mqtt_pubrec_param *param)
 {
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	int err_code;
+
+	err_code = unpack_uint16(buf, &param->message_id);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return ack_reason_decode(buf, &param->reason_code, &param->prop);
+#else
 	return unpack_uint16(buf, &param->message_id);
+#endif
 }
 
 int publish_release_decode(struct buf_ctx *buf, struct mqtt_pubrel_param *param)
 {
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	int err_code;
+
+	err_code = unpack_uint16(buf, &param->message_id);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return ack_reason_decode(buf, &param->reason_code, &param->prop);
+#else
 	return unpack_uint16(buf, &param->message_id);
+#endif
 }
 
 int publish_complete_decode(struct buf_ctx *buf,
 			    struct mqtt_pubcomp_param *param)
 {
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	int err_code;
+
+	err_code = unpack_uint16(buf, &param->message_id);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return ack_reason_decode(buf, &param->reason_code, &param->prop);
+#else
 	return unpack_uint16(buf, &param->message_id);
+#endif
 }
 
-int subscribe_ack_decode(struct buf_ctx *buf, struct mqtt_suback_param *param)
+int subscribe_ack_decode(const struct mqtt_client *client,
+			 struct buf_ctx *buf, struct mqtt_suback_param *param)
 {
 	int err_code;
 
@@ -299,11 +634,41 @@ int subscribe_ack_decode(struct buf_ctx *buf, struct mqtt_suback_param *param)
 		return err_code;
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		(void)memset(&param->prop, 0, sizeof(param->prop));
+
+		err_code = properties_decode(buf, &param->prop);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+#endif
+
 	return unpack_data(buf->end - buf->cur, buf, &param->return_codes);
 }
 
-int unsubscribe_ack_decode(struct buf_ctx *buf,
+int unsubscribe_ack_decode(const struct mqtt_client *client,
+			   struct buf_ctx *buf,
 			   struct mqtt_unsuback_param *param)
 {
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	int err_code;
+
+	err_code = unpack_uint16(buf, &param->message_id);
+	if (err_code != 0 || !MQTT_IS_VERSION_5_0(client)) {
+		return err_code;
+	}
+
+	(void)memset(&param->prop, 0, sizeof(param->prop));
+
+	err_code = properties_decode(buf, &param->prop);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return unpack_data(buf->end - buf->cur, buf, &param->reason_codes);
+#else
 	return unpack_uint16(buf, &param->message_id);
+#endif
 }
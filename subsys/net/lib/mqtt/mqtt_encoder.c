@@ -82,6 +82,35 @@ static int pack_uint16(uint16_t val, struct buf_ctx *buf)
 	return 0;
 }
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/**
+ * @brief Packs unsigned 32 bit value to the buffer at the offset requested.
+ *
+ * @param[in] val Value to be packed.
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -ENOMEM if there is no place in the buffer to store the value.
+ */
+static int pack_uint32(uint32_t val, struct buf_ctx *buf)
+{
+	if ((buf->end - buf->cur) < sizeof(uint32_t)) {
+		return -ENOMEM;
+	}
+
+	MQTT_TRC(">> val:%08x cur:%p, end:%p", val, buf->cur, buf->end);
+
+	/* Pack value. */
+	*(buf->cur++) = (val >> 24) & 0xFF;
+	*(buf->cur++) = (val >> 16) & 0xFF;
+	*(buf->cur++) = (val >> 8) & 0xFF;
+	*(buf->cur++) = val & 0xFF;
+
+	return 0;
+}
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
 /**
  * @brief Packs utf8 string to the buffer at the offset requested.
  *
@@ -162,6 +191,319 @@ static uint8_t packet_length_encode(uint32_t length, struct buf_ctx *buf)
 	return encoded_bytes;
 }
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/**
+ * @brief Packs binary data to the buffer at the offset requested, preceded
+ *        by its length.
+ *
+ * @param[in] str Binary data and its length to be packed.
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -ENOMEM if there is no place in the buffer to store the data.
+ */
+static int pack_binstr(const struct mqtt_binstr *str, struct buf_ctx *buf)
+{
+	if (str->len > UINT16_MAX) {
+		return -EINVAL;
+	}
+
+	if ((buf->end - buf->cur) < sizeof(uint16_t) + str->len) {
+		return -ENOMEM;
+	}
+
+	MQTT_TRC(">> bin_size:%08x cur:%p, end:%p", str->len, buf->cur,
+		 buf->end);
+
+	(void)pack_uint16(str->len, buf);
+
+	memcpy(buf->cur, str->data, str->len);
+	buf->cur += str->len;
+
+	return 0;
+}
+
+/**
+ * @brief Packs a variable byte integer, encoded like the remaining length.
+ *
+ * @param[in] val Value to be packed.
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -ENOMEM if there is no place in the buffer to store the value.
+ */
+static int pack_variable_int(uint32_t val, struct buf_ctx *buf)
+{
+	if (val > MQTT_MAX_PAYLOAD_SIZE) {
+		return -EINVAL;
+	}
+
+	if ((buf->end - buf->cur) < packet_length_encode(val, NULL)) {
+		return -ENOMEM;
+	}
+
+	(void)packet_length_encode(val, buf);
+
+	return 0;
+}
+
+/* Properties with a zero value or an empty string are absent, and not
+ * packed.
+ */
+static int pack_prop_uint8(uint8_t id, uint8_t val, struct buf_ctx *buf)
+{
+	int err_code;
+
+	if (val == 0U) {
+		return 0;
+	}
+
+	err_code = pack_uint8(id, buf);
+
+	return err_code ? err_code : pack_uint8(val, buf);
+}
+
+static int pack_prop_uint16(uint8_t id, uint16_t val, struct buf_ctx *buf)
+{
+	int err_code;
+
+	if (val == 0U) {
+		return 0;
+	}
+
+	err_code = pack_uint8(id, buf);
+
+	return err_code ? err_code : pack_uint16(val, buf);
+}
+
+static int pack_prop_uint32(uint8_t id, uint32_t val, struct buf_ctx *buf)
+{
+	int err_code;
+
+	if (val == 0U) {
+		return 0;
+	}
+
+	err_code = pack_uint8(id, buf);
+
+	return err_code ? err_code : pack_uint32(val, buf);
+}
+
+static int pack_prop_variable_int(uint8_t id, uint32_t val,
+				  struct buf_ctx *buf)
+{
+	int err_code;
+
+	if (val == 0U) {
+		return 0;
+	}
+
+	err_code = pack_uint8(id, buf);
+
+	return err_code ? err_code : pack_variable_int(val, buf);
+}
+
+static int pack_prop_utf8(uint8_t id, const struct mqtt_utf8 *str,
+			  struct buf_ctx *buf)
+{
+	int err_code;
+
+	if (str->size == 0U) {
+		return 0;
+	}
+
+	err_code = pack_uint8(id, buf);
+
+	return err_code ? err_code : pack_utf8_str(str, buf);
+}
+
+static int pack_prop_binstr(uint8_t id, const struct mqtt_binstr *str,
+			    struct buf_ctx *buf)
+{
+	int err_code;
+
+	if (str->len == 0U) {
+		return 0;
+	}
+
+	err_code = pack_uint8(id, buf);
+
+	return err_code ? err_code : pack_binstr(str, buf);
+}
+
+static int connect_properties_encode(const struct mqtt_prop *prop,
+				     struct buf_ctx *buf)
+{
+	int err_code;
+
+	err_code = pack_prop_uint32(MQTT_PROP_SESSION_EXPIRY_INTERVAL,
+				    prop->session_expiry_interval, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = pack_prop_uint16(MQTT_PROP_RECEIVE_MAXIMUM,
+				    prop->receive_maximum, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = pack_prop_uint32(MQTT_PROP_MAXIMUM_PACKET_SIZE,
+				    prop->maximum_packet_size, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	/* The aliases the server can use are the ones the client has room
+	 * for, whatever the application set.
+	 */
+	return pack_prop_uint16(MQTT_PROP_TOPIC_ALIAS_MAXIMUM,
+				CONFIG_MQTT_TOPIC_ALIAS_MAX, buf);
+}
+
+static int publish_properties_encode(const struct mqtt_prop *prop,
+				     struct buf_ctx *buf)
+{
+	int err_code;
+
+	err_code = pack_prop_uint8(MQTT_PROP_PAYLOAD_FORMAT_INDICATOR,
+				   prop->payload_format_indicator, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = pack_prop_uint32(MQTT_PROP_MESSAGE_EXPIRY_INTERVAL,
+				    prop->message_expiry_interval, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = pack_prop_uint16(MQTT_PROP_TOPIC_ALIAS,
+				    prop->topic_alias, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = pack_prop_utf8(MQTT_PROP_RESPONSE_TOPIC,
+				  &prop->response_topic, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = pack_prop_binstr(MQTT_PROP_CORRELATION_DATA,
+				    &prop->correlation_data, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return pack_prop_utf8(MQTT_PROP_CONTENT_TYPE, &prop->content_type,
+			      buf);
+}
+
+static int user_properties_encode(const struct mqtt_prop *prop,
+				  struct buf_ctx *buf)
+{
+	int err_code;
+	int i;
+
+	for (i = 0; i < MIN(prop->user_prop_count, CONFIG_MQTT_USER_PROP_MAX);
+	     i++) {
+		err_code = pack_uint8(MQTT_PROP_USER_PROPERTY, buf);
+		if (err_code != 0) {
+			return err_code;
+		}
+
+		err_code = pack_utf8_str(&prop->user_prop[i].name, buf);
+		if (err_code != 0) {
+			return err_code;
+		}
+
+		err_code = pack_utf8_str(&prop->user_prop[i].value, buf);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Encodes the MQTT 5.0 properties allowed in a packet, preceded by
+ *        their length.
+ *
+ * @param[in] packet_type Type of the packet the properties belong to.
+ * @param[in] prop Properties to encode.
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ *
+ * @retval 0 if the procedure is successful.
+ * @retval -ENOMEM if there is no place in the buffer to store the
+ *                 properties.
+ */
+static int properties_encode(uint8_t packet_type, const struct mqtt_prop *prop,
+			     struct buf_ctx *buf)
+{
+	uint8_t *start = buf->cur;
+	uint8_t length_bytes;
+	uint32_t length;
+	int err_code;
+
+	/* Reserve room for the longest property length, the properties are
+	 * moved once their length is known.
+	 */
+	if ((buf->end - buf->cur) < MQTT_MAX_LENGTH_BYTES) {
+		return -ENOMEM;
+	}
+
+	buf->cur += MQTT_MAX_LENGTH_BYTES;
+
+	switch (packet_type) {
+	case MQTT_PKT_TYPE_CONNECT:
+		err_code = connect_properties_encode(prop, buf);
+		break;
+	case MQTT_PKT_TYPE_PUBLISH:
+		err_code = publish_properties_encode(prop, buf);
+		break;
+	case MQTT_PKT_TYPE_PUBACK:
+	case MQTT_PKT_TYPE_PUBREC:
+	case MQTT_PKT_TYPE_PUBREL:
+	case MQTT_PKT_TYPE_PUBCOMP:
+		err_code = pack_prop_utf8(MQTT_PROP_REASON_STRING,
+					  &prop->reason_string, buf);
+		break;
+	case MQTT_PKT_TYPE_SUBSCRIBE:
+		err_code = pack_prop_variable_int(
+				MQTT_PROP_SUBSCRIPTION_IDENTIFIER,
+				prop->subscription_identifier, buf);
+		break;
+	default:
+		err_code = 0;
+		break;
+	}
+
+	if (err_code == 0) {
+		err_code = user_properties_encode(prop, buf);
+	}
+
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	length = buf->cur - start - MQTT_MAX_LENGTH_BYTES;
+	length_bytes = packet_length_encode(length, NULL);
+
+	memmove(start + length_bytes, start + MQTT_MAX_LENGTH_BYTES, length);
+
+	buf->cur = start;
+	(void)packet_length_encode(length, buf);
+	buf->cur += length;
+
+	return 0;
+}
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
 /**
  * @brief Encodes fixed header for the MQTT message and provides pointer to
  *        start of the header.
@@ -266,6 +608,62 @@ static int mqtt_message_id_only_enc(uint8_t message_type, uint16_t message_id,
 	return mqtt_encode_fixed_header(message_type, start, buf);
 }
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/**
+ * @brief Encodes MQTT 5.0 acknowledgments, with a reason code and properties
+ *        if they are not the default ones.
+ *
+ * @param[in] message_type Message type and reserved bit fields.
+ * @param[in] message_id Message id to be encoded in the variable header.
+ * @param[in] reason_code Reason code of the acknowledgment.
+ * @param[in] prop Properties of the acknowledgment.
+ * @param[inout] buf_ctx Pointer to the buffer context structure,
+ *                       containing buffer for the encoded message.
+ *
+ * @retval 0 or an error code indicating a reason for failure.
+ */
+static int mqtt_ack_enc(uint8_t message_type, uint16_t message_id,
+			uint8_t reason_code, const struct mqtt_prop *prop,
+			struct buf_ctx *buf)
+{
+	int err_code;
+	uint8_t *start;
+
+	/* The short form, which is also the MQTT 3.1.1 one, stands for a
+	 * success without properties.
+	 */
+	if (reason_code == MQTT_RC_SUCCESS && prop->reason_string.size == 0U &&
+	    prop->user_prop_count == 0U) {
+		return mqtt_message_id_only_enc(message_type, message_id, buf);
+	}
+
+	if (message_id == 0U) {
+		return -EINVAL;
+	}
+
+	/* Reserve space for fixed header. */
+	buf->cur += MQTT_FIXED_HEADER_MAX_SIZE;
+	start = buf->cur;
+
+	err_code = pack_uint16(message_id, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = pack_uint8(reason_code, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	err_code = properties_encode(message_type & 0xF0, prop, buf);
+	if (err_code != 0) {
+		return err_code;
+	}
+
+	return mqtt_encode_fixed_header(message_type, start, buf);
+}
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
 int connect_request_encode(const struct mqtt_client *client,
 			   struct buf_ctx *buf)
 {
@@ -277,7 +675,8 @@ int connect_request_encode(const struct mqtt_client *client,
 	int err_code;
 	uint8_t *start;
 
-	if (client->protocol_version == MQTT_VERSION_3_1_1) {
+	if (client->protocol_version >= MQTT_VERSION_3_1_1) {
+		/* MQTT 5.0 keeps the protocol name of 3.1.1. */
 		mqtt_proto_desc = &mqtt_3_1_1_proto_desc;
 	} else {
 		mqtt_proto_desc = &mqtt_3_1_0_proto_desc;
@@ -317,6 +716,16 @@ int connect_request_encode(const struct mqtt_client *client,
 		return err_code;
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		err_code = properties_encode(MQTT_PKT_TYPE_CONNECT,
+					     &client->prop, buf);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+#endif
+
 	MQTT_TRC("Encoding Client Id. Str:%s Size:%08x.",
 		 client->client_id.utf8, client->client_id.size);
 	err_code = pack_utf8_str(&client->client_id, buf);
@@ -331,6 +740,16 @@ int connect_request_encode(const struct mqtt_client *client,
 		connect_flags |= ((client->will_topic->qos & 0x03) << 3);
 		connect_flags |= client->will_retain << 5;
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+		if (MQTT_IS_VERSION_5_0(client)) {
+			/* No will properties. */
+			err_code = pack_uint8(0, buf);
+			if (err_code != 0) {
+				return err_code;
+			}
+		}
+#endif
+
 		MQTT_TRC("Encoding Will Topic. Str:%s Size:%08x.",
 			 client->will_topic->topic.utf8,
 			 client->will_topic->topic.size);
@@ -386,7 +805,8 @@ int connect_request_encode(const struct mqtt_client *client,
 	return mqtt_encode_fixed_header(message_type, start, buf);
 }
 
-int publish_encode(const struct mqtt_publish_param *param, struct buf_ctx *buf)
+int publish_encode(const struct mqtt_client *client,
+		   const struct mqtt_publish_param *param, struct buf_ctx *buf)
 {
 	const uint8_t message_type = MQTT_MESSAGES_OPTIONS(
 			MQTT_PKT_TYPE_PUBLISH, param->dup_flag,
@@ -415,6 +835,16 @@ int publish_encode(const struct mqtt_publish_param *param, struct buf_ctx *buf)
 		}
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		err_code = properties_encode(MQTT_PKT_TYPE_PUBLISH,
+					     &param->prop, buf);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+#endif
+
 	/* Do not copy payload. We move the buffer pointer to ensure that
 	 * message length in fixed header is encoded correctly.
 	 */
@@ -436,7 +866,12 @@ int publish_ack_encode(const struct mqtt_puback_param *param,
 	const uint8_t message_type =
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBACK, 0, 0, 0);
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	return mqtt_ack_enc(message_type, param->message_id, param->reason_code,
+			    &param->prop, buf);
+#else
 	return mqtt_message_id_only_enc(message_type, param->message_id, buf);
+#endif
 }
 
 int publish_receive_encode(const struct mqtt_pubrec_param *param,
@@ -445,7 +880,12 @@ int publish_receive_encode(const struct mqtt_pubrec_param *param,
 	const uint8_t message_type =
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBREC, 0, 0, 0);
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	return mqtt_ack_enc(message_type, param->message_id, param->reason_code,
+			    &param->prop, buf);
+#else
 	return mqtt_message_id_only_enc(message_type, param->message_id, buf);
+#endif
 }
 
 int publish_release_encode(const struct mqtt_pubrel_param *param,
@@ -454,7 +894,12 @@ int publish_release_encode(const struct mqtt_pubrel_param *param,
 	const uint8_t message_type =
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBREL, 0, 1, 0);
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	return mqtt_ack_enc(message_type, param->message_id, param->reason_code,
+			    &param->prop, buf);
+#else
 	return mqtt_message_id_only_enc(message_type, param->message_id, buf);
+#endif
 }
 
 int publish_complete_encode(const struct mqtt_pubcomp_param *param,
@@ -463,7 +908,12 @@ int publish_complete_encode(const struct mqtt_pubcomp_param *param,
 	const uint8_t message_type =
 		MQTT_MESSAGES_OPTIONS(MQTT_PKT_TYPE_PUBCOMP, 0, 0, 0);
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	return mqtt_ack_enc(message_type, param->message_id, param->reason_code,
+			    &param->prop, buf);
+#else
 	return mqtt_message_id_only_enc(message_type, param->message_id, buf);
+#endif
 }
 
 int disconnect_encode(struct buf_ctx *buf)
@@ -478,7 +928,8 @@ int disconnect_encode(struct buf_ctx *buf)
 	return 0;
 }
 
-int subscribe_encode(const struct mqtt_subscription_list *param,
+int subscribe_encode(const struct mqtt_client *client,
+		     const struct mqtt_subscription_list *param,
 		     struct buf_ctx *buf)
 {
 	const uint8_t message_type = MQTT_MESSAGES_OPTIONS(
@@ -500,6 +951,16 @@ int subscribe_encode(const struct mqtt_subscription_list *param,
 		return err_code;
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		err_code = properties_encode(MQTT_PKT_TYPE_SUBSCRIBE,
+					     &param->prop, buf);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+#endif
+
 	for (i = 0; i < param->list_count; i++) {
 		err_code = pack_utf8_str(&param->list[i].topic, buf);
 		if (err_code != 0) {
@@ -515,7 +976,8 @@ int subscribe_encode(const struct mqtt_subscription_list *param,
 	return mqtt_encode_fixed_header(message_type, start, buf);
 }
 
-int unsubscribe_encode(const struct mqtt_subscription_list *param,
+int unsubscribe_encode(const struct mqtt_client *client,
+		       const struct mqtt_subscription_list *param,
 		       struct buf_ctx *buf)
 {
 	const uint8_t message_type = MQTT_MESSAGES_OPTIONS(
@@ -532,6 +994,16 @@ int unsubscribe_encode(const struct mqtt_subscription_list *param,
 		return err_code;
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		err_code = properties_encode(MQTT_PKT_TYPE_UNSUBSCRIBE,
+					     &param->prop, buf);
+		if (err_code != 0) {
+			return err_code;
+		}
+	}
+#endif
+
 	for (i = 0; i < param->list_count; i++) {
 		err_code = pack_utf8_str(&param->list[i].topic, buf);
 		if (err_code != 0) {
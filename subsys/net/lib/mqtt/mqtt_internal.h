@@ -69,6 +69,38 @@ extern "C" {
 
 #define MQTT_CONNACK_FLAG_SESSION_PRESENT 0x01
 
+/**@brief MQTT 5.0 property identifiers. */
+#define MQTT_PROP_PAYLOAD_FORMAT_INDICATOR          0x01
+#define MQTT_PROP_MESSAGE_EXPIRY_INTERVAL           0x02
+#define MQTT_PROP_CONTENT_TYPE                      0x03
+#define MQTT_PROP_RESPONSE_TOPIC                    0x08
+#define MQTT_PROP_CORRELATION_DATA                  0x09
+#define MQTT_PROP_SUBSCRIPTION_IDENTIFIER           0x0B
+#define MQTT_PROP_SESSION_EXPIRY_INTERVAL           0x11
+#define MQTT_PROP_ASSIGNED_CLIENT_IDENTIFIER        0x12
+#define MQTT_PROP_SERVER_KEEP_ALIVE                 0x13
+#define MQTT_PROP_AUTHENTICATION_METHOD             0x15
+#define MQTT_PROP_AUTHENTICATION_DATA               0x16
+#define MQTT_PROP_REQUEST_PROBLEM_INFORMATION       0x17
+#define MQTT_PROP_WILL_DELAY_INTERVAL               0x18
+#define MQTT_PROP_REQUEST_RESPONSE_INFORMATION      0x19
+#define MQTT_PROP_RESPONSE_INFORMATION              0x1A
+#define MQTT_PROP_SERVER_REFERENCE                  0x1C
+#define MQTT_PROP_REASON_STRING                     0x1F
+#define MQTT_PROP_RECEIVE_MAXIMUM                   0x21
+#define MQTT_PROP_TOPIC_ALIAS_MAXIMUM               0x22
+#define MQTT_PROP_TOPIC_ALIAS                       0x23
+#define MQTT_PROP_MAXIMUM_QOS                       0x24
+#define MQTT_PROP_RETAIN_AVAILABLE                  0x25
+#define MQTT_PROP_USER_PROPERTY                     0x26
+#define MQTT_PROP_MAXIMUM_PACKET_SIZE               0x27
+#define MQTT_PROP_WILDCARD_SUBSCRIPTION_AVAILABLE   0x28
+#define MQTT_PROP_SUBSCRIPTION_IDENTIFIER_AVAILABLE 0x29
+#define MQTT_PROP_SHARED_SUBSCRIPTION_AVAILABLE     0x2A
+
+/**@brief Reason codes from this one on indicate a failure. */
+#define MQTT_REASON_FAILURE 0x80
+
 /**@brief Maximum payload size of MQTT packet. */
 #define MQTT_MAX_PAYLOAD_SIZE 0x0FFFFFFF
 
@@ -181,6 +213,7 @@ int connect_request_encode(const struct mqtt_client *client,
 
 /**@brief Constructs/encodes Publish packet.
  *
+ * @param[in] client Identifies the client for which the procedure is requested.
  * @param[in] param Publish message parameters.
  * @param[inout] buf_ctx Pointer to the buffer context structure,
  *                       containing buffer for the encoded message.
@@ -189,7 +222,8 @@ int connect_request_encode(const struct mqtt_client *client,
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int publish_encode(const struct mqtt_publish_param *param, struct buf_ctx *buf);
+int publish_encode(const struct mqtt_client *client,
+		   const struct mqtt_publish_param *param, struct buf_ctx *buf);
 
 /**@brief Constructs/encodes Publish Ack packet.
  *
@@ -256,6 +290,7 @@ int disconnect_encode(struct buf_ctx *buf);
 
 /**@brief Constructs/encodes Subscribe packet.
  *
+ * @param[in] client Identifies the client for which the procedure is requested.
  * @param[in] param Subscribe message parameters.
  * @param[inout] buf_ctx Pointer to the buffer context structure,
  *                       containing buffer for the encoded message.
@@ -264,11 +299,13 @@ int disconnect_encode(struct buf_ctx *buf);
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int subscribe_encode(const struct mqtt_subscription_list *param,
+int subscribe_encode(const struct mqtt_client *client,
+		     const struct mqtt_subscription_list *param,
 		     struct buf_ctx *buf);
 
 /**@brief Constructs/encodes Unsubscribe packet.
  *
+ * @param[in] client Identifies the client for which the procedure is requested.
  * @param[in] param Unsubscribe message parameters.
  * @param[inout] buf_ctx Pointer to the buffer context structure,
  *                       containing buffer for the encoded message.
@@ -277,7 +314,8 @@ int subscribe_encode(const struct mqtt_subscription_list *param,
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int unsubscribe_encode(const struct mqtt_subscription_list *param,
+int unsubscribe_encode(const struct mqtt_client *client,
+		       const struct mqtt_subscription_list *param,
 		       struct buf_ctx *buf);
 
 /**@brief Constructs/encodes Ping Request packet.
@@ -317,6 +355,7 @@ int connect_ack_decode(const struct mqtt_client *client, struct buf_ctx *buf,
 
 /**@brief Decode MQTT Publish packet.
  *
+ * @param[in] client MQTT client for which packet is decoded.
  * @param[in] flags Byte containing message type and flags.
  * @param[in] var_length Length of the variable part of the message.
  * @param[inout] buf A pointer to the buf_ctx structure containing current
@@ -325,7 +364,8 @@ int connect_ack_decode(const struct mqtt_client *client, struct buf_ctx *buf,
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int publish_decode(uint8_t flags, uint32_t var_length, struct buf_ctx *buf,
+int publish_decode(const struct mqtt_client *client, uint8_t flags,
+		   uint32_t var_length, struct buf_ctx *buf,
 		   struct mqtt_publish_param *param);
 
 /**@brief Decode MQTT Publish Ack packet.
@@ -373,26 +413,152 @@ int publish_complete_decode(struct buf_ctx *buf,
 
 /**@brief Decode MQTT Subscribe packet.
  *
+ * @param[in] client MQTT client for which packet is decoded.
  * @param[inout] buf A pointer to the buf_ctx structure containing current
  *                   buffer position.
  * @param[out] param Pointer to buffer for decoded Subscribe parameters.
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int subscribe_ack_decode(struct buf_ctx *buf,
+int subscribe_ack_decode(const struct mqtt_client *client,
+			 struct buf_ctx *buf,
 			 struct mqtt_suback_param *param);
 
 /**@brief Decode MQTT Unsubscribe packet.
  *
+ * @param[in] client MQTT client for which packet is decoded.
  * @param[inout] buf A pointer to the buf_ctx structure containing current
  *                   buffer position.
  * @param[out] param Pointer to buffer for decoded Unsubscribe parameters.
  *
  * @return 0 if the procedure is successful, an error code otherwise.
  */
-int unsubscribe_ack_decode(struct buf_ctx *buf,
+int unsubscribe_ack_decode(const struct mqtt_client *client,
+			   struct buf_ctx *buf,
 			   struct mqtt_unsuback_param *param);
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/**@brief Check if MQTT 5.0 is used by the client. */
+#define MQTT_IS_VERSION_5_0(CLIENT) \
+	((CLIENT)->protocol_version == MQTT_VERSION_5_0)
+
+/**@brief Decode the MQTT 5.0 DISCONNECT packet sent by the server.
+ *
+ * @param[inout] buf A pointer to the buf_ctx structure containing current
+ *                   buffer position.
+ * @param[out] reason_code Reason code of the disconnection.
+ * @param[out] prop Properties of the disconnection.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int disconnect_decode(struct buf_ctx *buf, uint8_t *reason_code,
+		      struct mqtt_prop *prop);
+
+/**@brief Forget the topic aliases of the previous connection.
+ *
+ * @param[in] client Client instance.
+ */
+void mqtt_topic_alias_reset(struct mqtt_client *client);
+
+/**@brief Replace the topic of a PUBLISH to be sent with a topic alias, or
+ *        bind the topic to an alias.
+ *
+ * @param[in] client Client instance.
+ * @param[inout] param Copy of the publish parameters to update.
+ */
+void mqtt_topic_alias_tx(struct mqtt_client *client,
+			 struct mqtt_publish_param *param);
+
+/**@brief Resolve or bind the topic alias of a received PUBLISH.
+ *
+ * @param[in] client Client instance.
+ * @param[inout] param Decoded publish parameters, whose topic is set from
+ *                     the alias if it is empty.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_topic_alias_rx(struct mqtt_client *client,
+			struct mqtt_publish_param *param);
+#else
+#define MQTT_IS_VERSION_5_0(CLIENT) false
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
+/**@brief Take one of the QoS 1 and 2 PUBLISH the server can receive, as
+ *        told by its MQTT 5.0 Receive Maximum.
+ *
+ * @param[in] client Client instance.
+ *
+ * @return true if the PUBLISH can be sent.
+ */
+static inline bool mqtt_send_quota_take(struct mqtt_client *client)
+{
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		if (client->internal.send_quota == 0U) {
+			return false;
+		}
+
+		client->internal.send_quota--;
+	}
+#endif
+
+	return true;
+}
+
+/**@brief Give back a PUBLISH to the send quota, once acknowledged.
+ *
+ * @param[in] client Client instance.
+ */
+static inline void mqtt_send_quota_give(struct mqtt_client *client)
+{
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (client->internal.send_quota < client->internal.receive_max) {
+		client->internal.send_quota++;
+	}
+#endif
+}
+
+#if defined(CONFIG_MQTT_TX_QUEUE)
+/**@brief Copy a PUBLISH message at the end of the outgoing queue.
+ *
+ * @param[in] client Client instance.
+ * @param[in] param Parameters of the message to queue.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_queue_publish(struct mqtt_client *client,
+		       const struct mqtt_publish_param *param);
+
+/**@brief Send the queued packets allowed by the in-flight window.
+ *
+ * @param[in] client Client instance, connected.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_queue_flush(struct mqtt_client *client);
+
+/**@brief Update a queued message on PUBACK, PUBREC or PUBCOMP reception,
+ *        and send what the in-flight window then allows.
+ *
+ * @param[in] client Client instance.
+ * @param[in] type Type of the received packet.
+ * @param[in] message_id Message identifier of the received packet.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_queue_ack(struct mqtt_client *client, uint8_t type,
+		   uint16_t message_id);
+
+/**@brief Send again the messages left unacknowledged on the previous
+ *        connection.
+ *
+ * @param[in] client Client instance, connected.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_queue_reconnected(struct mqtt_client *client);
+#endif /* CONFIG_MQTT_TX_QUEUE */
+
 #ifdef __cplusplus
 }
 #endif
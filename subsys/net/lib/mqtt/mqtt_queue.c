@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file mqtt_queue.c
+ *
+ * @brief MQTT outgoing message queue.
+ *
+ * Queued PUBLISH packets are kept encoded, with their payload, in the queue
+ * buffer given by the application, in the order they were queued. A
+ * QoS 1 or 2 message stays in the queue until the broker has acknowledged
+ * it, so that it can be sent again on reconnection.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_mqtt_queue, CONFIG_MQTT_LOG_LEVEL);
+
+#include <stdio.h>
+#include <settings/settings.h>
+
+#include "mqtt_internal.h"
+#include "mqtt_transport.h"
+#include "mqtt_os.h"
+
+/** State of a queued message. */
+enum mqtt_queue_state {
+	/** PUBLISH to be sent. */
+	MQTT_QUEUE_PENDING,
+
+	/** PUBLISH sent, waiting for PUBACK or PUBREC. */
+	MQTT_QUEUE_SENT,
+
+	/** PUBREC received, PUBREL to be sent. */
+	MQTT_QUEUE_RELEASE,
+
+	/** PUBREL sent, waiting for PUBCOMP. */
+	MQTT_QUEUE_RELEASED,
+
+	/** Message done with, to be removed from the queue. */
+	MQTT_QUEUE_DONE,
+};
+
+/** Queued message, followed by the encoded PUBLISH packet. */
+struct mqtt_queue_entry {
+	uint32_t len;
+	uint16_t message_id;
+	uint8_t qos;
+	uint8_t state;
+} __packed;
+
+#define PUBREL_BUF_SIZE (MQTT_FIXED_HEADER_MAX_SIZE + sizeof(uint16_t))
+
+#define ENTRY(client, offset) \
+	((struct mqtt_queue_entry *)&(client)->queue_buf[offset])
+
+#define ENTRY_SIZE(entry) (sizeof(struct mqtt_queue_entry) + (entry)->len)
+
+#define FOR_EACH_ENTRY(client, entry, offset)				 \
+	for (offset = 0U;						 \
+	     offset < (client)->internal.queue_len &&			 \
+	     (entry = ENTRY(client, offset), true);			 \
+	     offset += ENTRY_SIZE(entry))
+
+#if defined(CONFIG_MQTT_TX_QUEUE_PERSIST)
+#define QUEUE_SUBTREE "mqtt/q"
+
+static void entry_key(char *key, size_t len, uint16_t message_id)
+{
+	snprintk(key, len, QUEUE_SUBTREE "/%04x", message_id);
+}
+
+static void entry_store(struct mqtt_queue_entry *entry)
+{
+	char key[sizeof(QUEUE_SUBTREE "/0000")];
+	int err_code;
+
+	entry_key(key, sizeof(key), entry->message_id);
+
+	if (entry->state == MQTT_QUEUE_DONE) {
+		err_code = settings_delete(key);
+	} else {
+		err_code = settings_save_one(key, entry, ENTRY_SIZE(entry));
+	}
+
+	if (err_code < 0) {
+		MQTT_ERR("Cannot store message 0x%04x (%d)",
+			 entry->message_id, err_code);
+	}
+}
+#else
+#define entry_store(entry)
+#endif /* CONFIG_MQTT_TX_QUEUE_PERSIST */
+
+/** Set the state of a QoS 1 or 2 message, and store it if needed. */
+static void entry_set_state(struct mqtt_queue_entry *entry, uint8_t state)
+{
+	entry->state = state;
+
+	entry_store(entry);
+}
+
+/** Remove the messages done with from the queue. */
+static void queue_compact(struct mqtt_client *client)
+{
+	struct mqtt_queue_entry *entry;
+	uint32_t offset, len = 0U;
+
+	FOR_EACH_ENTRY(client, entry, offset) {
+		if (entry->state == MQTT_QUEUE_DONE) {
+			continue;
+		}
+
+		if (offset != len) {
+			memmove(&client->queue_buf[len], entry,
+				ENTRY_SIZE(entry));
+		}
+
+		len += ENTRY_SIZE(ENTRY(client, len));
+	}
+
+	client->internal.queue_len = len;
+}
+
+static int queue_write(struct mqtt_client *client, struct iovec *io_vector,
+		       size_t count)
+{
+	struct msghdr msg;
+	int err_code;
+
+	memset(&msg, 0, sizeof(msg));
+
+	msg.msg_iov = io_vector;
+	msg.msg_iovlen = count;
+
+	MQTT_TRC("[%p]: Writing %zu queued packets", client, count);
+
+	err_code = mqtt_transport_write_msg(client, &msg);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	client->internal.last_activity = mqtt_sys_tick_in_ms_get();
+
+	return 0;
+}
+
+int mqtt_queue_flush(struct mqtt_client *client)
+{
+	struct iovec io_vector[CONFIG_MQTT_TX_QUEUE_BATCH];
+	uint8_t pubrel[CONFIG_MQTT_TX_QUEUE_BATCH][PUBREL_BUF_SIZE];
+	struct mqtt_queue_entry *entry;
+	struct buf_ctx packet;
+	uint32_t offset;
+	int inflight = 0;
+	size_t count = 0;
+	int err_code = 0;
+
+	if (!MQTT_HAS_STATE(client, MQTT_STATE_CONNECTED)) {
+		return 0;
+	}
+
+	FOR_EACH_ENTRY(client, entry, offset) {
+		if (entry->state != MQTT_QUEUE_PENDING &&
+		    entry->state != MQTT_QUEUE_DONE) {
+			inflight++;
+		}
+	}
+
+	FOR_EACH_ENTRY(client, entry, offset) {
+		if (entry->state == MQTT_QUEUE_PENDING) {
+			/* Later messages wait too, to keep the order */
+			if (entry->qos > MQTT_QOS_0_AT_MOST_ONCE &&
+			    (inflight >= CONFIG_MQTT_TX_QUEUE_INFLIGHT ||
+			     !mqtt_send_quota_take(client))) {
+				break;
+			}
+
+			io_vector[count].iov_base = entry + 1;
+			io_vector[count].iov_len = entry->len;
+
+			if (entry->qos > MQTT_QOS_0_AT_MOST_ONCE) {
+				entry_set_state(entry, MQTT_QUEUE_SENT);
+				inflight++;
+			} else {
+				entry->state = MQTT_QUEUE_DONE;
+			}
+		} else if (entry->state == MQTT_QUEUE_RELEASE) {
+			struct mqtt_pubrel_param param = {
+				.message_id = entry->message_id,
+			};
+
+			packet.cur = pubrel[count];
+			packet.end = pubrel[count] + PUBREL_BUF_SIZE;
+
+			(void)publish_release_encode(&param, &packet);
+
+			io_vector[count].iov_base = packet.cur;
+			io_vector[count].iov_len = packet.end - packet.cur;
+
+			entry_set_state(entry, MQTT_QUEUE_RELEASED);
+		} else {
+			continue;
+		}
+
+		if (++count == ARRAY_SIZE(io_vector)) {
+			err_code = queue_write(client, io_vector, count);
+			if (err_code < 0) {
+				break;
+			}
+
+			count = 0;
+		}
+	}
+
+	if (err_code == 0 && count > 0) {
+		err_code = queue_write(client, io_vector, count);
+	}
+
+	queue_compact(client);
+
+	return err_code;
+}
+
+int mqtt_queue_ack(struct mqtt_client *client, uint8_t type,
+		   uint16_t message_id)
+{
+	struct mqtt_queue_entry *entry;
+	uint32_t offset;
+
+	FOR_EACH_ENTRY(client, entry, offset) {
+		if (entry->message_id != message_id ||
+		    entry->qos == MQTT_QOS_0_AT_MOST_ONCE) {
+			continue;
+		}
+
+		if (type == MQTT_PKT_TYPE_PUBACK &&
+		    entry->state == MQTT_QUEUE_SENT &&
+		    entry->qos == MQTT_QOS_1_AT_LEAST_ONCE) {
+			entry_set_state(entry, MQTT_QUEUE_DONE);
+		} else if (type == MQTT_PKT_TYPE_PUBREC &&
+			   entry->state == MQTT_QUEUE_SENT &&
+			   entry->qos == MQTT_QOS_2_EXACTLY_ONCE) {
+			entry_set_state(entry, MQTT_QUEUE_RELEASE);
+		} else if (type == MQTT_PKT_TYPE_PUBCOMP &&
+			   entry->state == MQTT_QUEUE_RELEASED) {
+			entry_set_state(entry, MQTT_QUEUE_DONE);
+		} else {
+			continue;
+		}
+
+		/* The window may have room for more messages now */
+		return mqtt_queue_flush(client);
+	}
+
+	/* Not a queued message */
+	return 0;
+}
+
+/** Prepare a message sent on a previous connection to be sent again. */
+static void entry_resend(struct mqtt_queue_entry *entry)
+{
+	uint8_t *packet = (uint8_t *)(entry + 1);
+
+	if (entry->state == MQTT_QUEUE_SENT) {
+		packet[0] |= MQTT_HEADER_DUP_MASK;
+		entry->state = MQTT_QUEUE_PENDING;
+	} else if (entry->state == MQTT_QUEUE_RELEASED) {
+		entry->state = MQTT_QUEUE_RELEASE;
+	}
+}
+
+int mqtt_queue_reconnected(struct mqtt_client *client)
+{
+	struct mqtt_queue_entry *entry;
+	uint32_t offset;
+
+	FOR_EACH_ENTRY(client, entry, offset) {
+		entry_resend(entry);
+	}
+
+	return mqtt_queue_flush(client);
+}
+
+int mqtt_queue_publish(struct mqtt_client *client,
+		       const struct mqtt_publish_param *param)
+{
+	struct mqtt_queue_entry *entry;
+	struct buf_ctx packet;
+	uint32_t header_len;
+	int err_code;
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	struct mqtt_publish_param no_alias;
+#endif
+
+	if (client->queue_buf == NULL) {
+		return -ENOMEM;
+	}
+
+	entry = ENTRY(client, client->internal.queue_len);
+
+	packet.cur = (uint8_t *)(entry + 1);
+	packet.end = client->queue_buf + client->queue_buf_size;
+
+	if (packet.cur > packet.end) {
+		return -ENOMEM;
+	}
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	/* Queued messages outlive the connection and its topic aliases. */
+	no_alias = *param;
+	no_alias.prop.topic_alias = 0U;
+	param = &no_alias;
+#endif
+
+	err_code = publish_encode(client, param, &packet);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	/* The fixed header may be shorter than what was reserved for it */
+	header_len = packet.end - packet.cur;
+	if ((uint8_t *)(entry + 1) + header_len + param->message.payload.len >
+	    client->queue_buf + client->queue_buf_size) {
+		return -ENOMEM;
+	}
+
+	memmove(entry + 1, packet.cur, header_len);
+
+	memcpy((uint8_t *)(entry + 1) + header_len,
+	       param->message.payload.data, param->message.payload.len);
+
+	entry->len = header_len + param->message.payload.len;
+	entry->message_id = param->message_id;
+	entry->qos = param->message.topic.qos;
+	entry->state = MQTT_QUEUE_PENDING;
+
+	client->internal.queue_len += ENTRY_SIZE(entry);
+
+	if (entry->qos > MQTT_QOS_0_AT_MOST_ONCE) {
+		entry_store(entry);
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_MQTT_TX_QUEUE_PERSIST)
+static int queue_restore_entry(const char *key, size_t len,
+			       settings_read_cb read_cb, void *cb_arg,
+			       void *param)
+{
+	struct mqtt_client *client = param;
+	struct mqtt_queue_entry *entry;
+	ssize_t ret;
+
+	if (client->internal.queue_len + len > client->queue_buf_size) {
+		MQTT_ERR("No room to restore message %s", log_strdup(key));
+		return 0;
+	}
+
+	entry = ENTRY(client, client->internal.queue_len);
+
+	ret = read_cb(cb_arg, entry, len);
+	if (ret != len || len < sizeof(*entry) || ENTRY_SIZE(entry) != len) {
+		return 0;
+	}
+
+	entry_resend(entry);
+
+	client->internal.queue_len += len;
+
+	return 0;
+}
+
+int mqtt_queue_restore(struct mqtt_client *client)
+{
+	if (client->queue_buf == NULL) {
+		return -ENOMEM;
+	}
+
+	client->internal.queue_len = 0U;
+
+	return settings_load_subtree_direct(QUEUE_SUBTREE,
+					    queue_restore_entry, client);
+}
+#endif /* CONFIG_MQTT_TX_QUEUE_PERSIST */
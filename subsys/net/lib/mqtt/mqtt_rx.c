@@ -16,6 +16,49 @@ LOG_MODULE_REGISTER(net_mqtt_rx, CONFIG_MQTT_LOG_LEVEL);
  * @brief MQTT Received data handling.
  */
 
+#if defined(CONFIG_MQTT_TX_QUEUE)
+/* Let the outgoing queue track the acknowledgments of its messages. */
+static int mqtt_queue_handle_evt(struct mqtt_client *client,
+				 const struct mqtt_evt *evt)
+{
+	switch (evt->type) {
+	case MQTT_EVT_CONNACK:
+		return mqtt_queue_reconnected(client);
+
+	case MQTT_EVT_PUBACK:
+		return mqtt_queue_ack(client, MQTT_PKT_TYPE_PUBACK,
+				      evt->param.puback.message_id);
+
+	case MQTT_EVT_PUBREC:
+		return mqtt_queue_ack(client, MQTT_PKT_TYPE_PUBREC,
+				      evt->param.pubrec.message_id);
+
+	case MQTT_EVT_PUBCOMP:
+		return mqtt_queue_ack(client, MQTT_PKT_TYPE_PUBCOMP,
+				      evt->param.pubcomp.message_id);
+
+	default:
+		return 0;
+	}
+}
+#endif /* CONFIG_MQTT_TX_QUEUE */
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+/* Apply the limits the server set in CONNACK to the new connection. */
+static void mqtt_connack_prop_apply(struct mqtt_client *client,
+				    const struct mqtt_prop *prop)
+{
+	client->internal.receive_max = prop->receive_maximum ?
+				       prop->receive_maximum : UINT16_MAX;
+	client->internal.send_quota = client->internal.receive_max;
+	client->internal.tx_alias_max = MIN(prop->topic_alias_maximum,
+					    CONFIG_MQTT_TOPIC_ALIAS_MAX);
+	client->internal.max_packet_size = prop->maximum_packet_size;
+
+	mqtt_topic_alias_reset(client);
+}
+#endif /* CONFIG_MQTT_VERSION_5_0 */
+
 static int mqtt_handle_packet(struct mqtt_client *client,
 			      uint8_t type_and_flags,
 			      uint32_t var_length,
@@ -42,6 +85,13 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 						MQTT_CONNECTION_ACCEPTED) {
 				/* Set state. */
 				MQTT_SET_STATE(client, MQTT_STATE_CONNECTED);
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+				if (MQTT_IS_VERSION_5_0(client)) {
+					mqtt_connack_prop_apply(client,
+						&evt.param.connack.prop);
+				}
+#endif
 			} else {
 				err_code = -ECONNREFUSED;
 			}
@@ -57,8 +107,14 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		MQTT_TRC("[CID %p]: Received MQTT_PKT_TYPE_PUBLISH", client);
 
 		evt.type = MQTT_EVT_PUBLISH;
-		err_code = publish_decode(type_and_flags, var_length, buf,
-					  &evt.param.publish);
+		err_code = publish_decode(client, type_and_flags, var_length,
+					  buf, &evt.param.publish);
+#if defined(CONFIG_MQTT_VERSION_5_0)
+		if (err_code == 0 && MQTT_IS_VERSION_5_0(client)) {
+			err_code = mqtt_topic_alias_rx(client,
+						       &evt.param.publish);
+		}
+#endif
 		evt.result = err_code;
 
 		client->internal.remaining_payload =
@@ -77,6 +133,10 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		evt.type = MQTT_EVT_PUBACK;
 		err_code = publish_ack_decode(buf, &evt.param.puback);
 		evt.result = err_code;
+
+		if (err_code == 0) {
+			mqtt_send_quota_give(client);
+		}
 		break;
 
 	case MQTT_PKT_TYPE_PUBREC:
@@ -85,6 +145,14 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		evt.type = MQTT_EVT_PUBREC;
 		err_code = publish_receive_decode(buf, &evt.param.pubrec);
 		evt.result = err_code;
+
+#if defined(CONFIG_MQTT_VERSION_5_0)
+		/* A failed QoS 2 exchange ends with the PUBREC. */
+		if (err_code == 0 &&
+		    evt.param.pubrec.reason_code >= MQTT_REASON_FAILURE) {
+			mqtt_send_quota_give(client);
+		}
+#endif
 		break;
 
 	case MQTT_PKT_TYPE_PUBREL:
@@ -101,13 +169,18 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		evt.type = MQTT_EVT_PUBCOMP;
 		err_code = publish_complete_decode(buf, &evt.param.pubcomp);
 		evt.result = err_code;
+
+		if (err_code == 0) {
+			mqtt_send_quota_give(client);
+		}
 		break;
 
 	case MQTT_PKT_TYPE_SUBACK:
 		MQTT_TRC("[CID %p]: Received MQTT_PKT_TYPE_SUBACK!", client);
 
 		evt.type = MQTT_EVT_SUBACK;
-		err_code = subscribe_ack_decode(buf, &evt.param.suback);
+		err_code = subscribe_ack_decode(client, buf,
+					       &evt.param.suback);
 		evt.result = err_code;
 		break;
 
@@ -115,7 +188,8 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		MQTT_TRC("[CID %p]: Received MQTT_PKT_TYPE_UNSUBACK!", client);
 
 		evt.type = MQTT_EVT_UNSUBACK;
-		err_code = unsubscribe_ack_decode(buf, &evt.param.unsuback);
+		err_code = unsubscribe_ack_decode(client, buf,
+						 &evt.param.unsuback);
 		evt.result = err_code;
 		break;
 
@@ -132,6 +206,30 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		evt.type = MQTT_EVT_PINGRESP;
 		break;
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	case MQTT_PKT_TYPE_DISCONNECT: {
+		struct mqtt_prop prop;
+		uint8_t reason_code;
+
+		MQTT_TRC("[CID %p]: Received MQTT_PKT_TYPE_DISCONNECT!", client);
+
+		/* The connection is closed by the caller, which notifies
+		 * MQTT_EVT_DISCONNECT.
+		 */
+		notify_event = false;
+
+		err_code = disconnect_decode(buf, &reason_code, &prop);
+		if (err_code == 0) {
+			MQTT_ERR("[CID %p]: Disconnected by the server, "
+				 "reason 0x%02x", client, reason_code);
+			err_code = -ECONNRESET;
+		}
+
+		break;
+	}
+#endif
+
+
 	default:
 		/* Nothing to notify. */
 		notify_event = false;
@@ -140,6 +238,12 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 
 	if (notify_event == true) {
 		event_notify(client, &evt);
+
+#if defined(CONFIG_MQTT_TX_QUEUE)
+		if (err_code == 0) {
+			err_code = mqtt_queue_handle_evt(client, &evt);
+		}
+#endif
 	}
 
 	return err_code;
@@ -216,6 +320,36 @@ static int mqtt_read_publish_var_header(struct mqtt_client *client,
 		variable_header_length += sizeof(uint16_t);
 	}
 
+#if defined(CONFIG_MQTT_VERSION_5_0)
+	if (MQTT_IS_VERSION_5_0(client)) {
+		uint32_t prop_length = 0U;
+		uint8_t shift = 0U;
+		uint8_t byte;
+
+		/* Read the property length one byte at a time. */
+		do {
+			if (shift >= MQTT_MAX_LENGTH_BYTES * MQTT_LENGTH_SHIFT) {
+				return -EINVAL;
+			}
+
+			variable_header_length++;
+
+			err_code = mqtt_read_message_chunk(
+					client, buf, variable_header_length);
+			if (err_code < 0) {
+				return err_code;
+			}
+
+			byte = buf->cur[variable_header_length - 1];
+			prop_length += (uint32_t)(byte & MQTT_LENGTH_VALUE_MASK)
+								<< shift;
+			shift += MQTT_LENGTH_SHIFT;
+		} while ((byte & MQTT_LENGTH_CONTINUATION_BIT) != 0U);
+
+		variable_header_length += prop_length;
+	}
+#endif
+
 	/* Now we can read the whole header. */
 	err_code = mqtt_read_message_chunk(client, buf,
 					   variable_header_length);
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file mqtt_topic_alias.c
+ *
+ * @brief MQTT 5.0 topic aliases.
+ *
+ * A topic alias replaces a topic in the PUBLISH packets of a connection,
+ * once the first PUBLISH with both the topic and the alias has bound them.
+ * Each direction has its own aliases, and they are forgotten when the
+ * connection is closed.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_mqtt_alias, CONFIG_MQTT_LOG_LEVEL);
+
+#include "mqtt_internal.h"
+#include "mqtt_os.h"
+
+void mqtt_topic_alias_reset(struct mqtt_client *client)
+{
+	(void)memset(client->internal.tx_alias, 0,
+		     sizeof(client->internal.tx_alias));
+	(void)memset(client->internal.rx_alias, 0,
+		     sizeof(client->internal.rx_alias));
+
+	client->internal.tx_alias_next = 0U;
+}
+
+void mqtt_topic_alias_tx(struct mqtt_client *client,
+			 struct mqtt_publish_param *param)
+{
+	struct mqtt_utf8 *topic = &param->message.topic.topic;
+	uint16_t count = client->internal.tx_alias_max;
+	struct mqtt_topic_alias *alias;
+	uint16_t i;
+
+	param->prop.topic_alias = 0U;
+
+	if (count == 0U || topic->size == 0U ||
+	    topic->size > CONFIG_MQTT_TOPIC_ALIAS_SIZE) {
+		return;
+	}
+
+	for (i = 0U; i < count; i++) {
+		alias = &client->internal.tx_alias[i];
+
+		if (alias->size == topic->size &&
+		    memcmp(alias->topic, topic->utf8, topic->size) == 0) {
+			/* Bound already, the topic is left out. */
+			param->prop.topic_alias = i + 1;
+			topic->size = 0U;
+
+			return;
+		}
+	}
+
+	/* Bind the topic to a free alias, or else to the oldest one. */
+	for (i = 0U; i < count; i++) {
+		if (client->internal.tx_alias[i].size == 0U) {
+			break;
+		}
+	}
+
+	if (i == count) {
+		i = client->internal.tx_alias_next;
+		client->internal.tx_alias_next = (i + 1) % count;
+	}
+
+	alias = &client->internal.tx_alias[i];
+	memcpy(alias->topic, topic->utf8, topic->size);
+	alias->size = topic->size;
+
+	param->prop.topic_alias = i + 1;
+
+	MQTT_TRC("[CID %p]: Topic alias %u bound", client, i + 1);
+}
+
+int mqtt_topic_alias_rx(struct mqtt_client *client,
+			struct mqtt_publish_param *param)
+{
+	struct mqtt_utf8 *topic = &param->message.topic.topic;
+	uint16_t id = param->prop.topic_alias;
+	struct mqtt_topic_alias *alias;
+
+	if (id == 0U) {
+		return 0;
+	}
+
+	if (id > CONFIG_MQTT_TOPIC_ALIAS_MAX) {
+		MQTT_ERR("[CID %p]: Topic alias %u out of range", client, id);
+		return -EINVAL;
+	}
+
+	alias = &client->internal.rx_alias[id - 1];
+
+	if (topic->size == 0U) {
+		if (alias->size == 0U) {
+			MQTT_ERR("[CID %p]: Topic alias %u not bound", client,
+				 id);
+			return -EINVAL;
+		}
+
+		topic->utf8 = alias->topic;
+		topic->size = alias->size;
+
+		return 0;
+	}
+
+	if (topic->size > CONFIG_MQTT_TOPIC_ALIAS_SIZE) {
+		MQTT_ERR("[CID %p]: Topic too long for alias %u", client, id);
+		return -EINVAL;
+	}
+
+	memcpy(alias->topic, topic->utf8, topic->size);
+	alias->size = topic->size;
+
+	return 0;
+}
@@ -98,7 +98,7 @@ int mqtt_client_websocket_write(struct mqtt_client *client, const uint8_t *data,
 					 WEBSOCKET_OPCODE_DATA_BINARY,
 					 true, true, SYS_FOREVER_MS);
 		if (ret < 0) {
-			return -errno;
+			return ret;
 		}
 
 		offset += ret;
@@ -110,31 +110,21 @@ int mqtt_client_websocket_write(struct mqtt_client *client, const uint8_t *data,
 int mqtt_client_websocket_write_msg(struct mqtt_client *client,
 				    const struct msghdr *message)
 {
-	enum websocket_opcode opcode = WEBSOCKET_OPCODE_DATA_BINARY;
-	bool final = false;
-	ssize_t len;
-	ssize_t ret;
-	int i;
-
-	len = 0;
-	for (i = 0; i < message->msg_iovlen; i++) {
-		if (i == message->msg_iovlen - 1) {
-			final = true;
-		}
-
-		ret = websocket_send_msg(client->transport.websocket.sock,
-					 message->msg_iov[i].iov_base,
-					 message->msg_iov[i].iov_len, opcode,
-					 true, final, SYS_FOREVER_MS);
-		if (ret < 0) {
-			return ret;
-		}
+	int ret;
 
-		opcode = WEBSOCKET_OPCODE_CONTINUE;
-		len += ret;
+	/* All the parts of the message go to one binary frame, the payload
+	 * is masked as it is copied to the stack instead of being copied to
+	 * a heap buffer first.
+	 */
+	ret = websocket_send_msg_iov(client->transport.websocket.sock,
+				     message->msg_iov, message->msg_iovlen,
+				     WEBSOCKET_OPCODE_DATA_BINARY,
+				     true, true, SYS_FOREVER_MS);
+	if (ret < 0) {
+		return ret;
 	}
 
-	return len;
+	return 0;
 }
 
 int mqtt_client_websocket_read(struct mqtt_client *client, uint8_t *data,
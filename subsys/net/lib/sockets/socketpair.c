@@ -59,6 +59,10 @@ __net_socket struct spair {
 	struct k_poll_signal read_signal;
 	/** buffer for @a recv_q recv_q */
 	uint8_t buf[CONFIG_NET_SOCKETPAIR_BUFFER_SIZE];
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	/** readiness notifiers of the local endpoint */
+	sys_dlist_t notifiers;
+#endif
 };
 
 /* forward declaration */
@@ -120,6 +124,17 @@ static inline size_t spair_read_avail(struct spair *spair)
 	return k_pipe_read_avail(&spair->recv_q);
 }
 
+/** Notify the readiness notifiers of a @ref spair */
+static inline void spair_notify(struct spair *spair, uint32_t events)
+{
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	z_fd_notify(&spair->notifiers, events);
+#else
+	ARG_UNUSED(spair);
+	ARG_UNUSED(events);
+#endif
+}
+
 /** Swap two 32-bit integers */
 static inline void swap32(uint32_t *a, uint32_t *b)
 {
@@ -182,6 +197,8 @@ static void spair_delete(struct spair *spair)
 				__ASSERT(res == 0,
 					"k_poll_signal_raise() failed: %d",
 					res);
+				spair_notify(remote,
+					     ZSOCK_POLLIN | ZSOCK_POLLHUP);
 			}
 		}
 	}
@@ -243,6 +260,9 @@ static struct spair *spair_new(void)
 	k_pipe_init(&spair->recv_q, spair->buf, sizeof(spair->buf));
 	k_poll_signal_init(&spair->write_signal);
 	k_poll_signal_init(&spair->read_signal);
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	sys_dlist_init(&spair->notifiers);
+#endif
 
 	spair->remote = z_reserve_fd();
 	if (spair->remote == -1) {
@@ -535,6 +555,8 @@ static ssize_t spair_write(void *obj, const void *buffer, size_t count)
 	res = k_poll_signal_raise(&remote->write_signal, SPAIR_SIG_DATA);
 	__ASSERT(res == 0, "k_poll_signal_raise() failed: %d", res);
 
+	spair_notify(remote, ZSOCK_POLLIN);
+
 	res = bytes_written;
 
 out:
@@ -594,6 +616,7 @@ static ssize_t spair_read(void *obj, void *buffer, size_t count)
 	bool have_local_sem = false;
 	bool will_block = false;
 	struct spair *const spair = (struct spair *)obj;
+	struct spair *remote;
 
 	if (obj == NULL || buffer == NULL || count == 0) {
 		errno = EINVAL;
@@ -703,6 +726,15 @@ static ssize_t spair_read(void *obj, void *buffer, size_t count)
 	if (is_connected) {
 		res = k_poll_signal_raise(&spair->read_signal, SPAIR_SIG_DATA);
 		__ASSERT(res == 0, "k_poll_signal_raise() failed: %d", res);
+
+		/* The remote endpoint cannot be deleted while the local
+		 * semaphore is held, so it is safe to notify it here.
+		 */
+		remote = z_get_fd_obj(spair->remote,
+			(const struct fd_op_vtable *)&spair_fd_op_vtable, 0);
+		if (remote != NULL) {
+			spair_notify(remote, ZSOCK_POLLOUT);
+		}
 	}
 
 	res = bytes_read;
@@ -943,6 +975,31 @@ static int spair_ioctl(void *obj, unsigned int request, va_list args)
 			goto out;
 		}
 
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+		case ZFD_IOCTL_POLL_READY: {
+			res = 0;
+
+			if (spair_read_avail(spair) > 0) {
+				res |= ZSOCK_POLLIN;
+			}
+
+			if (!sock_is_connected(spair)) {
+				res |= ZSOCK_POLLIN | ZSOCK_POLLHUP;
+			} else if (spair_write_avail(spair) > 0) {
+				res |= ZSOCK_POLLOUT;
+			}
+
+			goto out;
+		}
+
+		case ZFD_IOCTL_POLL_NOTIFY: {
+			z_fd_notifier_attach(&spair->notifiers,
+				va_arg(args, struct zfd_notifier *));
+			res = 0;
+			goto out;
+		}
+#endif
+
 		default: {
 			errno = EOPNOTSUPP;
 			res = -1;
@@ -1125,6 +1182,13 @@ static int spair_close(void *obj)
 	struct spair *const spair = (struct spair *)obj;
 	int res;
 
+#ifdef CONFIG_NET_SOCKETS_EPOLL
+	/* Before taking the local sem, which a readiness read in progress
+	 * may be waiting for.
+	 */
+	z_fd_notify_close(&spair->notifiers);
+#endif
+
 	res = k_sem_take(&spair->sem, K_FOREVER);
 	__ASSERT(res == 0, "failed to take local sem: %d", res);
 
@@ -24,6 +24,7 @@ LOG_MODULE_REGISTER(net_sock, CONFIG_NET_SOCKETS_LOG_LEVEL);
 #endif
 
 #include "../../ip/net_stats.h"
+#include "../../ip/tcp_internal.h"
 
 #include "sockets_internal.h"
 
@@ -169,6 +170,8 @@ int zsock_socket_internal(int family, int type, int proto)
 	/* recv_q and accept_q are in union */
 	k_fifo_init(&ctx->recv_q);
 
+	sock_notify_init(ctx);
+
 	/* TCP context is effectively owned by both application
 	 * and the stack: stack may detect that peer closed/aborted
 	 * connection, but it must not dispose of the context behind
@@ -238,6 +241,8 @@ int zsock_close_ctx(struct net_context *ctx)
 
 	zsock_flush_queue(ctx);
 
+	sock_notify_close(ctx);
+
 	SET_ERRNO(net_context_put(ctx));
 
 	return 0;
@@ -301,12 +306,15 @@ static void zsock_accepted_cb(struct net_context *new_ctx,
 	NET_DBG("parent=%p, ctx=%p, st=%d", parent, new_ctx, status);
 
 	if (status == 0) {
+		sock_notify_init(new_ctx);
+
 		/* This just installs a callback, so cannot fail. */
 		(void)net_context_recv(new_ctx, zsock_received_cb, K_NO_WAIT,
 				       NULL);
 		k_fifo_init(&new_ctx->recv_q);
 
 		k_fifo_put(&parent->accept_q, new_ctx);
+		sock_notify(parent, ZSOCK_POLLIN);
 	}
 }
 
@@ -336,6 +344,8 @@ static void zsock_received_cb(struct net_context *ctx,
 			net_pkt_set_eof(last_pkt, true);
 			NET_DBG("Set EOF flag on pkt %p", last_pkt);
 		}
+
+		sock_notify(ctx, ZSOCK_POLLIN | ZSOCK_POLLHUP);
 		return;
 	}
 
@@ -349,6 +359,7 @@ static void zsock_received_cb(struct net_context *ctx,
 	net_pkt_set_rx_stats_tick(pkt, k_cycle_get_32());
 
 	k_fifo_put(&ctx->recv_q, pkt);
+	sock_notify(ctx, ZSOCK_POLLIN);
 }
 
 int zsock_bind_ctx(struct net_context *ctx, const struct sockaddr *addr,
@@ -575,6 +586,36 @@ static inline int z_vrfy_zsock_accept(int sock, struct sockaddr *addr,
 #include <syscalls/zsock_accept_mrsh.c>
 #endif /* CONFIG_USERSPACE */
 
+#if defined(CONFIG_NET_SOCKETS_ZEROCOPY)
+static void zsock_zerocopy_cb(struct net_context *ctx, const void *buf,
+			      void *user_data)
+{
+	atomic_inc(&ctx->zerocopy_done);
+}
+
+static int zsock_sendto_zerocopy(struct net_context *ctx, const void *buf,
+				 size_t len, const struct sockaddr *dest_addr,
+				 socklen_t addrlen, k_timeout_t timeout)
+{
+	return net_context_sendto_zerocopy(ctx, buf, len, dest_addr, addrlen,
+					   zsock_zerocopy_cb, timeout, NULL);
+}
+#else
+#define zsock_sendto_zerocopy(...) (-EOPNOTSUPP)
+#endif /* CONFIG_NET_SOCKETS_ZEROCOPY */
+
+/* The TCP transmit semaphore is available while the send window of the
+ * peer can take more data, no other socket tracks its writability.
+ */
+static struct k_sem *sock_tx_sem(struct net_context *ctx)
+{
+	if (net_context_get_type(ctx) != SOCK_STREAM) {
+		return NULL;
+	}
+
+	return net_tcp_tx_sem_get(ctx);
+}
+
 ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
 			 int flags,
 			 const struct sockaddr *dest_addr, socklen_t addrlen)
@@ -596,7 +637,10 @@ ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
 		return -1;
 	}
 
-	if (dest_addr) {
+	if (flags & ZSOCK_MSG_ZEROCOPY) {
+		status = zsock_sendto_zerocopy(ctx, buf, len, dest_addr,
+					       addrlen, timeout);
+	} else if (dest_addr) {
 		status = net_context_sendto(ctx, buf, len, dest_addr,
 					    addrlen, NULL, timeout,
 					    ctx->user_data);
@@ -626,6 +670,11 @@ ssize_t z_vrfy_zsock_sendto(int sock, const void *buf, size_t len, int flags,
 	struct sockaddr_storage dest_addr_copy;
 
 	Z_OOPS(Z_SYSCALL_MEMORY_READ(buf, len));
+
+	/* The buffer could be modified or freed by the user thread while
+	 * the stack still uses it.
+	 */
+	flags &= ~ZSOCK_MSG_ZEROCOPY;
 	if (dest_addr) {
 		Z_OOPS(Z_SYSCALL_VERIFY(addrlen <= sizeof(dest_addr_copy)));
 		Z_OOPS(z_user_from_copy(&dest_addr_copy, (void *)dest_addr,
@@ -885,16 +934,9 @@ void net_socket_update_tc_rx_time(struct net_pkt *pkt, uint32_t end_tick)
 	}
 }
 
-static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
-				       void *buf,
-				       size_t max_len,
-				       int flags,
-				       struct sockaddr *src_addr,
-				       socklen_t *addrlen)
+static struct net_pkt *sock_recv_pkt(struct net_context *ctx, int flags)
 {
 	k_timeout_t timeout = K_FOREVER;
-	size_t recv_len = 0;
-	struct net_pkt_cursor backup;
 	struct net_pkt *pkt;
 
 	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
@@ -908,7 +950,7 @@ static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
 		/* EAGAIN when timeout expired, EINTR when cancelled */
 		if (res && res != -EAGAIN && res != -EINTR) {
 			errno = -res;
-			return -1;
+			return NULL;
 		}
 
 		pkt = k_fifo_peek_head(&ctx->recv_q);
@@ -918,32 +960,59 @@ static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
 
 	if (!pkt) {
 		errno = EAGAIN;
+	}
+
+	return pkt;
+}
+
+static int sock_get_src_addr(struct net_context *ctx, struct net_pkt *pkt,
+			     struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	int rv;
+
+	rv = sock_get_pkt_src_addr(pkt, net_context_get_ip_proto(ctx),
+				   src_addr, *addrlen);
+	if (rv < 0) {
+		errno = -rv;
 		return -1;
 	}
 
-	net_pkt_cursor_backup(pkt, &backup);
+	/* addrlen is a value-result argument, set to actual
+	 * size of source address
+	 */
+	if (src_addr->sa_family == AF_INET) {
+		*addrlen = sizeof(struct sockaddr_in);
+	} else if (src_addr->sa_family == AF_INET6) {
+		*addrlen = sizeof(struct sockaddr_in6);
+	} else {
+		errno = ENOTSUP;
+		return -1;
+	}
 
-	if (src_addr && addrlen) {
-		int rv;
+	return 0;
+}
 
-		rv = sock_get_pkt_src_addr(pkt, net_context_get_ip_proto(ctx),
-					   src_addr, *addrlen);
-		if (rv < 0) {
-			errno = -rv;
-			goto fail;
-		}
+static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
+				       void *buf,
+				       size_t max_len,
+				       int flags,
+				       struct sockaddr *src_addr,
+				       socklen_t *addrlen)
+{
+	size_t recv_len = 0;
+	struct net_pkt_cursor backup;
+	struct net_pkt *pkt;
 
-		/* addrlen is a value-result argument, set to actual
-		 * size of source address
-		 */
-		if (src_addr->sa_family == AF_INET) {
-			*addrlen = sizeof(struct sockaddr_in);
-		} else if (src_addr->sa_family == AF_INET6) {
-			*addrlen = sizeof(struct sockaddr_in6);
-		} else {
-			errno = ENOTSUP;
-			goto fail;
-		}
+	pkt = sock_recv_pkt(ctx, flags);
+	if (!pkt) {
+		return -1;
+	}
+
+	net_pkt_cursor_backup(pkt, &backup);
+
+	if (src_addr && addrlen &&
+	    sock_get_src_addr(ctx, pkt, src_addr, addrlen) < 0) {
+		goto fail;
 	}
 
 	recv_len = net_pkt_remaining_data(pkt);
@@ -1068,6 +1137,172 @@ static inline ssize_t zsock_recv_stream(struct net_context *ctx,
 	return recv_len;
 }
 
+#if defined(CONFIG_NET_SOCKETS_ZEROCOPY)
+/* Take the data of the packet, without the headers in front of the
+ * cursor, and release the packet itself.
+ */
+static struct net_buf *sock_pkt_take_data(struct net_pkt *pkt)
+{
+	size_t skip = net_pkt_get_len(pkt) - net_pkt_remaining_data(pkt);
+	struct net_buf *frags = pkt->buffer;
+
+	pkt->buffer = NULL;
+	net_pkt_unref(pkt);
+
+	while (frags && skip >= frags->len) {
+		skip -= frags->len;
+		frags = net_buf_frag_del(NULL, frags);
+	}
+
+	if (frags) {
+		net_buf_pull(frags, skip);
+	}
+
+	return frags;
+}
+
+static ssize_t zsock_recv_zerocopy_dgram(struct net_context *ctx,
+					 struct net_buf **frags,
+					 int flags,
+					 struct sockaddr *src_addr,
+					 socklen_t *addrlen)
+{
+	k_timeout_t timeout = K_FOREVER;
+	struct net_pkt *pkt;
+	size_t recv_len;
+
+	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
+		timeout = K_NO_WAIT;
+	}
+
+	pkt = k_fifo_get(&ctx->recv_q, timeout);
+	if (!pkt) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	if (src_addr && addrlen) {
+		int rv;
+
+		rv = sock_get_pkt_src_addr(pkt, net_context_get_ip_proto(ctx),
+					   src_addr, *addrlen);
+		if (rv < 0) {
+			net_pkt_unref(pkt);
+			errno = -rv;
+			return -1;
+		}
+
+		if (src_addr->sa_family == AF_INET) {
+			*addrlen = sizeof(struct sockaddr_in);
+		} else {
+			*addrlen = sizeof(struct sockaddr_in6);
+		}
+	}
+
+	if (IS_ENABLED(CONFIG_NET_PKT_RXTIME_STATS)) {
+		net_socket_update_tc_rx_time(pkt, k_cycle_get_32());
+	}
+
+	recv_len = net_pkt_remaining_data(pkt);
+	*frags = sock_pkt_take_data(pkt);
+
+	return recv_len;
+}
+
+static ssize_t zsock_recv_zerocopy_stream(struct net_context *ctx,
+					  struct net_buf **frags,
+					  int flags)
+{
+	k_timeout_t timeout = K_FOREVER;
+	struct net_pkt *pkt;
+	size_t recv_len;
+	int res;
+
+	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
+		timeout = K_NO_WAIT;
+	}
+
+	do {
+		if (sock_is_eof(ctx)) {
+			return 0;
+		}
+
+		res = k_fifo_wait_non_empty(&ctx->recv_q, timeout);
+		/* EAGAIN when timeout expired, EINTR when cancelled */
+		if (res && res != -EAGAIN && res != -EINTR) {
+			errno = -res;
+			return -1;
+		}
+
+		pkt = k_fifo_get(&ctx->recv_q, K_NO_WAIT);
+		if (!pkt) {
+			if (sock_is_eof(ctx)) {
+				return 0;
+			}
+
+			errno = EAGAIN;
+			return -1;
+		}
+
+		if (net_pkt_eof(pkt)) {
+			sock_set_eof(ctx);
+		}
+
+		if (IS_ENABLED(CONFIG_NET_PKT_RXTIME_STATS)) {
+			net_socket_update_tc_rx_time(pkt, k_cycle_get_32());
+		}
+
+		recv_len = net_pkt_remaining_data(pkt);
+		*frags = sock_pkt_take_data(pkt);
+		if (!recv_len && *frags) {
+			net_buf_unref(*frags);
+			*frags = NULL;
+		}
+	} while (recv_len == 0);
+
+	net_context_update_recv_wnd(ctx, recv_len);
+
+	return recv_len;
+}
+
+ssize_t zsock_recv_zerocopy(int sock, struct net_buf **frags, int flags,
+			    struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	const struct socket_op_vtable *vtable;
+	struct net_context *ctx;
+
+	ctx = get_sock_vtable(sock, &vtable);
+	if (ctx == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (vtable != &sock_fd_op_vtable) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	if (flags & ZSOCK_MSG_PEEK) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*frags = NULL;
+
+	if (net_context_get_type(ctx) == SOCK_DGRAM) {
+		return zsock_recv_zerocopy_dgram(ctx, frags, flags, src_addr,
+						 addrlen);
+	}
+
+	if (!net_context_is_used(ctx)) {
+		errno = EBADF;
+		return -1;
+	}
+
+	return zsock_recv_zerocopy_stream(ctx, frags, flags);
+}
+#endif /* CONFIG_NET_SOCKETS_ZEROCOPY */
+
 ssize_t zsock_recvfrom_ctx(struct net_context *ctx, void *buf, size_t max_len,
 			   int flags,
 			   struct sockaddr *src_addr, socklen_t *addrlen)
@@ -1127,39 +1362,499 @@ ssize_t z_vrfy_zsock_recvfrom(int sock, void *buf, size_t max_len, int flags,
 #include <syscalls/zsock_recvfrom_mrsh.c>
 #endif /* CONFIG_USERSPACE */
 
-/* As this is limited function, we don't follow POSIX signature, with
- * "..." instead of last arg.
- */
-int z_impl_zsock_fcntl(int sock, int cmd, int flags)
+static int sock_get_pkt_dst_addr(struct net_pkt *pkt, void *addr)
 {
-	const struct socket_op_vtable *vtable;
-	void *obj;
+	struct net_pkt_cursor backup;
+	int ret = 0;
 
-	obj = get_sock_vtable(sock, &vtable);
-	if (obj == NULL) {
-		errno = EBADF;
-		return -1;
+	net_pkt_cursor_backup(pkt, &backup);
+	net_pkt_cursor_init(pkt);
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(pkt) == AF_INET) {
+		NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv4_access,
+						      struct net_ipv4_hdr);
+		struct net_ipv4_hdr *ipv4_hdr;
+
+		ipv4_hdr = (struct net_ipv4_hdr *)net_pkt_get_data(
+							pkt, &ipv4_access);
+		if (ipv4_hdr) {
+			net_ipaddr_copy((struct in_addr *)addr, &ipv4_hdr->dst);
+		} else {
+			ret = -ENOBUFS;
+		}
+	} else if (IS_ENABLED(CONFIG_NET_IPV6) &&
+		   net_pkt_family(pkt) == AF_INET6) {
+		NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv6_access,
+						      struct net_ipv6_hdr);
+		struct net_ipv6_hdr *ipv6_hdr;
+
+		ipv6_hdr = (struct net_ipv6_hdr *)net_pkt_get_data(
+							pkt, &ipv6_access);
+		if (ipv6_hdr) {
+			net_ipaddr_copy((struct in6_addr *)addr,
+					&ipv6_hdr->dst);
+		} else {
+			ret = -ENOBUFS;
+		}
+	} else {
+		ret = -ENOTSUP;
 	}
 
-	return z_fdtable_call_ioctl((const struct fd_op_vtable *)vtable,
-				    obj, cmd, flags);
+	net_pkt_cursor_restore(pkt, &backup);
+
+	return ret;
 }
 
-#ifdef CONFIG_USERSPACE
-static inline int z_vrfy_zsock_fcntl(int sock, int cmd, int flags)
+/* Append a control message to msg_control, or flag the control data as
+ * truncated if it does not fit.
+ */
+static void sock_put_cmsg(struct msghdr *msg, size_t *pos, int level,
+			  int type, const void *data, size_t len)
 {
-	return z_impl_zsock_fcntl(sock, cmd, flags);
+	struct cmsghdr *cmsg;
+
+	if (!msg->msg_control ||
+	    *pos + CMSG_SPACE(len) > msg->msg_controllen) {
+		msg->msg_flags |= ZSOCK_MSG_CTRUNC;
+		return;
+	}
+
+	cmsg = (struct cmsghdr *)((uint8_t *)msg->msg_control + *pos);
+	cmsg->cmsg_len = CMSG_LEN(len);
+	cmsg->cmsg_level = level;
+	cmsg->cmsg_type = type;
+	memcpy(CMSG_DATA(cmsg), data, len);
+
+	*pos += CMSG_SPACE(len);
 }
-#include <syscalls/zsock_fcntl_mrsh.c>
-#endif
 
-static int zsock_poll_prepare_ctx(struct net_context *ctx,
-				  struct zsock_pollfd *pfd,
-				  struct k_poll_event **pev,
-				  struct k_poll_event *pev_end)
+static int sock_put_cmsgs(struct net_context *ctx, struct net_pkt *pkt,
+			  struct msghdr *msg)
 {
-	if (pfd->events & ZSOCK_POLLIN) {
-		if (*pev == pev_end) {
+	size_t pos = 0;
+	int ret;
+
+	if (sock_get_flag(ctx, SOCK_RECV_PKTINFO)) {
+		int ifindex = net_if_get_by_iface(net_pkt_iface(pkt));
+
+		if (IS_ENABLED(CONFIG_NET_IPV4) &&
+		    net_pkt_family(pkt) == AF_INET) {
+			struct in_pktinfo info = {
+				.ipi_ifindex = ifindex,
+			};
+
+			ret = sock_get_pkt_dst_addr(pkt, &info.ipi_addr);
+			if (ret < 0) {
+				return ret;
+			}
+
+			net_ipaddr_copy(&info.ipi_spec_dst, &info.ipi_addr);
+
+			sock_put_cmsg(msg, &pos, IPPROTO_IP, IP_PKTINFO,
+				      &info, sizeof(info));
+		} else if (IS_ENABLED(CONFIG_NET_IPV6) &&
+			   net_pkt_family(pkt) == AF_INET6) {
+			struct in6_pktinfo info = {
+				.ipi6_ifindex = ifindex,
+			};
+
+			ret = sock_get_pkt_dst_addr(pkt, &info.ipi6_addr);
+			if (ret < 0) {
+				return ret;
+			}
+
+			sock_put_cmsg(msg, &pos, IPPROTO_IPV6, IPV6_PKTINFO,
+				      &info, sizeof(info));
+		}
+	}
+
+	if (IS_ENABLED(CONFIG_NET_PKT_TIMESTAMP) &&
+	    sock_get_flag(ctx, SOCK_RECV_TIMESTAMP)) {
+		sock_put_cmsg(msg, &pos, SOL_SOCKET, SCM_TIMESTAMPING,
+			      net_pkt_timestamp(pkt),
+			      sizeof(struct net_ptp_time));
+	}
+
+	msg->msg_controllen = pos;
+
+	return 0;
+}
+
+static ssize_t zsock_recvmsg_dgram(struct net_context *ctx,
+				   struct msghdr *msg, int flags)
+{
+	size_t recv_len = 0;
+	struct net_pkt_cursor backup;
+	struct net_pkt *pkt;
+	size_t i, len;
+	int ret;
+
+	pkt = sock_recv_pkt(ctx, flags);
+	if (!pkt) {
+		return -1;
+	}
+
+	net_pkt_cursor_backup(pkt, &backup);
+
+	msg->msg_flags = 0;
+
+	if (msg->msg_name &&
+	    sock_get_src_addr(ctx, pkt, msg->msg_name,
+			      &msg->msg_namelen) < 0) {
+		goto fail;
+	}
+
+	ret = sock_put_cmsgs(ctx, pkt, msg);
+	if (ret < 0) {
+		errno = -ret;
+		goto fail;
+	}
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		len = MIN(net_pkt_remaining_data(pkt),
+			  msg->msg_iov[i].iov_len);
+
+		if (net_pkt_read(pkt, msg->msg_iov[i].iov_base, len)) {
+			errno = ENOBUFS;
+			goto fail;
+		}
+
+		recv_len += len;
+	}
+
+	if (net_pkt_remaining_data(pkt) > 0) {
+		msg->msg_flags |= ZSOCK_MSG_TRUNC;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_PKT_RXTIME_STATS) &&
+	    !(flags & ZSOCK_MSG_PEEK)) {
+		net_socket_update_tc_rx_time(pkt, k_cycle_get_32());
+	}
+
+	if (!(flags & ZSOCK_MSG_PEEK)) {
+		net_pkt_unref(pkt);
+	} else {
+		net_pkt_cursor_restore(pkt, &backup);
+	}
+
+	return recv_len;
+
+fail:
+	if (!(flags & ZSOCK_MSG_PEEK)) {
+		net_pkt_unref(pkt);
+	}
+
+	return -1;
+}
+
+static ssize_t zsock_recvmsg_stream(struct net_context *ctx,
+				    struct msghdr *msg, int flags)
+{
+	ssize_t recv_len = 0;
+	ssize_t ret;
+	size_t i;
+
+	msg->msg_controllen = 0;
+	msg->msg_flags = 0;
+
+	/* Fill the buffers in turn, only waiting for the first one */
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		if (msg->msg_iov[i].iov_len == 0) {
+			continue;
+		}
+
+		ret = zsock_recv_stream(ctx, msg->msg_iov[i].iov_base,
+					msg->msg_iov[i].iov_len, flags);
+		if (ret < 0) {
+			return recv_len > 0 ? recv_len : -1;
+		}
+
+		recv_len += ret;
+
+		if (ret < msg->msg_iov[i].iov_len ||
+		    (flags & ZSOCK_MSG_PEEK)) {
+			break;
+		}
+
+		flags |= ZSOCK_MSG_DONTWAIT;
+	}
+
+	return recv_len;
+}
+
+ssize_t zsock_recvmsg_ctx(struct net_context *ctx, struct msghdr *msg,
+			  int flags)
+{
+	enum net_sock_type sock_type = net_context_get_type(ctx);
+
+	if (sock_type == SOCK_DGRAM) {
+		return zsock_recvmsg_dgram(ctx, msg, flags);
+	} else if (sock_type == SOCK_STREAM) {
+		return zsock_recvmsg_stream(ctx, msg, flags);
+	} else {
+		__ASSERT(0, "Unknown socket type");
+	}
+
+	return 0;
+}
+
+static ssize_t sock_recvmsg(void *obj, const struct socket_op_vtable *vtable,
+			    struct msghdr *msg, int flags)
+{
+	ssize_t ret;
+
+	if (vtable->recvmsg) {
+		return vtable->recvmsg(obj, msg, flags);
+	}
+
+	/* Without a recvmsg method, receive into a single buffer and
+	 * return no control data.
+	 */
+	if (!vtable->recvfrom || msg->msg_iovlen > 1) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	ret = vtable->recvfrom(obj,
+			       msg->msg_iovlen ? msg->msg_iov[0].iov_base : NULL,
+			       msg->msg_iovlen ? msg->msg_iov[0].iov_len : 0,
+			       flags, msg->msg_name,
+			       msg->msg_name ? &msg->msg_namelen : NULL);
+	if (ret >= 0) {
+		msg->msg_controllen = 0;
+		msg->msg_flags = 0;
+	}
+
+	return ret;
+}
+
+ssize_t z_impl_zsock_recvmsg(int sock, struct msghdr *msg, int flags)
+{
+	const struct socket_op_vtable *vtable;
+	void *obj;
+
+	obj = get_sock_vtable(sock, &vtable);
+	if (obj == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	return sock_recvmsg(obj, vtable, msg, flags);
+}
+
+#ifdef CONFIG_USERSPACE
+static inline ssize_t z_vrfy_zsock_recvmsg(int sock, struct msghdr *msg,
+					   int flags)
+{
+	struct msghdr msg_copy;
+	struct iovec *iov;
+	size_t iov_size;
+	ssize_t ret;
+	size_t i;
+
+	Z_OOPS(Z_SYSCALL_MEMORY_WRITE(msg, sizeof(*msg)));
+	Z_OOPS(z_user_from_copy(&msg_copy, msg, sizeof(msg_copy)));
+
+	if (size_mul_overflow(msg_copy.msg_iovlen, sizeof(struct iovec),
+			      &iov_size)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* The data is written directly to the user buffers once they are
+	 * known to be writable, only the iovec array is copied.
+	 */
+	iov = NULL;
+	if (iov_size > 0) {
+		iov = z_user_alloc_from_copy(msg_copy.msg_iov, iov_size);
+		if (!iov) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+	msg_copy.msg_iov = iov;
+
+	for (i = 0; i < msg_copy.msg_iovlen; i++) {
+		if (Z_SYSCALL_MEMORY_WRITE(iov[i].iov_base, iov[i].iov_len)) {
+			errno = EFAULT;
+			ret = -1;
+			goto out;
+		}
+	}
+
+	if ((msg_copy.msg_name &&
+	     Z_SYSCALL_MEMORY_WRITE(msg_copy.msg_name,
+				    msg_copy.msg_namelen)) ||
+	    (msg_copy.msg_control &&
+	     Z_SYSCALL_MEMORY_WRITE(msg_copy.msg_control,
+				    msg_copy.msg_controllen))) {
+		errno = EFAULT;
+		ret = -1;
+		goto out;
+	}
+
+	ret = z_impl_zsock_recvmsg(sock, &msg_copy, flags);
+
+out:
+	k_free(iov);
+
+	if (ret >= 0) {
+		msg->msg_namelen = msg_copy.msg_namelen;
+		msg->msg_controllen = msg_copy.msg_controllen;
+		msg->msg_flags = msg_copy.msg_flags;
+	}
+
+	return ret;
+}
+#include <syscalls/zsock_recvmsg_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
+int z_impl_zsock_sendmmsg(int sock, struct mmsghdr *msgvec, unsigned int vlen,
+			  int flags)
+{
+	const struct socket_op_vtable *vtable;
+	ssize_t ret = 0;
+	unsigned int i;
+	void *obj;
+
+	obj = get_sock_vtable(sock, &vtable);
+	if (obj == NULL || vtable->sendmsg == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	for (i = 0; i < vlen; i++) {
+		ret = vtable->sendmsg(obj, &msgvec[i].msg_hdr, flags);
+		if (ret < 0) {
+			break;
+		}
+
+		msgvec[i].msg_len = ret;
+	}
+
+	return (i == 0 && ret < 0) ? -1 : i;
+}
+
+#ifdef CONFIG_USERSPACE
+static inline int z_vrfy_zsock_sendmmsg(int sock, struct mmsghdr *msgvec,
+					unsigned int vlen, int flags)
+{
+	unsigned int len;
+	ssize_t ret = 0;
+	unsigned int i;
+
+	Z_OOPS(Z_SYSCALL_MEMORY_ARRAY_WRITE(msgvec, vlen,
+					    sizeof(struct mmsghdr)));
+
+	for (i = 0; i < vlen; i++) {
+		ret = z_vrfy_zsock_sendmsg(sock, &msgvec[i].msg_hdr, flags);
+		if (ret < 0) {
+			break;
+		}
+
+		len = ret;
+		Z_OOPS(z_user_to_copy(&msgvec[i].msg_len, &len, sizeof(len)));
+	}
+
+	return (i == 0 && ret < 0) ? -1 : i;
+}
+#include <syscalls/zsock_sendmmsg_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
+int z_impl_zsock_recvmmsg(int sock, struct mmsghdr *msgvec, unsigned int vlen,
+			  int flags)
+{
+	const struct socket_op_vtable *vtable;
+	ssize_t ret = 0;
+	unsigned int i;
+	void *obj;
+
+	obj = get_sock_vtable(sock, &vtable);
+	if (obj == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	for (i = 0; i < vlen; i++) {
+		ret = sock_recvmsg(obj, vtable, &msgvec[i].msg_hdr, flags);
+		if (ret < 0) {
+			break;
+		}
+
+		msgvec[i].msg_len = ret;
+
+		if (flags & ZSOCK_MSG_WAITFORONE) {
+			flags |= ZSOCK_MSG_DONTWAIT;
+		}
+	}
+
+	return (i == 0 && ret < 0) ? -1 : i;
+}
+
+#ifdef CONFIG_USERSPACE
+static inline int z_vrfy_zsock_recvmmsg(int sock, struct mmsghdr *msgvec,
+					unsigned int vlen, int flags)
+{
+	unsigned int len;
+	ssize_t ret = 0;
+	unsigned int i;
+
+	Z_OOPS(Z_SYSCALL_MEMORY_ARRAY_WRITE(msgvec, vlen,
+					    sizeof(struct mmsghdr)));
+
+	for (i = 0; i < vlen; i++) {
+		ret = z_vrfy_zsock_recvmsg(sock, &msgvec[i].msg_hdr, flags);
+		if (ret < 0) {
+			break;
+		}
+
+		len = ret;
+		Z_OOPS(z_user_to_copy(&msgvec[i].msg_len, &len, sizeof(len)));
+
+		if (flags & ZSOCK_MSG_WAITFORONE) {
+			flags |= ZSOCK_MSG_DONTWAIT;
+		}
+	}
+
+	return (i == 0 && ret < 0) ? -1 : i;
+}
+#include <syscalls/zsock_recvmmsg_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
+/* As this is limited function, we don't follow POSIX signature, with
+ * "..." instead of last arg.
+ */
+int z_impl_zsock_fcntl(int sock, int cmd, int flags)
+{
+	const struct socket_op_vtable *vtable;
+	void *obj;
+
+	obj = get_sock_vtable(sock, &vtable);
+	if (obj == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	return z_fdtable_call_ioctl((const struct fd_op_vtable *)vtable,
+				    obj, cmd, flags);
+}
+
+#ifdef CONFIG_USERSPACE
+static inline int z_vrfy_zsock_fcntl(int sock, int cmd, int flags)
+{
+	return z_impl_zsock_fcntl(sock, cmd, flags);
+}
+#include <syscalls/zsock_fcntl_mrsh.c>
+#endif
+
+static int zsock_poll_prepare_ctx(struct net_context *ctx,
+				  struct zsock_pollfd *pfd,
+				  struct k_poll_event **pev,
+				  struct k_poll_event *pev_end)
+{
+	if (pfd->events & ZSOCK_POLLIN) {
+		if (*pev == pev_end) {
 			return -ENOMEM;
 		}
 
@@ -1171,7 +1866,19 @@ static int zsock_poll_prepare_ctx(struct net_context *ctx,
 	}
 
 	if (pfd->events & ZSOCK_POLLOUT) {
-		return -EALREADY;
+		struct k_sem *tx_sem = sock_tx_sem(ctx);
+
+		if (tx_sem == NULL) {
+			return -EALREADY;
+		}
+
+		if (*pev == pev_end) {
+			return -ENOMEM;
+		}
+
+		k_poll_event_init(*pev, K_POLL_TYPE_SEM_AVAILABLE,
+				  K_POLL_MODE_NOTIFY_ONLY, tx_sem);
+		(*pev)++;
 	}
 
 	/* If socket is already in EOF, it can be reported
@@ -1188,13 +1895,6 @@ static int zsock_poll_update_ctx(struct net_context *ctx,
 				 struct zsock_pollfd *pfd,
 				 struct k_poll_event **pev)
 {
-	ARG_UNUSED(ctx);
-
-	/* For now, assume that socket is always writable */
-	if (pfd->events & ZSOCK_POLLOUT) {
-		pfd->revents |= ZSOCK_POLLOUT;
-	}
-
 	if (pfd->events & ZSOCK_POLLIN) {
 		if ((*pev)->state != K_POLL_STATE_NOT_READY || sock_is_eof(ctx)) {
 			pfd->revents |= ZSOCK_POLLIN;
@@ -1202,9 +1902,43 @@ static int zsock_poll_update_ctx(struct net_context *ctx,
 		(*pev)++;
 	}
 
+	if (pfd->events & ZSOCK_POLLOUT) {
+		if (sock_tx_sem(ctx) == NULL) {
+			pfd->revents |= ZSOCK_POLLOUT;
+		} else {
+			if ((*pev)->state != K_POLL_STATE_NOT_READY ||
+			    sock_is_eof(ctx)) {
+				pfd->revents |= ZSOCK_POLLOUT;
+			}
+			(*pev)++;
+		}
+	}
+
 	return 0;
 }
 
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+static int zsock_poll_ready_ctx(struct net_context *ctx)
+{
+	struct k_sem *tx_sem = sock_tx_sem(ctx);
+	int events = 0;
+
+	if (tx_sem == NULL || k_sem_count_get(tx_sem) > 0) {
+		events |= ZSOCK_POLLOUT;
+	}
+
+	if (!k_fifo_is_empty(&ctx->recv_q) || sock_is_eof(ctx)) {
+		events |= ZSOCK_POLLIN;
+	}
+
+	if (sock_is_eof(ctx) && net_context_get_type(ctx) == SOCK_STREAM) {
+		events |= ZSOCK_POLLHUP;
+	}
+
+	return events;
+}
+#endif
+
 static inline int time_left(uint32_t start, uint32_t timeout)
 {
 	uint32_t elapsed = k_uptime_get_32() - start;
@@ -1443,6 +2177,19 @@ static inline int z_vrfy_zsock_inet_pton(sa_family_t family,
 #include <syscalls/zsock_inet_pton_mrsh.c>
 #endif
 
+static int sock_get_recv_flag(struct net_context *ctx, uintptr_t flag,
+			      void *optval, socklen_t *optlen)
+{
+	if (*optlen != sizeof(int)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*(int *)optval = sock_get_flag(ctx, flag) ? 1 : 0;
+
+	return 0;
+}
+
 int zsock_getsockopt_ctx(struct net_context *ctx, int level, int optname,
 			 void *optval, socklen_t *optlen)
 {
@@ -1451,6 +2198,17 @@ int zsock_getsockopt_ctx(struct net_context *ctx, int level, int optname,
 	switch (level) {
 	case SOL_SOCKET:
 		switch (optname) {
+#if defined(CONFIG_NET_SOCKETS_ZEROCOPY)
+		case SO_ZEROCOPY_DONE:
+			if (*optlen != sizeof(int)) {
+				errno = EINVAL;
+				return -1;
+			}
+
+			*(int *)optval = atomic_get(&ctx->zerocopy_done);
+
+			return 0;
+#endif
 		case SO_TXTIME:
 			if (IS_ENABLED(CONFIG_NET_CONTEXT_TXTIME)) {
 				ret = net_context_get_option(ctx,
@@ -1465,6 +2223,24 @@ int zsock_getsockopt_ctx(struct net_context *ctx, int level, int optname,
 			}
 		}
 
+		break;
+
+	case IPPROTO_IP:
+		switch (optname) {
+		case IP_PKTINFO:
+			return sock_get_recv_flag(ctx, SOCK_RECV_PKTINFO,
+						  optval, optlen);
+		}
+
+		break;
+
+	case IPPROTO_IPV6:
+		switch (optname) {
+		case IPV6_RECVPKTINFO:
+			return sock_get_recv_flag(ctx, SOCK_RECV_PKTINFO,
+						  optval, optlen);
+		}
+
 		break;
 	}
 
@@ -1509,6 +2285,59 @@ int z_vrfy_zsock_getsockopt(int sock, int level, int optname,
 #include <syscalls/zsock_getsockopt_mrsh.c>
 #endif /* CONFIG_USERSPACE */
 
+static int sock_set_recv_flag(struct net_context *ctx, uintptr_t flag,
+			      const void *optval, socklen_t optlen)
+{
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	sock_set_flag(ctx, flag, *(int *)optval ? flag : 0);
+
+	return 0;
+}
+
+static int sock_set_timestamping(struct net_context *ctx,
+				 const void *optval, socklen_t optlen)
+{
+	bool tx;
+	int flags;
+
+	/* A bool only enables TX timestamps, for compatibility */
+	if (optlen == sizeof(int)) {
+		flags = *(int *)optval;
+	} else if (optlen == sizeof(bool)) {
+		flags = *(bool *)optval ? SOF_TIMESTAMPING_TX_HARDWARE : 0;
+	} else {
+		return -EINVAL;
+	}
+
+	tx = flags & SOF_TIMESTAMPING_TX_HARDWARE;
+
+	if ((tx && !IS_ENABLED(CONFIG_NET_CONTEXT_TIMESTAMP)) ||
+	    ((flags & SOF_TIMESTAMPING_RX_HARDWARE) &&
+	     !IS_ENABLED(CONFIG_NET_PKT_TIMESTAMP))) {
+		return -ENOPROTOOPT;
+	}
+
+	/* Calculate TX network packet timings */
+	if (IS_ENABLED(CONFIG_NET_CONTEXT_TIMESTAMP)) {
+		int ret;
+
+		ret = net_context_set_option(ctx, NET_OPT_TIMESTAMP,
+					     &tx, sizeof(tx));
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	sock_set_flag(ctx, SOCK_RECV_TIMESTAMP,
+		      (flags & SOF_TIMESTAMPING_RX_HARDWARE) ?
+		      SOCK_RECV_TIMESTAMP : 0);
+
+	return 0;
+}
+
 int zsock_setsockopt_ctx(struct net_context *ctx, int level, int optname,
 			 const void *optval, socklen_t optlen)
 {
@@ -1539,20 +2368,13 @@ int zsock_setsockopt_ctx(struct net_context *ctx, int level, int optname,
 			break;
 
 		case SO_TIMESTAMPING:
-			/* Calculate TX network packet timings */
-			if (IS_ENABLED(CONFIG_NET_CONTEXT_TIMESTAMP)) {
-				ret = net_context_set_option(ctx,
-							     NET_OPT_TIMESTAMP,
-							     optval, optlen);
-				if (ret < 0) {
-					errno = -ret;
-					return -1;
-				}
-
-				return 0;
+			ret = sock_set_timestamping(ctx, optval, optlen);
+			if (ret < 0) {
+				errno = -ret;
+				return -1;
 			}
 
-			break;
+			return 0;
 
 		case SO_TXTIME:
 			if (IS_ENABLED(CONFIG_NET_CONTEXT_TXTIME)) {
@@ -1599,6 +2421,20 @@ int zsock_setsockopt_ctx(struct net_context *ctx, int level, int optname,
 		}
 		break;
 
+	case IPPROTO_IP:
+		switch (optname) {
+		case IP_PKTINFO:
+			ret = sock_set_recv_flag(ctx, SOCK_RECV_PKTINFO,
+						 optval, optlen);
+			if (ret < 0) {
+				errno = -ret;
+				return -1;
+			}
+
+			return 0;
+		}
+		break;
+
 	case IPPROTO_IPV6:
 		switch (optname) {
 		case IPV6_V6ONLY:
@@ -1606,6 +2442,16 @@ int zsock_setsockopt_ctx(struct net_context *ctx, int level, int optname,
 			 * existing apps.
 			 */
 			return 0;
+
+		case IPV6_RECVPKTINFO:
+			ret = sock_set_recv_flag(ctx, SOCK_RECV_PKTINFO,
+						 optval, optlen);
+			if (ret < 0) {
+				errno = -ret;
+				return -1;
+			}
+
+			return 0;
 		}
 		break;
 	}
@@ -1784,6 +2630,19 @@ static int sock_ioctl_vmeth(void *obj, unsigned int request, va_list args)
 		return zsock_poll_update_ctx(obj, pfd, pev);
 	}
 
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+	case ZFD_IOCTL_POLL_READY:
+		return zsock_poll_ready_ctx(obj);
+
+	case ZFD_IOCTL_POLL_NOTIFY: {
+		struct net_context *ctx = obj;
+
+		z_fd_notifier_attach(&ctx->poll_notifiers,
+				     va_arg(args, struct zfd_notifier *));
+		return 0;
+	}
+#endif
+
 	default:
 		errno = EOPNOTSUPP;
 		return -1;
@@ -1834,6 +2693,11 @@ static ssize_t sock_recvfrom_vmeth(void *obj, void *buf, size_t max_len,
 				  src_addr, addrlen);
 }
 
+static ssize_t sock_recvmsg_vmeth(void *obj, struct msghdr *msg, int flags)
+{
+	return zsock_recvmsg_ctx(obj, msg, flags);
+}
+
 static int sock_getsockopt_vmeth(void *obj, int level, int optname,
 				 void *optval, socklen_t *optlen)
 {
@@ -1871,6 +2735,7 @@ const struct socket_op_vtable sock_fd_op_vtable = {
 	.sendto = sock_sendto_vmeth,
 	.sendmsg = sock_sendmsg_vmeth,
 	.recvfrom = sock_recvfrom_vmeth,
+	.recvmsg = sock_recvmsg_vmeth,
 	.getsockopt = sock_getsockopt_vmeth,
 	.setsockopt = sock_setsockopt_vmeth,
 	.getsockname = sock_getsockname_vmeth,
@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_sock_epoll, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <kernel.h>
+#include <net/socket.h>
+#include <syscall_handler.h>
+#include <sys/fdtable.h>
+
+#include "sockets_internal.h"
+
+/* Events which are always reported, whether requested or not */
+#define EPOLL_ALWAYS_EVENTS (ZSOCK_EPOLLERR | ZSOCK_EPOLLHUP)
+
+struct epoll_instance;
+
+/* A file descriptor registered with an epoll instance. The notifier is
+ * attached to the object behind the file descriptor, which calls it when
+ * the object may have become ready. The item is then queued on the ready
+ * list of the instance, and a wait only checks the queued items.
+ */
+struct epoll_item {
+	struct zfd_notifier notifier;
+	sys_dnode_t ready_node;
+	struct epoll_instance *ep;
+	void *obj;
+	const struct fd_op_vtable *vtable;
+	int fd;
+	uint32_t events;
+	zsock_epoll_data_t data;
+	/* Generation of the last wait which looked at the item */
+	uint32_t gen;
+	/* The fields below are protected by epoll_instance.ready_lock */
+	bool queued;
+	bool closed;
+	bool armed;
+};
+
+__net_socket struct epoll_instance {
+	/* Serializes epoll_ctl() and the collection of the ready items */
+	struct k_mutex lock;
+	struct k_spinlock ready_lock;
+	sys_dlist_t ready;
+	struct k_sem ready_sem;
+	struct epoll_item *by_fd[CONFIG_POSIX_MAX_FDS];
+	uint32_t gen;
+	bool in_use;
+};
+
+K_MEM_SLAB_DEFINE(epoll_items, sizeof(struct epoll_item),
+		  CONFIG_NET_SOCKETS_EPOLL_MAX_ITEMS, 4);
+
+static K_MUTEX_DEFINE(epoll_lock);
+static struct epoll_instance epoll_instances[CONFIG_NET_SOCKETS_EPOLL_MAX];
+
+static const struct fd_op_vtable epoll_fd_op_vtable;
+
+static bool epoll_obj_access(void *obj)
+{
+#ifdef CONFIG_USERSPACE
+	if (z_is_in_user_syscall()) {
+		struct z_object *zo;
+		int ret;
+
+		zo = z_object_find(obj);
+		ret = z_object_validate(zo, K_OBJ_NET_SOCKET, _OBJ_INIT_TRUE);
+		if (ret != 0) {
+			z_dump_object_error(ret, obj, zo, K_OBJ_NET_SOCKET);
+			return false;
+		}
+	}
+#else
+	ARG_UNUSED(obj);
+#endif /* CONFIG_USERSPACE */
+
+	return true;
+}
+
+static struct epoll_instance *epoll_get(int epfd)
+{
+	struct epoll_instance *ep;
+
+	ep = z_get_fd_obj(epfd, &epoll_fd_op_vtable, EINVAL);
+	if (ep == NULL) {
+		return NULL;
+	}
+
+	if (!epoll_obj_access(ep)) {
+		errno = EBADF;
+		return NULL;
+	}
+
+	return ep;
+}
+
+/* Queue an item on the ready list, ep->ready_lock must be held */
+static bool epoll_item_queue(struct epoll_instance *ep,
+			     struct epoll_item *item)
+{
+	if (item->queued) {
+		return false;
+	}
+
+	item->queued = true;
+	sys_dlist_append(&ep->ready, &item->ready_node);
+
+	return true;
+}
+
+static void epoll_notify_cb(struct zfd_notifier *notifier, uint32_t events)
+{
+	struct epoll_item *item = CONTAINER_OF(notifier, struct epoll_item,
+					       notifier);
+	struct epoll_instance *ep = item->ep;
+	k_spinlock_key_t key;
+	bool wake = false;
+
+	key = k_spin_lock(&ep->ready_lock);
+
+	if (events & ZFD_NOTIFY_CLOSE) {
+		/* Let the next wait drop the item */
+		item->closed = true;
+		wake = epoll_item_queue(ep, item);
+	} else if (item->armed &&
+		   (events & (item->events | EPOLL_ALWAYS_EVENTS))) {
+		wake = epoll_item_queue(ep, item);
+	}
+
+	k_spin_unlock(&ep->ready_lock, key);
+
+	if (wake) {
+		k_sem_give(&ep->ready_sem);
+	}
+}
+
+static void epoll_item_free(struct epoll_instance *ep,
+			    struct epoll_item *item)
+{
+	k_spinlock_key_t key;
+
+	/* Once detached, the notifier is not called anymore */
+	z_fd_notifier_detach(&item->notifier);
+
+	key = k_spin_lock(&ep->ready_lock);
+
+	if (item->queued) {
+		sys_dlist_remove(&item->ready_node);
+		item->queued = false;
+	}
+
+	k_spin_unlock(&ep->ready_lock, key);
+
+	if (ep->by_fd[item->fd] == item) {
+		ep->by_fd[item->fd] = NULL;
+	}
+
+	k_mem_slab_free(&epoll_items, (void **)&item);
+}
+
+/* Return the item registered for fd, or NULL if there is none. An item
+ * whose file descriptor was closed, and maybe reused, is freed.
+ */
+static struct epoll_item *epoll_item_find(struct epoll_instance *ep,
+					  int fd, void *obj)
+{
+	struct epoll_item *item = ep->by_fd[fd];
+
+	if (item != NULL && (item->closed || item->obj != obj)) {
+		epoll_item_free(ep, item);
+		item = NULL;
+	}
+
+	return item;
+}
+
+static int epoll_item_add(struct epoll_instance *ep, int fd, void *obj,
+			  const struct fd_op_vtable *vtable,
+			  const struct zsock_epoll_event *event)
+{
+	struct epoll_item *item;
+	k_spinlock_key_t key;
+	int ret;
+
+	if (k_mem_slab_alloc(&epoll_items, (void **)&item, K_NO_WAIT) < 0) {
+		return -ENOMEM;
+	}
+
+	memset(item, 0, sizeof(*item));
+	item->notifier.cb = epoll_notify_cb;
+	item->ep = ep;
+	item->obj = obj;
+	item->vtable = vtable;
+	item->fd = fd;
+	item->events = event->events;
+	item->data = event->data;
+	item->gen = ep->gen;
+	item->armed = true;
+
+	ret = z_fdtable_call_ioctl(vtable, obj, ZFD_IOCTL_POLL_NOTIFY,
+				   &item->notifier);
+	if (ret < 0) {
+		/* The object cannot notify its readiness */
+		k_mem_slab_free(&epoll_items, (void **)&item);
+		return -EPERM;
+	}
+
+	ep->by_fd[fd] = item;
+
+	/* The object may already be ready, let the next wait check it */
+	key = k_spin_lock(&ep->ready_lock);
+	(void)epoll_item_queue(ep, item);
+	k_spin_unlock(&ep->ready_lock, key);
+
+	k_sem_give(&ep->ready_sem);
+
+	return 0;
+}
+
+static int epoll_item_mod(struct epoll_instance *ep, struct epoll_item *item,
+			  const struct zsock_epoll_event *event)
+{
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&ep->ready_lock);
+
+	item->events = event->events;
+	item->data = event->data;
+	item->armed = true;
+	(void)epoll_item_queue(ep, item);
+
+	k_spin_unlock(&ep->ready_lock, key);
+
+	k_sem_give(&ep->ready_sem);
+
+	return 0;
+}
+
+/* Report the ready items, ep->lock must be held. Only the queued items
+ * are checked, the items which stay ready in level-triggered mode are
+ * queued again for the next wait.
+ */
+static int epoll_collect(struct epoll_instance *ep,
+			 struct zsock_epoll_event *events, int maxevents)
+{
+	struct epoll_item *item;
+	k_spinlock_key_t key;
+	sys_dlist_t requeue;
+	sys_dnode_t *node;
+	int count = 0;
+	int ready;
+
+	sys_dlist_init(&requeue);
+	ep->gen++;
+
+	key = k_spin_lock(&ep->ready_lock);
+
+	while (count < maxevents &&
+	       (node = sys_dlist_get(&ep->ready)) != NULL) {
+		item = CONTAINER_OF(node, struct epoll_item, ready_node);
+		item->queued = false;
+
+		if (item->closed) {
+			k_spin_unlock(&ep->ready_lock, key);
+			epoll_item_free(ep, item);
+			key = k_spin_lock(&ep->ready_lock);
+			continue;
+		}
+
+		if (item->gen == ep->gen) {
+			/* Notified again after it was checked by this wait,
+			 * leave it for the next one.
+			 */
+			item->queued = true;
+			sys_dlist_append(&requeue, node);
+			continue;
+		}
+
+		if (!item->armed) {
+			continue;
+		}
+
+		item->gen = ep->gen;
+
+		/* The object may be closed once the lock is released, the
+		 * readiness is only read while it is still watched.
+		 */
+		k_spin_unlock(&ep->ready_lock, key);
+		ready = z_fd_notifier_poll_ready(&item->notifier, item->vtable,
+						 item->obj);
+		key = k_spin_lock(&ep->ready_lock);
+
+		if (ready < 0) {
+			ready = ZSOCK_EPOLLERR;
+		}
+
+		ready &= item->events | EPOLL_ALWAYS_EVENTS;
+		if (ready == 0 || !item->armed || item->closed) {
+			continue;
+		}
+
+		events[count].events = ready;
+		events[count].data = item->data;
+		count++;
+
+		if (item->events & ZSOCK_EPOLLONESHOT) {
+			item->armed = false;
+		} else if (!(item->events & ZSOCK_EPOLLET)) {
+			/* Still ready until proven otherwise */
+			if (!item->queued) {
+				item->queued = true;
+				sys_dlist_append(&requeue, node);
+			}
+		}
+	}
+
+	while ((node = sys_dlist_get(&requeue)) != NULL) {
+		sys_dlist_append(&ep->ready, node);
+	}
+
+	k_spin_unlock(&ep->ready_lock, key);
+
+	return count;
+}
+
+int z_impl_zsock_epoll_create(int flags)
+{
+	struct epoll_instance *ep = NULL;
+	int fd;
+	int i;
+
+	if (flags != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	k_mutex_lock(&epoll_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(epoll_instances); i++) {
+		if (!epoll_instances[i].in_use) {
+			ep = &epoll_instances[i];
+			break;
+		}
+	}
+
+	if (ep == NULL) {
+		k_mutex_unlock(&epoll_lock);
+		errno = EMFILE;
+		return -1;
+	}
+
+	fd = z_reserve_fd();
+	if (fd < 0) {
+		k_mutex_unlock(&epoll_lock);
+		return -1;
+	}
+
+	memset(ep, 0, sizeof(*ep));
+	k_mutex_init(&ep->lock);
+	sys_dlist_init(&ep->ready);
+	k_sem_init(&ep->ready_sem, 0, 1);
+	ep->in_use = true;
+
+	z_finalize_fd(fd, ep, &epoll_fd_op_vtable);
+
+	k_mutex_unlock(&epoll_lock);
+
+	LOG_DBG("epoll_create: ep=%p, fd=%d", ep, fd);
+
+	return fd;
+}
+
+#ifdef CONFIG_USERSPACE
+static inline int z_vrfy_zsock_epoll_create(int flags)
+{
+	return z_impl_zsock_epoll_create(flags);
+}
+#include <syscalls/zsock_epoll_create_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
+int z_impl_zsock_epoll_ctl(int epfd, int op, int fd,
+			   struct zsock_epoll_event *event)
+{
+	const struct fd_op_vtable *vtable;
+	struct epoll_instance *ep;
+	struct epoll_item *item;
+	void *obj;
+	int ret;
+
+	ep = epoll_get(epfd);
+	if (ep == NULL) {
+		return -1;
+	}
+
+	obj = z_get_fd_obj_and_vtable(fd, &vtable);
+	if (obj == NULL) {
+		return -1;
+	}
+
+	if (!epoll_obj_access(obj)) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (obj == (void *)ep) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (op != ZSOCK_EPOLL_CTL_DEL && event == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	k_mutex_lock(&ep->lock, K_FOREVER);
+
+	item = epoll_item_find(ep, fd, obj);
+
+	switch (op) {
+	case ZSOCK_EPOLL_CTL_ADD:
+		if (item != NULL) {
+			ret = -EEXIST;
+		} else {
+			ret = epoll_item_add(ep, fd, obj, vtable, event);
+		}
+		break;
+
+	case ZSOCK_EPOLL_CTL_MOD:
+		if (item == NULL) {
+			ret = -ENOENT;
+		} else {
+			ret = epoll_item_mod(ep, item, event);
+		}
+		break;
+
+	case ZSOCK_EPOLL_CTL_DEL:
+		if (item == NULL) {
+			ret = -ENOENT;
+		} else {
+			epoll_item_free(ep, item);
+			ret = 0;
+		}
+		break;
+
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	k_mutex_unlock(&ep->lock);
+
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_USERSPACE
+static inline int z_vrfy_zsock_epoll_ctl(int epfd, int op, int fd,
+					 struct zsock_epoll_event *event)
+{
+	struct zsock_epoll_event event_copy;
+
+	if (event == NULL) {
+		return z_impl_zsock_epoll_ctl(epfd, op, fd, NULL);
+	}
+
+	Z_OOPS(z_user_from_copy(&event_copy, event, sizeof(event_copy)));
+
+	return z_impl_zsock_epoll_ctl(epfd, op, fd, &event_copy);
+}
+#include <syscalls/zsock_epoll_ctl_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
+int z_impl_zsock_epoll_wait(int epfd, struct zsock_epoll_event *events,
+			    int maxevents, int timeout)
+{
+	struct epoll_instance *ep;
+	k_timeout_t wait;
+	uint64_t end;
+	int ret;
+
+	ep = epoll_get(epfd);
+	if (ep == NULL) {
+		return -1;
+	}
+
+	if (maxevents <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (timeout < 0) {
+		wait = K_FOREVER;
+	} else {
+		wait = K_MSEC(timeout);
+	}
+
+	end = z_timeout_end_calc(wait);
+
+	while (true) {
+		k_mutex_lock(&ep->lock, K_FOREVER);
+		ret = epoll_collect(ep, events, maxevents);
+		k_mutex_unlock(&ep->lock);
+
+		if (ret > 0 || K_TIMEOUT_EQ(wait, K_NO_WAIT)) {
+			break;
+		}
+
+		if (!K_TIMEOUT_EQ(wait, K_FOREVER)) {
+			int64_t remaining = end - z_tick_get();
+
+			if (remaining <= 0) {
+				break;
+			}
+
+			wait = Z_TIMEOUT_TICKS(remaining);
+		}
+
+		if (k_sem_take(&ep->ready_sem, wait) < 0) {
+			/* Pick up what was queued while timing out */
+			wait = K_NO_WAIT;
+		}
+	}
+
+	return ret;
+}
+
+#ifdef CONFIG_USERSPACE
+static inline int z_vrfy_zsock_epoll_wait(int epfd,
+					  struct zsock_epoll_event *events,
+					  int maxevents, int timeout)
+{
+	if (maxevents > 0) {
+		Z_OOPS(Z_SYSCALL_MEMORY_ARRAY_WRITE(events, maxevents,
+					sizeof(struct zsock_epoll_event)));
+	}
+
+	return z_impl_zsock_epoll_wait(epfd, events, maxevents, timeout);
+}
+#include <syscalls/zsock_epoll_wait_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
+static ssize_t epoll_read_vmeth(void *obj, void *buffer, size_t count)
+{
+	ARG_UNUSED(obj);
+	ARG_UNUSED(buffer);
+	ARG_UNUSED(count);
+
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t epoll_write_vmeth(void *obj, const void *buffer, size_t count)
+{
+	ARG_UNUSED(obj);
+	ARG_UNUSED(buffer);
+	ARG_UNUSED(count);
+
+	errno = EINVAL;
+	return -1;
+}
+
+static int epoll_ioctl_vmeth(void *obj, unsigned int request, va_list args)
+{
+	ARG_UNUSED(obj);
+	ARG_UNUSED(request);
+	ARG_UNUSED(args);
+
+	errno = EOPNOTSUPP;
+	return -1;
+}
+
+static int epoll_close_vmeth(void *obj)
+{
+	struct epoll_instance *ep = obj;
+	int i;
+
+	k_mutex_lock(&ep->lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(ep->by_fd); i++) {
+		if (ep->by_fd[i] != NULL) {
+			epoll_item_free(ep, ep->by_fd[i]);
+		}
+	}
+
+	k_mutex_unlock(&ep->lock);
+
+	k_mutex_lock(&epoll_lock, K_FOREVER);
+	ep->in_use = false;
+	k_mutex_unlock(&epoll_lock);
+
+	return 0;
+}
+
+static const struct fd_op_vtable epoll_fd_op_vtable = {
+	.read = epoll_read_vmeth,
+	.write = epoll_write_vmeth,
+	.close = epoll_close_vmeth,
+	.ioctl = epoll_ioctl_vmeth,
+};
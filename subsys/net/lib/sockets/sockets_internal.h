@@ -11,6 +11,8 @@
 
 #define SOCK_EOF 1
 #define SOCK_NONBLOCK 2
+#define SOCK_RECV_PKTINFO 4
+#define SOCK_RECV_TIMESTAMP 8
 
 static inline void sock_set_flag(struct net_context *ctx, uintptr_t mask,
 				 uintptr_t flag)
@@ -40,6 +42,39 @@ static inline bool net_socket_is_tls(void *obj)
 }
 #endif
 
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+static inline void sock_notify_init(struct net_context *ctx)
+{
+	sys_dlist_init(&ctx->poll_notifiers);
+}
+
+static inline void sock_notify(struct net_context *ctx, uint32_t events)
+{
+	z_fd_notify(&ctx->poll_notifiers, events);
+}
+
+static inline void sock_notify_close(struct net_context *ctx)
+{
+	z_fd_notify_close(&ctx->poll_notifiers);
+}
+#else
+static inline void sock_notify_init(struct net_context *ctx)
+{
+	ARG_UNUSED(ctx);
+}
+
+static inline void sock_notify(struct net_context *ctx, uint32_t events)
+{
+	ARG_UNUSED(ctx);
+	ARG_UNUSED(events);
+}
+
+static inline void sock_notify_close(struct net_context *ctx)
+{
+	ARG_UNUSED(ctx);
+}
+#endif
+
 #define sock_is_eof(ctx) sock_get_flag(ctx, SOCK_EOF)
 #define sock_set_eof(ctx) sock_set_flag(ctx, SOCK_EOF, SOCK_EOF)
 #define sock_is_nonblock(ctx) sock_get_flag(ctx, SOCK_NONBLOCK)
@@ -60,6 +95,7 @@ struct socket_op_vtable {
 	int (*setsockopt)(void *obj, int level, int optname,
 			  const void *optval, socklen_t optlen);
 	ssize_t (*sendmsg)(void *obj, const struct msghdr *msg, int flags);
+	ssize_t (*recvmsg)(void *obj, struct msghdr *msg, int flags);
 	int (*getsockname)(void *obj, struct sockaddr *addr,
 			   socklen_t *addrlen);
 };
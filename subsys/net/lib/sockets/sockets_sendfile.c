@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_sock_sendfile, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <fcntl.h>
+#include <kernel.h>
+#include <fs/fs.h>
+#include <net/net_context.h>
+#include <net/socket.h>
+#include <sys/fdtable.h>
+
+#include "sockets_internal.h"
+
+#define CHUNK_SIZE CONFIG_NET_SOCKETS_SENDFILE_CHUNK_SIZE
+
+extern const struct socket_op_vtable sock_fd_op_vtable;
+
+/* The file is read into these chunks, which are then attached to the
+ * network packets without copying. A chunk is free again once the stack
+ * has released it, i.e. once TCP got the data acknowledged, and the next
+ * chunks are read while the previous ones are in flight.
+ */
+K_MEM_SLAB_DEFINE(sendfile_chunks, CHUNK_SIZE,
+		  CONFIG_NET_SOCKETS_SENDFILE_CHUNKS, 4);
+
+static void sendfile_chunk_release(struct net_context *ctx, const void *buf,
+				   void *user_data)
+{
+	void *chunk = (void *)buf;
+
+	ARG_UNUSED(ctx);
+	ARG_UNUSED(user_data);
+
+	k_mem_slab_free(&sendfile_chunks, &chunk);
+}
+
+/* Move the file position back over data which was read but not sent */
+static void sendfile_unread(const struct fd_op_vtable *in_vtable,
+			    void *in_obj, size_t len)
+{
+	(void)z_fdtable_call_ioctl(in_vtable, in_obj, ZFD_IOCTL_LSEEK,
+				   -(off_t)len, FS_SEEK_CUR);
+}
+
+static ssize_t sendfile_zerocopy(struct net_context *ctx,
+				 const struct fd_op_vtable *in_vtable,
+				 void *in_obj, size_t count)
+{
+	k_timeout_t timeout = K_FOREVER;
+	size_t sent = 0;
+	void *chunk;
+	ssize_t len;
+	int ret = 0;
+
+	if (sock_is_nonblock(ctx)) {
+		timeout = K_NO_WAIT;
+	}
+
+	while (sent < count) {
+		if (k_mem_slab_alloc(&sendfile_chunks, &chunk, timeout) < 0) {
+			ret = -EAGAIN;
+			break;
+		}
+
+		len = in_vtable->read(in_obj, chunk, MIN(count - sent,
+							 CHUNK_SIZE));
+		if (len <= 0) {
+			k_mem_slab_free(&sendfile_chunks, &chunk);
+			ret = len < 0 ? -errno : 0;
+			break;
+		}
+
+		/* TCP queues the whole chunk or nothing, once the send
+		 * window has room for more data.
+		 */
+		ret = net_context_sendto_zerocopy(ctx, chunk, len, NULL, 0,
+						  sendfile_chunk_release,
+						  timeout, NULL);
+		if (ret < 0) {
+			k_mem_slab_free(&sendfile_chunks, &chunk);
+			sendfile_unread(in_vtable, in_obj, len);
+			break;
+		}
+
+		sent += len;
+	}
+
+	if (sent == 0 && ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return sent;
+}
+
+static ssize_t sendfile_copy(const struct socket_op_vtable *vtable,
+			     void *obj, const struct fd_op_vtable *in_vtable,
+			     void *in_obj, size_t count)
+{
+	k_timeout_t timeout = K_FOREVER;
+	size_t sent = 0;
+	uint8_t *chunk;
+	ssize_t len;
+	ssize_t ret = 0;
+	size_t pos;
+	int flags;
+
+	flags = z_fdtable_call_ioctl(&vtable->fd_vtable, obj, F_GETFL);
+	if (flags > 0 && (flags & O_NONBLOCK)) {
+		timeout = K_NO_WAIT;
+	}
+
+	if (k_mem_slab_alloc(&sendfile_chunks, (void **)&chunk,
+			     timeout) < 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	while (sent < count) {
+		len = in_vtable->read(in_obj, chunk, MIN(count - sent,
+							 CHUNK_SIZE));
+		if (len <= 0) {
+			ret = len;
+			break;
+		}
+
+		for (pos = 0; pos < len; pos += ret) {
+			ret = vtable->sendto(obj, chunk + pos, len - pos, 0,
+					     NULL, 0);
+			if (ret < 0) {
+				sendfile_unread(in_vtable, in_obj, len - pos);
+				sent += pos;
+				goto out;
+			}
+		}
+
+		sent += len;
+	}
+
+out:
+	k_mem_slab_free(&sendfile_chunks, (void **)&chunk);
+
+	if (sent == 0 && ret < 0) {
+		return -1;
+	}
+
+	return sent;
+}
+
+ssize_t zsock_sendfile(int sock, int in_fd, off_t *offset, size_t count)
+{
+	const struct fd_op_vtable *in_vtable;
+	const struct socket_op_vtable *vtable;
+	void *in_obj;
+	void *obj;
+	off_t pos = 0;
+	ssize_t sent;
+	int err;
+
+	obj = z_get_fd_obj_and_vtable(sock,
+				      (const struct fd_op_vtable **)&vtable);
+	if (obj == NULL) {
+		return -1;
+	}
+
+	in_obj = z_get_fd_obj_and_vtable(in_fd, &in_vtable);
+	if (in_obj == NULL) {
+		return -1;
+	}
+
+	if (offset != NULL) {
+		/* Read from the offset, then restore the file position */
+		pos = z_fdtable_call_ioctl(in_vtable, in_obj, ZFD_IOCTL_LSEEK,
+					   (off_t)0, FS_SEEK_CUR);
+		if (pos < 0) {
+			errno = ESPIPE;
+			return -1;
+		}
+
+		if (z_fdtable_call_ioctl(in_vtable, in_obj, ZFD_IOCTL_LSEEK,
+					 *offset, FS_SEEK_SET) < 0) {
+			return -1;
+		}
+	}
+
+	if (vtable == &sock_fd_op_vtable &&
+	    net_context_get_type(obj) == SOCK_STREAM) {
+		sent = sendfile_zerocopy(obj, in_vtable, in_obj, count);
+	} else {
+		sent = sendfile_copy(vtable, obj, in_vtable, in_obj, count);
+	}
+
+	if (offset != NULL) {
+		err = errno;
+
+		if (sent > 0) {
+			*offset += sent;
+		}
+
+		(void)z_fdtable_call_ioctl(in_vtable, in_obj, ZFD_IOCTL_LSEEK,
+					   pos, FS_SEEK_SET);
+		errno = err;
+	}
+
+	return sent;
+}
@@ -13,6 +13,7 @@ LOG_MODULE_REGISTER(net_sock_tls, CONFIG_NET_SOCKETS_LOG_LEVEL);
 
 #include <init.h>
 #include <drivers/entropy.h>
+#include <sys/crc.h>
 #include <sys/util.h>
 #include <net/socket.h>
 #include <random/rand32.h>
@@ -34,6 +35,25 @@ LOG_MODULE_REGISTER(net_sock_tls, CONFIG_NET_SOCKETS_LOG_LEVEL);
 #include <mbedtls/ssl_cookie.h>
 #include <mbedtls/error.h>
 #include <mbedtls/debug.h>
+
+/* Servers issue session tickets with the ticket callbacks of mbedTLS,
+ * which only exist with MBEDTLS_SSL_SESSION_TICKETS.
+ */
+#if defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_SSL_SESSION_TICKETS) && \
+	defined(MBEDTLS_SSL_TICKET_C)
+#define TLS_SESSION_TICKETS
+#include <mbedtls/ssl_ticket.h>
+#endif
+
+/* Without MBEDTLS_THREADING_C, RSA private key operations are not
+ * thread-safe, as they update the blinding values of the key. The key is
+ * then wrapped so that the configurations holding it can be shared.
+ */
+#if defined(MBEDTLS_X509_CRT_PARSE_C) && defined(MBEDTLS_RSA_C) && \
+	defined(MBEDTLS_PK_RSA_ALT_SUPPORT) && !defined(MBEDTLS_THREADING_C)
+#define TLS_RSA_KEY_LOCK
+#include <mbedtls/rsa.h>
+#endif
 #endif /* CONFIG_MBEDTLS */
 
 #include "sockets_internal.h"
@@ -50,6 +70,94 @@ struct sec_tag_list {
 	int sec_tag_count;
 };
 
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+/** Certificates parsed from the credentials of a list of secure tags.
+ *  They are shared by the TLS contexts which use the same secure tags.
+ */
+struct tls_cert_cache {
+	/** Number of TLS contexts using the certificates. */
+	int refcount;
+
+	/** Information whether all the certificates were parsed. */
+	bool is_valid;
+
+	/** Credentials generation the certificates were parsed from. */
+	uint32_t generation;
+
+	/** Secure tags the certificates were parsed from. */
+	struct sec_tag_list sec_tag_list;
+
+	/** mbedTLS structure for CA chain. */
+	mbedtls_x509_crt ca_chain;
+
+	/** mbedTLS structure for own certificate. */
+	mbedtls_x509_crt own_cert;
+};
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
+/** Parameters an mbedTLS configuration is set up from. */
+struct tls_config_params {
+	/** Secure tags the credentials are taken from. */
+	struct sec_tag_list sec_tag_list;
+
+	/** 0-terminated list of allowed ciphersuites (mbedTLS format). */
+	int ciphersuites[CONFIG_NET_SOCKETS_TLS_MAX_CIPHERSUITES + 1];
+
+	/** mbedTLS endpoint, client or server. */
+	int8_t endpoint;
+
+	/** mbedTLS transport, stream or datagram. */
+	int8_t transport;
+
+	/** Peer verification level. */
+	int8_t verify_level;
+
+	/** Maximum fragment length (mbedTLS format). */
+	uint8_t mfl_code;
+
+	/** Information whether session tickets are issued. */
+	bool tickets;
+};
+
+/** mbedTLS configuration and the credentials it refers to. It is shared by
+ *  the TLS contexts which use the same parameters.
+ */
+struct tls_config_cache {
+	/** Number of TLS contexts using the configuration. */
+	int refcount;
+
+	/** Information whether the configuration was set up. */
+	bool is_valid;
+
+	/** Information whether other TLS contexts may use the configuration. */
+	bool is_shared;
+
+	/** Credentials generation the configuration was set up from. */
+	uint32_t generation;
+
+	/** Parameters the configuration was set up from. */
+	struct tls_config_params params;
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	/** Certificates used by the configuration. */
+	struct tls_cert_cache *certs;
+
+	/** mbedTLS structure for own private key. */
+	mbedtls_pk_context priv_key;
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
+#if defined(TLS_RSA_KEY_LOCK)
+	/** RSA private key wrapper given to mbedTLS, taking key_lock. */
+	mbedtls_pk_context rsa_key;
+
+	/** Serializes the operations with the RSA private key. */
+	struct k_mutex key_lock;
+#endif
+
+	/** mbedTLS configuration. */
+	mbedtls_ssl_config config;
+};
+
 /** Timer context for DTLS. */
 struct dtls_timing_context {
 	/** Current time, stored during timer set. */
@@ -109,6 +217,12 @@ struct tls_context {
 
 		/** DTLS role, client by default. */
 		int8_t role;
+
+		/** Information if TLS session caching is enabled. */
+		bool cache_enabled;
+
+		/** Maximum fragment length (mbedTLS format). */
+		uint8_t mfl_code;
 	} options;
 
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
@@ -129,20 +243,8 @@ struct tls_context {
 	/** mbedTLS context. */
 	mbedtls_ssl_context ssl;
 
-	/** mbedTLS configuration. */
-	mbedtls_ssl_config config;
-
-#if defined(MBEDTLS_X509_CRT_PARSE_C)
-	/** mbedTLS structure for CA chain. */
-	mbedtls_x509_crt ca_chain;
-
-	/** mbedTLS structure for own certificate. */
-	mbedtls_x509_crt own_cert;
-
-	/** mbedTLS structure for own private key. */
-	mbedtls_pk_context priv_key;
-#endif /* MBEDTLS_X509_CRT_PARSE_C */
-
+	/** mbedTLS configuration, possibly shared with other contexts. */
+	struct tls_config_cache *conf;
 #endif /* CONFIG_MBEDTLS */
 };
 
@@ -158,6 +260,61 @@ static struct tls_context tls_contexts[CONFIG_NET_SOCKETS_TLS_MAX_CONTEXTS];
 /* A mutex for protecting TLS context allocation. */
 static struct k_mutex context_lock;
 
+/* mbedTLS configurations, protected by the credentials lock. Unused
+ * entries are kept for the next contexts with the same parameters.
+ */
+static struct tls_config_cache config_cache[CONFIG_NET_SOCKETS_TLS_MAX_CONFIGS];
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+/* Parsed certificates, protected by the credentials lock. Each
+ * configuration uses at most one entry, unused entries are kept for the
+ * next configurations.
+ */
+static struct tls_cert_cache cert_cache[CONFIG_NET_SOCKETS_TLS_MAX_CONFIGS];
+#endif
+
+#if defined(MBEDTLS_SSL_CLI_C) && \
+	(CONFIG_NET_SOCKETS_TLS_MAX_CLIENT_SESSION_COUNT > 0)
+/** Client session stored for TLS session resumption. */
+struct tls_session_cache {
+	/** Information whether the entry holds a session. */
+	bool is_used;
+
+	/** Time the session was stored at, to replace the oldest one. */
+	uint32_t timestamp;
+
+	/** Peer address the session was established with. */
+	struct sockaddr peer_addr;
+
+	/** Hash of the hostname the session was established for. */
+	uint32_t hostname_hash;
+
+	/** mbedTLS session. */
+	mbedtls_ssl_session session;
+};
+
+static struct tls_session_cache
+	client_cache[CONFIG_NET_SOCKETS_TLS_MAX_CLIENT_SESSION_COUNT];
+
+/* A mutex for protecting access to the client session cache. */
+static struct k_mutex client_cache_lock;
+#endif
+
+#if defined(TLS_SESSION_TICKETS)
+#if defined(MBEDTLS_GCM_C)
+#define TLS_TICKET_CIPHER MBEDTLS_CIPHER_AES_256_GCM
+#else
+#define TLS_TICKET_CIPHER MBEDTLS_CIPHER_AES_256_CCM
+#endif
+
+/* Session ticket keys, shared by all TLS servers. */
+static mbedtls_ssl_ticket_context ticket_ctx;
+static bool ticket_ctx_ready;
+
+/* mbedTLS only protects the ticket keys with MBEDTLS_THREADING_C. */
+static struct k_mutex ticket_lock;
+#endif
+
 bool net_socket_is_tls(void *obj)
 {
 	return PART_OF_ARRAY(tls_contexts, (struct tls_context *)obj);
@@ -270,7 +427,7 @@ static int tls_init(const struct device *unused)
 {
 	ARG_UNUSED(unused);
 
-	int ret;
+	int ret, i;
 	static const unsigned char drbg_seed[] = "zephyr";
 
 #if defined(CONFIG_ENTROPY_HAS_DRIVER)
@@ -288,6 +445,33 @@ static int tls_init(const struct device *unused)
 
 	k_mutex_init(&context_lock);
 
+	for (i = 0; i < ARRAY_SIZE(config_cache); i++) {
+		mbedtls_ssl_config_init(&config_cache[i].config);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+		mbedtls_pk_init(&config_cache[i].priv_key);
+#endif
+#if defined(TLS_RSA_KEY_LOCK)
+		mbedtls_pk_init(&config_cache[i].rsa_key);
+		k_mutex_init(&config_cache[i].key_lock);
+#endif
+	}
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	for (i = 0; i < ARRAY_SIZE(cert_cache); i++) {
+		mbedtls_x509_crt_init(&cert_cache[i].ca_chain);
+		mbedtls_x509_crt_init(&cert_cache[i].own_cert);
+	}
+#endif
+
+#if defined(MBEDTLS_SSL_CLI_C) && \
+	(CONFIG_NET_SOCKETS_TLS_MAX_CLIENT_SESSION_COUNT > 0)
+	k_mutex_init(&client_cache_lock);
+
+	for (i = 0; i < ARRAY_SIZE(client_cache); i++) {
+		mbedtls_ssl_session_init(&client_cache[i].session);
+	}
+#endif
+
 	mbedtls_ctr_drbg_init(&tls_ctr_drbg);
 
 	ret = mbedtls_ctr_drbg_seed(&tls_ctr_drbg, tls_entropy_func, NULL,
@@ -298,6 +482,21 @@ static int tls_init(const struct device *unused)
 		return -EFAULT;
 	}
 
+#if defined(TLS_SESSION_TICKETS)
+	k_mutex_init(&ticket_lock);
+	mbedtls_ssl_ticket_init(&ticket_ctx);
+
+	ret = mbedtls_ssl_ticket_setup(
+			&ticket_ctx, mbedtls_ctr_drbg_random, &tls_ctr_drbg,
+			TLS_TICKET_CIPHER,
+			CONFIG_NET_SOCKETS_TLS_SESSION_TICKET_LIFETIME);
+	if (ret != 0) {
+		NET_WARN("TLS session tickets not available: -%x", -ret);
+	} else {
+		ticket_ctx_ready = true;
+	}
+#endif
+
 #if defined(MBEDTLS_DEBUG_C) && (CONFIG_NET_SOCKETS_LOG_LEVEL >= LOG_LEVEL_DBG)
 	mbedtls_debug_set_threshold(CONFIG_MBEDTLS_DEBUG_LEVEL);
 #endif
@@ -312,6 +511,131 @@ static inline bool is_handshake_complete(struct tls_context *ctx)
 	return k_sem_count_get(&ctx->tls_established) != 0;
 }
 
+static bool sec_tag_list_cmp(const struct sec_tag_list *list1,
+			     const struct sec_tag_list *list2)
+{
+	return list1->sec_tag_count == list2->sec_tag_count &&
+	       memcmp(list1->sec_tags, list2->sec_tags,
+		      list1->sec_tag_count * sizeof(sec_tag_t)) == 0;
+}
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+static void tls_cert_cache_clear(struct tls_cert_cache *entry)
+{
+	mbedtls_x509_crt_free(&entry->ca_chain);
+	mbedtls_x509_crt_free(&entry->own_cert);
+	mbedtls_x509_crt_init(&entry->ca_chain);
+	mbedtls_x509_crt_init(&entry->own_cert);
+
+	entry->is_valid = false;
+}
+
+/* Get the certificates for the secure tags of a configuration. Return true
+ * if they were already parsed, otherwise the caller has to parse them.
+ * Credentials have to be locked.
+ */
+static bool tls_cert_cache_get(struct tls_config_cache *conf)
+{
+	const struct sec_tag_list *sec_tag_list = &conf->params.sec_tag_list;
+	uint32_t generation = credentials_generation_get();
+	struct tls_cert_cache *unused = NULL;
+	struct tls_cert_cache *entry;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cert_cache); i++) {
+		entry = &cert_cache[i];
+
+		if (entry->is_valid && entry->generation == generation &&
+		    sec_tag_list_cmp(&entry->sec_tag_list, sec_tag_list)) {
+			entry->refcount++;
+			conf->certs = entry;
+
+			return true;
+		}
+
+		/* Prefer entries which do not hold up to date certificates */
+		if (entry->refcount == 0 &&
+		    (unused == NULL || !entry->is_valid ||
+		     entry->generation != generation)) {
+			unused = entry;
+		}
+	}
+
+	/* There is an entry for each configuration. */
+	__ASSERT_NO_MSG(unused != NULL);
+
+	tls_cert_cache_clear(unused);
+
+	unused->refcount = 1;
+	unused->generation = generation;
+	unused->sec_tag_list = *sec_tag_list;
+	conf->certs = unused;
+
+	return false;
+}
+
+/* Release the certificates of a configuration. Credentials have to be
+ * locked.
+ */
+static void tls_cert_cache_put(struct tls_config_cache *conf)
+{
+	struct tls_cert_cache *entry = conf->certs;
+
+	if (entry == NULL) {
+		return;
+	}
+
+	conf->certs = NULL;
+
+	if (--entry->refcount == 0 &&
+	    (!entry->is_valid ||
+	     entry->generation != credentials_generation_get())) {
+		tls_cert_cache_clear(entry);
+	}
+}
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
+static void tls_config_cache_clear(struct tls_config_cache *entry)
+{
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	tls_cert_cache_put(entry);
+
+	mbedtls_pk_free(&entry->priv_key);
+	mbedtls_pk_init(&entry->priv_key);
+#endif
+
+#if defined(TLS_RSA_KEY_LOCK)
+	mbedtls_pk_free(&entry->rsa_key);
+	mbedtls_pk_init(&entry->rsa_key);
+#endif
+
+	mbedtls_ssl_config_free(&entry->config);
+	mbedtls_ssl_config_init(&entry->config);
+
+	entry->is_valid = false;
+	entry->is_shared = false;
+}
+
+/* Release the configuration of a TLS context. Credentials have to be
+ * locked.
+ */
+static void tls_config_cache_put(struct tls_context *tls)
+{
+	struct tls_config_cache *entry = tls->conf;
+
+	if (entry == NULL) {
+		return;
+	}
+
+	tls->conf = NULL;
+
+	if (--entry->refcount == 0 &&
+	    (!entry->is_valid || !entry->is_shared ||
+	     entry->generation != credentials_generation_get())) {
+		tls_config_cache_clear(entry);
+	}
+}
+
 /* Allocate TLS context. */
 static struct tls_context *tls_alloc(void)
 {
@@ -339,18 +663,8 @@ static struct tls_context *tls_alloc(void)
 		k_sem_init(&tls->tls_established, 0, 1);
 
 		mbedtls_ssl_init(&tls->ssl);
-		mbedtls_ssl_config_init(&tls->config);
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 		mbedtls_ssl_cookie_init(&tls->cookie);
-#endif
-#if defined(MBEDTLS_X509_CRT_PARSE_C)
-		mbedtls_x509_crt_init(&tls->ca_chain);
-		mbedtls_x509_crt_init(&tls->own_cert);
-		mbedtls_pk_init(&tls->priv_key);
-#endif
-
-#if defined(MBEDTLS_DEBUG_C) && (CONFIG_NET_SOCKETS_LOG_LEVEL >= LOG_LEVEL_DBG)
-		mbedtls_ssl_conf_dbg(&tls->config, tls_debug, NULL);
 #endif
 	} else {
 		NET_WARN("Failed to allocate TLS context");
@@ -398,16 +712,15 @@ static int tls_release(struct tls_context *tls)
 		return -EBADF;
 	}
 
+	mbedtls_ssl_free(&tls->ssl);
+
+	credentials_lock();
+	tls_config_cache_put(tls);
+	credentials_unlock();
+
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 	mbedtls_ssl_cookie_free(&tls->cookie);
 #endif
-	mbedtls_ssl_config_free(&tls->config);
-	mbedtls_ssl_free(&tls->ssl);
-#if defined(MBEDTLS_X509_CRT_PARSE_C)
-	mbedtls_x509_crt_free(&tls->ca_chain);
-	mbedtls_x509_crt_free(&tls->own_cert);
-	mbedtls_pk_free(&tls->priv_key);
-#endif
 
 	tls->is_used = false;
 
@@ -421,34 +734,37 @@ static inline int time_left(uint32_t start, uint32_t timeout)
 	return timeout - elapsed;
 }
 
-#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
-static bool dtls_is_peer_addr_valid(struct tls_context *context,
-				    const struct sockaddr *peer_addr,
-				    socklen_t addrlen)
+static inline bool peer_addr_cmp(const struct sockaddr *addr1,
+				 const struct sockaddr *addr2)
 {
-	if (context->dtls_peer_addrlen != addrlen ||
-	    context->dtls_peer_addr.sa_family != peer_addr->sa_family) {
+	if (addr1->sa_family != addr2->sa_family) {
 		return false;
 	}
 
-	if (IS_ENABLED(CONFIG_NET_IPV6) && peer_addr->sa_family == AF_INET6) {
-		struct sockaddr_in6 *addr1 = net_sin6(peer_addr);
-		struct sockaddr_in6 *addr2 =
-				net_sin6(&context->dtls_peer_addr);
+	if (IS_ENABLED(CONFIG_NET_IPV6) && addr1->sa_family == AF_INET6) {
+		return (net_sin6(addr1)->sin6_port ==
+			net_sin6(addr2)->sin6_port) &&
+			net_ipv6_addr_cmp(&net_sin6(addr1)->sin6_addr,
+					  &net_sin6(addr2)->sin6_addr);
+	} else if (IS_ENABLED(CONFIG_NET_IPV4) && addr1->sa_family == AF_INET) {
+		return (net_sin(addr1)->sin_port == net_sin(addr2)->sin_port) &&
+			net_ipv4_addr_cmp(&net_sin(addr1)->sin_addr,
+					  &net_sin(addr2)->sin_addr);
+	}
 
-		return (addr1->sin6_port == addr2->sin6_port) &&
-			net_ipv6_addr_cmp(&addr1->sin6_addr, &addr2->sin6_addr);
-	} else if (IS_ENABLED(CONFIG_NET_IPV4) &&
-		   peer_addr->sa_family == AF_INET) {
-		struct sockaddr_in *addr1 = net_sin(peer_addr);
-		struct sockaddr_in *addr2 =
-				net_sin(&context->dtls_peer_addr);
+	return false;
+}
 
-		return (addr1->sin_port == addr2->sin_port) &&
-			net_ipv4_addr_cmp(&addr1->sin_addr, &addr2->sin_addr);
+#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
+static bool dtls_is_peer_addr_valid(struct tls_context *context,
+				    const struct sockaddr *peer_addr,
+				    socklen_t addrlen)
+{
+	if (context->dtls_peer_addrlen != addrlen) {
+		return false;
 	}
 
-	return false;
+	return peer_addr_cmp(&context->dtls_peer_addr, peer_addr);
 }
 
 static void dtls_peer_address_set(struct tls_context *context,
@@ -604,11 +920,169 @@ static int tls_rx(void *ctx, unsigned char *buf, size_t len)
 	return received;
 }
 
-static int tls_add_ca_certificate(struct tls_context *tls,
+#if defined(MBEDTLS_SSL_CLI_C) && \
+	(CONFIG_NET_SOCKETS_TLS_MAX_CLIENT_SESSION_COUNT > 0)
+static uint32_t tls_session_hostname_hash(struct tls_context *ctx)
+{
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	if (ctx->ssl.hostname != NULL) {
+		return crc32_ieee((const uint8_t *)ctx->ssl.hostname,
+				  strlen(ctx->ssl.hostname));
+	}
+#endif
+
+	return 0;
+}
+
+static struct tls_session_cache *tls_session_find(
+	const struct sockaddr *peer_addr, uint32_t hostname_hash)
+{
+	struct tls_session_cache *entry;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(client_cache); i++) {
+		entry = &client_cache[i];
+
+		if (entry->is_used && entry->hostname_hash == hostname_hash &&
+		    peer_addr_cmp(&entry->peer_addr, peer_addr)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* Store the session of a client after a successful handshake. */
+static void tls_session_store(struct tls_context *ctx,
+			      const struct sockaddr *peer_addr,
+			      socklen_t addrlen)
+{
+	struct tls_session_cache *entry;
+	uint32_t hostname_hash;
+	int i, ret;
+
+	if (!ctx->options.cache_enabled) {
+		return;
+	}
+
+	hostname_hash = tls_session_hostname_hash(ctx);
+
+	k_mutex_lock(&client_cache_lock, K_FOREVER);
+
+	entry = tls_session_find(peer_addr, hostname_hash);
+	if (entry == NULL) {
+		/* Use a free entry, or replace the oldest session. */
+		for (i = 0; i < ARRAY_SIZE(client_cache); i++) {
+			if (!client_cache[i].is_used) {
+				entry = &client_cache[i];
+				break;
+			}
+
+			if (entry == NULL ||
+			    (int32_t)(client_cache[i].timestamp -
+				      entry->timestamp) < 0) {
+				entry = &client_cache[i];
+			}
+		}
+	}
+
+	mbedtls_ssl_session_free(&entry->session);
+	mbedtls_ssl_session_init(&entry->session);
+	entry->is_used = false;
+
+	ret = mbedtls_ssl_get_session(&ctx->ssl, &entry->session);
+	if (ret != 0) {
+		NET_WARN("Failed to store TLS session: -%x", -ret);
+		goto unlock;
+	}
+
+	memcpy(&entry->peer_addr, peer_addr,
+	       MIN(addrlen, sizeof(entry->peer_addr)));
+	entry->hostname_hash = hostname_hash;
+	entry->timestamp = k_uptime_get_32();
+	entry->is_used = true;
+
+unlock:
+	k_mutex_unlock(&client_cache_lock);
+}
+
+/* Offer a stored session to the server, before the handshake. */
+static void tls_session_restore(struct tls_context *ctx,
+				const struct sockaddr *peer_addr)
+{
+	struct tls_session_cache *entry;
+	int ret;
+
+	if (!ctx->options.cache_enabled) {
+		return;
+	}
+
+	k_mutex_lock(&client_cache_lock, K_FOREVER);
+
+	entry = tls_session_find(peer_addr, tls_session_hostname_hash(ctx));
+	if (entry != NULL) {
+		ret = mbedtls_ssl_set_session(&ctx->ssl, &entry->session);
+		if (ret != 0) {
+			NET_WARN("Failed to restore TLS session: -%x", -ret);
+		}
+	}
+
+	k_mutex_unlock(&client_cache_lock);
+}
+
+static void tls_session_purge(void)
+{
+	int i;
+
+	k_mutex_lock(&client_cache_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(client_cache); i++) {
+		mbedtls_ssl_session_free(&client_cache[i].session);
+		mbedtls_ssl_session_init(&client_cache[i].session);
+		client_cache[i].is_used = false;
+	}
+
+	k_mutex_unlock(&client_cache_lock);
+}
+#else
+#define tls_session_store(...)
+#define tls_session_restore(...)
+#define tls_session_purge(...)
+#endif /* MBEDTLS_SSL_CLI_C && CLIENT_SESSION_COUNT > 0 */
+
+#if defined(TLS_SESSION_TICKETS)
+static int tls_ticket_write(void *p_ticket, const mbedtls_ssl_session *session,
+			    unsigned char *start, const unsigned char *end,
+			    size_t *tlen, uint32_t *lifetime)
+{
+	int ret;
+
+	k_mutex_lock(&ticket_lock, K_FOREVER);
+	ret = mbedtls_ssl_ticket_write(p_ticket, session, start, end,
+				       tlen, lifetime);
+	k_mutex_unlock(&ticket_lock);
+
+	return ret;
+}
+
+static int tls_ticket_parse(void *p_ticket, mbedtls_ssl_session *session,
+			    unsigned char *buf, size_t len)
+{
+	int ret;
+
+	k_mutex_lock(&ticket_lock, K_FOREVER);
+	ret = mbedtls_ssl_ticket_parse(p_ticket, session, buf, len);
+	k_mutex_unlock(&ticket_lock);
+
+	return ret;
+}
+#endif /* TLS_SESSION_TICKETS */
+
+static int tls_add_ca_certificate(struct tls_config_cache *conf,
 				  struct tls_credential *ca_cert)
 {
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
-	int err = mbedtls_x509_crt_parse(&tls->ca_chain,
+	int err = mbedtls_x509_crt_parse(&conf->certs->ca_chain,
 					 ca_cert->buf, ca_cert->len);
 	if (err != 0) {
 		return -EINVAL;
@@ -620,36 +1094,99 @@ static int tls_add_ca_certificate(struct tls_context *tls,
 	return -ENOTSUP;
 }
 
-static void tls_set_ca_chain(struct tls_context *tls)
+static void tls_set_ca_chain(struct tls_config_cache *conf)
 {
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
-	mbedtls_ssl_conf_ca_chain(&tls->config, &tls->ca_chain, NULL);
-	mbedtls_ssl_conf_cert_profile(&tls->config,
+	mbedtls_ssl_conf_ca_chain(&conf->config, &conf->certs->ca_chain, NULL);
+	mbedtls_ssl_conf_cert_profile(&conf->config,
 				      &mbedtls_x509_crt_profile_default);
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 }
 
-static int tls_set_own_cert(struct tls_context *tls,
+#if defined(TLS_RSA_KEY_LOCK)
+static int tls_rsa_key_decrypt(void *key, int mode, size_t *olen,
+			       const unsigned char *input,
+			       unsigned char *output, size_t output_max_len)
+{
+	struct tls_config_cache *conf = key;
+	int ret;
+
+	k_mutex_lock(&conf->key_lock, K_FOREVER);
+	ret = mbedtls_rsa_pkcs1_decrypt(mbedtls_pk_rsa(conf->priv_key),
+					mbedtls_ctr_drbg_random, &tls_ctr_drbg,
+					mode, olen, input, output,
+					output_max_len);
+	k_mutex_unlock(&conf->key_lock);
+
+	return ret;
+}
+
+static int tls_rsa_key_sign(void *key,
+			    int (*f_rng)(void *, unsigned char *, size_t),
+			    void *p_rng, int mode, mbedtls_md_type_t md_alg,
+			    unsigned int hashlen, const unsigned char *hash,
+			    unsigned char *sig)
+{
+	struct tls_config_cache *conf = key;
+	int ret;
+
+	k_mutex_lock(&conf->key_lock, K_FOREVER);
+	ret = mbedtls_rsa_pkcs1_sign(mbedtls_pk_rsa(conf->priv_key), f_rng,
+				     p_rng, mode, md_alg, hashlen, hash, sig);
+	k_mutex_unlock(&conf->key_lock);
+
+	return ret;
+}
+
+static size_t tls_rsa_key_len(void *key)
+{
+	struct tls_config_cache *conf = key;
+
+	return mbedtls_rsa_get_len(mbedtls_pk_rsa(conf->priv_key));
+}
+#endif /* TLS_RSA_KEY_LOCK */
+
+static int tls_set_own_cert(struct tls_config_cache *conf,
 			    struct tls_credential *own_cert,
-			    struct tls_credential *priv_key)
+			    struct tls_credential *priv_key,
+			    bool parse_cert)
 {
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
-	int err = mbedtls_x509_crt_parse(&tls->own_cert,
-					 own_cert->buf, own_cert->len);
-	if (err != 0) {
-		return -EINVAL;
+	mbedtls_pk_context *key = &conf->priv_key;
+	int err;
+
+	if (parse_cert) {
+		err = mbedtls_x509_crt_parse(&conf->certs->own_cert,
+					     own_cert->buf, own_cert->len);
+		if (err != 0) {
+			return -EINVAL;
+		}
 	}
 
-	err = mbedtls_pk_parse_key(&tls->priv_key, priv_key->buf,
+	err = mbedtls_pk_parse_key(&conf->priv_key, priv_key->buf,
 				   priv_key->len, NULL, 0);
 	if (err != 0) {
 		return -EINVAL;
 	}
 
-	err = mbedtls_ssl_conf_own_cert(&tls->config, &tls->own_cert,
-					&tls->priv_key);
+#if defined(TLS_RSA_KEY_LOCK)
+	if (mbedtls_pk_get_type(&conf->priv_key) == MBEDTLS_PK_RSA) {
+		err = mbedtls_pk_setup_rsa_alt(&conf->rsa_key, conf,
+					       tls_rsa_key_decrypt,
+					       tls_rsa_key_sign,
+					       tls_rsa_key_len);
+		if (err != 0) {
+			return -ENOMEM;
+		}
+
+		key = &conf->rsa_key;
+	}
+#endif
+
+	err = mbedtls_ssl_conf_own_cert(&conf->config, &conf->certs->own_cert,
+					key);
 	if (err != 0) {
-		err = -ENOMEM;
+		return -ENOMEM;
 	}
 
 	return 0;
@@ -658,12 +1195,12 @@ static int tls_set_own_cert(struct tls_context *tls,
 	return -ENOTSUP;
 }
 
-static int tls_set_psk(struct tls_context *tls,
+static int tls_set_psk(struct tls_config_cache *conf,
 		       struct tls_credential *psk,
 		       struct tls_credential *psk_id)
 {
 #if defined(MBEDTLS_KEY_EXCHANGE__SOME__PSK_ENABLED)
-	int err = mbedtls_ssl_conf_psk(&tls->config,
+	int err = mbedtls_ssl_conf_psk(&conf->config,
 				       psk->buf, psk->len,
 				       (const unsigned char *)psk_id->buf,
 				       psk_id->len);
@@ -674,98 +1211,321 @@ static int tls_set_psk(struct tls_context *tls,
 	return 0;
 #endif
 
-	return -ENOTSUP;
-}
+	return -ENOTSUP;
+}
+
+static int tls_set_credential(struct tls_config_cache *conf,
+			      struct tls_credential *cred,
+			      bool parse_certs)
+{
+	switch (cred->type) {
+	case TLS_CREDENTIAL_CA_CERTIFICATE:
+		if (!parse_certs) {
+			/* Already in the CA chain. */
+			break;
+		}
+
+		return tls_add_ca_certificate(conf, cred);
+
+	case TLS_CREDENTIAL_SERVER_CERTIFICATE:
+	{
+		struct tls_credential *priv_key =
+			credential_get(cred->tag, TLS_CREDENTIAL_PRIVATE_KEY);
+		if (!priv_key) {
+			return -ENOENT;
+		}
+
+		return tls_set_own_cert(conf, cred, priv_key, parse_certs);
+	}
+
+	case TLS_CREDENTIAL_PRIVATE_KEY:
+		/* Ignore private key - it will be used together
+		 * with public certificate
+		 */
+		break;
+
+	case TLS_CREDENTIAL_PSK:
+	{
+		struct tls_credential *psk_id =
+			credential_get(cred->tag, TLS_CREDENTIAL_PSK_ID);
+		if (!psk_id) {
+			return -ENOENT;
+		}
+
+		return tls_set_psk(conf, cred, psk_id);
+	}
+
+	case TLS_CREDENTIAL_PSK_ID:
+		/* Ignore PSK ID - it will be used together
+		 * with PSK
+		 */
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Set the credentials of the secure tags of a configuration. Credentials
+ * have to be locked.
+ */
+static int tls_mbedtls_set_credentials(struct tls_config_cache *conf)
+{
+	const struct sec_tag_list *sec_tag_list = &conf->params.sec_tag_list;
+	struct tls_credential *cred;
+	sec_tag_t tag;
+	int i, err = 0;
+	bool tag_found, ca_cert_present = false;
+	bool parse_certs = true;
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	/* The certificates are parsed once for all the configurations using
+	 * the same secure tags.
+	 */
+	parse_certs = !tls_cert_cache_get(conf);
+#endif
+
+	for (i = 0; i < sec_tag_list->sec_tag_count; i++) {
+		tag = sec_tag_list->sec_tags[i];
+		cred = NULL;
+		tag_found = false;
+
+		while ((cred = credential_next_get(tag, cred)) != NULL) {
+			tag_found = true;
+
+			err = tls_set_credential(conf, cred, parse_certs);
+			if (err != 0) {
+				goto exit;
+			}
+
+			if (cred->type == TLS_CREDENTIAL_CA_CERTIFICATE) {
+				ca_cert_present = true;
+			}
+		}
+
+		if (!tag_found) {
+			err = -ENOENT;
+			goto exit;
+		}
+	}
+
+exit:
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	if (err == 0) {
+		conf->certs->is_valid = true;
+	} else {
+		tls_cert_cache_put(conf);
+	}
+#endif
+
+	if (err == 0 && ca_cert_present) {
+		tls_set_ca_chain(conf);
+	}
+
+	return err;
+}
+
+static bool tls_config_params_cmp(const struct tls_config_params *params1,
+				  const struct tls_config_params *params2)
+{
+	int i;
+
+	if (params1->endpoint != params2->endpoint ||
+	    params1->transport != params2->transport ||
+	    params1->verify_level != params2->verify_level ||
+	    params1->mfl_code != params2->mfl_code ||
+	    params1->tickets != params2->tickets ||
+	    !sec_tag_list_cmp(&params1->sec_tag_list,
+			      &params2->sec_tag_list)) {
+		return false;
+	}
+
+	for (i = 0; params1->ciphersuites[i] != 0; i++) {
+		if (params1->ciphersuites[i] != params2->ciphersuites[i]) {
+			return false;
+		}
+	}
+
+	return params2->ciphersuites[i] == 0;
+}
+
+/* Set up the configuration of a TLS context from its parameters.
+ * Credentials have to be locked.
+ */
+static int tls_config_setup(struct tls_context *context)
+{
+	struct tls_config_cache *conf = context->conf;
+	const struct tls_config_params *params = &conf->params;
+	bool is_shared = true;
+	int ret;
+
+	ret = mbedtls_ssl_config_defaults(&conf->config, params->endpoint,
+					  params->transport,
+					  MBEDTLS_SSL_PRESET_DEFAULT);
+	if (ret != 0) {
+		/* According to mbedTLS API documentation,
+		 * mbedtls_ssl_config_defaults can fail due to memory
+		 * allocation failure
+		 */
+		return -ENOMEM;
+	}
+
+#if defined(MBEDTLS_SSL_RENEGOTIATION)
+	mbedtls_ssl_conf_legacy_renegotiation(&conf->config,
+					   MBEDTLS_SSL_LEGACY_BREAK_HANDSHAKE);
+	mbedtls_ssl_conf_renegotiation(&conf->config,
+				       MBEDTLS_SSL_RENEGOTIATION_ENABLED);
+#endif
+
+#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
+	/* Configure cookie for DTLS server. The cookie belongs to the
+	 * context, so the configuration cannot be shared.
+	 */
+	if (params->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM &&
+	    params->endpoint == MBEDTLS_SSL_IS_SERVER) {
+		ret = mbedtls_ssl_cookie_setup(&context->cookie,
+					       mbedtls_ctr_drbg_random,
+					       &tls_ctr_drbg);
+		if (ret != 0) {
+			return -ENOMEM;
+		}
+
+		mbedtls_ssl_conf_dtls_cookies(&conf->config,
+					      mbedtls_ssl_cookie_write,
+					      mbedtls_ssl_cookie_check,
+					      &context->cookie);
 
-static int tls_set_credential(struct tls_context *tls,
-			      struct tls_credential *cred)
-{
-	switch (cred->type) {
-	case TLS_CREDENTIAL_CA_CERTIFICATE:
-		return tls_add_ca_certificate(tls, cred);
+		mbedtls_ssl_conf_read_timeout(&conf->config,
+					      CONFIG_NET_SOCKETS_DTLS_TIMEOUT);
 
-	case TLS_CREDENTIAL_SERVER_CERTIFICATE:
-	{
-		struct tls_credential *priv_key =
-			credential_get(cred->tag, TLS_CREDENTIAL_PRIVATE_KEY);
-		if (!priv_key) {
-			return -ENOENT;
-		}
+		is_shared = false;
+	}
+#endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 
-		return tls_set_own_cert(tls, cred, priv_key);
+	/* If verification level was specified explicitly, set it. Otherwise,
+	 * use mbedTLS default values (required for client, none for server)
+	 */
+	if (params->verify_level != -1) {
+		mbedtls_ssl_conf_authmode(&conf->config, params->verify_level);
 	}
 
-	case TLS_CREDENTIAL_PRIVATE_KEY:
-		/* Ignore private key - it will be used together
-		 * with public certificate
-		 */
-		break;
+	mbedtls_ssl_conf_rng(&conf->config,
+			     mbedtls_ctr_drbg_random,
+			     &tls_ctr_drbg);
 
-	case TLS_CREDENTIAL_PSK:
-	{
-		struct tls_credential *psk_id =
-			credential_get(cred->tag, TLS_CREDENTIAL_PSK_ID);
-		if (!psk_id) {
-			return -ENOENT;
+#if defined(MBEDTLS_DEBUG_C) && (CONFIG_NET_SOCKETS_LOG_LEVEL >= LOG_LEVEL_DBG)
+	mbedtls_ssl_conf_dbg(&conf->config, tls_debug, NULL);
+#endif
+
+	if (params->ciphersuites[0] != 0) {
+		mbedtls_ssl_conf_ciphersuites(&conf->config,
+					      params->ciphersuites);
+	}
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+	if (params->mfl_code != MBEDTLS_SSL_MAX_FRAG_LEN_NONE) {
+		ret = mbedtls_ssl_conf_max_frag_len(&conf->config,
+						    params->mfl_code);
+		if (ret != 0) {
+			return -EINVAL;
 		}
+	}
+#endif
 
-		return tls_set_psk(tls, cred, psk_id);
+#if defined(TLS_SESSION_TICKETS)
+	if (params->tickets) {
+		mbedtls_ssl_conf_session_tickets_cb(&conf->config,
+						    tls_ticket_write,
+						    tls_ticket_parse,
+						    &ticket_ctx);
 	}
+#endif
 
-	case TLS_CREDENTIAL_PSK_ID:
-		/* Ignore PSK ID - it will be used together
-		 * with PSK
-		 */
-		break;
+	ret = tls_mbedtls_set_credentials(conf);
+	if (ret != 0) {
+		return ret;
+	}
 
-	default:
-		return -EINVAL;
+#if defined(MBEDTLS_X509_CRT_PARSE_C) && !defined(MBEDTLS_THREADING_C) && \
+	!defined(TLS_RSA_KEY_LOCK)
+	/* RSA blinding values are updated by each private key operation,
+	 * which mbedTLS only protects with MBEDTLS_THREADING_C.
+	 */
+	if (mbedtls_pk_can_do(&conf->priv_key, MBEDTLS_PK_RSA)) {
+		is_shared = false;
 	}
+#endif
+
+	conf->is_shared = is_shared;
 
 	return 0;
 }
 
-static int tls_mbedtls_set_credentials(struct tls_context *tls)
+/* Get a configuration for a TLS context, shared with the other contexts
+ * using the same parameters if possible.
+ */
+static int tls_config_cache_get(struct tls_context *context,
+				const struct tls_config_params *params)
 {
-	struct tls_credential *cred;
-	sec_tag_t tag;
-	int i, err = 0;
-	bool tag_found, ca_cert_present = false;
+	struct tls_config_cache *unused = NULL;
+	struct tls_config_cache *entry;
+	uint32_t generation;
+	int i, ret = 0;
 
 	credentials_lock();
 
-	for (i = 0; i < tls->options.sec_tag_list.sec_tag_count; i++) {
-		tag = tls->options.sec_tag_list.sec_tags[i];
-		cred = NULL;
-		tag_found = false;
+	tls_config_cache_put(context);
 
-		while ((cred = credential_next_get(tag, cred)) != NULL) {
-			tag_found = true;
+	generation = credentials_generation_get();
 
-			err = tls_set_credential(tls, cred);
-			if (err != 0) {
-				goto exit;
-			}
+	for (i = 0; i < ARRAY_SIZE(config_cache); i++) {
+		entry = &config_cache[i];
 
-			if (cred->type == TLS_CREDENTIAL_CA_CERTIFICATE) {
-				ca_cert_present = true;
-			}
+		if (entry->is_valid && entry->is_shared &&
+		    entry->generation == generation &&
+		    tls_config_params_cmp(&entry->params, params)) {
+			entry->refcount++;
+			context->conf = entry;
+
+			goto out;
 		}
 
-		if (!tag_found) {
-			err = -ENOENT;
-			goto exit;
+		/* Prefer entries which do not hold an up to date
+		 * configuration.
+		 */
+		if (entry->refcount == 0 &&
+		    (unused == NULL || !entry->is_valid ||
+		     entry->generation != generation)) {
+			unused = entry;
 		}
 	}
 
-exit:
-	credentials_unlock();
+	if (unused == NULL) {
+		NET_WARN("No free TLS configuration");
+		ret = -ENOMEM;
+		goto out;
+	}
 
-	if (err == 0 && ca_cert_present) {
-		tls_set_ca_chain(tls);
+	tls_config_cache_clear(unused);
+
+	unused->refcount = 1;
+	unused->generation = generation;
+	unused->params = *params;
+	context->conf = unused;
+
+	ret = tls_config_setup(context);
+	if (ret == 0) {
+		unused->is_valid = true;
+	} else {
+		tls_config_cache_put(context);
 	}
 
-	return err;
+out:
+	credentials_unlock();
+
+	return ret;
 }
 
 static int tls_mbedtls_reset(struct tls_context *context)
@@ -827,71 +1587,51 @@ static int tls_mbedtls_handshake(struct tls_context *context, bool block)
 
 static int tls_mbedtls_init(struct tls_context *context, bool is_server)
 {
-	int role, type, ret;
+	struct tls_config_params params;
+	int ret;
+
+	(void)memset(&params, 0, sizeof(params));
 
-	role = is_server ? MBEDTLS_SSL_IS_SERVER : MBEDTLS_SSL_IS_CLIENT;
+	params.endpoint = is_server ? MBEDTLS_SSL_IS_SERVER :
+				      MBEDTLS_SSL_IS_CLIENT;
 
-	type = (context->type == SOCK_STREAM) ?
+	params.transport = (context->type == SOCK_STREAM) ?
 		MBEDTLS_SSL_TRANSPORT_STREAM :
 		MBEDTLS_SSL_TRANSPORT_DATAGRAM;
 
-	if (type == MBEDTLS_SSL_TRANSPORT_STREAM) {
+	params.sec_tag_list = context->options.sec_tag_list;
+	memcpy(params.ciphersuites, context->options.ciphersuites,
+	       sizeof(params.ciphersuites));
+	params.verify_level = context->options.verify_level;
+	params.mfl_code = context->options.mfl_code;
+
+#if defined(TLS_SESSION_TICKETS)
+	params.tickets = is_server && context->options.cache_enabled &&
+			 ticket_ctx_ready;
+#endif
+
+	if (params.transport == MBEDTLS_SSL_TRANSPORT_STREAM) {
 		mbedtls_ssl_set_bio(&context->ssl, context,
 				    tls_tx, tls_rx, NULL);
 	} else {
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 		mbedtls_ssl_set_bio(&context->ssl, context,
 				    dtls_tx, NULL, dtls_rx);
-#else
-		return -ENOTSUP;
-#endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
-	}
-
-	ret = mbedtls_ssl_config_defaults(&context->config, role, type,
-					  MBEDTLS_SSL_PRESET_DEFAULT);
-	if (ret != 0) {
-		/* According to mbedTLS API documentation,
-		 * mbedtls_ssl_config_defaults can fail due to memory
-		 * allocation failure
-		 */
-		return -ENOMEM;
-	}
 
-#if defined(MBEDTLS_SSL_RENEGOTIATION)
-	mbedtls_ssl_conf_legacy_renegotiation(&context->config,
-					   MBEDTLS_SSL_LEGACY_BREAK_HANDSHAKE);
-	mbedtls_ssl_conf_renegotiation(&context->config,
-				       MBEDTLS_SSL_RENEGOTIATION_ENABLED);
-#endif
-
-#if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
-	if (type == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
 		/* DTLS requires timer callbacks to operate */
 		mbedtls_ssl_set_timer_cb(&context->ssl,
 					 &context->dtls_timing,
 					 dtls_timing_set_delay,
 					 dtls_timing_get_delay);
+#else
+		return -ENOTSUP;
+#endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
+	}
 
-		/* Configure cookie for DTLS server */
-		if (role == MBEDTLS_SSL_IS_SERVER) {
-			ret = mbedtls_ssl_cookie_setup(&context->cookie,
-						       mbedtls_ctr_drbg_random,
-						       &tls_ctr_drbg);
-			if (ret != 0) {
-				return -ENOMEM;
-			}
-
-			mbedtls_ssl_conf_dtls_cookies(&context->config,
-						      mbedtls_ssl_cookie_write,
-						      mbedtls_ssl_cookie_check,
-						      &context->cookie);
-
-			mbedtls_ssl_conf_read_timeout(
-					&context->config,
-					CONFIG_NET_SOCKETS_DTLS_TIMEOUT);
-		}
+	ret = tls_config_cache_get(context, &params);
+	if (ret != 0) {
+		return ret;
 	}
-#endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
 	/* For TLS clients, set hostname to empty string to enforce it's
@@ -903,25 +1643,8 @@ static int tls_mbedtls_init(struct tls_context *context, bool is_server)
 	}
 #endif
 
-	/* If verification level was specified explicitly, set it. Otherwise,
-	 * use mbedTLS default values (required for client, none for server)
-	 */
-	if (context->options.verify_level != -1) {
-		mbedtls_ssl_conf_authmode(&context->config,
-					  context->options.verify_level);
-	}
-
-	mbedtls_ssl_conf_rng(&context->config,
-			     mbedtls_ctr_drbg_random,
-			     &tls_ctr_drbg);
-
-	ret = tls_mbedtls_set_credentials(context);
-	if (ret != 0) {
-		return ret;
-	}
-
 	ret = mbedtls_ssl_setup(&context->ssl,
-				&context->config);
+				&context->conf->config);
 	if (ret != 0) {
 		/* According to mbedTLS API documentation,
 		 * mbedtls_ssl_setup can fail due to memory allocation failure
@@ -1122,6 +1845,175 @@ static int tls_opt_dtls_role_set(struct tls_context *context,
 	return 0;
 }
 
+static int tls_opt_session_cache_set(struct tls_context *context,
+				     const void *optval, socklen_t optlen)
+{
+	int *cache;
+
+	if (!optval) {
+		return -EINVAL;
+	}
+
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	cache = (int *)optval;
+	if (*cache != TLS_SESSION_CACHE_DISABLED &&
+	    *cache != TLS_SESSION_CACHE_ENABLED) {
+		return -EINVAL;
+	}
+
+	context->options.cache_enabled = (*cache == TLS_SESSION_CACHE_ENABLED);
+
+	return 0;
+}
+
+static int tls_opt_session_cache_get(struct tls_context *context,
+				     void *optval, socklen_t *optlen)
+{
+	if (*optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	*(int *)optval = context->options.cache_enabled ?
+			 TLS_SESSION_CACHE_ENABLED :
+			 TLS_SESSION_CACHE_DISABLED;
+
+	return 0;
+}
+
+static int tls_opt_session_cache_purge_set(struct tls_context *context,
+					   const void *optval,
+					   socklen_t optlen)
+{
+	ARG_UNUSED(context);
+	ARG_UNUSED(optval);
+	ARG_UNUSED(optlen);
+
+	tls_session_purge();
+
+	return 0;
+}
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+/* Maximum fragment lengths, indexed by mbedTLS code. */
+static const uint16_t mfl_lengths[] = {
+	[MBEDTLS_SSL_MAX_FRAG_LEN_NONE] = 0,
+	[MBEDTLS_SSL_MAX_FRAG_LEN_512] = 512,
+	[MBEDTLS_SSL_MAX_FRAG_LEN_1024] = 1024,
+	[MBEDTLS_SSL_MAX_FRAG_LEN_2048] = 2048,
+	[MBEDTLS_SSL_MAX_FRAG_LEN_4096] = 4096,
+};
+#endif
+
+static int tls_opt_max_frag_len_set(struct tls_context *context,
+				    const void *optval, socklen_t optlen)
+{
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+	int i;
+
+	if (!optval) {
+		return -EINVAL;
+	}
+
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(mfl_lengths); i++) {
+		if (mfl_lengths[i] == *(int *)optval) {
+			context->options.mfl_code = i;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+#else
+	return -ENOTSUP;
+#endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
+}
+
+static int tls_opt_max_frag_len_get(struct tls_context *context,
+				    void *optval, socklen_t *optlen)
+{
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+	if (*optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	*(int *)optval = mfl_lengths[context->options.mfl_code];
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
+}
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+/* Size of a parsed certificate chain, the raw certificates are copied. */
+static size_t tls_crt_size(const mbedtls_x509_crt *crt)
+{
+	size_t size = 0;
+
+	for (; crt != NULL && crt->raw.len != 0; crt = crt->next) {
+		size += sizeof(*crt) + crt->raw.len;
+	}
+
+	return size;
+}
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
+static int tls_opt_memory_usage_get(struct tls_context *context,
+				    void *optval, socklen_t *optlen)
+{
+	struct tls_memory_usage *usage = optval;
+	const struct tls_config_cache *conf;
+
+	if (*optlen != sizeof(*usage)) {
+		return -EINVAL;
+	}
+
+	(void)memset(usage, 0, sizeof(*usage));
+
+	usage->context = sizeof(*context);
+
+	if (!context->is_initialized) {
+		return 0;
+	}
+
+	/* The record buffers and the session state are internal to
+	 * mbedTLS, their sizes are derived from the configuration.
+	 */
+	usage->in_buf = MBEDTLS_SSL_IN_CONTENT_LEN;
+	usage->out_buf = MBEDTLS_SSL_OUT_CONTENT_LEN;
+	usage->session = sizeof(mbedtls_ssl_session);
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	usage->session +=
+		tls_crt_size(mbedtls_ssl_get_peer_cert(&context->ssl));
+#endif
+
+	credentials_lock();
+
+	conf = context->conf;
+	if (conf != NULL) {
+		usage->config = sizeof(*conf);
+		usage->config_users = conf->refcount;
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+		if (conf->certs != NULL) {
+			usage->config += tls_crt_size(&conf->certs->ca_chain) +
+					 tls_crt_size(&conf->certs->own_cert);
+		}
+#endif
+	}
+
+	credentials_unlock();
+
+	return 0;
+}
+
 static int protocol_check(int family, int type, int *proto)
 {
 	if (family != AF_INET && family != AF_INET6) {
@@ -1236,6 +2128,8 @@ int ztls_connect_ctx(struct tls_context *ctx, const struct sockaddr *addr,
 			goto error;
 		}
 
+		tls_session_restore(ctx, addr);
+
 		/* Do not use any socket flags during the handshake. */
 		ctx->flags = 0;
 
@@ -1246,6 +2140,8 @@ int ztls_connect_ctx(struct tls_context *ctx, const struct sockaddr *addr,
 		if (ret < 0) {
 			goto error;
 		}
+
+		tls_session_store(ctx, addr, addrlen);
 	} else {
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 		/* Just store the address. */
@@ -1376,6 +2272,8 @@ static ssize_t sendto_dtls_client(struct tls_context *ctx, const void *buf,
 		if (ret < 0) {
 			goto error;
 		}
+
+		tls_session_restore(ctx, &ctx->dtls_peer_addr);
 	}
 
 	if (!is_handshake_complete(ctx)) {
@@ -1386,6 +2284,9 @@ static ssize_t sendto_dtls_client(struct tls_context *ctx, const void *buf,
 		if (ret < 0) {
 			goto error;
 		}
+
+		tls_session_store(ctx, &ctx->dtls_peer_addr,
+				  ctx->dtls_peer_addrlen);
 	}
 
 	return send_tls(ctx, buf, len, flags);
@@ -1423,6 +2324,10 @@ ssize_t ztls_sendto_ctx(struct tls_context *ctx, const void *buf, size_t len,
 			int flags, const struct sockaddr *dest_addr,
 			socklen_t addrlen)
 {
+	/* The records are encrypted to a separate buffer anyway, so the
+	 * transport never sends the caller's data as is.
+	 */
+	flags &= ~ZSOCK_MSG_ZEROCOPY;
 	ctx->flags = flags;
 
 	/* TLS */
@@ -1922,6 +2827,18 @@ int ztls_getsockopt_ctx(struct tls_context *ctx, int level, int optname,
 		err = tls_opt_ciphersuite_used_get(ctx, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_get(ctx, optval, optlen);
+		break;
+
+	case TLS_MAX_FRAG_LEN:
+		err = tls_opt_max_frag_len_get(ctx, optval, optlen);
+		break;
+
+	case TLS_MEMORY_USAGE:
+		err = tls_opt_memory_usage_get(ctx, optval, optlen);
+		break;
+
 	default:
 		/* Unknown or write-only option. */
 		err = -ENOPROTOOPT;
@@ -1967,6 +2884,18 @@ int ztls_setsockopt_ctx(struct tls_context *ctx, int level, int optname,
 		err = tls_opt_dtls_role_set(ctx, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_set(ctx, optval, optlen);
+		break;
+
+	case TLS_SESSION_CACHE_PURGE:
+		err = tls_opt_session_cache_purge_set(ctx, optval, optlen);
+		break;
+
+	case TLS_MAX_FRAG_LEN:
+		err = tls_opt_max_frag_len_set(ctx, optval, optlen);
+		break;
+
 	default:
 		/* Unknown or read-only option. */
 		err = -ENOPROTOOPT;
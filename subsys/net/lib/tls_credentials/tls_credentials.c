@@ -16,6 +16,9 @@ static struct tls_credential credentials[CONFIG_TLS_MAX_CREDENTIALS_NUMBER];
 /* A mutex for protecting access to the credentials array. */
 static struct k_mutex credential_lock;
 
+/* Incremented on every change of the credentials array. */
+static uint32_t credentials_generation;
+
 static int credentials_init(const struct device *unused)
 {
 	(void)memset(credentials, 0, sizeof(credentials));
@@ -74,6 +77,11 @@ struct tls_credential *credential_next_get(sec_tag_t tag,
 	return NULL;
 }
 
+uint32_t credentials_generation_get(void)
+{
+	return credentials_generation;
+}
+
 void credentials_lock(void)
 {
 	k_mutex_lock(&credential_lock, K_FOREVER);
@@ -108,6 +116,7 @@ int tls_credential_add(sec_tag_t tag, enum tls_credential_type type,
 	credential->type = type;
 	credential->buf = cred;
 	credential->len = credlen;
+	credentials_generation++;
 
 exit:
 	credentials_unlock();
@@ -159,6 +168,7 @@ int tls_credential_delete(sec_tag_t tag, enum tls_credential_type type)
 
 	(void)memset(credential, 0, sizeof(struct tls_credential));
 	credential->type = TLS_CREDENTIAL_NONE;
+	credentials_generation++;
 
 exit:
 	credentials_unlock();
@@ -51,4 +51,13 @@ struct tls_credential *credential_get(sec_tag_t tag,
 struct tls_credential *credential_next_get(sec_tag_t tag,
 					   struct tls_credential *iter);
 
+/* Function for getting the credentials generation, which changes every time
+ * a credential is added or deleted. It allows to check whether data derived
+ * from the credentials is still up to date.
+ *
+ * Note, that to assure thread safety, credential access should be locked with
+ * credentials_lock before calling this function.
+ */
+uint32_t credentials_generation_get(void);
+
 #endif /* __TLS_INTERNAL_H */
@@ -50,7 +50,7 @@ extern const struct socket_op_vtable sock_fd_op_vtable;
 static const struct socket_op_vtable websocket_fd_op_vtable;
 
 #if defined(CONFIG_NET_TEST)
-int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg);
+int verify_sent_msg(struct msghdr *msg);
 #endif
 
 static const char *opcode2str(enum websocket_opcode opcode)
@@ -439,34 +439,68 @@ static int websocket_ioctl_vmeth(void *obj, unsigned int request, va_list args)
 	return sock_fd_op_vtable.fd_vtable.ioctl(obj, request, args);
 }
 
+/* Mask or unmask len bytes of src to dst, which may be the same buffer.
+ * The offset is the position of the first byte in the payload, it tells
+ * which byte of the masking key applies to it. Once dst is aligned, the
+ * data is processed a word at a time.
+ */
+static void websocket_mask(uint8_t *dst, const uint8_t *src, size_t len,
+			   uint32_t masking_value, uint64_t offset)
+{
+	uint8_t key[sizeof(uint32_t)];
+	uint8_t rotated[sizeof(uint32_t)];
+	uint32_t word_mask;
+	size_t i, j;
+
+	sys_put_be32(masking_value, key);
+
+	for (i = 0; i < len && ((uintptr_t)&dst[i] % sizeof(uint32_t)); i++) {
+		dst[i] = src[i] ^ key[(offset + i) % sizeof(key)];
+	}
+
+	for (j = 0; j < sizeof(rotated); j++) {
+		rotated[j] = key[(offset + i + j) % sizeof(key)];
+	}
+
+	memcpy(&word_mask, rotated, sizeof(word_mask));
+
+	for (; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t)) {
+		*(uint32_t *)&dst[i] =
+			UNALIGNED_GET((const uint32_t *)&src[i]) ^ word_mask;
+	}
+
+	for (; i < len; i++) {
+		dst[i] = src[i] ^ key[(offset + i) % sizeof(key)];
+	}
+}
+
 static int websocket_prepare_and_send(struct websocket_context *ctx,
-				      uint8_t *header, size_t header_len,
-				      uint8_t *payload, size_t payload_len,
+				      struct iovec *io_vector, size_t iovlen,
 				      int32_t timeout)
 {
-	struct iovec io_vector[2];
 	struct msghdr msg;
-
-	io_vector[0].iov_base = header;
-	io_vector[0].iov_len = header_len;
-	io_vector[1].iov_base = payload;
-	io_vector[1].iov_len = payload_len;
+	ssize_t ret;
+	int total = 0;
+	int i;
 
 	memset(&msg, 0, sizeof(msg));
 
 	msg.msg_iov = io_vector;
-	msg.msg_iovlen = ARRAY_SIZE(io_vector);
+	msg.msg_iovlen = iovlen;
 
 	if (HEXDUMP_SENT_PACKETS) {
-		LOG_HEXDUMP_DBG(header, header_len, "Header");
-		LOG_HEXDUMP_DBG(payload, payload_len, "Payload");
+		for (i = 0; i < iovlen; i++) {
+			LOG_HEXDUMP_DBG(io_vector[i].iov_base,
+					io_vector[i].iov_len, "Data");
+		}
 	}
 
 #if defined(CONFIG_NET_TEST)
-	/* Simulate a case where the payload is split to two. The unit test
-	 * does not set mask bit in this case.
-	 */
-	return verify_sent_and_received_msg(&msg, !(header[1] & BIT(7)));
+	ARG_UNUSED(ret);
+	ARG_UNUSED(total);
+
+	/* The unit test collects the data instead of sending it */
+	return verify_sent_msg(&msg);
 #else
 	k_timeout_t tout = K_FOREVER;
 
@@ -474,19 +508,157 @@ static int websocket_prepare_and_send(struct websocket_context *ctx,
 		tout = K_MSEC(timeout);
 	}
 
-	return sendmsg(ctx->real_sock, &msg,
-		       K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
+	while (msg.msg_iovlen > 0) {
+		ret = sendmsg(ctx->real_sock, &msg,
+			      K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		total += ret;
+
+		/* Skip what was sent and try again with the rest */
+		while (msg.msg_iovlen > 0 && ret >= msg.msg_iov->iov_len) {
+			ret -= msg.msg_iov->iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+
+		if (msg.msg_iovlen > 0) {
+			msg.msg_iov->iov_base =
+				(uint8_t *)msg.msg_iov->iov_base + ret;
+			msg.msg_iov->iov_len -= ret;
+		}
+	}
+
+	return total;
 #endif /* CONFIG_NET_TEST */
 }
 
-int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
-		       enum websocket_opcode opcode, bool mask, bool final,
-		       int32_t timeout)
+/* The header and this many buffers are given to sendmsg() at once */
+#define MAX_SEND_IOV 4
+
+/* Send the header and the payload, gathered from the buffers as they are.
+ * Returns the amount of payload sent.
+ */
+static int websocket_send_plain(struct websocket_context *ctx,
+				uint8_t *header, size_t hdr_len,
+				const struct iovec *iov, size_t iovlen,
+				int32_t timeout)
 {
-	struct websocket_context *ctx;
-	uint8_t header[MAX_HEADER_LEN], hdr_len = 2;
-	uint8_t *data_to_send = (uint8_t *)payload;
+	struct iovec io_vector[1 + MAX_SEND_IOV];
+	size_t count = 1;
+	int total = 0;
+	int ret;
+	int i;
+
+	io_vector[0].iov_base = header;
+	io_vector[0].iov_len = hdr_len;
+
+	for (i = 0; i < iovlen; i++) {
+		io_vector[count++] = iov[i];
+
+		if (count < ARRAY_SIZE(io_vector) && i + 1 < iovlen) {
+			continue;
+		}
+
+		ret = websocket_prepare_and_send(ctx, io_vector, count,
+						 timeout);
+		if (ret < 0) {
+			return ret;
+		}
+
+		total += ret;
+		count = 0;
+	}
+
+	/* Frame without payload */
+	if (count > 0) {
+		ret = websocket_prepare_and_send(ctx, io_vector, count,
+						 timeout);
+		if (ret < 0) {
+			return ret;
+		}
+
+		total += ret;
+	}
+
+	return total - hdr_len;
+}
+
+/* Send the header and the payload, which is masked while being copied to
+ * a buffer in the stack. Returns the amount of payload sent.
+ */
+static int websocket_send_masked(struct websocket_context *ctx,
+				 uint8_t *header, size_t hdr_len,
+				 const struct iovec *iov, size_t iovlen,
+				 int32_t timeout)
+{
+	uint8_t masked[CONFIG_WEBSOCKET_MASK_BUF_SIZE] __aligned(4);
+	struct iovec io_vector[2];
+	size_t count = 1, len = 0, pos, copy;
+	uint64_t offset = 0;
+	int total = 0;
 	int ret;
+	int i;
+
+	io_vector[0].iov_base = header;
+	io_vector[0].iov_len = hdr_len;
+
+	for (i = 0; i < iovlen; i++) {
+		for (pos = 0; pos < iov[i].iov_len; pos += copy) {
+			copy = MIN(sizeof(masked) - len, iov[i].iov_len - pos);
+
+			websocket_mask(&masked[len],
+				       (const uint8_t *)iov[i].iov_base + pos,
+				       copy, ctx->masking_value, offset);
+
+			len += copy;
+			offset += copy;
+
+			if (len < sizeof(masked)) {
+				continue;
+			}
+
+			io_vector[count].iov_base = masked;
+			io_vector[count++].iov_len = len;
+
+			ret = websocket_prepare_and_send(ctx, io_vector, count,
+							 timeout);
+			if (ret < 0) {
+				return ret;
+			}
+
+			total += ret;
+			count = 0;
+			len = 0;
+		}
+	}
+
+	if (count > 0 || len > 0) {
+		io_vector[count].iov_base = masked;
+		io_vector[count++].iov_len = len;
+
+		ret = websocket_prepare_and_send(ctx, io_vector, count,
+						 timeout);
+		if (ret < 0) {
+			return ret;
+		}
+
+		total += ret;
+	}
+
+	return total - hdr_len;
+}
+
+static int websocket_send_frame(struct websocket_context *ctx,
+				const struct iovec *iov, size_t iovlen,
+				enum websocket_opcode opcode, bool mask,
+				bool final, int32_t timeout)
+{
+	uint8_t header[MAX_HEADER_LEN], hdr_len = 2;
+	size_t payload_len = 0;
+	int i;
 
 	if (opcode != WEBSOCKET_OPCODE_DATA_TEXT &&
 	    opcode != WEBSOCKET_OPCODE_DATA_BINARY &&
@@ -497,21 +669,9 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		return -EINVAL;
 	}
 
-#if defined(CONFIG_NET_TEST)
-	/* Websocket unit test does not use socket layer but feeds
-	 * the data directly here when testing this function.
-	 */
-	ctx = INT_TO_POINTER(ws_sock);
-#else
-	ctx = z_get_fd_obj(ws_sock, NULL, 0);
-	if (ctx == NULL) {
-		return -EBADF;
-	}
-
-	if (!PART_OF_ARRAY(contexts, ctx)) {
-		return -ENOENT;
+	for (i = 0; i < iovlen; i++) {
+		payload_len += iov[i].iov_len;
 	}
-#endif /* CONFIG_NET_TEST */
 
 	NET_DBG("[%p] Len %zd %s/%d/%s", ctx, payload_len, opcode2str(opcode),
 		mask, final ? "final" : "more");
@@ -531,59 +691,84 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		header[1] |= payload_len;
 	} else if (payload_len < 65536) {
 		header[1] |= 126;
-		header[2] = payload_len >> 8;
-		header[3] = payload_len;
+		sys_put_be16(payload_len, &header[2]);
 		hdr_len += 2;
 	} else {
 		header[1] |= 127;
-		header[2] = 0;
-		header[3] = 0;
-		header[4] = 0;
-		header[5] = 0;
-		header[6] = payload_len >> 24;
-		header[7] = payload_len >> 16;
-		header[8] = payload_len >> 8;
-		header[9] = payload_len;
+		sys_put_be64(payload_len, &header[2]);
 		hdr_len += 8;
 	}
 
-	/* Add masking value if needed */
-	if (mask) {
-		int i;
+	if (!mask) {
+		return websocket_send_plain(ctx, header, hdr_len, iov, iovlen,
+					    timeout);
+	}
 
-		ctx->masking_value = sys_rand32_get();
+	/* Add masking value */
+	ctx->masking_value = sys_rand32_get();
 
-		header[hdr_len++] |= ctx->masking_value >> 24;
-		header[hdr_len++] |= ctx->masking_value >> 16;
-		header[hdr_len++] |= ctx->masking_value >> 8;
-		header[hdr_len++] |= ctx->masking_value;
+	sys_put_be32(ctx->masking_value, &header[hdr_len]);
+	hdr_len += 4;
 
-		data_to_send = k_malloc(payload_len);
-		if (!data_to_send) {
-			return -ENOMEM;
-		}
+	return websocket_send_masked(ctx, header, hdr_len, iov, iovlen,
+				     timeout);
+}
 
-		memcpy(data_to_send, payload, payload_len);
+static struct websocket_context *websocket_send_ctx(int ws_sock)
+{
+	struct websocket_context *ctx;
 
-		for (i = 0; i < payload_len; i++) {
-			data_to_send[i] ^=
-				ctx->masking_value >> (8 * (3 - i % 4));
-		}
+#if defined(CONFIG_NET_TEST)
+	/* Websocket unit test does not use socket layer but feeds
+	 * the data directly here when testing this function.
+	 */
+	ctx = INT_TO_POINTER(ws_sock);
+#else
+	ctx = z_get_fd_obj(ws_sock, NULL, 0);
+	if (ctx == NULL) {
+		return NULL;
 	}
 
-	ret = websocket_prepare_and_send(ctx, header, hdr_len,
-					 data_to_send, payload_len, timeout);
-	if (ret < 0) {
-		NET_DBG("Cannot send ws msg (%d)", -errno);
-		goto quit;
+	if (!PART_OF_ARRAY(contexts, ctx)) {
+		return NULL;
+	}
+#endif /* CONFIG_NET_TEST */
+
+	return ctx;
+}
+
+int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
+		       enum websocket_opcode opcode, bool mask, bool final,
+		       int32_t timeout)
+{
+	struct websocket_context *ctx;
+	struct iovec iov = {
+		.iov_base = (void *)payload,
+		.iov_len = payload_len,
+	};
+
+	ctx = websocket_send_ctx(ws_sock);
+	if (ctx == NULL) {
+		return -EBADF;
 	}
 
-quit:
-	if (data_to_send != payload) {
-		k_free(data_to_send);
+	return websocket_send_frame(ctx, &iov, 1, opcode, mask, final,
+				    timeout);
+}
+
+int websocket_send_msg_iov(int ws_sock, const struct iovec *iov,
+			   size_t iovlen, enum websocket_opcode opcode,
+			   bool mask, bool final, int32_t timeout)
+{
+	struct websocket_context *ctx;
+
+	ctx = websocket_send_ctx(ws_sock);
+	if (ctx == NULL) {
+		return -EBADF;
 	}
 
-	return ret - hdr_len;
+	return websocket_send_frame(ctx, iov, iovlen, opcode, mask, final,
+				    timeout);
 }
 
 static bool websocket_parse_header(uint8_t *buf, size_t buf_len, bool *masked,
@@ -776,17 +961,21 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 
 	/* Now read the whole payload or parts of it */
 
-	if (ctx->tmp_buf_pos == 0) {
-		/* Read more data into temp buffer */
+	if (ctx->tmp_buf_pos == 0 && ctx->total_read < ctx->message_len) {
+		/* Nothing is buffered, so read the data directly to the
+		 * caller buffer but not past the end of the message.
+		 */
+		can_copy = MIN(ctx->message_len - ctx->total_read, buf_len);
+
 #if defined(CONFIG_NET_TEST)
-		size_t input_len = MIN(ctx->tmp_buf_len, test_data->input_len);
+		size_t input_len = MIN(can_copy, test_data->input_len);
 
-		memcpy(ctx->tmp_buf, test_data->input_buf, input_len);
+		memcpy(buf, test_data->input_buf, input_len);
 		test_data->input_buf += input_len;
 
 		ret = input_len;
 #else
-		ret = recv(ctx->real_sock, ctx->tmp_buf, ctx->tmp_buf_len,
+		ret = recv(ctx->real_sock, buf, can_copy,
 			   K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
 #endif /* CONFIG_NET_TEST */
 
@@ -798,51 +987,39 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 			return 0;
 		}
 
-		ctx->tmp_buf_pos = ret;
-	}
+		recv_len = ret;
 
-	if (ctx->tmp_buf_pos <= buf_len) {
-		/* Is there already any data in the temp buffer? If yes,
-		 * just return it to the caller.
-		 */
-		can_copy = MIN(ctx->message_len - ctx->total_read,
-			       ctx->tmp_buf_pos);
+		/* Unmask the data in place */
+		if (ctx->masked) {
+			websocket_mask(buf, buf, recv_len, ctx->masking_value,
+				       ctx->total_read);
+		}
 	} else {
-		/* We have more data in tmp buffer that will fit into
-		 * user buffer.
-		 */
-		can_copy = MIN(ctx->message_len - ctx->total_read, buf_len);
-	}
+		/* Return the data already in the temp buffer */
+		can_copy = MIN(ctx->message_len - ctx->total_read,
+			       MIN(ctx->tmp_buf_pos, buf_len));
 
-	left = ctx->tmp_buf_pos - can_copy;
+		left = ctx->tmp_buf_pos - can_copy;
 
-	NET_ASSERT(ctx->tmp_buf_pos >= can_copy);
+		/* The data is unmasked while being copied */
+		if (ctx->masked) {
+			websocket_mask(buf, ctx->tmp_buf, can_copy,
+				       ctx->masking_value, ctx->total_read);
+		} else {
+			memmove(buf, ctx->tmp_buf, can_copy);
+		}
 
-	memmove(buf, ctx->tmp_buf, can_copy);
-	recv_len = can_copy;
+		recv_len = can_copy;
+
+		if (left > 0) {
+			memmove(ctx->tmp_buf, &ctx->tmp_buf[can_copy], left);
+		}
 
-	if (left > 0) {
-		memmove(ctx->tmp_buf, &ctx->tmp_buf[can_copy], left);
+		ctx->tmp_buf_pos = left;
 	}
 
-	ctx->tmp_buf_pos = left;
 	ctx->total_read += recv_len;
 
-	/* Unmask the data */
-	if (ctx->masked) {
-		/* As we might have less than 4 received bytes, we must select
-		 * which byte from masking value to take. The mask_shift will
-		 * tell that.
-		 */
-		int mask_shift = (ctx->total_read - recv_len) % sizeof(uint32_t);
-		int i;
-
-		for (i = 0; i < recv_len; i++) {
-			buf[i] ^= ctx->masking_value >>
-				(8 * (3 - (i + mask_shift) % 4));
-		}
-	}
-
 #if HEXDUMP_RECV_PACKETS
 	LOG_HEXDUMP_DBG(buf, recv_len, "Payload");
 #endif
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Throughput of the JSON library on hawkBit and UpdateHub style payloads:
+ *
+ * parse:  json_obj_parse() of the server responses, copied first
+ * stream: json_obj_stream_feed() of the server responses, in CHUNK_SIZE
+ *         bytes chunks
+ * encode: json_obj_encode_buf() of the client messages
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <string.h>
+
+#include <data/json.h>
+
+#define ROUNDS		200
+#define CHUNK_SIZE	64
+
+/* hawkBit deployment base response */
+struct href {
+	const char *href;
+};
+
+struct hashes {
+	const char *sha1;
+	const char *md5;
+	const char *sha256;
+};
+
+struct links {
+	struct href download_http;
+	struct href md5sum_http;
+};
+
+struct artifact {
+	const char *filename;
+	struct hashes hashes;
+	struct links _links;
+	int size;
+};
+
+struct chunk {
+	const char *part;
+	const char *name;
+	const char *version;
+	struct artifact artifacts[1];
+	size_t num_artifacts;
+};
+
+struct deploy {
+	const char *download;
+	const char *update;
+	struct chunk chunks[1];
+	size_t num_chunks;
+};
+
+struct deployment {
+	const char *id;
+	struct deploy deployment;
+};
+
+static const struct json_obj_descr href_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct href, href, JSON_TOK_STRING),
+};
+
+static const struct json_obj_descr hashes_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct hashes, sha1, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct hashes, md5, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct hashes, sha256, JSON_TOK_STRING),
+};
+
+static const struct json_obj_descr links_descr[] = {
+	JSON_OBJ_DESCR_OBJECT_NAMED(struct links, "download-http",
+				    download_http, href_descr),
+	JSON_OBJ_DESCR_OBJECT_NAMED(struct links, "md5sum-http",
+				    md5sum_http, href_descr),
+};
+
+static const struct json_obj_descr artifact_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct artifact, filename, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJECT(struct artifact, hashes, hashes_descr),
+	JSON_OBJ_DESCR_PRIM(struct artifact, size, JSON_TOK_NUMBER),
+	JSON_OBJ_DESCR_OBJECT(struct artifact, _links, links_descr),
+};
+
+static const struct json_obj_descr chunk_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct chunk, part, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct chunk, version, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct chunk, name, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJ_ARRAY(struct chunk, artifacts, 1, num_artifacts,
+				 artifact_descr, ARRAY_SIZE(artifact_descr)),
+};
+
+static const struct json_obj_descr deploy_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct deploy, download, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct deploy, update, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJ_ARRAY(struct deploy, chunks, 1, num_chunks,
+				 chunk_descr, ARRAY_SIZE(chunk_descr)),
+};
+
+static const struct json_obj_descr deployment_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct deployment, id, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJECT(struct deployment, deployment, deploy_descr),
+};
+
+static const char deployment_json[] =
+	"{\"id\":\"42\",\"deployment\":{\"download\":\"forced\","
+	"\"update\":\"forced\",\"maintenanceWindow\":\"available\","
+	"\"chunks\":[{\"part\":\"os\",\"version\":\"1.0.2\","
+	"\"name\":\"zephyr\",\"artifacts\":[{"
+	"\"filename\":\"zephyr.signed.bin\",\"hashes\":{"
+	"\"sha1\":\"e4d1c5bd4bc3b6f7ba9a1bb5b1a83e0bd48a1ee8\","
+	"\"md5\":\"0d1b08c34858921bc7c662b228acb7ba\","
+	"\"sha256\":\"a03b221c6c6eae7122ca51695d456d5222e524889136394944b2f9763b483615\"},"
+	"\"size\":159012,\"_links\":{\"download-http\":{"
+	"\"href\":\"http://192.0.2.2:8080/DEFAULT/controller/v1/zephyr/"
+	"softwaremodules/23/artifacts/zephyr.signed.bin\"},"
+	"\"md5sum-http\":{"
+	"\"href\":\"http://192.0.2.2:8080/DEFAULT/controller/v1/zephyr/"
+	"softwaremodules/23/artifacts/zephyr.signed.bin.MD5SUM\"}}}]}]}}";
+
+/* UpdateHub probe response */
+struct object {
+	const char *mode;
+	const char *sha256sum;
+	int size;
+};
+
+struct object_array {
+	struct object objects;
+};
+
+struct probe {
+	struct object_array objects[2];
+	size_t objects_len;
+	const char *product;
+	const char *supported_hardware;
+};
+
+static const struct json_obj_descr object_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct object, mode, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct object, sha256sum, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct object, size, JSON_TOK_NUMBER),
+};
+
+static const struct json_obj_descr object_array_descr[] = {
+	JSON_OBJ_DESCR_OBJECT(struct object_array, objects, object_descr),
+};
+
+static const struct json_obj_descr probe_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct probe, product, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM_NAMED(struct probe, "supported-hardware",
+				  supported_hardware, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_ARRAY_ARRAY(struct probe, objects, 2, objects_len,
+				   object_array_descr,
+				   ARRAY_SIZE(object_array_descr)),
+};
+
+static const char probe_json[] =
+	"{\"product\":\"5df3a2b9a21c4f5c8e0b3d5f3c4e2b1a\","
+	"\"version\":\"1.2.3\",\"supported-hardware\":\"any\","
+	"\"objects\":[[{\"mode\":\"raw\",\"filename\":\"zephyr.bin\","
+	"\"target\":\"/dev/flash\",\"target-type\":\"device\","
+	"\"sha256sum\":\"a03b221c6c6eae7122ca51695d456d5222e524889136394944b2f9763b483615\","
+	"\"size\":159012}],"
+	"[{\"mode\":\"raw\",\"filename\":\"zephyr.bin\","
+	"\"target\":\"/dev/flash\",\"target-type\":\"device\","
+	"\"sha256sum\":\"a03b221c6c6eae7122ca51695d456d5222e524889136394944b2f9763b483615\","
+	"\"size\":159012}]]}";
+
+/* hawkBit configuration data, and UpdateHub report */
+struct cfg_data {
+	const char *VIN;
+	const char *hwRevision;
+};
+
+struct status_result {
+	const char *finished;
+};
+
+struct status {
+	struct status_result result;
+	const char *execution;
+};
+
+struct cfg {
+	const char *mode;
+	struct cfg_data data;
+	const char *id;
+	const char *time;
+	struct status status;
+};
+
+struct identity {
+	const char *id;
+};
+
+struct report {
+	const char *product_uid;
+	const char *hardware;
+	const char *version;
+	struct identity device_identity;
+	const char *status;
+	const char *package_uid;
+	int64_t timestamp;
+};
+
+static const struct json_obj_descr cfg_data_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct cfg_data, VIN, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct cfg_data, hwRevision, JSON_TOK_STRING),
+};
+
+static const struct json_obj_descr status_result_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct status_result, finished, JSON_TOK_STRING),
+};
+
+static const struct json_obj_descr status_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct status, execution, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJECT(struct status, result, status_result_descr),
+};
+
+static const struct json_obj_descr cfg_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct cfg, mode, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJECT(struct cfg, data, cfg_data_descr),
+	JSON_OBJ_DESCR_PRIM(struct cfg, id, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct cfg, time, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJECT(struct cfg, status, status_descr),
+};
+
+static const struct json_obj_descr identity_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct identity, id, JSON_TOK_STRING),
+};
+
+static const struct json_obj_descr report_descr[] = {
+	JSON_OBJ_DESCR_PRIM_NAMED(struct report, "product-uid", product_uid,
+				  JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct report, hardware, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct report, version, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_OBJECT_NAMED(struct report, "device-identity",
+				    device_identity, identity_descr),
+	JSON_OBJ_DESCR_PRIM(struct report, status, JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM_NAMED(struct report, "package-uid", package_uid,
+				  JSON_TOK_STRING),
+	JSON_OBJ_DESCR_PRIM(struct report, timestamp, JSON_TOK_INT64),
+};
+
+static const struct cfg cfg = {
+	.mode = "merge",
+	.data = {
+		.VIN = "0ae9a1bc5e2d4c51",
+		.hwRevision = "3",
+	},
+	.id = "",
+	.time = "20200101T000000",
+	.status = {
+		.result = {
+			.finished = "success",
+		},
+		.execution = "closed",
+	},
+};
+
+static const struct report report = {
+	.product_uid = "5df3a2b9a21c4f5c8e0b3d5f3c4e2b1a",
+	.hardware = "qemu_x86",
+	.version = "1.2.3",
+	.device_identity = {
+		.id = "0ae9a1bc5e2d4c51",
+	},
+	.status = "downloading",
+	.package_uid = "a03b221c6c6eae7122ca51695d456d52",
+	.timestamp = 1577836800000LL,
+};
+
+static char payload[sizeof(deployment_json)];
+static char strings[sizeof(deployment_json)];
+static char encoded[512];
+static struct deployment deployment;
+static struct probe probe;
+
+static int parse(const char *json, size_t len,
+		 const struct json_obj_descr *descr, size_t descr_len,
+		 void *val)
+{
+	memcpy(payload, json, len);
+
+	return json_obj_parse(payload, len, descr, descr_len, val);
+}
+
+static int run_parse(void)
+{
+	size_t bytes = 0;
+	int round;
+
+	for (round = 0; round < ROUNDS; round++) {
+		if (parse(deployment_json, sizeof(deployment_json) - 1,
+			  deployment_descr, ARRAY_SIZE(deployment_descr),
+			  &deployment) < 0 ||
+		    parse(probe_json, sizeof(probe_json) - 1, probe_descr,
+			  ARRAY_SIZE(probe_descr), &probe) < 0) {
+			return -1;
+		}
+
+		bytes += sizeof(deployment_json) + sizeof(probe_json) - 2;
+	}
+
+	return bytes;
+}
+
+static int stream_parse(const char *json, size_t len,
+			const struct json_obj_descr *descr, size_t descr_len,
+			void *val)
+{
+	struct json_obj_stream stream;
+	size_t pos;
+	int ret;
+
+	json_obj_stream_init(&stream, descr, descr_len, val, strings,
+			     sizeof(strings));
+
+	for (pos = 0; pos < len; pos += CHUNK_SIZE) {
+		ret = json_obj_stream_feed(&stream, json + pos,
+					   MIN(CHUNK_SIZE, len - pos));
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return json_obj_stream_end(&stream);
+}
+
+static int run_stream(void)
+{
+	size_t bytes = 0;
+	int round;
+
+	for (round = 0; round < ROUNDS; round++) {
+		if (stream_parse(deployment_json, sizeof(deployment_json) - 1,
+				 deployment_descr, ARRAY_SIZE(deployment_descr),
+				 &deployment) < 0 ||
+		    stream_parse(probe_json, sizeof(probe_json) - 1,
+				 probe_descr, ARRAY_SIZE(probe_descr),
+				 &probe) < 0) {
+			return -1;
+		}
+
+		bytes += sizeof(deployment_json) + sizeof(probe_json) - 2;
+	}
+
+	return bytes;
+}
+
+static int run_encode(void)
+{
+	size_t bytes = 0;
+	int round;
+
+	for (round = 0; round < ROUNDS; round++) {
+		if (json_obj_encode_buf(cfg_descr, ARRAY_SIZE(cfg_descr), &cfg,
+					encoded, sizeof(encoded)) < 0) {
+			return -1;
+		}
+
+		bytes += strlen(encoded);
+
+		if (json_obj_encode_buf(report_descr, ARRAY_SIZE(report_descr),
+					&report, encoded,
+					sizeof(encoded)) < 0) {
+			return -1;
+		}
+
+		bytes += strlen(encoded);
+	}
+
+	return bytes;
+}
+
+static void report_run(const char *name, int (*run)(void))
+{
+	uint32_t start = k_cycle_get_32();
+	int count = run();
+	uint64_t us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	if (count < 0) {
+		printk("%s failed\n", name);
+		return;
+	}
+
+	printk("%-10s: %u bytes in %u us, %u bytes/s\n", name, count,
+	       (uint32_t)us, (uint32_t)(count * (uint64_t)USEC_PER_SEC / us));
+}
+
+void main(void)
+{
+	report_run("parse", run_parse);
+	report_run("stream", run_stream);
+	report_run("encode", run_encode);
+
+	printk("fin\n");
+}
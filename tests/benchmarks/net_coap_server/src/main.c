@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* CPU cost of the CoAP server helpers, on parsed packets.
+ *
+ * linear:     coap_handle_request() over RESOURCE_COUNT resources
+ * index:      coap_handle_request_index() over the same resources
+ * obs-flat:   coap_find_observer_by_addr() over the observers of all
+ *             resources
+ * obs-index:  coap_find_observer() over the observers of one resource
+ * block-64:   a BODY_SIZE body sent and received in blocks of 64 bytes
+ * block-1024: the same in blocks of 1024 bytes
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <string.h>
+
+#include <net/coap.h>
+
+#define RESOURCE_COUNT		64
+#define OBSERVERS_PER_RESOURCE	4
+#define OBSERVER_COUNT		(RESOURCE_COUNT * OBSERVERS_PER_RESOURCE)
+#define LOOKUP_COUNT		20000
+#define BODY_SIZE		4096
+#define BODY_ROUNDS		50
+
+#define REQUEST_SIZE		32
+#define BLOCK_PKT_SIZE		1100
+
+static int resource_get(struct coap_resource *resource,
+			struct coap_packet *request,
+			struct sockaddr *addr, socklen_t addr_len)
+{
+	return 0;
+}
+
+static char names[RESOURCE_COUNT][4];
+static const char *paths[RESOURCE_COUNT][3];
+static struct coap_resource resources[RESOURCE_COUNT + 1];
+static struct coap_resource *buckets[RESOURCE_COUNT];
+static struct coap_resource_index resource_index;
+
+static uint8_t request_data[RESOURCE_COUNT][REQUEST_SIZE];
+static struct coap_packet requests[RESOURCE_COUNT];
+static struct coap_option options[RESOURCE_COUNT][4];
+
+static struct coap_observer observers[OBSERVER_COUNT];
+static struct sockaddr_in observer_addr[OBSERVER_COUNT];
+
+static uint8_t tx_body[BODY_SIZE];
+static uint8_t rx_body[BODY_SIZE];
+static uint8_t req_data[BLOCK_PKT_SIZE];
+static uint8_t rsp_data[BLOCK_PKT_SIZE];
+
+static struct sockaddr_in peer = {
+	.sin_family = AF_INET,
+	.sin_port = htons(5683),
+	.sin_addr = { { { 192, 0, 2, 2 } } },
+};
+
+static int setup_resources(void)
+{
+	int i, r;
+
+	/* /sensors/<n> */
+	for (i = 0; i < RESOURCE_COUNT; i++) {
+		snprintk(names[i], sizeof(names[i]), "%d", i);
+		paths[i][0] = "sensors";
+		paths[i][1] = names[i];
+		paths[i][2] = NULL;
+
+		resources[i].path = paths[i];
+		resources[i].get = resource_get;
+
+		r = coap_packet_init(&requests[i], request_data[i],
+				     REQUEST_SIZE, 1, COAP_TYPE_CON, 0, NULL,
+				     COAP_METHOD_GET, coap_next_id());
+		r = r < 0 ? r :
+		    coap_packet_append_option(&requests[i],
+					      COAP_OPTION_URI_PATH,
+					      (const uint8_t *)"sensors",
+					      strlen("sensors"));
+		r = r < 0 ? r :
+		    coap_packet_append_option(&requests[i],
+					      COAP_OPTION_URI_PATH,
+					      (const uint8_t *)names[i],
+					      strlen(names[i]));
+		r = r < 0 ? r :
+		    coap_packet_parse(&requests[i], request_data[i],
+				      requests[i].offset, options[i],
+				      ARRAY_SIZE(options[i]));
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	return coap_resource_index_init(&resource_index, resources, buckets,
+					ARRAY_SIZE(buckets));
+}
+
+static void setup_observers(void)
+{
+	struct coap_observer *o;
+	uint32_t i;
+
+	for (i = 0; i < OBSERVER_COUNT; i++) {
+		o = &observers[i];
+
+		observer_addr[i] = peer;
+		observer_addr[i].sin_port = htons(1024 + i);
+
+		memcpy(&o->addr, &observer_addr[i], sizeof(observer_addr[i]));
+		memcpy(o->token, &i, sizeof(i));
+		o->tkl = sizeof(i);
+
+		coap_register_observer(&resources[i / OBSERVERS_PER_RESOURCE],
+				       o);
+	}
+}
+
+static int run_linear(void)
+{
+	uint32_t i, n;
+
+	for (i = 0; i < LOOKUP_COUNT; i++) {
+		n = (i * 7) % RESOURCE_COUNT;
+
+		if (coap_handle_request(&requests[n], resources, options[n],
+					ARRAY_SIZE(options[n]),
+					(struct sockaddr *)&peer,
+					sizeof(peer)) < 0) {
+			return -1;
+		}
+	}
+
+	return LOOKUP_COUNT;
+}
+
+static int run_index(void)
+{
+	uint32_t i, n;
+
+	for (i = 0; i < LOOKUP_COUNT; i++) {
+		n = (i * 7) % RESOURCE_COUNT;
+
+		if (coap_handle_request_index(&requests[n], &resource_index,
+					      options[n],
+					      ARRAY_SIZE(options[n]),
+					      (struct sockaddr *)&peer,
+					      sizeof(peer)) < 0) {
+			return -1;
+		}
+	}
+
+	return LOOKUP_COUNT;
+}
+
+static int run_obs_flat(void)
+{
+	uint32_t i, n;
+
+	for (i = 0; i < LOOKUP_COUNT; i++) {
+		n = (i * 7) % OBSERVER_COUNT;
+
+		if (coap_find_observer_by_addr(
+			    observers, OBSERVER_COUNT,
+			    (struct sockaddr *)&observer_addr[n]) !=
+		    &observers[n]) {
+			return -1;
+		}
+	}
+
+	return LOOKUP_COUNT;
+}
+
+static int run_obs_index(void)
+{
+	uint32_t i, n;
+
+	for (i = 0; i < LOOKUP_COUNT; i++) {
+		n = (i * 7) % OBSERVER_COUNT;
+
+		if (coap_find_observer(
+			    &resources[n / OBSERVERS_PER_RESOURCE],
+			    (struct sockaddr *)&observer_addr[n],
+			    (uint8_t *)&n, sizeof(n)) != &observers[n]) {
+			return -1;
+		}
+	}
+
+	return LOOKUP_COUNT;
+}
+
+/* Body sent with Block1 requests, each one acknowledged by a 2.31
+ * Continue response holding the Block1 option of the server.
+ */
+static int run_block(enum coap_block_size block_size)
+{
+	struct coap_block_transfer tx;
+	struct coap_block_transfer rx;
+	struct coap_packet req;
+	struct coap_packet rsp;
+	uint32_t blocks = 0;
+	bool first;
+	int round;
+	int last;
+	int r;
+
+	for (round = 0; round < BODY_ROUNDS; round++) {
+		coap_block_transfer_setup(&tx, block_size, tx_body,
+					  sizeof(tx_body), sizeof(tx_body));
+		coap_block_transfer_setup(&rx, block_size, rx_body,
+					  sizeof(rx_body), 0);
+		first = true;
+
+		do {
+			r = coap_packet_init(&req, req_data, sizeof(req_data),
+					     1, COAP_TYPE_CON, 0, NULL,
+					     COAP_METHOD_POST, coap_next_id());
+			last = r < 0 ? r :
+			       coap_block_transfer_send(&tx, &req,
+							first ? NULL : &rsp);
+			if (last < 0 ||
+			    coap_packet_parse(&req, req_data, req.offset,
+					      NULL, 0) < 0 ||
+			    coap_block_transfer_recv(&rx, &req) != last) {
+				return -1;
+			}
+
+			r = coap_packet_init(&rsp, rsp_data, sizeof(rsp_data),
+					     1, COAP_TYPE_ACK, 0, NULL,
+					     COAP_RESPONSE_CODE_CONTINUE,
+					     coap_header_get_id(&req));
+			r = r < 0 ? r : coap_append_block1_option(&rsp,
+								  &rx.ctx);
+			if (r < 0 ||
+			    coap_packet_parse(&rsp, rsp_data, rsp.offset,
+					      NULL, 0) < 0) {
+				return -1;
+			}
+
+			first = false;
+			blocks++;
+		} while (!last);
+	}
+
+	if (memcmp(rx_body, tx_body, sizeof(tx_body))) {
+		return -1;
+	}
+
+	return blocks;
+}
+
+static int run_block_64(void)
+{
+	return run_block(COAP_BLOCK_64);
+}
+
+static int run_block_1024(void)
+{
+	return run_block(COAP_BLOCK_1024);
+}
+
+static void run(const char *name, const char *unit, int (*fn)(void))
+{
+	uint32_t start;
+	uint64_t us;
+	int count;
+
+	start = k_cycle_get_32();
+
+	count = fn();
+	if (count < 0) {
+		printk("%s failed\n", name);
+		return;
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%-10s: %u %s in %u us, %u %s/s\n", name, count, unit,
+	       (uint32_t)us, (uint32_t)(count * (uint64_t)USEC_PER_SEC / us),
+	       unit);
+}
+
+void main(void)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(tx_body); i++) {
+		tx_body[i] = i;
+	}
+
+	if (setup_resources() < 0) {
+		printk("Cannot set up the resources\n");
+		return;
+	}
+
+	setup_observers();
+
+	run("linear", "lookups", run_linear);
+	run("index", "lookups", run_index);
+	run("obs-flat", "lookups", run_obs_flat);
+	run("obs-index", "lookups", run_obs_index);
+	run("block-64", "blocks", run_block_64);
+	run("block-1024", "blocks", run_block_1024);
+
+	printk("fin\n");
+}
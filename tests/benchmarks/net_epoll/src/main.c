@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Wait rate for one active socket among many idle ones, with poll() and
+ * with epoll_wait().
+ *
+ * The main thread sends a datagram to the active socket over the loopback
+ * interface, waits until it is readable and receives the datagram before
+ * sending the next one.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <net/socket.h>
+
+#define N_ROUNDS	5000
+#define MAX_IDLE	256
+#define PAYLOAD_LEN	32
+#define PORT		4242
+#define IDLE_PORT	5000
+
+static struct zsock_pollfd fds[MAX_IDLE + 1];
+static int idle_socks[MAX_IDLE];
+static uint8_t data[PAYLOAD_LEN];
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static int open_idle(int from, int to)
+{
+	struct sockaddr_in idle_addr = addr;
+	int i;
+
+	for (i = from; i < to; i++) {
+		idle_socks[i] = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (idle_socks[i] < 0) {
+			return -1;
+		}
+
+		idle_addr.sin_port = htons(IDLE_PORT + i);
+		if (zsock_bind(idle_socks[i], (struct sockaddr *)&idle_addr,
+			       sizeof(idle_addr)) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int wait_poll(int rx_sock, int n_idle)
+{
+	int i, ret;
+
+	for (i = 0; i < n_idle; i++) {
+		fds[i].fd = idle_socks[i];
+		fds[i].events = ZSOCK_POLLIN;
+	}
+
+	/* The active socket is checked last */
+	fds[n_idle].fd = rx_sock;
+	fds[n_idle].events = ZSOCK_POLLIN;
+
+	ret = zsock_poll(fds, n_idle + 1, -1);
+	if (ret != 1 || fds[n_idle].revents != ZSOCK_POLLIN) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int wait_epoll(int epfd, int rx_sock)
+{
+	struct zsock_epoll_event ev;
+	int ret;
+
+	ret = zsock_epoll_wait(epfd, &ev, 1, -1);
+	if (ret != 1 || ev.data.fd != rx_sock) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int epoll_register(int epfd, int fd)
+{
+	struct zsock_epoll_event ev = {
+		.events = ZSOCK_EPOLLIN,
+		.data.fd = fd,
+	};
+
+	return zsock_epoll_ctl(epfd, ZSOCK_EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void run(int tx_sock, int rx_sock, int n_idle, bool epoll)
+{
+	uint32_t start;
+	uint64_t us;
+	int epfd = -1;
+	int i, ret;
+
+	if (epoll) {
+		epfd = zsock_epoll_create(0);
+		if (epfd < 0 || epoll_register(epfd, rx_sock) < 0) {
+			printk("Cannot create epoll instance (%d)\n", errno);
+			goto out;
+		}
+
+		for (i = 0; i < n_idle; i++) {
+			if (epoll_register(epfd, idle_socks[i]) < 0) {
+				printk("Cannot register socket (%d)\n", errno);
+				goto out;
+			}
+		}
+	}
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_ROUNDS; i++) {
+		ret = zsock_send(tx_sock, data, PAYLOAD_LEN, 0);
+		if (ret != PAYLOAD_LEN) {
+			printk("Cannot send (%d, %d)\n", ret, errno);
+			goto out;
+		}
+
+		if (epoll) {
+			ret = wait_epoll(epfd, rx_sock);
+		} else {
+			ret = wait_poll(rx_sock, n_idle);
+		}
+
+		if (ret < 0) {
+			printk("Cannot wait (%d)\n", errno);
+			goto out;
+		}
+
+		ret = zsock_recv(rx_sock, data, PAYLOAD_LEN, 0);
+		if (ret != PAYLOAD_LEN) {
+			printk("Cannot receive (%d, %d)\n", ret, errno);
+			goto out;
+		}
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%-5s idle %3d: %d waits in %u us, %u waits/s\n",
+	       epoll ? "epoll" : "poll", n_idle, N_ROUNDS, (uint32_t)us,
+	       (uint32_t)(N_ROUNDS * (uint64_t)USEC_PER_SEC / us));
+
+out:
+	if (epfd >= 0) {
+		zsock_close(epfd);
+	}
+}
+
+void main(void)
+{
+	int tx_sock, rx_sock;
+	int n_idle, opened = 0;
+	int i;
+
+	rx_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	tx_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (rx_sock < 0 || tx_sock < 0) {
+		printk("Cannot create UDP sockets (%d)\n", errno);
+		return;
+	}
+
+	if (zsock_bind(rx_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_connect(tx_sock, (struct sockaddr *)&addr,
+			  sizeof(addr)) < 0) {
+		printk("Cannot connect UDP sockets (%d)\n", errno);
+		goto out;
+	}
+
+	for (n_idle = 16; n_idle <= MAX_IDLE; n_idle *= 4) {
+		if (open_idle(opened, n_idle) < 0) {
+			printk("Cannot open idle sockets (%d)\n", errno);
+			goto out;
+		}
+
+		opened = n_idle;
+
+		run(tx_sock, rx_sock, n_idle, false);
+		run(tx_sock, rx_sock, n_idle, true);
+	}
+
+out:
+	for (i = 0; i < opened; i++) {
+		zsock_close(idle_socks[i]);
+	}
+
+	zsock_close(tx_sock);
+	zsock_close(rx_sock);
+
+	printk("fin\n");
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* CPU time per received TCP byte. The main thread acts as an Ethernet
+ * driver and passes bursts of in-order segments of one connection to the
+ * stack with the scheduler locked, so that a whole burst is queued before
+ * the RX thread runs, as it would be after an interrupt.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+#include <net/net_pkt.h>
+
+#include <eth_test_helpers.h>
+
+#include "connection.h"
+
+#define N_SEGMENTS	2048
+#define MAX_BURST	16
+#define MSS		1000
+#define PORT_SRC	5000
+#define PORT_DST	4242
+#define SEQ		0x12345678
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+#define FRAME_LEN	(sizeof(struct net_eth_hdr) + NET_IPV4TCPH_LEN + MSS)
+
+static struct in_addr in4addr_my = { { { 192, 0, 2, 1 } } };
+static struct in_addr in4addr_peer = { { { 192, 0, 2, 2 } } };
+
+static uint8_t frames[MAX_BURST][FRAME_LEN];
+
+static struct net_if *bench_iface;
+static struct eth_context eth_context;
+
+static size_t received;
+static int delivered;
+static K_SEM_DEFINE(done, 0, 1);
+
+static int eth_tx(const struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static struct ethernet_api api_funcs = {
+	.iface_api.init = eth_iface_init,
+	.send = eth_tx,
+};
+
+ETH_NET_DEVICE_INIT(eth_bench, "eth_bench", eth_init, device_pm_control_nop,
+		    &eth_context, NULL, CONFIG_ETH_INIT_PRIORITY, &api_funcs,
+		    NET_ETH_MTU);
+
+/* The segments of a burst follow each other, the last one has PSH set */
+static void build_frame(uint8_t *frame, int idx, int burst)
+{
+	struct net_eth_hdr *eth_hdr = (struct net_eth_hdr *)frame;
+	struct net_ipv4_hdr *ip_hdr;
+	struct net_tcp_hdr *tcp_hdr;
+	uint8_t *payload;
+	uint16_t sum;
+	int i;
+
+	memset(frame, 0, FRAME_LEN);
+
+	memcpy(eth_hdr->dst.addr, eth_context.mac_addr,
+	       sizeof(eth_hdr->dst.addr));
+	eth_hdr->src.addr[5] = 0x42;
+	eth_hdr->type = htons(NET_ETH_PTYPE_IP);
+
+	ip_hdr = (struct net_ipv4_hdr *)(eth_hdr + 1);
+	ip_hdr->vhl = 0x45;
+	ip_hdr->len = htons(NET_IPV4TCPH_LEN + MSS);
+	ip_hdr->ttl = 64;
+	ip_hdr->proto = IPPROTO_TCP;
+	net_ipaddr_copy(&ip_hdr->src, &in4addr_peer);
+	net_ipaddr_copy(&ip_hdr->dst, &in4addr_my);
+	ip_hdr->chksum = ~htons(chksum(0, (uint8_t *)ip_hdr, NET_IPV4H_LEN));
+
+	tcp_hdr = (struct net_tcp_hdr *)(ip_hdr + 1);
+	tcp_hdr->src_port = htons(PORT_SRC);
+	tcp_hdr->dst_port = htons(PORT_DST);
+	sys_put_be32(SEQ + idx * MSS, tcp_hdr->seq);
+	sys_put_be32(1, tcp_hdr->ack);
+	tcp_hdr->offset = (NET_TCPH_LEN / 4) << 4;
+	tcp_hdr->flags = idx == burst - 1 ? TCP_ACK | TCP_PSH : TCP_ACK;
+	sys_put_be16(8192, tcp_hdr->wnd);
+
+	payload = (uint8_t *)(tcp_hdr + 1);
+	for (i = 0; i < MSS; i++) {
+		payload[i] = (uint8_t)i;
+	}
+
+	sum = chksum(IPPROTO_TCP + NET_TCPH_LEN + MSS,
+		     (uint8_t *)&ip_hdr->src, 2 * sizeof(struct in_addr));
+	tcp_hdr->chksum = ~htons(chksum(sum, (uint8_t *)tcp_hdr,
+					NET_TCPH_LEN + MSS));
+}
+
+static enum net_verdict tcp_received(struct net_conn *conn,
+				     struct net_pkt *pkt,
+				     union net_ip_header *ip_hdr,
+				     union net_proto_header *proto_hdr,
+				     void *user_data)
+{
+	received += net_pkt_remaining_data(pkt);
+	delivered++;
+
+	net_pkt_unref(pkt);
+
+	if (received == N_SEGMENTS * MSS) {
+		k_sem_give(&done);
+	}
+
+	return NET_OK;
+}
+
+static void run(int burst)
+{
+	struct net_pkt *pkts[MAX_BURST];
+	uint32_t start, cycles;
+	uint64_t us;
+	int i, j;
+
+	for (i = 0; i < burst; i++) {
+		build_frame(frames[i], i, burst);
+	}
+
+	received = 0;
+	delivered = 0;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_SEGMENTS; i += burst) {
+		for (j = 0; j < burst; j++) {
+			/* Waiting for a free packet throttles the generator
+			 * to the speed of the stack.
+			 */
+			pkts[j] = net_pkt_rx_alloc_with_buffer(bench_iface,
+							       FRAME_LEN,
+							       AF_UNSPEC, 0,
+							       K_FOREVER);
+			if (!pkts[j] ||
+			    net_pkt_write(pkts[j], frames[j], FRAME_LEN)) {
+				printk("Cannot allocate pkt\n");
+				return;
+			}
+		}
+
+		k_sched_lock();
+
+		for (j = 0; j < burst; j++) {
+			if (net_recv_data(bench_iface, pkts[j]) < 0) {
+				k_sched_unlock();
+				printk("Cannot pass pkt to the stack\n");
+				return;
+			}
+		}
+
+		k_sched_unlock();
+	}
+
+	if (k_sem_take(&done, K_SECONDS(60))) {
+		printk("Timeout, %zu bytes received\n", received);
+		return;
+	}
+
+	cycles = k_cycle_get_32() - start;
+	us = MAX(k_cyc_to_us_floor64(cycles), 1);
+
+	printk("burst %2d: %d bytes in %u us, %u cycles/KiB, %d packets up\n",
+	       burst, N_SEGMENTS * MSS, (uint32_t)us,
+	       (uint32_t)((uint64_t)cycles * 1024U / (N_SEGMENTS * MSS)),
+	       delivered);
+}
+
+void main(void)
+{
+	struct net_conn_handle *handle;
+	int burst;
+
+	bench_iface = net_if_get_first_by_type(&NET_L2_GET_NAME(ETHERNET));
+	if (!bench_iface) {
+		printk("No Ethernet interface\n");
+		return;
+	}
+
+	net_if_ipv4_addr_add(bench_iface, &in4addr_my, NET_ADDR_MANUAL, 0);
+
+	if (net_conn_register(IPPROTO_TCP, AF_INET, NULL, NULL, PORT_SRC,
+			      PORT_DST, tcp_received, NULL, &handle) < 0) {
+		printk("Cannot register TCP handler\n");
+		return;
+	}
+
+	for (burst = 1; burst <= MAX_BURST; burst *= 2) {
+		run(burst);
+	}
+
+	printk("fin\n");
+}
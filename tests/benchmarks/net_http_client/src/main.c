@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Requests per second done by the HTTP client against a local server
+ * stand-in, with a new connection per request, with a persistent
+ * connection, with pipelined requests and with streamed request bodies.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/http_client.h>
+#include <net/http_server.h>
+
+#define PORT		8080
+#define TIMEOUT_MS	3000
+#define CLOSE_COUNT	50
+#define REQ_COUNT	1000
+#define UPLOAD_COUNT	200
+#define PIPELINE_DEPTH	8
+#define CHUNK_COUNT	4
+#define CHUNK_SIZE	64
+
+static int ok_cb(struct http_server_req *req, void *user_data)
+{
+	return http_server_send_response(req, 200, "text/plain", "ok", 2);
+}
+
+HTTP_RESOURCE_DYNAMIC_DEFINE(ok_resource, "/ok", ok_cb, NULL);
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static const char *close_headers[] = {
+	"Connection: close" HTTP_CRLF,
+	NULL
+};
+
+static struct http_request reqs[PIPELINE_DEPTH];
+static struct http_request *req_ptrs[PIPELINE_DEPTH];
+static uint8_t recv_buf[512];
+static uint8_t chunk[CHUNK_SIZE];
+static int chunks_left;
+static int responses;
+
+static void body_cb(struct http_response *rsp, const uint8_t *data,
+		    size_t len, void *user_data)
+{
+}
+
+static ssize_t producer(struct http_request *req, const void **data,
+			void *user_data)
+{
+	if (chunks_left == 0) {
+		return 0;
+	}
+
+	chunks_left--;
+	*data = chunk;
+
+	return sizeof(chunk);
+}
+
+static void init_req(struct http_request *req, enum http_method method)
+{
+	(void)memset(req, 0, sizeof(*req));
+
+	req->method = method;
+	req->url = "/ok";
+	req->host = "192.0.2.1";
+	req->protocol = "HTTP/1.1";
+	req->body_cb = body_cb;
+	req->recv_buf = recv_buf;
+	req->recv_buf_len = sizeof(recv_buf);
+}
+
+static int connect_server(void)
+{
+	int sock;
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0) {
+		return -1;
+	}
+
+	if (zsock_connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		zsock_close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+/* Do the request and count the response if the connection can be reused
+ * as expected.
+ */
+static int request(int sock, struct http_request *req, bool keep_alive)
+{
+	if (http_client_req(sock, req, TIMEOUT_MS, NULL) < 0 ||
+	    !req->internal.response.message_complete ||
+	    req->internal.parser.status_code != 200 ||
+	    req->internal.response.keep_alive != keep_alive) {
+		return -1;
+	}
+
+	responses++;
+
+	return 0;
+}
+
+static int run_close(void)
+{
+	int ret = 0;
+	int sock;
+	int i;
+
+	for (i = 0; i < CLOSE_COUNT && ret == 0; i++) {
+		sock = connect_server();
+		if (sock < 0) {
+			return -1;
+		}
+
+		init_req(&reqs[0], HTTP_GET);
+		reqs[0].header_fields = close_headers;
+
+		ret = request(sock, &reqs[0], false);
+
+		zsock_close(sock);
+	}
+
+	return ret;
+}
+
+static int run_keep_alive(void)
+{
+	int ret = 0;
+	int sock;
+	int i;
+
+	sock = connect_server();
+	if (sock < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < REQ_COUNT && ret == 0; i++) {
+		init_req(&reqs[0], HTTP_GET);
+		ret = request(sock, &reqs[0], true);
+	}
+
+	zsock_close(sock);
+
+	return ret;
+}
+
+static int run_pipelined(void)
+{
+	int ret = 0;
+	int sock;
+	int i, j;
+
+	sock = connect_server();
+	if (sock < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < REQ_COUNT && ret == 0; i += PIPELINE_DEPTH) {
+		for (j = 0; j < PIPELINE_DEPTH; j++) {
+			init_req(&reqs[j], HTTP_GET);
+		}
+
+		if (http_client_req_pipelined(sock, req_ptrs, PIPELINE_DEPTH,
+					      TIMEOUT_MS, NULL) < 0) {
+			ret = -1;
+			break;
+		}
+
+		for (j = 0; j < PIPELINE_DEPTH; j++) {
+			if (reqs[j].internal.parser.status_code == 200) {
+				responses++;
+			}
+		}
+	}
+
+	zsock_close(sock);
+
+	return ret;
+}
+
+static int run_chunked(void)
+{
+	int ret = 0;
+	int sock;
+	int i;
+
+	sock = connect_server();
+	if (sock < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < UPLOAD_COUNT && ret == 0; i++) {
+		init_req(&reqs[0], HTTP_POST);
+		reqs[0].payload_producer = producer;
+		chunks_left = CHUNK_COUNT;
+
+		ret = request(sock, &reqs[0], true);
+	}
+
+	zsock_close(sock);
+
+	return ret;
+}
+
+static void run(const char *name, int (*fn)(void))
+{
+	uint32_t start;
+	uint64_t us;
+
+	responses = 0;
+	start = k_cycle_get_32();
+
+	if (fn() < 0) {
+		printk("%s failed after %d responses (%d)\n", name, responses,
+		       errno);
+		return;
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%-10s: %u requests in %u us, %u req/s\n", name, responses,
+	       (uint32_t)us, (uint32_t)(responses * USEC_PER_SEC / us));
+}
+
+void main(void)
+{
+	int i;
+
+	for (i = 0; i < PIPELINE_DEPTH; i++) {
+		req_ptrs[i] = &reqs[i];
+	}
+
+	(void)memset(chunk, 'a', sizeof(chunk));
+
+	if (http_server_start(PORT) < 0) {
+		printk("Cannot start HTTP server\n");
+		return;
+	}
+
+	run("close", run_close);
+	run("keep-alive", run_keep_alive);
+	run("pipelined", run_pipelined);
+	run("chunked", run_chunked);
+
+	printk("fin\n");
+}
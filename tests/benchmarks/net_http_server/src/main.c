@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Requests per second served by the HTTP server over a loopback
+ * connection, with a new connection per request, with a persistent
+ * connection and with pipelined requests.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/http_parser.h>
+#include <net/http_server.h>
+
+#define PORT		8080
+#define CLOSE_COUNT	50
+#define REQ_COUNT	1000
+#define PIPELINE_DEPTH	8
+
+#define REQUEST "GET /index.html HTTP/1.1\r\n"				\
+		"Host: 192.0.2.1\r\n"					\
+		"Accept-Encoding: gzip\r\n"				\
+		"\r\n"
+
+#define REQUEST_CLOSE "GET /index.html HTTP/1.1\r\n"			\
+		      "Host: 192.0.2.1\r\n"				\
+		      "Accept-Encoding: gzip\r\n"			\
+		      "Connection: close\r\n"				\
+		      "\r\n"
+
+static const uint8_t index_html_gz[] = {
+#include "index.html.gz.inc"
+};
+
+HTTP_RESOURCE_STATIC_DEFINE(index_resource, "/index.html", "text/html",
+			    "gzip", index_html_gz, sizeof(index_html_gz));
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static char pipeline[PIPELINE_DEPTH * (sizeof(REQUEST) - 1)];
+static char rx_buf[1460];
+
+static struct http_parser parser;
+static int responses;
+
+static int on_message_complete(struct http_parser *p)
+{
+	if (p->status_code == 200) {
+		responses++;
+	}
+
+	return 0;
+}
+
+static const struct http_parser_settings parser_settings = {
+	.on_message_complete = on_message_complete,
+};
+
+static int connect_server(void)
+{
+	int sock;
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0) {
+		return -1;
+	}
+
+	if (zsock_connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		zsock_close(sock);
+		return -1;
+	}
+
+	http_parser_init(&parser, HTTP_RESPONSE);
+
+	return sock;
+}
+
+static int send_all(int sock, const char *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = zsock_send(sock, buf, len, 0);
+		if (ret < 0) {
+			return -1;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+/* Receive and parse the responses until there are count of them */
+static int wait_responses(int sock, int count)
+{
+	ssize_t len;
+
+	while (responses < count) {
+		len = zsock_recv(sock, rx_buf, sizeof(rx_buf), 0);
+		if (len <= 0) {
+			return -1;
+		}
+
+		if (http_parser_execute(&parser, &parser_settings, rx_buf,
+					len) != len) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int run_close(void)
+{
+	int sock;
+	int i;
+
+	for (i = 0; i < CLOSE_COUNT; i++) {
+		sock = connect_server();
+		if (sock < 0) {
+			return -1;
+		}
+
+		if (send_all(sock, REQUEST_CLOSE, sizeof(REQUEST_CLOSE) - 1) ||
+		    wait_responses(sock, i + 1)) {
+			zsock_close(sock);
+			return -1;
+		}
+
+		zsock_close(sock);
+	}
+
+	return 0;
+}
+
+static int run_keep_alive(void)
+{
+	int ret = 0;
+	int sock;
+	int i;
+
+	sock = connect_server();
+	if (sock < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < REQ_COUNT && ret == 0; i++) {
+		ret = send_all(sock, REQUEST, sizeof(REQUEST) - 1);
+		ret = ret ? ret : wait_responses(sock, i + 1);
+	}
+
+	zsock_close(sock);
+
+	return ret;
+}
+
+static int run_pipelined(void)
+{
+	int ret = 0;
+	int sock;
+	int i;
+
+	sock = connect_server();
+	if (sock < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < REQ_COUNT && ret == 0; i += PIPELINE_DEPTH) {
+		ret = send_all(sock, pipeline, sizeof(pipeline));
+		ret = ret ? ret : wait_responses(sock, i + PIPELINE_DEPTH);
+	}
+
+	zsock_close(sock);
+
+	return ret;
+}
+
+static void run(const char *name, int (*fn)(void))
+{
+	uint32_t start;
+	uint64_t us;
+
+	responses = 0;
+	start = k_cycle_get_32();
+
+	if (fn() < 0) {
+		printk("%s failed after %d responses (%d)\n", name, responses,
+		       errno);
+		return;
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%-10s: %u requests in %u us, %u req/s\n", name, responses,
+	       (uint32_t)us, (uint32_t)(responses * USEC_PER_SEC / us));
+}
+
+void main(void)
+{
+	int i;
+
+	for (i = 0; i < PIPELINE_DEPTH; i++) {
+		memcpy(pipeline + i * (sizeof(REQUEST) - 1), REQUEST,
+		       sizeof(REQUEST) - 1);
+	}
+
+	if (http_server_start(PORT) < 0) {
+		printk("Cannot start HTTP server\n");
+		return;
+	}
+
+	run("close", run_close);
+	run("keep-alive", run_keep_alive);
+	run("pipelined", run_pipelined);
+
+	printk("fin\n");
+}
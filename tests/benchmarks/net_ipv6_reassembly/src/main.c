@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Rate of large UDP datagrams over the IPv6 loopback interface, which are
+ * fragmented when sent and reassembled when received.
+ *
+ * The main thread sends a datagram and receives it back on the other
+ * socket before sending the next one.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <net/socket.h>
+
+#define N_DATAGRAMS	2000
+#define MAX_SIZE	8192
+#define PORT		4242
+
+static const int sizes[] = { 1024, 4096, MAX_SIZE };
+
+static uint8_t tx_data[MAX_SIZE];
+static uint8_t rx_data[MAX_SIZE];
+
+static struct sockaddr_in6 addr = {
+	.sin6_family = AF_INET6,
+	.sin6_port = htons(PORT),
+	.sin6_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+			   0, 0, 0, 0, 0, 0, 0, 0x1 } } },
+};
+
+static void run(int tx_sock, int rx_sock, int size)
+{
+	uint32_t start;
+	uint64_t us;
+	ssize_t ret;
+	int i;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_DATAGRAMS; i++) {
+		tx_data[0] = i;
+
+		ret = zsock_send(tx_sock, tx_data, size, 0);
+		if (ret != size) {
+			printk("Cannot send (%d, %d)\n", (int)ret, errno);
+			return;
+		}
+
+		ret = zsock_recv(rx_sock, rx_data, sizeof(rx_data), 0);
+		if (ret < 0) {
+			printk("Cannot receive (%d)\n", errno);
+			return;
+		}
+
+		if (ret != size || memcmp(rx_data, tx_data, size)) {
+			printk("Invalid datagram %d\n", i);
+			return;
+		}
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("size %5d: %d datagrams in %u us, %u datagrams/s, %u kB/s\n",
+	       size, N_DATAGRAMS, (uint32_t)us,
+	       (uint32_t)(N_DATAGRAMS * (uint64_t)USEC_PER_SEC / us),
+	       (uint32_t)(N_DATAGRAMS * (uint64_t)size * USEC_PER_SEC /
+			  1024 / us));
+}
+
+void main(void)
+{
+	int tx_sock, rx_sock;
+	int i;
+
+	for (i = 0; i < sizeof(tx_data); i++) {
+		tx_data[i] = i;
+	}
+
+	rx_sock = zsock_socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	tx_sock = zsock_socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	if (rx_sock < 0 || tx_sock < 0) {
+		printk("Cannot create UDP sockets (%d)\n", errno);
+		return;
+	}
+
+	if (zsock_bind(rx_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_connect(tx_sock, (struct sockaddr *)&addr,
+			  sizeof(addr)) < 0) {
+		printk("Cannot connect UDP sockets (%d)\n", errno);
+		goto out;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		run(tx_sock, rx_sock, sizes[i]);
+	}
+
+out:
+	zsock_close(tx_sock);
+	zsock_close(rx_sock);
+
+	printk("fin\n");
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Notifications per second sent by the LwM2M engine to a local server
+ * stand-in, which observes the value of OBSERVER_COUNT temperature sensor
+ * instances and acknowledges each notification.
+ *
+ * set:    resource updates with lwm2m_engine_set_float32(), each one
+ *         looking up the object instance and its observer
+ * notify: notifications received after NOTIFY_ROUNDS updates of all the
+ *         resources, timed from the first notification to the last one
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/coap.h>
+#include <net/lwm2m.h>
+
+#define PORT		5683
+#define OBSERVER_COUNT	CONFIG_LWM2M_IPSO_TEMP_SENSOR_INSTANCE_COUNT
+#define SET_ROUNDS	50
+#define NOTIFY_ROUNDS	5
+#define TIMEOUT_MS	2000
+
+#define PKT_SIZE	128
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static struct lwm2m_ctx client;
+static struct sockaddr client_addr;
+static int server_sock;
+
+static char paths[OBSERVER_COUNT][sizeof("3303/65535/5700")];
+static uint8_t pkt_buf[PKT_SIZE];
+static uint8_t ack_buf[PKT_SIZE];
+
+static int server_recv(struct coap_packet *pkt, int timeout)
+{
+	struct zsock_pollfd fds = {
+		.fd = server_sock,
+		.events = ZSOCK_POLLIN,
+	};
+	ssize_t len;
+
+	if (zsock_poll(&fds, 1, timeout) <= 0) {
+		return -ETIMEDOUT;
+	}
+
+	len = zsock_recv(server_sock, pkt_buf, sizeof(pkt_buf), 0);
+	if (len < 0) {
+		return -errno;
+	}
+
+	return coap_packet_parse(pkt, pkt_buf, len, NULL, 0);
+}
+
+static int server_ack(struct coap_packet *pkt)
+{
+	struct coap_packet ack;
+	int r;
+
+	r = coap_packet_init(&ack, ack_buf, sizeof(ack_buf), 1, COAP_TYPE_ACK,
+			     0, NULL, 0, coap_header_get_id(pkt));
+	if (r < 0) {
+		return r;
+	}
+
+	if (zsock_sendto(server_sock, ack.data, ack.offset, 0, &client_addr,
+			 sizeof(struct sockaddr_in)) < 0) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+/* GET with Observe 0 on 3303/<n>/5700, token n */
+static int server_observe(uint32_t n)
+{
+	struct coap_packet pkt;
+	char inst[6];
+	int r;
+
+	snprintk(inst, sizeof(inst), "%u", n);
+
+	r = coap_packet_init(&pkt, ack_buf, sizeof(ack_buf), 1, COAP_TYPE_CON,
+			     sizeof(n), (uint8_t *)&n, COAP_METHOD_GET,
+			     coap_next_id());
+	r = r < 0 ? r : coap_append_option_int(&pkt, COAP_OPTION_OBSERVE, 0);
+	r = r < 0 ? r : coap_packet_append_option(&pkt, COAP_OPTION_URI_PATH,
+						  (const uint8_t *)"3303",
+						  strlen("3303"));
+	r = r < 0 ? r : coap_packet_append_option(&pkt, COAP_OPTION_URI_PATH,
+						  (const uint8_t *)inst,
+						  strlen(inst));
+	r = r < 0 ? r : coap_packet_append_option(&pkt, COAP_OPTION_URI_PATH,
+						  (const uint8_t *)"5700",
+						  strlen("5700"));
+	if (r < 0) {
+		return r;
+	}
+
+	if (zsock_sendto(server_sock, pkt.data, pkt.offset, 0, &client_addr,
+			 sizeof(struct sockaddr_in)) < 0) {
+		return -errno;
+	}
+
+	r = server_recv(&pkt, TIMEOUT_MS);
+	if (r < 0) {
+		return r;
+	}
+
+	if (coap_header_get_type(&pkt) != COAP_TYPE_ACK ||
+	    coap_header_get_code(&pkt) != COAP_RESPONSE_CODE_CONTENT) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int setup(void)
+{
+	socklen_t len = sizeof(client_addr);
+	uint32_t i;
+	int r;
+
+	server_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (server_sock < 0 ||
+	    zsock_bind(server_sock, (struct sockaddr *)&addr,
+		       sizeof(addr)) < 0) {
+		return -errno;
+	}
+
+	lwm2m_engine_set_string("0/0/0", "coap://192.0.2.1:5683");
+	lwm2m_engine_set_u8("0/0/2", 3);
+
+	for (i = 0; i < OBSERVER_COUNT; i++) {
+		snprintk(paths[i], sizeof(paths[i]), "3303/%u", i);
+		r = lwm2m_engine_create_obj_inst(paths[i]);
+		if (r < 0) {
+			return r;
+		}
+
+		strcat(paths[i], "/5700");
+	}
+
+	r = lwm2m_engine_start(&client);
+	if (r < 0) {
+		return r;
+	}
+
+	if (zsock_getsockname(client.sock_fd, &client_addr, &len) < 0) {
+		return -errno;
+	}
+
+	for (i = 0; i < OBSERVER_COUNT; i++) {
+		r = server_observe(i);
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	return 0;
+}
+
+static int set_all(int32_t round)
+{
+	float32_value_t value;
+	uint32_t i;
+
+	for (i = 0; i < OBSERVER_COUNT; i++) {
+		value.val1 = round;
+		value.val2 = i;
+
+		if (lwm2m_engine_set_float32(paths[i], &value) < 0) {
+			return -1;
+		}
+	}
+
+	return OBSERVER_COUNT;
+}
+
+static int run_set(void)
+{
+	int32_t round;
+
+	for (round = 0; round < SET_ROUNDS; round++) {
+		if (set_all(round) < 0) {
+			return -1;
+		}
+	}
+
+	return SET_ROUNDS * OBSERVER_COUNT;
+}
+
+/* Drain the notifications of the set run first, then count the ones
+ * sent for NOTIFY_ROUNDS updates of each resource made at once. Updates
+ * of a resource within the same pass of the engine are sent as one
+ * notification.
+ */
+static uint32_t notify_start;
+static uint32_t notify_end;
+
+static int run_notify(void)
+{
+	struct coap_packet pkt;
+	uint32_t count = 0;
+	int32_t round;
+
+	while (server_recv(&pkt, TIMEOUT_MS) >= 0) {
+		if (coap_header_get_type(&pkt) == COAP_TYPE_CON &&
+		    server_ack(&pkt) < 0) {
+			return -1;
+		}
+	}
+
+	for (round = 0; round < NOTIFY_ROUNDS; round++) {
+		if (set_all(SET_ROUNDS + round) < 0) {
+			return -1;
+		}
+	}
+
+	while (server_recv(&pkt, count ? TIMEOUT_MS : 2 * TIMEOUT_MS) >= 0) {
+		if (!count) {
+			notify_start = k_cycle_get_32();
+		}
+
+		notify_end = k_cycle_get_32();
+		count++;
+
+		if (coap_header_get_type(&pkt) == COAP_TYPE_CON &&
+		    server_ack(&pkt) < 0) {
+			return -1;
+		}
+	}
+
+	return count;
+}
+
+static void report(const char *name, const char *unit, int count,
+		   uint32_t cycles)
+{
+	uint64_t us = MAX(k_cyc_to_us_floor64(cycles), 1);
+
+	printk("%-10s: %u %s in %u us, %u %s/s\n", name, count, unit,
+	       (uint32_t)us, (uint32_t)(count * (uint64_t)USEC_PER_SEC / us),
+	       unit);
+}
+
+void main(void)
+{
+	uint32_t start;
+	int count;
+
+	if (setup() < 0) {
+		printk("Cannot set up the observers\n");
+		return;
+	}
+
+	start = k_cycle_get_32();
+	count = run_set();
+	if (count < 0) {
+		printk("set failed\n");
+		return;
+	}
+
+	report("set", "updates", count, k_cycle_get_32() - start);
+
+	count = run_notify();
+	if (count <= 0) {
+		printk("notify failed\n");
+		return;
+	}
+
+	report("notify", "notifications", count, notify_end - notify_start);
+
+	printk("fin\n");
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Small datagram rate over the loopback interface, with one datagram per
+ * socket call and with batches of datagrams sent with sendmmsg() and
+ * received with recvmmsg().
+ *
+ * The main thread sends a batch of datagrams and receives them back on
+ * the other socket before sending the next batch.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <net/socket.h>
+
+#define N_DATAGRAMS	20000
+#define MAX_BATCH	16
+#define PAYLOAD_LEN	32
+#define PORT		4242
+
+static uint8_t tx_data[MAX_BATCH][PAYLOAD_LEN];
+static uint8_t rx_data[MAX_BATCH][PAYLOAD_LEN];
+
+static struct iovec tx_iov[MAX_BATCH];
+static struct iovec rx_iov[MAX_BATCH];
+static struct mmsghdr tx_msgs[MAX_BATCH];
+static struct mmsghdr rx_msgs[MAX_BATCH];
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static void setup_msgs(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_BATCH; i++) {
+		memset(tx_data[i], i, PAYLOAD_LEN);
+
+		tx_iov[i].iov_base = tx_data[i];
+		tx_iov[i].iov_len = PAYLOAD_LEN;
+		tx_msgs[i].msg_hdr.msg_iov = &tx_iov[i];
+		tx_msgs[i].msg_hdr.msg_iovlen = 1;
+
+		rx_iov[i].iov_base = rx_data[i];
+		rx_iov[i].iov_len = PAYLOAD_LEN;
+		rx_msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+		rx_msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+}
+
+static int send_batch(int sock, int batch)
+{
+	if (batch == 1) {
+		return zsock_send(sock, tx_data[0], PAYLOAD_LEN, 0) < 0 ?
+			-1 : 1;
+	}
+
+	return zsock_sendmmsg(sock, tx_msgs, batch, 0);
+}
+
+static int recv_batch(int sock, int batch)
+{
+	int received = 0;
+	int ret;
+
+	while (received < batch) {
+		if (batch == 1) {
+			ret = zsock_recv(sock, rx_data[0], PAYLOAD_LEN, 0);
+			ret = ret == PAYLOAD_LEN ? 1 : -1;
+		} else {
+			ret = zsock_recvmmsg(sock, rx_msgs + received,
+					     batch - received,
+					     ZSOCK_MSG_WAITFORONE);
+		}
+
+		if (ret < 0) {
+			return -1;
+		}
+
+		received += ret;
+	}
+
+	return 0;
+}
+
+static int check_batch(int batch)
+{
+	int i;
+
+	for (i = 0; i < batch; i++) {
+		if ((batch > 1 && rx_msgs[i].msg_len != PAYLOAD_LEN) ||
+		    memcmp(rx_data[i], tx_data[i], PAYLOAD_LEN)) {
+			printk("Invalid datagram %d\n", i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void run(int tx_sock, int rx_sock, int batch)
+{
+	uint32_t start;
+	uint64_t us;
+	int i, ret;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_DATAGRAMS; i += batch) {
+		ret = send_batch(tx_sock, batch);
+		if (ret != batch) {
+			printk("Cannot send (%d, %d)\n", ret, errno);
+			return;
+		}
+
+		if (recv_batch(rx_sock, batch) < 0) {
+			printk("Cannot receive (%d)\n", errno);
+			return;
+		}
+
+		if (check_batch(batch) < 0) {
+			return;
+		}
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("batch %2d: %d datagrams in %u us, %u datagrams/s\n", batch,
+	       N_DATAGRAMS, (uint32_t)us,
+	       (uint32_t)(N_DATAGRAMS * (uint64_t)USEC_PER_SEC / us));
+}
+
+void main(void)
+{
+	int tx_sock, rx_sock;
+	int batch;
+
+	setup_msgs();
+
+	rx_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	tx_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (rx_sock < 0 || tx_sock < 0) {
+		printk("Cannot create UDP sockets (%d)\n", errno);
+		return;
+	}
+
+	if (zsock_bind(rx_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_connect(tx_sock, (struct sockaddr *)&addr,
+			  sizeof(addr)) < 0) {
+		printk("Cannot connect UDP sockets (%d)\n", errno);
+		goto out;
+	}
+
+	for (batch = 1; batch <= MAX_BATCH; batch *= 4) {
+		run(tx_sock, rx_sock, batch);
+	}
+
+out:
+	zsock_close(tx_sock);
+	zsock_close(rx_sock);
+
+	printk("fin\n");
+}
@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Messages per second published by the MQTT client to a local broker
+ * stand-in, which counts the PUBLISH packets it receives and answers the
+ * QoS 1 ones with a PUBACK.
+ *
+ * sync-qos0:  QoS 0 messages sent one by one with mqtt_publish()
+ * queue-qos0: QoS 0 messages queued with mqtt_publish_queued() and sent in
+ *             batches
+ * sync-qos1:  QoS 1 messages sent with mqtt_publish(), waiting for the
+ *             PUBACK before sending the next one
+ * queue-qos1: QoS 1 messages queued, with an in-flight window of
+ *             CONFIG_MQTT_TX_QUEUE_INFLIGHT messages
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#define PORT		1883
+#define TIMEOUT_MS	3000
+#define MSG_COUNT	2000
+#define PAYLOAD_LEN	32
+
+#define PUBLISH_TYPE	0x30
+#define PUBLISH_QOS1	0x02
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static struct mqtt_client client;
+static uint8_t rx_buf[128];
+static uint8_t tx_buf[128];
+static uint8_t queue_buf[2048];
+static uint8_t payload[PAYLOAD_LEN];
+
+static uint8_t server_buf[1460];
+static uint8_t ack_buf[sizeof(server_buf)];
+static uint32_t server_received;
+static uint32_t server_expected;
+
+static uint32_t acked;
+
+static K_SEM_DEFINE(server_done, 0, 1);
+
+static int send_all(int sock, const uint8_t *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = zsock_send(sock, buf, len, 0);
+		if (ret < 0) {
+			return -1;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+/* Parse the complete packets in buf, all shorter than 128 bytes, and
+ * answer the QoS 1 PUBLISH packets. Return the length parsed.
+ */
+static ssize_t server_parse(int sock, const uint8_t *buf, size_t len)
+{
+	size_t ack_len = 0;
+	size_t offset = 0;
+	size_t pkt_len;
+
+	while (len - offset >= 2) {
+		pkt_len = 2 + buf[offset + 1];
+		if (len - offset < pkt_len) {
+			break;
+		}
+
+		if ((buf[offset] & 0xF0) == PUBLISH_TYPE) {
+			if (buf[offset] & PUBLISH_QOS1) {
+				/* Message id after the topic */
+				size_t id = offset + 4 + buf[offset + 3];
+
+				ack_buf[ack_len++] = 0x40;
+				ack_buf[ack_len++] = 0x02;
+				ack_buf[ack_len++] = buf[id];
+				ack_buf[ack_len++] = buf[id + 1];
+			}
+
+			if (++server_received == server_expected) {
+				k_sem_give(&server_done);
+			}
+		}
+
+		offset += pkt_len;
+	}
+
+	if (ack_len > 0 && send_all(sock, ack_buf, ack_len) < 0) {
+		return -1;
+	}
+
+	return offset;
+}
+
+static void server_thread(void *p1, void *p2, void *p3)
+{
+	static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	int s_sock = POINTER_TO_INT(p1);
+	bool connected = false;
+	size_t len = 0;
+	ssize_t ret;
+	int sock;
+
+	sock = zsock_accept(s_sock, NULL, NULL);
+	if (sock < 0) {
+		printk("Server accept failed (%d)\n", errno);
+		return;
+	}
+
+	while (true) {
+		ret = zsock_recv(sock, server_buf + len,
+				 sizeof(server_buf) - len, 0);
+		if (ret <= 0) {
+			break;
+		}
+
+		len += ret;
+
+		/* The CONNECT packet is the first one */
+		if (!connected) {
+			if (len < 2 || len < 2 + server_buf[1]) {
+				continue;
+			}
+
+			connected = true;
+
+			len -= 2 + server_buf[1];
+			memmove(server_buf, server_buf + 2 + server_buf[1], len);
+
+			if (send_all(sock, connack, sizeof(connack)) < 0) {
+				break;
+			}
+		}
+
+		ret = server_parse(sock, server_buf, len);
+		if (ret < 0) {
+			break;
+		}
+
+		len -= ret;
+		memmove(server_buf, server_buf + ret, len);
+	}
+
+	zsock_close(sock);
+}
+
+K_THREAD_STACK_DEFINE(server_stack, 2048);
+static struct k_thread server_thread_data;
+
+static void evt_cb(struct mqtt_client *const c, const struct mqtt_evt *evt)
+{
+	if (evt->type == MQTT_EVT_PUBACK) {
+		acked++;
+	}
+}
+
+static int wait_input(void)
+{
+	struct zsock_pollfd fds = {
+		.fd = client.transport.tcp.sock,
+		.events = ZSOCK_POLLIN,
+	};
+
+	if (zsock_poll(&fds, 1, TIMEOUT_MS) != 1) {
+		return -1;
+	}
+
+	return mqtt_input(&client);
+}
+
+static void init_param(struct mqtt_publish_param *param, enum mqtt_qos qos,
+		       uint32_t i)
+{
+	param->message.topic.topic.utf8 = (uint8_t *)"bench";
+	param->message.topic.topic.size = strlen("bench");
+	param->message.topic.qos = qos;
+	param->message.payload.data = payload;
+	param->message.payload.len = sizeof(payload);
+	param->message_id = qos ? (i % UINT16_MAX) + 1 : 0;
+	param->dup_flag = 0;
+	param->retain_flag = 0;
+}
+
+static int run_sync_qos0(void)
+{
+	struct mqtt_publish_param param;
+	uint32_t i;
+
+	for (i = 0; i < MSG_COUNT; i++) {
+		init_param(&param, MQTT_QOS_0_AT_MOST_ONCE, i);
+
+		if (mqtt_publish(&client, &param) < 0) {
+			return -1;
+		}
+	}
+
+	return k_sem_take(&server_done, K_MSEC(TIMEOUT_MS));
+}
+
+static int run_queue_qos0(void)
+{
+	struct mqtt_publish_param param;
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < MSG_COUNT; i++) {
+		init_param(&param, MQTT_QOS_0_AT_MOST_ONCE, i);
+
+		ret = mqtt_publish_queued(&client, &param);
+		if (ret == -ENOMEM) {
+			/* Queue full, send it all */
+			ret = mqtt_flush(&client);
+			ret = ret ? ret : mqtt_publish_queued(&client, &param);
+		}
+
+		if (ret < 0) {
+			return -1;
+		}
+	}
+
+	if (mqtt_flush(&client) < 0) {
+		return -1;
+	}
+
+	return k_sem_take(&server_done, K_MSEC(TIMEOUT_MS));
+}
+
+static int run_sync_qos1(void)
+{
+	struct mqtt_publish_param param;
+	uint32_t i;
+
+	for (i = 0; i < MSG_COUNT; i++) {
+		init_param(&param, MQTT_QOS_1_AT_LEAST_ONCE, i);
+
+		if (mqtt_publish(&client, &param) < 0) {
+			return -1;
+		}
+
+		while (acked <= i) {
+			if (wait_input() < 0) {
+				return -1;
+			}
+		}
+	}
+
+	return k_sem_take(&server_done, K_MSEC(TIMEOUT_MS));
+}
+
+static int run_queue_qos1(void)
+{
+	struct mqtt_publish_param param;
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < MSG_COUNT; i++) {
+		init_param(&param, MQTT_QOS_1_AT_LEAST_ONCE, i);
+
+		ret = mqtt_publish_queued(&client, &param);
+		while (ret == -ENOMEM) {
+			/* Queue full, the PUBACKs make room */
+			ret = mqtt_flush(&client);
+			ret = ret ? ret : wait_input();
+			ret = ret ? ret : mqtt_publish_queued(&client, &param);
+		}
+
+		if (ret < 0) {
+			return -1;
+		}
+	}
+
+	if (mqtt_flush(&client) < 0) {
+		return -1;
+	}
+
+	while (acked < MSG_COUNT) {
+		if (wait_input() < 0) {
+			return -1;
+		}
+	}
+
+	return k_sem_take(&server_done, K_MSEC(TIMEOUT_MS));
+}
+
+static void run(const char *name, int (*fn)(void))
+{
+	uint32_t start;
+	uint64_t us;
+
+	server_received = 0;
+	server_expected = MSG_COUNT;
+	acked = 0;
+	start = k_cycle_get_32();
+
+	if (fn() < 0) {
+		printk("%s failed after %u messages (%d)\n", name,
+		       server_received, errno);
+		return;
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%-10s: %u messages in %u us, %u msg/s\n", name,
+	       server_received, (uint32_t)us,
+	       (uint32_t)(server_received * USEC_PER_SEC / us));
+}
+
+static int client_connect(void)
+{
+	int s_sock;
+
+	s_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s_sock < 0 ||
+	    zsock_bind(s_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_listen(s_sock, 1) < 0) {
+		return -1;
+	}
+
+	k_thread_create(&server_thread_data, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_thread,
+			INT_TO_POINTER(s_sock), NULL, NULL,
+			K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	mqtt_client_init(&client);
+
+	client.broker = &addr;
+	client.evt_cb = evt_cb;
+	client.client_id.utf8 = (uint8_t *)"bench";
+	client.client_id.size = strlen("bench");
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.rx_buf = rx_buf;
+	client.rx_buf_size = sizeof(rx_buf);
+	client.tx_buf = tx_buf;
+	client.tx_buf_size = sizeof(tx_buf);
+	client.queue_buf = queue_buf;
+	client.queue_buf_size = sizeof(queue_buf);
+
+	if (mqtt_connect(&client) < 0) {
+		return -1;
+	}
+
+	/* CONNACK */
+	return wait_input();
+}
+
+void main(void)
+{
+	(void)memset(payload, 'a', sizeof(payload));
+
+	if (client_connect() < 0) {
+		printk("Cannot connect MQTT client (%d)\n", errno);
+		return;
+	}
+
+	run("sync-qos0", run_sync_qos0);
+	run("queue-qos0", run_queue_qos0);
+	run("sync-qos1", run_sync_qos1);
+	run("queue-qos1", run_queue_qos1);
+
+	mqtt_disconnect(&client);
+
+	printk("fin\n");
+}
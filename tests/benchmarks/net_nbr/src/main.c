@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* IPv6 neighbor cache performance with many neighbors.
+ *
+ * Lookup: the neighbor cache is filled with a number of neighbors and the
+ * main thread looks them up round robin, the way the stack does for every
+ * sent packet.
+ *
+ * NS storm: the main thread acts as an Ethernet driver and feeds pre-built
+ * Neighbor Solicitations for our address to net_recv_data(), round robin
+ * from a number of neighbors. Every NS creates or updates the neighbor
+ * cache entry of its sender and is answered with a Neighbor Advertisement,
+ * which the fake driver counts.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <random/rand32.h>
+
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+#include <net/net_pkt.h>
+
+#include "icmpv6.h"
+#include "ipv6.h"
+
+#define N_LOOKUPS	100000
+#define N_PACKETS	20000
+#define MAX_NBRS	CONFIG_NET_IPV6_MAX_NEIGHBORS
+
+#define NS_LEN		(sizeof(struct net_icmp_hdr) + \
+			 sizeof(struct net_icmpv6_ns_hdr) + \
+			 sizeof(struct net_icmpv6_nd_opt_hdr) + \
+			 sizeof(struct net_eth_addr))
+#define FRAME_LEN	(sizeof(struct net_eth_hdr) + NET_IPV6H_LEN + NS_LEN)
+
+static const int nbr_counts[] = { 8, 64, MAX_NBRS };
+
+static struct in6_addr in6addr_my = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					  0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+
+static struct in6_addr nbr_addrs[MAX_NBRS];
+static uint8_t frames[MAX_NBRS][FRAME_LEN];
+
+static struct net_if *bench_iface;
+static uint8_t mac_addr[6];
+
+static atomic_t sent;
+static K_SEM_DEFINE(done, 0, 1);
+
+static void eth_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+
+	ethernet_init(iface);
+}
+
+static int eth_tx(const struct device *dev, struct net_pkt *pkt)
+{
+	if (atomic_inc(&sent) + 1 == N_PACKETS) {
+		k_sem_give(&done);
+	}
+
+	return 0;
+}
+
+static struct ethernet_api api_funcs = {
+	.iface_api.init = eth_iface_init,
+	.send = eth_tx,
+};
+
+static int eth_init(const struct device *dev)
+{
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	mac_addr[0] = 0x00;
+	mac_addr[1] = 0x00;
+	mac_addr[2] = 0x5E;
+	mac_addr[3] = 0x00;
+	mac_addr[4] = 0x53;
+	mac_addr[5] = sys_rand32_get();
+
+	return 0;
+}
+
+ETH_NET_DEVICE_INIT(eth_bench, "eth_bench", eth_init, device_pm_control_nop,
+		    NULL, NULL, CONFIG_ETH_INIT_PRIORITY, &api_funcs,
+		    NET_ETH_MTU);
+
+static uint16_t chksum(uint32_t sum, const uint8_t *data, size_t len)
+{
+	for (; len > 1; len -= 2, data += 2) {
+		sum += (data[0] << 8) | data[1];
+	}
+
+	if (len) {
+		sum += data[0] << 8;
+	}
+
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return sum;
+}
+
+/* The neighbors are in 2001:db8::/64, with an interface identifier
+ * derived from their MAC address 00-00-5E-00-54-xx.
+ */
+static void nbr_lladdr(int i, uint8_t *lladdr)
+{
+	lladdr[0] = 0x00;
+	lladdr[1] = 0x00;
+	lladdr[2] = 0x5E;
+	lladdr[3] = 0x00;
+	lladdr[4] = 0x54;
+	lladdr[5] = i;
+}
+
+static void build_frame(uint8_t *frame, int i)
+{
+	struct net_eth_hdr *eth_hdr = (struct net_eth_hdr *)frame;
+	struct net_icmpv6_nd_opt_hdr *opt_hdr;
+	struct net_icmpv6_ns_hdr *ns_hdr;
+	struct net_ipv6_hdr *ip_hdr;
+	struct net_icmp_hdr *icmp_hdr;
+
+	memcpy(eth_hdr->dst.addr, mac_addr, sizeof(eth_hdr->dst.addr));
+	nbr_lladdr(i, eth_hdr->src.addr);
+	eth_hdr->type = htons(NET_ETH_PTYPE_IPV6);
+
+	ip_hdr = (struct net_ipv6_hdr *)(eth_hdr + 1);
+	ip_hdr->vtc = 0x60;
+	ip_hdr->len = htons(NS_LEN);
+	ip_hdr->nexthdr = IPPROTO_ICMPV6;
+	ip_hdr->hop_limit = NET_IPV6_ND_HOP_LIMIT;
+	net_ipaddr_copy(&ip_hdr->src, &nbr_addrs[i]);
+	net_ipaddr_copy(&ip_hdr->dst, &in6addr_my);
+
+	icmp_hdr = (struct net_icmp_hdr *)(ip_hdr + 1);
+	icmp_hdr->type = NET_ICMPV6_NS;
+
+	ns_hdr = (struct net_icmpv6_ns_hdr *)(icmp_hdr + 1);
+	net_ipaddr_copy(&ns_hdr->tgt, &in6addr_my);
+
+	opt_hdr = (struct net_icmpv6_nd_opt_hdr *)(ns_hdr + 1);
+	opt_hdr->type = NET_ICMPV6_ND_OPT_SLLAO;
+	opt_hdr->len = 1U;
+	nbr_lladdr(i, (uint8_t *)(opt_hdr + 1));
+
+	icmp_hdr->chksum = ~htons(chksum(chksum(IPPROTO_ICMPV6 + NS_LEN,
+						(uint8_t *)&ip_hdr->src,
+						2 * sizeof(struct in6_addr)),
+					 (uint8_t *)icmp_hdr, NS_LEN));
+}
+
+static void setup_nbrs(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_NBRS; i++) {
+		net_ipv6_addr_create(&nbr_addrs[i], 0x2001, 0x0db8, 0, 0,
+				     0x0200, 0x5eff, 0xfe00, 0x5400 | i);
+
+		build_frame(frames[i], i);
+	}
+}
+
+static void clear_nbrs(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_NBRS; i++) {
+		net_ipv6_nbr_rm(bench_iface, &nbr_addrs[i]);
+	}
+}
+
+static int add_nbrs(int count)
+{
+	struct net_linkaddr lladdr = {
+		.len = sizeof(mac_addr),
+		.type = NET_LINK_ETHERNET,
+	};
+	uint8_t addr[sizeof(mac_addr)];
+	int i;
+
+	lladdr.addr = addr;
+
+	for (i = 0; i < count; i++) {
+		nbr_lladdr(i, addr);
+
+		if (!net_ipv6_nbr_add(bench_iface, &nbr_addrs[i], &lladdr,
+				      false, NET_IPV6_NBR_STATE_STALE)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static uint64_t elapsed_us(uint32_t start)
+{
+	return MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+}
+
+static void run_lookup(int count)
+{
+	uint32_t start;
+	uint64_t us;
+	int i;
+
+	clear_nbrs();
+
+	if (add_nbrs(count) < 0) {
+		printk("Cannot add %d neighbors\n", count);
+		return;
+	}
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		if (!net_ipv6_nbr_lookup(bench_iface,
+					 &nbr_addrs[i % count])) {
+			printk("Neighbor %d not found\n", i % count);
+			return;
+		}
+	}
+
+	us = elapsed_us(start);
+
+	printk("lookup neighbors %3d: %d lookups in %u us, %u lookups/s\n",
+	       count, N_LOOKUPS, (uint32_t)us,
+	       (uint32_t)(N_LOOKUPS * (uint64_t)USEC_PER_SEC / us));
+}
+
+static void run_ns_storm(int count)
+{
+	uint32_t start;
+	uint64_t us;
+	int i;
+
+	clear_nbrs();
+
+	atomic_set(&sent, 0);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_PACKETS; i++) {
+		struct net_pkt *pkt;
+
+		/* Waiting for a free packet throttles the generator to the
+		 * speed of the stack.
+		 */
+		pkt = net_pkt_rx_alloc_with_buffer(bench_iface, FRAME_LEN,
+						   AF_UNSPEC, 0, K_FOREVER);
+		if (!pkt) {
+			printk("Cannot allocate pkt\n");
+			return;
+		}
+
+		if (net_pkt_write(pkt, frames[i % count], FRAME_LEN) ||
+		    net_recv_data(bench_iface, pkt) < 0) {
+			printk("Cannot pass pkt to the stack\n");
+			net_pkt_unref(pkt);
+			return;
+		}
+	}
+
+	if (k_sem_take(&done, K_SECONDS(60))) {
+		printk("Timeout, sent %d NAs\n", (int)atomic_get(&sent));
+		return;
+	}
+
+	us = elapsed_us(start);
+
+	printk("ns storm neighbors %3d: %d packets in %u us, %u pps\n",
+	       count, N_PACKETS, (uint32_t)us,
+	       (uint32_t)(N_PACKETS * (uint64_t)USEC_PER_SEC / us));
+}
+
+void main(void)
+{
+	struct net_if_addr *ifaddr;
+	int i;
+
+	bench_iface = net_if_get_first_by_type(&NET_L2_GET_NAME(ETHERNET));
+	if (!bench_iface) {
+		printk("No Ethernet interface\n");
+		return;
+	}
+
+	ifaddr = net_if_ipv6_addr_add(bench_iface, &in6addr_my,
+				      NET_ADDR_MANUAL, 0);
+	if (!ifaddr) {
+		printk("Cannot add IPv6 address\n");
+		return;
+	}
+
+	ifaddr->addr_state = NET_ADDR_PREFERRED;
+
+	setup_nbrs();
+
+	for (i = 0; i < ARRAY_SIZE(nbr_counts); i++) {
+		run_lookup(nbr_counts[i]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(nbr_counts); i++) {
+		run_ns_storm(nbr_counts[i]);
+	}
+
+	printk("fin\n");
+}
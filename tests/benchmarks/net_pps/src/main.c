@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Small packet rate of the network stack, with packets passed to and
+ * from the Ethernet driver in bursts of different sizes.
+ *
+ * Rx: the main thread acts as an Ethernet driver and feeds pre-built
+ * minimum sized UDP frames to net_recv_data_burst(). A UDP connection
+ * handler counts them.
+ *
+ * Tx: the main thread sends minimum sized UDP datagrams with a socket,
+ * a burst at a time with the scheduler locked so that the packets pile
+ * up in the Tx queue, and the fake driver counts the frames and how many
+ * times it was called.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <random/rand32.h>
+
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+#include <net/net_pkt.h>
+#include <net/socket.h>
+
+#include "connection.h"
+
+#define N_PACKETS	20000
+#define MAX_BURST	16
+#define PORT_SRC	5000
+#define PORT_DST	4242
+
+/* Ethernet, IPv4 and UDP headers take 42 bytes of a 64 byte frame */
+#define PAYLOAD_LEN	22
+#define FRAME_LEN	(sizeof(struct net_eth_hdr) + NET_IPV4UDPH_LEN + \
+			 PAYLOAD_LEN)
+
+static struct in_addr in4addr_my = { { { 192, 0, 2, 1 } } };
+static struct in_addr in4addr_peer = { { { 192, 0, 2, 2 } } };
+
+static uint8_t frame[FRAME_LEN];
+
+static struct net_if *bench_iface;
+static uint8_t mac_addr[6];
+
+static atomic_t received;
+static atomic_t sent;
+static atomic_t driver_calls;
+static K_SEM_DEFINE(done, 0, 1);
+
+static void eth_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+
+	ethernet_init(iface);
+}
+
+static void tx_count(int count)
+{
+	atomic_inc(&driver_calls);
+
+	if (atomic_add(&sent, count) + count == N_PACKETS) {
+		k_sem_give(&done);
+	}
+}
+
+static int eth_tx(const struct device *dev, struct net_pkt *pkt)
+{
+	tx_count(1);
+
+	return 0;
+}
+
+static int eth_tx_burst(const struct device *dev, struct net_pkt **pkts,
+			int count)
+{
+	tx_count(count);
+
+	return count;
+}
+
+static struct ethernet_api api_funcs = {
+	.iface_api.init = eth_iface_init,
+	.send = eth_tx,
+	.send_burst = eth_tx_burst,
+};
+
+static int eth_init(const struct device *dev)
+{
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	mac_addr[0] = 0x00;
+	mac_addr[1] = 0x00;
+	mac_addr[2] = 0x5E;
+	mac_addr[3] = 0x00;
+	mac_addr[4] = 0x53;
+	mac_addr[5] = sys_rand32_get();
+
+	return 0;
+}
+
+ETH_NET_DEVICE_INIT(eth_bench, "eth_bench", eth_init, device_pm_control_nop,
+		    NULL, NULL, CONFIG_ETH_INIT_PRIORITY, &api_funcs,
+		    NET_ETH_MTU);
+
+static uint16_t chksum(uint32_t sum, const uint8_t *data, size_t len)
+{
+	for (; len > 1; len -= 2, data += 2) {
+		sum += (data[0] << 8) | data[1];
+	}
+
+	if (len) {
+		sum += data[0] << 8;
+	}
+
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return sum;
+}
+
+static void build_frame(uint8_t *frame)
+{
+	struct net_eth_hdr *eth_hdr = (struct net_eth_hdr *)frame;
+	struct net_ipv4_hdr *ip_hdr;
+	struct net_udp_hdr *udp_hdr;
+
+	memcpy(eth_hdr->dst.addr, mac_addr, sizeof(eth_hdr->dst.addr));
+	eth_hdr->src.addr[5] = 0x42;
+	eth_hdr->type = htons(NET_ETH_PTYPE_IP);
+
+	ip_hdr = (struct net_ipv4_hdr *)(eth_hdr + 1);
+	ip_hdr->vhl = 0x45;
+	ip_hdr->len = htons(NET_IPV4UDPH_LEN + PAYLOAD_LEN);
+	ip_hdr->ttl = 64;
+	ip_hdr->proto = IPPROTO_UDP;
+	net_ipaddr_copy(&ip_hdr->src, &in4addr_peer);
+	net_ipaddr_copy(&ip_hdr->dst, &in4addr_my);
+	ip_hdr->chksum = ~htons(chksum(0, (uint8_t *)ip_hdr, NET_IPV4H_LEN));
+
+	udp_hdr = (struct net_udp_hdr *)(ip_hdr + 1);
+	udp_hdr->src_port = htons(PORT_SRC);
+	udp_hdr->dst_port = htons(PORT_DST);
+	udp_hdr->len = htons(NET_UDPH_LEN + PAYLOAD_LEN);
+
+	udp_hdr->chksum = ~htons(chksum(chksum(IPPROTO_UDP + NET_UDPH_LEN +
+					       PAYLOAD_LEN,
+					       (uint8_t *)&ip_hdr->src,
+					       2 * sizeof(struct in_addr)),
+					(uint8_t *)udp_hdr,
+					NET_UDPH_LEN + PAYLOAD_LEN));
+}
+
+static enum net_verdict udp_received(struct net_conn *conn,
+				     struct net_pkt *pkt,
+				     union net_ip_header *ip_hdr,
+				     union net_proto_header *proto_hdr,
+				     void *user_data)
+{
+	net_pkt_unref(pkt);
+
+	if (atomic_inc(&received) + 1 == N_PACKETS) {
+		k_sem_give(&done);
+	}
+
+	return NET_OK;
+}
+
+static bool wait_done(const char *dir, atomic_t *count)
+{
+	if (k_sem_take(&done, K_SECONDS(60))) {
+		printk("%s timeout, %d packets\n", dir, (int)atomic_get(count));
+		return false;
+	}
+
+	return true;
+}
+
+static uint64_t elapsed_us(uint32_t start)
+{
+	return MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+}
+
+static void run_rx(int burst)
+{
+	struct net_pkt *pkts[MAX_BURST];
+	uint32_t start;
+	uint64_t us;
+	int i, j, ret;
+
+	atomic_set(&received, 0);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_PACKETS; i += burst) {
+		for (j = 0; j < burst; j++) {
+			/* Waiting for a free packet throttles the generator
+			 * to the speed of the stack.
+			 */
+			pkts[j] = net_pkt_rx_alloc_with_buffer(bench_iface,
+							       FRAME_LEN,
+							       AF_UNSPEC, 0,
+							       K_FOREVER);
+			if (!pkts[j] ||
+			    net_pkt_write(pkts[j], frame, FRAME_LEN)) {
+				printk("Cannot allocate pkt\n");
+				return;
+			}
+		}
+
+		ret = net_recv_data_burst(bench_iface, pkts, burst);
+		if (ret != burst) {
+			printk("Cannot pass pkts to the stack (%d)\n", ret);
+			return;
+		}
+	}
+
+	if (!wait_done("rx", &received)) {
+		return;
+	}
+
+	us = elapsed_us(start);
+
+	printk("rx burst %2d: %d packets in %u us, %u pps\n", burst,
+	       N_PACKETS, (uint32_t)us,
+	       (uint32_t)(N_PACKETS * (uint64_t)USEC_PER_SEC / us));
+}
+
+static void run_tx(int sock, int burst)
+{
+	struct sockaddr_in peer = {
+		.sin_family = AF_INET,
+		.sin_port = htons(PORT_DST),
+	};
+	static uint8_t payload[PAYLOAD_LEN];
+	uint32_t start;
+	uint64_t us;
+	int i, j;
+
+	net_ipaddr_copy(&peer.sin_addr, &in4addr_peer);
+
+	atomic_set(&sent, 0);
+	atomic_set(&driver_calls, 0);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_PACKETS; i += burst) {
+		k_sched_lock();
+
+		for (j = 0; j < burst; j++) {
+			if (zsock_sendto(sock, payload, sizeof(payload), 0,
+					 (struct sockaddr *)&peer,
+					 sizeof(peer)) < 0) {
+				k_sched_unlock();
+				printk("Cannot send (%d)\n", errno);
+				return;
+			}
+		}
+
+		k_sched_unlock();
+	}
+
+	if (!wait_done("tx", &sent)) {
+		return;
+	}
+
+	us = elapsed_us(start);
+
+	printk("tx burst %2d: %d packets in %u us, %u pps, %d driver calls\n",
+	       burst, N_PACKETS, (uint32_t)us,
+	       (uint32_t)(N_PACKETS * (uint64_t)USEC_PER_SEC / us),
+	       (int)atomic_get(&driver_calls));
+}
+
+void main(void)
+{
+	struct net_conn_handle *handle;
+	int burst;
+	int sock;
+
+	bench_iface = net_if_get_first_by_type(&NET_L2_GET_NAME(ETHERNET));
+	if (!bench_iface) {
+		printk("No Ethernet interface\n");
+		return;
+	}
+
+	net_if_ipv4_addr_add(bench_iface, &in4addr_my, NET_ADDR_MANUAL, 0);
+
+	if (net_conn_register(IPPROTO_UDP, AF_INET, NULL, NULL, 0, PORT_DST,
+			      udp_received, NULL, &handle) < 0) {
+		printk("Cannot register UDP handler\n");
+		return;
+	}
+
+	build_frame(frame);
+
+	for (burst = 1; burst <= MAX_BURST; burst *= 4) {
+		run_rx(burst);
+	}
+
+	sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		printk("Cannot create socket (%d)\n", errno);
+		return;
+	}
+
+	for (burst = 1; burst <= MAX_BURST; burst *= 4) {
+		run_tx(sock, burst);
+	}
+
+	zsock_close(sock);
+
+	printk("fin\n");
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* IPv6 route lookup rate, depending on the size of the routing table.
+ *
+ * The routing table is filled with random prefixes of 2001:db8::/32 that
+ * have a length between 48 and 128 bits, all of them via the same
+ * neighbor. The main thread then looks up the route of a set of
+ * destinations, round robin, the way the stack does for every forwarded
+ * or sent packet. With CONFIG_NET_ROUTE_CACHE_SIZE the result for the most
+ * recent destinations is cached.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <random/rand32.h>
+
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+
+#include "ipv6.h"
+#include "route.h"
+
+#define N_LOOKUPS	100000
+#define MAX_DESTS	64
+
+static struct in6_addr in6addr_nexthop = { { { 0x20, 0x01, 0x0d, 0xb8,
+					       0, 0, 0, 0, 0, 0, 0, 0,
+					       0, 0, 0, 0x2 } } };
+
+static struct in6_addr dests[MAX_DESTS];
+static struct in6_addr prefixes[CONFIG_NET_MAX_ROUTES];
+static struct net_route_entry *entries[CONFIG_NET_MAX_ROUTES];
+static const int table_sizes[] = { 1, 8, 32, CONFIG_NET_MAX_ROUTES };
+
+static struct net_if *bench_iface;
+static uint8_t mac_addr[6];
+
+static void eth_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+
+	ethernet_init(iface);
+}
+
+static int eth_tx(const struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static struct ethernet_api api_funcs = {
+	.iface_api.init = eth_iface_init,
+	.send = eth_tx,
+};
+
+static int eth_init(const struct device *dev)
+{
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	mac_addr[0] = 0x00;
+	mac_addr[1] = 0x00;
+	mac_addr[2] = 0x5E;
+	mac_addr[3] = 0x00;
+	mac_addr[4] = 0x53;
+	mac_addr[5] = sys_rand32_get();
+
+	return 0;
+}
+
+ETH_NET_DEVICE_INIT(eth_bench, "eth_bench", eth_init, device_pm_control_nop,
+		    NULL, NULL, CONFIG_ETH_INIT_PRIORITY, &api_funcs,
+		    NET_ETH_MTU);
+
+static void random_addr(struct in6_addr *addr)
+{
+	int i;
+
+	net_ipv6_addr_create(addr, 0x2001, 0x0db8, 0, 0, 0, 0, 0, 0);
+
+	for (i = 4; i < sizeof(addr->s6_addr); i++) {
+		addr->s6_addr[i] = sys_rand32_get();
+	}
+}
+
+static int add_routes(int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		random_addr(&prefixes[i]);
+
+		entries[i] = net_route_add(bench_iface, &prefixes[i],
+					   48 + sys_rand32_get() % 81,
+					   &in6addr_nexthop);
+		if (!entries[i]) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void del_routes(int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		net_route_del(entries[i]);
+	}
+}
+
+/* Half of the destinations are the address of one of the routes, the
+ * other half are random and mostly have no route.
+ */
+static void set_dests(int routes)
+{
+	int i;
+
+	for (i = 0; i < MAX_DESTS; i++) {
+		random_addr(&dests[i]);
+
+		if (i % 2) {
+			net_ipaddr_copy(&dests[i], &prefixes[i % routes]);
+		}
+	}
+}
+
+static void run(int routes, int ndests)
+{
+	uint32_t start;
+	uint64_t us;
+	int i, found = 0;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		if (net_route_lookup(bench_iface, &dests[i % ndests])) {
+			found++;
+		}
+	}
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("routes %3d destinations %2d: %d lookups in %u us, %u lookups/s"
+	       " (%d found)\n", routes, ndests, N_LOOKUPS, (uint32_t)us,
+	       (uint32_t)(N_LOOKUPS * (uint64_t)USEC_PER_SEC / us), found);
+}
+
+void main(void)
+{
+	struct net_linkaddr lladdr = {
+		.addr = mac_addr,
+		.len = sizeof(mac_addr),
+		.type = NET_LINK_ETHERNET,
+	};
+	int i, routes, ndests;
+
+	bench_iface = net_if_get_first_by_type(&NET_L2_GET_NAME(ETHERNET));
+	if (!bench_iface) {
+		printk("No Ethernet interface\n");
+		return;
+	}
+
+	if (!net_ipv6_nbr_add(bench_iface, &in6addr_nexthop, &lladdr, true,
+			      NET_IPV6_NBR_STATE_REACHABLE)) {
+		printk("Cannot add neighbor\n");
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(table_sizes); i++) {
+		routes = table_sizes[i];
+
+		if (add_routes(routes) < 0) {
+			printk("Cannot add %d routes\n", routes);
+			return;
+		}
+
+		set_dests(routes);
+
+		for (ndests = 4; ndests <= MAX_DESTS; ndests *= 4) {
+			run(routes, ndests);
+		}
+
+		del_routes(routes);
+	}
+
+	printk("fin\n");
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Receive throughput of the network stack with several UDP flows.
+ *
+ * The main thread acts as an Ethernet driver and feeds pre-built UDP
+ * frames to net_recv_data(), round robin over a number of flows that
+ * differ by their source port. A UDP connection handler counts the
+ * packets and the time to receive all of them is reported. With
+ * CONFIG_NET_RX_FLOW_STEERING the flows are processed by one Rx queue per
+ * CPU.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <random/rand32.h>
+
+#include <net/ethernet.h>
+#include <net/net_ip.h>
+#include <net/net_pkt.h>
+
+#include "connection.h"
+
+#define N_PACKETS	20000
+#define MAX_FLOWS	8
+#define PAYLOAD_LEN	1000
+#define PORT_SRC	5000
+#define PORT_DST	4242
+
+#if defined(CONFIG_NET_RX_FLOW_STEERING)
+#define RX_QUEUES	CONFIG_NET_RX_FLOW_QUEUES
+#else
+#define RX_QUEUES	1
+#endif
+
+#define FRAME_LEN	(sizeof(struct net_eth_hdr) + NET_IPV4UDPH_LEN + \
+			 PAYLOAD_LEN)
+
+static struct in_addr in4addr_my = { { { 192, 0, 2, 1 } } };
+static struct in_addr in4addr_peer = { { { 192, 0, 2, 2 } } };
+
+static uint8_t frames[MAX_FLOWS][FRAME_LEN];
+
+static struct net_if *bench_iface;
+static uint8_t mac_addr[6];
+
+static atomic_t received;
+static K_SEM_DEFINE(done, 0, 1);
+
+static void eth_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+
+	ethernet_init(iface);
+}
+
+static int eth_tx(const struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static struct ethernet_api api_funcs = {
+	.iface_api.init = eth_iface_init,
+	.send = eth_tx,
+};
+
+static int eth_init(const struct device *dev)
+{
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	mac_addr[0] = 0x00;
+	mac_addr[1] = 0x00;
+	mac_addr[2] = 0x5E;
+	mac_addr[3] = 0x00;
+	mac_addr[4] = 0x53;
+	mac_addr[5] = sys_rand32_get();
+
+	return 0;
+}
+
+ETH_NET_DEVICE_INIT(eth_bench, "eth_bench", eth_init, device_pm_control_nop,
+		    NULL, NULL, CONFIG_ETH_INIT_PRIORITY, &api_funcs,
+		    NET_ETH_MTU);
+
+static uint16_t chksum(uint32_t sum, const uint8_t *data, size_t len)
+{
+	for (; len > 1; len -= 2, data += 2) {
+		sum += (data[0] << 8) | data[1];
+	}
+
+	if (len) {
+		sum += data[0] << 8;
+	}
+
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return sum;
+}
+
+static void build_frame(uint8_t *frame, uint16_t src_port)
+{
+	struct net_eth_hdr *eth_hdr = (struct net_eth_hdr *)frame;
+	struct net_ipv4_hdr *ip_hdr;
+	struct net_udp_hdr *udp_hdr;
+	uint8_t *payload;
+	int i;
+
+	memcpy(eth_hdr->dst.addr, mac_addr, sizeof(eth_hdr->dst.addr));
+	eth_hdr->src.addr[5] = 0x42;
+	eth_hdr->type = htons(NET_ETH_PTYPE_IP);
+
+	ip_hdr = (struct net_ipv4_hdr *)(eth_hdr + 1);
+	ip_hdr->vhl = 0x45;
+	ip_hdr->len = htons(NET_IPV4UDPH_LEN + PAYLOAD_LEN);
+	ip_hdr->ttl = 64;
+	ip_hdr->proto = IPPROTO_UDP;
+	net_ipaddr_copy(&ip_hdr->src, &in4addr_peer);
+	net_ipaddr_copy(&ip_hdr->dst, &in4addr_my);
+	ip_hdr->chksum = ~htons(chksum(0, (uint8_t *)ip_hdr, NET_IPV4H_LEN));
+
+	udp_hdr = (struct net_udp_hdr *)(ip_hdr + 1);
+	udp_hdr->src_port = htons(src_port);
+	udp_hdr->dst_port = htons(PORT_DST);
+	udp_hdr->len = htons(NET_UDPH_LEN + PAYLOAD_LEN);
+
+	payload = (uint8_t *)(udp_hdr + 1);
+	for (i = 0; i < PAYLOAD_LEN; i++) {
+		payload[i] = i;
+	}
+
+	udp_hdr->chksum = ~htons(chksum(chksum(IPPROTO_UDP + NET_UDPH_LEN +
+					       PAYLOAD_LEN,
+					       (uint8_t *)&ip_hdr->src,
+					       2 * sizeof(struct in_addr)),
+					(uint8_t *)udp_hdr,
+					NET_UDPH_LEN + PAYLOAD_LEN));
+}
+
+static enum net_verdict udp_received(struct net_conn *conn,
+				     struct net_pkt *pkt,
+				     union net_ip_header *ip_hdr,
+				     union net_proto_header *proto_hdr,
+				     void *user_data)
+{
+	net_pkt_unref(pkt);
+
+	if (atomic_inc(&received) + 1 == N_PACKETS) {
+		k_sem_give(&done);
+	}
+
+	return NET_OK;
+}
+
+static void run(int flows)
+{
+	uint32_t start, cycles;
+	uint64_t us;
+	int i;
+
+	atomic_set(&received, 0);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_PACKETS; i++) {
+		struct net_pkt *pkt;
+
+		/* Waiting for a free packet throttles the generator to the
+		 * speed of the stack.
+		 */
+		pkt = net_pkt_rx_alloc_with_buffer(bench_iface, FRAME_LEN,
+						   AF_UNSPEC, 0, K_FOREVER);
+		if (!pkt) {
+			printk("Cannot allocate pkt\n");
+			return;
+		}
+
+		if (net_pkt_write(pkt, frames[i % flows], FRAME_LEN) ||
+		    net_recv_data(bench_iface, pkt) < 0) {
+			printk("Cannot pass pkt to the stack\n");
+			net_pkt_unref(pkt);
+			return;
+		}
+	}
+
+	if (k_sem_take(&done, K_SECONDS(60))) {
+		printk("Timeout, received %d packets\n",
+		       (int)atomic_get(&received));
+		return;
+	}
+
+	cycles = k_cycle_get_32() - start;
+	us = MAX(k_cyc_to_us_floor64(cycles), 1);
+
+	printk("flows %2d queues %d: %d packets in %u us, %u pps\n", flows,
+	       RX_QUEUES, N_PACKETS, (uint32_t)us,
+	       (uint32_t)(N_PACKETS * (uint64_t)USEC_PER_SEC / us));
+}
+
+void main(void)
+{
+	struct net_conn_handle *handle;
+	int flows;
+
+	bench_iface = net_if_get_first_by_type(&NET_L2_GET_NAME(ETHERNET));
+	if (!bench_iface) {
+		printk("No Ethernet interface\n");
+		return;
+	}
+
+	net_if_ipv4_addr_add(bench_iface, &in4addr_my, NET_ADDR_MANUAL, 0);
+
+	if (net_conn_register(IPPROTO_UDP, AF_INET, NULL, NULL, 0, PORT_DST,
+			      udp_received, NULL, &handle) < 0) {
+		printk("Cannot register UDP handler\n");
+		return;
+	}
+
+	for (flows = 0; flows < MAX_FLOWS; flows++) {
+		build_frame(frames[flows], PORT_SRC + flows);
+	}
+
+	for (flows = 1; flows <= MAX_FLOWS; flows *= 2) {
+		run(flows);
+	}
+
+	printk("fin\n");
+}
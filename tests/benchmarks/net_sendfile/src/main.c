@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Throughput of serving a file from a FAT RAM disk over a loopback TCP
+ * connection, with read() and send() and with sendfile().
+ *
+ * A receiver thread accepts the connection and counts the received bytes
+ * while the main thread sends the whole file.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <ff.h>
+#include <fs/fs.h>
+#include <net/socket.h>
+#include <sys/sendfile.h>
+
+#define FILE_SIZE	(256 * 1024)
+#define CHUNK_SIZE	CONFIG_NET_SOCKETS_SENDFILE_CHUNK_SIZE
+#define PORT		4242
+#define FILE_NAME	"/RAM:/data.bin"
+
+static FATFS fat_fs;
+static struct fs_mount_t mp = {
+	.type = FS_FATFS,
+	.mnt_point = "/RAM:",
+	.fs_data = &fat_fs,
+};
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static uint8_t buf[CHUNK_SIZE];
+static uint8_t rx_buf[CHUNK_SIZE];
+
+static K_SEM_DEFINE(rx_done, 0, 1);
+static size_t rx_total;
+
+static void receiver(void *p1, void *p2, void *p3)
+{
+	int s_sock = POINTER_TO_INT(p1);
+	int sock;
+	ssize_t ret;
+
+	while (true) {
+		sock = zsock_accept(s_sock, NULL, NULL);
+		if (sock < 0) {
+			printk("Cannot accept (%d)\n", errno);
+			return;
+		}
+
+		rx_total = 0;
+
+		do {
+			ret = zsock_recv(sock, rx_buf, sizeof(rx_buf), 0);
+			if (ret > 0) {
+				rx_total += ret;
+			}
+		} while (ret > 0);
+
+		zsock_close(sock);
+		k_sem_give(&rx_done);
+	}
+}
+
+K_THREAD_STACK_DEFINE(receiver_stack, 2048);
+static struct k_thread receiver_thread;
+
+static int create_file(void)
+{
+	struct fs_file_t file;
+	size_t written;
+	int i, ret;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = i;
+	}
+
+	ret = fs_open(&file, FILE_NAME, FS_O_CREATE | FS_O_WRITE);
+	if (ret < 0) {
+		return ret;
+	}
+
+	for (written = 0; written < FILE_SIZE; written += ret) {
+		ret = fs_write(&file, buf, MIN(sizeof(buf),
+					       FILE_SIZE - written));
+		if (ret <= 0) {
+			break;
+		}
+	}
+
+	fs_close(&file);
+
+	return written == FILE_SIZE ? 0 : -EIO;
+}
+
+static ssize_t send_copy(int sock, int fd)
+{
+	size_t sent = 0;
+	ssize_t len, ret;
+	ssize_t pos;
+
+	while ((len = read(fd, buf, sizeof(buf))) > 0) {
+		for (pos = 0; pos < len; pos += ret) {
+			ret = zsock_send(sock, buf + pos, len - pos, 0);
+			if (ret < 0) {
+				return -1;
+			}
+		}
+
+		sent += len;
+	}
+
+	return len < 0 ? -1 : sent;
+}
+
+static void run(bool use_sendfile)
+{
+	uint32_t start;
+	uint64_t us;
+	ssize_t sent;
+	int sock, fd;
+
+	fd = open(FILE_NAME, O_RDONLY);
+	if (fd < 0) {
+		printk("Cannot open file (%d)\n", errno);
+		return;
+	}
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0 || zsock_connect(sock, (struct sockaddr *)&addr,
+				      sizeof(addr)) < 0) {
+		printk("Cannot connect (%d)\n", errno);
+		goto out;
+	}
+
+	start = k_cycle_get_32();
+
+	if (use_sendfile) {
+		sent = sendfile(sock, fd, NULL, FILE_SIZE);
+	} else {
+		sent = send_copy(sock, fd);
+	}
+
+	if (sent != FILE_SIZE) {
+		printk("Cannot send (%d, %d)\n", (int)sent, errno);
+		goto out;
+	}
+
+	zsock_close(sock);
+	sock = -1;
+	k_sem_take(&rx_done, K_FOREVER);
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%-8s: %u bytes in %u us, %u kB/s\n",
+	       use_sendfile ? "sendfile" : "copy", (uint32_t)rx_total,
+	       (uint32_t)us, (uint32_t)(rx_total * USEC_PER_SEC / 1024 / us));
+
+out:
+	if (sock >= 0) {
+		zsock_close(sock);
+	}
+
+	close(fd);
+}
+
+void main(void)
+{
+	int s_sock;
+	int ret;
+
+	ret = fs_mount(&mp);
+	if (ret < 0 || create_file() < 0) {
+		printk("Cannot create file on RAM disk (%d)\n", ret);
+		return;
+	}
+
+	s_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s_sock < 0 ||
+	    zsock_bind(s_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_listen(s_sock, 1) < 0) {
+		printk("Cannot create TCP server (%d)\n", errno);
+		return;
+	}
+
+	k_thread_create(&receiver_thread, receiver_stack,
+			K_THREAD_STACK_SIZEOF(receiver_stack), receiver,
+			INT_TO_POINTER(s_sock), NULL, NULL,
+			K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	run(false);
+	run(true);
+
+	printk("fin\n");
+}
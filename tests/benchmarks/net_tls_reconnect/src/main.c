@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Cost of reconnecting a TLS client to a TLS server over the loopback
+ * interface, with full handshakes and with session resumption.
+ *
+ * A server thread accepts the connections, which completes the handshake,
+ * and closes them once the client closed its side. The main thread
+ * connects and closes N_CONNECTIONS times in a row, then reports the
+ * memory used by one connection.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <net/socket.h>
+#include <net/tls_credentials.h>
+
+#define N_CONNECTIONS	20
+#define PORT_FULL	4242
+#define PORT_RESUMED	4243
+#define HOSTNAME	"localhost"
+
+#define SERVER_TAG	1
+#define CA_TAG		2
+
+static const unsigned char ca_certificate[] = {
+#include "ca.der.inc"
+};
+
+static const unsigned char server_certificate[] = {
+#include "server.der.inc"
+};
+
+static const unsigned char private_key[] = {
+#include "server_privkey.der.inc"
+};
+
+static K_SEM_DEFINE(conn_done, 0, 1);
+
+K_THREAD_STACK_ARRAY_DEFINE(server_stacks, 2, 4096);
+static struct k_thread server_threads[2];
+
+static struct sockaddr_in server_addr(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { { { 192, 0, 2, 1 } } },
+	};
+
+	return addr;
+}
+
+static void server(void *p1, void *p2, void *p3)
+{
+	int s_sock = POINTER_TO_INT(p1);
+	uint8_t buf[16];
+	int sock;
+
+	while (true) {
+		sock = zsock_accept(s_sock, NULL, NULL);
+		if (sock < 0) {
+			printk("Cannot accept (%d)\n", errno);
+			return;
+		}
+
+		while (zsock_recv(sock, buf, sizeof(buf), 0) > 0) {
+		}
+
+		zsock_close(sock);
+		k_sem_give(&conn_done);
+	}
+}
+
+static int start_server(int index, uint16_t port, int cache)
+{
+	sec_tag_t sec_tag_list[] = { SERVER_TAG };
+	struct sockaddr_in addr = server_addr(port);
+	int sock;
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	if (sock < 0 ||
+	    zsock_setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, sec_tag_list,
+			     sizeof(sec_tag_list)) < 0 ||
+	    zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE, &cache,
+			     sizeof(cache)) < 0 ||
+	    zsock_bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_listen(sock, 1) < 0) {
+		return -1;
+	}
+
+	k_thread_create(&server_threads[index], server_stacks[index],
+			K_THREAD_STACK_SIZEOF(server_stacks[index]), server,
+			INT_TO_POINTER(sock), NULL, NULL,
+			K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	return 0;
+}
+
+static int connect_once(uint16_t port, int cache,
+			struct tls_memory_usage *usage)
+{
+	sec_tag_t sec_tag_list[] = { CA_TAG };
+	struct sockaddr_in addr = server_addr(port);
+	socklen_t optlen = sizeof(*usage);
+	int sock, ret;
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	if (sock < 0) {
+		return -1;
+	}
+
+	ret = zsock_setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, sec_tag_list,
+			       sizeof(sec_tag_list));
+	if (ret == 0) {
+		ret = zsock_setsockopt(sock, SOL_TLS, TLS_HOSTNAME, HOSTNAME,
+				       sizeof(HOSTNAME));
+	}
+
+	if (ret == 0) {
+		ret = zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE,
+				       &cache, sizeof(cache));
+	}
+
+	if (ret == 0) {
+		ret = zsock_connect(sock, (struct sockaddr *)&addr,
+				    sizeof(addr));
+	}
+
+	if (ret == 0 && usage != NULL) {
+		ret = zsock_getsockopt(sock, SOL_TLS, TLS_MEMORY_USAGE, usage,
+				       &optlen);
+	}
+
+	zsock_close(sock);
+
+	if (ret == 0) {
+		k_sem_take(&conn_done, K_FOREVER);
+	}
+
+	return ret;
+}
+
+static void run(uint16_t port, int cache)
+{
+	uint32_t start;
+	uint32_t ms;
+	int i;
+
+	start = k_uptime_get_32();
+
+	for (i = 0; i < N_CONNECTIONS; i++) {
+		if (connect_once(port, cache, NULL) < 0) {
+			printk("Cannot connect (%d)\n", errno);
+			return;
+		}
+	}
+
+	ms = k_uptime_get_32() - start;
+
+	printk("%-7s: %d connections in %u ms, %u ms per connection\n",
+	       cache == TLS_SESSION_CACHE_ENABLED ? "resumed" : "full",
+	       N_CONNECTIONS, ms, ms / N_CONNECTIONS);
+}
+
+static void report_memory(void)
+{
+	struct tls_memory_usage usage;
+
+	if (connect_once(PORT_RESUMED, TLS_SESSION_CACHE_ENABLED,
+			 &usage) < 0) {
+		printk("Cannot read memory usage (%d)\n", errno);
+		return;
+	}
+
+	printk("memory : context %u, buffers %u/%u, session %u, "
+	       "config %u shared by %u\n", usage.context, usage.in_buf,
+	       usage.out_buf, usage.session, usage.config,
+	       usage.config_users);
+}
+
+void main(void)
+{
+	if (tls_credential_add(CA_TAG, TLS_CREDENTIAL_CA_CERTIFICATE,
+			       ca_certificate, sizeof(ca_certificate)) < 0 ||
+	    tls_credential_add(SERVER_TAG, TLS_CREDENTIAL_SERVER_CERTIFICATE,
+			       server_certificate,
+			       sizeof(server_certificate)) < 0 ||
+	    tls_credential_add(SERVER_TAG, TLS_CREDENTIAL_PRIVATE_KEY,
+			       private_key, sizeof(private_key)) < 0) {
+		printk("Cannot register credentials\n");
+		return;
+	}
+
+	if (start_server(0, PORT_FULL, TLS_SESSION_CACHE_DISABLED) < 0 ||
+	    start_server(1, PORT_RESUMED, TLS_SESSION_CACHE_ENABLED) < 0) {
+		printk("Cannot create TLS servers (%d)\n", errno);
+		return;
+	}
+
+	run(PORT_FULL, TLS_SESSION_CACHE_DISABLED);
+	run(PORT_RESUMED, TLS_SESSION_CACHE_ENABLED);
+	report_memory();
+
+	printk("fin\n");
+}
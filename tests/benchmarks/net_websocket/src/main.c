@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Websocket throughput over the loopback interface. A server stand-in
+ * thread does the handshake and then drains the masked frames sent by the
+ * client, or sends unmasked frames to the client.
+ *
+ * send: frames sent with websocket_send_msg(), masked by the library
+ * iov:  frames sent with websocket_send_msg_iov(), the payload being given
+ *       in two parts like MQTT does with the packet header and payload
+ * recv: frames received with websocket_recv_msg()
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <sys/byteorder.h>
+#include <sys/base64.h>
+#include <string.h>
+#include <mbedtls/sha1.h>
+
+#include <net/socket.h>
+#include <net/websocket.h>
+
+#define TOTAL_LEN	(256 * 1024)
+#define MAX_FRAME	8192
+#define PORT		8080
+#define TIMEOUT_MS	5000
+
+#define WS_MAGIC "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_KEY "Sec-WebSocket-Key: "
+
+enum mode {
+	MODE_DRAIN,
+	MODE_SEND,
+};
+
+static const size_t frame_sizes[] = { 64, 1024, MAX_FRAME };
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static uint8_t payload[MAX_FRAME];
+static uint8_t rx_buf[MAX_FRAME];
+static uint8_t tmp_buf[512];
+static char server_buf[1460];
+
+static enum mode server_mode;
+static size_t server_frame_len;
+static size_t server_total;
+
+static K_SEM_DEFINE(server_start, 0, 1);
+static K_SEM_DEFINE(server_done, 0, 1);
+
+static size_t header_len(size_t len, bool masked)
+{
+	size_t hdr_len = 2;
+
+	if (len >= 65536) {
+		hdr_len += 8;
+	} else if (len >= 126) {
+		hdr_len += 2;
+	}
+
+	return hdr_len + (masked ? 4 : 0);
+}
+
+static int send_all(int sock, const void *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len) {
+		ret = zsock_send(sock, buf, len, 0);
+		if (ret < 0) {
+			return -1;
+		}
+
+		buf = (const uint8_t *)buf + ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+/* Answer the handshake with the key the client expects */
+static int server_handshake(int sock)
+{
+	uint8_t sha1[20];
+	char accept[32];
+	char *key, *end;
+	size_t len = 0, olen;
+	ssize_t ret;
+
+	do {
+		ret = zsock_recv(sock, server_buf + len,
+				 sizeof(server_buf) - 1 - len, 0);
+		if (ret <= 0) {
+			return -1;
+		}
+
+		len += ret;
+		server_buf[len] = '\0';
+	} while (strstr(server_buf, "\r\n\r\n") == NULL);
+
+	key = strstr(server_buf, WS_KEY);
+	if (key == NULL) {
+		return -1;
+	}
+
+	key += sizeof(WS_KEY) - 1;
+	end = strstr(key, "\r\n");
+
+	/* The magic string replaces the end of the request */
+	strcpy(end, WS_MAGIC);
+
+	mbedtls_sha1_ret((const unsigned char *)key, strlen(key), sha1);
+
+	if (base64_encode((uint8_t *)accept, sizeof(accept) - 1, &olen,
+			  sha1, sizeof(sha1)) < 0) {
+		return -1;
+	}
+
+	accept[olen] = '\0';
+
+	len = snprintk(server_buf, sizeof(server_buf),
+		       "HTTP/1.1 101 Switching Protocols\r\n"
+		       "Upgrade: websocket\r\n"
+		       "Connection: Upgrade\r\n"
+		       "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+
+	return send_all(sock, server_buf, len);
+}
+
+static int server_drain(int sock, size_t total)
+{
+	ssize_t ret;
+
+	while (total > 0) {
+		ret = zsock_recv(sock, server_buf, sizeof(server_buf), 0);
+		if (ret <= 0) {
+			return -1;
+		}
+
+		total -= MIN(total, ret);
+	}
+
+	return 0;
+}
+
+static int server_send(int sock, size_t frame_len, size_t total)
+{
+	uint8_t header[4];
+	size_t hdr_len = header_len(frame_len, false);
+
+	header[0] = BIT(7) | WEBSOCKET_OPCODE_DATA_BINARY;
+
+	if (frame_len < 126) {
+		header[1] = frame_len;
+	} else {
+		header[1] = 126;
+		sys_put_be16(frame_len, &header[2]);
+	}
+
+	for (; total >= frame_len; total -= frame_len) {
+		if (send_all(sock, header, hdr_len) < 0 ||
+		    send_all(sock, payload, frame_len) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void server_thread(void *p1, void *p2, void *p3)
+{
+	int s_sock = POINTER_TO_INT(p1);
+	int sock;
+	int ret;
+
+	sock = zsock_accept(s_sock, NULL, NULL);
+	if (sock < 0 || server_handshake(sock) < 0) {
+		printk("Server handshake failed\n");
+		return;
+	}
+
+	while (true) {
+		k_sem_take(&server_start, K_FOREVER);
+
+		if (server_mode == MODE_DRAIN) {
+			ret = server_drain(sock, server_total);
+		} else {
+			ret = server_send(sock, server_frame_len,
+					  server_total);
+		}
+
+		if (ret < 0) {
+			printk("Server failed (%d)\n", errno);
+			break;
+		}
+
+		k_sem_give(&server_done);
+	}
+
+	zsock_close(sock);
+}
+
+K_THREAD_STACK_DEFINE(server_stack, 2048);
+static struct k_thread server_thread_data;
+
+static void report(const char *name, size_t frame_len, uint32_t start,
+		   size_t total)
+{
+	uint64_t us;
+
+	us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%-6s %5zu: %zu bytes in %u us, %u kB/s\n", name, frame_len,
+	       total, (uint32_t)us, (uint32_t)(total * 1000 / us));
+}
+
+static int run_send(int ws_sock, size_t frame_len, bool iov)
+{
+	size_t count = TOTAL_LEN / frame_len;
+	struct iovec io_vector[] = {
+		{ .iov_base = payload, .iov_len = 2 },
+		{ .iov_base = payload + 2, .iov_len = frame_len - 2 },
+	};
+	uint32_t start;
+	size_t i;
+	int ret;
+
+	server_mode = MODE_DRAIN;
+	server_total = count * (frame_len + header_len(frame_len, true));
+	k_sem_give(&server_start);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < count; i++) {
+		if (iov) {
+			ret = websocket_send_msg_iov(ws_sock, io_vector,
+						     ARRAY_SIZE(io_vector),
+						     WEBSOCKET_OPCODE_DATA_BINARY,
+						     true, true, TIMEOUT_MS);
+		} else {
+			ret = websocket_send_msg(ws_sock, payload, frame_len,
+						 WEBSOCKET_OPCODE_DATA_BINARY,
+						 true, true, TIMEOUT_MS);
+		}
+
+		if (ret != frame_len) {
+			return -1;
+		}
+	}
+
+	if (k_sem_take(&server_done, K_MSEC(TIMEOUT_MS)) < 0) {
+		return -1;
+	}
+
+	report(iov ? "iov" : "send", frame_len, start, count * frame_len);
+
+	return 0;
+}
+
+static int run_recv(int ws_sock, size_t frame_len)
+{
+	size_t count = TOTAL_LEN / frame_len;
+	size_t total = count * frame_len;
+	size_t received = 0;
+	uint32_t message_type;
+	uint64_t remaining;
+	uint32_t start;
+	int ret;
+
+	server_mode = MODE_SEND;
+	server_frame_len = frame_len;
+	server_total = total;
+	k_sem_give(&server_start);
+
+	start = k_cycle_get_32();
+
+	while (received < total) {
+		ret = websocket_recv_msg(ws_sock, rx_buf, sizeof(rx_buf),
+					 &message_type, &remaining,
+					 TIMEOUT_MS);
+		if (ret == -EAGAIN) {
+			continue;
+		}
+
+		if (ret <= 0) {
+			return -1;
+		}
+
+		received += ret;
+	}
+
+	if (k_sem_take(&server_done, K_MSEC(TIMEOUT_MS)) < 0) {
+		return -1;
+	}
+
+	report("recv", frame_len, start, total);
+
+	return 0;
+}
+
+static int ws_connect(void)
+{
+	struct websocket_request req = {
+		.host = "192.0.2.1",
+		.url = "/",
+		.tmp_buf = tmp_buf,
+		.tmp_buf_len = sizeof(tmp_buf),
+	};
+	int s_sock, sock;
+
+	s_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s_sock < 0 ||
+	    zsock_bind(s_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_listen(s_sock, 1) < 0) {
+		return -1;
+	}
+
+	k_thread_create(&server_thread_data, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_thread,
+			INT_TO_POINTER(s_sock), NULL, NULL,
+			K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0 ||
+	    zsock_connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		return -1;
+	}
+
+	return websocket_connect(sock, &req, TIMEOUT_MS, NULL);
+}
+
+void main(void)
+{
+	int ws_sock;
+	int i;
+
+	for (i = 0; i < sizeof(payload); i++) {
+		payload[i] = i;
+	}
+
+	ws_sock = ws_connect();
+	if (ws_sock < 0) {
+		printk("Cannot connect websocket (%d)\n", ws_sock);
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(frame_sizes); i++) {
+		if (run_send(ws_sock, frame_sizes[i], false) < 0 ||
+		    run_send(ws_sock, frame_sizes[i], true) < 0 ||
+		    run_recv(ws_sock, frame_sizes[i]) < 0) {
+			printk("Frame size %zu failed\n", frame_sizes[i]);
+			return;
+		}
+	}
+
+	printk("fin\n");
+}
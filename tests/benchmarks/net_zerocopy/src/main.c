@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Socket throughput over the loopback interface, with the data copied
+ * between the application and the network buffers, and without copying
+ * it, using MSG_ZEROCOPY for sending and zsock_recv_zerocopy() for
+ * receiving.
+ *
+ * The main thread sends a chunk of data and receives it back on the other
+ * socket before sending the next one. The received data is checked.
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+
+#include <net/buf.h>
+#include <net/socket.h>
+
+#define TOTAL_LEN	(1024 * 1024)
+#define UDP_CHUNK	512
+#define TCP_CHUNK	2048
+#define PORT		4242
+
+static uint8_t tx_data[TCP_CHUNK];
+static uint8_t rx_data[TCP_CHUNK];
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static int zerocopy_done(int sock)
+{
+	socklen_t optlen = sizeof(int);
+	int done;
+
+	if (zsock_getsockopt(sock, SOL_SOCKET, SO_ZEROCOPY_DONE, &done,
+			     &optlen) < 0) {
+		return -1;
+	}
+
+	return done;
+}
+
+/* The stack references at most CONFIG_NET_CONTEXT_ZEROCOPY_BUF_COUNT
+ * buffers at a time, wait for one of them to be released. The data is
+ * never modified so the same buffer can be in flight several times.
+ */
+static int wait_zerocopy(int sock, int sent, int in_flight)
+{
+	int done;
+
+	while ((done = zerocopy_done(sock)) >= 0 && sent - done > in_flight) {
+		k_sleep(K_MSEC(1));
+	}
+
+	return done < 0 ? -1 : 0;
+}
+
+static int send_chunk(int sock, size_t len, bool zerocopy, int *sent)
+{
+	size_t pos = 0;
+	ssize_t ret;
+
+	while (pos < len) {
+		if (zerocopy) {
+			if (wait_zerocopy(sock, *sent,
+				CONFIG_NET_CONTEXT_ZEROCOPY_BUF_COUNT - 1) < 0) {
+				return -1;
+			}
+
+			ret = zsock_send(sock, tx_data + pos, len - pos,
+					 ZSOCK_MSG_ZEROCOPY);
+			(*sent)++;
+		} else {
+			ret = zsock_send(sock, tx_data + pos, len - pos, 0);
+		}
+
+		if (ret < 0) {
+			return -1;
+		}
+
+		pos += ret;
+	}
+
+	return 0;
+}
+
+static int check_data(const uint8_t *data, size_t pos, size_t len)
+{
+	if (memcmp(data, tx_data + pos, len)) {
+		printk("Invalid data at %zd\n", pos);
+		return -1;
+	}
+
+	return 0;
+}
+
+static ssize_t recv_zerocopy(int sock, size_t pos)
+{
+	struct net_buf *frags, *frag;
+	ssize_t ret;
+
+	ret = zsock_recv_zerocopy(sock, &frags, 0, NULL, NULL);
+	if (ret <= 0) {
+		return ret;
+	}
+
+	for (frag = frags; frag; frag = frag->frags) {
+		if (pos + frag->len > sizeof(tx_data) ||
+		    check_data(frag->data, pos, frag->len)) {
+			ret = -1;
+			break;
+		}
+
+		pos += frag->len;
+	}
+
+	net_buf_unref(frags);
+
+	return ret;
+}
+
+static int recv_chunk(int sock, size_t len, bool zerocopy)
+{
+	size_t pos = 0;
+	ssize_t ret;
+
+	while (pos < len) {
+		if (zerocopy) {
+			ret = recv_zerocopy(sock, pos);
+		} else {
+			ret = zsock_recv(sock, rx_data, len - pos, 0);
+			if (ret > 0 && check_data(rx_data, pos, ret)) {
+				ret = -1;
+			}
+		}
+
+		if (ret <= 0) {
+			return -1;
+		}
+
+		pos += ret;
+	}
+
+	return 0;
+}
+
+static void report(const char *name, uint32_t start)
+{
+	uint64_t us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+	printk("%s: %d bytes in %u us, %u kB/s\n", name, TOTAL_LEN,
+	       (uint32_t)us, (uint32_t)(TOTAL_LEN * (uint64_t)USEC_PER_SEC /
+					 us / 1024));
+}
+
+static void run(const char *name, int tx_sock, int rx_sock, size_t chunk,
+		bool zerocopy)
+{
+	uint32_t start;
+	size_t pos;
+	int sent = 0;
+
+	start = k_cycle_get_32();
+
+	for (pos = 0; pos < TOTAL_LEN; pos += chunk) {
+		if (send_chunk(tx_sock, chunk, zerocopy, &sent) < 0) {
+			printk("Cannot send (%d)\n", errno);
+			return;
+		}
+
+		if (recv_chunk(rx_sock, chunk, zerocopy) < 0) {
+			printk("Cannot receive (%d)\n", errno);
+			return;
+		}
+	}
+
+	/* All the buffers must have been released before reusing them */
+	if (zerocopy && wait_zerocopy(tx_sock, sent, 0) < 0) {
+		printk("Cannot get zero-copy status (%d)\n", errno);
+		return;
+	}
+
+	report(name, start);
+}
+
+static void run_udp(bool zerocopy)
+{
+	int tx_sock, rx_sock;
+
+	rx_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	tx_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (rx_sock < 0 || tx_sock < 0) {
+		printk("Cannot create UDP sockets (%d)\n", errno);
+		return;
+	}
+
+	if (zsock_bind(rx_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    zsock_connect(tx_sock, (struct sockaddr *)&addr,
+			  sizeof(addr)) < 0) {
+		printk("Cannot connect UDP sockets (%d)\n", errno);
+		goto out;
+	}
+
+	run(zerocopy ? "udp zerocopy" : "udp copy", tx_sock, rx_sock,
+	    UDP_CHUNK, zerocopy);
+
+out:
+	zsock_close(tx_sock);
+	zsock_close(rx_sock);
+}
+
+static void run_tcp(bool zerocopy)
+{
+	int listen_sock, tx_sock, rx_sock = -1;
+
+	listen_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	tx_sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listen_sock < 0 || tx_sock < 0) {
+		printk("Cannot create TCP sockets (%d)\n", errno);
+		return;
+	}
+
+	if (zsock_bind(listen_sock, (struct sockaddr *)&addr,
+		       sizeof(addr)) < 0 ||
+	    zsock_listen(listen_sock, 1) < 0 ||
+	    zsock_connect(tx_sock, (struct sockaddr *)&addr,
+			  sizeof(addr)) < 0) {
+		printk("Cannot connect TCP sockets (%d)\n", errno);
+		goto out;
+	}
+
+	rx_sock = zsock_accept(listen_sock, NULL, NULL);
+	if (rx_sock < 0) {
+		printk("Cannot accept (%d)\n", errno);
+		goto out;
+	}
+
+	run(zerocopy ? "tcp zerocopy" : "tcp copy", tx_sock, rx_sock,
+	    TCP_CHUNK, zerocopy);
+
+out:
+	zsock_close(tx_sock);
+	if (rx_sock >= 0) {
+		zsock_close(rx_sock);
+	}
+
+	zsock_close(listen_sock);
+
+	/* Let the connections close before the port is reused */
+	k_sleep(K_MSEC(100));
+}
+
+void main(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(tx_data); i++) {
+		tx_data[i] = i;
+	}
+
+	run_udp(false);
+	run_udp(true);
+	run_tcp(false);
+	run_tcp(true);
+
+	printk("fin\n");
+}
@@ -390,6 +390,225 @@ static void test_json_invalid_number(void)
 	parse_harness(encoded, ARRAY_SIZE(encoded));
 }
 
+struct test_numbers {
+	int64_t some_int64;
+	int64_t min_int64;
+	struct json_obj_token some_float;
+	struct json_obj_token floats[4];
+	size_t floats_len;
+};
+
+static const struct json_obj_descr numbers_descr[] = {
+	JSON_OBJ_DESCR_PRIM(struct test_numbers, some_int64, JSON_TOK_INT64),
+	JSON_OBJ_DESCR_PRIM(struct test_numbers, min_int64, JSON_TOK_INT64),
+	JSON_OBJ_DESCR_PRIM(struct test_numbers, some_float, JSON_TOK_FLOAT),
+	JSON_OBJ_DESCR_ARRAY(struct test_numbers, floats, 4, floats_len,
+			     JSON_TOK_FLOAT),
+};
+
+static void test_json_numbers_decoding(void)
+{
+	struct test_numbers tn;
+	char encoded[] = "{\"some_int64\":1099511627776,"
+		"\"min_int64\":-9223372036854775808,"
+		"\"some_float\":-21.5e-3,"
+		"\"floats\":[0,1.25,2E+10,-0.5]}";
+	int ret;
+
+	ret = json_obj_parse(encoded, sizeof(encoded) - 1, numbers_descr,
+			     ARRAY_SIZE(numbers_descr), &tn);
+	zassert_equal(ret, (1 << ARRAY_SIZE(numbers_descr)) - 1,
+		      "All fields decoded correctly");
+	zassert_equal(tn.some_int64, 1099511627776LL,
+		      "64-bit integer decoded correctly");
+	zassert_equal(tn.min_int64, INT64_MIN,
+		      "Minimum 64-bit integer decoded correctly");
+	zassert_true(tn.some_float.length == strlen("-21.5e-3") &&
+		     !memcmp(tn.some_float.start, "-21.5e-3",
+			     tn.some_float.length),
+		     "Float decoded correctly");
+	zassert_equal(tn.floats_len, 4, "Float array has 4 items");
+	zassert_true(tn.floats[2].length == strlen("2E+10") &&
+		     !memcmp(tn.floats[2].start, "2E+10",
+			     tn.floats[2].length),
+		     "Float array decoded correctly");
+}
+
+static void test_json_numbers_encoding(void)
+{
+	struct test_numbers tn = {
+		.some_int64 = 1099511627776LL,
+		.min_int64 = INT64_MIN,
+		.some_float = { "-21.5e-3", 8 },
+		.floats = { { "0", 1 }, { "1.25", 4 } },
+		.floats_len = 2,
+	};
+	const char encoded[] = "{\"some_int64\":1099511627776,"
+		"\"min_int64\":-9223372036854775808,"
+		"\"some_float\":-21.5e-3,"
+		"\"floats\":[0,1.25]}";
+	char buffer[sizeof(encoded)];
+	int ret;
+
+	ret = json_obj_encode_buf(numbers_descr, ARRAY_SIZE(numbers_descr),
+				  &tn, buffer, sizeof(buffer));
+	zassert_equal(ret, 0, "Encoding function returned no errors");
+	zassert_true(!strcmp(buffer, encoded), "Encoded contents consistent");
+
+	tn.some_float.length = 4;
+	ret = json_obj_encode_buf(numbers_descr, ARRAY_SIZE(numbers_descr),
+				  &tn, buffer, sizeof(buffer));
+	zassert_equal(ret, -EINVAL, "Invalid float encoded");
+}
+
+static void test_json_invalid_numbers(void)
+{
+	struct encoding_test encoded[] = {
+		{ "{\"some_int\":2147483648}", -ERANGE },
+		{ "{\"some_int\":1.5}", -EINVAL },
+		{ "{\"some_int\":-}", -EINVAL },
+	};
+	struct test_numbers tn;
+	char overflow[] = "{\"some_int64\":9223372036854775808}";
+	char bad_float[] = "{\"some_float\":1.e5}";
+	int ret;
+
+	parse_harness(encoded, ARRAY_SIZE(encoded));
+
+	ret = json_obj_parse(overflow, sizeof(overflow) - 1, numbers_descr,
+			     ARRAY_SIZE(numbers_descr), &tn);
+	zassert_equal(ret, -ERANGE, "64-bit overflow detected");
+
+	ret = json_obj_parse(bad_float, sizeof(bad_float) - 1, numbers_descr,
+			     ARRAY_SIZE(numbers_descr), &tn);
+	zassert_equal(ret, -EINVAL, "Invalid float detected");
+}
+
+static void test_json_skip_unknown(void)
+{
+	struct test_nested tn;
+	char encoded[] = "{\"unknown\":{\"nested_int\":1,\"x\":[[],{}]},"
+		"\"nested_int\":42,\"list\":[\"}\",null,{\"a\":[1]}],"
+		"\"nested_int\":43,\"other\":null}";
+	int ret;
+
+	ret = json_obj_parse(encoded, sizeof(encoded) - 1, nested_descr,
+			     ARRAY_SIZE(nested_descr), &tn);
+	zassert_equal(ret, 1, "Only nested_int decoded");
+	zassert_equal(tn.nested_int, 42, "First value of the field kept");
+}
+
+/* test_json_decoding payload, with commas between all the values */
+static const char stream_encoded[] = "{\"some_string\":\"zephyr 123\\uABCD\","
+	"\"some_int\":\t-42\n,"
+	"\"some_bool\":true    \t  \n\r   ,"
+	"\"unknown\":{\"x\":[\"]\\\"\",1,{}],\"y\":null},"
+	"\"some_nested_struct\":{    "
+	"\"nested_int\":-1234,\n\n"
+	"\"nested_bool\":false,\t"
+	"\"nested_string\":\"this should be escaped: \\t\"},"
+	"\"some_array\":[11,22, 33,\t45,\n299],"
+	"\"another_b!@l\":true,"
+	"\"if\":false,"
+	"\"another-array\":[2,3,5,7],"
+	"\"4nother_ne$+\":{\"nested_int\":1234,"
+	"\"nested_bool\":true,"
+	"\"nested_string\":\"no escape necessary\"}"
+	"}\n";
+
+static void stream_check(const struct test_struct *ts)
+{
+	const int expected_array[] = { 11, 22, 33, 45, 299 };
+
+	zassert_true(!strcmp(ts->some_string, "zephyr 123\\uABCD"),
+		     "String decoded correctly");
+	zassert_equal(ts->some_int, -42, "Integer decoded correctly");
+	zassert_true(ts->some_bool, "Boolean decoded correctly");
+	zassert_equal(ts->some_nested_struct.nested_int, -1234,
+		      "Nested integer decoded correctly");
+	zassert_true(!strcmp(ts->some_nested_struct.nested_string,
+			     "this should be escaped: \\t"),
+		     "Nested string decoded correctly");
+	zassert_equal(ts->some_array_len, 5, "Array has 5 items");
+	zassert_true(!memcmp(ts->some_array, expected_array,
+			     sizeof(expected_array)),
+		     "Array decoded with expected values");
+	zassert_equal(ts->another_array_len, 4, "Named array has 4 items");
+	zassert_true(!strcmp(ts->xnother_nexx.nested_string,
+			     "no escape necessary"),
+		     "Named nested string decoded correctly");
+}
+
+static void test_json_stream_decoding(void)
+{
+	static const size_t chunk_sizes[] = {
+		sizeof(stream_encoded), 1, 2, 7, 64,
+	};
+	struct json_obj_stream stream;
+	struct test_struct ts;
+	char buf[128];
+	size_t i, pos, len;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(chunk_sizes); i++) {
+		memset(&ts, 0, sizeof(ts));
+		json_obj_stream_init(&stream, test_descr,
+				     ARRAY_SIZE(test_descr), &ts,
+				     buf, sizeof(buf));
+
+		for (pos = 0; pos < sizeof(stream_encoded) - 1; pos += len) {
+			len = MIN(chunk_sizes[i],
+				  sizeof(stream_encoded) - 1 - pos);
+			ret = json_obj_stream_feed(&stream,
+						   &stream_encoded[pos], len);
+			zassert_equal(ret, 0, "Chunk %zu of %zu bytes parsed",
+				      pos, len);
+		}
+
+		ret = json_obj_stream_end(&stream);
+		zassert_equal(ret, (1 << ARRAY_SIZE(test_descr)) - 1,
+			      "All fields decoded in chunks of %zu bytes",
+			      chunk_sizes[i]);
+		stream_check(&ts);
+	}
+}
+
+static void stream_harness(const char *encoded, int result, size_t buf_size)
+{
+	struct json_obj_stream stream;
+	struct test_struct ts;
+	char buf[64];
+	int ret;
+
+	json_obj_stream_init(&stream, test_descr, ARRAY_SIZE(test_descr),
+			     &ts, buf, buf_size);
+	ret = json_obj_stream_feed(&stream, encoded, strlen(encoded));
+	if (ret == 0) {
+		ret = json_obj_stream_end(&stream);
+	}
+
+	zassert_equal(ret, result, "Decoding '%s' result %d, expected %d",
+		      encoded, ret, result);
+}
+
+static void test_json_stream_errors(void)
+{
+	stream_harness("{\"some_int\":1", -EINVAL, 64);
+	stream_harness("{\"some_int\":1,}", -EINVAL, 64);
+	stream_harness("{\"some_int\":1 \"if\":true}", -EINVAL, 64);
+	stream_harness("{\"some_int\":1} x", -EINVAL, 64);
+	stream_harness("{\"some_string\":null}", -EINVAL, 64);
+	stream_harness("{\"some_string\":\"\\uABC@\"}", -EINVAL, 64);
+	stream_harness("{\"some_bool\":truffle}", -EINVAL, 64);
+	stream_harness("{\"some_int\":\"42\"}", -EINVAL, 64);
+	stream_harness("{\"another-array\":[1,2,3,4,5,6,7,8,9,10,11]}",
+		       -ENOSPC, 64);
+	stream_harness("{\"some_string\":\"too long for the buffer\"}",
+		       -ENOMEM, 16);
+	stream_harness("{\"unknown\":[[[[[[[[[[1]]]]]]]]]],\"some_int\":1}",
+		       1 << 1, 64);
+}
+
 static void test_json_missing_quote(void)
 {
 	struct test_struct ts;
@@ -560,7 +779,13 @@ void test_main(void)
 			 ztest_unit_test(test_json_escape_empty),
 			 ztest_unit_test(test_json_escape_no_op),
 			 ztest_unit_test(test_json_escape_bounds_check),
-			 ztest_unit_test(test_json_encode_bounds_check)
+			 ztest_unit_test(test_json_encode_bounds_check),
+			 ztest_unit_test(test_json_numbers_decoding),
+			 ztest_unit_test(test_json_numbers_encoding),
+			 ztest_unit_test(test_json_invalid_numbers),
+			 ztest_unit_test(test_json_skip_unknown),
+			 ztest_unit_test(test_json_stream_decoding),
+			 ztest_unit_test(test_json_stream_errors)
 			 );
 
 	ztest_run_test_suite(lib_json_test);
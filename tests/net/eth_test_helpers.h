@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Fake Ethernet device and checksum helper for the tests that feed hand
+ * built frames to the stack or check the frames it sends.
+ */
+
+#include <zephyr/types.h>
+#include <random/rand32.h>
+
+#include <net/ethernet.h>
+
+struct eth_context {
+	struct net_if *iface;
+	uint8_t mac_addr[6];
+};
+
+static inline void eth_iface_init(struct net_if *iface)
+{
+	const struct device *dev = net_if_get_device(iface);
+	struct eth_context *context = dev->data;
+
+	net_if_set_link_addr(iface, context->mac_addr,
+			     sizeof(context->mac_addr),
+			     NET_LINK_ETHERNET);
+
+	ethernet_init(iface);
+}
+
+static inline int eth_init(const struct device *dev)
+{
+	struct eth_context *context = dev->data;
+
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	context->mac_addr[0] = 0x00;
+	context->mac_addr[1] = 0x00;
+	context->mac_addr[2] = 0x5E;
+	context->mac_addr[3] = 0x00;
+	context->mac_addr[4] = 0x53;
+	context->mac_addr[5] = sys_rand32_get();
+
+	return 0;
+}
+
+/* Ones' complement sum of data added to sum, in host byte order */
+static inline uint16_t chksum(uint32_t sum, const uint8_t *data, size_t len)
+{
+	for (; len > 1; len -= 2, data += 2) {
+		sum += (data[0] << 8) | data[1];
+	}
+
+	if (len) {
+		sum += data[0] << 8;
+	}
+
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return sum;
+}
@@ -0,0 +1,440 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define NET_LOG_LEVEL CONFIG_NET_GRO_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, NET_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/printk.h>
+
+#include <ztest.h>
+
+#include <net/ethernet.h>
+#include <net/buf.h>
+#include <net/net_ip.h>
+#include <net/net_l2.h>
+
+#include "../../eth_test_helpers.h"
+
+#include "connection.h"
+
+#define NET_LOG_ENABLED 1
+#include "net_private.h"
+
+#if NET_LOG_LEVEL >= LOG_LEVEL_DBG
+#define DBG(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#else
+#define DBG(fmt, ...)
+#endif
+
+#define TEST_MSS	1000
+#define TEST_SEQ	0x12345678
+#define TEST_PORT_SRC	4242
+#define TEST_PORT_DST	4243
+#define TCP_FIN		0x01
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+#define MAX_RECEIVED	8
+
+#define WAIT_TIME K_SECONDS(1)
+
+static struct in_addr in4addr_my = { { { 192, 0, 2, 1 } } };
+static struct in_addr in4addr_peer = { { { 192, 0, 2, 2 } } };
+static struct in6_addr in6addr_my = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					  0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr in6addr_peer = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0,
+					    0, 0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+
+static struct net_if *gro_iface;
+
+static K_SEM_DEFINE(wait_data, 0, UINT_MAX);
+
+struct received_seg {
+	uint32_t seq;
+	size_t len;
+	uint8_t flags;
+};
+
+static struct received_seg received[MAX_RECEIVED];
+static int received_count;
+static bool test_failed;
+
+/* Mark injected segments as already verified, like a driver with RX
+ * checksum offload does.
+ */
+static bool chksum_done;
+
+/* Put the headers and the payload of injected segments in separate
+ * buffers, like a driver which splits them does.
+ */
+static bool split_hdr;
+
+static struct eth_context eth_context_gro;
+
+static int eth_tx(const struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static enum ethernet_hw_caps eth_caps(const struct device *dev)
+{
+	return 0;
+}
+
+static struct ethernet_api api_funcs = {
+	.iface_api.init = eth_iface_init,
+
+	.get_capabilities = eth_caps,
+	.send = eth_tx,
+};
+
+ETH_NET_DEVICE_INIT(eth_gro_test, "eth_gro_test",
+		    eth_init, device_pm_control_nop,
+		    &eth_context_gro, NULL,
+		    CONFIG_ETH_INIT_PRIORITY,
+		    &api_funcs,
+		    NET_ETH_MTU);
+
+static enum net_verdict tcp_received(struct net_conn *conn,
+				     struct net_pkt *pkt,
+				     union net_ip_header *ip_hdr,
+				     union net_proto_header *proto_hdr,
+				     void *user_data)
+{
+	struct net_tcp_hdr *tcp_hdr = proto_hdr->tcp;
+	uint32_t seq = sys_get_be32(tcp_hdr->seq);
+	size_t len = net_pkt_remaining_data(pkt);
+	uint8_t byte;
+	size_t i;
+
+	if (net_pkt_family(pkt) == AF_INET &&
+	    chksum(0, (uint8_t *)ip_hdr->ipv4, NET_IPV4H_LEN) != 0xffff) {
+		DBG("Invalid IPv4 checksum\n");
+		test_failed = true;
+	}
+
+	for (i = 0; i < len; i++) {
+		if (net_pkt_read_u8(pkt, &byte) ||
+		    byte != (uint8_t)(seq - TEST_SEQ + i)) {
+			DBG("Invalid payload at %zd\n", i);
+			test_failed = true;
+			break;
+		}
+	}
+
+	if (received_count < MAX_RECEIVED) {
+		received[received_count].seq = seq;
+		received[received_count].len = len;
+		received[received_count].flags = tcp_hdr->flags;
+	}
+
+	received_count++;
+
+	k_sem_give(&wait_data);
+
+	net_pkt_unref(pkt);
+
+	return NET_OK;
+}
+
+static void iface_cb(struct net_if *iface, void *user_data)
+{
+	if (net_if_get_device(iface)->data == &eth_context_gro) {
+		gro_iface = iface;
+	}
+}
+
+static void test_setup(void)
+{
+	struct net_conn_handle *handle;
+
+	net_if_foreach(iface_cb, NULL);
+
+	zassert_not_null(gro_iface, "GRO interface not found");
+
+	zassert_not_null(net_if_ipv4_addr_add(gro_iface, &in4addr_my,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv4 address");
+	zassert_not_null(net_if_ipv6_addr_add(gro_iface, &in6addr_my,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv6 address");
+
+	zassert_equal(net_conn_register(IPPROTO_TCP, AF_INET, NULL, NULL,
+					TEST_PORT_SRC, TEST_PORT_DST,
+					tcp_received, NULL, &handle), 0,
+		      "Cannot register IPv4 TCP handler");
+	zassert_equal(net_conn_register(IPPROTO_TCP, AF_INET6, NULL, NULL,
+					TEST_PORT_SRC, TEST_PORT_DST,
+					tcp_received, NULL, &handle), 0,
+		      "Cannot register IPv6 TCP handler");
+}
+
+static void inject_segment(sa_family_t family, uint32_t offset, size_t len,
+			   uint8_t flags)
+{
+	static uint8_t payload[TEST_MSS];
+	uint8_t frame[sizeof(struct net_eth_hdr) + NET_IPV6TCPH_LEN];
+	struct net_eth_hdr *eth_hdr = (struct net_eth_hdr *)frame;
+	struct net_tcp_hdr *tcp_hdr;
+	size_t ip_hdr_len, hdr_len, i;
+	struct net_buf *frag;
+	uint8_t *addrs;
+	struct net_pkt *pkt;
+	uint32_t sum;
+
+	memset(frame, 0, sizeof(frame));
+
+	memcpy(eth_hdr->dst.addr, eth_context_gro.mac_addr,
+	       sizeof(eth_hdr->dst.addr));
+	eth_hdr->src.addr[5] = 0x42;
+
+	if (family == AF_INET) {
+		struct net_ipv4_hdr *ip_hdr = (struct net_ipv4_hdr *)
+			(frame + sizeof(struct net_eth_hdr));
+
+		ip_hdr_len = NET_IPV4H_LEN;
+		eth_hdr->type = htons(NET_ETH_PTYPE_IP);
+
+		ip_hdr->vhl = 0x45;
+		ip_hdr->len = htons(NET_IPV4TCPH_LEN + len);
+		ip_hdr->ttl = 64;
+		ip_hdr->proto = IPPROTO_TCP;
+		net_ipaddr_copy(&ip_hdr->src, &in4addr_peer);
+		net_ipaddr_copy(&ip_hdr->dst, &in4addr_my);
+		ip_hdr->chksum = ~htons(chksum(0, (uint8_t *)ip_hdr,
+					       NET_IPV4H_LEN));
+
+		addrs = (uint8_t *)&ip_hdr->src;
+	} else {
+		struct net_ipv6_hdr *ip_hdr = (struct net_ipv6_hdr *)
+			(frame + sizeof(struct net_eth_hdr));
+
+		ip_hdr_len = NET_IPV6H_LEN;
+		eth_hdr->type = htons(NET_ETH_PTYPE_IPV6);
+
+		ip_hdr->vtc = 0x60;
+		ip_hdr->len = htons(NET_TCPH_LEN + len);
+		ip_hdr->nexthdr = IPPROTO_TCP;
+		ip_hdr->hop_limit = 64;
+		net_ipaddr_copy(&ip_hdr->src, &in6addr_peer);
+		net_ipaddr_copy(&ip_hdr->dst, &in6addr_my);
+
+		addrs = (uint8_t *)&ip_hdr->src;
+	}
+
+	hdr_len = sizeof(struct net_eth_hdr) + ip_hdr_len + NET_TCPH_LEN;
+	tcp_hdr = (struct net_tcp_hdr *)(frame + hdr_len - NET_TCPH_LEN);
+
+	tcp_hdr->src_port = htons(TEST_PORT_SRC);
+	tcp_hdr->dst_port = htons(TEST_PORT_DST);
+	sys_put_be32(TEST_SEQ + offset, tcp_hdr->seq);
+	sys_put_be32(1, tcp_hdr->ack);
+	tcp_hdr->offset = (NET_TCPH_LEN / 4) << 4;
+	tcp_hdr->flags = flags;
+	sys_put_be16(1024, tcp_hdr->wnd);
+
+	/* Pseudo header, TCP header and payload */
+	sum = chksum(IPPROTO_TCP + NET_TCPH_LEN + len, addrs,
+		     2 * (ip_hdr_len == NET_IPV4H_LEN ?
+			  sizeof(struct in_addr) : sizeof(struct in6_addr)));
+	sum = chksum(sum, (uint8_t *)tcp_hdr, NET_TCPH_LEN);
+
+	for (i = 0; i < len; i++) {
+		payload[i] = (uint8_t)(offset + i);
+	}
+
+	tcp_hdr->chksum = ~htons(chksum(sum, payload, len));
+
+	pkt = net_pkt_rx_alloc_with_buffer(gro_iface,
+					   split_hdr ? hdr_len : hdr_len + len,
+					   AF_UNSPEC, 0, K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_pkt_write(pkt, frame, hdr_len), 0,
+		      "Cannot write headers");
+
+	if (split_hdr) {
+		for (i = 0; i < len; i += frag->len) {
+			frag = net_pkt_get_frag(pkt, K_NO_WAIT);
+			zassert_not_null(frag, "Cannot allocate fragment");
+
+			net_buf_add_mem(frag, payload + i,
+					MIN(net_buf_tailroom(frag), len - i));
+			net_pkt_frag_add(pkt, frag);
+		}
+	} else {
+		zassert_equal(net_pkt_write(pkt, payload, len), 0,
+			      "Cannot write data");
+	}
+
+	net_pkt_set_chksum_done(pkt, chksum_done);
+
+	zassert_equal(net_recv_data(gro_iface, pkt), 0, "Recv failed");
+}
+
+static void wait_received(int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		zassert_equal(k_sem_take(&wait_data, WAIT_TIME), 0, "Timeout");
+	}
+
+	/* Nothing else must be delivered. */
+	zassert_not_equal(k_sem_take(&wait_data, K_MSEC(50)), 0,
+			  "Too many packets");
+
+	zassert_false(test_failed, "Invalid packet");
+	zassert_equal(received_count, count, "Invalid number of packets (%d)",
+		      received_count);
+}
+
+static void check_received(int idx, uint32_t offset, size_t len,
+			   uint8_t flags)
+{
+	zassert_equal(received[idx].seq, TEST_SEQ + offset,
+		      "Invalid sequence number in packet %d", idx);
+	zassert_equal(received[idx].len, len,
+		      "Invalid length %zd in packet %d", received[idx].len,
+		      idx);
+	zassert_equal(received[idx].flags, flags,
+		      "Invalid flags 0x%02x in packet %d", received[idx].flags,
+		      idx);
+}
+
+static void reset(void)
+{
+	k_sem_reset(&wait_data);
+	received_count = 0;
+	test_failed = false;
+	chksum_done = false;
+	split_hdr = false;
+}
+
+static void coalesce(sa_family_t family, bool hw_chksum, bool split)
+{
+	int i;
+
+	reset();
+	chksum_done = hw_chksum;
+	split_hdr = split;
+
+	/* Queue the whole burst before the RX thread gets to run. */
+	k_sched_lock();
+
+	for (i = 0; i < 4; i++) {
+		inject_segment(family, i * TEST_MSS, TEST_MSS,
+			       i == 3 ? TCP_ACK | TCP_PSH : TCP_ACK);
+	}
+
+	k_sched_unlock();
+
+	wait_received(1);
+	check_received(0, 0, 4 * TEST_MSS, TCP_ACK | TCP_PSH);
+}
+
+static void test_coalesce_ipv4(void)
+{
+	coalesce(AF_INET, false, false);
+}
+
+static void test_coalesce_ipv6(void)
+{
+	coalesce(AF_INET6, false, false);
+}
+
+/* The IPv4 header checksum of the merged packet must be right even if
+ * the stack did not verify the segments.
+ */
+static void test_coalesce_chksum_done(void)
+{
+	coalesce(AF_INET, true, false);
+}
+
+/* The buffers holding only the headers of the merged segments are freed,
+ * their window and PSH flag must be taken before.
+ */
+static void test_coalesce_split_headers(void)
+{
+	coalesce(AF_INET, false, true);
+}
+
+static void test_flush_on_idle(void)
+{
+	reset();
+
+	k_sched_lock();
+
+	inject_segment(AF_INET, 0, TEST_MSS, TCP_ACK);
+	inject_segment(AF_INET, TEST_MSS, TEST_MSS, TCP_ACK);
+	inject_segment(AF_INET, 2 * TEST_MSS, TEST_MSS, TCP_ACK);
+
+	k_sched_unlock();
+
+	/* No PSH, the segments are passed up when the RX queue is empty. */
+	wait_received(1);
+	check_received(0, 0, 3 * TEST_MSS, TCP_ACK);
+}
+
+static void test_out_of_order(void)
+{
+	reset();
+
+	k_sched_lock();
+
+	inject_segment(AF_INET, 0, TEST_MSS, TCP_ACK);
+	inject_segment(AF_INET, 2 * TEST_MSS, TEST_MSS, TCP_ACK);
+	inject_segment(AF_INET, 3 * TEST_MSS, TEST_MSS, TCP_ACK);
+
+	k_sched_unlock();
+
+	wait_received(2);
+	check_received(0, 0, TEST_MSS, TCP_ACK);
+	check_received(1, 2 * TEST_MSS, 2 * TEST_MSS, TCP_ACK);
+}
+
+static void test_control_segment(void)
+{
+	reset();
+
+	k_sched_lock();
+
+	inject_segment(AF_INET, 0, TEST_MSS, TCP_ACK);
+	inject_segment(AF_INET, TEST_MSS, TEST_MSS, TCP_ACK);
+	inject_segment(AF_INET, 2 * TEST_MSS, 10, TCP_ACK | TCP_FIN);
+
+	k_sched_unlock();
+
+	/* FIN is not merged but it is passed up after the held data. */
+	wait_received(2);
+	check_received(0, 0, 2 * TEST_MSS, TCP_ACK);
+	check_received(1, 2 * TEST_MSS, 10, TCP_ACK | TCP_FIN);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_gro_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_coalesce_ipv4),
+			 ztest_unit_test(test_coalesce_ipv6),
+			 ztest_unit_test(test_coalesce_chksum_done),
+			 ztest_unit_test(test_coalesce_split_headers),
+			 ztest_unit_test(test_flush_on_idle),
+			 ztest_unit_test(test_out_of_order),
+			 ztest_unit_test(test_control_segment)
+			 );
+
+	ztest_run_test_suite(net_gro_test);
+}
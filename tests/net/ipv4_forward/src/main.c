@@ -0,0 +1,448 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define NET_LOG_LEVEL CONFIG_NET_IPV4_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, NET_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/printk.h>
+#include <random/rand32.h>
+
+#include <ztest.h>
+
+#include <net/ethernet.h>
+#include <net/dummy.h>
+#include <net/buf.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#define NET_LOG_ENABLED 1
+#include "net_private.h"
+#include "icmpv4.h"
+#include "ipv4.h"
+#include "udp_internal.h"
+
+#if NET_LOG_LEVEL >= LOG_LEVEL_DBG
+#define DBG(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#else
+#define DBG(fmt, ...)
+#endif
+
+#define TEST_PORT_HOST	4242
+#define TEST_PORT_PEER	4243
+#define TEST_ECHO_ID	0x1234
+#define TEST_TTL	64
+
+#define WAIT_TIME K_MSEC(250)
+
+/* The host is behind the LAN interface, the peer behind the WAN one */
+static struct in_addr in4addr_lan = { { { 192, 0, 2, 1 } } };
+static struct in_addr in4addr_host = { { { 192, 0, 2, 10 } } };
+static struct in_addr in4addr_wan = { { { 198, 51, 100, 1 } } };
+static struct in_addr in4addr_peer = { { { 198, 51, 100, 20 } } };
+static struct in_addr in4addr_mask = { { { 255, 255, 255, 0 } } };
+
+static const uint8_t payload[] = { 'f', 'o', 'r', 'w', 'a', 'r', 'd' };
+
+struct net_fwd_test {
+	uint8_t mac_addr[sizeof(struct net_eth_addr)];
+	struct net_pkt *sent;
+};
+
+static struct net_fwd_test net_fwd_data_lan;
+static struct net_fwd_test net_fwd_data_wan;
+
+static struct net_if *lan_iface;
+static struct net_if *wan_iface;
+
+static K_SEM_DEFINE(wait_data, 0, UINT_MAX);
+
+static uint16_t nat_port;
+
+static int net_fwd_dev_init(const struct device *dev)
+{
+	struct net_fwd_test *data = dev->data;
+
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	data->mac_addr[0] = 0x00;
+	data->mac_addr[1] = 0x00;
+	data->mac_addr[2] = 0x5E;
+	data->mac_addr[3] = 0x00;
+	data->mac_addr[4] = 0x53;
+	data->mac_addr[5] = sys_rand32_get();
+
+	return 0;
+}
+
+static void net_fwd_iface_init(struct net_if *iface)
+{
+	struct net_fwd_test *data = net_if_get_device(iface)->data;
+
+	net_if_set_link_addr(iface, data->mac_addr, sizeof(data->mac_addr),
+			     NET_LINK_ETHERNET);
+}
+
+static int tester_send(const struct device *dev, struct net_pkt *pkt)
+{
+	struct net_fwd_test *data = dev->data;
+
+	DBG("pkt %p sent by %s len %zu\n", pkt, dev->name,
+	    net_pkt_get_len(pkt));
+
+	if (data->sent) {
+		net_pkt_unref(data->sent);
+	}
+
+	data->sent = net_pkt_ref(pkt);
+
+	k_sem_give(&wait_data);
+
+	return 0;
+}
+
+static struct dummy_api net_fwd_if_api = {
+	.iface_api.init = net_fwd_iface_init,
+	.send = tester_send,
+};
+
+#define _ETH_L2_LAYER DUMMY_L2
+#define _ETH_L2_CTX_TYPE NET_L2_GET_CTX_TYPE(DUMMY_L2)
+
+NET_DEVICE_INIT_INSTANCE(net_fwd_test_lan, "net_fwd_test_lan", lan,
+			 net_fwd_dev_init, device_pm_control_nop,
+			 &net_fwd_data_lan, NULL,
+			 CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+			 &net_fwd_if_api, _ETH_L2_LAYER,
+			 _ETH_L2_CTX_TYPE, 1500);
+
+NET_DEVICE_INIT_INSTANCE(net_fwd_test_wan, "net_fwd_test_wan", wan,
+			 net_fwd_dev_init, device_pm_control_nop,
+			 &net_fwd_data_wan, NULL,
+			 CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+			 &net_fwd_if_api, _ETH_L2_LAYER,
+			 _ETH_L2_CTX_TYPE, 1500);
+
+static void iface_cb(struct net_if *iface, void *user_data)
+{
+	if (net_if_get_device(iface)->data == &net_fwd_data_lan) {
+		lan_iface = iface;
+	} else if (net_if_get_device(iface)->data == &net_fwd_data_wan) {
+		wan_iface = iface;
+	}
+}
+
+static void test_setup(void)
+{
+	net_if_foreach(iface_cb, NULL);
+
+	zassert_not_null(lan_iface, "LAN interface not found");
+	zassert_not_null(wan_iface, "WAN interface not found");
+
+	zassert_not_null(net_if_ipv4_addr_add(lan_iface, &in4addr_lan,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add LAN address");
+	zassert_not_null(net_if_ipv4_addr_add(wan_iface, &in4addr_wan,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add WAN address");
+
+	net_if_ipv4_set_netmask(lan_iface, &in4addr_mask);
+	net_if_ipv4_set_netmask(wan_iface, &in4addr_mask);
+}
+
+static void recv_pkt(struct net_pkt *pkt)
+{
+	zassert_not_null(pkt, "Cannot create pkt");
+
+	net_pkt_cursor_init(pkt);
+
+	zassert_equal(net_recv_data(net_pkt_iface(pkt), pkt), 0,
+		      "Cannot receive pkt");
+}
+
+static struct net_pkt *create_udp(struct net_if *iface,
+				  const struct in_addr *src,
+				  const struct in_addr *dst,
+				  uint16_t src_port, uint16_t dst_port,
+				  uint8_t ttl)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, sizeof(payload), AF_INET,
+					   IPPROTO_UDP, K_NO_WAIT);
+	if (!pkt) {
+		return NULL;
+	}
+
+	net_pkt_set_ipv4_ttl(pkt, ttl);
+
+	if (net_ipv4_create(pkt, src, dst) ||
+	    net_udp_create(pkt, htons(src_port), htons(dst_port)) ||
+	    net_pkt_write(pkt, payload, sizeof(payload))) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_ipv4_finalize(pkt, IPPROTO_UDP);
+
+	return pkt;
+}
+
+static struct net_pkt *create_echo(struct net_if *iface,
+				   const struct in_addr *src,
+				   const struct in_addr *dst,
+				   uint8_t type, uint16_t id)
+{
+	struct net_icmpv4_echo_req echo = {
+		.identifier = htons(id),
+		.sequence = htons(1),
+	};
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, sizeof(struct net_icmp_hdr) +
+					   sizeof(echo), AF_INET, IPPROTO_ICMP,
+					   K_NO_WAIT);
+	if (!pkt) {
+		return NULL;
+	}
+
+	net_pkt_set_ipv4_ttl(pkt, TEST_TTL);
+
+	if (net_ipv4_create(pkt, src, dst) ||
+	    net_pkt_write_u8(pkt, type) ||
+	    net_pkt_write_u8(pkt, 0) ||
+	    net_pkt_write_be16(pkt, 0) ||
+	    net_pkt_write(pkt, &echo, sizeof(echo))) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_ipv4_finalize(pkt, IPPROTO_ICMP);
+
+	return pkt;
+}
+
+/* Wait for the pkt sent by an interface and check its IPv4 header. */
+static struct net_pkt *wait_sent(struct net_fwd_test *data,
+				 const struct in_addr *src,
+				 const struct in_addr *dst)
+{
+	struct net_ipv4_hdr *hdr;
+	struct net_pkt *pkt;
+
+	zassert_equal(k_sem_take(&wait_data, WAIT_TIME), 0,
+		      "Timeout while waiting pkt");
+
+	pkt = data->sent;
+	data->sent = NULL;
+
+	zassert_not_null(pkt, "Pkt sent by the wrong interface");
+
+	hdr = NET_IPV4_HDR(pkt);
+
+	zassert_true(net_ipv4_addr_cmp(&hdr->src, src), "Invalid src %s",
+		     net_sprint_ipv4_addr(&hdr->src));
+	zassert_true(net_ipv4_addr_cmp(&hdr->dst, dst), "Invalid dst %s",
+		     net_sprint_ipv4_addr(&hdr->dst));
+	zassert_equal(net_calc_chksum_ipv4(pkt), 0, "Invalid IPv4 checksum");
+
+	return pkt;
+}
+
+static struct net_udp_hdr *get_udp_hdr(struct net_pkt *pkt)
+{
+	return (struct net_udp_hdr *)(pkt->buffer->data +
+				      net_pkt_ip_hdr_len(pkt) +
+				      net_pkt_ipv4_opts_len(pkt));
+}
+
+static struct net_icmpv4_echo_req *get_echo_hdr(struct net_pkt *pkt)
+{
+	return (struct net_icmpv4_echo_req *)((uint8_t *)get_udp_hdr(pkt) +
+					      sizeof(struct net_icmp_hdr));
+}
+
+static void test_forward(void)
+{
+	struct net_udp_hdr *udp_hdr;
+	struct net_pkt *pkt;
+
+	recv_pkt(create_udp(lan_iface, &in4addr_host, &in4addr_peer,
+			    TEST_PORT_HOST, TEST_PORT_PEER, TEST_TTL));
+
+	pkt = wait_sent(&net_fwd_data_wan, &in4addr_host, &in4addr_peer);
+
+	udp_hdr = get_udp_hdr(pkt);
+
+	zassert_equal(NET_IPV4_HDR(pkt)->ttl, TEST_TTL - 1, "TTL not updated");
+	zassert_equal(ntohs(udp_hdr->src_port), TEST_PORT_HOST,
+		      "Source port changed");
+	zassert_equal(net_calc_verify_chksum_udp(pkt), 0,
+		      "Invalid UDP checksum");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_forward_ttl_expired(void)
+{
+	struct net_pkt *pkt;
+
+	recv_pkt(create_udp(lan_iface, &in4addr_host, &in4addr_peer,
+			    TEST_PORT_HOST, TEST_PORT_PEER, 1));
+
+	/* Time exceeded error sent back to the host */
+	pkt = wait_sent(&net_fwd_data_lan, &in4addr_lan, &in4addr_host);
+
+	zassert_equal(NET_IPV4_HDR(pkt)->proto, IPPROTO_ICMP,
+		      "Not an ICMP error");
+	zassert_equal(((struct net_icmp_hdr *)get_udp_hdr(pkt))->type,
+		      NET_ICMPV4_TIME_EXCEEDED, "Not a time exceeded error");
+	zassert_is_null(net_fwd_data_wan.sent, "Pkt forwarded");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_masquerade(void)
+{
+	struct net_udp_hdr *udp_hdr;
+	struct net_pkt *pkt;
+
+	net_if_flag_set(wan_iface, NET_IF_IPV4_MASQUERADE);
+
+	recv_pkt(create_udp(lan_iface, &in4addr_host, &in4addr_peer,
+			    TEST_PORT_HOST, TEST_PORT_PEER, TEST_TTL));
+
+	pkt = wait_sent(&net_fwd_data_wan, &in4addr_wan, &in4addr_peer);
+
+	udp_hdr = get_udp_hdr(pkt);
+	nat_port = ntohs(udp_hdr->src_port);
+
+	zassert_true(nat_port >= CONFIG_NET_IPV4_NAT_PORT_MIN &&
+		     nat_port <= CONFIG_NET_IPV4_NAT_PORT_MAX,
+		     "Invalid translated port %u", nat_port);
+	zassert_equal(ntohs(udp_hdr->dst_port), TEST_PORT_PEER,
+		      "Destination port changed");
+	zassert_equal(net_calc_verify_chksum_udp(pkt), 0,
+		      "Invalid UDP checksum");
+
+	net_pkt_unref(pkt);
+
+	/* The next pkt of the connection uses the same port */
+	recv_pkt(create_udp(lan_iface, &in4addr_host, &in4addr_peer,
+			    TEST_PORT_HOST, TEST_PORT_PEER, TEST_TTL));
+
+	pkt = wait_sent(&net_fwd_data_wan, &in4addr_wan, &in4addr_peer);
+
+	zassert_equal(ntohs(get_udp_hdr(pkt)->src_port), nat_port,
+		      "Connection not tracked");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_masquerade_reply(void)
+{
+	struct net_udp_hdr *udp_hdr;
+	struct net_pkt *pkt;
+
+	recv_pkt(create_udp(wan_iface, &in4addr_peer, &in4addr_wan,
+			    TEST_PORT_PEER, nat_port, TEST_TTL));
+
+	pkt = wait_sent(&net_fwd_data_lan, &in4addr_peer, &in4addr_host);
+
+	udp_hdr = get_udp_hdr(pkt);
+
+	zassert_equal(ntohs(udp_hdr->src_port), TEST_PORT_PEER,
+		      "Source port changed");
+	zassert_equal(ntohs(udp_hdr->dst_port), TEST_PORT_HOST,
+		      "Destination port not translated back");
+	zassert_equal(net_calc_verify_chksum_udp(pkt), 0,
+		      "Invalid UDP checksum");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_masquerade_echo(void)
+{
+	struct net_icmpv4_echo_req *echo;
+	struct net_pkt *pkt;
+	uint16_t id;
+
+	recv_pkt(create_echo(lan_iface, &in4addr_host, &in4addr_peer,
+			     NET_ICMPV4_ECHO_REQUEST, TEST_ECHO_ID));
+
+	pkt = wait_sent(&net_fwd_data_wan, &in4addr_wan, &in4addr_peer);
+
+	echo = get_echo_hdr(pkt);
+	id = ntohs(echo->identifier);
+
+	zassert_not_equal(id, TEST_ECHO_ID, "Identifier not translated");
+	zassert_equal(net_calc_chksum_icmpv4(pkt), 0,
+		      "Invalid ICMP checksum");
+
+	net_pkt_unref(pkt);
+
+	recv_pkt(create_echo(wan_iface, &in4addr_peer, &in4addr_wan,
+			     NET_ICMPV4_ECHO_REPLY, id));
+
+	pkt = wait_sent(&net_fwd_data_lan, &in4addr_peer, &in4addr_host);
+
+	echo = get_echo_hdr(pkt);
+
+	zassert_equal(ntohs(echo->identifier), TEST_ECHO_ID,
+		      "Identifier not translated back");
+	zassert_equal(net_calc_chksum_icmpv4(pkt), 0,
+		      "Invalid ICMP checksum");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_masquerade_table_full(void)
+{
+	struct net_pkt *pkt;
+	int i;
+
+	/* Two connections are already tracked */
+	for (i = 2; i < CONFIG_NET_IPV4_NAT_MAX_CONNECTIONS; i++) {
+		recv_pkt(create_udp(lan_iface, &in4addr_host, &in4addr_peer,
+				    TEST_PORT_HOST + i, TEST_PORT_PEER,
+				    TEST_TTL));
+
+		pkt = wait_sent(&net_fwd_data_wan, &in4addr_wan,
+				&in4addr_peer);
+		net_pkt_unref(pkt);
+	}
+
+	recv_pkt(create_udp(lan_iface, &in4addr_host, &in4addr_peer,
+			    TEST_PORT_HOST + i, TEST_PORT_PEER, TEST_TTL));
+
+	zassert_not_equal(k_sem_take(&wait_data, WAIT_TIME), 0,
+			  "Pkt forwarded with a full table");
+
+	net_if_flag_clear(wan_iface, NET_IF_IPV4_MASQUERADE);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_ipv4_forward_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_forward),
+			 ztest_unit_test(test_forward_ttl_expired),
+			 ztest_unit_test(test_masquerade),
+			 ztest_unit_test(test_masquerade_reply),
+			 ztest_unit_test(test_masquerade_echo),
+			 ztest_unit_test(test_masquerade_table_full));
+
+	ztest_run_test_suite(net_ipv4_forward_test);
+}
@@ -502,6 +502,76 @@ static void test_nbr_lookup_ok(void)
 			 net_sprint_ipv6_addr(&peer_addr));
 }
 
+static void nbr_lookup_cb(struct net_nbr *nbr, void *user_data)
+{
+	struct in6_addr *addr = &net_ipv6_nbr_data(nbr)->addr;
+	struct in6_addr *removed = user_data;
+
+	zassert_false(net_ipv6_addr_cmp(addr, removed),
+		      "Removed neighbor %s still in cache\n",
+		      net_sprint_ipv6_addr(addr));
+
+	zassert_equal_ptr(net_ipv6_nbr_lookup(nbr->iface, addr), nbr,
+			  "Neighbor %s not found in cache\n",
+			  net_sprint_ipv6_addr(addr));
+	zassert_equal_ptr(net_ipv6_nbr_lookup(NULL, addr), nbr,
+			  "Neighbor %s not found in any cache\n",
+			  net_sprint_ipv6_addr(addr));
+}
+
+static void nbr_find_cb(struct net_nbr *nbr, void *user_data)
+{
+	struct in6_addr *addr = user_data;
+
+	if (!net_ipv6_addr_cmp(&net_ipv6_nbr_data(nbr)->addr, &peer_addr)) {
+		net_ipaddr_copy(addr, &net_ipv6_nbr_data(nbr)->addr);
+	}
+}
+
+/**
+ * @brief IPv6 neighbor lookup of every cached neighbor
+ */
+static void test_nbr_lookup_all(void)
+{
+	struct in6_addr removed = IN6ADDR_ANY_INIT;
+	struct net_linkaddr_storage llstorage;
+	struct net_linkaddr lladdr;
+	struct net_nbr *nbr;
+
+	net_ipv6_nbr_foreach(nbr_lookup_cb, &removed);
+
+	net_ipv6_nbr_foreach(nbr_find_cb, &removed);
+	zassert_false(net_ipv6_is_addr_unspecified(&removed),
+		      "No neighbor to remove");
+
+	nbr = net_ipv6_nbr_lookup(net_if_get_default(), &removed);
+	zassert_not_null(nbr, "Neighbor %s not found in cache\n",
+			 net_sprint_ipv6_addr(&removed));
+
+	memcpy(&llstorage, net_nbr_get_lladdr(nbr->idx), sizeof(llstorage));
+
+	zassert_true(net_ipv6_nbr_rm(net_if_get_default(), &removed),
+		     "Cannot remove neighbor %s\n",
+		     net_sprint_ipv6_addr(&removed));
+	zassert_is_null(net_ipv6_nbr_lookup(NULL, &removed),
+			"Neighbor %s found in cache\n",
+			net_sprint_ipv6_addr(&removed));
+
+	net_ipv6_nbr_foreach(nbr_lookup_cb, &removed);
+
+	lladdr.len = llstorage.len;
+	lladdr.addr = llstorage.addr;
+	lladdr.type = NET_LINK_ETHERNET;
+
+	nbr = net_ipv6_nbr_add(net_if_get_default(), &removed, &lladdr,
+			       false, NET_IPV6_NBR_STATE_STALE);
+	zassert_not_null(nbr, "Cannot add peer %s to neighbor cache\n",
+			 net_sprint_ipv6_addr(&removed));
+	zassert_equal_ptr(net_ipv6_nbr_lookup(NULL, &removed), nbr,
+			  "Neighbor %s not found in cache\n",
+			  net_sprint_ipv6_addr(&removed));
+}
+
 /**
  * @brief IPv6 send NS extra options
  */
@@ -1502,6 +1572,7 @@ void test_main(void)
 			 ztest_unit_test(test_add_neighbor),
 			 ztest_unit_test(test_add_max_neighbors),
 			 ztest_unit_test(test_nbr_lookup_ok),
+			 ztest_unit_test(test_nbr_lookup_all),
 			 ztest_unit_test(test_send_ns_extra_options),
 			 ztest_unit_test(test_send_ns_no_options),
 			 ztest_unit_test(test_rs_message),
@@ -2043,6 +2043,145 @@ static void test_recv_ipv6_fragment(void)
 	zassert_true(ret == NET_OK, "IPv6 frag2 reassembly failed");
 }
 
+static int recv_fragment(const uint8_t *hdrs, size_t hdrs_len,
+			 uint16_t offset, uint16_t payload_len)
+{
+	struct net_ipv6_hdr ipv6_hdr;
+	struct net_pkt_cursor backup;
+	struct net_ipv6_frag_hdr *frag_hdr;
+	struct net_pkt *pkt;
+	uint8_t buf[sizeof(ipv6_reass_frag1)];
+	int ret;
+
+	memcpy(buf, hdrs, hdrs_len);
+
+	frag_hdr = (struct net_ipv6_frag_hdr *)(buf +
+						sizeof(struct net_ipv6_hdr));
+	frag_hdr->offset = htons(offset | (ntohs(frag_hdr->offset) & 0x07));
+
+	pkt = net_pkt_alloc_with_buffer(iface1, hdrs_len + payload_len,
+					AF_UNSPEC, 0, ALLOC_TIMEOUT);
+	zassert_not_null(pkt, "packet");
+
+	net_pkt_set_family(pkt, AF_INET6);
+	net_pkt_set_ip_hdr_len(pkt, sizeof(struct net_ipv6_hdr));
+	net_pkt_cursor_init(pkt);
+
+	memcpy(&ipv6_hdr, buf, sizeof(struct net_ipv6_hdr));
+
+	ret = net_pkt_write(pkt, buf, sizeof(struct net_ipv6_hdr) + 1);
+	zassert_true(ret == 0, "IPv6 header append failed");
+
+	net_pkt_cursor_backup(pkt, &backup);
+
+	ret = net_pkt_write(pkt, buf + sizeof(struct net_ipv6_hdr) + 1,
+			    hdrs_len - sizeof(struct net_ipv6_hdr) - 1);
+	zassert_true(ret == 0, "IPv6 fragment header append failed");
+
+	ret = net_pkt_memset(pkt, offset, payload_len);
+	zassert_true(ret == 0, "IPv6 payload append failed");
+
+	net_pkt_set_ipv6_fragment_start(pkt, sizeof(struct net_ipv6_hdr));
+	net_pkt_set_overwrite(pkt, true);
+
+	net_pkt_cursor_restore(pkt, &backup);
+
+	ret = net_ipv6_handle_fragment_hdr(pkt, &ipv6_hdr,
+					   NET_IPV6_NEXTHDR_FRAG);
+	if (ret == NET_DROP) {
+		net_pkt_unref(pkt);
+	}
+
+	return ret;
+}
+
+static void count_reassembly_cb(struct net_ipv6_reassembly *reass,
+				void *user_data)
+{
+	int *count = user_data;
+
+	(*count)++;
+}
+
+static int count_reassemblies(void)
+{
+	int count = 0;
+
+	net_ipv6_frag_foreach(count_reassembly_cb, &count);
+
+	return count;
+}
+
+/* Length of the data of the fragments sent by the tests below, the first
+ * one holding the ICMPv6 header.
+ */
+#define FRAG1_DATA_LEN	1232
+#define FRAG2_DATA_LEN	76
+
+static void test_recv_ipv6_fragment_reverse(void)
+{
+	int ret;
+
+	zassert_equal(count_reassemblies(), 0, "Pending reassembly");
+
+	ret = recv_fragment(ipv6_reass_frag2, sizeof(ipv6_reass_frag2),
+			    FRAG1_DATA_LEN, FRAG2_DATA_LEN);
+	zassert_equal(ret, NET_OK, "IPv6 last fragment not accepted");
+	zassert_equal(count_reassemblies(), 1, "Reassembly not pending");
+
+	ret = recv_fragment(ipv6_reass_frag1, sizeof(ipv6_reass_frag1), 0,
+			    FRAG1_DATA_LEN - 8);
+	zassert_equal(ret, NET_OK, "IPv6 first fragment not accepted");
+	zassert_equal(count_reassemblies(), 0, "Reassembly not completed");
+}
+
+static void test_recv_ipv6_fragment_duplicate(void)
+{
+	int ret;
+
+	ret = recv_fragment(ipv6_reass_frag1, sizeof(ipv6_reass_frag1), 0,
+			    FRAG1_DATA_LEN - 8);
+	zassert_equal(ret, NET_OK, "IPv6 first fragment not accepted");
+
+	ret = recv_fragment(ipv6_reass_frag1, sizeof(ipv6_reass_frag1), 0,
+			    FRAG1_DATA_LEN - 8);
+	zassert_equal(ret, NET_DROP, "IPv6 duplicate fragment accepted");
+	zassert_equal(count_reassemblies(), 1, "Reassembly discarded");
+
+	ret = recv_fragment(ipv6_reass_frag2, sizeof(ipv6_reass_frag2),
+			    FRAG1_DATA_LEN, FRAG2_DATA_LEN);
+	zassert_equal(ret, NET_OK, "IPv6 last fragment not accepted");
+	zassert_equal(count_reassemblies(), 0, "Reassembly not completed");
+}
+
+static void test_recv_ipv6_fragment_overlap(void)
+{
+	int ret;
+
+	ret = recv_fragment(ipv6_reass_frag1, sizeof(ipv6_reass_frag1), 0,
+			    FRAG1_DATA_LEN - 8);
+	zassert_equal(ret, NET_OK, "IPv6 first fragment not accepted");
+
+	/* Overlaps the last 8 bytes of the first fragment, which makes
+	 * the whole packet invalid.
+	 */
+	ret = recv_fragment(ipv6_reass_frag2, sizeof(ipv6_reass_frag2),
+			    FRAG1_DATA_LEN - 8, FRAG2_DATA_LEN + 8);
+	zassert_equal(ret, NET_DROP, "IPv6 overlapping fragment accepted");
+	zassert_equal(count_reassemblies(), 0, "Reassembly not discarded");
+
+	/* The remaining fragment starts a new reassembly */
+	ret = recv_fragment(ipv6_reass_frag2, sizeof(ipv6_reass_frag2),
+			    FRAG1_DATA_LEN, FRAG2_DATA_LEN);
+	zassert_equal(ret, NET_OK, "IPv6 last fragment not accepted");
+	zassert_equal(count_reassemblies(), 1, "Reassembly not pending");
+
+	ret = recv_fragment(ipv6_reass_frag1, sizeof(ipv6_reass_frag1), 0,
+			    FRAG1_DATA_LEN - 8);
+	zassert_equal(ret, NET_OK, "IPv6 first fragment not accepted");
+	zassert_equal(count_reassemblies(), 0, "Reassembly not completed");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(net_ipv6_fragment_test,
@@ -2059,7 +2198,10 @@ void test_main(void)
 			 ztest_unit_test(test_send_ipv6_fragment),
 			 ztest_unit_test(test_send_ipv6_fragment_large_hbho),
 			 ztest_unit_test(test_send_ipv6_fragment_without_hbho),
-			 ztest_unit_test(test_recv_ipv6_fragment)
+			 ztest_unit_test(test_recv_ipv6_fragment),
+			 ztest_unit_test(test_recv_ipv6_fragment_reverse),
+			 ztest_unit_test(test_recv_ipv6_fragment_duplicate),
+			 ztest_unit_test(test_recv_ipv6_fragment_overlap)
 			 );
 
 	ztest_run_test_suite(net_ipv6_fragment_test);
@@ -1303,6 +1303,20 @@ static int test_observer_server(void)
 		goto done;
 	}
 
+	if (coap_find_observer(&server_resources[0],
+			       (struct sockaddr *)&dummy_addr,
+			       (const uint8_t *)"token", 5) != &observers[0]) {
+		TC_PRINT("The observer should be found\n");
+		goto done;
+	}
+
+	if (coap_find_observer(&server_resources[0],
+			       (struct sockaddr *)&dummy_addr,
+			       (const uint8_t *)"tok", 3)) {
+		TC_PRINT("No observer should match another token\n");
+		goto done;
+	}
+
 	/* Suppose some time passes */
 	r = coap_resource_notify(&server_resources[0]);
 	if (r) {
@@ -1454,6 +1468,326 @@ done:
 	return result;
 }
 
+static struct coap_resource *index_hit;
+
+static int index_resource_get(struct coap_resource *resource,
+			      struct coap_packet *request,
+			      struct sockaddr *addr, socklen_t addr_len)
+{
+	index_hit = resource;
+
+	return 0;
+}
+
+static const char * const index_path_a[] = { "a", NULL };
+static const char * const index_path_ab[] = { "a", "b", NULL };
+static const char * const index_path_w[] = { "w", "+", NULL };
+static const char * const index_path_wx[] = { "w", "x", NULL };
+static const char * const index_path_p[] = { "p", NULL };
+static struct coap_resource index_resources[] = {
+	{ .path = index_path_a, .get = index_resource_get },
+	{ .path = index_path_ab, .get = index_resource_get },
+	{ .path = index_path_w, .get = index_resource_get },
+	{ .path = index_path_wx, .get = index_resource_get },
+	{ .path = index_path_p, .post = index_resource_get },
+	{ },
+};
+
+static int index_request(const struct coap_resource_index *index,
+			 const char * const *path)
+{
+	struct coap_option options[4] = {};
+	struct coap_packet req;
+	uint8_t data[COAP_BUF_SIZE];
+	struct coap_resource *hit;
+	int r, linear_r;
+
+	r = coap_packet_init(&req, data, sizeof(data), 1, COAP_TYPE_CON,
+			     0, NULL, COAP_METHOD_GET, coap_next_id());
+	if (r < 0) {
+		return r;
+	}
+
+	for (; *path; path++) {
+		r = coap_packet_append_option(&req, COAP_OPTION_URI_PATH,
+					      (const uint8_t *)*path,
+					      strlen(*path));
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	r = coap_packet_parse(&req, data, req.offset, options,
+			      ARRAY_SIZE(options));
+	if (r < 0) {
+		return r;
+	}
+
+	/* The index must find the resource found by a linear lookup */
+	index_hit = NULL;
+	linear_r = coap_handle_request(&req, index_resources, options,
+				       ARRAY_SIZE(options),
+				       (struct sockaddr *)&dummy_addr,
+				       sizeof(dummy_addr));
+	hit = index_hit;
+
+	index_hit = NULL;
+	r = coap_handle_request_index(&req, index, options,
+				      ARRAY_SIZE(options),
+				      (struct sockaddr *)&dummy_addr,
+				      sizeof(dummy_addr));
+	if (r != linear_r || index_hit != hit) {
+		TC_PRINT("Index and linear lookups differ\n");
+		return -EFAULT;
+	}
+
+	return r;
+}
+
+static int test_resource_index(void)
+{
+	const char * const path_wy[] = { "w", "y", NULL };
+	const char * const path_z[] = { "z", NULL };
+	const char * const path_abc[] = { "a", "b", "c", NULL };
+	struct coap_resource *buckets[4];
+	struct coap_resource_index index;
+	int result = TC_FAIL;
+	int r;
+
+	r = coap_resource_index_init(&index, index_resources, buckets, 3);
+	if (r != -EINVAL) {
+		TC_PRINT("The bucket count should be a power of two\n");
+		goto done;
+	}
+
+	r = coap_resource_index_init(&index, index_resources, buckets,
+				     ARRAY_SIZE(buckets));
+	if (r < 0) {
+		TC_PRINT("Could not build the index\n");
+		goto done;
+	}
+
+	if (index_request(&index, index_path_a) != 0 ||
+	    index_hit != &index_resources[0]) {
+		TC_PRINT("/a should be found\n");
+		goto done;
+	}
+
+	if (index_request(&index, index_path_ab) != 0 ||
+	    index_hit != &index_resources[1]) {
+		TC_PRINT("/a/b should be found\n");
+		goto done;
+	}
+
+	/* The wildcard resource comes first */
+	if (index_request(&index, index_path_wx) != 0 ||
+	    index_hit != &index_resources[2]) {
+		TC_PRINT("/w/x should match the wildcard\n");
+		goto done;
+	}
+
+	if (index_request(&index, path_wy) != 0 ||
+	    index_hit != &index_resources[2]) {
+		TC_PRINT("/w/y should match the wildcard\n");
+		goto done;
+	}
+
+	if (index_request(&index, index_path_p) != -EPERM) {
+		TC_PRINT("/p has no GET method\n");
+		goto done;
+	}
+
+	if (index_request(&index, path_z) != -ENOENT ||
+	    index_request(&index, path_abc) != -ENOENT) {
+		TC_PRINT("Unknown resources should not be found\n");
+		goto done;
+	}
+
+	result = TC_PASS;
+
+done:
+	TC_END_RESULT(result);
+
+	return result;
+}
+
+/* Builds a packet and parses it again, as the peer would */
+static int block_packet_init(struct coap_packet *cpkt, uint8_t *data,
+			     uint8_t type, uint8_t code)
+{
+	return coap_packet_init(cpkt, data, COAP_BUF_SIZE, 1, type, 0, NULL,
+				code, coap_next_id());
+}
+
+static int block_packet_parse(struct coap_packet *cpkt, uint8_t *data)
+{
+	return coap_packet_parse(cpkt, data, cpkt->offset, NULL, 0);
+}
+
+#define BLOCK_BODY_SIZE 100
+
+static int test_block_transfer_block1(void)
+{
+	uint8_t req_data[COAP_BUF_SIZE];
+	uint8_t rsp_data[COAP_BUF_SIZE];
+	uint8_t tx_body[BLOCK_BODY_SIZE];
+	uint8_t rx_body[BLOCK_BODY_SIZE];
+	struct coap_block_transfer tx;
+	struct coap_block_transfer rx;
+	struct coap_packet req;
+	struct coap_packet rsp;
+	int result = TC_FAIL;
+	int blocks = 0;
+	int last, r;
+	size_t i;
+
+	for (i = 0; i < sizeof(tx_body); i++) {
+		tx_body[i] = i;
+	}
+
+	/* The server asks for smaller blocks after the first one */
+	coap_block_transfer_setup(&tx, COAP_BLOCK_32, tx_body,
+				  sizeof(tx_body), sizeof(tx_body));
+	coap_block_transfer_setup(&rx, COAP_BLOCK_16, rx_body,
+				  sizeof(rx_body), 0);
+
+	do {
+		r = block_packet_init(&req, req_data, COAP_TYPE_CON,
+				      COAP_METHOD_POST);
+		if (r < 0) {
+			TC_PRINT("Unable to initialize request\n");
+			goto done;
+		}
+
+		last = coap_block_transfer_send(&tx, &req,
+						blocks ? &rsp : NULL);
+		if (last < 0 || block_packet_parse(&req, req_data) < 0) {
+			TC_PRINT("Unable to send block %d\n", blocks);
+			goto done;
+		}
+
+		r = coap_block_transfer_recv(&rx, &req);
+		if (r != last) {
+			TC_PRINT("Unexpected block %d (%d)\n", blocks, r);
+			goto done;
+		}
+
+		if (blocks == 0 && rx.ctx.total_size != sizeof(tx_body)) {
+			TC_PRINT("Size1 should be given with the first block\n");
+			goto done;
+		}
+
+		r = block_packet_init(&rsp, rsp_data, COAP_TYPE_ACK,
+				      last ? COAP_RESPONSE_CODE_CHANGED :
+				      COAP_RESPONSE_CODE_CONTINUE);
+		r = r < 0 ? r : coap_append_block1_option(&rsp, &rx.ctx);
+		if (r < 0 || block_packet_parse(&rsp, rsp_data) < 0) {
+			TC_PRINT("Unable to build response\n");
+			goto done;
+		}
+
+		blocks++;
+	} while (!last);
+
+	/* One block of 32 bytes, then 68 bytes in blocks of 16 */
+	if (blocks != 6) {
+		TC_PRINT("Body sent in %d blocks\n", blocks);
+		goto done;
+	}
+
+	if (rx.len != sizeof(tx_body) ||
+	    memcmp(rx_body, tx_body, sizeof(tx_body))) {
+		TC_PRINT("The body received differs\n");
+		goto done;
+	}
+
+	result = TC_PASS;
+
+done:
+	TC_END_RESULT(result);
+
+	return result;
+}
+
+static int test_block_transfer_block2(void)
+{
+	uint8_t req_data[COAP_BUF_SIZE];
+	uint8_t rsp_data[COAP_BUF_SIZE];
+	uint8_t tx_body[BLOCK_BODY_SIZE];
+	uint8_t rx_body[BLOCK_BODY_SIZE];
+	struct coap_block_transfer tx;
+	struct coap_block_transfer rx;
+	struct coap_packet req;
+	struct coap_packet rsp;
+	int result = TC_FAIL;
+	int blocks = 0;
+	int last, r;
+	size_t i;
+
+	for (i = 0; i < sizeof(tx_body); i++) {
+		tx_body[i] = ~i;
+	}
+
+	/* The client asks for smaller blocks after the first one */
+	coap_block_transfer_setup(&tx, COAP_BLOCK_64, tx_body,
+				  sizeof(tx_body), sizeof(tx_body));
+	coap_block_transfer_setup(&rx, COAP_BLOCK_32, rx_body,
+				  sizeof(rx_body), 0);
+
+	do {
+		r = block_packet_init(&req, req_data, COAP_TYPE_CON,
+				      COAP_METHOD_GET);
+		if (r >= 0 && blocks) {
+			r = coap_append_block2_option(&req, &rx.ctx);
+		}
+
+		if (r < 0 || block_packet_parse(&req, req_data) < 0) {
+			TC_PRINT("Unable to build request\n");
+			goto done;
+		}
+
+		r = block_packet_init(&rsp, rsp_data, COAP_TYPE_ACK,
+				      COAP_RESPONSE_CODE_CONTENT);
+		last = r < 0 ? r : coap_block_transfer_send(&tx, &rsp, &req);
+		if (last < 0 || block_packet_parse(&rsp, rsp_data) < 0) {
+			TC_PRINT("Unable to send block %d\n", blocks);
+			goto done;
+		}
+
+		r = coap_block_transfer_recv(&rx, &rsp);
+		if (r != last) {
+			TC_PRINT("Unexpected block %d (%d)\n", blocks, r);
+			goto done;
+		}
+
+		if (blocks == 1 && coap_block_transfer_recv(&rx, &rsp) != -EINVAL) {
+			TC_PRINT("A block received twice should fail\n");
+			goto done;
+		}
+
+		blocks++;
+	} while (!last);
+
+	/* One block of 64 bytes, then 36 bytes in blocks of 32 */
+	if (blocks != 3) {
+		TC_PRINT("Body sent in %d blocks\n", blocks);
+		goto done;
+	}
+
+	if (rx.len != sizeof(tx_body) ||
+	    memcmp(rx_body, tx_body, sizeof(tx_body))) {
+		TC_PRINT("The body received differs\n");
+		goto done;
+	}
+
+	result = TC_PASS;
+
+done:
+	TC_END_RESULT(result);
+
+	return result;
+}
+
 static const struct {
 	const char *name;
 	int (*func)(void);
@@ -1476,6 +1810,9 @@ static const struct {
 	{ "Test retransmission", test_retransmit_second_round, },
 	{ "Test observer server", test_observer_server, },
 	{ "Test observer client", test_observer_client, },
+	{ "Test resource index", test_resource_index, },
+	{ "Test block transfer Block1", test_block_transfer_block1, },
+	{ "Test block transfer Block2", test_block_transfer_block2, },
 };
 
 void main(void)
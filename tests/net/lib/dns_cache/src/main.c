@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_DNS_RESOLVER_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/printk.h>
+
+#include <ztest.h>
+
+#include <net/ethernet.h>
+#include <net/dummy.h>
+#include <net/buf.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/dns_resolve.h>
+
+#define NET_LOG_ENABLED 1
+#include "net_private.h"
+#include "ipv4.h"
+#include "udp_internal.h"
+
+#if defined(CONFIG_DNS_RESOLVER_LOG_LEVEL_DBG)
+#define DBG(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#else
+#define DBG(fmt, ...)
+#endif
+
+#define DNS_PORT 53
+#define DNS_TIMEOUT 500 /* ms */
+
+/* this must be higher that the DNS_TIMEOUT */
+#define WAIT_TIME K_MSEC(DNS_TIMEOUT + 300)
+
+#define RCODE_NOERROR 0
+#define RCODE_NXDOMAIN 3
+
+static struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static struct in_addr server_addr = { { { 192, 0, 2, 2 } } };
+
+/* The local DNS server stand-in keeps the last query sent to it, the
+ * tests decide when and how it is answered.
+ */
+static struct {
+	uint8_t data[128];
+	size_t len;
+	uint16_t port;
+	int count;
+} query;
+
+static K_SEM_DEFINE(wait_query, 0, UINT_MAX);
+
+static struct net_if *iface;
+
+struct result {
+	struct k_sem done;
+	int status;
+	int count;
+	struct in_addr addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS];
+};
+
+struct net_dns_cache_test {
+	uint8_t mac_addr[sizeof(struct net_eth_addr)];
+};
+
+static struct net_dns_cache_test net_dns_cache_data;
+
+static int net_dns_cache_dev_init(const struct device *dev)
+{
+	struct net_dns_cache_test *data = dev->data;
+
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	data->mac_addr[0] = 0x00;
+	data->mac_addr[1] = 0x00;
+	data->mac_addr[2] = 0x5E;
+	data->mac_addr[3] = 0x00;
+	data->mac_addr[4] = 0x53;
+	data->mac_addr[5] = 0x01;
+
+	return 0;
+}
+
+static void net_dns_cache_iface_init(struct net_if *iface)
+{
+	struct net_dns_cache_test *data = net_if_get_device(iface)->data;
+
+	net_if_set_link_addr(iface, data->mac_addr, sizeof(data->mac_addr),
+			     NET_LINK_ETHERNET);
+}
+
+static int tester_send(const struct device *dev, struct net_pkt *pkt)
+{
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+
+	if (net_pkt_skip(pkt, NET_IPV4H_LEN) ||
+	    net_pkt_read_be16(pkt, &query.port) ||
+	    net_pkt_skip(pkt, sizeof(struct net_udp_hdr) - sizeof(uint16_t))) {
+		return -EINVAL;
+	}
+
+	query.len = net_pkt_remaining_data(pkt);
+	if (query.len > sizeof(query.data) ||
+	    net_pkt_read(pkt, query.data, query.len)) {
+		return -EINVAL;
+	}
+
+	query.count++;
+
+	DBG("DNS query %d from port %u len %zu\n", query.count, query.port,
+	    query.len);
+
+	k_sem_give(&wait_query);
+
+	return 0;
+}
+
+static struct dummy_api net_dns_cache_if_api = {
+	.iface_api.init = net_dns_cache_iface_init,
+	.send = tester_send,
+};
+
+#define _ETH_L2_LAYER DUMMY_L2
+#define _ETH_L2_CTX_TYPE NET_L2_GET_CTX_TYPE(DUMMY_L2)
+
+NET_DEVICE_INIT(net_dns_cache_test, "net_dns_cache_test",
+		net_dns_cache_dev_init, device_pm_control_nop,
+		&net_dns_cache_data, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_dns_cache_if_api, _ETH_L2_LAYER,
+		_ETH_L2_CTX_TYPE, 127);
+
+static void put_be16(uint8_t *buf, size_t *pos, uint16_t val)
+{
+	buf[(*pos)++] = val >> 8;
+	buf[(*pos)++] = val;
+}
+
+static void put_rr(uint8_t *buf, size_t *pos, uint16_t type, uint32_t ttl,
+		   const uint8_t *rdata, uint16_t rdlength)
+{
+	/* The owner is the name of the question */
+	put_be16(buf, pos, 0xc000 | 12);
+	put_be16(buf, pos, type);
+	put_be16(buf, pos, 1); /* IN */
+	put_be16(buf, pos, ttl >> 16);
+	put_be16(buf, pos, ttl);
+	put_be16(buf, pos, rdlength);
+
+	memcpy(buf + *pos, rdata, rdlength);
+	*pos += rdlength;
+}
+
+/* Answer the last query with count addresses 192.0.2.10, 192.0.2.11...
+ * If cname_ttl is not 0, the addresses follow a CNAME with that TTL.
+ */
+static void reply(uint8_t rcode, int count, uint32_t ttl, uint32_t cname_ttl)
+{
+	static const uint8_t cname[] = { 0xc0, 12 };
+	uint8_t buf[256];
+	struct net_pkt *pkt;
+	size_t len;
+	int i;
+
+	zassert_true(query.len > 12, "No query to answer");
+
+	memcpy(buf, query.data, query.len);
+	len = query.len;
+
+	buf[2] = 0x81; /* Response, recursion desired */
+	buf[3] = 0x80 | rcode; /* Recursion available */
+	buf[6] = 0U;
+	buf[7] = count + (cname_ttl ? 1 : 0);
+
+	if (cname_ttl) {
+		put_rr(buf, &len, 5, cname_ttl, cname, sizeof(cname));
+	}
+
+	for (i = 0; i < count; i++) {
+		uint8_t addr[4] = { 192, 0, 2, 10 + i };
+
+		put_rr(buf, &len, 1, ttl, addr, sizeof(addr));
+	}
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, len, AF_INET, IPPROTO_UDP,
+					   K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_ipv4_create(pkt, &server_addr, &my_addr), 0,
+		      "Cannot create IPv4 header");
+	zassert_equal(net_udp_create(pkt, htons(DNS_PORT), htons(query.port)),
+		      0, "Cannot create UDP header");
+	zassert_equal(net_pkt_write(pkt, buf, len), 0, "Cannot write answer");
+
+	net_pkt_cursor_init(pkt);
+	net_ipv4_finalize(pkt, IPPROTO_UDP);
+	net_pkt_cursor_init(pkt);
+
+	zassert_equal(net_recv_data(iface, pkt), 0, "Cannot receive answer");
+}
+
+static void result_cb(enum dns_resolve_status status,
+		      struct dns_addrinfo *info, void *user_data)
+{
+	struct result *res = user_data;
+
+	if (status == DNS_EAI_INPROGRESS && info) {
+		if (res->count < ARRAY_SIZE(res->addr)) {
+			net_ipaddr_copy(&res->addr[res->count],
+					&net_sin(&info->ai_addr)->sin_addr);
+		}
+
+		res->count++;
+		return;
+	}
+
+	res->status = status;
+	k_sem_give(&res->done);
+}
+
+static uint16_t resolve(const char *name, struct result *res)
+{
+	uint16_t dns_id;
+	int ret;
+
+	k_sem_init(&res->done, 0, 1);
+	res->status = 0;
+	res->count = 0;
+
+	ret = dns_get_addr_info(name, DNS_QUERY_TYPE_A, &dns_id, result_cb,
+				res, DNS_TIMEOUT);
+	zassert_equal(ret, 0, "Cannot resolve %s (%d)", name, ret);
+
+	return dns_id;
+}
+
+static void expect_query(void)
+{
+	zassert_equal(k_sem_take(&wait_query, WAIT_TIME), 0,
+		      "Query not sent");
+}
+
+static void expect_no_query(void)
+{
+	zassert_not_equal(k_sem_take(&wait_query, K_MSEC(100)), 0,
+			  "Query sent");
+}
+
+static void expect_result(struct result *res, int status, int count)
+{
+	zassert_equal(k_sem_take(&res->done, WAIT_TIME), 0,
+		      "No result");
+	zassert_equal(res->status, status, "Invalid status %d", res->status);
+	zassert_equal(res->count, count, "Got %d addresses", res->count);
+}
+
+static void test_setup(void)
+{
+	struct net_if_addr *ifaddr;
+
+	iface = net_if_get_default();
+
+	ifaddr = net_if_ipv4_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add address");
+
+	net_if_up(iface);
+
+	dns_resolve_cache_flush();
+}
+
+static void test_cache_hit(void)
+{
+	struct dns_resolve_cache_stats before, after;
+	struct in_addr addr = { { { 192, 0, 2, 11 } } };
+	struct result res;
+
+	dns_resolve_cache_get_stats(&before);
+
+	resolve("hit.zephyr.test", &res);
+	expect_query();
+	reply(RCODE_NOERROR, 2, 60, 0);
+	expect_result(&res, DNS_EAI_ALLDONE, 2);
+
+	zassert_true(net_ipv4_addr_cmp(&res.addr[1], &addr),
+		     "Invalid second address");
+
+	resolve("hit.zephyr.test", &res);
+	expect_result(&res, DNS_EAI_ALLDONE, 2);
+	expect_no_query();
+
+	zassert_true(net_ipv4_addr_cmp(&res.addr[1], &addr),
+		     "Invalid cached address");
+
+	dns_resolve_cache_get_stats(&after);
+
+	zassert_equal(after.hits, before.hits + 1, "Hit not counted");
+	zassert_equal(after.misses, before.misses + 1, "Miss not counted");
+}
+
+static void test_cache_ttl(void)
+{
+	struct result res;
+
+	resolve("ttl.zephyr.test", &res);
+	expect_query();
+	reply(RCODE_NOERROR, 1, 1, 0);
+	expect_result(&res, DNS_EAI_ALLDONE, 1);
+
+	k_sleep(K_MSEC(1100));
+
+	resolve("ttl.zephyr.test", &res);
+	expect_query();
+	reply(RCODE_NOERROR, 1, 60, 0);
+	expect_result(&res, DNS_EAI_ALLDONE, 1);
+}
+
+static void test_cache_cname_ttl(void)
+{
+	struct result res;
+
+	resolve("cname.zephyr.test", &res);
+	expect_query();
+	reply(RCODE_NOERROR, 1, 60, 1);
+	expect_result(&res, DNS_EAI_ALLDONE, 1);
+
+	resolve("cname.zephyr.test", &res);
+	expect_result(&res, DNS_EAI_ALLDONE, 1);
+	expect_no_query();
+
+	/* The CNAME expires before the address */
+	k_sleep(K_MSEC(1100));
+
+	resolve("cname.zephyr.test", &res);
+	expect_query();
+	reply(RCODE_NOERROR, 1, 60, 0);
+	expect_result(&res, DNS_EAI_ALLDONE, 1);
+}
+
+static void test_cache_negative(void)
+{
+	struct result res;
+
+	resolve("none.zephyr.test", &res);
+	expect_query();
+	reply(RCODE_NXDOMAIN, 0, 0, 0);
+	expect_result(&res, DNS_EAI_NODATA, 0);
+
+	resolve("none.zephyr.test", &res);
+	expect_result(&res, DNS_EAI_NODATA, 0);
+	expect_no_query();
+}
+
+static void test_coalesce(void)
+{
+	struct dns_resolve_cache_stats before, after;
+	struct result res1, res2;
+
+	dns_resolve_cache_get_stats(&before);
+
+	resolve("same.zephyr.test", &res1);
+	resolve("same.zephyr.test", &res2);
+
+	expect_query();
+	expect_no_query();
+
+	reply(RCODE_NOERROR, 2, 60, 0);
+
+	expect_result(&res1, DNS_EAI_ALLDONE, 2);
+	expect_result(&res2, DNS_EAI_ALLDONE, 2);
+
+	dns_resolve_cache_get_stats(&after);
+
+	zassert_equal(after.coalesced, before.coalesced + 1,
+		      "Coalesced query not counted");
+}
+
+static void test_coalesce_cancel(void)
+{
+	struct result res1, res2;
+	uint16_t dns_id;
+
+	dns_id = resolve("cancel.zephyr.test", &res1);
+	resolve("cancel.zephyr.test", &res2);
+
+	expect_query();
+
+	/* The waiting query is sent when the first one is canceled */
+	zassert_equal(dns_cancel_addr_info(dns_id), 0, "Cannot cancel");
+	expect_result(&res1, DNS_EAI_CANCELED, 0);
+
+	expect_query();
+	reply(RCODE_NOERROR, 1, 60, 0);
+	expect_result(&res2, DNS_EAI_ALLDONE, 1);
+}
+
+static void test_coalesce_cancel_timeout(void)
+{
+	struct result res1, res2;
+	uint16_t dns_id;
+
+	dns_id = resolve("late.zephyr.test", &res1);
+	resolve("late.zephyr.test", &res2);
+
+	expect_query();
+
+	k_sleep(K_MSEC(DNS_TIMEOUT / 2));
+
+	zassert_equal(dns_cancel_addr_info(dns_id), 0, "Cannot cancel");
+	expect_result(&res1, DNS_EAI_CANCELED, 0);
+	expect_query();
+
+	/* The query sent instead keeps the time it had left */
+	zassert_equal(k_sem_take(&res2.done, K_MSEC(DNS_TIMEOUT / 2 + 100)),
+		      0, "Timeout restarted");
+	zassert_equal(res2.status, DNS_EAI_CANCELED, "Invalid status %d",
+		      res2.status);
+}
+
+static void test_cache_flush(void)
+{
+	struct result res;
+
+	dns_resolve_cache_flush();
+
+	resolve("hit.zephyr.test", &res);
+	expect_query();
+	reply(RCODE_NOERROR, 1, 60, 0);
+	expect_result(&res, DNS_EAI_ALLDONE, 1);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(dns_cache,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_cache_hit),
+			 ztest_unit_test(test_cache_ttl),
+			 ztest_unit_test(test_cache_cname_ttl),
+			 ztest_unit_test(test_cache_negative),
+			 ztest_unit_test(test_coalesce),
+			 ztest_unit_test(test_coalesce_cancel),
+			 ztest_unit_test(test_coalesce_cancel_timeout),
+			 ztest_unit_test(test_cache_flush));
+
+	ztest_run_test_suite(dns_cache);
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_HTTP_LOG_LEVEL);
+
+#include <ztest.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/http_client.h>
+
+#define SERVER_PORT 8080
+#define TIMEOUT_MS 3000
+
+#define GET(path) "GET " path " HTTP/1.1\r\nHost: 192.0.2.1\r\n\r\n"
+#define RSP(len, body) "HTTP/1.1 200 OK\r\nContent-Length: " #len	\
+		       "\r\n\r\n" body
+
+/* A request expected by the server stand-in and the response it sends */
+struct exchange {
+	const char *req;
+	const char *rsp;
+};
+
+static const struct exchange *script;
+static size_t script_len;
+static bool script_ok;
+
+static K_SEM_DEFINE(script_done, 0, 1);
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static char server_buf[512];
+static uint8_t recv_buf[256];
+
+static struct http_request reqs[3];
+static char body[ARRAY_SIZE(reqs)][16];
+static size_t body_len[ARRAY_SIZE(reqs)];
+static bool zero_copy;
+
+/* Play the script on each accepted connection */
+static void server_thread(void *p1, void *p2, void *p3)
+{
+	int s_sock = POINTER_TO_INT(p1);
+	size_t len, total;
+	ssize_t ret;
+	int sock;
+	int i;
+
+	while (true) {
+		sock = accept(s_sock, NULL, NULL);
+		if (sock < 0) {
+			return;
+		}
+
+		script_ok = true;
+
+		for (i = 0; i < script_len && script_ok; i++) {
+			len = strlen(script[i].req);
+
+			for (total = 0; total < len; total += ret) {
+				ret = recv(sock, server_buf + total,
+					   len - total, 0);
+				if (ret <= 0) {
+					break;
+				}
+			}
+
+			if (total != len || memcmp(server_buf, script[i].req,
+						   len)) {
+				server_buf[total] = '\0';
+				TC_PRINT("Unexpected request: %s\n",
+					 server_buf);
+				script_ok = false;
+				break;
+			}
+
+			send(sock, script[i].rsp, strlen(script[i].rsp), 0);
+		}
+
+		close(sock);
+		k_sem_give(&script_done);
+	}
+}
+
+K_THREAD_STACK_DEFINE(server_stack, 1024);
+static struct k_thread server_thread_data;
+
+static int connect_server(const struct exchange *exchanges, size_t count)
+{
+	int sock;
+
+	script = exchanges;
+	script_len = count;
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+
+	zassert_equal(connect(sock, (struct sockaddr *)&server_addr,
+			      sizeof(server_addr)), 0,
+		      "Cannot connect (%d)", errno);
+
+	return sock;
+}
+
+static void close_server(int sock)
+{
+	close(sock);
+
+	zassert_equal(k_sem_take(&script_done, K_SECONDS(1)), 0,
+		      "Script not finished");
+	zassert_true(script_ok, "Invalid requests");
+}
+
+static void response_cb(struct http_response *rsp,
+			enum http_final_call final_data,
+			void *user_data)
+{
+}
+
+static void body_cb(struct http_response *rsp, const uint8_t *data,
+		    size_t len, void *user_data)
+{
+	struct http_request *req = CONTAINER_OF(rsp, struct http_request,
+						internal.response);
+	int i = req - reqs;
+
+	zassert_true(i >= 0 && i < ARRAY_SIZE(reqs), "Unknown request");
+
+	/* The bodies are handed out from the receive buffer */
+	zero_copy = zero_copy && data >= recv_buf &&
+		    data + len <= recv_buf + sizeof(recv_buf);
+
+	memcpy(body[i] + body_len[i], data, len);
+	body_len[i] += len;
+}
+
+static void init_req(struct http_request *req, enum http_method method,
+		     const char *url)
+{
+	(void)memset(req, 0, sizeof(*req));
+
+	req->method = method;
+	req->url = url;
+	req->host = "192.0.2.1";
+	req->protocol = "HTTP/1.1";
+	req->response = response_cb;
+	req->recv_buf = recv_buf;
+	req->recv_buf_len = sizeof(recv_buf);
+}
+
+static void test_setup(void)
+{
+	int s_sock;
+
+	s_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(s_sock >= 0, "Cannot create socket");
+	zassert_equal(bind(s_sock, (struct sockaddr *)&server_addr,
+			   sizeof(server_addr)), 0, "Cannot bind");
+	zassert_equal(listen(s_sock, 1), 0, "Cannot listen");
+
+	k_thread_create(&server_thread_data, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_thread,
+			INT_TO_POINTER(s_sock), NULL, NULL,
+			K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+}
+
+static void test_keep_alive(void)
+{
+	static const struct exchange exchanges[] = {
+		{ GET("/a"), RSP(5, "first") },
+		{ GET("/b"), RSP(6, "second") },
+	};
+	struct http_request req;
+	int sock;
+
+	sock = connect_server(exchanges, ARRAY_SIZE(exchanges));
+
+	init_req(&req, HTTP_GET, "/a");
+	zassert_true(http_client_req(sock, &req, TIMEOUT_MS, NULL) > 0,
+		     "First request failed");
+	zassert_true(req.internal.response.message_complete,
+		     "First response not complete");
+	zassert_true(req.internal.response.keep_alive,
+		     "Connection cannot be reused");
+
+	init_req(&req, HTTP_GET, "/b");
+	zassert_true(http_client_req(sock, &req, TIMEOUT_MS, NULL) > 0,
+		     "Second request failed");
+	zassert_true(req.internal.response.message_complete,
+		     "Second response not complete");
+	zassert_equal(req.internal.response.processed, sizeof("second") - 1,
+		      "Invalid second response");
+
+	close_server(sock);
+}
+
+static const char *const chunks[] = { "abc", "defg" };
+static int chunk_idx;
+
+static ssize_t producer(struct http_request *req, const void **data,
+			void *user_data)
+{
+	if (chunk_idx == ARRAY_SIZE(chunks)) {
+		return 0;
+	}
+
+	*data = chunks[chunk_idx];
+
+	return strlen(chunks[chunk_idx++]);
+}
+
+static void test_chunked_upload(void)
+{
+	static const struct exchange exchanges[] = {
+		{
+			"POST /up HTTP/1.1\r\n"
+			"Host: 192.0.2.1\r\n"
+			"Transfer-Encoding: chunked\r\n\r\n"
+			"3\r\nabc\r\n"
+			"4\r\ndefg\r\n"
+			"0\r\n\r\n",
+			RSP(2, "ok")
+		},
+	};
+	struct http_request req;
+	int sock;
+
+	sock = connect_server(exchanges, ARRAY_SIZE(exchanges));
+
+	init_req(&req, HTTP_POST, "/up");
+	req.payload_producer = producer;
+
+	zassert_true(http_client_req(sock, &req, TIMEOUT_MS, NULL) > 0,
+		     "Request failed");
+	zassert_true(req.internal.response.message_complete,
+		     "Response not complete");
+	zassert_equal(chunk_idx, ARRAY_SIZE(chunks), "Payload not consumed");
+
+	close_server(sock);
+}
+
+static void test_pipelined(void)
+{
+	/* The server answers once it has all the requests, so the
+	 * responses come together.
+	 */
+	static const struct exchange exchanges[] = {
+		{
+			GET("/0") GET("/1") GET("/2"),
+			RSP(4, "zero") RSP(3, "one") RSP(3, "two")
+		},
+	};
+	static const char *const urls[] = { "/0", "/1", "/2" };
+	static const char *const expected[] = { "zero", "one", "two" };
+	struct http_request *req_ptrs[ARRAY_SIZE(reqs)];
+	int sock;
+	int i;
+
+	sock = connect_server(exchanges, ARRAY_SIZE(exchanges));
+
+	zero_copy = true;
+
+	for (i = 0; i < ARRAY_SIZE(reqs); i++) {
+		init_req(&reqs[i], HTTP_GET, urls[i]);
+		reqs[i].response = NULL;
+		reqs[i].body_cb = body_cb;
+		req_ptrs[i] = &reqs[i];
+	}
+
+	zassert_true(http_client_req_pipelined(sock, req_ptrs,
+					       ARRAY_SIZE(reqs), TIMEOUT_MS,
+					       NULL) > 0,
+		     "Pipelined requests failed");
+
+	for (i = 0; i < ARRAY_SIZE(reqs); i++) {
+		zassert_true(reqs[i].internal.response.message_complete,
+			     "Response %d not complete", i);
+		zassert_equal(body_len[i], strlen(expected[i]),
+			      "Invalid body %d length", i);
+		zassert_mem_equal(body[i], expected[i], body_len[i],
+				  "Invalid body %d", i);
+	}
+
+	zassert_true(zero_copy, "Body copied");
+
+	close_server(sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(http_client,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_keep_alive),
+			 ztest_unit_test(test_chunked_upload),
+			 ztest_unit_test(test_pipelined));
+
+	ztest_run_test_suite(http_client);
+}
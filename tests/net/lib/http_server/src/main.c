@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_HTTP_SERVER_LOG_LEVEL);
+
+#include <ztest.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/http_server.h>
+
+#define SERVER_PORT 8080
+#define RECV_TIMEOUT_MS 500
+
+#define GET(path, headers) "GET " path " HTTP/1.1\r\n" headers "\r\n"
+
+#define PLAIN_RSP "HTTP/1.1 200 OK\r\n"				\
+		  "Content-Type: text/plain\r\n"		\
+		  "Content-Length: 5\r\n\r\n"			\
+		  "hello"
+
+static const uint8_t plain_txt[] = "hello";
+
+/* Larger than the send buffer of a connection */
+#define BIG_LEN 2048
+#define BIG_HDR "HTTP/1.1 200 OK\r\n"				\
+		"Content-Type: application/octet-stream\r\n"	\
+		"Content-Length: 2048\r\n\r\n"
+
+static uint8_t big_bin[BIG_LEN];
+
+static const uint8_t index_html_gz[] = {
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+HTTP_RESOURCE_STATIC_DEFINE(plain_resource, "/plain", "text/plain", NULL,
+			    plain_txt, sizeof(plain_txt) - 1);
+HTTP_RESOURCE_STATIC_DEFINE(big_resource, "/big", "application/octet-stream",
+			    NULL, big_bin, sizeof(big_bin));
+HTTP_RESOURCE_STATIC_DEFINE(index_resource, "/index.html", "text/html",
+			    "gzip", index_html_gz, sizeof(index_html_gz));
+
+static int dyn_cb(struct http_server_req *req, void *user_data)
+{
+	int ret;
+
+	zassert_equal_ptr(user_data, &plain_resource, "Invalid user data");
+
+	if (req->method == HTTP_POST) {
+		return http_server_send_response(req, 200, "text/plain",
+						 req->body, req->body_len);
+	}
+
+	ret = http_server_send_chunked_start(req, 200, "text/plain");
+	ret = ret ? ret : http_server_send_chunk(req, "hel", 3);
+	ret = ret ? ret : http_server_send_chunk(req, "lo", 2);
+
+	/* The server ends the chunked response */
+	return ret;
+}
+
+HTTP_RESOURCE_DYNAMIC_DEFINE(dyn_resource, "/dyn", dyn_cb,
+			     (void *)&plain_resource);
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static char rsp[BIG_LEN + 512];
+
+static int connect_server(void)
+{
+	int sock;
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+
+	zassert_equal(zsock_connect(sock, (struct sockaddr *)&server_addr,
+				    sizeof(server_addr)), 0,
+		      "Cannot connect (%d)", errno);
+
+	return sock;
+}
+
+/* Receive until len bytes arrived, the connection is closed or nothing
+ * comes for a while.
+ */
+static size_t recv_rsp(int sock, size_t len, bool *closed)
+{
+	struct zsock_pollfd pfd = { .fd = sock, .events = ZSOCK_POLLIN };
+	size_t total = 0;
+	ssize_t ret;
+
+	*closed = false;
+
+	while (total < len || len == 0) {
+		if (zsock_poll(&pfd, 1, RECV_TIMEOUT_MS) <= 0) {
+			break;
+		}
+
+		ret = zsock_recv(sock, rsp + total, sizeof(rsp) - 1 - total, 0);
+		if (ret <= 0) {
+			*closed = true;
+			break;
+		}
+
+		total += ret;
+	}
+
+	rsp[total] = '\0';
+
+	return total;
+}
+
+static void request(int sock, const char *req, const char *expected,
+		    bool expect_close)
+{
+	size_t len = strlen(expected);
+	bool closed;
+
+	zassert_equal(zsock_send(sock, req, strlen(req), 0), strlen(req),
+		      "Cannot send request");
+
+	zassert_equal(recv_rsp(sock, len, &closed), len,
+		      "Invalid response length: %s", rsp);
+	zassert_mem_equal(rsp, expected, len, "Invalid response: %s", rsp);
+
+	if (expect_close) {
+		recv_rsp(sock, 0, &closed);
+		zassert_true(closed, "Connection not closed");
+	}
+}
+
+static void test_start(void)
+{
+	zassert_equal(http_server_start(SERVER_PORT), 0, "Cannot start");
+	zassert_equal(http_server_start(SERVER_PORT), -EALREADY,
+		      "Started twice");
+}
+
+static void test_keep_alive(void)
+{
+	int sock = connect_server();
+
+	request(sock, GET("/plain", "Host: test\r\n"), PLAIN_RSP, false);
+	request(sock, GET("/plain", "Host: test\r\n"), PLAIN_RSP, false);
+
+	request(sock, GET("/plain", "Connection: close\r\n"),
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/plain\r\n"
+		"Content-Length: 5\r\n"
+		"Connection: close\r\n\r\n"
+		"hello", true);
+
+	zsock_close(sock);
+}
+
+static void test_pipelining(void)
+{
+	int sock = connect_server();
+
+	request(sock,
+		GET("/plain", "")
+		GET("/missing", "")
+		"HEAD /plain HTTP/1.1\r\n\r\n"
+		"POST /plain HTTP/1.1\r\nContent-Length: 0\r\n\r\n",
+		PLAIN_RSP
+		"HTTP/1.1 404 Not Found\r\n"
+		"Content-Length: 0\r\n\r\n"
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/plain\r\n"
+		"Content-Length: 5\r\n\r\n"
+		"HTTP/1.1 405 Method Not Allowed\r\n"
+		"Content-Length: 0\r\n"
+		"Allow: GET, HEAD\r\n\r\n", false);
+
+	zsock_close(sock);
+}
+
+static void test_gzip(void)
+{
+	int sock = connect_server();
+
+	request(sock, GET("/index.html", "Accept-Encoding: deflate, gzip\r\n"),
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/html\r\n"
+		"Content-Encoding: gzip\r\n"
+		"Content-Length: 8\r\n\r\n"
+		"\x1f\x8b\x08\x00\x00\x00\x00\x00", false);
+
+	request(sock, GET("/index.html", ""),
+		"HTTP/1.1 406 Not Acceptable\r\n"
+		"Content-Length: 0\r\n\r\n", false);
+
+	zsock_close(sock);
+}
+
+static void test_dynamic(void)
+{
+	int sock = connect_server();
+
+	request(sock, GET("/dyn?x=1", ""),
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/plain\r\n"
+		"Transfer-Encoding: chunked\r\n\r\n"
+		"3\r\nhel\r\n"
+		"2\r\nlo\r\n"
+		"0\r\n\r\n", false);
+
+	request(sock,
+		"POST /dyn HTTP/1.1\r\n"
+		"Transfer-Encoding: chunked\r\n\r\n"
+		"4\r\nabcd\r\n"
+		"2\r\nef\r\n"
+		"0\r\n\r\n",
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/plain\r\n"
+		"Content-Length: 6\r\n\r\n"
+		"abcdef", false);
+
+	zsock_close(sock);
+}
+
+static void test_errors(void)
+{
+	int sock = connect_server();
+
+	request(sock,
+		"POST /dyn HTTP/1.1\r\n"
+		"Content-Length: 100000\r\n\r\n",
+		"HTTP/1.1 413 Payload Too Large\r\n"
+		"Content-Length: 0\r\n"
+		"Connection: close\r\n\r\n", true);
+
+	zsock_close(sock);
+
+	sock = connect_server();
+
+	request(sock, "GET /plain FOO\r\n\r\n",
+		"HTTP/1.1 400 Bad Request\r\n"
+		"Content-Length: 0\r\n"
+		"Connection: close\r\n\r\n", true);
+
+	zsock_close(sock);
+}
+
+/* A client which does not read its responses does not hold up the others,
+ * and gets them in order once it reads.
+ */
+static void test_slow_client(void)
+{
+	static const char reqs[] = GET("/big", "") GET("/plain", "");
+	size_t len = sizeof(BIG_HDR) - 1 + BIG_LEN + sizeof(PLAIN_RSP) - 1;
+	int slow, sock;
+	bool closed;
+	int i;
+
+	for (i = 0; i < BIG_LEN; i++) {
+		big_bin[i] = i;
+	}
+
+	slow = connect_server();
+
+	zassert_equal(zsock_send(slow, reqs, sizeof(reqs) - 1, 0),
+		      sizeof(reqs) - 1, "Cannot send request");
+
+	sock = connect_server();
+	request(sock, GET("/plain", ""), PLAIN_RSP, false);
+	zsock_close(sock);
+
+	zassert_equal(recv_rsp(slow, len, &closed), len,
+		      "Invalid response length");
+	zassert_mem_equal(rsp, BIG_HDR, sizeof(BIG_HDR) - 1,
+			  "Invalid header: %s", rsp);
+	zassert_mem_equal(rsp + sizeof(BIG_HDR) - 1, big_bin, BIG_LEN,
+			  "Invalid body");
+	zassert_mem_equal(rsp + sizeof(BIG_HDR) - 1 + BIG_LEN, PLAIN_RSP,
+			  sizeof(PLAIN_RSP) - 1, "Invalid pipelined response");
+
+	zsock_close(slow);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(http_server,
+			 ztest_unit_test(test_start),
+			 ztest_unit_test(test_keep_alive),
+			 ztest_unit_test(test_pipelining),
+			 ztest_unit_test(test_gzip),
+			 ztest_unit_test(test_dynamic),
+			 ztest_unit_test(test_slow_client),
+			 ztest_unit_test(test_errors));
+
+	ztest_run_test_suite(http_server);
+}
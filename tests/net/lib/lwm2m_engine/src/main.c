@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_LWM2M_LOG_LEVEL);
+
+#include <ztest.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/coap.h>
+#include <net/lwm2m.h>
+
+#define PORT		5683
+/* longer than the 1 s pmin and an engine service period */
+#define TIMEOUT_MS	3000
+
+#define FORMAT_PLAIN_TEXT	0
+
+#define PKT_SIZE	256
+
+/* tokens of the observations, one byte long */
+#define TOKEN_0		'0'
+#define TOKEN_2		'2'
+#define TOKEN_3		'3'
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static struct lwm2m_ctx client;
+static struct sockaddr client_addr;
+static int server_sock = -1;
+
+static uint8_t req_buf[PKT_SIZE];
+static uint8_t rsp_buf[PKT_SIZE];
+static struct coap_packet rsp;
+
+static int server_recv(int timeout)
+{
+	struct zsock_pollfd fds = {
+		.fd = server_sock,
+		.events = ZSOCK_POLLIN,
+	};
+	ssize_t len;
+
+	if (zsock_poll(&fds, 1, timeout) <= 0) {
+		return -ETIMEDOUT;
+	}
+
+	len = zsock_recv(server_sock, rsp_buf, sizeof(rsp_buf), 0);
+	if (len < 0) {
+		return -errno;
+	}
+
+	return coap_packet_parse(&rsp, rsp_buf, len, NULL, 0);
+}
+
+static void server_send(struct coap_packet *pkt)
+{
+	zassert_true(zsock_sendto(server_sock, pkt->data, pkt->offset, 0,
+				  &client_addr, sizeof(struct sockaddr_in)) >= 0,
+		     "Cannot send to the client");
+}
+
+/*
+ * Request on path, made of the '/' separated segments given, with the
+ * Observe option if >= 0.
+ */
+static void request(uint8_t method, uint8_t token, const char *path,
+		    int observe)
+{
+	struct coap_packet req;
+	const char *end;
+	int r;
+
+	r = coap_packet_init(&req, req_buf, sizeof(req_buf), 1, COAP_TYPE_CON,
+			     1, &token, method, coap_next_id());
+	zassert_equal(r, 0, "Cannot init the request");
+
+	if (observe >= 0) {
+		r = coap_append_option_int(&req, COAP_OPTION_OBSERVE, observe);
+		zassert_equal(r, 0, "Cannot append Observe");
+	}
+
+	while (*path) {
+		end = strchr(path, '/');
+		if (!end) {
+			end = path + strlen(path);
+		}
+
+		r = coap_packet_append_option(&req, COAP_OPTION_URI_PATH,
+					      (const uint8_t *)path,
+					      end - path);
+		zassert_equal(r, 0, "Cannot append Uri-Path");
+
+		path = *end ? end + 1 : end;
+	}
+
+	if (method == COAP_METHOD_GET) {
+		r = coap_append_option_int(&req, COAP_OPTION_ACCEPT,
+					   FORMAT_PLAIN_TEXT);
+		zassert_equal(r, 0, "Cannot append Accept");
+	}
+
+	server_send(&req);
+}
+
+static void expect_response(uint8_t code)
+{
+	zassert_equal(server_recv(TIMEOUT_MS), 0, "No response");
+	zassert_equal(coap_header_get_type(&rsp), COAP_TYPE_ACK,
+		      "Not an ACK");
+	zassert_equal(coap_header_get_code(&rsp), code,
+		      "Unexpected response code %u",
+		      coap_header_get_code(&rsp));
+}
+
+/* Receive a notification with the given token and payload, and ACK it */
+static void expect_notification(uint8_t token, const char *payload)
+{
+	struct coap_packet ack;
+	uint8_t rsp_token[8];
+	const uint8_t *data;
+	uint16_t data_len;
+
+	zassert_equal(server_recv(TIMEOUT_MS), 0, "No notification");
+	zassert_equal(coap_header_get_type(&rsp), COAP_TYPE_CON, "Not a CON");
+	zassert_equal(coap_header_get_token(&rsp, rsp_token), 1,
+		      "Unexpected token length");
+	zassert_equal(rsp_token[0], token, "Unexpected token %c",
+		      rsp_token[0]);
+
+	data = coap_packet_get_payload(&rsp, &data_len);
+	zassert_equal(data_len, strlen(payload), "Unexpected payload length");
+	zassert_mem_equal(data, payload, data_len, "Unexpected payload");
+
+	zassert_equal(coap_packet_init(&ack, req_buf, sizeof(req_buf), 1,
+				       COAP_TYPE_ACK, 0, NULL, 0,
+				       coap_header_get_id(&rsp)), 0,
+		      "Cannot init the ACK");
+	server_send(&ack);
+}
+
+static void observe(uint8_t token, const char *path)
+{
+	request(COAP_METHOD_GET, token, path, 0);
+	expect_response(COAP_RESPONSE_CODE_CONTENT);
+
+	/* updates in the same millisecond would not be events */
+	k_sleep(K_MSEC(10));
+}
+
+static void cancel(uint8_t token, const char *path)
+{
+	request(COAP_METHOD_GET, token, path, 1);
+	expect_response(COAP_RESPONSE_CODE_CONTENT);
+}
+
+static void set_value(char *path, int32_t val1)
+{
+	float32_value_t value = { val1, 0 };
+
+	zassert_equal(lwm2m_engine_set_float32(path, &value), 0,
+		      "Cannot set %s", path);
+}
+
+static int32_t get_value(char *path)
+{
+	float32_value_t value;
+
+	zassert_equal(lwm2m_engine_get_float32(path, &value), 0,
+		      "Cannot get %s", path);
+
+	return value.val1;
+}
+
+static void test_setup(void)
+{
+	socklen_t len = sizeof(client_addr);
+
+	server_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(server_sock >= 0, "Cannot create the server socket");
+	zassert_equal(zsock_bind(server_sock, (struct sockaddr *)&addr,
+				 sizeof(addr)), 0, "Cannot bind");
+
+	lwm2m_engine_set_string("0/0/0", "coap://192.0.2.1:5683");
+	lwm2m_engine_set_u8("0/0/2", 3);
+
+	zassert_equal(lwm2m_engine_start(&client), 0, "Cannot start");
+	zassert_equal(zsock_getsockname(client.sock_fd, &client_addr, &len),
+		      0, "Cannot get the client address");
+}
+
+/* Instances in the same index bucket are found and removed one by one */
+static void test_path_index(void)
+{
+	float32_value_t value;
+
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/0"), 0,
+		      "Cannot create 3303/0");
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/1"), 0,
+		      "Cannot create 3303/1");
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/2"), 0,
+		      "Cannot create 3303/2");
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/3"), 0,
+		      "Cannot create 3303/3");
+	zassert_not_equal(lwm2m_engine_create_obj_inst("3303/2"), 0,
+			  "3303/2 created twice");
+
+	set_value("3303/0/5700", 10);
+	set_value("3303/1/5700", 11);
+	set_value("3303/2/5700", 12);
+	set_value("3303/3/5700", 13);
+
+	zassert_equal(get_value("3303/0/5700"), 10, "Wrong instance");
+	zassert_equal(get_value("3303/1/5700"), 11, "Wrong instance");
+	zassert_equal(get_value("3303/2/5700"), 12, "Wrong instance");
+	zassert_equal(get_value("3303/3/5700"), 13, "Wrong instance");
+
+	request(COAP_METHOD_DELETE, 'd', "3303/1", -1);
+	expect_response(COAP_RESPONSE_CODE_DELETED);
+
+	zassert_not_equal(lwm2m_engine_get_float32("3303/1/5700", &value), 0,
+			  "Deleted instance found");
+	zassert_equal(get_value("3303/0/5700"), 10, "Wrong instance");
+	zassert_equal(get_value("3303/2/5700"), 12, "Wrong instance");
+	zassert_equal(get_value("3303/3/5700"), 13, "Wrong instance");
+
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/1"), 0,
+		      "Cannot create 3303/1 again");
+	set_value("3303/1/5700", 21);
+	zassert_equal(get_value("3303/1/5700"), 21, "Wrong instance");
+}
+
+/* Deleting an instance removes its observers, and only them */
+static void test_observer_removal(void)
+{
+	observe(TOKEN_0, "3303/0/5700");
+	observe(TOKEN_2, "3303/2/5700");
+
+	request(COAP_METHOD_DELETE, 'd', "3303/0", -1);
+	expect_response(COAP_RESPONSE_CODE_DELETED);
+
+	set_value("3303/2/5700", 22);
+	expect_notification(TOKEN_2, "22.0");
+
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/0"), 0,
+		      "Cannot create 3303/0 again");
+	set_value("3303/0/5700", 20);
+	zassert_equal(server_recv(TIMEOUT_MS), -ETIMEDOUT,
+		      "Removed observer notified");
+
+	cancel(TOKEN_2, "3303/2/5700");
+}
+
+/* The updates of a resource within its pmin make one notification */
+static void test_event_coalescing(void)
+{
+	observe(TOKEN_3, "3303/3/5700");
+
+	set_value("3303/3/5700", 31);
+	set_value("3303/3/5700", 32);
+	set_value("3303/3/5700", 33);
+
+	expect_notification(TOKEN_3, "33.0");
+	zassert_equal(server_recv(TIMEOUT_MS), -ETIMEDOUT,
+		      "Events notified twice");
+
+	/* an event after the notification is notified again */
+	set_value("3303/3/5700", 34);
+	expect_notification(TOKEN_3, "34.0");
+
+	cancel(TOKEN_3, "3303/3/5700");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_engine,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_path_index),
+			 ztest_unit_test(test_observer_removal),
+			 ztest_unit_test(test_event_coalescing));
+
+	ztest_run_test_suite(lwm2m_engine);
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_LWM2M_LOG_LEVEL);
+
+#include <ztest.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/coap.h>
+#include <net/lwm2m.h>
+
+#define PORT		5683
+#define TIMEOUT_MS	2000
+
+#define FORMAT_SENML_JSON	110
+#define FORMAT_SENML_CBOR	112
+
+#define PKT_SIZE	256
+
+/* CBOR text string of 8 or 12 characters */
+#define TEXT8(...)	0x68, __VA_ARGS__
+#define TEXT12(...)	0x6c, __VA_ARGS__
+
+#define BN_3303_0	TEXT8('/', '3', '3', '0', '3', '/', '0', '/')
+#define BN_3303_1	TEXT8('/', '3', '3', '0', '3', '/', '1', '/')
+#define N_5700		0x64, '5', '7', '0', '0'
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static struct lwm2m_ctx client;
+static struct sockaddr client_addr;
+static int server_sock = -1;
+
+static uint8_t token[] = { 0x53, 0x65, 0x6e, 0x4d };
+static uint8_t req_buf[PKT_SIZE];
+static uint8_t rsp_buf[PKT_SIZE];
+static struct coap_packet rsp;
+
+static char utc_offset[8];
+static char timezone[16];
+
+static int server_recv(int timeout)
+{
+	struct zsock_pollfd fds = {
+		.fd = server_sock,
+		.events = ZSOCK_POLLIN,
+	};
+	ssize_t len;
+
+	if (zsock_poll(&fds, 1, timeout) <= 0) {
+		return -ETIMEDOUT;
+	}
+
+	len = zsock_recv(server_sock, rsp_buf, sizeof(rsp_buf), 0);
+	if (len < 0) {
+		return -errno;
+	}
+
+	return coap_packet_parse(&rsp, rsp_buf, len, NULL, 0);
+}
+
+static void server_send(struct coap_packet *pkt)
+{
+	zassert_true(zsock_sendto(server_sock, pkt->data, pkt->offset, 0,
+				  &client_addr, sizeof(struct sockaddr_in)) >= 0,
+		     "Cannot send to the client");
+}
+
+/*
+ * Request on path, made of the '/' separated segments given, with the
+ * options >= 0 only.
+ */
+static void request(uint8_t method, const char *path, int observe,
+		    int format, int accept, const void *payload, size_t len)
+{
+	struct coap_packet req;
+	const char *end;
+	int r;
+
+	r = coap_packet_init(&req, req_buf, sizeof(req_buf), 1, COAP_TYPE_CON,
+			     sizeof(token), token, method, coap_next_id());
+	zassert_equal(r, 0, "Cannot init the request");
+
+	if (observe >= 0) {
+		r = coap_append_option_int(&req, COAP_OPTION_OBSERVE, observe);
+		zassert_equal(r, 0, "Cannot append Observe");
+	}
+
+	while (path && *path) {
+		end = strchr(path, '/');
+		if (!end) {
+			end = path + strlen(path);
+		}
+
+		r = coap_packet_append_option(&req, COAP_OPTION_URI_PATH,
+					      (const uint8_t *)path,
+					      end - path);
+		zassert_equal(r, 0, "Cannot append Uri-Path");
+
+		path = *end ? end + 1 : end;
+	}
+
+	if (format >= 0) {
+		r = coap_append_option_int(&req, COAP_OPTION_CONTENT_FORMAT,
+					   format);
+		zassert_equal(r, 0, "Cannot append Content-Format");
+	}
+
+	if (accept >= 0) {
+		r = coap_append_option_int(&req, COAP_OPTION_ACCEPT, accept);
+		zassert_equal(r, 0, "Cannot append Accept");
+	}
+
+	if (len) {
+		r = coap_packet_append_payload_marker(&req);
+		r = r < 0 ? r : coap_packet_append_payload(&req,
+							  (uint8_t *)payload, len);
+		zassert_equal(r, 0, "Cannot append the payload");
+	}
+
+	server_send(&req);
+}
+
+static void expect_payload(const void *payload, size_t len)
+{
+	const uint8_t *data;
+	uint16_t data_len;
+
+	data = coap_packet_get_payload(&rsp, &data_len);
+	zassert_equal(data_len, len, "Unexpected payload length %u",
+		      data_len);
+	zassert_mem_equal(data, payload, len, "Unexpected payload");
+}
+
+static void expect_response(uint8_t code, const void *payload, size_t len)
+{
+	zassert_equal(server_recv(TIMEOUT_MS), 0, "No response");
+	zassert_equal(coap_header_get_type(&rsp), COAP_TYPE_ACK,
+		      "Not an ACK");
+	zassert_equal(coap_header_get_code(&rsp), code,
+		      "Unexpected response code %u",
+		      coap_header_get_code(&rsp));
+
+	expect_payload(payload, len);
+}
+
+static void test_setup(void)
+{
+	socklen_t len = sizeof(client_addr);
+	float32_value_t value;
+
+	server_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(server_sock >= 0, "Cannot create the server socket");
+	zassert_equal(zsock_bind(server_sock, (struct sockaddr *)&addr,
+				 sizeof(addr)), 0, "Cannot bind");
+
+	lwm2m_engine_set_string("0/0/0", "coap://192.0.2.1:5683");
+	lwm2m_engine_set_u8("0/0/2", 3);
+
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/0"), 0,
+		      "Cannot create 3303/0");
+	zassert_equal(lwm2m_engine_create_obj_inst("3303/1"), 0,
+		      "Cannot create 3303/1");
+	zassert_equal(lwm2m_engine_create_obj_inst("3338/0"), 0,
+		      "Cannot create 3338/0");
+
+	value.val1 = 21;
+	value.val2 = 500000;
+	lwm2m_engine_set_float32("3303/0/5700", &value);
+
+	value.val1 = -4;
+	value.val2 = -250000;
+	lwm2m_engine_set_float32("3303/1/5700", &value);
+
+	lwm2m_engine_set_res_data("3/0/14", utc_offset, sizeof(utc_offset), 0);
+	lwm2m_engine_set_res_data("3/0/15", timezone, sizeof(timezone), 0);
+
+	zassert_equal(lwm2m_engine_start(&client), 0, "Cannot start");
+	zassert_equal(zsock_getsockname(client.sock_fd, &client_addr, &len),
+		      0, "Cannot get the client address");
+}
+
+static void test_read_senml_json(void)
+{
+	static const char expected[] =
+		"[{\"bn\":\"/3303/0/\",\"n\":\"5700\",\"v\":21.5}]";
+
+	request(COAP_METHOD_GET, "3303/0/5700", -1, -1, FORMAT_SENML_JSON,
+		NULL, 0);
+	expect_response(COAP_RESPONSE_CODE_CONTENT, expected,
+			strlen(expected));
+}
+
+static void test_read_senml_cbor(void)
+{
+	static const uint8_t expected[] = {
+		0x81, 0xa3, 0x21, BN_3303_0, 0x00, N_5700,
+		0x02, 0xfa, 0x41, 0xac, 0x00, 0x00,
+	};
+
+	request(COAP_METHOD_GET, "3303/0/5700", -1, -1, FORMAT_SENML_CBOR,
+		NULL, 0);
+	expect_response(COAP_RESPONSE_CODE_CONTENT, expected,
+			sizeof(expected));
+}
+
+static void test_write_senml_json(void)
+{
+	static const char payload[] =
+		"[{\"bn\":\"/3/0/\",\"n\":\"14\",\"vs\":\"+02:00\"},"
+		"{\"n\":\"15\",\"vs\":\"Europe/Paris\"}]";
+
+	request(COAP_METHOD_POST, "3/0", -1, FORMAT_SENML_JSON, -1,
+		payload, strlen(payload));
+	expect_response(COAP_RESPONSE_CODE_CHANGED, NULL, 0);
+
+	zassert_equal(strcmp(utc_offset, "+02:00"), 0, "Not written");
+	zassert_equal(strcmp(timezone, "Europe/Paris"), 0, "Not written");
+}
+
+static void test_composite_write_senml_cbor(void)
+{
+	static const uint8_t payload[] = {
+		0x81, 0xa2,
+		0x00, 0x67, '/', '3', '/', '0', '/', '1', '4',
+		0x03, 0x66, '+', '0', '1', ':', '0', '0',
+	};
+
+	request(COAP_METHOD_IPATCH, NULL, -1, FORMAT_SENML_CBOR, -1,
+		payload, sizeof(payload));
+	expect_response(COAP_RESPONSE_CODE_CHANGED, NULL, 0);
+
+	zassert_equal(strcmp(utc_offset, "+01:00"), 0, "Not written");
+}
+
+/* Negative binary32 and binary64 values, with and without a whole part */
+static void test_composite_write_float_senml_cbor(void)
+{
+	static const uint8_t payload[] = {
+		0x82, 0xa2,
+		0x00, TEXT12('/', '3', '3', '3', '8', '/', '0', '/',
+			     '5', '5', '4', '8'),
+		0x02, 0xfa, 0xc0, 0x88, 0x00, 0x00,
+		0xa2,
+		0x00, TEXT12('/', '3', '3', '3', '8', '/', '0', '/',
+			     '5', '5', '2', '5'),
+		0x02, 0xfb, 0xbf, 0xe0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+	float32_value_t level;
+	float64_value_t off_time;
+
+	request(COAP_METHOD_IPATCH, NULL, -1, FORMAT_SENML_CBOR, -1,
+		payload, sizeof(payload));
+	expect_response(COAP_RESPONSE_CODE_CHANGED, NULL, 0);
+
+	zassert_equal(lwm2m_engine_get_float32("3338/0/5548", &level), 0,
+		      "Cannot get 3338/0/5548");
+	zassert_equal(level.val1, -4, "Wrong whole part");
+	zassert_equal(level.val2, -250000, "Wrong fractional part");
+
+	zassert_equal(lwm2m_engine_get_float64("3338/0/5525", &off_time), 0,
+		      "Cannot get 3338/0/5525");
+	zassert_equal(off_time.val1, 0, "Wrong whole part");
+	zassert_equal(off_time.val2, -500000000LL, "Wrong fractional part");
+}
+
+static void test_composite_read_senml_json(void)
+{
+	static const char payload[] =
+		"[{\"n\":\"/3303/0/5700\"},{\"n\":\"/3303/1/5700\"},"
+		"{\"n\":\"/3303/7/5700\"}]";
+	static const char expected[] =
+		"[{\"bn\":\"/3303/0/\",\"n\":\"5700\",\"v\":21.5},"
+		"{\"bn\":\"/3303/1/\",\"n\":\"5700\",\"v\":-4.25}]";
+
+	request(COAP_METHOD_FETCH, NULL, -1, FORMAT_SENML_JSON, -1,
+		payload, strlen(payload));
+	expect_response(COAP_RESPONSE_CODE_CONTENT, expected,
+			strlen(expected));
+}
+
+static void test_composite_observe_senml_cbor(void)
+{
+	static const uint8_t payload[] = {
+		0x82,
+		0xa1, 0x00, TEXT12('/', '3', '3', '0', '3', '/', '0', '/',
+				   '5', '7', '0', '0'),
+		0xa1, 0x00, TEXT12('/', '3', '3', '0', '3', '/', '1', '/',
+				   '5', '7', '0', '0'),
+	};
+	static const uint8_t expected[] = {
+		0x82,
+		0xa3, 0x21, BN_3303_0, 0x00, N_5700,
+		0x02, 0xfa, 0x41, 0xac, 0x00, 0x00,
+		0xa3, 0x21, BN_3303_1, 0x00, N_5700,
+		0x02, 0xfa, 0xc0, 0x88, 0x00, 0x00,
+	};
+	/* whole numbers are sent as integers */
+	static const uint8_t notified[] = {
+		0x82,
+		0xa3, 0x21, BN_3303_0, 0x00, N_5700,
+		0x02, 0xfa, 0x41, 0xac, 0x00, 0x00,
+		0xa3, 0x21, BN_3303_1, 0x00, N_5700,
+		0x02, 0x18, 0x1e,
+	};
+	float32_value_t value = { 30, 0 };
+	struct coap_packet ack;
+	uint8_t rsp_token[8];
+
+	request(COAP_METHOD_FETCH, NULL, 0, FORMAT_SENML_CBOR, -1,
+		payload, sizeof(payload));
+	expect_response(COAP_RESPONSE_CODE_CONTENT, expected,
+			sizeof(expected));
+	zassert_equal(coap_get_option_int(&rsp, COAP_OPTION_OBSERVE), 1,
+		      "No Observe option");
+
+	/* after the observation started */
+	k_sleep(K_MSEC(10));
+	lwm2m_engine_set_float32("3303/1/5700", &value);
+
+	zassert_equal(server_recv(TIMEOUT_MS), 0, "No notification");
+	zassert_equal(coap_header_get_type(&rsp), COAP_TYPE_CON, "Not a CON");
+	zassert_equal(coap_header_get_token(&rsp, rsp_token), sizeof(token),
+		      "Unexpected token length");
+	zassert_mem_equal(rsp_token, token, sizeof(token),
+			  "Unexpected token");
+	zassert_equal(coap_get_option_int(&rsp, COAP_OPTION_OBSERVE), 2,
+		      "Unexpected Observe option");
+	expect_payload(notified, sizeof(notified));
+
+	zassert_equal(coap_packet_init(&ack, req_buf, sizeof(req_buf), 1,
+				       COAP_TYPE_ACK, 0, NULL, 0,
+				       coap_header_get_id(&rsp)), 0,
+		      "Cannot init the ACK");
+	server_send(&ack);
+
+	/* cancel the observation */
+	request(COAP_METHOD_FETCH, NULL, 1, FORMAT_SENML_CBOR, -1,
+		payload, sizeof(payload));
+	expect_response(COAP_RESPONSE_CODE_CONTENT, notified,
+			sizeof(notified));
+
+	value.val1 = 31;
+	lwm2m_engine_set_float32("3303/1/5700", &value);
+	zassert_equal(server_recv(TIMEOUT_MS), -ETIMEDOUT,
+		      "Notified after the cancellation");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_senml,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_read_senml_json),
+			 ztest_unit_test(test_read_senml_cbor),
+			 ztest_unit_test(test_write_senml_json),
+			 ztest_unit_test(test_composite_write_senml_cbor),
+			 ztest_unit_test(test_composite_write_float_senml_cbor),
+			 ztest_unit_test(test_composite_read_senml_json),
+			 ztest_unit_test(test_composite_observe_senml_cbor));
+
+	ztest_run_test_suite(lwm2m_senml);
+}
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_MQTT_LOG_LEVEL);
+
+#include <ztest.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#define SERVER_PORT 1883
+#define TIMEOUT_MS 1000
+
+/* QoS 0 PUBLISH of "a" on topic "t/<n>", binding it to a topic alias */
+#define PUBLISH_BIND(n, alias) \
+	0x30, 0x0A, 0x00, 0x03, 't', '/', (n), 0x03, 0x23, 0x00, (alias), 'a'
+
+/* PUBLISH of "a" on the topic bound to a topic alias */
+#define PUBLISH_ALIAS(alias) \
+	0x30, 0x07, 0x00, 0x00, 0x03, 0x23, 0x00, (alias), 'a'
+
+#define PUBLISH_QOS1_ALIAS(id, alias) \
+	0x32, 0x09, 0x00, 0x00, 0x00, (id), 0x03, 0x23, 0x00, (alias), 'a'
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static struct mqtt_client client;
+static uint8_t rx_buf[128];
+static uint8_t tx_buf[128];
+static uint8_t server_buf[128];
+static int s_sock = -1;
+static int sock = -1;
+
+static enum mqtt_evt_type last_evt;
+static struct mqtt_connack_param last_connack;
+static struct mqtt_puback_param last_puback;
+static uint8_t rx_topic[16];
+static size_t rx_topic_len;
+static uint8_t rx_payload;
+
+static void evt_cb(struct mqtt_client *const c, const struct mqtt_evt *evt)
+{
+	const struct mqtt_publish_param *pub = &evt->param.publish;
+
+	last_evt = evt->type;
+
+	switch (evt->type) {
+	case MQTT_EVT_CONNACK:
+		last_connack = evt->param.connack;
+		break;
+
+	case MQTT_EVT_PUBACK:
+		last_puback = evt->param.puback;
+		break;
+
+	case MQTT_EVT_PUBLISH:
+		if (evt->result != 0) {
+			break;
+		}
+
+		rx_topic_len = MIN(pub->message.topic.topic.size,
+				   sizeof(rx_topic));
+		memcpy(rx_topic, pub->message.topic.topic.utf8, rx_topic_len);
+
+		zassert_equal(pub->message.payload.len, 1, "Unexpected payload");
+		zassert_equal(mqtt_read_publish_payload_blocking(
+				      c, &rx_payload, 1), 1,
+			      "Cannot read payload");
+		break;
+
+	default:
+		break;
+	}
+}
+
+static int wait_data(int fd, int timeout)
+{
+	struct pollfd fds = {
+		.fd = fd,
+		.events = POLLIN,
+	};
+
+	return poll(&fds, 1, timeout);
+}
+
+/* Receive exactly len bytes on the broker side */
+static void server_recv(uint8_t *buf, size_t len)
+{
+	size_t total;
+	ssize_t ret;
+
+	for (total = 0; total < len; total += ret) {
+		zassert_equal(wait_data(sock, TIMEOUT_MS), 1, "No data");
+
+		ret = recv(sock, buf + total, len - total, 0);
+		zassert_true(ret > 0, "recv failed (%d)", errno);
+	}
+}
+
+static void server_expect(const uint8_t *expected, size_t len)
+{
+	server_recv(server_buf, len);
+	zassert_mem_equal(server_buf, expected, len, "Unexpected packets");
+}
+
+/* Send a packet from the broker and let the client handle it */
+static int server_send(const uint8_t *packet, size_t len)
+{
+	zassert_equal(send(sock, packet, len, 0), len, "send failed");
+
+	zassert_equal(wait_data(client.transport.tcp.sock, TIMEOUT_MS), 1,
+		      "No data for the client");
+
+	return mqtt_input(&client);
+}
+
+static int publish(const char *topic, enum mqtt_qos qos, uint16_t message_id)
+{
+	struct mqtt_publish_param param = {
+		.message.topic.topic.utf8 = (uint8_t *)topic,
+		.message.topic.topic.size = strlen(topic),
+		.message.topic.qos = qos,
+		.message.payload.data = (uint8_t *)"a",
+		.message.payload.len = 1,
+		.message_id = message_id,
+	};
+
+	return mqtt_publish(&client, &param);
+}
+
+static void client_connect(void)
+{
+	/* Protocol level 5 and Topic Alias Maximum 2 */
+	static const uint8_t connect[] = {
+		0x10, 0x15, 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x05, 0x02,
+		0x00, 0x3C, 0x03, 0x22, 0x00, 0x02,
+		0x00, 0x05, 'm', 'q', 't', 't', '5'
+	};
+	/* Receive Maximum 1 and Topic Alias Maximum 2 */
+	static const uint8_t connack[] = {
+		0x20, 0x09, 0x00, 0x00, 0x06, 0x21, 0x00, 0x01,
+		0x22, 0x00, 0x02
+	};
+
+	zassert_equal(mqtt_connect(&client), 0, "mqtt_connect failed");
+
+	sock = accept(s_sock, NULL, NULL);
+	zassert_true(sock >= 0, "accept failed (%d)", errno);
+
+	server_expect(connect, sizeof(connect));
+
+	zassert_equal(server_send(connack, sizeof(connack)), 0,
+		      "mqtt_input failed");
+	zassert_equal(last_evt, MQTT_EVT_CONNACK, "Not connected");
+}
+
+static void test_connect(void)
+{
+	s_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(s_sock >= 0, "Cannot create socket");
+	zassert_equal(bind(s_sock, (struct sockaddr *)&server_addr,
+			   sizeof(server_addr)), 0, "Cannot bind");
+	zassert_equal(listen(s_sock, 1), 0, "Cannot listen");
+
+	mqtt_client_init(&client);
+
+	client.broker = &server_addr;
+	client.evt_cb = evt_cb;
+	client.client_id.utf8 = (uint8_t *)"mqtt5";
+	client.client_id.size = strlen("mqtt5");
+	client.protocol_version = MQTT_VERSION_5_0;
+	client.clean_session = 1U;
+	client.keepalive = 60U;
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.rx_buf = rx_buf;
+	client.rx_buf_size = sizeof(rx_buf);
+	client.tx_buf = tx_buf;
+	client.tx_buf_size = sizeof(tx_buf);
+
+	client_connect();
+
+	zassert_equal(last_connack.prop.receive_maximum, 1,
+		      "Receive Maximum not decoded");
+	zassert_equal(last_connack.prop.topic_alias_maximum, 2,
+		      "Topic Alias Maximum not decoded");
+	zassert_equal(last_connack.prop.maximum_qos, MQTT_QOS_2_EXACTLY_ONCE,
+		      "Default Maximum QoS not set");
+}
+
+static void test_topic_alias_tx(void)
+{
+	static const uint8_t expected[] = {
+		PUBLISH_BIND('1', 1), PUBLISH_ALIAS(1)
+	};
+
+	zassert_equal(publish("t/1", MQTT_QOS_0_AT_MOST_ONCE, 0), 0,
+		      "Publish failed");
+	zassert_equal(publish("t/1", MQTT_QOS_0_AT_MOST_ONCE, 0), 0,
+		      "Publish failed");
+
+	/* The topic is left out once bound */
+	server_expect(expected, sizeof(expected));
+}
+
+static void test_topic_alias_rx(void)
+{
+	static const uint8_t bind[] = {
+		0x30, 0x0A, 0x00, 0x03, 's', '/', '1', 0x03, 0x23, 0x00, 0x01,
+		'x'
+	};
+	static const uint8_t aliased[] = {
+		0x30, 0x07, 0x00, 0x00, 0x03, 0x23, 0x00, 0x01, 'y'
+	};
+
+	zassert_equal(server_send(bind, sizeof(bind)), 0, "mqtt_input failed");
+	zassert_equal(last_evt, MQTT_EVT_PUBLISH, "PUBLISH not notified");
+	zassert_equal(rx_payload, 'x', "Wrong payload");
+
+	rx_topic_len = 0;
+
+	zassert_equal(server_send(aliased, sizeof(aliased)), 0,
+		      "mqtt_input failed");
+	zassert_equal(rx_payload, 'y', "Wrong payload");
+	zassert_equal(rx_topic_len, 3, "Topic not resolved");
+	zassert_mem_equal(rx_topic, "s/1", 3, "Wrong topic");
+}
+
+static void test_receive_maximum(void)
+{
+	static const uint8_t first[] = { PUBLISH_QOS1_ALIAS(1, 1) };
+	static const uint8_t second[] = { PUBLISH_QOS1_ALIAS(2, 1) };
+	/* No matching subscribers, with a user property */
+	static const uint8_t puback[] = {
+		0x40, 0x0B, 0x00, 0x01, 0x10, 0x07,
+		0x26, 0x00, 0x01, 'k', 0x00, 0x01, 'v'
+	};
+	static const uint8_t puback_short[] = { 0x40, 0x02, 0x00, 0x02 };
+
+	zassert_equal(publish("t/1", MQTT_QOS_1_AT_LEAST_ONCE, 1), 0,
+		      "Publish failed");
+	server_expect(first, sizeof(first));
+
+	/* The server accepts a single unacknowledged message */
+	zassert_equal(publish("t/1", MQTT_QOS_1_AT_LEAST_ONCE, 2), -EBUSY,
+		      "Receive Maximum exceeded");
+
+	zassert_equal(server_send(puback, sizeof(puback)), 0,
+		      "mqtt_input failed");
+	zassert_equal(last_evt, MQTT_EVT_PUBACK, "PUBACK not notified");
+	zassert_equal(last_puback.message_id, 1, "Wrong message id");
+	zassert_equal(last_puback.reason_code, MQTT_RC_NO_MATCHING_SUBSCRIBERS,
+		      "Wrong reason code");
+	zassert_equal(last_puback.prop.user_prop_count, 1,
+		      "User property not decoded");
+
+	zassert_equal(publish("t/1", MQTT_QOS_1_AT_LEAST_ONCE, 2), 0,
+		      "Publish failed");
+	server_expect(second, sizeof(second));
+
+	zassert_equal(server_send(puback_short, sizeof(puback_short)), 0,
+		      "mqtt_input failed");
+	zassert_equal(last_puback.reason_code, MQTT_RC_SUCCESS,
+		      "Wrong reason code");
+}
+
+static void test_user_property(void)
+{
+	/* Binds topic "t/2" to alias 2, with user property k=v */
+	static const uint8_t expected[] = {
+		0x30, 0x11, 0x00, 0x03, 't', '/', '2', 0x0A, 0x23, 0x00, 0x02,
+		0x26, 0x00, 0x01, 'k', 0x00, 0x01, 'v', 'a'
+	};
+	struct mqtt_publish_param param = {
+		.message.topic.topic.utf8 = (uint8_t *)"t/2",
+		.message.topic.topic.size = 3,
+		.message.payload.data = (uint8_t *)"a",
+		.message.payload.len = 1,
+		.prop.user_prop = {
+			{
+				.name = MQTT_UTF8_LITERAL("k"),
+				.value = MQTT_UTF8_LITERAL("v"),
+			},
+		},
+		.prop.user_prop_count = 1,
+	};
+
+	zassert_equal(mqtt_publish(&client, &param), 0, "Publish failed");
+	server_expect(expected, sizeof(expected));
+}
+
+static void test_topic_alias_replace(void)
+{
+	/* Both aliases are used, the oldest binding is replaced */
+	static const uint8_t expected[] = {
+		PUBLISH_BIND('3', 1), PUBLISH_BIND('1', 2), PUBLISH_ALIAS(1)
+	};
+
+	zassert_equal(publish("t/3", MQTT_QOS_0_AT_MOST_ONCE, 0), 0,
+		      "Publish failed");
+	zassert_equal(publish("t/1", MQTT_QOS_0_AT_MOST_ONCE, 0), 0,
+		      "Publish failed");
+	zassert_equal(publish("t/3", MQTT_QOS_0_AT_MOST_ONCE, 0), 0,
+		      "Publish failed");
+
+	server_expect(expected, sizeof(expected));
+}
+
+static void test_topic_alias_unbound(void)
+{
+	static const uint8_t unbound[] = {
+		0x30, 0x07, 0x00, 0x00, 0x03, 0x23, 0x00, 0x02, 'z'
+	};
+
+	/* An alias the server never bound is a protocol error */
+	zassert_not_equal(server_send(unbound, sizeof(unbound)), 0,
+			  "Unbound topic alias accepted");
+	zassert_equal(last_evt, MQTT_EVT_DISCONNECT, "Not disconnected");
+
+	close(sock);
+}
+
+static void test_server_disconnect(void)
+{
+	/* Aliases are bound again on the new connection */
+	static const uint8_t expected[] = { PUBLISH_BIND('3', 1) };
+	/* Server shutting down */
+	static const uint8_t disconnect[] = { 0xE0, 0x01, 0x8B };
+
+	client_connect();
+
+	zassert_equal(publish("t/3", MQTT_QOS_0_AT_MOST_ONCE, 0), 0,
+		      "Publish failed");
+	server_expect(expected, sizeof(expected));
+
+	zassert_equal(server_send(disconnect, sizeof(disconnect)),
+		      -ECONNRESET, "DISCONNECT not handled");
+	zassert_equal(last_evt, MQTT_EVT_DISCONNECT, "Not disconnected");
+
+	close(sock);
+	close(s_sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt5,
+			 ztest_unit_test(test_connect),
+			 ztest_unit_test(test_topic_alias_tx),
+			 ztest_unit_test(test_topic_alias_rx),
+			 ztest_unit_test(test_receive_maximum),
+			 ztest_unit_test(test_user_property),
+			 ztest_unit_test(test_topic_alias_replace),
+			 ztest_unit_test(test_topic_alias_unbound),
+			 ztest_unit_test(test_server_disconnect));
+
+	ztest_run_test_suite(mqtt5);
+}
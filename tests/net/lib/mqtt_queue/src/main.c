@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_MQTT_LOG_LEVEL);
+
+#include <ztest.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#define SERVER_PORT 1883
+#define TIMEOUT_MS 1000
+#define NO_DATA_MS 100
+
+/* QoS 0 PUBLISH of "a" on topic "t" */
+#define QOS0_PUBLISH 0x30, 0x04, 0x00, 0x01, 't', 'a'
+
+/* QoS 1 or 2 PUBLISH of "a" on topic "t", with the given flags */
+#define PUBLISH(flags, id) \
+	0x30 | (flags), 0x06, 0x00, 0x01, 't', 0x00, id, 'a'
+
+#define QOS1 0x02
+#define QOS2 0x04
+#define DUP 0x08
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static struct mqtt_client client;
+static uint8_t rx_buf[128];
+static uint8_t tx_buf[128];
+static uint8_t queue_buf[256];
+static uint8_t server_buf[128];
+static int s_sock = -1;
+static int sock = -1;
+
+static enum mqtt_evt_type last_evt;
+
+static void evt_cb(struct mqtt_client *const c, const struct mqtt_evt *evt)
+{
+	last_evt = evt->type;
+}
+
+static int wait_data(int fd, int timeout)
+{
+	struct pollfd fds = {
+		.fd = fd,
+		.events = POLLIN,
+	};
+
+	return poll(&fds, 1, timeout);
+}
+
+/* Receive exactly len bytes on the broker side */
+static void server_recv(uint8_t *buf, size_t len)
+{
+	size_t total;
+	ssize_t ret;
+
+	for (total = 0; total < len; total += ret) {
+		zassert_equal(wait_data(sock, TIMEOUT_MS), 1, "No data");
+
+		ret = recv(sock, buf + total, len - total, 0);
+		zassert_true(ret > 0, "recv failed (%d)", errno);
+	}
+}
+
+static void server_expect(const uint8_t *expected, size_t len)
+{
+	server_recv(server_buf, len);
+	zassert_mem_equal(server_buf, expected, len, "Unexpected packets");
+}
+
+static void server_expect_nothing(void)
+{
+	zassert_equal(wait_data(sock, NO_DATA_MS), 0, "Unexpected data");
+}
+
+/* Send a packet from the broker and let the client handle it */
+static void server_send(const uint8_t *packet, size_t len)
+{
+	zassert_equal(send(sock, packet, len, 0), len, "send failed");
+
+	zassert_equal(wait_data(client.transport.tcp.sock, TIMEOUT_MS), 1,
+		      "No data for the client");
+	zassert_equal(mqtt_input(&client), 0, "mqtt_input failed");
+}
+
+static void server_ack(uint8_t type, uint8_t id)
+{
+	uint8_t packet[] = { type, 0x02, 0x00, id };
+
+	server_send(packet, sizeof(packet));
+}
+
+static void client_connect(void)
+{
+	static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+
+	zassert_equal(mqtt_connect(&client), 0, "mqtt_connect failed");
+
+	sock = accept(s_sock, NULL, NULL);
+	zassert_true(sock >= 0, "accept failed (%d)", errno);
+
+	/* CONNECT, shorter than 128 bytes */
+	server_recv(server_buf, 2);
+	server_recv(server_buf + 2, server_buf[1]);
+
+	server_send(connack, sizeof(connack));
+	zassert_equal(last_evt, MQTT_EVT_CONNACK, "Not connected");
+}
+
+static void queue(enum mqtt_qos qos, uint16_t message_id)
+{
+	struct mqtt_publish_param param = {
+		.message.topic.topic.utf8 = (uint8_t *)"t",
+		.message.topic.topic.size = 1,
+		.message.topic.qos = qos,
+		.message.payload.data = (uint8_t *)"a",
+		.message.payload.len = 1,
+		.message_id = message_id,
+	};
+
+	zassert_equal(mqtt_publish_queued(&client, &param), 0,
+		      "Cannot queue message %u", message_id);
+}
+
+static void test_setup(void)
+{
+	s_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(s_sock >= 0, "Cannot create socket");
+	zassert_equal(bind(s_sock, (struct sockaddr *)&server_addr,
+			   sizeof(server_addr)), 0, "Cannot bind");
+	zassert_equal(listen(s_sock, 1), 0, "Cannot listen");
+
+	mqtt_client_init(&client);
+
+	client.broker = &server_addr;
+	client.evt_cb = evt_cb;
+	client.client_id.utf8 = (uint8_t *)"queue";
+	client.client_id.size = strlen("queue");
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.rx_buf = rx_buf;
+	client.rx_buf_size = sizeof(rx_buf);
+	client.tx_buf = tx_buf;
+	client.tx_buf_size = sizeof(tx_buf);
+	client.queue_buf = queue_buf;
+	client.queue_buf_size = sizeof(queue_buf);
+
+	client_connect();
+}
+
+static void test_batch(void)
+{
+	static const uint8_t expected[] = {
+		QOS0_PUBLISH, QOS0_PUBLISH, QOS0_PUBLISH
+	};
+
+	queue(MQTT_QOS_0_AT_MOST_ONCE, 0);
+	queue(MQTT_QOS_0_AT_MOST_ONCE, 0);
+	queue(MQTT_QOS_0_AT_MOST_ONCE, 0);
+
+	zassert_equal(mqtt_flush(&client), 0, "Flush failed");
+
+	server_expect(expected, sizeof(expected));
+	zassert_equal(client.internal.queue_len, 0,
+		      "QoS 0 messages left in the queue");
+}
+
+static void test_window(void)
+{
+	static const uint8_t first[] = {
+		PUBLISH(QOS1, 1), PUBLISH(QOS1, 2)
+	};
+	static const uint8_t third[] = { PUBLISH(QOS1, 3) };
+
+	queue(MQTT_QOS_1_AT_LEAST_ONCE, 1);
+	queue(MQTT_QOS_1_AT_LEAST_ONCE, 2);
+	queue(MQTT_QOS_1_AT_LEAST_ONCE, 3);
+
+	zassert_equal(mqtt_flush(&client), 0, "Flush failed");
+
+	/* Only two messages can wait for their PUBACK */
+	server_expect(first, sizeof(first));
+	server_expect_nothing();
+
+	server_ack(0x40, 1);
+	server_expect(third, sizeof(third));
+
+	server_ack(0x40, 2);
+	server_ack(0x40, 3);
+
+	zassert_equal(client.internal.queue_len, 0,
+		      "Acknowledged messages left in the queue");
+}
+
+static void test_qos2(void)
+{
+	static const uint8_t publish[] = { PUBLISH(QOS2, 4) };
+	static const uint8_t pubrel[] = { 0x62, 0x02, 0x00, 4 };
+
+	queue(MQTT_QOS_2_EXACTLY_ONCE, 4);
+
+	zassert_equal(mqtt_flush(&client), 0, "Flush failed");
+	server_expect(publish, sizeof(publish));
+
+	/* The library answers PUBREC itself */
+	server_ack(0x50, 4);
+	server_expect(pubrel, sizeof(pubrel));
+	zassert_equal(last_evt, MQTT_EVT_PUBREC, "PUBREC not notified");
+
+	server_ack(0x70, 4);
+	zassert_equal(client.internal.queue_len, 0,
+		      "Completed message left in the queue");
+}
+
+static void test_reconnect(void)
+{
+	static const uint8_t publish[] = { PUBLISH(QOS1, 5) };
+	static const uint8_t resent[] = { PUBLISH(QOS1 | DUP, 5) };
+	static const uint8_t queued[] = { QOS0_PUBLISH };
+
+	queue(MQTT_QOS_1_AT_LEAST_ONCE, 5);
+
+	zassert_equal(mqtt_flush(&client), 0, "Flush failed");
+	server_expect(publish, sizeof(publish));
+
+	/* The connection is lost before the PUBACK */
+	mqtt_abort(&client);
+	close(sock);
+
+	/* Messages can be queued while disconnected */
+	queue(MQTT_QOS_0_AT_MOST_ONCE, 0);
+
+	client_connect();
+
+	server_expect(resent, sizeof(resent));
+	server_expect(queued, sizeof(queued));
+
+	server_ack(0x40, 5);
+	zassert_equal(client.internal.queue_len, 0,
+		      "Acknowledged message left in the queue");
+
+	mqtt_abort(&client);
+	close(sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_queue,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_batch),
+			 ztest_unit_test(test_window),
+			 ztest_unit_test(test_qos2),
+			 ztest_unit_test(test_reconnect));
+
+	ztest_run_test_suite(mqtt_queue);
+}
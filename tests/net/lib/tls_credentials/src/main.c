@@ -164,13 +164,48 @@ static void test_credential_delete(void)
 	zassert_equal(ret, -ENOENT, "Should have failed with ENOENT");
 }
 
+/**
+ * @brief Test credentials_generation_get function
+ *
+ * This test verifies that the generation changes on credential changes only.
+ */
+static void test_credential_internal_generation(void)
+{
+	uint32_t generation;
+	int ret;
+
+	generation = credentials_generation_get();
+
+	/* Failed operations should not change the generation. */
+	ret = tls_credential_delete(invalid_tag, TLS_CREDENTIAL_CA_CERTIFICATE);
+	zassert_equal(ret, -ENOENT, "Should have failed with ENOENT");
+	zassert_equal(credentials_generation_get(), generation,
+		      "Generation changed");
+
+	ret = tls_credential_add(common_tag, TLS_CREDENTIAL_PRIVATE_KEY,
+				 test_server_key, sizeof(test_server_key));
+	zassert_equal(ret, 0, "Failed to add credential %d %d",
+		      common_tag, TLS_CREDENTIAL_PRIVATE_KEY);
+	zassert_not_equal(credentials_generation_get(), generation,
+			  "Generation not changed on add");
+
+	generation = credentials_generation_get();
+
+	ret = tls_credential_delete(common_tag, TLS_CREDENTIAL_PRIVATE_KEY);
+	zassert_equal(ret, 0, "Failed to delete credential %d %d",
+		      common_tag, TLS_CREDENTIAL_PRIVATE_KEY);
+	zassert_not_equal(credentials_generation_get(), generation,
+			  "Generation not changed on delete");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(tls_crecentials_tests,
 		ztest_unit_test(test_credential_add),
 		ztest_unit_test(test_credential_get),
 		ztest_unit_test(test_credential_internal_iterate),
-		ztest_unit_test(test_credential_delete)
+		ztest_unit_test(test_credential_delete),
+		ztest_unit_test(test_credential_internal_generation)
 	);
 
 	ztest_run_test_suite(tls_crecentials_tests);
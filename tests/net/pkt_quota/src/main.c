@@ -0,0 +1,415 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define NET_LOG_LEVEL CONFIG_NET_PKT_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, NET_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/printk.h>
+
+#include <ztest.h>
+
+#include <net/ethernet.h>
+#include <net/dummy.h>
+#include <net/buf.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/net_pkt.h>
+
+#define NET_LOG_ENABLED 1
+#include "net_private.h"
+#include "connection.h"
+#include "ipv4.h"
+#include "udp_internal.h"
+
+#define RX_PKT_QUOTA NET_PKT_QUOTA(CONFIG_NET_PKT_RX_COUNT)
+#define RX_BUF_QUOTA NET_PKT_QUOTA(CONFIG_NET_BUF_RX_COUNT)
+
+/* Three buffers are needed to hold this much data */
+#define BIG_PKT_LEN (2 * CONFIG_NET_BUF_DATA_SIZE + 1)
+
+#define FLOOD_PORT 4242
+#define FLOOD_ROUNDS (3 * CONFIG_NET_PKT_RX_COUNT)
+
+struct net_quota_test {
+	uint8_t mac_addr[sizeof(struct net_eth_addr)];
+};
+
+static struct net_quota_test net_quota_data_a;
+static struct net_quota_test net_quota_data_b;
+
+static struct net_if *iface_a;
+static struct net_if *iface_b;
+
+static struct in_addr in4addr_a = { { { 192, 0, 2, 1 } } };
+static struct in_addr in4addr_b = { { { 192, 0, 2, 2 } } };
+static struct in_addr in4addr_peer = { { { 192, 0, 2, 100 } } };
+
+static struct net_pkt *pkts[CONFIG_NET_PKT_RX_COUNT];
+
+/* Packets received on interface A that its application does not read */
+static struct net_pkt *held[CONFIG_NET_PKT_RX_COUNT];
+static int held_count;
+static int received_b;
+
+static int net_quota_dev_init(const struct device *dev)
+{
+	struct net_quota_test *data = dev->data;
+
+	/* 00-00-5E-00-53-xx Documentation RFC 7042 */
+	data->mac_addr[0] = 0x00;
+	data->mac_addr[1] = 0x00;
+	data->mac_addr[2] = 0x5E;
+	data->mac_addr[3] = 0x00;
+	data->mac_addr[4] = 0x53;
+	data->mac_addr[5] = data == &net_quota_data_a ? 0x01 : 0x02;
+
+	return 0;
+}
+
+static void net_quota_iface_init(struct net_if *iface)
+{
+	struct net_quota_test *data = net_if_get_device(iface)->data;
+
+	net_if_set_link_addr(iface, data->mac_addr, sizeof(data->mac_addr),
+			     NET_LINK_ETHERNET);
+}
+
+static int tester_send(const struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static struct dummy_api net_quota_if_api = {
+	.iface_api.init = net_quota_iface_init,
+	.send = tester_send,
+};
+
+#define _ETH_L2_LAYER DUMMY_L2
+#define _ETH_L2_CTX_TYPE NET_L2_GET_CTX_TYPE(DUMMY_L2)
+
+NET_DEVICE_INIT_INSTANCE(net_quota_test_a, "net_quota_test_a", a,
+			 net_quota_dev_init, device_pm_control_nop,
+			 &net_quota_data_a, NULL,
+			 CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+			 &net_quota_if_api, _ETH_L2_LAYER,
+			 _ETH_L2_CTX_TYPE, 1500);
+
+NET_DEVICE_INIT_INSTANCE(net_quota_test_b, "net_quota_test_b", b,
+			 net_quota_dev_init, device_pm_control_nop,
+			 &net_quota_data_b, NULL,
+			 CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+			 &net_quota_if_api, _ETH_L2_LAYER,
+			 _ETH_L2_CTX_TYPE, 1500);
+
+static void iface_cb(struct net_if *iface, void *user_data)
+{
+	if (net_if_get_device(iface)->data == &net_quota_data_a) {
+		iface_a = iface;
+	} else if (net_if_get_device(iface)->data == &net_quota_data_b) {
+		iface_b = iface;
+	}
+}
+
+/* Allocate RX packets on iface until the allocation is refused */
+static int alloc_until_refused(struct net_if *iface, int first, size_t len)
+{
+	int i;
+
+	for (i = first; i < ARRAY_SIZE(pkts); i++) {
+		pkts[i] = net_pkt_rx_alloc_with_buffer(iface, len, AF_UNSPEC,
+						       0, K_NO_WAIT);
+		if (!pkts[i]) {
+			break;
+		}
+	}
+
+	return i - first;
+}
+
+static void unref_pkts(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pkts); i++) {
+		if (pkts[i]) {
+			net_pkt_unref(pkts[i]);
+			pkts[i] = NULL;
+		}
+	}
+}
+
+static void test_setup(void)
+{
+	net_if_foreach(iface_cb, NULL);
+
+	zassert_not_null(iface_a, "Interface A not found");
+	zassert_not_null(iface_b, "Interface B not found");
+
+	zassert_not_null(net_if_ipv4_addr_add(iface_a, &in4addr_a,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv4 address to interface A");
+	zassert_not_null(net_if_ipv4_addr_add(iface_b, &in4addr_b,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv4 address to interface B");
+}
+
+static void test_pkt_quota(void)
+{
+	int count;
+
+	count = alloc_until_refused(iface_a, 0, 1);
+	zassert_equal(count, RX_PKT_QUOTA, "Allocated %d pkts, quota %d",
+		      count, RX_PKT_QUOTA);
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_pkts), RX_PKT_QUOTA,
+		      "Invalid RX pkt usage");
+
+	/* The other interface is not affected by the flood */
+	count = alloc_until_refused(iface_b, RX_PKT_QUOTA, 1);
+	zassert_equal(count, RX_PKT_QUOTA, "Allocated %d pkts, quota %d",
+		      count, RX_PKT_QUOTA);
+
+	zassert_equal(iface_a->stats.mem.rx.pkts_max, RX_PKT_QUOTA,
+		      "Invalid RX pkt high watermark");
+	zassert_true(iface_a->stats.mem.rx.quota_drop > 0,
+		     "Quota drop not counted");
+
+	unref_pkts();
+
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_pkts), 0,
+		      "RX pkts not released");
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_bufs), 0,
+		      "RX bufs not released");
+	zassert_equal(atomic_get(&iface_b->pkt_usage.rx_pkts), 0,
+		      "RX pkts not released");
+}
+
+static void test_buf_quota(void)
+{
+	int count;
+
+	count = alloc_until_refused(iface_a, 0, BIG_PKT_LEN);
+	zassert_equal(count, RX_BUF_QUOTA / 3, "Allocated %d pkts", count);
+	zassert_true(atomic_get(&iface_a->pkt_usage.rx_bufs) <= RX_BUF_QUOTA,
+		     "RX buf quota exceeded");
+
+	/* A refused buffer allocation does not keep its packet */
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_pkts), count,
+		      "Invalid RX pkt usage");
+
+	count = alloc_until_refused(iface_b, count, 1);
+	zassert_true(count > 0, "Interface B starved of buffers");
+
+	unref_pkts();
+
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_bufs), 0,
+		      "RX bufs not released");
+	zassert_equal(atomic_get(&iface_b->pkt_usage.rx_bufs), 0,
+		      "RX bufs not released");
+}
+
+static void test_rx_reserve(void)
+{
+	uint32_t reserve_drop = iface_a->stats.mem.reserve_drop;
+	struct net_pkt *pkt;
+	int count;
+
+	/* Use up all the RX packets but the reserve */
+	count = alloc_until_refused(iface_a, 0, 1);
+	count += alloc_until_refused(iface_b, count, 1);
+	zassert_equal(count, CONFIG_NET_PKT_RX_COUNT, "Pool not exhausted");
+
+	net_pkt_unref(pkts[0]);
+	net_pkt_unref(pkts[1]);
+	pkts[0] = NULL;
+	pkts[1] = NULL;
+
+	/* Only one packet is free once this one is taken */
+	pkt = net_pkt_rx_alloc_with_buffer(iface_a, 1, AF_UNSPEC, 0,
+					   K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	net_pkt_set_priority(pkt, NET_PRIORITY_BE);
+	zassert_equal(net_recv_data(iface_a, pkt), -ENOBUFS,
+		      "Best effort pkt received from the reserve");
+	zassert_equal(iface_a->stats.mem.reserve_drop, reserve_drop + 1,
+		      "Reserve drop not counted");
+
+	net_pkt_set_priority(pkt, NET_PRIORITY_NC);
+	zassert_equal(net_recv_data(iface_a, pkt), 0,
+		      "Network control pkt not received");
+
+	/* Let the RX thread consume the pkt */
+	k_sleep(K_MSEC(10));
+
+	unref_pkts();
+}
+
+static void test_frag_quota(void)
+{
+	struct net_buf *frag;
+	int count = 0;
+
+	pkts[0] = net_pkt_rx_alloc_with_buffer(iface_a, 1, AF_UNSPEC, 0,
+					       K_NO_WAIT);
+	zassert_not_null(pkts[0], "Cannot allocate pkt");
+
+	/* Fragments added by hand are charged like the initial buffer */
+	while ((frag = net_pkt_get_frag(pkts[0], K_NO_WAIT))) {
+		net_pkt_frag_add(pkts[0], frag);
+		count++;
+	}
+
+	zassert_equal(count, RX_BUF_QUOTA - 1, "Got %d fragments", count);
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_bufs), RX_BUF_QUOTA,
+		      "Invalid RX buf usage");
+
+	unref_pkts();
+
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_bufs), 0,
+		      "RX bufs not released");
+}
+
+static void test_clone_quota(void)
+{
+	struct net_pkt *clone;
+	int count;
+
+	count = alloc_until_refused(iface_a, 0, 1);
+	zassert_equal(count, RX_PKT_QUOTA, "Allocated %d pkts", count);
+
+	/* A clone is charged to the interface of the original */
+	clone = net_pkt_clone(pkts[0], K_NO_WAIT);
+	zassert_is_null(clone, "Clone allocated over the quota");
+
+	net_pkt_unref(pkts[0]);
+	pkts[0] = NULL;
+
+	clone = net_pkt_clone(pkts[1], K_NO_WAIT);
+	zassert_not_null(clone, "Cannot clone pkt");
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_pkts), RX_PKT_QUOTA,
+		      "Clone not charged");
+
+	net_pkt_unref(clone);
+	unref_pkts();
+
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_pkts), 0,
+		      "RX pkts not released");
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_bufs), 0,
+		      "RX bufs not released");
+}
+
+static enum net_verdict flood_received(struct net_conn *conn,
+				       struct net_pkt *pkt,
+				       union net_ip_header *ip_hdr,
+				       union net_proto_header *proto_hdr,
+				       void *user_data)
+{
+	if (net_pkt_iface(pkt) == iface_a && held_count < ARRAY_SIZE(held)) {
+		held[held_count++] = pkt;
+	} else if (net_pkt_iface(pkt) == iface_a) {
+		net_pkt_unref(pkt);
+	} else {
+		received_b++;
+		net_pkt_unref(pkt);
+	}
+
+	return NET_OK;
+}
+
+static int send_udp(struct net_if *iface, struct in_addr *dst)
+{
+	struct net_pkt *pkt;
+	int ret;
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, 1, AF_INET, IPPROTO_UDP,
+					   K_NO_WAIT);
+	if (!pkt) {
+		return -ENOBUFS;
+	}
+
+	if (net_ipv4_create(pkt, &in4addr_peer, dst) ||
+	    net_udp_create(pkt, htons(FLOOD_PORT), htons(FLOOD_PORT)) ||
+	    net_pkt_write_u8(pkt, 0)) {
+		net_pkt_unref(pkt);
+		return -EINVAL;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_ipv4_finalize(pkt, IPPROTO_UDP);
+
+	ret = net_recv_data(iface, pkt);
+	if (ret < 0) {
+		net_pkt_unref(pkt);
+	}
+
+	return ret;
+}
+
+/* Interface A is flooded with packets nobody reads, while interface B
+ * keeps receiving at its own pace.
+ */
+static void test_flood(void)
+{
+	struct net_conn_handle *handle;
+	int refused_a = 0;
+	int i;
+
+	zassert_equal(net_conn_register(IPPROTO_UDP, AF_INET, NULL, NULL,
+					FLOOD_PORT, FLOOD_PORT,
+					flood_received, NULL, &handle), 0,
+		      "Cannot register UDP handler");
+
+	for (i = 0; i < FLOOD_ROUNDS; i++) {
+		if (send_udp(iface_a, &in4addr_a) < 0) {
+			refused_a++;
+		}
+
+		zassert_equal(send_udp(iface_b, &in4addr_b), 0,
+			      "Interface B starved in round %d", i);
+
+		/* Let the RX thread deliver the pkts */
+		k_sleep(K_MSEC(10));
+	}
+
+	zassert_equal(held_count, RX_PKT_QUOTA, "Interface A held %d pkts",
+		      held_count);
+	zassert_equal(refused_a, FLOOD_ROUNDS - RX_PKT_QUOTA,
+		      "Interface A not throttled");
+	zassert_equal(received_b, FLOOD_ROUNDS, "Interface B received %d pkts",
+		      received_b);
+
+	net_conn_unregister(handle);
+
+	for (i = 0; i < held_count; i++) {
+		net_pkt_unref(held[i]);
+	}
+
+	zassert_equal(atomic_get(&iface_a->pkt_usage.rx_pkts), 0,
+		      "RX pkts not released");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_pkt_quota_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_pkt_quota),
+			 ztest_unit_test(test_buf_quota),
+			 ztest_unit_test(test_frag_quota),
+			 ztest_unit_test(test_clone_quota),
+			 ztest_unit_test(test_flood),
+			 ztest_unit_test(test_rx_reserve));
+
+	ztest_run_test_suite(net_pkt_quota_test);
+}
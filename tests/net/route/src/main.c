@@ -473,6 +473,100 @@ static void test_route_del_many(void)
 	}
 }
 
+static void check_lookup(struct in6_addr *dst,
+			 struct net_route_entry *expected)
+{
+	struct net_route_entry *found;
+
+	found = net_route_lookup(my_iface, dst);
+	zassert_equal_ptr(found, expected, "Wrong route for %s",
+			  net_sprint_ipv6_addr(dst));
+}
+
+static void test_route_longest_prefix_match(void)
+{
+	struct in6_addr other_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					   0, 0, 0, 0, 0, 0, 0xab, 0xcd } } };
+	struct in6_addr other_net = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 1, 0, 0,
+					  0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+	struct in6_addr unknown = { { { 0x20, 0x01, 0x0d, 0xb9, 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+	struct net_route_entry *route_32, *route_64, *route_112, *route_128;
+
+	route_32 = net_route_add(my_iface, &generic_addr, 32, &peer_addr);
+	route_112 = net_route_add(my_iface, &generic_addr, 112, &peer_addr);
+	route_128 = net_route_add(my_iface, &dest_addresses[0], 128,
+				  &peer_addr);
+	route_64 = net_route_add(my_iface, &generic_addr, 64, &peer_addr);
+
+	zassert_not_null(route_32, "Route add failed");
+	zassert_not_null(route_64, "Route add failed");
+	zassert_not_null(route_112, "Route add failed");
+	zassert_not_null(route_128, "Route add failed");
+
+	/* Adding the same prefix again must not replace a shorter one */
+	zassert_equal_ptr(net_route_add(my_iface, &generic_addr, 64,
+					&peer_addr), route_64,
+			  "Route add again failed");
+
+	check_lookup(&dest_addresses[0], route_128);
+	check_lookup(&dest_addresses[1], route_112);
+	check_lookup(&other_addr, route_64);
+	check_lookup(&other_net, route_32);
+	check_lookup(&unknown, NULL);
+
+	zassert_is_null(net_route_lookup(peer_iface, &dest_addresses[0]),
+			"Route found for another interface");
+
+	zassert_false(net_route_del(route_112), "Route del failed");
+	check_lookup(&dest_addresses[1], route_64);
+	check_lookup(&dest_addresses[0], route_128);
+
+	zassert_false(net_route_del(route_128), "Route del failed");
+	check_lookup(&dest_addresses[0], route_64);
+
+	zassert_false(net_route_del(route_64), "Route del failed");
+	check_lookup(&dest_addresses[0], route_32);
+	check_lookup(&other_addr, route_32);
+
+	zassert_false(net_route_del(route_32), "Route del failed");
+	check_lookup(&dest_addresses[0], NULL);
+	check_lookup(&other_net, NULL);
+}
+
+static void test_route_del_least_recently_used(void)
+{
+	struct net_route_entry *extra;
+	struct in6_addr extra_addr;
+	int i;
+
+	test_route_add_many();
+
+	/* All but the first route are used, so the first one is removed
+	 * when the table is full.
+	 */
+	for (i = 1; i < max_routes; i++) {
+		check_lookup(&dest_addresses[i], test_routes[i]);
+	}
+
+	net_ipaddr_copy(&extra_addr, &generic_addr);
+	extra_addr.s6_addr[14] = max_routes + 1;
+
+	extra = net_route_add(my_iface, &extra_addr, 128, &peer_addr);
+	zassert_not_null(extra, "Route add failed");
+
+	check_lookup(&dest_addresses[0], NULL);
+	check_lookup(&extra_addr, extra);
+
+	for (i = 1; i < max_routes; i++) {
+		check_lookup(&dest_addresses[i], test_routes[i]);
+		zassert_false(net_route_del(test_routes[i]),
+			      "Route del failed");
+	}
+
+	zassert_false(net_route_del(extra), "Route del failed");
+}
+
 /*test case main entry*/
 void test_main(void)
 {
@@ -492,6 +586,8 @@ void test_main(void)
 			ztest_unit_test(test_route_del_nexthop_again),
 			ztest_unit_test(test_populate_nbr_cache),
 			ztest_unit_test(test_route_add_many),
-			ztest_unit_test(test_route_del_many));
+			ztest_unit_test(test_route_del_many),
+			ztest_unit_test(test_route_longest_prefix_match),
+			ztest_unit_test(test_route_del_least_recently_used));
 	ztest_run_test_suite(test_route);
 }
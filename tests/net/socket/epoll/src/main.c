@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <stdio.h>
+#include <ztest_assert.h>
+
+#include <net/socket.h>
+#include <sys/fdtable.h>
+
+#include "../../socket_helpers.h"
+
+#define STRLEN(buf) (sizeof(buf) - 1)
+
+#define TEST_STR_SMALL "test"
+
+#define SERVER_PORT 4242
+#define CLIENT_PORT 9898
+
+/* Time for a packet to go through the loopback interface */
+#define WAIT_MS 100
+
+/* On QEMU, a wait takes +10ms from the requested time. */
+#define FUZZ 10
+
+static int c_sock;
+static int s_sock;
+static int epfd;
+
+static void epoll_setup(void)
+{
+	struct sockaddr_in6 c_addr;
+	struct sockaddr_in6 s_addr;
+	int res;
+
+	prepare_sock_udp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, CLIENT_PORT,
+			    &c_sock, &c_addr);
+	prepare_sock_udp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, SERVER_PORT,
+			    &s_sock, &s_addr);
+
+	res = bind(s_sock, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "bind failed");
+
+	res = connect(c_sock, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "connect failed");
+
+	epfd = epoll_create1(0);
+	zassert_true(epfd >= 0, "epoll_create1 failed");
+}
+
+static void epoll_teardown(void)
+{
+	zassert_equal(close(epfd), 0, "close failed");
+	zassert_equal(close(c_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+}
+
+static void epoll_add(int fd, uint32_t events)
+{
+	struct epoll_event ev = {
+		.events = events,
+		.data.fd = fd,
+	};
+
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev), 0,
+		      "epoll_ctl failed");
+}
+
+static void send_small(void)
+{
+	ssize_t len;
+
+	len = send(c_sock, TEST_STR_SMALL, STRLEN(TEST_STR_SMALL), 0);
+	zassert_equal(len, STRLEN(TEST_STR_SMALL), "send failed");
+}
+
+static int drain(int sock)
+{
+	char buf[10];
+	int count = 0;
+
+	while (recv(sock, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+		count++;
+	}
+
+	zassert_equal(errno, EAGAIN, "recv failed");
+
+	return count;
+}
+
+static void check_ready(int timeout, int fd, uint32_t events)
+{
+	struct epoll_event ev[2];
+	int res;
+
+	res = epoll_wait(epfd, ev, ARRAY_SIZE(ev), timeout);
+	zassert_equal(res, 1, "fd not ready");
+	zassert_equal(ev[0].data.fd, fd, "wrong fd");
+	zassert_equal(ev[0].events, events, "wrong events");
+}
+
+static void check_not_ready(void)
+{
+	struct epoll_event ev[2];
+
+	zassert_equal(epoll_wait(epfd, ev, ARRAY_SIZE(ev), 0), 0,
+		      "fd ready");
+}
+
+void test_epoll_level_triggered(void)
+{
+	epoll_setup();
+	epoll_add(s_sock, EPOLLIN);
+
+	check_not_ready();
+
+	send_small();
+	check_ready(WAIT_MS, s_sock, EPOLLIN);
+
+	/* Reported again as long as it is readable */
+	check_ready(0, s_sock, EPOLLIN);
+
+	zassert_equal(drain(s_sock), 1, "");
+	check_not_ready();
+
+	epoll_teardown();
+}
+
+void test_epoll_edge_triggered(void)
+{
+	epoll_setup();
+	epoll_add(s_sock, EPOLLIN | EPOLLET);
+
+	send_small();
+	check_ready(WAIT_MS, s_sock, EPOLLIN);
+
+	/* Reported once, even though it is still readable */
+	check_not_ready();
+
+	send_small();
+	check_ready(WAIT_MS, s_sock, EPOLLIN);
+	check_not_ready();
+
+	zassert_equal(drain(s_sock), 2, "");
+
+	epoll_teardown();
+}
+
+void test_epoll_oneshot(void)
+{
+	struct epoll_event ev = {
+		.events = EPOLLIN | EPOLLONESHOT,
+		.data.u32 = 1234,
+	};
+	struct epoll_event out;
+
+	epoll_setup();
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_ADD, s_sock, &ev), 0, "");
+
+	send_small();
+	zassert_equal(epoll_wait(epfd, &out, 1, WAIT_MS), 1, "");
+	zassert_equal(out.data.u32, 1234, "wrong data");
+
+	/* Disabled after the first event */
+	send_small();
+	k_msleep(WAIT_MS);
+	check_not_ready();
+
+	/* Re-armed by EPOLL_CTL_MOD, which also changes the data */
+	ev.data.fd = s_sock;
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_MOD, s_sock, &ev), 0, "");
+	check_ready(0, s_sock, EPOLLIN);
+	check_not_ready();
+
+	zassert_equal(drain(s_sock), 2, "");
+
+	epoll_teardown();
+}
+
+void test_epoll_ctl(void)
+{
+	struct epoll_event ev = { .events = EPOLLIN };
+
+	epoll_setup();
+
+	epoll_add(s_sock, EPOLLIN);
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_ADD, s_sock, &ev), -1, "");
+	zassert_equal(errno, EEXIST, "");
+
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_MOD, c_sock, &ev), -1, "");
+	zassert_equal(errno, ENOENT, "");
+
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_DEL, s_sock, NULL), 0, "");
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_DEL, s_sock, NULL), -1, "");
+	zassert_equal(errno, ENOENT, "");
+
+	/* Unregistered sockets are not reported */
+	send_small();
+	k_msleep(WAIT_MS);
+	check_not_ready();
+	zassert_equal(drain(s_sock), 1, "");
+
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_ADD, epfd, &ev), -1, "");
+	zassert_equal(errno, EINVAL, "");
+
+	zassert_equal(epoll_ctl(s_sock, EPOLL_CTL_ADD, c_sock, &ev), -1, "");
+	zassert_equal(errno, EINVAL, "");
+
+	zassert_equal(epoll_ctl(epfd, EPOLL_CTL_ADD, -1, &ev), -1, "");
+	zassert_equal(errno, EBADF, "");
+
+	zassert_equal(epoll_wait(epfd, &ev, 0, 0), -1, "");
+	zassert_equal(errno, EINVAL, "");
+
+	epoll_teardown();
+}
+
+void test_epoll_close(void)
+{
+	struct sockaddr_in6 addr;
+	int sock;
+	int fd;
+
+	epoll_setup();
+	epoll_add(c_sock, EPOLLIN);
+
+	/* A closed file descriptor is removed from the instance */
+	fd = c_sock;
+	zassert_equal(close(c_sock), 0, "close failed");
+	check_not_ready();
+
+	prepare_sock_udp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, CLIENT_PORT,
+			    &sock, &addr);
+	zassert_equal(sock, fd, "fd not reused");
+	epoll_add(sock, EPOLLIN);
+	c_sock = sock;
+
+	epoll_teardown();
+}
+
+void test_epoll_timeout(void)
+{
+	struct epoll_event ev;
+	uint32_t tstamp;
+
+	epoll_setup();
+	epoll_add(s_sock, EPOLLIN);
+
+	tstamp = k_uptime_get_32();
+	zassert_equal(epoll_wait(epfd, &ev, 1, 0), 0, "");
+	zassert_true(k_uptime_get_32() - tstamp <= FUZZ, "");
+
+	tstamp = k_uptime_get_32();
+	zassert_equal(epoll_wait(epfd, &ev, 1, 30), 0, "");
+	tstamp = k_uptime_get_32() - tstamp;
+	zassert_true(tstamp >= 30U && tstamp <= 30 + FUZZ * 2, "");
+
+	epoll_teardown();
+}
+
+static struct k_delayed_work send_work;
+
+static void send_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	send_small();
+}
+
+void test_epoll_blocking_wait(void)
+{
+	epoll_setup();
+	epoll_add(s_sock, EPOLLIN | EPOLLET);
+	check_not_ready();
+
+	k_delayed_work_init(&send_work, send_work_handler);
+	k_delayed_work_submit(&send_work, K_MSEC(10));
+
+	check_ready(-1, s_sock, EPOLLIN);
+	zassert_equal(drain(s_sock), 1, "");
+
+	epoll_teardown();
+}
+
+void test_epoll_socketpair(void)
+{
+	int sv[2];
+	ssize_t len;
+	char buf[10];
+
+	epfd = epoll_create1(0);
+	zassert_true(epfd >= 0, "epoll_create1 failed");
+
+	zassert_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0, "");
+	epoll_add(sv[1], EPOLLIN);
+	epoll_add(sv[0], EPOLLOUT | EPOLLET);
+
+	check_ready(0, sv[0], EPOLLOUT);
+	check_not_ready();
+
+	len = send(sv[0], TEST_STR_SMALL, STRLEN(TEST_STR_SMALL), 0);
+	zassert_equal(len, STRLEN(TEST_STR_SMALL), "send failed");
+	check_ready(0, sv[1], EPOLLIN);
+
+	len = recv(sv[1], buf, sizeof(buf), 0);
+	zassert_equal(len, STRLEN(TEST_STR_SMALL), "recv failed");
+
+	/* The read notifies the writer, which is still writable */
+	check_ready(0, sv[0], EPOLLOUT);
+	check_not_ready();
+
+	/* Closing one end hangs up the other */
+	zassert_equal(close(sv[0]), 0, "close failed");
+	check_ready(0, sv[1], EPOLLIN | EPOLLHUP);
+
+	zassert_equal(close(sv[1]), 0, "close failed");
+	zassert_equal(close(epfd), 0, "close failed");
+}
+
+void test_epoll_accept(void)
+{
+	struct sockaddr_in6 c_addr;
+	struct sockaddr_in6 s_addr;
+	struct sockaddr addr;
+	socklen_t addrlen = sizeof(addr);
+	int c_sock_tcp;
+	int s_sock_tcp;
+	int new_sock;
+	int res;
+
+	prepare_sock_tcp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, CLIENT_PORT,
+			    &c_sock_tcp, &c_addr);
+	prepare_sock_tcp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, SERVER_PORT,
+			    &s_sock_tcp, &s_addr);
+
+	res = bind(s_sock_tcp, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "bind failed");
+
+	res = listen(s_sock_tcp, 0);
+	zassert_equal(res, 0, "listen failed");
+
+	epfd = epoll_create1(0);
+	zassert_true(epfd >= 0, "epoll_create1 failed");
+	epoll_add(s_sock_tcp, EPOLLIN);
+	check_not_ready();
+
+	res = connect(c_sock_tcp, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "connect failed");
+
+	check_ready(WAIT_MS, s_sock_tcp, EPOLLIN);
+
+	new_sock = accept(s_sock_tcp, &addr, &addrlen);
+	zassert_true(new_sock >= 0, "accept failed");
+
+	/* The accepted socket notifies its own readiness */
+	epoll_add(new_sock, EPOLLIN);
+	res = send(c_sock_tcp, TEST_STR_SMALL, STRLEN(TEST_STR_SMALL), 0);
+	zassert_equal(res, STRLEN(TEST_STR_SMALL), "send failed");
+	check_ready(WAIT_MS, new_sock, EPOLLIN);
+
+	zassert_equal(close(epfd), 0, "close failed");
+	zassert_equal(close(new_sock), 0, "close failed");
+	zassert_equal(close(c_sock_tcp), 0, "close failed");
+	zassert_equal(close(s_sock_tcp), 0, "close failed");
+
+	/* Let the TCP connection close */
+	k_msleep(WAIT_MS);
+}
+
+/* The receive window of the native TCP, which the peer fills */
+#define TCP_WINDOW 1280
+
+/* A TCP socket is writable again, and notifies it, once the peer has
+ * acknowledged the data which filled its window.
+ */
+void test_epoll_tcp_writable(void)
+{
+	static char buf[TCP_WINDOW];
+	struct sockaddr_in6 c_addr;
+	struct sockaddr_in6 s_addr;
+	struct sockaddr addr;
+	socklen_t addrlen = sizeof(addr);
+	int c_sock_tcp;
+	int s_sock_tcp;
+	int new_sock;
+	size_t len;
+	int res;
+
+	prepare_sock_tcp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, CLIENT_PORT,
+			    &c_sock_tcp, &c_addr);
+	prepare_sock_tcp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, SERVER_PORT,
+			    &s_sock_tcp, &s_addr);
+
+	res = bind(s_sock_tcp, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "bind failed");
+
+	res = listen(s_sock_tcp, 0);
+	zassert_equal(res, 0, "listen failed");
+
+	res = connect(c_sock_tcp, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "connect failed");
+
+	new_sock = accept(s_sock_tcp, &addr, &addrlen);
+	zassert_true(new_sock >= 0, "accept failed");
+
+	epfd = epoll_create1(0);
+	zassert_true(epfd >= 0, "epoll_create1 failed");
+	epoll_add(c_sock_tcp, EPOLLOUT | EPOLLET);
+	check_ready(0, c_sock_tcp, EPOLLOUT);
+	check_not_ready();
+
+	res = send(c_sock_tcp, buf, sizeof(buf), MSG_DONTWAIT);
+	zassert_equal(res, sizeof(buf), "send failed");
+	check_ready(WAIT_MS, c_sock_tcp, EPOLLOUT);
+
+	for (len = 0; len < sizeof(buf); len += res) {
+		res = recv(new_sock, buf, sizeof(buf) - len, 0);
+		zassert_true(res > 0, "recv failed");
+	}
+
+	zassert_equal(close(epfd), 0, "close failed");
+	zassert_equal(close(new_sock), 0, "close failed");
+	zassert_equal(close(c_sock_tcp), 0, "close failed");
+	zassert_equal(close(s_sock_tcp), 0, "close failed");
+
+	/* Let the TCP connection close */
+	k_msleep(WAIT_MS);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_epoll,
+			 ztest_unit_test(test_epoll_level_triggered),
+			 ztest_unit_test(test_epoll_edge_triggered),
+			 ztest_unit_test(test_epoll_oneshot),
+			 ztest_unit_test(test_epoll_ctl),
+			 ztest_unit_test(test_epoll_close),
+			 ztest_unit_test(test_epoll_timeout),
+			 ztest_unit_test(test_epoll_blocking_wait),
+			 ztest_unit_test(test_epoll_socketpair),
+			 ztest_unit_test(test_epoll_accept),
+			 ztest_unit_test(test_epoll_tcp_writable));
+
+	ztest_run_test_suite(socket_epoll);
+}
@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <ztest_assert.h>
+
+#include <fs/fs.h>
+#include <net/socket.h>
+#include <sys/fdtable.h>
+
+#include "../../socket_helpers.h"
+
+#define SERVER_PORT 4242
+#define CLIENT_PORT 9898
+
+#define FILE_SIZE 6000
+
+/* Time for a packet to go through the loopback interface */
+#define WAIT_MS 100
+
+/* A read-only file descriptor backed by a memory buffer */
+struct mem_file {
+	const uint8_t *data;
+	size_t size;
+	off_t pos;
+	bool seekable;
+};
+
+extern struct k_mem_slab sendfile_chunks;
+
+static uint8_t file_data[FILE_SIZE];
+static uint8_t rx_buf[FILE_SIZE];
+static struct mem_file mem_file;
+
+static ssize_t mem_file_read(void *obj, void *buf, size_t sz)
+{
+	struct mem_file *file = obj;
+
+	sz = MIN(sz, file->size - file->pos);
+	memcpy(buf, file->data + file->pos, sz);
+	file->pos += sz;
+
+	return sz;
+}
+
+static ssize_t mem_file_write(void *obj, const void *buf, size_t sz)
+{
+	errno = EBADF;
+	return -1;
+}
+
+static int mem_file_close(void *obj)
+{
+	return 0;
+}
+
+static int mem_file_ioctl(void *obj, unsigned int request, va_list args)
+{
+	struct mem_file *file = obj;
+	off_t offset;
+	int whence;
+
+	if (request != ZFD_IOCTL_LSEEK || !file->seekable) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	offset = va_arg(args, off_t);
+	whence = va_arg(args, int);
+
+	if (whence == FS_SEEK_CUR) {
+		offset += file->pos;
+	} else if (whence == FS_SEEK_END) {
+		offset += file->size;
+	}
+
+	if (offset < 0 || offset > file->size) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	file->pos = offset;
+
+	return offset;
+}
+
+static const struct fd_op_vtable mem_file_vtable = {
+	.read = mem_file_read,
+	.write = mem_file_write,
+	.close = mem_file_close,
+	.ioctl = mem_file_ioctl,
+};
+
+static int mem_file_open(bool seekable)
+{
+	int fd;
+
+	mem_file.data = file_data;
+	mem_file.size = sizeof(file_data);
+	mem_file.pos = 0;
+	mem_file.seekable = seekable;
+
+	fd = z_reserve_fd();
+	zassert_true(fd >= 0, "cannot reserve fd");
+	z_finalize_fd(fd, &mem_file, &mem_file_vtable);
+
+	return fd;
+}
+
+static void recv_all(int sock, size_t len)
+{
+	size_t received = 0;
+	ssize_t ret;
+
+	while (received < len) {
+		ret = recv(sock, rx_buf + received, len - received, 0);
+		zassert_true(ret > 0, "recv failed");
+		received += ret;
+	}
+}
+
+static void tcp_connect(int *c_sock, int *s_sock, int *new_sock)
+{
+	struct sockaddr_in6 c_addr;
+	struct sockaddr_in6 s_addr;
+	struct sockaddr addr;
+	socklen_t addrlen = sizeof(addr);
+	int res;
+
+	prepare_sock_tcp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, CLIENT_PORT,
+			    c_sock, &c_addr);
+	prepare_sock_tcp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, SERVER_PORT,
+			    s_sock, &s_addr);
+
+	res = bind(*s_sock, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "bind failed");
+
+	res = listen(*s_sock, 0);
+	zassert_equal(res, 0, "listen failed");
+
+	res = connect(*c_sock, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "connect failed");
+
+	*new_sock = accept(*s_sock, &addr, &addrlen);
+	zassert_true(*new_sock >= 0, "accept failed");
+}
+
+static void tcp_close(int c_sock, int s_sock, int new_sock)
+{
+	zassert_equal(close(new_sock), 0, "close failed");
+	zassert_equal(close(c_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+
+	/* Let the TCP connection close */
+	k_msleep(WAIT_MS);
+}
+
+static void test_sendfile_setup(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(file_data); i++) {
+		file_data[i] = i % 251;
+	}
+}
+
+void test_sendfile_tcp(void)
+{
+	int c_sock, s_sock, new_sock;
+	int fd;
+	ssize_t ret;
+
+	test_sendfile_setup();
+	tcp_connect(&c_sock, &s_sock, &new_sock);
+	fd = mem_file_open(true);
+
+	ret = sendfile(new_sock, fd, NULL, FILE_SIZE);
+	zassert_equal(ret, FILE_SIZE, "sendfile failed");
+	zassert_equal(mem_file.pos, FILE_SIZE, "file position not advanced");
+
+	recv_all(c_sock, FILE_SIZE);
+	zassert_mem_equal(rx_buf, file_data, FILE_SIZE, "invalid data");
+
+	/* Nothing more is sent at the end of the file */
+	ret = sendfile(new_sock, fd, NULL, FILE_SIZE);
+	zassert_equal(ret, 0, "sendfile at EOF failed");
+
+	zassert_equal(close(fd), 0, "close failed");
+	tcp_close(c_sock, s_sock, new_sock);
+}
+
+void test_sendfile_offset(void)
+{
+	int c_sock, s_sock, new_sock;
+	off_t offset = 1000;
+	int fd;
+	ssize_t ret;
+
+	tcp_connect(&c_sock, &s_sock, &new_sock);
+	fd = mem_file_open(true);
+	mem_file.pos = 10;
+
+	ret = sendfile(new_sock, fd, &offset, 2000);
+	zassert_equal(ret, 2000, "sendfile failed");
+	zassert_equal(offset, 3000, "offset not advanced");
+	zassert_equal(mem_file.pos, 10, "file position changed");
+
+	recv_all(c_sock, 2000);
+	zassert_mem_equal(rx_buf, file_data + 1000, 2000, "invalid data");
+
+	/* Only the remaining part of the file is sent */
+	ret = sendfile(new_sock, fd, &offset, FILE_SIZE);
+	zassert_equal(ret, FILE_SIZE - 3000, "sendfile failed");
+	zassert_equal(offset, FILE_SIZE, "offset not advanced");
+
+	recv_all(c_sock, FILE_SIZE - 3000);
+	zassert_mem_equal(rx_buf, file_data + 3000, FILE_SIZE - 3000,
+			  "invalid data");
+
+	zassert_equal(close(fd), 0, "close failed");
+	tcp_close(c_sock, s_sock, new_sock);
+}
+
+void test_sendfile_socketpair(void)
+{
+	off_t offset = 100;
+	int sv[2];
+	int fd;
+	ssize_t ret;
+
+	zassert_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0,
+		      "socketpair failed");
+	fd = mem_file_open(true);
+
+	/* Not a network socket, the data is copied */
+	ret = sendfile(sv[0], fd, &offset, 50);
+	zassert_equal(ret, 50, "sendfile failed");
+	zassert_equal(offset, 150, "offset not advanced");
+
+	ret = recv(sv[1], rx_buf, sizeof(rx_buf), 0);
+	zassert_equal(ret, 50, "recv failed");
+	zassert_mem_equal(rx_buf, file_data + 100, 50, "invalid data");
+
+	zassert_equal(close(fd), 0, "close failed");
+	zassert_equal(close(sv[0]), 0, "close failed");
+	zassert_equal(close(sv[1]), 0, "close failed");
+}
+
+void test_sendfile_errors(void)
+{
+	off_t offset = 0;
+	int sv[2];
+	int fd;
+	ssize_t ret;
+
+	zassert_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0,
+		      "socketpair failed");
+	fd = mem_file_open(false);
+
+	/* An offset needs a seekable file */
+	ret = sendfile(sv[0], fd, &offset, 200);
+	zassert_equal(ret, -1, "sendfile succeeded");
+	zassert_equal(errno, ESPIPE, "invalid errno");
+
+	ret = sendfile(sv[0], fd + 1, NULL, 200);
+	zassert_equal(ret, -1, "sendfile succeeded");
+	zassert_equal(errno, EBADF, "invalid errno");
+
+	zassert_equal(close(fd), 0, "close failed");
+	zassert_equal(close(sv[0]), 0, "close failed");
+	zassert_equal(close(sv[1]), 0, "close failed");
+}
+
+void test_sendfile_nonblock(void)
+{
+	void *chunks[CONFIG_NET_SOCKETS_SENDFILE_CHUNKS];
+	int sv[2];
+	int fd;
+	int i;
+	ssize_t ret;
+
+	zassert_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0,
+		      "socketpair failed");
+	zassert_equal(fcntl(sv[0], F_SETFL, O_NONBLOCK), 0, "fcntl failed");
+	fd = mem_file_open(true);
+
+	for (i = 0; i < ARRAY_SIZE(chunks); i++) {
+		zassert_equal(k_mem_slab_alloc(&sendfile_chunks, &chunks[i],
+					       K_NO_WAIT), 0,
+			      "cannot take chunk");
+	}
+
+	/* No chunk to copy the data, a non-blocking socket does not wait */
+	ret = sendfile(sv[0], fd, NULL, 50);
+	zassert_equal(ret, -1, "sendfile succeeded");
+	zassert_equal(errno, EAGAIN, "invalid errno");
+	zassert_equal(mem_file.pos, 0, "file position changed");
+
+	for (i = 0; i < ARRAY_SIZE(chunks); i++) {
+		k_mem_slab_free(&sendfile_chunks, &chunks[i]);
+	}
+
+	ret = sendfile(sv[0], fd, NULL, 50);
+	zassert_equal(ret, 50, "sendfile failed");
+
+	ret = recv(sv[1], rx_buf, sizeof(rx_buf), 0);
+	zassert_equal(ret, 50, "recv failed");
+	zassert_mem_equal(rx_buf, file_data, 50, "invalid data");
+
+	zassert_equal(close(fd), 0, "close failed");
+	zassert_equal(close(sv[0]), 0, "close failed");
+	zassert_equal(close(sv[1]), 0, "close failed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_sendfile,
+			 ztest_unit_test(test_sendfile_tcp),
+			 ztest_unit_test(test_sendfile_offset),
+			 ztest_unit_test(test_sendfile_socketpair),
+			 ztest_unit_test(test_sendfile_nonblock),
+			 ztest_unit_test(test_sendfile_errors));
+
+	ztest_run_test_suite(socket_sendfile);
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2020 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <ztest.h>
+
+#include <net/socket.h>
+#include <net/tls_credentials.h>
+
+#define SERVER_PORT	4242
+#define HOSTNAME	"localhost"
+#define MAX_CONNS	2
+
+#define SERVER_TAG	1
+#define CA_TAG		2
+#define OTHER_CA_TAG	3
+
+#define ACCEPT_TIMEOUT	K_SECONDS(5)
+
+static const unsigned char ca_certificate[] = {
+#include "ca.der.inc"
+};
+
+static const unsigned char server_certificate[] = {
+#include "server.der.inc"
+};
+
+static const unsigned char private_key[] = {
+#include "server_privkey.der.inc"
+};
+
+/* A CA which did not sign the server certificate */
+static const unsigned char other_ca_certificate[] = {
+#include "other_ca.der.inc"
+};
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 192, 0, 2, 1 } } },
+};
+
+static int accepted[MAX_CONNS];
+static int accepted_count;
+static K_SEM_DEFINE(accept_sem, 0, MAX_CONNS);
+
+K_THREAD_STACK_DEFINE(server_stack, 4096);
+static struct k_thread server_thread;
+
+/* Accept the connections, which completes their handshake, and keep them
+ * open for the test to look at.
+ */
+static void server(void *p1, void *p2, void *p3)
+{
+	int s_sock = POINTER_TO_INT(p1);
+	int sock;
+
+	while (true) {
+		sock = zsock_accept(s_sock, NULL, NULL);
+		if (sock < 0) {
+			continue;
+		}
+
+		if (accepted_count == MAX_CONNS) {
+			zsock_close(sock);
+			continue;
+		}
+
+		accepted[accepted_count++] = sock;
+		k_sem_give(&accept_sem);
+	}
+}
+
+static int client_socket(sec_tag_t ca_tag, int cache)
+{
+	sec_tag_t sec_tag_list[] = { ca_tag };
+	int sock;
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+
+	zassert_equal(zsock_setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST,
+				       sec_tag_list, sizeof(sec_tag_list)), 0,
+		      "Cannot set secure tags (%d)", errno);
+	zassert_equal(zsock_setsockopt(sock, SOL_TLS, TLS_HOSTNAME, HOSTNAME,
+				       sizeof(HOSTNAME)), 0,
+		      "Cannot set hostname (%d)", errno);
+	zassert_equal(zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE,
+				       &cache, sizeof(cache)), 0,
+		      "Cannot set session cache (%d)", errno);
+
+	return sock;
+}
+
+static int client_connect(sec_tag_t ca_tag, int cache)
+{
+	int sock = client_socket(ca_tag, cache);
+
+	zassert_equal(zsock_connect(sock, (struct sockaddr *)&server_addr,
+				    sizeof(server_addr)), 0,
+		      "Cannot connect (%d)", errno);
+
+	zassert_equal(k_sem_take(&accept_sem, ACCEPT_TIMEOUT), 0,
+		      "Connection not accepted");
+
+	return sock;
+}
+
+static uint32_t config_users(int sock)
+{
+	struct tls_memory_usage usage;
+	socklen_t optlen = sizeof(usage);
+
+	zassert_equal(zsock_getsockopt(sock, SOL_TLS, TLS_MEMORY_USAGE,
+				       &usage, &optlen), 0,
+		      "Cannot read memory usage (%d)", errno);
+
+	return usage.config_users;
+}
+
+static void close_all(int *socks, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		zsock_close(socks[i]);
+	}
+
+	for (i = 0; i < accepted_count; i++) {
+		zsock_close(accepted[i]);
+	}
+
+	accepted_count = 0;
+}
+
+static void test_setup(void)
+{
+	sec_tag_t sec_tag_list[] = { SERVER_TAG };
+	int cache = TLS_SESSION_CACHE_ENABLED;
+	int sock;
+
+	zassert_equal(tls_credential_add(CA_TAG,
+					 TLS_CREDENTIAL_CA_CERTIFICATE,
+					 ca_certificate,
+					 sizeof(ca_certificate)), 0,
+		      "Cannot add CA certificate");
+	zassert_equal(tls_credential_add(SERVER_TAG,
+					 TLS_CREDENTIAL_SERVER_CERTIFICATE,
+					 server_certificate,
+					 sizeof(server_certificate)), 0,
+		      "Cannot add server certificate");
+	zassert_equal(tls_credential_add(SERVER_TAG,
+					 TLS_CREDENTIAL_PRIVATE_KEY,
+					 private_key, sizeof(private_key)), 0,
+		      "Cannot add private key");
+	zassert_equal(tls_credential_add(OTHER_CA_TAG,
+					 TLS_CREDENTIAL_CA_CERTIFICATE,
+					 other_ca_certificate,
+					 sizeof(other_ca_certificate)), 0,
+		      "Cannot add CA certificate");
+
+	sock = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+
+	zassert_equal(zsock_setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST,
+				       sec_tag_list, sizeof(sec_tag_list)), 0,
+		      "Cannot set secure tags (%d)", errno);
+	zassert_equal(zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE,
+				       &cache, sizeof(cache)), 0,
+		      "Cannot set session cache (%d)", errno);
+	zassert_equal(zsock_bind(sock, (struct sockaddr *)&server_addr,
+				 sizeof(server_addr)), 0,
+		      "Cannot bind (%d)", errno);
+	zassert_equal(zsock_listen(sock, MAX_CONNS), 0,
+		      "Cannot listen (%d)", errno);
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server,
+			INT_TO_POINTER(sock), NULL, NULL,
+			K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+}
+
+/* Connections with the same credentials and options use one mbedTLS
+ * configuration, on the server side too although its key is an RSA key.
+ */
+static void test_config_shared(void)
+{
+	int socks[MAX_CONNS];
+
+	socks[0] = client_connect(CA_TAG, TLS_SESSION_CACHE_DISABLED);
+	socks[1] = client_connect(CA_TAG, TLS_SESSION_CACHE_DISABLED);
+
+	zassert_equal(config_users(socks[0]), 2, "Client config not shared");
+	zassert_equal(config_users(socks[1]), 2, "Client config not shared");
+	zassert_equal(config_users(accepted[0]), 2,
+		      "Server config not shared");
+	zassert_equal(config_users(accepted[1]), 2,
+		      "Server config not shared");
+
+	close_all(socks, MAX_CONNS);
+}
+
+/* A resumed session skips the server certificate, which was verified when
+ * the session was established, so a connection which would not trust the
+ * server only succeeds when its session ticket is accepted.
+ */
+static void test_session_resumed(void)
+{
+	int purge = 0;
+	int sock;
+
+	sock = client_connect(CA_TAG, TLS_SESSION_CACHE_ENABLED);
+	close_all(&sock, 1);
+
+	sock = client_socket(OTHER_CA_TAG, TLS_SESSION_CACHE_DISABLED);
+	zassert_not_equal(zsock_connect(sock, (struct sockaddr *)&server_addr,
+					sizeof(server_addr)), 0,
+			  "Untrusted server accepted");
+	zsock_close(sock);
+
+	sock = client_connect(OTHER_CA_TAG, TLS_SESSION_CACHE_ENABLED);
+
+	/* The session is stored again after the abbreviated handshake */
+	zassert_equal(zsock_setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE_PURGE,
+				       &purge, sizeof(purge)), 0,
+		      "Cannot purge sessions (%d)", errno);
+	close_all(&sock, 1);
+
+	sock = client_socket(OTHER_CA_TAG, TLS_SESSION_CACHE_ENABLED);
+	zassert_not_equal(zsock_connect(sock, (struct sockaddr *)&server_addr,
+					sizeof(server_addr)), 0,
+			  "Purged session resumed");
+	zsock_close(sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_tls,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_config_shared),
+			 ztest_unit_test(test_session_resumed));
+
+	ztest_run_test_suite(socket_tls);
+}
@@ -752,6 +752,440 @@ void test_so_txtime(void)
 	zassert_equal(rv, 0, "close failed");
 }
 
+static int zerocopy_done(int sock)
+{
+	socklen_t optlen = sizeof(int);
+	int done, rv;
+
+	rv = getsockopt(sock, SOL_SOCKET, SO_ZEROCOPY_DONE, &done, &optlen);
+	zassert_equal(rv, 0, "getsockopt failed (%d)", errno);
+
+	return done;
+}
+
+void test_v4_zerocopy_sendto_recv(void)
+{
+	struct sockaddr_in client_addr;
+	struct sockaddr_in server_addr;
+	struct sockaddr_in addr;
+	socklen_t addrlen;
+	int client_sock, server_sock;
+	struct net_buf *frags;
+	ssize_t len;
+	int i, rv;
+
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, CLIENT_PORT,
+			    &client_sock, &client_addr);
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			    &server_sock, &server_addr);
+
+	rv = bind(server_sock, (struct sockaddr *)&server_addr,
+		  sizeof(server_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	rv = bind(client_sock, (struct sockaddr *)&client_addr,
+		  sizeof(client_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	zassert_equal(zerocopy_done(client_sock), 0, "data already released");
+
+	len = sendto(client_sock, BUF_AND_SIZE(TEST_STR2), MSG_ZEROCOPY,
+		     (struct sockaddr *)&server_addr, sizeof(server_addr));
+	zassert_equal(len, STRLEN(TEST_STR2), "sendto failed");
+
+	len = zsock_recv_zerocopy(server_sock, &frags, MSG_PEEK, NULL, NULL);
+	zassert_equal(len, -1, "MSG_PEEK accepted");
+	zassert_equal(errno, EINVAL, "Invalid errno (%d)", errno);
+
+	addrlen = sizeof(addr);
+	len = zsock_recv_zerocopy(server_sock, &frags, 0,
+				  (struct sockaddr *)&addr, &addrlen);
+	zassert_equal(len, STRLEN(TEST_STR2), "recv failed (%d)", errno);
+	zassert_equal(net_buf_frags_len(frags), len, "invalid fragments");
+	zassert_equal(addrlen, sizeof(addr), "unexpected addrlen");
+	zassert_equal(addr.sin_port, client_addr.sin_port,
+		      "unexpected client port");
+
+	clear_buf(rx_buf);
+	net_buf_linearize(rx_buf, sizeof(rx_buf), frags, 0, len);
+	zassert_mem_equal(rx_buf, BUF_AND_SIZE(TEST_STR2), "wrong data");
+
+	net_buf_unref(frags);
+
+	for (i = 0; i < 10 && !zerocopy_done(client_sock); i++) {
+		k_msleep(10);
+	}
+
+	zassert_equal(zerocopy_done(client_sock), 1, "data not released");
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+/* Send a datagram and receive it scattered over two buffers, the control
+ * data is left in msg for the caller to check.
+ */
+static void comm_sendto_recvmsg(int client_sock, int server_sock,
+				struct sockaddr *server_addr,
+				socklen_t addrlen, struct msghdr *msg)
+{
+	struct iovec io_vector[2];
+	ssize_t len;
+
+	len = sendto(client_sock, BUF_AND_SIZE(TEST_STR2), 0, server_addr,
+		     addrlen);
+	zassert_equal(len, STRLEN(TEST_STR2), "sendto failed");
+
+	clear_buf(rx_buf);
+	io_vector[0].iov_base = rx_buf;
+	io_vector[0].iov_len = 100;
+	io_vector[1].iov_base = rx_buf + 100;
+	io_vector[1].iov_len = sizeof(rx_buf) - 100;
+
+	msg->msg_iov = io_vector;
+	msg->msg_iovlen = ARRAY_SIZE(io_vector);
+
+	len = recvmsg(server_sock, msg, 0);
+	zassert_equal(len, STRLEN(TEST_STR2), "recvmsg failed (%d)", errno);
+	zassert_mem_equal(rx_buf, BUF_AND_SIZE(TEST_STR2), "wrong data");
+	zassert_false(msg->msg_flags & MSG_TRUNC, "datagram truncated");
+
+	msg->msg_iov = NULL;
+	msg->msg_iovlen = 0;
+}
+
+/* The rest of a datagram, or of its control data, which does not fit is
+ * dropped.
+ */
+static void check_recvmsg_trunc(int client_sock, int server_sock,
+				struct sockaddr *server_addr,
+				socklen_t addrlen)
+{
+	struct iovec io_vector[1];
+	struct msghdr msg;
+	ssize_t len;
+
+	len = sendto(client_sock, BUF_AND_SIZE(TEST_STR_SMALL), 0,
+		     server_addr, addrlen);
+	zassert_equal(len, STRLEN(TEST_STR_SMALL), "sendto failed");
+
+	io_vector[0].iov_base = rx_buf;
+	io_vector[0].iov_len = 2;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = io_vector;
+	msg.msg_iovlen = 1;
+
+	len = recvmsg(server_sock, &msg, 0);
+	zassert_equal(len, 2, "recvmsg failed (%d)", errno);
+	zassert_equal(msg.msg_flags, MSG_TRUNC | MSG_CTRUNC,
+		      "unexpected flags %x", msg.msg_flags);
+	zassert_equal(msg.msg_controllen, 0, "unexpected control data");
+}
+
+void test_v4_recvmsg_pktinfo(void)
+{
+	struct sockaddr_in client_addr;
+	struct sockaddr_in server_addr;
+	struct sockaddr_in addr;
+	struct in_pktinfo *info;
+	struct cmsghdr *cmsg;
+	struct msghdr msg;
+	union {
+		struct cmsghdr hdr;
+		unsigned char  buf[CMSG_SPACE(sizeof(struct in_pktinfo))];
+	} cmsgbuf;
+	int client_sock, server_sock;
+	socklen_t optlen;
+	int optval;
+	int rv;
+
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, CLIENT_PORT,
+			    &client_sock, &client_addr);
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			    &server_sock, &server_addr);
+
+	rv = bind(server_sock, (struct sockaddr *)&server_addr,
+		  sizeof(server_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	rv = bind(client_sock, (struct sockaddr *)&client_addr,
+		  sizeof(client_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	optval = 1;
+	rv = setsockopt(server_sock, IPPROTO_IP, IP_PKTINFO, &optval,
+			sizeof(optval));
+	zassert_equal(rv, 0, "setsockopt failed (%d)", errno);
+
+	optval = 0;
+	optlen = sizeof(optval);
+	rv = getsockopt(server_sock, IPPROTO_IP, IP_PKTINFO, &optval,
+			&optlen);
+	zassert_equal(rv, 0, "getsockopt failed (%d)", errno);
+	zassert_equal(optval, 1, "IP_PKTINFO not set");
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(addr);
+	msg.msg_control = &cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+	comm_sendto_recvmsg(client_sock, server_sock,
+			    (struct sockaddr *)&server_addr,
+			    sizeof(server_addr), &msg);
+
+	zassert_equal(msg.msg_namelen, sizeof(addr), "unexpected addrlen");
+	zassert_equal(addr.sin_port, client_addr.sin_port,
+		      "unexpected client port");
+	zassert_equal(msg.msg_flags, 0, "unexpected flags %x",
+		      msg.msg_flags);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	zassert_not_null(cmsg, "no control message");
+	zassert_equal(cmsg->cmsg_level, IPPROTO_IP, "wrong level");
+	zassert_equal(cmsg->cmsg_type, IP_PKTINFO, "wrong type");
+	zassert_equal(cmsg->cmsg_len, CMSG_LEN(sizeof(*info)), "wrong len");
+
+	info = (struct in_pktinfo *)CMSG_DATA(cmsg);
+	zassert_true(net_ipv4_addr_cmp(&info->ipi_addr,
+				       &server_addr.sin_addr),
+		     "wrong destination address");
+	zassert_true(info->ipi_ifindex > 0, "no interface index");
+
+	check_recvmsg_trunc(client_sock, server_sock,
+			    (struct sockaddr *)&server_addr,
+			    sizeof(server_addr));
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+void test_v6_recvmsg_pktinfo(void)
+{
+	struct sockaddr_in6 client_addr;
+	struct sockaddr_in6 server_addr;
+	struct sockaddr_in6 addr;
+	struct in6_pktinfo *info;
+	struct cmsghdr *cmsg;
+	struct msghdr msg;
+	union {
+		struct cmsghdr hdr;
+		unsigned char  buf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+	} cmsgbuf;
+	int client_sock, server_sock;
+	int optval = 1;
+	int rv;
+
+	prepare_sock_udp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, CLIENT_PORT,
+			    &client_sock, &client_addr);
+	prepare_sock_udp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, SERVER_PORT,
+			    &server_sock, &server_addr);
+
+	rv = bind(server_sock, (struct sockaddr *)&server_addr,
+		  sizeof(server_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	rv = bind(client_sock, (struct sockaddr *)&client_addr,
+		  sizeof(client_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	rv = setsockopt(server_sock, IPPROTO_IPV6, IPV6_RECVPKTINFO, &optval,
+			sizeof(optval));
+	zassert_equal(rv, 0, "setsockopt failed (%d)", errno);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(addr);
+	msg.msg_control = &cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+	comm_sendto_recvmsg(client_sock, server_sock,
+			    (struct sockaddr *)&server_addr,
+			    sizeof(server_addr), &msg);
+
+	zassert_equal(msg.msg_namelen, sizeof(addr), "unexpected addrlen");
+	zassert_equal(addr.sin6_port, client_addr.sin6_port,
+		      "unexpected client port");
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	zassert_not_null(cmsg, "no control message");
+	zassert_equal(cmsg->cmsg_level, IPPROTO_IPV6, "wrong level");
+	zassert_equal(cmsg->cmsg_type, IPV6_PKTINFO, "wrong type");
+	zassert_equal(cmsg->cmsg_len, CMSG_LEN(sizeof(*info)), "wrong len");
+
+	info = (struct in6_pktinfo *)CMSG_DATA(cmsg);
+	zassert_true(net_ipv6_addr_cmp(&info->ipi6_addr,
+				       &server_addr.sin6_addr),
+		     "wrong destination address");
+	zassert_true(info->ipi6_ifindex > 0, "no interface index");
+
+	check_recvmsg_trunc(client_sock, server_sock,
+			    (struct sockaddr *)&server_addr,
+			    sizeof(server_addr));
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+void test_v4_recvmsg_timestamping(void)
+{
+	struct sockaddr_in client_addr;
+	struct sockaddr_in server_addr;
+	struct cmsghdr *cmsg;
+	struct msghdr msg;
+	union {
+		struct cmsghdr hdr;
+		unsigned char  buf[CMSG_SPACE(sizeof(struct in_pktinfo)) +
+				   CMSG_SPACE(sizeof(struct net_ptp_time))];
+	} cmsgbuf;
+	int client_sock, server_sock;
+	int optval;
+	int rv;
+
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, CLIENT_PORT,
+			    &client_sock, &client_addr);
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			    &server_sock, &server_addr);
+
+	rv = bind(server_sock, (struct sockaddr *)&server_addr,
+		  sizeof(server_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	rv = bind(client_sock, (struct sockaddr *)&client_addr,
+		  sizeof(client_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	optval = 1;
+	rv = setsockopt(server_sock, IPPROTO_IP, IP_PKTINFO, &optval,
+			sizeof(optval));
+	zassert_equal(rv, 0, "setsockopt failed (%d)", errno);
+
+	optval = SOF_TIMESTAMPING_RX_HARDWARE;
+	rv = setsockopt(server_sock, SOL_SOCKET, SO_TIMESTAMPING, &optval,
+			sizeof(optval));
+	zassert_equal(rv, 0, "setsockopt failed (%d)", errno);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_control = &cmsgbuf.buf;
+	msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+	comm_sendto_recvmsg(client_sock, server_sock,
+			    (struct sockaddr *)&server_addr,
+			    sizeof(server_addr), &msg);
+
+	zassert_equal(msg.msg_controllen, sizeof(cmsgbuf.buf),
+		      "unexpected control data length");
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	zassert_not_null(cmsg, "no control message");
+	zassert_equal(cmsg->cmsg_type, IP_PKTINFO, "wrong type");
+
+	cmsg = CMSG_NXTHDR(&msg, cmsg);
+	zassert_not_null(cmsg, "no timestamp");
+	zassert_equal(cmsg->cmsg_level, SOL_SOCKET, "wrong level");
+	zassert_equal(cmsg->cmsg_type, SCM_TIMESTAMPING, "wrong type");
+	zassert_equal(cmsg->cmsg_len, CMSG_LEN(sizeof(struct net_ptp_time)),
+		      "wrong len");
+
+	/* The pktinfo still fits when the timestamp does not */
+	msg.msg_control = &cmsgbuf.buf;
+	msg.msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
+
+	comm_sendto_recvmsg(client_sock, server_sock,
+			    (struct sockaddr *)&server_addr,
+			    sizeof(server_addr), &msg);
+
+	zassert_equal(msg.msg_flags, MSG_CTRUNC, "unexpected flags %x",
+		      msg.msg_flags);
+	zassert_equal(msg.msg_controllen,
+		      CMSG_SPACE(sizeof(struct in_pktinfo)),
+		      "unexpected control data length");
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+#define MMSG_COUNT 3
+
+void test_v4_sendmmsg_recvmmsg(void)
+{
+	struct sockaddr_in client_addr;
+	struct sockaddr_in server_addr;
+	struct mmsghdr msgs[MMSG_COUNT + 1];
+	struct iovec io_vector[MMSG_COUNT + 1];
+	int client_sock, server_sock;
+	int i, rv;
+
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, CLIENT_PORT,
+			    &client_sock, &client_addr);
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			    &server_sock, &server_addr);
+
+	rv = bind(server_sock, (struct sockaddr *)&server_addr,
+		  sizeof(server_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	rv = bind(client_sock, (struct sockaddr *)&client_addr,
+		  sizeof(client_addr));
+	zassert_equal(rv, 0, "bind failed");
+
+	memset(msgs, 0, sizeof(msgs));
+
+	for (i = 0; i < MMSG_COUNT; i++) {
+		io_vector[i].iov_base = TEST_STR2;
+		io_vector[i].iov_len = i + 1;
+		msgs[i].msg_hdr.msg_iov = &io_vector[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &server_addr;
+		msgs[i].msg_hdr.msg_namelen = sizeof(server_addr);
+	}
+
+	rv = sendmmsg(client_sock, msgs, MMSG_COUNT, 0);
+	zassert_equal(rv, MMSG_COUNT, "sendmmsg failed (%d)", errno);
+
+	for (i = 0; i < MMSG_COUNT; i++) {
+		zassert_equal(msgs[i].msg_len, i + 1, "wrong sent length");
+	}
+
+	/* Only wait for the first message, the last one stays empty */
+	memset(msgs, 0, sizeof(msgs));
+	clear_buf(rx_buf);
+
+	for (i = 0; i < MMSG_COUNT + 1; i++) {
+		io_vector[i].iov_base = rx_buf + i * 10;
+		io_vector[i].iov_len = 10;
+		msgs[i].msg_hdr.msg_iov = &io_vector[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	rv = recvmmsg(server_sock, msgs, MMSG_COUNT + 1, MSG_WAITFORONE);
+	zassert_equal(rv, MMSG_COUNT, "recvmmsg failed (%d)", errno);
+
+	for (i = 0; i < MMSG_COUNT; i++) {
+		zassert_equal(msgs[i].msg_len, i + 1, "wrong received length");
+		zassert_mem_equal(rx_buf + i * 10, TEST_STR2, i + 1,
+				  "wrong data");
+	}
+
+	rv = recvmmsg(server_sock, msgs, MMSG_COUNT, MSG_DONTWAIT);
+	zassert_equal(rv, -1, "unexpected message");
+	zassert_equal(errno, EAGAIN, "Invalid errno (%d)", errno);
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
 static void comm_sendmsg_with_txtime(int client_sock,
 				     struct sockaddr *client_addr,
 				     socklen_t client_addrlen,
@@ -976,6 +1410,15 @@ void test_main(void)
 			 ztest_user_unit_test(test_v4_sendmsg_recvfrom_connected),
 			 ztest_unit_test(test_v6_sendmsg_recvfrom_connected),
 			 ztest_user_unit_test(test_v6_sendmsg_recvfrom_connected),
+			 ztest_unit_test(test_v4_zerocopy_sendto_recv),
+			 ztest_unit_test(test_v4_recvmsg_pktinfo),
+			 ztest_user_unit_test(test_v4_recvmsg_pktinfo),
+			 ztest_unit_test(test_v6_recvmsg_pktinfo),
+			 ztest_user_unit_test(test_v6_recvmsg_pktinfo),
+			 ztest_unit_test(test_v4_recvmsg_timestamping),
+			 ztest_user_unit_test(test_v4_recvmsg_timestamping),
+			 ztest_unit_test(test_v4_sendmmsg_recvmmsg),
+			 ztest_user_unit_test(test_v4_sendmmsg_recvmmsg),
 			 ztest_unit_test(test_setup_eth),
 			 ztest_unit_test(test_v6_sendmsg_with_txtime),
 			 ztest_user_unit_test(test_v6_sendmsg_with_txtime)
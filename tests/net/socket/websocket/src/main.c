@@ -269,12 +269,36 @@ static void test_recv_two_msg(void)
 	test_recv_2(sizeof(frame1) + FRAME1_HDR_SIZE / 2);
 }
 
-int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg)
+/* The frames sent are collected here instead of being sent */
+static uint8_t wire_buf[sizeof(lorem_ipsum) + MAX_HEADER_LEN];
+static size_t wire_len;
+
+int verify_sent_msg(struct msghdr *msg)
+{
+	size_t total = 0;
+	int i;
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		zassert_true(wire_len + msg->msg_iov[i].iov_len <=
+			     sizeof(wire_buf), "Too much data sent");
+
+		memcpy(&wire_buf[wire_len], msg->msg_iov[i].iov_base,
+		       msg->msg_iov[i].iov_len);
+		wire_len += msg->msg_iov[i].iov_len;
+		total += msg->msg_iov[i].iov_len;
+	}
+
+	return total;
+}
+
+static void verify_received_msg(bool split_msg)
 {
 	static struct websocket_context ctx;
 	uint32_t msg_type = -1;
 	uint64_t remaining = -1;
 	size_t split_len = 0, total_read = 0;
+	size_t header_len = wire_len - test_msg_len;
+	uint8_t *payload = &wire_buf[header_len];
 	int ret;
 
 	memset(&ctx, 0, sizeof(ctx));
@@ -283,18 +307,16 @@ int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg)
 	ctx.tmp_buf_len = sizeof(temp_recv_buf);
 
 	/* Read first the header */
-	ret = test_recv_buf(msg->msg_iov[0].iov_base,
-			    msg->msg_iov[0].iov_len,
+	ret = test_recv_buf(wire_buf, header_len,
 			    &ctx, &msg_type, &remaining,
 			    recv_buf, sizeof(recv_buf));
 	zassert_equal(ret, -EAGAIN, "Msg header not found");
 
 	/* Then the first split if it is enabled */
 	if (split_msg) {
-		split_len = msg->msg_iov[1].iov_len / 2;
+		split_len = test_msg_len / 2;
 
-		ret = test_recv_buf(msg->msg_iov[1].iov_base,
-				    split_len,
+		ret = test_recv_buf(payload, split_len,
 				    &ctx, &msg_type, &remaining,
 				    recv_buf, sizeof(recv_buf));
 		zassert_true(ret > 0, "Cannot read data (%d)", ret);
@@ -304,32 +326,28 @@ int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg)
 
 	/* Then the data */
 	while (remaining > 0) {
-		ret = test_recv_buf((uint8_t *)msg->msg_iov[1].iov_base +
-								total_read,
-				    msg->msg_iov[1].iov_len - total_read,
+		ret = test_recv_buf(payload + total_read,
+				    test_msg_len - total_read,
 				    &ctx, &msg_type, &remaining,
-				    recv_buf, sizeof(recv_buf));
+				    recv_buf + total_read,
+				    sizeof(recv_buf) - total_read);
 		zassert_true(ret > 0, "Cannot read data (%d)", ret);
 
-		if (memcmp(recv_buf, lorem_ipsum + total_read, ret) != 0) {
-			LOG_HEXDUMP_ERR(lorem_ipsum + total_read, ret,
-					"Received message should be");
-			LOG_HEXDUMP_ERR(recv_buf, ret, "but it was instead");
-			zassert_true(false, "Invalid received message "
-				     "after %d bytes", total_read);
-		}
-
 		total_read += ret;
 	}
 
+	if (memcmp(recv_buf, lorem_ipsum, total_read) != 0) {
+		LOG_HEXDUMP_ERR(lorem_ipsum, total_read,
+				"Received message should be");
+		LOG_HEXDUMP_ERR(recv_buf, total_read, "but it was instead");
+		zassert_true(false, "Invalid received message");
+	}
+
 	zassert_equal(total_read, test_msg_len,
 		      "Msg body not valid, received %d instead of %zd",
 		      total_read, test_msg_len);
 
-	NET_DBG("Received %zd header and %zd body",
-		msg->msg_iov[0].iov_len, total_read);
-
-	return msg->msg_iov[0].iov_len + total_read;
+	NET_DBG("Received %zd header and %zd body", header_len, total_read);
 }
 
 static void test_send_and_recv_lorem_ipsum(void)
@@ -343,6 +361,7 @@ static void test_send_and_recv_lorem_ipsum(void)
 	ctx.tmp_buf_len = sizeof(temp_recv_buf);
 
 	test_msg_len = sizeof(lorem_ipsum) - 1;
+	wire_len = 0;
 
 	ret = websocket_send_msg(POINTER_TO_INT(&ctx),
 				 lorem_ipsum, test_msg_len,
@@ -351,6 +370,8 @@ static void test_send_and_recv_lorem_ipsum(void)
 	zassert_equal(ret, test_msg_len,
 		      "Should have sent %zd bytes but sent %d instead",
 		      test_msg_len, ret);
+
+	verify_received_msg(false);
 }
 
 static void test_recv_two_large_split_msg(void)
@@ -364,6 +385,7 @@ static void test_recv_two_large_split_msg(void)
 	ctx.tmp_buf_len = sizeof(temp_recv_buf);
 
 	test_msg_len = sizeof(lorem_ipsum) - 1;
+	wire_len = 0;
 
 	ret = websocket_send_msg(POINTER_TO_INT(&ctx), lorem_ipsum,
 				 test_msg_len, WEBSOCKET_OPCODE_DATA_TEXT,
@@ -371,12 +393,59 @@ static void test_recv_two_large_split_msg(void)
 	zassert_equal(ret, test_msg_len,
 		      "1st should have sent %zd bytes but sent %d instead",
 		      test_msg_len, ret);
+
+	verify_received_msg(true);
 }
 
-void test_main(void)
+static void test_send_iov(bool mask)
 {
-	k_thread_system_pool_assign(k_current_get());
+	static struct websocket_context ctx;
+	/* Odd lengths so that the masking key and the words do not stay
+	 * aligned with the buffers.
+	 */
+	struct iovec iov[] = {
+		{ .iov_base = (void *)lorem_ipsum, .iov_len = 1 },
+		{ .iov_base = (void *)&lorem_ipsum[1], .iov_len = 3 },
+		{ .iov_base = (void *)&lorem_ipsum[4], .iov_len = 501 },
+		{ .iov_base = (void *)&lorem_ipsum[505], .iov_len = 6 },
+		{ .iov_base = (void *)&lorem_ipsum[511],
+		  .iov_len = sizeof(lorem_ipsum) - 1 - 511 },
+	};
+	int ret;
 
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.tmp_buf = temp_recv_buf;
+	ctx.tmp_buf_len = sizeof(temp_recv_buf);
+
+	test_msg_len = sizeof(lorem_ipsum) - 1;
+	wire_len = 0;
+
+	ret = websocket_send_msg_iov(POINTER_TO_INT(&ctx), iov,
+				     ARRAY_SIZE(iov),
+				     WEBSOCKET_OPCODE_DATA_BINARY, mask, true,
+				     SYS_FOREVER_MS);
+	zassert_equal(ret, test_msg_len,
+		      "Should have sent %zd bytes but sent %d instead",
+		      test_msg_len, ret);
+	zassert_equal(wire_len, test_msg_len + (mask ? 8 : 4),
+		      "Invalid frame length %zd", wire_len);
+
+	verify_received_msg(false);
+}
+
+static void test_send_iov_masked(void)
+{
+	test_send_iov(true);
+}
+
+static void test_send_iov_unmasked(void)
+{
+	test_send_iov(false);
+}
+
+void test_main(void)
+{
 	ztest_test_suite(websocket,
 			 ztest_unit_test(test_recv_1_byte),
 			 ztest_unit_test(test_recv_2_byte),
@@ -390,7 +459,9 @@ void test_main(void)
 			 ztest_unit_test(test_recv_whole_msg),
 			 ztest_unit_test(test_recv_two_msg),
 			 ztest_unit_test(test_send_and_recv_lorem_ipsum),
-			 ztest_unit_test(test_recv_two_large_split_msg)
+			 ztest_unit_test(test_recv_two_large_split_msg),
+			 ztest_unit_test(test_send_iov_masked),
+			 ztest_unit_test(test_send_iov_unmasked)
 		);
 
 	ztest_run_test_suite(websocket);
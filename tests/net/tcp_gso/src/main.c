@@ -0,0 +1,517 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define NET_LOG_LEVEL CONFIG_NET_L2_ETHERNET_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, NET_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/printk.h>
+
+#include <ztest.h>
+
+#include <net/ethernet.h>
+#include <net/buf.h>
+#include <net/net_ip.h>
+#include <net/net_l2.h>
+
+#include "../../eth_test_helpers.h"
+
+#include "ipv4.h"
+#include "ipv6.h"
+#include "udp_internal.h"
+
+#define NET_LOG_ENABLED 1
+#include "net_private.h"
+
+#if NET_LOG_LEVEL >= LOG_LEVEL_DBG
+#define DBG(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#else
+#define DBG(fmt, ...)
+#endif
+
+#define TEST_MSS	1000
+#define TEST_DATA_LEN	(3 * TEST_MSS + 123)
+#define TEST_SEQ	0x12345678
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+#define WAIT_TIME K_SECONDS(1)
+
+static struct in_addr in4addr_my = { { { 192, 0, 2, 1 } } };
+static struct in_addr in4addr_dst = { { { 192, 0, 2, 2 } } };
+static struct in6_addr in6addr_my = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					  0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr in6addr_dst = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					   0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+static uint8_t lladdr_dst[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0xff };
+
+static struct net_if *gso_iface;
+static struct net_if *tso_iface;
+static struct net_if *csum_iface;
+
+static K_SEM_DEFINE(wait_data, 0, UINT_MAX);
+
+static size_t received;
+static int frames;
+static bool test_failed;
+
+static struct eth_context eth_context_gso;
+static struct eth_context eth_context_tso;
+static struct eth_context eth_context_csum;
+
+/* UDP datagram reassembled from the fragments sent by csum_iface */
+static uint8_t datagram[NET_UDPH_LEN + TEST_DATA_LEN];
+static size_t datagram_len;
+
+static bool check_frame(uint8_t *frame, size_t len)
+{
+	uint8_t *ip_hdr = frame + sizeof(struct net_eth_hdr);
+	size_t ip_len = len - sizeof(struct net_eth_hdr);
+	struct net_tcp_hdr *tcp_hdr;
+	size_t payload_len, i;
+	uint8_t *payload;
+	uint16_t sum;
+
+	if (ntohs(((struct net_eth_hdr *)frame)->type) == NET_ETH_PTYPE_IP) {
+		struct net_ipv4_hdr *hdr = (struct net_ipv4_hdr *)ip_hdr;
+
+		if (ntohs(hdr->len) != ip_len) {
+			DBG("Invalid IPv4 length %d\n", ntohs(hdr->len));
+			return false;
+		}
+
+		if (chksum(0, ip_hdr, NET_IPV4H_LEN) != 0xffff) {
+			DBG("Invalid IPv4 checksum\n");
+			return false;
+		}
+
+		sum = chksum(0, (uint8_t *)&hdr->src,
+			     2 * sizeof(struct in_addr));
+		tcp_hdr = (struct net_tcp_hdr *)(ip_hdr + NET_IPV4H_LEN);
+		payload_len = ip_len - NET_IPV4TCPH_LEN;
+	} else {
+		struct net_ipv6_hdr *hdr = (struct net_ipv6_hdr *)ip_hdr;
+
+		if (ntohs(hdr->len) != ip_len - NET_IPV6H_LEN) {
+			DBG("Invalid IPv6 length %d\n", ntohs(hdr->len));
+			return false;
+		}
+
+		sum = chksum(0, (uint8_t *)&hdr->src,
+			     2 * sizeof(struct in6_addr));
+		tcp_hdr = (struct net_tcp_hdr *)(ip_hdr + NET_IPV6H_LEN);
+		payload_len = ip_len - NET_IPV6TCPH_LEN;
+	}
+
+	payload = (uint8_t *)tcp_hdr + NET_TCPH_LEN;
+
+	if (payload_len > TEST_MSS) {
+		DBG("Frame too long %zd\n", payload_len);
+		return false;
+	}
+
+	if (chksum(IPPROTO_TCP + NET_TCPH_LEN + payload_len + sum,
+		   (uint8_t *)tcp_hdr, NET_TCPH_LEN + payload_len) != 0xffff) {
+		DBG("Invalid TCP checksum\n");
+		return false;
+	}
+
+	if (sys_get_be32(tcp_hdr->seq) != TEST_SEQ + received) {
+		DBG("Invalid sequence number\n");
+		return false;
+	}
+
+	if (!!(tcp_hdr->flags & TCP_PSH) !=
+	    (received + payload_len == TEST_DATA_LEN)) {
+		DBG("PSH flag must be set only in the last frame\n");
+		return false;
+	}
+
+	for (i = 0; i < payload_len; i++) {
+		if (payload[i] != (uint8_t)(received + i)) {
+			DBG("Invalid payload at %zd\n", received + i);
+			return false;
+		}
+	}
+
+	received += payload_len;
+
+	return true;
+}
+
+/* Copy the payload of an IPv6 fragment to its place in the datagram.
+ * Returns true once the last fragment has been added.
+ */
+static bool add_fragment(uint8_t *frame, size_t len)
+{
+	struct net_ipv6_hdr *ip_hdr;
+	struct net_ipv6_frag_hdr *frag_hdr;
+	size_t offset, payload_len;
+
+	ip_hdr = (struct net_ipv6_hdr *)(frame + sizeof(struct net_eth_hdr));
+	frag_hdr = (struct net_ipv6_frag_hdr *)((uint8_t *)ip_hdr +
+						NET_IPV6H_LEN);
+	payload_len = len - sizeof(struct net_eth_hdr) - NET_IPV6H_LEN -
+		      NET_IPV6_FRAGH_LEN;
+
+	if (ip_hdr->nexthdr != NET_IPV6_NEXTHDR_FRAG ||
+	    frag_hdr->nexthdr != IPPROTO_UDP) {
+		DBG("Not a UDP fragment\n");
+		test_failed = true;
+		return true;
+	}
+
+	offset = ntohs(frag_hdr->offset) & 0xfff8;
+	if (offset + payload_len > sizeof(datagram)) {
+		DBG("Fragment out of bounds\n");
+		test_failed = true;
+		return true;
+	}
+
+	memcpy(&datagram[offset], (uint8_t *)frag_hdr + NET_IPV6_FRAGH_LEN,
+	       payload_len);
+	datagram_len += payload_len;
+
+	return !(ntohs(frag_hdr->offset) & 0x0001);
+}
+
+static int eth_tx_gso(const struct device *dev, struct net_pkt *pkt)
+{
+	static uint8_t frame[NET_ETH_MAX_FRAME_SIZE];
+	size_t len = net_pkt_get_len(pkt);
+
+	zassert_equal(net_pkt_gso_size(pkt), 0, "Oversized frame");
+
+	if (len > sizeof(frame) || net_pkt_read(pkt, frame, len) ||
+	    !check_frame(frame, len)) {
+		test_failed = true;
+	}
+
+	frames++;
+
+	if (test_failed || received == TEST_DATA_LEN) {
+		k_sem_give(&wait_data);
+	}
+
+	return 0;
+}
+
+static int eth_tx_tso(const struct device *dev, struct net_pkt *pkt)
+{
+	if (net_pkt_gso_size(pkt) != TEST_MSS ||
+	    net_pkt_get_len(pkt) != sizeof(struct net_eth_hdr) +
+	    NET_IPV4TCPH_LEN + TEST_DATA_LEN) {
+		test_failed = true;
+	}
+
+	frames++;
+	k_sem_give(&wait_data);
+
+	return 0;
+}
+
+static int eth_tx_frag(const struct device *dev, struct net_pkt *pkt)
+{
+	static uint8_t frame[NET_ETH_MAX_FRAME_SIZE];
+	size_t len = net_pkt_get_len(pkt);
+
+	if (len > sizeof(frame) || net_pkt_read(pkt, frame, len)) {
+		test_failed = true;
+	}
+
+	frames++;
+
+	if (test_failed || add_fragment(frame, len)) {
+		k_sem_give(&wait_data);
+	}
+
+	return 0;
+}
+
+static enum ethernet_hw_caps eth_caps_gso(const struct device *dev)
+{
+	return 0;
+}
+
+static enum ethernet_hw_caps eth_caps_tso(const struct device *dev)
+{
+	return ETHERNET_HW_TX_TSO;
+}
+
+static enum ethernet_hw_caps eth_caps_csum(const struct device *dev)
+{
+	return ETHERNET_HW_TX_CHKSUM_OFFLOAD;
+}
+
+static struct ethernet_api api_funcs_gso = {
+	.iface_api.init = eth_iface_init,
+
+	.get_capabilities = eth_caps_gso,
+	.send = eth_tx_gso,
+};
+
+static struct ethernet_api api_funcs_tso = {
+	.iface_api.init = eth_iface_init,
+
+	.get_capabilities = eth_caps_tso,
+	.send = eth_tx_tso,
+};
+
+static struct ethernet_api api_funcs_csum = {
+	.iface_api.init = eth_iface_init,
+
+	.get_capabilities = eth_caps_csum,
+	.send = eth_tx_frag,
+};
+
+ETH_NET_DEVICE_INIT(eth_gso_test, "eth_gso_test",
+		    eth_init, device_pm_control_nop,
+		    &eth_context_gso, NULL,
+		    CONFIG_ETH_INIT_PRIORITY,
+		    &api_funcs_gso,
+		    NET_ETH_MTU);
+
+ETH_NET_DEVICE_INIT(eth_tso_test, "eth_tso_test",
+		    eth_init, device_pm_control_nop,
+		    &eth_context_tso, NULL,
+		    CONFIG_ETH_INIT_PRIORITY,
+		    &api_funcs_tso,
+		    NET_ETH_MTU);
+
+ETH_NET_DEVICE_INIT(eth_csum_test, "eth_csum_test",
+		    eth_init, device_pm_control_nop,
+		    &eth_context_csum, NULL,
+		    CONFIG_ETH_INIT_PRIORITY,
+		    &api_funcs_csum,
+		    NET_ETH_MTU);
+
+static void iface_cb(struct net_if *iface, void *user_data)
+{
+	if (net_if_l2(iface) != &NET_L2_GET_NAME(ETHERNET)) {
+		return;
+	}
+
+	if (net_if_get_device(iface)->data == &eth_context_gso) {
+		gso_iface = iface;
+	} else if (net_if_get_device(iface)->data == &eth_context_tso) {
+		tso_iface = iface;
+	} else if (net_if_get_device(iface)->data == &eth_context_csum) {
+		csum_iface = iface;
+	}
+}
+
+static void add_ipv6(struct net_if *iface)
+{
+	struct net_linkaddr lladdr = {
+		.addr = lladdr_dst,
+		.len = sizeof(lladdr_dst),
+		.type = NET_LINK_ETHERNET,
+	};
+
+	zassert_not_null(net_if_ipv6_addr_add(iface, &in6addr_my,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv6 address");
+	zassert_not_null(net_ipv6_nbr_add(iface, &in6addr_dst, &lladdr,
+					  false, NET_IPV6_NBR_STATE_REACHABLE),
+			 "Cannot add neighbor");
+}
+
+static void test_setup(void)
+{
+	net_if_foreach(iface_cb, NULL);
+
+	zassert_not_null(gso_iface, "GSO interface not found");
+	zassert_not_null(tso_iface, "TSO interface not found");
+	zassert_not_null(csum_iface, "Checksum interface not found");
+
+	zassert_not_null(net_if_ipv4_addr_add(gso_iface, &in4addr_my,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv4 address");
+	zassert_not_null(net_if_ipv4_addr_add(tso_iface, &in4addr_my,
+					      NET_ADDR_MANUAL, 0),
+			 "Cannot add IPv4 address");
+
+	add_ipv6(gso_iface);
+	add_ipv6(csum_iface);
+
+	zassert_false(net_if_need_tcp_segmentation(gso_iface),
+		      "GSO not enabled");
+	zassert_false(net_if_need_tcp_segmentation(tso_iface),
+		      "TSO not enabled");
+	zassert_false(net_if_need_calc_tx_checksum(csum_iface),
+		      "Checksum offload not enabled");
+}
+
+static struct net_pkt *create_pkt(struct net_if *iface, sa_family_t family,
+				  uint8_t proto)
+{
+	struct net_tcp_hdr tcp_hdr = { 0 };
+	struct net_pkt *pkt;
+	size_t hdr_len, i;
+
+	hdr_len = family == AF_INET ? NET_IPV4H_LEN : NET_IPV6H_LEN;
+	hdr_len += proto == IPPROTO_TCP ? NET_TCPH_LEN : NET_UDPH_LEN;
+
+	/* Not bound to the interface yet so that the buffer is not capped
+	 * to the MTU.
+	 */
+	pkt = net_pkt_alloc(K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_pkt_alloc_buffer(pkt, hdr_len + TEST_DATA_LEN, 0,
+					   K_NO_WAIT), 0,
+		      "Cannot allocate buffer");
+
+	net_pkt_set_iface(pkt, iface);
+	net_pkt_set_family(pkt, family);
+
+	if (family == AF_INET) {
+		zassert_equal(net_ipv4_create(pkt, &in4addr_my, &in4addr_dst),
+			      0, "Cannot create IPv4 header");
+	} else {
+		zassert_equal(net_ipv6_create(pkt, &in6addr_my, &in6addr_dst),
+			      0, "Cannot create IPv6 header");
+	}
+
+	if (proto == IPPROTO_TCP) {
+		tcp_hdr.src_port = htons(4242);
+		tcp_hdr.dst_port = htons(4243);
+		sys_put_be32(TEST_SEQ, tcp_hdr.seq);
+		tcp_hdr.offset = (NET_TCPH_LEN / 4) << 4;
+		tcp_hdr.flags = TCP_PSH | TCP_ACK;
+		sys_put_be16(1024, tcp_hdr.wnd);
+
+		zassert_equal(net_pkt_write(pkt, &tcp_hdr, sizeof(tcp_hdr)),
+			      0, "Cannot write TCP header");
+	} else {
+		zassert_equal(net_udp_create(pkt, htons(4242), htons(4243)),
+			      0, "Cannot write UDP header");
+	}
+
+	for (i = 0; i < TEST_DATA_LEN; i++) {
+		zassert_equal(net_pkt_write_u8(pkt, (uint8_t)i), 0,
+			      "Cannot write data");
+	}
+
+	net_pkt_cursor_init(pkt);
+
+	if (family == AF_INET) {
+		zassert_equal(net_ipv4_finalize(pkt, proto), 0,
+			      "Cannot finalize");
+	} else {
+		zassert_equal(net_ipv6_finalize(pkt, proto), 0,
+			      "Cannot finalize");
+	}
+
+	return pkt;
+}
+
+static struct net_pkt *create_oversized_segment(struct net_if *iface,
+						sa_family_t family)
+{
+	struct net_pkt *pkt = create_pkt(iface, family, IPPROTO_TCP);
+
+	net_pkt_set_gso_size(pkt, TEST_MSS);
+
+	return pkt;
+}
+
+static void software_gso(sa_family_t family)
+{
+	struct net_pkt *pkt;
+
+	received = 0;
+	frames = 0;
+	test_failed = false;
+
+	pkt = create_oversized_segment(gso_iface, family);
+
+	zassert_equal(net_send_data(pkt), 0, "Send failed");
+
+	zassert_equal(k_sem_take(&wait_data, WAIT_TIME), 0, "Timeout");
+
+	zassert_false(test_failed, "Invalid frame");
+	zassert_equal(received, TEST_DATA_LEN, "Data missing");
+	zassert_equal(frames, ceiling_fraction(TEST_DATA_LEN, TEST_MSS),
+		      "Invalid number of frames (%d)", frames);
+}
+
+static void test_software_gso(void)
+{
+	software_gso(AF_INET);
+}
+
+static void test_software_gso_ipv6(void)
+{
+	software_gso(AF_INET6);
+}
+
+static void test_hardware_tso(void)
+{
+	struct net_pkt *pkt;
+
+	frames = 0;
+	test_failed = false;
+
+	pkt = create_oversized_segment(tso_iface, AF_INET);
+
+	zassert_equal(net_send_data(pkt), 0, "Send failed");
+
+	zassert_equal(k_sem_take(&wait_data, WAIT_TIME), 0, "Timeout");
+
+	zassert_false(test_failed, "Segment was modified");
+	zassert_equal(frames, 1, "Segment was split (%d)", frames);
+}
+
+/* The device cannot insert the checksum of a datagram it only gets the
+ * fragments of, so the stack must compute it before fragmenting.
+ */
+static void test_fragment_chksum_ipv6(void)
+{
+	struct net_pkt *pkt;
+	uint16_t sum;
+
+	frames = 0;
+	test_failed = false;
+	datagram_len = 0;
+
+	pkt = create_pkt(csum_iface, AF_INET6, IPPROTO_UDP);
+
+	zassert_equal(net_send_data(pkt), 0, "Send failed");
+
+	zassert_equal(k_sem_take(&wait_data, WAIT_TIME), 0, "Timeout");
+
+	zassert_false(test_failed, "Invalid fragment");
+	zassert_true(frames > 1, "Datagram was not fragmented");
+	zassert_equal(datagram_len, sizeof(datagram), "Data missing");
+
+	sum = chksum(0, (uint8_t *)&in6addr_my, sizeof(in6addr_my));
+	sum = chksum(sum, (uint8_t *)&in6addr_dst, sizeof(in6addr_dst));
+	zassert_equal(chksum(IPPROTO_UDP + sizeof(datagram) + sum,
+			     datagram, sizeof(datagram)), 0xffff,
+		      "Invalid UDP checksum");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_tcp_gso_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_software_gso),
+			 ztest_unit_test(test_software_gso_ipv6),
+			 ztest_unit_test(test_hardware_tso),
+			 ztest_unit_test(test_fragment_chksum_ipv6)
+			 );
+
+	ztest_run_test_suite(net_tcp_gso_test);
+}